@@ -8,6 +8,11 @@
  * @ingroup wbxml
  */
 
+/** 
+ * @defgroup wbxml_arena WBXML Arena Allocator
+ * @ingroup wbxml
+ */
+
 /** 
  * @defgroup wbxml_buffers WBXML Buffers
  * @ingroup wbxml
@@ -0,0 +1,282 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_arena.c
+ * @ingroup wbxml_arena
+ *
+ * @date 26/10/17
+ *
+ * @brief Arena Allocator: many small objects, all released at once
+ */
+
+#include "wbxml.h"
+#include "wbxml_arena.h"
+
+/** Usable size of a standard block */
+#define WBXML_ARENA_BLOCK_SIZE 32768
+
+/** Allocations bigger than this get a block of their own (so that blocks are not wasted) */
+#define WBXML_ARENA_BIG_SIZE (WBXML_ARENA_BLOCK_SIZE / 4)
+
+/** Types with the strongest alignment needed in this library */
+typedef union WBXMLArenaAlign_u {
+    void   *ptr;
+    long    l;
+    double  d;
+} WBXMLArenaAlign;
+
+/** Alignment of allocated memory */
+#define WBXML_ARENA_ALIGN ((WB_ULONG) sizeof(WBXMLArenaAlign))
+
+/** Round a size up to the alignment */
+#define WBXML_ARENA_ROUND(size) (((size) + WBXML_ARENA_ALIGN - 1) & ~(WBXML_ARENA_ALIGN - 1))
+
+/**
+ * @brief A block of memory
+ * @note Memory given by the block starts just after this header
+ */
+typedef struct WBXMLArenaBlock_s {
+    struct WBXMLArenaBlock_s *next; /**< Next block */
+    WB_ULONG                  size; /**< Usable size */
+    WB_ULONG                  used; /**< Used size */
+    WB_ULONG                  last; /**< Offset of the last allocation in block */
+} WBXMLArenaBlock;
+
+/** Size of a block header */
+#define WBXML_ARENA_HEADER WBXML_ARENA_ROUND((WB_ULONG) sizeof(WBXMLArenaBlock))
+
+/** Memory given by a block */
+#define WBXML_ARENA_DATA(block) ((WB_UTINY *) (block) + WBXML_ARENA_HEADER)
+
+/** The Arena type */
+struct WBXMLArena_s {
+    WBXMLArenaBlock *blocks;    /**< All blocks (the last created first) */
+    WBXMLArenaBlock *current;   /**< Standard block where memory is allocated */
+    WB_ULONG         nb_blocks; /**< Number of blocks */
+    WB_BOOL          foreign;   /**< Are objects allocated elsewhere linked to objects of this Arena ? */
+    WBXMLAllocator  *allocator; /**< Allocator of blocks (NULL if default one is used) */
+};
+
+
+/* Private functions prototypes */
+static WBXMLArenaBlock *arena_add_block(WBXMLArena *arena, WB_ULONG size);
+
+
+/***************************************************
+ *    Public Functions
+ */
+
+WBXML_DECLARE(WBXMLArena *) wbxml_arena_create_real(void)
+{
+    return wbxml_arena_create_with_allocator_real(NULL);
+}
+
+
+WBXML_DECLARE(WBXMLArena *) wbxml_arena_create_with_allocator_real(WBXMLAllocator *allocator)
+{
+    WBXMLArena *arena = NULL;
+
+    if ((arena = wbxml_mem_malloc(allocator, sizeof(WBXMLArena))) == NULL)
+        return NULL;
+
+    arena->blocks = NULL;
+    arena->current = NULL;
+    arena->nb_blocks = 0;
+    arena->foreign = FALSE;
+    arena->allocator = allocator;
+
+    return arena;
+}
+
+
+WBXML_DECLARE(void) wbxml_arena_destroy(WBXMLArena *arena)
+{
+    WBXMLArenaBlock *block = NULL, *next = NULL;
+
+    if (arena == NULL)
+        return;
+
+    for (block = arena->blocks; block != NULL; block = next) {
+        next = block->next;
+        wbxml_mem_free(arena->allocator, block);
+    }
+
+    wbxml_mem_free(arena->allocator, arena);
+}
+
+
+WBXML_DECLARE(void *) wbxml_arena_alloc(WBXMLArena *arena, WB_ULONG size)
+{
+    WBXMLArenaBlock *block = NULL;
+
+    if (arena == NULL)
+        return NULL;
+
+    /* Too big to be allocated */
+    if (size > (WB_ULONG) -1 - WBXML_ARENA_HEADER - WBXML_ARENA_ALIGN)
+        return NULL;
+
+    size = (size == 0) ? WBXML_ARENA_ALIGN : WBXML_ARENA_ROUND(size);
+
+    block = arena->current;
+
+    if ((block == NULL) || (block->size - block->used < size)) {
+        if (size > WBXML_ARENA_BIG_SIZE) {
+            /* A block of its own: the current block is kept for next allocations */
+            if ((block = arena_add_block(arena, size)) == NULL)
+                return NULL;
+        }
+        else {
+            if ((block = arena_add_block(arena, WBXML_ARENA_BLOCK_SIZE)) == NULL)
+                return NULL;
+
+            arena->current = block;
+        }
+    }
+
+    block->last = block->used;
+    block->used += size;
+
+    return WBXML_ARENA_DATA(block) + block->last;
+}
+
+
+WBXML_DECLARE(void *) wbxml_arena_realloc(WBXMLArena *arena, void *ptr, WB_ULONG old_size, WB_ULONG size)
+{
+    WBXMLArenaBlock *block = NULL;
+    void *result = NULL;
+
+    if (arena == NULL)
+        return NULL;
+
+    if (ptr == NULL)
+        return wbxml_arena_alloc(arena, size);
+
+    old_size = WBXML_ARENA_ROUND(old_size);
+
+    /* Already big enough */
+    if (size <= old_size)
+        return ptr;
+
+    if (size > (WB_ULONG) -1 - WBXML_ARENA_HEADER - WBXML_ARENA_ALIGN)
+        return NULL;
+
+    /* Last allocation of the current block: extend it in place */
+    block = arena->current;
+
+    if ((block != NULL) &&
+        ((WB_UTINY *) ptr == WBXML_ARENA_DATA(block) + block->last) &&
+        (block->last + old_size == block->used) &&
+        (WBXML_ARENA_ROUND(size) <= block->size - block->last))
+    {
+        block->used = block->last + WBXML_ARENA_ROUND(size);
+        return ptr;
+    }
+
+    /* Alone in the last created block: resize this block */
+    block = arena->blocks;
+
+    if ((block != NULL) && (block != arena->current) && ((WB_UTINY *) ptr == WBXML_ARENA_DATA(block))) {
+        if ((block = wbxml_mem_realloc(arena->allocator, block, WBXML_ARENA_HEADER + WBXML_ARENA_ROUND(size))) == NULL)
+            return NULL;
+
+        block->size = block->used = WBXML_ARENA_ROUND(size);
+        arena->blocks = block;
+
+        return WBXML_ARENA_DATA(block);
+    }
+
+    /* Copy it: old memory is lost until the Arena is destroyed */
+    if ((result = wbxml_arena_alloc(arena, size)) == NULL)
+        return NULL;
+
+    memcpy(result, ptr, old_size);
+
+    return result;
+}
+
+
+WBXML_DECLARE(void) wbxml_arena_add_foreign(WBXMLArena *arena)
+{
+    if (arena != NULL)
+        arena->foreign = TRUE;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_arena_has_foreign(WBXMLArena *arena)
+{
+    if (arena == NULL)
+        return FALSE;
+
+    return arena->foreign;
+}
+
+
+WBXML_DECLARE(WBXMLAllocator *) wbxml_arena_get_allocator(WBXMLArena *arena)
+{
+    if (arena == NULL)
+        return NULL;
+
+    return arena->allocator;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_arena_blocks(WBXMLArena *arena)
+{
+    if (arena == NULL)
+        return 0;
+
+    return arena->nb_blocks;
+}
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Add a block to an Arena
+ * @param arena The Arena
+ * @param size  Usable size of the block (already rounded)
+ * @return The new block, or NULL if not enough memory
+ */
+static WBXMLArenaBlock *arena_add_block(WBXMLArena *arena, WB_ULONG size)
+{
+    WBXMLArenaBlock *block = NULL;
+
+    if ((block = wbxml_mem_malloc(arena->allocator, WBXML_ARENA_HEADER + size)) == NULL)
+        return NULL;
+
+    block->size = size;
+    block->used = 0;
+    block->last = 0;
+
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->nb_blocks++;
+
+    return block;
+}
@@ -0,0 +1,137 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_arena.h
+ * @ingroup wbxml_arena
+ *
+ * @date 26/10/17
+ *
+ * @brief Arena Allocator: many small objects, all released at once
+ */
+
+#ifndef WBXML_ARENA_H
+#define WBXML_ARENA_H
+
+#include "wbxml_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/**
+ * @brief WBXML Arena
+ *
+ * Memory is taken from big blocks, by moving a pointer forward. It is never freed
+ * one object at a time: all the blocks are released when the Arena is destroyed.
+ */
+typedef struct WBXMLArena_s WBXMLArena;
+
+
+/** @addtogroup wbxml_arena
+ *  @{
+ */
+
+/**
+ * @brief Create an Arena
+ * @return The newly created Arena, or NULL if not enough memory
+ * @note No block is allocated before the first call to wbxml_arena_alloc()
+ * @warning Do NOT use this function directly, use wbxml_arena_create() macro instead
+ */
+WBXML_DECLARE(WBXMLArena *) wbxml_arena_create_real(void);
+#define wbxml_arena_create() wbxml_mem_cleam(wbxml_arena_create_real())
+
+/**
+ * @brief Create an Arena with an Allocator
+ * @param allocator The Allocator of the Arena blocks (NULL to use the default one)
+ * @return The newly created Arena, or NULL if not enough memory
+ * @warning Do NOT use this function directly, use wbxml_arena_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLArena *) wbxml_arena_create_with_allocator_real(WBXMLAllocator *allocator);
+#define wbxml_arena_create_with_allocator(a) wbxml_mem_cleam(wbxml_arena_create_with_allocator_real(a))
+
+/**
+ * @brief Destroy an Arena, and release all the memory allocated in it
+ * @param arena The Arena to destroy
+ */
+WBXML_DECLARE(void) wbxml_arena_destroy(WBXMLArena *arena);
+
+/**
+ * @brief Allocate memory in an Arena
+ * @param arena The Arena
+ * @param size  Size of memory to allocate
+ * @return The allocated memory (aligned for any structure of this library), or NULL if not enough memory
+ */
+WBXML_DECLARE(void *) wbxml_arena_alloc(WBXMLArena *arena, WB_ULONG size);
+
+/**
+ * @brief Resize memory allocated in an Arena
+ * @param arena    The Arena
+ * @param ptr      Memory allocated by wbxml_arena_alloc() (can be NULL)
+ * @param old_size Size of memory that was asked for 'ptr'
+ * @param size     New size
+ * @return The resized memory, or NULL if not enough memory ('ptr' is then left as is)
+ * @note Memory is extended in place when it is the last one allocated. Otherwise it is
+ *       copied into new memory: the old memory is only released with the Arena.
+ */
+WBXML_DECLARE(void *) wbxml_arena_realloc(WBXMLArena *arena, void *ptr, WB_ULONG old_size, WB_ULONG size);
+
+/**
+ * @brief Tell an Arena that objects allocated elsewhere are linked to its objects
+ * @param arena The Arena
+ * @note Such objects must be released one by one before the Arena is destroyed
+ *       (for example Tree Nodes added to a Tree built in an Arena, cf wbxml_tree_destroy())
+ */
+WBXML_DECLARE(void) wbxml_arena_add_foreign(WBXMLArena *arena);
+
+/**
+ * @brief Are objects allocated elsewhere linked to the objects of an Arena ?
+ * @param arena The Arena
+ * @return TRUE if wbxml_arena_add_foreign() was called for this Arena, FALSE otherwise
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_arena_has_foreign(WBXMLArena *arena);
+
+/**
+ * @brief Get the Allocator of an Arena
+ * @param arena The Arena
+ * @return The Allocator of its blocks (NULL if default one is used)
+ */
+WBXML_DECLARE(WBXMLAllocator *) wbxml_arena_get_allocator(WBXMLArena *arena);
+
+/**
+ * @brief Get the number of blocks allocated by an Arena
+ * @param arena The Arena
+ * @return The number of blocks
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_arena_blocks(WBXMLArena *arena);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WBXML_ARENA_H */
@@ -38,6 +38,17 @@
 #include "wbxml_base64.h"
 #include "wbxml_mem.h"
 
+/* SIMD kernels need the GCC (or clang) intrinsics and 'target' attribute */
+#if !defined( WBXML_BASE64_NO_SIMD )
+#if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define WBXML_BASE64_X86
+#include <immintrin.h>
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+#define WBXML_BASE64_NEON
+#include <arm_neon.h>
+#endif /* __GNUC__ && (__x86_64__ || __i386__) */
+#endif /* !WBXML_BASE64_NO_SIMD */
+
 
 /* aaaack but it's fast and const should make it shared text page. */
 static const unsigned char pr2six[256] =
@@ -64,26 +75,108 @@ static const unsigned char pr2six[256] =
 /** Base64 table */
 static const char basis_64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+/** Implementation forced by wbxml_base64_set_impl() */
+static WBXMLBase64Impl sv_base64_impl = WBXML_BASE64_IMPL_AUTO;
+
+
+/* Private Functions Prototypes */
+static WBXMLBase64Impl base64_impl(void);
+static WB_BOOL base64_impl_supported(WBXMLBase64Impl impl);
+
+#if defined( WBXML_BASE64_X86 )
+static WB_ULONG encode_ssse3(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+static WB_ULONG encode_avx2(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+static WB_ULONG decode_ssse3(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+static WB_ULONG decode_avx2(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+#endif /* WBXML_BASE64_X86 */
+
+#if defined( WBXML_BASE64_NEON )
+static WB_ULONG encode_neon(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+static WB_ULONG decode_neon(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out);
+#endif /* WBXML_BASE64_NEON */
+
 
 /**********************************
  *    Public functions
  */
 
-/* Function adapted from APR library (http://apr.apache.org/) */
 WBXML_DECLARE(WB_UTINY *) wbxml_base64_encode(const WB_UTINY *buffer, WB_LONG len)
 {
-    WB_LONG i = 0;
-    WB_UTINY *p = NULL, *result = NULL;
+    WB_UTINY *result = NULL;
+    WB_ULONG  result_len = 0;
 
     if ((buffer == NULL) || (len <= 0))
         return NULL;
 
     /* Malloc result buffer */
-    if ((result = wbxml_malloc(((len + 2) / 3 * 4) + 1 + 1)) == NULL)
+    if ((result = wbxml_malloc(WBXML_BASE64_ENCODED_LEN(len) + 1 + 1)) == NULL)
         return NULL;
 
-    p = result;
-    for (i = 0; i < len - 2; i += 3) {
+    result_len = wbxml_base64_encode_to(buffer, (WB_ULONG) len, result);
+    result[result_len] = '\0';
+
+    return result;
+}
+
+
+WBXML_DECLARE(WB_LONG) wbxml_base64_decode(const WB_UTINY *buffer, WB_LONG len, WB_UTINY **result)
+{
+    WB_ULONG nprbytes = 0;
+
+    if ((buffer == NULL) || (result == NULL))
+        return 0;
+
+    /* Initialize output buffer */
+    *result = NULL;
+
+    if (len >= 0) {
+        nprbytes = (WB_ULONG) len;
+    }
+    else {
+        /* Terminated by a non-Base64 character */
+        while (pr2six[buffer[nprbytes]] <= 63)
+            nprbytes++;
+    }
+
+    /* Malloc result buffer */
+    if ((*result = wbxml_malloc(WBXML_BASE64_DECODED_MAX_LEN(nprbytes) + 1)) == NULL)
+        return 0;
+
+    return (WB_LONG) wbxml_base64_decode_to(buffer, nprbytes, *result);
+}
+
+
+/* Function adapted from APR library (http://apr.apache.org/) */
+WBXML_DECLARE(WB_ULONG) wbxml_base64_encode_to(const WB_UTINY *buffer, WB_ULONG len, WB_UTINY *out)
+{
+    WB_ULONG i = 0;
+    WB_UTINY *p = out;
+
+    if ((buffer == NULL) || (out == NULL))
+        return 0;
+
+    /* Biggest part, with SIMD */
+    switch (base64_impl()) {
+#if defined( WBXML_BASE64_X86 )
+    case WBXML_BASE64_IMPL_AVX2:
+        i = encode_avx2(buffer, len, out);
+        break;
+    case WBXML_BASE64_IMPL_SSSE3:
+        i = encode_ssse3(buffer, len, out);
+        break;
+#endif /* WBXML_BASE64_X86 */
+#if defined( WBXML_BASE64_NEON )
+    case WBXML_BASE64_IMPL_NEON:
+        i = encode_neon(buffer, len, out);
+        break;
+#endif /* WBXML_BASE64_NEON */
+    default:
+        break;
+    }
+
+    p = out + i / 3 * 4;
+
+    for (; i + 2 < len; i += 3) {
         *p++ = basis_64[(buffer[i] >> 2) & 0x3F];
         *p++ = basis_64[((buffer[i] & 0x3) << 4) |
                         ((int) (buffer[i + 1] & 0xF0) >> 4)];
@@ -105,62 +198,446 @@ WBXML_DECLARE(WB_UTINY *) wbxml_base64_encode(const WB_UTINY *buffer, WB_LONG le
         *p++ = '=';
     }
 
-    *p++ = '\0';
-
-    return result;
+    return (WB_ULONG) (p - out);
 }
 
 
 /* Function adapted from APR library (http://apr.apache.org/) */
-WBXML_DECLARE(WB_LONG) wbxml_base64_decode(const WB_UTINY *buffer, WB_LONG len, WB_UTINY **result)
+WBXML_DECLARE(WB_ULONG) wbxml_base64_decode_to(const WB_UTINY *buffer, WB_ULONG len, WB_UTINY *out)
 {
-    WB_LONG nbytesdecoded = 0, nprbytes = 0;
+    WB_ULONG nbytesdecoded = 0, nprbytes = 0;
     const WB_UTINY *bufin = NULL;
-	const WB_UTINY *end = (len >= 0) ? (buffer + len) : NULL;
+    const WB_UTINY *end = NULL;
     WB_UTINY *bufout = NULL;
+    WB_UTINY c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+    WB_ULONG done = 0;
 
-    if ((buffer == NULL) || (result == NULL))
+    if ((buffer == NULL) || (out == NULL))
         return 0;
 
-    /* Initialize output buffer */
-    *result = NULL;
+    /* Biggest part, with SIMD (stops before the first non-Base64 character) */
+    switch (base64_impl()) {
+#if defined( WBXML_BASE64_X86 )
+    case WBXML_BASE64_IMPL_AVX2:
+        done = decode_avx2(buffer, len, out);
+        break;
+    case WBXML_BASE64_IMPL_SSSE3:
+        done = decode_ssse3(buffer, len, out);
+        break;
+#endif /* WBXML_BASE64_X86 */
+#if defined( WBXML_BASE64_NEON )
+    case WBXML_BASE64_IMPL_NEON:
+        done = decode_neon(buffer, len, out);
+        break;
+#endif /* WBXML_BASE64_NEON */
+    default:
+        break;
+    }
 
-    bufin = buffer;   
+    bufin = buffer + done;
+    end = buffer + len;
     while (bufin != end && pr2six[*bufin] <= 63)
-		bufin++;
-    
-	nprbytes = bufin - buffer;
+        bufin++;
 
+    nprbytes = (WB_ULONG) (bufin - buffer) - done;
     nbytesdecoded = ((nprbytes + 3) / 4) * 3;
-    
-    /* Malloc result buffer */
-    if ((*result = wbxml_malloc(nbytesdecoded + 1)) == NULL)
-        return 0;
 
-    bufout = *result;
-    bufin = buffer;
+    bufout = out + done / 4 * 3;
+    bufin = buffer + done;
 
-    while (nprbytes > 4) 
+    /* Each character is read before being overwritten, when decoding in place */
+    while (nprbytes > 4)
     {
-        *(bufout++) = (WB_UTINY) (pr2six[*bufin] << 2 | pr2six[bufin[1]] >> 4);
-        *(bufout++) = (WB_UTINY) (pr2six[bufin[1]] << 4 | pr2six[bufin[2]] >> 2);
-        *(bufout++) = (WB_UTINY) (pr2six[bufin[2]] << 6 | pr2six[bufin[3]]);
+        c0 = pr2six[bufin[0]];
+        c1 = pr2six[bufin[1]];
+        c2 = pr2six[bufin[2]];
+        c3 = pr2six[bufin[3]];
+
+        *(bufout++) = (WB_UTINY) (c0 << 2 | c1 >> 4);
+        *(bufout++) = (WB_UTINY) (c1 << 4 | c2 >> 2);
+        *(bufout++) = (WB_UTINY) (c2 << 6 | c3);
         bufin += 4;
         nprbytes -= 4;
     }
 
+    c0 = (nprbytes > 0) ? pr2six[bufin[0]] : 0;
+    c1 = (nprbytes > 1) ? pr2six[bufin[1]] : 0;
+    c2 = (nprbytes > 2) ? pr2six[bufin[2]] : 0;
+    c3 = (nprbytes > 3) ? pr2six[bufin[3]] : 0;
+
     /* Note: (nprbytes == 1) would be an error, so just ingore that case */
     if (nprbytes > 1) {
-        *(bufout++) = (WB_UTINY) (pr2six[*bufin] << 2 | pr2six[bufin[1]] >> 4);
+        *(bufout++) = (WB_UTINY) (c0 << 2 | c1 >> 4);
     }
     if (nprbytes > 2) {
-        *(bufout++) = (WB_UTINY) (pr2six[bufin[1]] << 4 | pr2six[bufin[2]] >> 2);
+        *(bufout++) = (WB_UTINY) (c1 << 4 | c2 >> 2);
     }
     if (nprbytes > 3) {
-        *(bufout++) = (WB_UTINY) (pr2six[bufin[2]] << 6 | pr2six[bufin[3]]);
+        *(bufout++) = (WB_UTINY) (c2 << 6 | c3);
     }
 
     nbytesdecoded -= (4 - nprbytes) & 3;
-    
-    return nbytesdecoded;
+
+    return done / 4 * 3 + nbytesdecoded;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_base64_set_impl(WBXMLBase64Impl impl)
+{
+    if (!base64_impl_supported(impl))
+        return FALSE;
+
+    sv_base64_impl = impl;
+
+    return TRUE;
+}
+
+
+WBXML_DECLARE(WBXMLBase64Impl) wbxml_base64_get_impl(void)
+{
+    return base64_impl();
 }
+
+
+/**********************************
+ *    Private functions
+ */
+
+/**
+ * @brief Get the implementation to use
+ * @return The forced one, or else the best one supported by this CPU
+ */
+static WBXMLBase64Impl base64_impl(void)
+{
+    if (sv_base64_impl != WBXML_BASE64_IMPL_AUTO)
+        return sv_base64_impl;
+
+#if defined( WBXML_BASE64_X86 )
+    if (__builtin_cpu_supports("avx2"))
+        return WBXML_BASE64_IMPL_AVX2;
+
+    if (__builtin_cpu_supports("ssse3"))
+        return WBXML_BASE64_IMPL_SSSE3;
+#endif /* WBXML_BASE64_X86 */
+
+    /* NEON kernels are only used when forced, until they are checked against scalar ones on AArch64 */
+    return WBXML_BASE64_IMPL_SCALAR;
+}
+
+
+/**
+ * @brief Check if an implementation can be used
+ * @param impl The implementation
+ * @return TRUE if compiled in, and supported by this CPU
+ */
+static WB_BOOL base64_impl_supported(WBXMLBase64Impl impl)
+{
+    switch (impl) {
+    case WBXML_BASE64_IMPL_AUTO:
+    case WBXML_BASE64_IMPL_SCALAR:
+        return TRUE;
+#if defined( WBXML_BASE64_X86 )
+    case WBXML_BASE64_IMPL_SSSE3:
+        return (__builtin_cpu_supports("ssse3") != 0);
+    case WBXML_BASE64_IMPL_AVX2:
+        return (__builtin_cpu_supports("avx2") != 0);
+#endif /* WBXML_BASE64_X86 */
+#if defined( WBXML_BASE64_NEON )
+    case WBXML_BASE64_IMPL_NEON:
+        return TRUE;
+#endif /* WBXML_BASE64_NEON */
+    default:
+        return FALSE;
+    }
+}
+
+
+#if defined( WBXML_BASE64_X86 )
+
+/*
+ * x86 kernels, after the algorithms of Wojciech Mula and Daniel Lemire
+ * ("Faster Base64 Encoding and Decoding using AVX2 Instructions", 2018).
+ *
+ * Each encoding kernel returns the number of bytes encoded (multiple of 3), each decoding
+ * kernel returns the number of characters decoded (multiple of 4). Decoding stops at the
+ * first block holding a non-Base64 character, and writes at most (len / 4 * 3) bytes, even
+ * if it stores full vectors: decoding in place ('out' == 'in') is possible.
+ */
+
+/** @brief Convert 6-bit values to Base64 characters (SSSE3) */
+__attribute__((target("ssse3")))
+static __m128i encode_lookup_ssse3(__m128i indices)
+{
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                            '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                            '/' - 63, 'A', 0, 0);
+    __m128i reduced = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+
+    reduced = _mm_or_si128(reduced, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+    return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, reduced), indices);
+}
+
+
+/** @brief Split 12 bytes (in a 16 bytes vector) in 16 6-bit values (SSSE3) */
+__attribute__((target("ssse3")))
+static __m128i encode_split_ssse3(__m128i in)
+{
+    __m128i t0, t1, t2, t3;
+
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+
+    t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+
+    return _mm_or_si128(t1, t3);
+}
+
+
+__attribute__((target("ssse3")))
+static WB_ULONG encode_ssse3(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    WB_ULONG i = 0;
+
+    /* 12 bytes are encoded, but 16 are read */
+    for (i = 0; i + 16 <= len; i += 12) {
+        __m128i data = _mm_loadu_si128((const __m128i *) (in + i));
+
+        _mm_storeu_si128((__m128i *) out, encode_lookup_ssse3(encode_split_ssse3(data)));
+        out += 16;
+    }
+
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+static WB_ULONG encode_avx2(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0,
+                                               'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                               '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                               '/' - 63, 'A', 0, 0);
+    const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                             1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    WB_ULONG i = 0;
+
+    /* 24 bytes are encoded (12 in each lane), but 28 are read */
+    for (i = 0; i + 28 <= len; i += 24) {
+        __m256i data, t0, t1, t2, t3, indices, reduced, less;
+
+        data = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) (in + i))),
+                                       _mm_loadu_si128((const __m128i *) (in + i + 12)), 1);
+        data = _mm256_shuffle_epi8(data, shuffle);
+
+        t0 = _mm256_and_si256(data, _mm256_set1_epi32(0x0fc0fc00));
+        t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        t2 = _mm256_and_si256(data, _mm256_set1_epi32(0x003f03f0));
+        t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        indices = _mm256_or_si256(t1, t3);
+
+        reduced = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        reduced = _mm256_or_si256(reduced, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+
+        _mm256_storeu_si256((__m256i *) out, _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, reduced), indices));
+        out += 32;
+    }
+
+    return i;
+}
+
+
+__attribute__((target("ssse3")))
+static WB_ULONG decode_ssse3(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                           0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m128i mask_0f = _mm_set1_epi8(0x0f);
+    WB_ULONG i = 0;
+
+    /* 16 characters are decoded in 12 bytes, but 16 are written */
+    for (i = 0; i + 24 <= len; i += 16) {
+        __m128i data, hi_nibbles, lo_nibbles, lo, hi, roll, merged;
+
+        data = _mm_loadu_si128((const __m128i *) (in + i));
+        hi_nibbles = _mm_and_si128(_mm_srli_epi32(data, 4), mask_0f);
+        lo_nibbles = _mm_and_si128(data, mask_0f);
+
+        lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+        hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+
+        /* Not a Base64 character */
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff)
+            break;
+
+        roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(_mm_cmpeq_epi8(data, _mm_set1_epi8('/')), hi_nibbles));
+        data = _mm_add_epi8(data, roll);
+
+        merged = _mm_maddubs_epi16(data, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+
+        _mm_storeu_si128((__m128i *) out, _mm_shuffle_epi8(merged, pack));
+        out += 12;
+    }
+
+    return i;
+}
+
+
+__attribute__((target("avx2")))
+static WB_ULONG decode_avx2(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                                            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0,
+                                              0, 16, 19, 4, -65, -65, -71, -71,
+                                              0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                          2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i mask_0f = _mm256_set1_epi8(0x0f);
+    WB_ULONG i = 0;
+
+    /* 32 characters are decoded in 24 bytes, but 32 are written */
+    for (i = 0; i + 44 <= len; i += 32) {
+        __m256i data, hi_nibbles, lo_nibbles, lo, hi, roll, merged;
+
+        data = _mm256_loadu_si256((const __m256i *) (in + i));
+        hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(data, 4), mask_0f);
+        lo_nibbles = _mm256_and_si256(data, mask_0f);
+
+        lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+        hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+
+        /* Not a Base64 character */
+        if (!_mm256_testz_si256(lo, hi))
+            break;
+
+        roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(data, _mm256_set1_epi8('/')), hi_nibbles));
+        data = _mm256_add_epi8(data, roll);
+
+        merged = _mm256_maddubs_epi16(data, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        merged = _mm256_shuffle_epi8(merged, pack);
+        merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+        _mm256_storeu_si256((__m256i *) out, merged);
+        out += 24;
+    }
+
+    return i;
+}
+
+#endif /* WBXML_BASE64_X86 */
+
+
+#if defined( WBXML_BASE64_NEON )
+
+/*
+ * NEON kernels: bytes are deinterleaved by the structured loads and stores,
+ * and Base64 characters are looked up with table instructions.
+ *
+ * Same return values and limits as x86 kernels.
+ */
+
+static WB_ULONG encode_neon(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    uint8x16x4_t table, result;
+    uint8x16x3_t data;
+    WB_ULONG i = 0;
+
+    table.val[0] = vld1q_u8((const uint8_t *) basis_64);
+    table.val[1] = vld1q_u8((const uint8_t *) basis_64 + 16);
+    table.val[2] = vld1q_u8((const uint8_t *) basis_64 + 32);
+    table.val[3] = vld1q_u8((const uint8_t *) basis_64 + 48);
+
+    /* 48 bytes are encoded in 64 characters */
+    for (i = 0; i + 48 <= len; i += 48) {
+        data = vld3q_u8(in + i);
+
+        result.val[0] = vshrq_n_u8(data.val[0], 2);
+        result.val[1] = vorrq_u8(vandq_u8(vshlq_n_u8(data.val[0], 4), vdupq_n_u8(0x30)),
+                                 vshrq_n_u8(data.val[1], 4));
+        result.val[2] = vorrq_u8(vandq_u8(vshlq_n_u8(data.val[1], 2), vdupq_n_u8(0x3c)),
+                                 vshrq_n_u8(data.val[2], 6));
+        result.val[3] = vandq_u8(data.val[2], vdupq_n_u8(0x3f));
+
+        result.val[0] = vqtbl4q_u8(table, result.val[0]);
+        result.val[1] = vqtbl4q_u8(table, result.val[1]);
+        result.val[2] = vqtbl4q_u8(table, result.val[2]);
+        result.val[3] = vqtbl4q_u8(table, result.val[3]);
+
+        vst4q_u8(out, result);
+        out += 64;
+    }
+
+    return i;
+}
+
+
+static WB_ULONG decode_neon(const WB_UTINY *in, WB_ULONG len, WB_UTINY *out)
+{
+    uint8x16x4_t table_lo, table_hi, data;
+    uint8x16x3_t result;
+    uint8x16_t   error;
+    WB_ULONG     i = 0, j = 0;
+
+    /* Characters below 128 are looked up in pr2six[] (64 if not a Base64 character) */
+    table_lo.val[0] = vld1q_u8(pr2six);
+    table_lo.val[1] = vld1q_u8(pr2six + 16);
+    table_lo.val[2] = vld1q_u8(pr2six + 32);
+    table_lo.val[3] = vld1q_u8(pr2six + 48);
+    table_hi.val[0] = vld1q_u8(pr2six + 64);
+    table_hi.val[1] = vld1q_u8(pr2six + 80);
+    table_hi.val[2] = vld1q_u8(pr2six + 96);
+    table_hi.val[3] = vld1q_u8(pr2six + 112);
+
+    /* 64 characters are decoded in 48 bytes */
+    for (i = 0; i + 64 <= len; i += 64) {
+        data = vld4q_u8(in + i);
+        error = vdupq_n_u8(0);
+
+        for (j = 0; j < 4; j++) {
+            /* Characters above 127 are looked up in none of the tables: keep their high bit */
+            error = vorrq_u8(error, vandq_u8(data.val[j], vdupq_n_u8(0x80)));
+            data.val[j] = vqtbx4q_u8(vqtbl4q_u8(table_lo, data.val[j]),
+                                     table_hi, vsubq_u8(data.val[j], vdupq_n_u8(64)));
+            error = vorrq_u8(error, data.val[j]);
+        }
+
+        /* Not a Base64 character */
+        if (vmaxvq_u8(error) > 63)
+            break;
+
+        result.val[0] = vorrq_u8(vshlq_n_u8(data.val[0], 2), vshrq_n_u8(data.val[1], 4));
+        result.val[1] = vorrq_u8(vshlq_n_u8(data.val[1], 4), vshrq_n_u8(data.val[2], 2));
+        result.val[2] = vorrq_u8(vshlq_n_u8(data.val[2], 6), data.val[3]);
+
+        vst3q_u8(out, result);
+        out += 48;
+    }
+
+    return i;
+}
+
+#endif /* WBXML_BASE64_NEON */
@@ -48,6 +48,21 @@ extern "C" {
  *  @{ 
  */
 
+/** Length of Base64 encoded data (without NULL terminator) */
+#define WBXML_BASE64_ENCODED_LEN(len) (((len) + 2) / 3 * 4)
+
+/** Maximum length of Base64 decoded data */
+#define WBXML_BASE64_DECODED_MAX_LEN(len) (((len) + 3) / 4 * 3)
+
+/** Base64 implementations */
+typedef enum WBXMLBase64Impl_e {
+    WBXML_BASE64_IMPL_AUTO = 0, /**< Best one supported by this CPU */
+    WBXML_BASE64_IMPL_SCALAR,   /**< Portable C */
+    WBXML_BASE64_IMPL_SSSE3,    /**< x86 SSSE3 */
+    WBXML_BASE64_IMPL_AVX2,     /**< x86 AVX2 */
+    WBXML_BASE64_IMPL_NEON      /**< AArch64 NEON (never chosen by WBXML_BASE64_IMPL_AUTO) */
+} WBXMLBase64Impl;
+
 /**
  * @brief Encode a buffer to Base64
  * @param buffer The buffer to encode
@@ -68,6 +83,39 @@ WBXML_DECLARE(WB_UTINY *) wbxml_base64_encode(const WB_UTINY *buffer, WB_LONG le
  */
 WBXML_DECLARE(WB_LONG) wbxml_base64_decode(const WB_UTINY *buffer, WB_LONG len, WB_UTINY **result);
 
+/**
+ * @brief Encode a buffer to Base64, into a buffer given by caller
+ * @param buffer The buffer to encode
+ * @param len    Buffer length
+ * @param out    Where the result is written (WBXML_BASE64_ENCODED_LEN(len) bytes, not NULL terminated)
+ * @return Length of result
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_base64_encode_to(const WB_UTINY *buffer, WB_ULONG len, WB_UTINY *out);
+
+/**
+ * @brief Decode a Base64 encoded buffer, into a buffer given by caller
+ * @param buffer The buffer to decode (decoding stops at the first non-Base64 character)
+ * @param len    Buffer length
+ * @param out    Where the result is written (at most WBXML_BASE64_DECODED_MAX_LEN(len) bytes)
+ * @return Length of result
+ * @note 'out' can be 'buffer' itself, to decode in place
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_base64_decode_to(const WB_UTINY *buffer, WB_ULONG len, WB_UTINY *out);
+
+/**
+ * @brief Force the Base64 implementation used by this library
+ * @param impl The implementation (WBXML_BASE64_IMPL_AUTO to choose the best one again)
+ * @return TRUE if set, FALSE if not supported by this build or this CPU
+ * @note This is meant for tests and benchmarks, and is not thread safe
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_base64_set_impl(WBXMLBase64Impl impl);
+
+/**
+ * @brief Get the Base64 implementation used by this library
+ * @return The implementation (never WBXML_BASE64_IMPL_AUTO)
+ */
+WBXML_DECLARE(WBXMLBase64Impl) wbxml_base64_get_impl(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -54,6 +54,8 @@ struct WBXMLBuffer_s
     WB_ULONG  len;              /**< Length of data in buffer */
     WB_ULONG  malloced;         /**< Length of buffer */
     WB_BOOL   is_static;        /**< Is it a static buffer ?  */
+    WBXMLArena *arena;          /**< Arena where structure and data are allocated (NULL if malloced) */
+    WBXMLAllocator *allocator;  /**< Allocator of structure and data (NULL if default one is used) */
 };
 
 
@@ -68,14 +70,25 @@ static WB_BOOL insert_data(WBXMLBuffer *buffer, WB_ULONG pos, const WB_UTINY *da
 
 
 WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_real(const WB_UTINY *data, WB_ULONG len, WB_ULONG malloc_block)
+{
+    return wbxml_buffer_create_with_allocator_real(NULL, data, len, malloc_block);
+}
+
+
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_with_allocator_real(WBXMLAllocator *allocator,
+                                                                     const WB_UTINY *data,
+                                                                     WB_ULONG len,
+                                                                     WB_ULONG malloc_block)
 {
     WBXMLBuffer *buffer = NULL;
 
-    buffer = wbxml_malloc(sizeof(WBXMLBuffer));
+    buffer = wbxml_mem_malloc(allocator, sizeof(WBXMLBuffer));
     if (buffer == NULL)
         return NULL;
         
     buffer->is_static    = FALSE;
+    buffer->arena        = NULL;
+    buffer->allocator    = allocator;
 
     if ((len <= 0) || (data == NULL)) {        
         buffer->malloced = 0;
@@ -88,9 +101,9 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_real(const WB_UTINY *data, WB_U
         else
             buffer->malloced = malloc_block + 1;
         
-        buffer->data = wbxml_malloc(buffer->malloced * sizeof(WB_UTINY));
+        buffer->data = wbxml_mem_malloc(allocator, buffer->malloced * sizeof(WB_UTINY));
         if (buffer->data == NULL) {
-            wbxml_free(buffer);
+            wbxml_mem_free(allocator, buffer);
             return NULL;
         }
 
@@ -104,15 +117,25 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_real(const WB_UTINY *data, WB_U
 
 
 WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_sta_create_real(const WB_UTINY *data, WB_ULONG len)
+{
+    return wbxml_buffer_sta_create_with_allocator_real(NULL, data, len);
+}
+
+
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_sta_create_with_allocator_real(WBXMLAllocator *allocator,
+                                                                         const WB_UTINY *data,
+                                                                         WB_ULONG len)
 {
     WBXMLBuffer *buffer = NULL;
   
-    buffer = wbxml_malloc(sizeof(WBXMLBuffer));
+    buffer = wbxml_mem_malloc(allocator, sizeof(WBXMLBuffer));
     if (buffer == NULL) {
         return NULL;
     }
 
     buffer->is_static    = TRUE;
+    buffer->arena        = NULL;
+    buffer->allocator    = allocator;
     buffer->data         = (WB_UTINY *) data;
     buffer->len          = len;
 
@@ -120,16 +143,47 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_sta_create_real(const WB_UTINY *data,
 }
 
 
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_in_arena_real(WBXMLArena *arena, const WB_UTINY *data, WB_ULONG len)
+{
+    WBXMLBuffer *buffer = NULL;
+
+    if (arena == NULL)
+        return wbxml_buffer_create_real(data, len, len);
+
+    if ((buffer = wbxml_arena_alloc(arena, sizeof(WBXMLBuffer))) == NULL)
+        return NULL;
+
+    buffer->is_static = FALSE;
+    buffer->arena     = arena;
+    buffer->allocator = wbxml_arena_get_allocator(arena);
+    buffer->malloced  = 0;
+    buffer->len       = 0;
+    buffer->data      = NULL;
+
+    if ((len > 0) && (data != NULL)) {
+        if ((buffer->data = wbxml_arena_alloc(arena, len + 1)) == NULL)
+            return NULL;
+
+        buffer->malloced = len + 1;
+        buffer->len = len;
+        memcpy(buffer->data, data, len);
+        buffer->data[len] = '\0';
+    }
+
+    return buffer;
+}
+
+
 WBXML_DECLARE(void) wbxml_buffer_destroy(WBXMLBuffer *buffer)
 {
-    if (buffer != NULL) {
+    if ((buffer != NULL) && (buffer->arena == NULL)) {
         if (!buffer->is_static) {
             /* Free dynamic data */
-            wbxml_free(buffer->data);
+            wbxml_mem_free(buffer->allocator, buffer->data);
         }
 
         /* Free structure */
-        wbxml_free(buffer);
+        wbxml_mem_free(buffer->allocator, buffer);
     }
 }
 
@@ -147,9 +201,10 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_duplicate(WBXMLBuffer *buff)
     if (buff == NULL)
         return NULL;
 
-    result = wbxml_buffer_create_real(wbxml_buffer_get_cstr(buff),
-                                      wbxml_buffer_len(buff),  
-                                      wbxml_buffer_len(buff));
+    result = wbxml_buffer_create_with_allocator_real(buff->allocator,
+                                                     wbxml_buffer_get_cstr(buff),
+                                                     wbxml_buffer_len(buff),
+                                                     wbxml_buffer_len(buff));
 
     return result;
 }
@@ -194,6 +249,38 @@ WBXML_DECLARE(WB_UTINY *) wbxml_buffer_get_cstr(WBXMLBuffer *buffer)
 }
 
 
+WBXML_DECLARE(WB_UTINY *) wbxml_buffer_detach(WBXMLBuffer *buffer, WB_ULONG *len)
+{
+    WB_UTINY *result = NULL;
+
+    if (len != NULL)
+        *len = 0;
+
+    if ((buffer == NULL) || buffer->is_static || (buffer->len == 0))
+        return NULL;
+
+    if (buffer->arena != NULL) {
+        /* Arena memory can't be given: give a copy */
+        if ((result = wbxml_mem_malloc(buffer->allocator, buffer->len + 1)) == NULL)
+            return NULL;
+
+        memcpy(result, buffer->data, buffer->len + 1);
+    }
+    /* Give back the unused memory (this does not move data with most allocators) */
+    else if ((result = wbxml_mem_realloc(buffer->allocator, buffer->data, buffer->len + 1)) == NULL)
+        result = buffer->data;
+
+    if (len != NULL)
+        *len = buffer->len;
+
+    buffer->data = NULL;
+    buffer->len = 0;
+    buffer->malloced = 0;
+
+    return result;
+}
+
+
 WBXML_DECLARE(WB_BOOL) wbxml_buffer_insert(WBXMLBuffer *to, WBXMLBuffer *buffer, WB_ULONG pos)
 {
     if ((to != NULL) && (buffer != NULL) && !to->is_static)
@@ -259,6 +346,34 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_append_char(WBXMLBuffer *buffer, WB_UTINY ch
 }
 
 
+WBXML_DECLARE(WB_BOOL) wbxml_buffer_reserve(WBXMLBuffer *buffer, WB_ULONG len)
+{
+    if ((buffer == NULL) || buffer->is_static)
+        return FALSE;
+
+    return grow_buff(buffer, len);
+}
+
+
+WBXML_DECLARE(WB_UTINY *) wbxml_buffer_append_space(WBXMLBuffer *buffer, WB_ULONG len)
+{
+    WB_UTINY *result = NULL;
+
+    if ((buffer == NULL) || buffer->is_static)
+        return NULL;
+
+    if (!grow_buff(buffer, len))
+        return NULL;
+
+    result = buffer->data + buffer->len;
+
+    buffer->len += len;
+    buffer->data[buffer->len] = '\0';
+
+    return result;
+}
+
+
 WBXML_DECLARE(WB_BOOL) wbxml_buffer_append_mb_uint_32(WBXMLBuffer *buffer, WB_ULONG value)
 {
     /**
@@ -371,23 +486,44 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_strip_blanks(WBXMLBuffer *buffer)
     return TRUE;
 }
 
+WBXML_DECLARE(void) wbxml_buffer_get_stripped_bounds(WBXMLBuffer *buffer, WB_ULONG *start, WB_ULONG *len)
+{
+    WB_ULONG end = 0;
+
+    *start = 0;
+    *len = 0;
+
+    if ((buffer == NULL) || (buffer->len == 0))
+        return;
+
+    end = buffer->len;
+
+    /* Skip whitespaces at beginning of buffer... */
+    while ((*start < end) && isspace(buffer->data[*start]))
+        (*start)++;
+
+    /* ... and at the end */
+    while ((end > *start) && isspace(buffer->data[end - 1]))
+        end--;
+
+    *len = end - *start;
+}
+
 WBXML_DECLARE(void) wbxml_buffer_no_spaces(WBXMLBuffer *buffer)
 {
-    WB_ULONG i = 0;
-    WB_UTINY ch = 0;
+    WB_ULONG i = 0, j = 0;
     
     if ((buffer == NULL) || buffer->is_static)
         return;
         
-    while (i < wbxml_buffer_len(buffer))
-    {
-        if (wbxml_buffer_get_char(buffer, i, &ch) && isspace(ch)) 
-        {
-             wbxml_buffer_delete(buffer, i, 1);
-        } else {
-             i++;
-        }
+    /* Keep other chars, in one pass */
+    for (i = 0; i < buffer->len; i++) {
+        if (!isspace(buffer->data[i]))
+            buffer->data[j++] = buffer->data[i];
     }
+
+    buffer->len = j;
+    buffer->data[buffer->len] = '\0';
 }
 
 WBXML_DECLARE(WB_LONG) wbxml_buffer_compare(WBXMLBuffer *buff1, WBXMLBuffer *buff2)
@@ -484,7 +620,7 @@ WBXML_DECLARE(WBXMLList *) wbxml_buffer_split_words_real(WBXMLBuffer *buff)
     if (buff == NULL)
         return NULL;
 
-    if ((list = wbxml_list_create()) == NULL)
+    if ((list = wbxml_list_create_with_allocator(buff->allocator)) == NULL)
         return NULL;
 
     p = buff->data;
@@ -506,7 +642,7 @@ WBXML_DECLARE(WBXMLList *) wbxml_buffer_split_words_real(WBXMLBuffer *buff)
         if (start == end)
             break;
 
-        if((word = wbxml_buffer_create(buff->data + start, end - start, WBXML_BUFFER_SPLIT_BLOCK)) == NULL) {
+        if((word = wbxml_buffer_create_with_allocator(buff->allocator, buff->data + start, end - start, WBXML_BUFFER_SPLIT_BLOCK)) == NULL) {
             wbxml_list_destroy(list, wbxml_buffer_destroy_item);
             return NULL;
         }
@@ -705,9 +841,7 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_binary_to_hex(WBXMLBuffer *buffer, WB_BOOL u
 
 WBXML_DECLARE(WBXMLError) wbxml_buffer_decode_base64(WBXMLBuffer *buffer)
 {
-    WB_UTINY   *result = NULL;
-    WB_LONG     len    = 0;
-    WBXMLError  ret    = WBXML_OK;
+    WB_ULONG len = 0;
     
     if ( (buffer == NULL) || (buffer->is_static) ) {
         return WBXML_ERROR_INTERNAL;
@@ -715,51 +849,89 @@ WBXML_DECLARE(WBXMLError) wbxml_buffer_decode_base64(WBXMLBuffer *buffer)
 
     wbxml_buffer_no_spaces(buffer);
     
-    if ((len = wbxml_base64_decode((const WB_UTINY *) wbxml_buffer_get_cstr(buffer),
-                                   wbxml_buffer_len(buffer), &result)) <= 0)
-    {
+    /* Decode in place */
+    if ((len = wbxml_base64_decode_to(buffer->data, buffer->len, buffer->data)) == 0) {
         return WBXML_ERROR_B64_DEC;
     }
     
-    /* Reset buffer */
-    wbxml_buffer_delete(buffer, 0, wbxml_buffer_len(buffer));
-    
-    /* Set binary data */
-    if (!wbxml_buffer_append_data(buffer, result, len)) {
-        ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
-    
-    wbxml_free(result);
+    buffer->len = len;
+    buffer->data[buffer->len] = '\0';
     
-    return ret;
+    return WBXML_OK;
 }
 
 WBXML_DECLARE(WBXMLError) wbxml_buffer_encode_base64(WBXMLBuffer *buffer)
 {
-    WB_UTINY   *result = NULL;
-    WBXMLError  ret    = WBXML_OK;
+    WB_ULONG len = 0;
     
     if ( (buffer == NULL) || (buffer->is_static) ) {
         return WBXML_ERROR_INTERNAL;
     }
     
-    if ((result = wbxml_base64_encode((const WB_UTINY *) wbxml_buffer_get_cstr(buffer),
-                                      wbxml_buffer_len(buffer))) == NULL)
-    {
+    if ((len = buffer->len) == 0) {
         return WBXML_ERROR_B64_ENC;
     }
     
-    /* Reset buffer */
-    wbxml_buffer_delete(buffer, 0, wbxml_buffer_len(buffer));
+    /* Encode after data, then move result in place of data */
+    if (wbxml_buffer_append_base64_encoded(buffer, buffer->data, len) != WBXML_OK) {
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
     
-    /* Set data */
-    if (!wbxml_buffer_append_cstr(buffer, result)) {
-        ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    wbxml_buffer_delete(buffer, 0, len);
+    
+    return WBXML_OK;
+}
+
+WBXML_DECLARE(WBXMLError) wbxml_buffer_append_base64_encoded(WBXMLBuffer *buffer, const WB_UTINY *data, WB_ULONG len)
+{
+    WB_ULONG  offset = 0;
+    WB_UTINY *out    = NULL;
+    
+    if ( (buffer == NULL) || (buffer->is_static) || ((data == NULL) && (len > 0)) ) {
+        return WBXML_ERROR_INTERNAL;
     }
     
-    wbxml_free(result);
+    /* 'data' may be in 'buffer': find it again after growing it */
+    if ((data >= buffer->data) && (data < buffer->data + buffer->len)) {
+        offset = (WB_ULONG) (data - buffer->data);
+        
+        if ((out = wbxml_buffer_append_space(buffer, WBXML_BASE64_ENCODED_LEN(len))) == NULL) {
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+        
+        data = buffer->data + offset;
+    }
+    else if ((out = wbxml_buffer_append_space(buffer, WBXML_BASE64_ENCODED_LEN(len))) == NULL) {
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
     
-    return ret;
+    (void) wbxml_base64_encode_to(data, len, out);
+    
+    return WBXML_OK;
+}
+
+WBXML_DECLARE(WBXMLError) wbxml_buffer_append_base64_decoded(WBXMLBuffer *buffer, const WB_UTINY *data, WB_ULONG len)
+{
+    WB_ULONG  max_len = WBXML_BASE64_DECODED_MAX_LEN(len);
+    WB_ULONG  out_len = 0;
+    WB_UTINY *out     = NULL;
+    
+    if ( (buffer == NULL) || (buffer->is_static) || ((data == NULL) && (len > 0)) ||
+         ((data >= buffer->data) && (data < buffer->data + buffer->len)) )
+    {
+        return WBXML_ERROR_INTERNAL;
+    }
+    
+    if ((out = wbxml_buffer_append_space(buffer, max_len)) == NULL) {
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    
+    out_len = wbxml_base64_decode_to(data, len, out);
+    
+    /* Remove unused bytes */
+    wbxml_buffer_delete(buffer, buffer->len - (max_len - out_len), max_len - out_len);
+    
+    return WBXML_OK;
 }
 
 WBXML_DECLARE(WB_BOOL) wbxml_buffer_remove_trailing_zeros(WBXMLBuffer *buffer)
@@ -792,6 +964,9 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_remove_trailing_zeros(WBXMLBuffer *buffer)
  */
 static WB_BOOL grow_buff(WBXMLBuffer *buffer, WB_ULONG size)
 {
+    WB_UTINY *data = NULL;
+    WB_ULONG new_size = 0;
+
     if ((buffer == NULL) || buffer->is_static)
         return FALSE;
         
@@ -800,13 +975,20 @@ static WB_BOOL grow_buff(WBXMLBuffer *buffer, WB_ULONG size)
 
     if ((buffer->len + size) > buffer->malloced) {
         if ((buffer->malloced * 2) < (buffer->len + size))
-            buffer->malloced = buffer->len + size;
+            new_size = buffer->len + size;
         else
-            buffer->malloced *= 2;
-            
-        buffer->data = wbxml_realloc(buffer->data, buffer->malloced);
-        if (buffer->data == NULL)
+            new_size = buffer->malloced * 2;
+
+        if (buffer->arena != NULL)
+            data = wbxml_arena_realloc(buffer->arena, buffer->data, buffer->malloced, new_size);
+        else
+            data = wbxml_mem_realloc(buffer->allocator, buffer->data, new_size);
+
+        if (data == NULL)
             return FALSE;
+
+        buffer->data = data;
+        buffer->malloced = new_size;
     }
 
     return TRUE;
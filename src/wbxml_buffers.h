@@ -42,6 +42,7 @@
 
 #include "wbxml.h"
 #include "wbxml_lists.h"
+#include "wbxml_arena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -75,6 +76,25 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_real(const WB_UTINY *data, WB_U
 #define wbxml_buffer_create_from_cstr(a) \
   wbxml_buffer_create((const WB_UTINY *)a,WBXML_STRLEN(a),WBXML_STRLEN(a))
 
+/**
+ * @brief Create a Buffer with an Allocator
+ * @param allocator The Allocator of the Buffer (NULL to use the default one)
+ * @param data The initial data for buffer
+ * @param len Size of data
+ * @param malloc_block Size of the initial malloc block (tune this parameter to avoid too many reallocations)
+ * @return The newly created Buffer, or NULL if not enough memory
+ * @note The Buffer keeps its Allocator: its data is resized and freed with it.
+ * @warning Do NOT use this function directly, use wbxml_buffer_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_with_allocator_real(WBXMLAllocator *allocator,
+                                                                     const WB_UTINY *data,
+                                                                     WB_ULONG len,
+                                                                     WB_ULONG malloc_block);
+
+/** Wrapper around wbxml_buffer_create_with_allocator_real() to track Memory */
+#define wbxml_buffer_create_with_allocator(a,b,c,d) \
+  wbxml_mem_cleam(wbxml_buffer_create_with_allocator_real(a,(const WB_UTINY *)b,c,d))
+
 /**
  * @brief Create a static Buffer
  * @param data Buffer data
@@ -94,6 +114,39 @@ WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_sta_create_real(const WB_UTINY *data,
 #define wbxml_buffer_sta_create_from_cstr(a) \
   wbxml_buffer_sta_create((const WB_UTINY *)a,WBXML_STRLEN(a))
 
+/**
+ * @brief Create a static Buffer with an Allocator
+ * @param allocator The Allocator of the Buffer structure (NULL to use the default one)
+ * @param data Buffer data
+ * @param len  Data lenght
+ * @return The newly created Buffer, or NULL if not enough memory
+ * @warning Do NOT use this function directly, use wbxml_buffer_sta_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_sta_create_with_allocator_real(WBXMLAllocator *allocator,
+                                                                         const WB_UTINY *data,
+                                                                         WB_ULONG len);
+
+/** Wrapper around wbxml_buffer_sta_create_with_allocator_real() to track Memory */
+#define wbxml_buffer_sta_create_with_allocator(a,b,c) \
+  wbxml_mem_cleam(wbxml_buffer_sta_create_with_allocator_real(a,(const WB_UTINY *)b,c))
+
+/**
+ * @brief Create a Buffer in an Arena
+ * @param arena The Arena where the Buffer (structure and data) is allocated (NULL to use malloc)
+ * @param data  The initial data for buffer
+ * @param len   Size of data
+ * @return The newly created Buffer, or NULL if not enough memory
+ * @note This is a dynamic buffer, but its memory is only released with the Arena:
+ *       wbxml_buffer_destroy() does nothing, and data that grows is copied in the Arena
+ *       (if it can't be extended in place). Its Allocator is the one of the Arena.
+ * @warning Do NOT use this function directly, use wbxml_buffer_create_in_arena() macro instead
+ */
+WBXML_DECLARE(WBXMLBuffer *) wbxml_buffer_create_in_arena_real(WBXMLArena *arena, const WB_UTINY *data, WB_ULONG len);
+
+/** Wrapper around wbxml_buffer_create_in_arena_real() to track Memory */
+#define wbxml_buffer_create_in_arena(a,b,c) \
+  wbxml_mem_cleam(wbxml_buffer_create_in_arena_real(a,(const WB_UTINY *)b,c))
+
 /**
  * @brief Destroy a Buffer
  * @param buff The Buffer to destroy
@@ -110,7 +163,7 @@ WBXML_DECLARE_NONSTD(void) wbxml_buffer_destroy_item(void *buff);
  * Duplicate a Buffer
  *
  * Even if a static buffer is provided, the duplicated buffer is
- * a dynamic buffer.
+ * a dynamic buffer. It has the same Allocator as 'buff'.
  *
  * @param buff The Buffer to duplicate
  * @return The duplicated buffer, or NULL if not enough memory
@@ -148,6 +201,17 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_set_char(WBXMLBuffer *buff, WB_ULONG pos, WB
  */
 WBXML_DECLARE(WB_UTINY *) wbxml_buffer_get_cstr(WBXMLBuffer *buff);
 
+/**
+ * @brief Take the data of a dynamic Buffer
+ * @param buff The Buffer
+ * @param len [out] The data length (can be NULL)
+ * @return The NULL terminated data (to be freed with wbxml_mem_free() and the Allocator of Buffer),
+ *         or NULL if Buffer is static or empty
+ * @note The Buffer is then empty, and can still be used: this saves a copy when the data of a
+ *       Buffer is the final result
+ */
+WBXML_DECLARE(WB_UTINY *) wbxml_buffer_detach(WBXMLBuffer *buff, WB_ULONG *len);
+
 /**
  * @brief Insert a Buffer into a dynamic Buffer
  * @param to The Buffer to modify
@@ -207,6 +271,23 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_append_cstr_real(WBXMLBuffer *buff, const WB
  */
 WBXML_DECLARE(WB_BOOL) wbxml_buffer_append_char(WBXMLBuffer *buff, WB_UTINY ch);
 
+/**
+ * @brief Make room in a dynamic Buffer, so that bytes can then be appended without reallocation
+ * @param buff The Buffer
+ * @param len Number of bytes
+ * @return TRUE if done, FALSE otherwise
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_buffer_reserve(WBXMLBuffer *buff, WB_ULONG len);
+
+/**
+ * @brief Append room for bytes to a dynamic Buffer, to be written there by caller
+ * @param buff The Buffer
+ * @param len Number of bytes to append
+ * @return Pointer to the appended bytes (not initialized), or NULL if not appended
+ * @note Unused bytes can then be removed with wbxml_buffer_delete()
+ */
+WBXML_DECLARE(WB_UTINY *) wbxml_buffer_append_space(WBXMLBuffer *buff, WB_ULONG len);
+
 /**
  * @brief Append a Multibyte Integer to a dynamic Buffer
  * @param buff The Buffer
@@ -236,6 +317,15 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_shrink_blanks(WBXMLBuffer *buff);
  */
 WBXML_DECLARE(WB_BOOL) wbxml_buffer_strip_blanks(WBXMLBuffer *buff);
 
+/**
+ * @brief Get the part of a Buffer without whitespaces at beginning and end
+ * @param buff  The Buffer
+ * @param start [out] Position of the first char that is not a whitespace
+ * @param len   [out] Length of the part without whitespaces (0 if Buffer is blank)
+ * @note Unlike wbxml_buffer_strip_blanks(), the Buffer is not modified (it can be a static one)
+ */
+WBXML_DECLARE(void) wbxml_buffer_get_stripped_bounds(WBXMLBuffer *buff, WB_ULONG *start, WB_ULONG *len);
+
 /**
  * @brief Compare two Buffers
  * @param buff1
@@ -256,6 +346,7 @@ WBXML_DECLARE(WB_LONG) wbxml_buffer_compare_cstr(WBXMLBuffer *buff, const WB_TIN
  * @brief Split a Buffer into words at whitespace
  * @param buff The buffer to split
  * @return The List of splitted Words, or NULL if not enough memory
+ * @note The List and the Words have the same Allocator as 'buff'
  * @warning Do NOT use this function directly, use wbxml_buffer_split_words() macro instead
  */
 WBXML_DECLARE(WBXMLList *) wbxml_buffer_split_words_real(WBXMLBuffer *buff);
@@ -314,18 +405,36 @@ WBXML_DECLARE(WB_BOOL) wbxml_buffer_binary_to_hex(WBXMLBuffer *buffer, WB_BOOL u
 
 /**
  * @brief Convert base64 encoded data to binary data
- * @param buffer The buffer to convert
- * @return TRUE if converted, FALSE otherwise
+ * @param buffer The buffer to convert (in place)
+ * @return WBXML_OK if converted, an error code otherwise
  */
 WBXML_DECLARE(WBXMLError) wbxml_buffer_decode_base64(WBXMLBuffer *buffer);
 
 /**
  * @brief Convert binary data to base64 encoded data
- * @param buffer The buffer to convert
- * @return TRUE if converted, FALSE otherwise
+ * @param buffer The buffer to convert (in place)
+ * @return WBXML_OK if converted, an error code otherwise
  */
 WBXML_DECLARE(WBXMLError) wbxml_buffer_encode_base64(WBXMLBuffer *buffer);
 
+/**
+ * @brief Append binary data to a Buffer, Base64 encoded
+ * @param buffer The Buffer
+ * @param data   The data to encode (may be part of 'buffer')
+ * @param len    Data length
+ * @return WBXML_OK if appended, an error code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_buffer_append_base64_encoded(WBXMLBuffer *buffer, const WB_UTINY *data, WB_ULONG len);
+
+/**
+ * @brief Append Base64 encoded data to a Buffer, decoded
+ * @param buffer The Buffer
+ * @param data   The data to decode (decoding stops at the first non-Base64 character)
+ * @param len    Data length
+ * @return WBXML_OK if appended, an error code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_buffer_append_base64_decoded(WBXMLBuffer *buffer, const WB_UTINY *data, WB_ULONG len);
+
 /**
  * @brief Remove trailing Zeros from a dynamic Buffer
  * @param buffer The buffer
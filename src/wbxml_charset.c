@@ -35,6 +35,7 @@
 
 #include "wbxml_charset.h"
 #include "wbxml_internals.h"
+#include "wbxml_config_internals.h"
 
 /* Structures */
 
@@ -44,6 +45,69 @@ typedef struct WBXMLCharsetEntry_s {
     WBXMLCharsetMIBEnum  mib_enum; /**< Charset MIBEnum Value */
 } WBXMLCharsetEntry;
 
+/**
+ * @brief Charset Converter written by hand
+ * @param in       Buffer to convert
+ * @param io_bytes Number of bytes in buffer, decremented by the number of bytes converted
+ * @param out      Where the result is written (at least 2 * 'io_bytes' + 2 bytes)
+ * @return Number of bytes written
+ * @note Conversion stops at the first invalid or incomplete sequence (as iconv() does)
+ */
+typedef WB_ULONG (*WBXMLCharsetConvFunc)(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+
+/** Charset Converter of a charsets pair */
+typedef struct WBXMLCharsetConverter_s {
+    WBXMLCharsetMIBEnum  from; /**< Original charset */
+    WBXMLCharsetMIBEnum  to;   /**< Destination charset */
+    WBXMLCharsetConvFunc conv; /**< Converter */
+} WBXMLCharsetConverter;
+
+#if defined( HAVE_ICONV )
+/** iconv Conversion Descriptor of a charsets pair, kept for next conversions */
+typedef struct WBXMLCharsetIconv_s {
+    WBXMLCharsetMIBEnum from; /**< Original charset (WBXML_CHARSET_UNKNOWN if not used) */
+    WBXMLCharsetMIBEnum to;   /**< Destination charset */
+    iconv_t             cd;   /**< Conversion Descriptor */
+} WBXMLCharsetIconv;
+#endif /* HAVE_ICONV */
+
+/** Number of iconv Conversion Descriptors kept by each thread */
+#define WBXML_CHARSET_ICONV_CACHE_LEN 4
+
+/** Room left in output when iconv() stops, under which it may have stopped because output is full */
+#define WBXML_CHARSET_ICONV_MIN_ROOM 16
+
+
+/* Private Functions Prototypes */
+static WB_BOOL search_null_block(const WB_TINY *in_buf,
+                                 WB_ULONG       in_buf_len,
+                                 WB_ULONG       block_len,
+                                 WB_ULONG      *out_pos);
+
+static WB_ULONG conv_latin1_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+static WB_ULONG conv_utf16_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+static WB_ULONG conv_ucs2_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+static WB_ULONG conv_utf8_to_latin1(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+static WB_ULONG conv_utf8_to_utf16(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+static WB_ULONG conv_utf8_to_ucs2(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out);
+
+static WB_ULONG utf16_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out, WB_BOOL surrogates);
+static WB_ULONG utf8_to_utf16(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out, WB_BOOL surrogates);
+static WB_ULONG utf8_decode(const WB_UTINY *in, WB_ULONG len, WB_ULONG *ch);
+static WB_ULONG utf8_encode(WB_ULONG ch, WB_UTINY *out);
+
+#if defined( HAVE_ICONV )
+static WBXMLError charset_iconv_conv(const WB_TINY       *in_buf,
+                                     WB_ULONG            *io_bytes,
+                                     WBXMLCharsetMIBEnum  in_charset,
+                                     WBXMLBuffer         *out_buf,
+                                     WBXMLCharsetMIBEnum  out_charset);
+static WBXMLError charset_iconv_open(WBXMLCharsetMIBEnum  in_charset,
+                                     WBXMLCharsetMIBEnum  out_charset,
+                                     iconv_t             *cd,
+                                     WB_BOOL             *cached);
+#endif /* HAVE_ICONV */
+
 
 /* Globals */
 
@@ -70,12 +134,28 @@ static const WBXMLCharsetEntry wbxml_charset_entries[] =
     { "Big5",            WBXML_CHARSET_BIG5            }
 };
 
+/**
+ * @brief Converters written by hand, for the most used charsets
+ * @note  UTF-16 and UCS-2 are read as Big Endian, unless they start with a Byte Order Mark (RFC 2781).
+ *        UTF-16 is written as Big Endian, after a Byte Order Mark. UCS-2 is written as Big Endian.
+ */
+static const WBXMLCharsetConverter wbxml_charset_converters[] =
+{
+    { WBXML_CHARSET_ISO_8859_1,      WBXML_CHARSET_UTF_8,           conv_latin1_to_utf8 },
+    { WBXML_CHARSET_UTF_16,          WBXML_CHARSET_UTF_8,           conv_utf16_to_utf8  },
+    { WBXML_CHARSET_ISO_10646_UCS_2, WBXML_CHARSET_UTF_8,           conv_ucs2_to_utf8   },
+    { WBXML_CHARSET_UTF_8,           WBXML_CHARSET_ISO_8859_1,      conv_utf8_to_latin1 },
+    { WBXML_CHARSET_UTF_8,           WBXML_CHARSET_UTF_16,          conv_utf8_to_utf16  },
+    { WBXML_CHARSET_UTF_8,           WBXML_CHARSET_ISO_10646_UCS_2, conv_utf8_to_ucs2   }
+};
 
-/* Private Functions Prototypes */
-static WB_BOOL search_null_block(const WB_TINY *in_buf,
-                                 WB_ULONG       in_buf_len,
-                                 WB_ULONG       block_len,
-                                 WB_ULONG      *out_pos);
+#if defined( HAVE_ICONV ) && defined( WBXML_THREAD_LOCAL )
+/** iconv Conversion Descriptors of calling thread (cf wbxml_charset_conv_cleanup()) */
+static WBXML_THREAD_LOCAL WBXMLCharsetIconv sv_iconv_cache[WBXML_CHARSET_ICONV_CACHE_LEN];
+
+/** Next Conversion Descriptor replaced in 'sv_iconv_cache' */
+static WBXML_THREAD_LOCAL WB_ULONG sv_iconv_cache_next = 0;
+#endif /* HAVE_ICONV && WBXML_THREAD_LOCAL */
 
 
 /***************************************************
@@ -126,6 +206,24 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv(const WB_TINY        *in_buf,
                                              WBXMLBuffer         **out_buf,
                                              WBXMLCharsetMIBEnum   out_charset)
 {
+    return wbxml_charset_conv_with_allocator(NULL, in_buf, io_bytes, in_charset, out_buf, out_charset);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_charset_conv_with_allocator(WBXMLAllocator       *allocator,
+                                                            const WB_TINY        *in_buf,
+                                                            WB_ULONG             *io_bytes,
+                                                            WBXMLCharsetMIBEnum   in_charset,
+                                                            WBXMLBuffer         **out_buf,
+                                                            WBXMLCharsetMIBEnum   out_charset)
+{
+    const WBXMLCharsetConverter *converter = NULL;
+    WBXMLBuffer *result  = NULL;
+    WB_UTINY    *out     = NULL;
+    WB_ULONG     out_len = 0;
+    WB_ULONG     i       = 0;
+    WBXMLError   ret     = WBXML_OK;
+
     /**************************************************
      * First, check for simple US-ASCII / UTF-8 cases
      */
@@ -135,7 +233,7 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv(const WB_TINY        *in_buf,
         ((out_charset == WBXML_CHARSET_US_ASCII) || (out_charset == WBXML_CHARSET_UTF_8)))
     {
         /* Create a static buffer */
-        if ((*out_buf = wbxml_buffer_sta_create_from_cstr(in_buf)) == NULL) {
+        if ((*out_buf = wbxml_buffer_sta_create_with_allocator(allocator, in_buf, WBXML_STRLEN(in_buf))) == NULL) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
 
@@ -148,106 +246,81 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv(const WB_TINY        *in_buf,
     /**************************************
      * Ok guys, we really have to convert
      */
-  
-#if defined( HAVE_ICONV )
-  
-    {
-        /**********************
-         * The iconv way
-         */
-    
-        const WB_TINY * inbuf_pos    = NULL;
-        WB_TINY      **__restrict__ inbuf_ref = NULL;
-        const WB_TINY * charset_to   = NULL;
-        const WB_TINY * charset_from = NULL;
-        WB_TINY       * tmp_buf      = NULL;
-        WB_TINY       * tmp_ptr      = NULL;
-        WB_ULONG        tmp_buf_len  = 0;
-        WB_ULONG        tmp_len_left = 0;
-        WBXMLError      ret          = WBXML_OK;
-        iconv_t         cd           = 0;
-        WB_UTINY        last_char    = 0;
-    
-        /* Get Charsets names */
-        if (!wbxml_charset_get_name(in_charset, &charset_from)) {
-            return WBXML_ERROR_CHARSET_UNKNOWN;
-        }
-  
-        if (!wbxml_charset_get_name(out_charset, &charset_to)) {
-            return WBXML_ERROR_CHARSET_UNKNOWN;
-        }
-    
-        /* Init iconv */
-        if ((cd = iconv_open(charset_to, charset_from)) == (iconv_t)(-1))
-        {
-            /* Init failed */
-            return WBXML_ERROR_CHARSET_CONV_INIT;
-        }
-    
-        /* Allocate maximum result buffer (4 bytes unicode) */
-        tmp_len_left = tmp_buf_len = 4 * (sizeof(WB_TINY) * (*io_bytes));
-    
-        if ((tmp_buf = wbxml_malloc(tmp_buf_len)) == NULL) {
-            iconv_close(cd);
-            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    for (i = 0; i < WBXML_TABLE_SIZE(wbxml_charset_converters); i++) {
+        if ((wbxml_charset_converters[i].from == in_charset) && (wbxml_charset_converters[i].to == out_charset)) {
+            converter = &wbxml_charset_converters[i];
+            break;
         }
+    }
 
-        tmp_ptr = tmp_buf;
+#if !defined( HAVE_ICONV )
+    if (converter == NULL) {
+        /***************************************************
+         * Add your own charset conversion function here !
+         */
 
-        /* The input buffer is const but not the pointer itself.
-           The original const *inbuf should not be modified for a potential later usage.
+        return WBXML_ERROR_NO_CHARSET_CONV;
+    }
+#endif /* !HAVE_ICONV */
+
+    /* The result is written straight into its buffer */
+    if ((result = wbxml_buffer_create_with_allocator(allocator, NULL, 0, 0)) == NULL) {
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    if (converter != NULL) {
+        /**********************
+         * The fast way
          */
-        inbuf_pos = in_buf;
-        inbuf_ref = (WB_TINY **__restrict__) &inbuf_pos;
-    
-        /* Convert ! */
-        (void) iconv(cd,
-                     inbuf_ref,
-                     (size_t*)io_bytes,
-                     &tmp_buf,
-                     (size_t*)&tmp_len_left);
-
-        /** @todo Check errno (but it doesn't seems to work on windows) */
-
-        if (tmp_buf_len > tmp_len_left) {
-            /* Create result buffer */
-            if ((*out_buf = wbxml_buffer_create(tmp_ptr,
-                                                tmp_buf_len - tmp_len_left,
-                                                tmp_buf_len - tmp_len_left)) == NULL)
-            {
-                /* Not enough memory */
-                ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
-            }
 
-            /* Remove trailing NULL char */
-            wbxml_buffer_remove_trailing_zeros(*out_buf);
+        if ((out = wbxml_buffer_append_space(result, 2 * (*io_bytes) + 2)) == NULL) {
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
-        else
-        {
-            /* Not converted */
-            ret = WBXML_ERROR_CHARSET_CONV;
-        }
-    
-        /* Shutdown iconv */
-        iconv_close(cd);
-    
-        /* Clean-up */
-        wbxml_free(tmp_ptr);
+        else {
+            out_len = converter->conv((const WB_UTINY *) in_buf, io_bytes, out);
 
-        return ret;
+            /* Remove unused bytes */
+            wbxml_buffer_delete(result, out_len, wbxml_buffer_len(result) - out_len);
+        }
     }
-  
-#else
-  
-    {
-        /***************************************************
-         * Add your own charset conversion function here !
+#if defined( HAVE_ICONV )
+    else {
+        /**********************
+         * The iconv way
          */
-    
-        return WBXML_ERROR_NO_CHARSET_CONV;
+
+        ret = charset_iconv_conv(in_buf, io_bytes, in_charset, result, out_charset);
     }
-  
 #endif /* HAVE_ICONV */
+
+    if ((ret == WBXML_OK) && (wbxml_buffer_len(result) == 0)) {
+        /* Not converted */
+        ret = WBXML_ERROR_CHARSET_CONV;
+    }
+
+    if (ret != WBXML_OK) {
+        wbxml_buffer_destroy(result);
+        return ret;
+    }
+
+    /* Remove trailing NULL char */
+    if ((out_charset == WBXML_CHARSET_ISO_10646_UCS_2) || (out_charset == WBXML_CHARSET_UTF_16)) {
+        /* Two bytes long: do not cut a character ending with a NULL byte */
+        while ((wbxml_buffer_len(result) >= 2) &&
+               (wbxml_buffer_get_cstr(result)[wbxml_buffer_len(result) - 1] == '\0') &&
+               (wbxml_buffer_get_cstr(result)[wbxml_buffer_len(result) - 2] == '\0'))
+        {
+            wbxml_buffer_delete(result, wbxml_buffer_len(result) - 2, 2);
+        }
+    }
+    else {
+        wbxml_buffer_remove_trailing_zeros(result);
+    }
+
+    *out_buf = result;
+
+    return WBXML_OK;
 }
 
 
@@ -256,10 +329,22 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term(const WB_TINY        *in_buf,
                                                   WBXMLCharsetMIBEnum   in_charset,
                                                   WBXMLBuffer         **out_buf,
                                                   WBXMLCharsetMIBEnum   out_charset)
+{
+    return wbxml_charset_conv_term_with_allocator(NULL, in_buf, io_bytes, in_charset, out_buf, out_charset);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term_with_allocator(WBXMLAllocator       *allocator,
+                                                                 const WB_TINY        *in_buf,
+                                                                 WB_ULONG             *io_bytes,
+                                                                 WBXMLCharsetMIBEnum   in_charset,
+                                                                 WBXMLBuffer         **out_buf,
+                                                                 WBXMLCharsetMIBEnum   out_charset)
 {
     WB_ULONG   buf_len  = 0;
     WB_ULONG   new_len  = 0;
     WB_ULONG   term_len = 0;
+    const WB_TINY *term = NULL;
     WBXMLError ret      = WBXML_OK;
   
     /* Find length of input buffer */
@@ -282,7 +367,12 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term(const WB_TINY        *in_buf,
         /* Terminated by a simple NULL char ('\0') */
         term_len = 1;
 
-        buf_len = WBXML_STRLEN(in_buf) + term_len;
+        /* Do not look past the input buffer: it may not be NULL terminated */
+        if ((term = memchr(in_buf, '\0', *io_bytes)) == NULL) {
+            return WBXML_ERROR_CHARSET_STR_LEN;
+        }
+
+        buf_len = (WB_ULONG) (term - in_buf) + term_len;
         break;
     }
 
@@ -295,11 +385,12 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term(const WB_TINY        *in_buf,
     new_len = buf_len;
   
     /* Convert ! */
-    ret = wbxml_charset_conv(in_buf, 
-                             &new_len,
-                             in_charset,
-                             out_buf,
-                             out_charset);
+    ret = wbxml_charset_conv_with_allocator(allocator,
+                                            in_buf,
+                                            &new_len,
+                                            in_charset,
+                                            out_buf,
+                                            out_charset);
   
     /* Set input buffer length */           
     *io_bytes = buf_len;
@@ -308,6 +399,23 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term(const WB_TINY        *in_buf,
 }
 
 
+WBXML_DECLARE(void) wbxml_charset_conv_cleanup(void)
+{
+#if defined( HAVE_ICONV ) && defined( WBXML_THREAD_LOCAL )
+    WB_ULONG i = 0;
+
+    for (i = 0; i < WBXML_CHARSET_ICONV_CACHE_LEN; i++) {
+        if (sv_iconv_cache[i].from != WBXML_CHARSET_UNKNOWN) {
+            iconv_close(sv_iconv_cache[i].cd);
+            sv_iconv_cache[i].from = WBXML_CHARSET_UNKNOWN;
+        }
+    }
+
+    sv_iconv_cache_next = 0;
+#endif /* HAVE_ICONV && WBXML_THREAD_LOCAL */
+}
+
+
 /***************************************************
  *    Private Functions
  */
@@ -344,3 +452,419 @@ static WB_BOOL search_null_block(const WB_TINY *in_buf,
 
     return FALSE;
 }
+
+
+/**
+ * @brief Convert ISO-8859-1 to UTF-8
+ * @note Every byte is a character
+ */
+static WB_ULONG conv_latin1_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    WB_ULONG len = *io_bytes;
+    WB_ULONG out_len = 0;
+    WB_ULONG i = 0;
+
+    for (i = 0; i < len; i++) {
+        if (in[i] < 0x80) {
+            out[out_len++] = in[i];
+        }
+        else {
+            out[out_len++] = (WB_UTINY) (0xc0 | (in[i] >> 6));
+            out[out_len++] = (WB_UTINY) (0x80 | (in[i] & 0x3f));
+        }
+    }
+
+    *io_bytes = 0;
+
+    return out_len;
+}
+
+
+/** @brief Convert UTF-16 to UTF-8 */
+static WB_ULONG conv_utf16_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    return utf16_to_utf8(in, io_bytes, out, TRUE);
+}
+
+
+/** @brief Convert UCS-2 to UTF-8 */
+static WB_ULONG conv_ucs2_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    return utf16_to_utf8(in, io_bytes, out, FALSE);
+}
+
+
+/**
+ * @brief Convert UTF-8 to ISO-8859-1
+ * @note Stops at the first character that is not in ISO-8859-1
+ */
+static WB_ULONG conv_utf8_to_latin1(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    WB_ULONG len = *io_bytes;
+    WB_ULONG out_len = 0;
+    WB_ULONG pos = 0;
+    WB_ULONG ch = 0;
+    WB_ULONG seq_len = 0;
+
+    while (pos < len) {
+        if (in[pos] < 0x80) {
+            out[out_len++] = in[pos++];
+            continue;
+        }
+
+        if (((seq_len = utf8_decode(in + pos, len - pos, &ch)) == 0) || (ch > 0xff))
+            break;
+
+        out[out_len++] = (WB_UTINY) ch;
+        pos += seq_len;
+    }
+
+    *io_bytes = len - pos;
+
+    return out_len;
+}
+
+
+/** @brief Convert UTF-8 to UTF-16 */
+static WB_ULONG conv_utf8_to_utf16(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    return utf8_to_utf16(in, io_bytes, out, TRUE);
+}
+
+
+/** @brief Convert UTF-8 to UCS-2 */
+static WB_ULONG conv_utf8_to_ucs2(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out)
+{
+    return utf8_to_utf16(in, io_bytes, out, FALSE);
+}
+
+
+/**
+ * @brief Convert UTF-16 or UCS-2 to UTF-8
+ * @param in         Buffer to convert
+ * @param io_bytes   Number of bytes in buffer, decremented by the number of bytes converted
+ * @param out        Where the result is written
+ * @param surrogates TRUE for UTF-16 (surrogate pairs), FALSE for UCS-2 (surrogates are invalid)
+ * @return Number of bytes written
+ * @note Big Endian, unless the buffer starts with a Byte Order Mark (which is not converted)
+ */
+static WB_ULONG utf16_to_utf8(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out, WB_BOOL surrogates)
+{
+    WB_ULONG len = *io_bytes;
+    WB_ULONG out_len = 0;
+    WB_ULONG pos = 0;
+    WB_ULONG ch = 0, low = 0;
+    WB_ULONG hi = 0, lo = 1;
+
+    /* Byte Order Mark */
+    if (len >= 2) {
+        if ((in[0] == 0xff) && (in[1] == 0xfe)) {
+            hi = 1;
+            lo = 0;
+            pos = 2;
+        }
+        else if ((in[0] == 0xfe) && (in[1] == 0xff)) {
+            pos = 2;
+        }
+    }
+
+    while (pos + 2 <= len) {
+        ch = ((WB_ULONG) in[pos + hi] << 8) | in[pos + lo];
+
+        if ((ch >= 0xd800) && (ch <= 0xdfff)) {
+            /* A high surrogate must be followed by a low one */
+            if (!surrogates || (ch >= 0xdc00) || (pos + 4 > len))
+                break;
+
+            low = ((WB_ULONG) in[pos + 2 + hi] << 8) | in[pos + 2 + lo];
+            if ((low < 0xdc00) || (low > 0xdfff))
+                break;
+
+            ch = 0x10000 + ((ch - 0xd800) << 10) + (low - 0xdc00);
+            pos += 2;
+        }
+
+        out_len += utf8_encode(ch, out + out_len);
+        pos += 2;
+    }
+
+    *io_bytes = len - pos;
+
+    return out_len;
+}
+
+
+/**
+ * @brief Convert UTF-8 to UTF-16 or UCS-2 (Big Endian)
+ * @param in         Buffer to convert
+ * @param io_bytes   Number of bytes in buffer, decremented by the number of bytes converted
+ * @param out        Where the result is written
+ * @param surrogates TRUE for UTF-16 (starts with a Byte Order Mark, surrogate pairs),
+ *                   FALSE for UCS-2 (stops at characters above U+FFFF)
+ * @return Number of bytes written
+ */
+static WB_ULONG utf8_to_utf16(const WB_UTINY *in, WB_ULONG *io_bytes, WB_UTINY *out, WB_BOOL surrogates)
+{
+    WB_ULONG len = *io_bytes;
+    WB_ULONG out_len = 0;
+    WB_ULONG pos = 0;
+    WB_ULONG ch = 0;
+    WB_ULONG seq_len = 0;
+
+    while (pos < len) {
+        if (in[pos] < 0x80) {
+            ch = in[pos];
+            seq_len = 1;
+        }
+        else if ((seq_len = utf8_decode(in + pos, len - pos, &ch)) == 0) {
+            break;
+        }
+
+        if ((ch > 0xffff) && !surrogates)
+            break;
+
+        if (surrogates && (out_len == 0)) {
+            out[out_len++] = 0xfe;
+            out[out_len++] = 0xff;
+        }
+
+        if (ch > 0xffff) {
+            ch -= 0x10000;
+            out[out_len++] = (WB_UTINY) (0xd8 | (ch >> 18));
+            out[out_len++] = (WB_UTINY) ((ch >> 10) & 0xff);
+            out[out_len++] = (WB_UTINY) (0xdc | ((ch >> 8) & 0x03));
+            out[out_len++] = (WB_UTINY) (ch & 0xff);
+        }
+        else {
+            out[out_len++] = (WB_UTINY) (ch >> 8);
+            out[out_len++] = (WB_UTINY) (ch & 0xff);
+        }
+
+        pos += seq_len;
+    }
+
+    *io_bytes = len - pos;
+
+    return out_len;
+}
+
+
+/**
+ * @brief Decode a multi-bytes UTF-8 sequence
+ * @param in  The sequence
+ * @param len Number of bytes available
+ * @param ch  The decoded character
+ * @return Length of the sequence, or 0 if it is invalid or incomplete
+ * @note Overlong sequences, surrogates and characters above U+10FFFF are invalid
+ */
+static WB_ULONG utf8_decode(const WB_UTINY *in, WB_ULONG len, WB_ULONG *ch)
+{
+    WB_ULONG seq_len = 0;
+    WB_ULONG min = 0;
+    WB_ULONG i = 0;
+
+    if ((in[0] & 0xe0) == 0xc0) {
+        seq_len = 2;
+        min = 0x80;
+        *ch = in[0] & 0x1f;
+    }
+    else if ((in[0] & 0xf0) == 0xe0) {
+        seq_len = 3;
+        min = 0x800;
+        *ch = in[0] & 0x0f;
+    }
+    else if ((in[0] & 0xf8) == 0xf0) {
+        seq_len = 4;
+        min = 0x10000;
+        *ch = in[0] & 0x07;
+    }
+    else {
+        return 0;
+    }
+
+    if (seq_len > len)
+        return 0;
+
+    for (i = 1; i < seq_len; i++) {
+        if ((in[i] & 0xc0) != 0x80)
+            return 0;
+
+        *ch = (*ch << 6) | (in[i] & 0x3f);
+    }
+
+    if ((*ch < min) || (*ch > 0x10ffff) || ((*ch >= 0xd800) && (*ch <= 0xdfff)))
+        return 0;
+
+    return seq_len;
+}
+
+
+/**
+ * @brief Encode a character in UTF-8
+ * @param ch  The character (at most U+10FFFF)
+ * @param out Where the sequence is written
+ * @return Length of the sequence
+ */
+static WB_ULONG utf8_encode(WB_ULONG ch, WB_UTINY *out)
+{
+    if (ch < 0x80) {
+        out[0] = (WB_UTINY) ch;
+        return 1;
+    }
+
+    if (ch < 0x800) {
+        out[0] = (WB_UTINY) (0xc0 | (ch >> 6));
+        out[1] = (WB_UTINY) (0x80 | (ch & 0x3f));
+        return 2;
+    }
+
+    if (ch < 0x10000) {
+        out[0] = (WB_UTINY) (0xe0 | (ch >> 12));
+        out[1] = (WB_UTINY) (0x80 | ((ch >> 6) & 0x3f));
+        out[2] = (WB_UTINY) (0x80 | (ch & 0x3f));
+        return 3;
+    }
+
+    out[0] = (WB_UTINY) (0xf0 | (ch >> 18));
+    out[1] = (WB_UTINY) (0x80 | ((ch >> 12) & 0x3f));
+    out[2] = (WB_UTINY) (0x80 | ((ch >> 6) & 0x3f));
+    out[3] = (WB_UTINY) (0x80 | (ch & 0x3f));
+    return 4;
+}
+
+
+#if defined( HAVE_ICONV )
+
+/**
+ * @brief Convert a buffer with iconv
+ * @param in_buf      Buffer to convert
+ * @param io_bytes    Number of bytes in buffer, decremented by the number of bytes converted
+ * @param in_charset  Original charset
+ * @param out_buf     Buffer where the result is appended
+ * @param out_charset Destination charset
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError charset_iconv_conv(const WB_TINY       *in_buf,
+                                     WB_ULONG            *io_bytes,
+                                     WBXMLCharsetMIBEnum  in_charset,
+                                     WBXMLBuffer         *out_buf,
+                                     WBXMLCharsetMIBEnum  out_charset)
+{
+    iconv_t     cd          = (iconv_t) -1;
+    WB_BOOL     cached      = FALSE;
+    WB_ULONG    room        = 2 * (*io_bytes) + WBXML_CHARSET_ICONV_MIN_ROOM;
+    WB_ULONG    used        = 0;
+    WB_UTINY   *out         = NULL;
+    char       *inbuf_pos   = (char *) in_buf;
+    size_t      inbuf_left  = *io_bytes;
+    char       *outbuf_pos  = NULL;
+    size_t      outbuf_left = 0;
+    WBXMLError  ret         = WBXML_OK;
+
+    if ((ret = charset_iconv_open(in_charset, out_charset, &cd, &cached)) != WBXML_OK)
+        return ret;
+
+    while (ret == WBXML_OK) {
+        /* Write straight into the buffer */
+        if ((out = wbxml_buffer_append_space(out_buf, room)) == NULL) {
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            break;
+        }
+
+        outbuf_pos = (char *) out;
+        outbuf_left = room;
+
+        /* Convert ! */
+        (void) iconv(cd,
+                     &inbuf_pos,
+                     &inbuf_left,
+                     &outbuf_pos,
+                     &outbuf_left);
+
+        /* Remove unused bytes */
+        used = room - (WB_ULONG) outbuf_left;
+        wbxml_buffer_delete(out_buf, wbxml_buffer_len(out_buf) - (WB_ULONG) outbuf_left, (WB_ULONG) outbuf_left);
+
+        /* Stopped because of output room: go on with more of it */
+        if ((inbuf_left == 0) || (outbuf_left >= WBXML_CHARSET_ICONV_MIN_ROOM) || (used == 0))
+            break;
+
+        room *= 2;
+    }
+
+    *io_bytes = (WB_ULONG) inbuf_left;
+
+    if (cached) {
+        /* Reset Conversion Descriptor for next conversion */
+        (void) iconv(cd, NULL, NULL, NULL, NULL);
+    }
+    else {
+        iconv_close(cd);
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief Get an iconv Conversion Descriptor
+ * @param in_charset  Original charset
+ * @param out_charset Destination charset
+ * @param cd          The Conversion Descriptor
+ * @param cached      TRUE if the Conversion Descriptor is kept by calling thread (must not be closed)
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError charset_iconv_open(WBXMLCharsetMIBEnum  in_charset,
+                                     WBXMLCharsetMIBEnum  out_charset,
+                                     iconv_t             *cd,
+                                     WB_BOOL             *cached)
+{
+    const WB_TINY *charset_from = NULL;
+    const WB_TINY *charset_to   = NULL;
+#if defined( WBXML_THREAD_LOCAL )
+    WBXMLCharsetIconv *entry = NULL;
+    WB_ULONG           i     = 0;
+
+    for (i = 0; i < WBXML_CHARSET_ICONV_CACHE_LEN; i++) {
+        if ((sv_iconv_cache[i].from == in_charset) && (sv_iconv_cache[i].to == out_charset)) {
+            *cd = sv_iconv_cache[i].cd;
+            *cached = TRUE;
+            return WBXML_OK;
+        }
+    }
+#endif /* WBXML_THREAD_LOCAL */
+
+    *cached = FALSE;
+
+    /* Get Charsets names */
+    if (!wbxml_charset_get_name(in_charset, &charset_from) ||
+        !wbxml_charset_get_name(out_charset, &charset_to))
+    {
+        return WBXML_ERROR_CHARSET_UNKNOWN;
+    }
+
+    /* Init iconv */
+    if ((*cd = iconv_open(charset_to, charset_from)) == (iconv_t) -1) {
+        /* Init failed */
+        return WBXML_ERROR_CHARSET_CONV_INIT;
+    }
+
+#if defined( WBXML_THREAD_LOCAL )
+    /* Keep it, in place of the oldest one */
+    entry = &sv_iconv_cache[sv_iconv_cache_next];
+    sv_iconv_cache_next = (sv_iconv_cache_next + 1) % WBXML_CHARSET_ICONV_CACHE_LEN;
+
+    if (entry->from != WBXML_CHARSET_UNKNOWN)
+        iconv_close(entry->cd);
+
+    entry->from = in_charset;
+    entry->to = out_charset;
+    entry->cd = *cd;
+
+    *cached = TRUE;
+#endif /* WBXML_THREAD_LOCAL */
+
+    return WBXML_OK;
+}
+
+#endif /* HAVE_ICONV */
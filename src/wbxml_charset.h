@@ -79,6 +79,12 @@ WBXML_DECLARE(WB_BOOL) wbxml_charset_get_name(WBXMLCharsetMIBEnum   mib_enum,
  * converted from 'in_buf', so that it reflects the number of bytes that
  * have been converted from 'in_buf'.
  *
+ * Conversions between UTF-8 and ISO-8859-1, UTF-16 or UCS-2 are done
+ * without iconv. UTF-16 and UCS-2 are read as Big Endian, unless they
+ * start with a Byte Order Mark. Other conversions use iconv: each thread
+ * keeps the last Conversion Descriptors it used, until it calls
+ * wbxml_charset_conv_cleanup().
+ *
  * @param in_buf      Buffer to convert
  * @param io_bytes    Number of bytes in buffer
  * @param in_charset  Original charset
@@ -91,6 +97,25 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv(const WB_TINY        *in_buf,
                                              WBXMLBuffer         **out_buf,
                                              WBXMLCharsetMIBEnum   out_charset);
 
+/**
+ * Charset Convertion function, with an Allocator
+ *
+ * Same as wbxml_charset_conv(), but the resulting Buffer is created with 'allocator'.
+ *
+ * @param allocator   Allocator of resulting Buffer (NULL to use the default one)
+ * @param in_buf      Buffer to convert
+ * @param io_bytes    Number of bytes in buffer
+ * @param in_charset  Original charset
+ * @param out_buf     Resulting converted Buffer
+ * @param out_charset Destination charset
+ */
+WBXML_DECLARE(WBXMLError) wbxml_charset_conv_with_allocator(WBXMLAllocator       *allocator,
+                                                            const WB_TINY        *in_buf,
+                                                            WB_ULONG             *io_bytes,
+                                                            WBXMLCharsetMIBEnum   in_charset,
+                                                            WBXMLBuffer         **out_buf,
+                                                            WBXMLCharsetMIBEnum   out_charset);
+
 /**
  * Charset Convertion function, for unknown length strings
  *
@@ -117,6 +142,32 @@ WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term(const WB_TINY        *in_buf,
                                                   WBXMLBuffer         **out_buf,
                                                   WBXMLCharsetMIBEnum   out_charset);
 
+/**
+ * Charset Convertion function, for unknown length strings, with an Allocator
+ *
+ * Same as wbxml_charset_conv_term(), but the resulting Buffer is created with 'allocator'.
+ *
+ * @param allocator   Allocator of resulting Buffer (NULL to use the default one)
+ * @param in_buf      Buffer to convert
+ * @param io_bytes    Number of bytes in buffer
+ * @param in_charset  Original charset
+ * @param out_buf     Resulting converted Buffer
+ * @param out_charset Destination charset
+ */
+WBXML_DECLARE(WBXMLError) wbxml_charset_conv_term_with_allocator(WBXMLAllocator       *allocator,
+                                                                 const WB_TINY        *in_buf,
+                                                                 WB_ULONG             *io_bytes,
+                                                                 WBXMLCharsetMIBEnum   in_charset,
+                                                                 WBXMLBuffer         **out_buf,
+                                                                 WBXMLCharsetMIBEnum   out_charset);
+
+/**
+ * Close the iconv Conversion Descriptors kept by calling thread
+ *
+ * Call it before a thread that converted charsets exits.
+ */
+WBXML_DECLARE(void) wbxml_charset_conv_cleanup(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -35,6 +35,7 @@
 
 #include "wbxml_conv.h"
 #include "wbxml_tree.h"
+#include "wbxml_encoder.h"
 #include "wbxml_log.h"
 
 /****************************
@@ -48,13 +49,16 @@ struct WBXMLConvWBXML2XML_s {
     WBXMLCharsetMIBEnum charset; /**< Set document Language (does not overwrite document character set) */
     WB_UTINY indent;             /**< Indentation Delta, when using WBXML_GEN_XML_INDENT Generation Type (Default: 0) */
     WB_BOOL keep_ignorable_ws;   /**< Keep Ignorable Whitespaces (Default: FALSE) */
+    WBXMLAllocator *allocator;   /**< Allocator of this converter (NULL if default one is used) */
 };
 
 struct WBXMLConvXML2WBXML_s {
     WBXMLVersion wbxml_version; /**< WBXML Version */
     WB_BOOL keep_ignorable_ws;  /**< Keep Ignorable Whitespaces (Default: FALSE) */
     WB_BOOL use_strtbl;         /**< Generate String Table (Default: TRUE) */
+    WB_BOOL optimal_strtbl;     /**< Choose String Table content by bytes saved (Default: FALSE) */
     WB_BOOL produce_anonymous;  /**< Produce an anonymous document (Default: FALSE) */
+    WBXMLAllocator *allocator;  /**< Allocator of this converter (NULL if default one is used) */
 };
 
 /****************************
@@ -63,12 +67,23 @@ struct WBXMLConvXML2WBXML_s {
  */
 
 WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_create(WBXMLConvWBXML2XML **conv)
+{
+    return wbxml_conv_wbxml2xml_create_with_allocator(NULL, conv);
+}
+
+/**
+ * @brief Create a new WBXML to XML converter, that allocates with a given Allocator
+ * @param allocator [in] the Allocator of converter, and of the resulting XML Document (NULL for the default one)
+ * @param conv      [out] a reference to the pointer of the new converter
+ * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_create_with_allocator(WBXMLAllocator *allocator, WBXMLConvWBXML2XML **conv)
 {
     if (conv == NULL) {
         return WBXML_ERROR_BAD_PARAMETER;
     }
 
-    *conv = wbxml_malloc(sizeof(WBXMLConvWBXML2XML));
+    *conv = wbxml_mem_malloc(allocator, sizeof(WBXMLConvWBXML2XML));
     if (*conv == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
@@ -78,6 +93,7 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_create(WBXMLConvWBXML2XML **conv)
     (*conv)->charset  = WBXML_CHARSET_UNKNOWN;
     (*conv)->indent   = 0;
     (*conv)->keep_ignorable_ws = FALSE;
+    (*conv)->allocator = allocator;
 
     return WBXML_OK;
 }
@@ -139,11 +155,13 @@ WBXML_DECLARE(void) wbxml_conv_wbxml2xml_enable_preserve_whitespaces(WBXMLConvWB
 /**
  * @brief Convert WBXML to XML
  * @param conv      [in] the converter
- * @param wbxml     [in] WBXML Document to convert
+ * @param wbxml     [in] WBXML Document to convert (parsed in place, it is not modified)
  * @param wbxml_len [in] Length of WBXML Document
  * @param xml       [out] Resulting XML Document
  * @param xml_len   [out] XML Document length
  * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ * @note XML is encoded while WBXML is parsed, without building a WBXML Tree
+ *       (cf wbxml_encoder_encode_wbxml_to_xml())
  */
 WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_run(WBXMLConvWBXML2XML *conv,
                                                    WB_UTINY  *wbxml,
@@ -151,18 +169,10 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_run(WBXMLConvWBXML2XML *conv,
                                                    WB_UTINY **xml,
                                                    WB_ULONG  *xml_len)
 {
-    WBXMLGenXMLParams params;
-    WBXMLTree *wbxml_tree = NULL;
+    WBXMLEncoder *wbxml_encoder = NULL;
     WB_ULONG   dummy_len = 0;
     WBXMLError ret = WBXML_OK;
 
-    /* Copy options */
-    params.gen_type          = conv->gen_type;
-    params.lang              = conv->lang;
-    params.charset           = conv->charset;
-    params.keep_ignorable_ws = conv->keep_ignorable_ws;
-    params.indent            = conv->indent;
-
     /* Check Parameters (we allow 'xml_len' to be NULL for backward compatibility) */
     if ((wbxml == NULL) || (wbxml_len == 0) || (xml == NULL))
         return WBXML_ERROR_BAD_PARAMETER;
@@ -173,27 +183,38 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_run(WBXMLConvWBXML2XML *conv,
     *xml = NULL;
     *xml_len = 0;
 
-    /* Parse WBXML to WBXML Tree */
-    ret = wbxml_tree_from_wbxml(wbxml, wbxml_len, conv->lang, conv->charset, &wbxml_tree);
-    if (ret != WBXML_OK) {
-        WBXML_ERROR((WBXML_CONV, "wbxml2xml conversion failed - WBXML Parser Error: %s",
-                                 wbxml_errors_string(ret)));
+    /* Create WBXML Encoder (with the Allocator of converter) */
+    if ((wbxml_encoder = wbxml_encoder_create_with_allocator(conv->allocator)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-        return ret;
+    /* Set XML Generation Type */
+    wbxml_encoder_set_xml_gen_type(wbxml_encoder, conv->gen_type);
+
+    /* Set Indent */
+    if (conv->gen_type == WBXML_GEN_XML_INDENT)
+        wbxml_encoder_set_indent(wbxml_encoder, conv->indent);
+
+    /* Ignorable Whitespaces */
+    if (conv->keep_ignorable_ws) {
+        wbxml_encoder_set_ignore_empty_text(wbxml_encoder, FALSE);
+        wbxml_encoder_set_remove_text_blanks(wbxml_encoder, FALSE);
     }
     else {
-        /* Convert Tree to XML */
-        ret = wbxml_tree_to_xml(wbxml_tree, xml, xml_len, &params);
-        if (ret != WBXML_OK) {
-            WBXML_ERROR((WBXML_CONV, "wbxml2xml conversion failed - WBXML Encoder Error: %s",
-                                     wbxml_errors_string(ret)));
-        }
-
-        /* Clean-up */
-        wbxml_tree_destroy(wbxml_tree);
+        wbxml_encoder_set_ignore_empty_text(wbxml_encoder, TRUE);
+        wbxml_encoder_set_remove_text_blanks(wbxml_encoder, TRUE);
+    }
 
-        return ret;
+    /* Encode WBXML to XML */
+    ret = wbxml_encoder_encode_wbxml_to_xml(wbxml_encoder, wbxml, wbxml_len, conv->lang, conv->charset, xml, xml_len);
+    if (ret != WBXML_OK) {
+        WBXML_ERROR((WBXML_CONV, "wbxml2xml conversion failed: %s",
+                                 wbxml_errors_string(ret)));
     }
+
+    /* Clean-up */
+    wbxml_encoder_destroy(wbxml_encoder);
+
+    return ret;
 }
 
 /**
@@ -202,7 +223,10 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_run(WBXMLConvWBXML2XML *conv,
  */
 WBXML_DECLARE(void) wbxml_conv_wbxml2xml_destroy(WBXMLConvWBXML2XML *conv)
 {
-    wbxml_free(conv);
+    if (conv == NULL)
+        return;
+
+    wbxml_mem_free(conv->allocator, conv);
 }
 
 /**
@@ -211,12 +235,23 @@ WBXML_DECLARE(void) wbxml_conv_wbxml2xml_destroy(WBXMLConvWBXML2XML *conv)
  * @return WBXML_OK if conversion succeeded, an Error Code otherwise
  */
 WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_create(WBXMLConvXML2WBXML **conv)
+{
+    return wbxml_conv_xml2wbxml_create_with_allocator(NULL, conv);
+}
+
+/**
+ * @brief Create a new XML to WBXML converter, that allocates with a given Allocator
+ * @param allocator [in] the Allocator of converter, and of the resulting WBXML Document (NULL for the default one)
+ * @param conv      [out] a reference to the pointer of the new converter
+ * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_create_with_allocator(WBXMLAllocator *allocator, WBXMLConvXML2WBXML **conv)
 {
     if (conv == NULL) {
         return WBXML_ERROR_BAD_PARAMETER;
     }
 
-    *conv = wbxml_malloc(sizeof(WBXMLConvXML2WBXML));
+    *conv = wbxml_mem_malloc(allocator, sizeof(WBXMLConvXML2WBXML));
     if (*conv == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
@@ -224,7 +259,9 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_create(WBXMLConvXML2WBXML **conv)
     (*conv)->wbxml_version     = WBXML_VERSION_13;
     (*conv)->keep_ignorable_ws = FALSE;
     (*conv)->use_strtbl        = TRUE;
+    (*conv)->optimal_strtbl    = FALSE;
     (*conv)->produce_anonymous = FALSE;
+    (*conv)->allocator = allocator;
 
     return WBXML_OK;
 }
@@ -258,6 +295,15 @@ WBXML_DECLARE(void) wbxml_conv_xml2wbxml_disable_string_table(WBXMLConvXML2WBXML
     conv->use_strtbl = FALSE;
 }
 
+/**
+ * @brief Enable optimal string table (default: FALSE/DISABLED).
+ * @param conv     [in] the converter
+ */
+WBXML_DECLARE(void) wbxml_conv_xml2wbxml_enable_optimal_string_table(WBXMLConvXML2WBXML *conv)
+{
+    conv->optimal_strtbl = TRUE;
+}
+
 /**
  * @brief Disable public ID (default: TRUE/ENABLED).
  * @param conv     [in] the converter
@@ -282,44 +328,50 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_run(WBXMLConvXML2WBXML *conv,
                                                    WB_UTINY **wbxml,
                                                    WB_ULONG  *wbxml_len)
 {
-    WBXMLTree *wbxml_tree = NULL;
+    WBXMLEncoder *wbxml_encoder = NULL;
     WBXMLError ret = WBXML_OK;
-    WBXMLGenWBXMLParams params;
 
     /* Check Parameters */
     if ((xml == NULL) || (xml_len == 0) || (wbxml == NULL) || (wbxml_len == NULL))
         return WBXML_ERROR_BAD_PARAMETER;
 
-    /* copy options */
-    params.wbxml_version     = conv->wbxml_version;
-    params.keep_ignorable_ws = conv->keep_ignorable_ws;
-    params.use_strtbl        = conv->use_strtbl;
-    params.produce_anonymous = conv->produce_anonymous;
-
     *wbxml = NULL;
     *wbxml_len = 0;
 
-    /* Parse XML to WBXML Tree */
-    ret = wbxml_tree_from_xml(xml, xml_len, &wbxml_tree);
-    if (ret != WBXML_OK) {
-        WBXML_ERROR((WBXML_CONV, "xml2wbxml conversion failed - Error: %s",
-                                  wbxml_errors_string(ret)));
+    /* Create WBXML Encoder (same options than wbxml_tree_to_wbxml(), and the Allocator of converter) */
+    if ((wbxml_encoder = wbxml_encoder_create_with_allocator(conv->allocator)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-        return ret;
+    /* WBXML Version */
+    wbxml_encoder_set_wbxml_version(wbxml_encoder, conv->wbxml_version);
+
+    /* Keep Ignorable Whitespaces ? */
+    if (!conv->keep_ignorable_ws) {
+        /* Ignores "Empty Text" Nodes */
+        wbxml_encoder_set_ignore_empty_text(wbxml_encoder, TRUE);
+
+        /* Remove leading and trailing whitespaces in "Text Nodes" */
+        wbxml_encoder_set_remove_text_blanks(wbxml_encoder, TRUE);
     }
-    else {
-        /* Convert Tree to WBXML */
-        ret = wbxml_tree_to_wbxml(wbxml_tree, wbxml, wbxml_len, &params);
-        if (ret != WBXML_OK) {
-            WBXML_ERROR((WBXML_CONV, "xml2wbxml conversion failed - WBXML Encoder Error: %s",
-                                     wbxml_errors_string(ret)));
-        }
 
-        /* Clean-up */
-        wbxml_tree_destroy(wbxml_tree);
+    /* String Table */
+    wbxml_encoder_set_use_strtbl(wbxml_encoder, conv->use_strtbl);
+    wbxml_encoder_set_optimal_strtbl(wbxml_encoder, conv->optimal_strtbl);
 
-        return ret;
+    /* Produce an anonymous document? */
+    wbxml_encoder_set_produce_anonymous(wbxml_encoder, conv->produce_anonymous);
+
+    /* Encode XML to WBXML (without String Table, no WBXML Tree is built) */
+    ret = wbxml_encoder_encode_xml_to_wbxml(wbxml_encoder, xml, xml_len, wbxml, wbxml_len);
+    if (ret != WBXML_OK) {
+        WBXML_ERROR((WBXML_CONV, "xml2wbxml conversion failed - Error: %s",
+                                 wbxml_errors_string(ret)));
     }
+
+    /* Clean-up */
+    wbxml_encoder_destroy(wbxml_encoder);
+
+    return ret;
 }
 
 
@@ -329,7 +381,10 @@ WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_run(WBXMLConvXML2WBXML *conv,
  */
 WBXML_DECLARE(void) wbxml_conv_xml2wbxml_destroy(WBXMLConvXML2WBXML *conv)
 {
-    wbxml_free(conv);
+    if (conv == NULL)
+        return;
+
+    wbxml_mem_free(conv->allocator, conv);
 }
 
 /**************************************
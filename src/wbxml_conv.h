@@ -278,6 +278,15 @@ typedef struct WBXMLConvWBXML2XML_s WBXMLConvWBXML2XML;
  */
 WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_create(WBXMLConvWBXML2XML **conv);
 
+/**
+ * @brief Create a new WBXML to XML converter, that allocates with a given Allocator
+ * @param allocator [in] the Allocator of converter, and of the resulting XML Document (NULL for the default one)
+ * @param conv      [out] a reference to the pointer of the new converter
+ * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ * @note The resulting XML Document must be freed with wbxml_mem_free(allocator, ...)
+ */
+WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_create_with_allocator(WBXMLAllocator *allocator, WBXMLConvWBXML2XML **conv);
+
 /**
  * @brief Set the XML generation type (default: WBXML_GEN_XML_INDENT).
  * @param conv     [in] the converter
@@ -325,6 +334,8 @@ WBXML_DECLARE(void) wbxml_conv_wbxml2xml_enable_preserve_whitespaces(WBXMLConvWB
  * @param xml       [out] Resulting XML Document
  * @param xml_len   [out] XML Document length
  * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ * @note The WBXML Document is parsed in place (see wbxml_parser_parse_static()): it is not
+ *       modified, must stay valid until this function returns, and can be released afterwards.
  */
 WBXML_DECLARE(WBXMLError) wbxml_conv_wbxml2xml_run(WBXMLConvWBXML2XML *conv,
                                                    WB_UTINY  *xml,
@@ -352,6 +363,15 @@ typedef struct WBXMLConvXML2WBXML_s WBXMLConvXML2WBXML;
  */
 WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_create(WBXMLConvXML2WBXML **conv);
 
+/**
+ * @brief Create a new XML to WBXML converter, that allocates with a given Allocator
+ * @param allocator [in] the Allocator of converter, and of the resulting WBXML Document (NULL for the default one)
+ * @param conv      [out] a reference to the pointer of the new converter
+ * @return WBXML_OK if conversion succeeded, an Error Code otherwise
+ * @note The resulting WBXML Document must be freed with wbxml_mem_free(allocator, ...)
+ */
+WBXML_DECLARE(WBXMLError) wbxml_conv_xml2wbxml_create_with_allocator(WBXMLAllocator *allocator, WBXMLConvXML2WBXML **conv);
+
 /**
  * @brief Set the WBXML version (default: 1.3).
  * @param conv   [in] the converter
@@ -372,6 +392,14 @@ WBXML_DECLARE(void) wbxml_conv_xml2wbxml_enable_preserve_whitespaces(WBXMLConvXM
  */
 WBXML_DECLARE(void) wbxml_conv_xml2wbxml_disable_string_table(WBXMLConvXML2WBXML *conv);
 
+/**
+ * @brief Enable optimal string table (default: FALSE/DISABLED).
+ *        String table content is chosen by bytes saved: documents are smaller,
+ *        but conversion takes longer (see wbxml_encoder_set_optimal_strtbl()).
+ * @param conv     [in] the converter
+ */
+WBXML_DECLARE(void) wbxml_conv_xml2wbxml_enable_optimal_string_table(WBXMLConvXML2WBXML *conv);
+
 /**
  * @desription: Disable public ID (default: TRUE/ENABLED).
  *              Usually you don't want to produce WBXML documents which are
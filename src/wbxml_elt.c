@@ -40,6 +40,21 @@
 #define WBXML_ELT_UNKNOWN_NAME ((WB_UTINY *)"unknown")
 
 
+/* Private functions prototypes */
+static void *elt_alloc(WBXMLArena *arena, WBXMLAllocator *allocator, WB_ULONG size);
+static WBXMLBuffer *elt_buffer_create(WBXMLArena *arena, WBXMLAllocator *allocator, const WB_UTINY *data, WB_ULONG len);
+static WBXMLTag *elt_tag_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLValueType type);
+static WBXMLTag *elt_tag_create_token(WBXMLArena *arena, WBXMLAllocator *allocator, const WBXMLTagEntry *value);
+static WBXMLTag *elt_tag_create_literal(WBXMLArena *arena, WBXMLAllocator *allocator, WB_UTINY *value);
+static WBXMLTag *elt_tag_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLTag *tag);
+static WBXMLAttributeName *elt_attribute_name_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLValueType type);
+static WBXMLAttributeName *elt_attribute_name_create_token(WBXMLArena *arena, WBXMLAllocator *allocator, const WBXMLAttrEntry *value);
+static WBXMLAttributeName *elt_attribute_name_create_literal(WBXMLArena *arena, WBXMLAllocator *allocator, WB_UTINY *value);
+static WBXMLAttributeName *elt_attribute_name_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLAttributeName *name);
+static WBXMLAttribute *elt_attribute_create(WBXMLArena *arena, WBXMLAllocator *allocator);
+static WBXMLAttribute *elt_attribute_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLAttribute *attr);
+
+
 
 /***************************************************
  *    Public Functions
@@ -49,50 +64,55 @@
 
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create(WBXMLValueType type)
 {
-    WBXMLTag *result = NULL;
-    
-    if ((result = wbxml_malloc(sizeof(WBXMLTag))) == NULL)
-        return NULL;
+    return elt_tag_create(NULL, NULL, type);
+}
 
-    result->type = type;
-    result->u.token = NULL;
-    result->u.literal = NULL;
 
-    return result;
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_in_arena(WBXMLArena *arena, WBXMLValueType type)
+{
+    return elt_tag_create(arena, NULL, type);
+}
+
+
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_with_allocator(WBXMLAllocator *allocator, WBXMLValueType type)
+{
+    return elt_tag_create(NULL, allocator, type);
 }
 
 
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token(const WBXMLTagEntry *value)
 {
-    WBXMLTag *result = NULL;
+    return elt_tag_create_token(NULL, NULL, value);
+}
 
-    if ((result = wbxml_tag_create(WBXML_VALUE_TOKEN)) == NULL)
-        return NULL;
 
-    result->u.token = value;
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token_in_arena(WBXMLArena *arena, const WBXMLTagEntry *value)
+{
+    return elt_tag_create_token(arena, NULL, value);
+}
 
-    return result;
+
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token_with_allocator(WBXMLAllocator *allocator, const WBXMLTagEntry *value)
+{
+    return elt_tag_create_token(NULL, allocator, value);
 }
 
 
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal(WB_UTINY *value)
 {
-    WBXMLTag *result = NULL;
+    return elt_tag_create_literal(NULL, NULL, value);
+}
 
-    if ((result = wbxml_tag_create(WBXML_VALUE_LITERAL)) == NULL)
-        return NULL;
 
-    if (value == NULL)
-        result->u.literal = NULL;
-    else {
-        result->u.literal = wbxml_buffer_create(value, WBXML_STRLEN(value), WBXML_STRLEN(value));
-        if (result->u.literal == NULL) {
-            wbxml_tag_destroy(result);
-            return NULL;
-        }
-    }
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal_in_arena(WBXMLArena *arena, WB_UTINY *value)
+{
+    return elt_tag_create_literal(arena, NULL, value);
+}
 
-    return result;
+
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal_with_allocator(WBXMLAllocator *allocator, WB_UTINY *value)
+{
+    return elt_tag_create_literal(NULL, allocator, value);
 }
 
 
@@ -104,36 +124,25 @@ WBXML_DECLARE(void) wbxml_tag_destroy(WBXMLTag *tag)
     if (tag->type == WBXML_VALUE_LITERAL)
         wbxml_buffer_destroy(tag->u.literal);
 
-    wbxml_free(tag);
+    wbxml_mem_free(tag->allocator, tag);
 }
 
 
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate(WBXMLTag *tag)
 {
-    WBXMLTag *result = NULL;
-
-    if (tag == NULL)
-        return NULL;
+    return elt_tag_duplicate(NULL, NULL, tag);
+}
 
-    if ((result = wbxml_malloc(sizeof(WBXMLTag))) == NULL)
-        return NULL;
 
-    result->type = tag->type;
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate_in_arena(WBXMLArena *arena, WBXMLTag *tag)
+{
+    return elt_tag_duplicate(arena, NULL, tag);
+}
 
-    switch (result->type) {
-    case WBXML_VALUE_TOKEN:
-        result->u.token = tag->u.token;
-        break;
-    case WBXML_VALUE_LITERAL:
-        result->u.literal = wbxml_buffer_duplicate(tag->u.literal);
-        break;
-    default:
-        /* Must Never Happen ! */
-        wbxml_free(result);
-        return NULL;
-    }
 
-    return result;
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLTag *tag)
+{
+    return elt_tag_duplicate(NULL, allocator, tag);
 }
 
 
@@ -158,50 +167,55 @@ WBXML_DECLARE(const WB_UTINY *) wbxml_tag_get_xml_name(WBXMLTag *tag)
 
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create(WBXMLValueType type)
 {
-    WBXMLAttributeName *result = NULL;
-    
-    if ((result = wbxml_malloc(sizeof(WBXMLAttributeName))) == NULL)
-        return NULL;
+    return elt_attribute_name_create(NULL, NULL, type);
+}
 
-    result->type = type;
-    result->u.token = NULL;
-    result->u.literal = NULL;
 
-    return result;
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_in_arena(WBXMLArena *arena, WBXMLValueType type)
+{
+    return elt_attribute_name_create(arena, NULL, type);
+}
+
+
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_with_allocator(WBXMLAllocator *allocator, WBXMLValueType type)
+{
+    return elt_attribute_name_create(NULL, allocator, type);
 }
 
 
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token(const WBXMLAttrEntry *value)
 {
-    WBXMLAttributeName *result = NULL;
+    return elt_attribute_name_create_token(NULL, NULL, value);
+}
 
-    if ((result = wbxml_attribute_name_create(WBXML_VALUE_TOKEN)) == NULL)
-        return NULL;
 
-    result->u.token = value;
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token_in_arena(WBXMLArena *arena, const WBXMLAttrEntry *value)
+{
+    return elt_attribute_name_create_token(arena, NULL, value);
+}
 
-    return result;
+
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token_with_allocator(WBXMLAllocator *allocator, const WBXMLAttrEntry *value)
+{
+    return elt_attribute_name_create_token(NULL, allocator, value);
 }
 
 
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal(WB_UTINY *value)
 {
-    WBXMLAttributeName *result = NULL;
+    return elt_attribute_name_create_literal(NULL, NULL, value);
+}
 
-    if ((result = wbxml_attribute_name_create(WBXML_VALUE_LITERAL)) == NULL)
-        return NULL;
 
-    if (value == NULL)
-        result->u.literal = NULL;
-    else {
-        result->u.literal = wbxml_buffer_create(value, WBXML_STRLEN(value), WBXML_STRLEN(value));
-        if (result->u.literal == NULL) {
-            wbxml_attribute_name_destroy(result);
-            return NULL;
-        }
-    }
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal_in_arena(WBXMLArena *arena, WB_UTINY *value)
+{
+    return elt_attribute_name_create_literal(arena, NULL, value);
+}
 
-    return result;
+
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal_with_allocator(WBXMLAllocator *allocator, WB_UTINY *value)
+{
+    return elt_attribute_name_create_literal(NULL, allocator, value);
 }
 
 
@@ -213,36 +227,25 @@ WBXML_DECLARE(void) wbxml_attribute_name_destroy(WBXMLAttributeName *name)
     if (name->type == WBXML_VALUE_LITERAL)
         wbxml_buffer_destroy(name->u.literal);
 
-    wbxml_free(name);
+    wbxml_mem_free(name->allocator, name);
 }
 
 
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate(WBXMLAttributeName *name)
 {
-    WBXMLAttributeName *result = NULL;
-
-    if (name == NULL)
-        return NULL;
+    return elt_attribute_name_duplicate(NULL, NULL, name);
+}
 
-    if ((result = wbxml_malloc(sizeof(WBXMLAttributeName))) == NULL)
-        return NULL;
 
-    result->type = name->type;
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate_in_arena(WBXMLArena *arena, WBXMLAttributeName *name)
+{
+    return elt_attribute_name_duplicate(arena, NULL, name);
+}
 
-    switch (result->type) {
-    case WBXML_VALUE_TOKEN:
-        result->u.token = name->u.token;
-        break;
-    case WBXML_VALUE_LITERAL:
-        result->u.literal = wbxml_buffer_duplicate(name->u.literal);
-        break;
-    default:
-        /* Must Never Happen ! */
-        wbxml_free(result);
-        return NULL;
-    }
 
-    return result;
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLAttributeName *name)
+{
+    return elt_attribute_name_duplicate(NULL, allocator, name);
 }
 
 
@@ -267,15 +270,19 @@ WBXML_DECLARE(const WB_UTINY *) wbxml_attribute_name_get_xml_name(WBXMLAttribute
 
 WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create(void)
 {
-    WBXMLAttribute *result = NULL;
-    
-    if ((result = wbxml_malloc(sizeof(WBXMLAttribute))) == NULL)
-        return NULL;
+    return elt_attribute_create(NULL, NULL);
+}
 
-    result->name = NULL;
-    result->value = NULL;
 
-    return result;
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create_in_arena(WBXMLArena *arena)
+{
+    return elt_attribute_create(arena, NULL);
+}
+
+
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create_with_allocator(WBXMLAllocator *allocator)
+{
+    return elt_attribute_create(NULL, allocator);
 }
 
 
@@ -287,7 +294,7 @@ WBXML_DECLARE(void) wbxml_attribute_destroy(WBXMLAttribute *attr)
     wbxml_attribute_name_destroy(attr->name);
     wbxml_buffer_destroy(attr->value);     
 
-    wbxml_free(attr);
+    wbxml_mem_free(attr->allocator, attr);
 }
 
 
@@ -299,18 +306,19 @@ WBXML_DECLARE_NONSTD(void) wbxml_attribute_destroy_item(void *attr)
 
 WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate(WBXMLAttribute *attr)
 {
-    WBXMLAttribute *result = NULL;
+    return elt_attribute_duplicate(NULL, NULL, attr);
+}
 
-    if (attr == NULL)
-        return NULL;
 
-    if ((result = wbxml_malloc(sizeof(WBXMLAttribute))) == NULL)
-        return NULL;
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate_in_arena(WBXMLArena *arena, WBXMLAttribute *attr)
+{
+    return elt_attribute_duplicate(arena, NULL, attr);
+}
 
-    result->name = wbxml_attribute_name_duplicate(attr->name);
-    result->value = wbxml_buffer_duplicate(attr->value);
 
-    return result;
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLAttribute *attr)
+{
+    return elt_attribute_duplicate(NULL, allocator, attr);
 }
 
 
@@ -330,3 +338,254 @@ WBXML_DECLARE(const WB_UTINY *) wbxml_attribute_get_xml_value(WBXMLAttribute *at
 
     return wbxml_buffer_get_cstr(attr->value);
 }
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Allocate an Element structure
+ * @param arena     The Arena to allocate from (NULL to use the Allocator)
+ * @param allocator The Allocator to use if there is no Arena (NULL to use the default one)
+ * @param size      The size to allocate
+ * @return The allocated memory, or NULL if not enough memory
+ */
+static void *elt_alloc(WBXMLArena *arena, WBXMLAllocator *allocator, WB_ULONG size)
+{
+    if (arena != NULL)
+        return wbxml_arena_alloc(arena, size);
+
+    return wbxml_mem_malloc(allocator, size);
+}
+
+
+/**
+ * @brief Create the Literal value of an Element
+ * @param arena     The Arena to allocate from (NULL to use the Allocator)
+ * @param allocator The Allocator to use if there is no Arena (NULL to use the default one)
+ * @param data      The Literal value
+ * @param len       The Literal value length
+ * @return The newly created Buffer, or NULL if not enough memory
+ */
+static WBXMLBuffer *elt_buffer_create(WBXMLArena *arena, WBXMLAllocator *allocator, const WB_UTINY *data, WB_ULONG len)
+{
+    if (arena != NULL)
+        return wbxml_buffer_create_in_arena(arena, data, len);
+
+    return wbxml_buffer_create_with_allocator(allocator, data, len, len);
+}
+
+
+/* WBXMLTag */
+
+static WBXMLTag *elt_tag_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLValueType type)
+{
+    WBXMLTag *result = NULL;
+    
+    if ((result = elt_alloc(arena, allocator, sizeof(WBXMLTag))) == NULL)
+        return NULL;
+
+    result->type = type;
+    result->u.token = NULL;
+    result->u.literal = NULL;
+    result->allocator = (arena != NULL) ? wbxml_arena_get_allocator(arena) : allocator;
+
+    return result;
+}
+
+
+static WBXMLTag *elt_tag_create_token(WBXMLArena *arena, WBXMLAllocator *allocator, const WBXMLTagEntry *value)
+{
+    WBXMLTag *result = NULL;
+
+    if ((result = elt_tag_create(arena, allocator, WBXML_VALUE_TOKEN)) == NULL)
+        return NULL;
+
+    result->u.token = value;
+
+    return result;
+}
+
+
+static WBXMLTag *elt_tag_create_literal(WBXMLArena *arena, WBXMLAllocator *allocator, WB_UTINY *value)
+{
+    WBXMLTag *result = NULL;
+
+    if ((result = elt_tag_create(arena, allocator, WBXML_VALUE_LITERAL)) == NULL)
+        return NULL;
+
+    if (value == NULL)
+        result->u.literal = NULL;
+    else {
+        result->u.literal = elt_buffer_create(arena, allocator, value, WBXML_STRLEN(value));
+        if (result->u.literal == NULL) {
+            if (arena == NULL)
+                wbxml_tag_destroy(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+
+static WBXMLTag *elt_tag_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLTag *tag)
+{
+    WBXMLTag *result = NULL;
+
+    if (tag == NULL)
+        return NULL;
+
+    if ((result = elt_tag_create(arena, allocator, tag->type)) == NULL)
+        return NULL;
+
+    switch (result->type) {
+    case WBXML_VALUE_TOKEN:
+        result->u.token = tag->u.token;
+        break;
+    case WBXML_VALUE_LITERAL:
+        if (tag->u.literal == NULL)
+            result->u.literal = NULL;
+        else
+            result->u.literal = elt_buffer_create(arena,
+                                                  allocator,
+                                                  wbxml_buffer_get_cstr(tag->u.literal),
+                                                  wbxml_buffer_len(tag->u.literal));
+        break;
+    default:
+        /* Must Never Happen ! */
+        if (arena == NULL)
+            wbxml_mem_free(allocator, result);
+        return NULL;
+    }
+
+    return result;
+}
+
+
+/* WBXMLAttributeName */
+
+static WBXMLAttributeName *elt_attribute_name_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLValueType type)
+{
+    WBXMLAttributeName *result = NULL;
+    
+    if ((result = elt_alloc(arena, allocator, sizeof(WBXMLAttributeName))) == NULL)
+        return NULL;
+
+    result->type = type;
+    result->u.token = NULL;
+    result->u.literal = NULL;
+    result->allocator = (arena != NULL) ? wbxml_arena_get_allocator(arena) : allocator;
+
+    return result;
+}
+
+
+static WBXMLAttributeName *elt_attribute_name_create_token(WBXMLArena *arena, WBXMLAllocator *allocator, const WBXMLAttrEntry *value)
+{
+    WBXMLAttributeName *result = NULL;
+
+    if ((result = elt_attribute_name_create(arena, allocator, WBXML_VALUE_TOKEN)) == NULL)
+        return NULL;
+
+    result->u.token = value;
+
+    return result;
+}
+
+
+static WBXMLAttributeName *elt_attribute_name_create_literal(WBXMLArena *arena, WBXMLAllocator *allocator, WB_UTINY *value)
+{
+    WBXMLAttributeName *result = NULL;
+
+    if ((result = elt_attribute_name_create(arena, allocator, WBXML_VALUE_LITERAL)) == NULL)
+        return NULL;
+
+    if (value == NULL)
+        result->u.literal = NULL;
+    else {
+        result->u.literal = elt_buffer_create(arena, allocator, value, WBXML_STRLEN(value));
+        if (result->u.literal == NULL) {
+            if (arena == NULL)
+                wbxml_attribute_name_destroy(result);
+            return NULL;
+        }
+    }
+
+    return result;
+}
+
+
+static WBXMLAttributeName *elt_attribute_name_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLAttributeName *name)
+{
+    WBXMLAttributeName *result = NULL;
+
+    if (name == NULL)
+        return NULL;
+
+    if ((result = elt_attribute_name_create(arena, allocator, name->type)) == NULL)
+        return NULL;
+
+    switch (result->type) {
+    case WBXML_VALUE_TOKEN:
+        result->u.token = name->u.token;
+        break;
+    case WBXML_VALUE_LITERAL:
+        if (name->u.literal == NULL)
+            result->u.literal = NULL;
+        else
+            result->u.literal = elt_buffer_create(arena,
+                                                  allocator,
+                                                  wbxml_buffer_get_cstr(name->u.literal),
+                                                  wbxml_buffer_len(name->u.literal));
+        break;
+    default:
+        /* Must Never Happen ! */
+        if (arena == NULL)
+            wbxml_mem_free(allocator, result);
+        return NULL;
+    }
+
+    return result;
+}
+
+
+/* WBXMLAttribute */
+
+static WBXMLAttribute *elt_attribute_create(WBXMLArena *arena, WBXMLAllocator *allocator)
+{
+    WBXMLAttribute *result = NULL;
+    
+    if ((result = elt_alloc(arena, allocator, sizeof(WBXMLAttribute))) == NULL)
+        return NULL;
+
+    result->name = NULL;
+    result->value = NULL;
+    result->allocator = (arena != NULL) ? wbxml_arena_get_allocator(arena) : allocator;
+
+    return result;
+}
+
+
+static WBXMLAttribute *elt_attribute_duplicate(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLAttribute *attr)
+{
+    WBXMLAttribute *result = NULL;
+
+    if (attr == NULL)
+        return NULL;
+
+    if ((result = elt_attribute_create(arena, allocator)) == NULL)
+        return NULL;
+
+    result->name = elt_attribute_name_duplicate(arena, allocator, attr->name);
+    if (attr->value == NULL)
+        result->value = NULL;
+    else
+        result->value = elt_buffer_create(arena,
+                                          allocator,
+                                          wbxml_buffer_get_cstr(attr->value),
+                                          wbxml_buffer_len(attr->value));
+
+    return result;
+}
@@ -64,6 +64,7 @@ typedef struct WBXMLTag_s {
         const WBXMLTagEntry *token;   /**< Token Tag (MUST be const structure, ie from wbxml_tables.c) */
         WBXMLBuffer         *literal; /**< Literal Tag (MUST be dynamically allocated WBXMLBuffer) */
     } u;
+    WBXMLAllocator *allocator; /**< Allocator of this Tag (NULL if default one is used) */
 } WBXMLTag;
 
 
@@ -74,6 +75,7 @@ typedef struct WBXMLAttributeName_s {
         const WBXMLAttrEntry *token;   /**< Token Attribute Name (MUST be const structure, ie from wbxml_tables.c) */
         WBXMLBuffer          *literal; /**< Literal Attribute Name (MUST be dynamically allocated WBXMLBuffer) */
     } u;
+    WBXMLAllocator *allocator; /**< Allocator of this Attribute Name (NULL if default one is used) */
 } WBXMLAttributeName;
 
 
@@ -95,6 +97,7 @@ typedef struct WBXMLAttributeName_s {
 typedef struct WBXMLAttribute_s {
     WBXMLAttributeName *name;  /**< Attribute Name */
     WBXMLBuffer        *value; /**< Full Attribute Value */
+    WBXMLAllocator     *allocator; /**< Allocator of this Attribute (NULL if default one is used) */
 } WBXMLAttribute;
 
 
@@ -111,6 +114,23 @@ typedef struct WBXMLAttribute_s {
  */
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create(WBXMLValueType type);
 
+/**
+ * @brief Create a Tag structure in an Arena
+ * @param arena The Arena where the Tag is allocated (NULL to use malloc)
+ * @param type WBXML Value Type
+ * @return The newly created Tag, or NULL if not enough memory
+ * @note A Tag created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_in_arena(WBXMLArena *arena, WBXMLValueType type);
+
+/**
+ * @brief Create a Tag structure with an Allocator
+ * @param allocator The Allocator of the Tag (NULL to use the default one)
+ * @param type WBXML Value Type
+ * @return The newly created Tag, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_with_allocator(WBXMLAllocator *allocator, WBXMLValueType type);
+
 /**
  * @brief Additional function to create directly a Token Tag structure
  * @param value The WBXMLTagEntry value
@@ -118,6 +138,22 @@ WBXML_DECLARE(WBXMLTag *) wbxml_tag_create(WBXMLValueType type);
  */
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token(const WBXMLTagEntry *value);
 
+/**
+ * @brief Additional function to create directly a Token Tag structure in an Arena
+ * @param arena The Arena where the Tag is allocated (NULL to use malloc)
+ * @param value The WBXMLTagEntry value
+ * @return The newly created Tag, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token_in_arena(WBXMLArena *arena, const WBXMLTagEntry *value);
+
+/**
+ * @brief Additional function to create directly a Token Tag structure with an Allocator
+ * @param allocator The Allocator of the Tag (NULL to use the default one)
+ * @param value The WBXMLTagEntry value
+ * @return The newly created Tag, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token_with_allocator(WBXMLAllocator *allocator, const WBXMLTagEntry *value);
+
 /**
  * @brief Additional function to create directly a Literal Tag structure
  * @param value The Literal value
@@ -125,6 +161,22 @@ WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_token(const WBXMLTagEntry *value);
  */
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal(WB_UTINY *value);
 
+/**
+ * @brief Additional function to create directly a Literal Tag structure in an Arena
+ * @param arena The Arena where the Tag (and its Literal value) is allocated (NULL to use malloc)
+ * @param value The Literal value
+ * @return The newly created Tag, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal_in_arena(WBXMLArena *arena, WB_UTINY *value);
+
+/**
+ * @brief Additional function to create directly a Literal Tag structure with an Allocator
+ * @param allocator The Allocator of the Tag and of its Literal value (NULL to use the default one)
+ * @param value The Literal value
+ * @return The newly created Tag, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_create_literal_with_allocator(WBXMLAllocator *allocator, WB_UTINY *value);
+
 /**
  * @brief Destroy a Tag structure
  * @param tag The Tag structure to destroy
@@ -138,6 +190,23 @@ WBXML_DECLARE(void) wbxml_tag_destroy(WBXMLTag *tag);
  */
 WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate(WBXMLTag *tag);
 
+/**
+ * @brief Duplicate a Tag structure in an Arena
+ * @param arena The Arena where the duplicated Tag is allocated (NULL to use malloc)
+ * @param tag The Tag structure to duplicate
+ * @return The duplicated Tag structure, or NULL if not enough memory
+ * @note A Tag created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate_in_arena(WBXMLArena *arena, WBXMLTag *tag);
+
+/**
+ * @brief Duplicate a Tag structure with an Allocator
+ * @param allocator The Allocator of the duplicated Tag (NULL to use the default one)
+ * @param tag The Tag structure to duplicate
+ * @return The duplicated Tag structure, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLTag *) wbxml_tag_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLTag *tag);
+
 /**
  * @brief Get the XML Name of a WBXML Tag
  * @param tag The WBXML Tag
@@ -155,6 +224,23 @@ WBXML_DECLARE(const WB_UTINY *) wbxml_tag_get_xml_name(WBXMLTag *tag);
  */
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create(WBXMLValueType type);
 
+/**
+ * @brief Create an Attribute Name structure in an Arena
+ * @param arena The Arena where the Attribute Name is allocated (NULL to use malloc)
+ * @param type WBXML Value Type
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ * @note An Attribute Name created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_in_arena(WBXMLArena *arena, WBXMLValueType type);
+
+/**
+ * @brief Create an Attribute Name structure with an Allocator
+ * @param allocator The Allocator of the Attribute Name (NULL to use the default one)
+ * @param type WBXML Value Type
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_with_allocator(WBXMLAllocator *allocator, WBXMLValueType type);
+
 /**
  * @brief Additional function to create directly a Token Attribute Name structure
  * @param value The WBXMLTagEntry value
@@ -162,6 +248,22 @@ WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create(WBXMLValueType t
  */
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token(const WBXMLAttrEntry *value);
 
+/**
+ * @brief Additional function to create directly a Token Attribute Name structure in an Arena
+ * @param arena The Arena where the Attribute Name is allocated (NULL to use malloc)
+ * @param value The WBXMLTagEntry value
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token_in_arena(WBXMLArena *arena, const WBXMLAttrEntry *value);
+
+/**
+ * @brief Additional function to create directly a Token Attribute Name structure with an Allocator
+ * @param allocator The Allocator of the Attribute Name (NULL to use the default one)
+ * @param value The WBXMLTagEntry value
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token_with_allocator(WBXMLAllocator *allocator, const WBXMLAttrEntry *value);
+
 /**
  * @brief Additional function to create directly a Literal Attribute Name structure
  * @param value The Literal value
@@ -169,6 +271,22 @@ WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_token(const WBXM
  */
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal(WB_UTINY *value);
 
+/**
+ * @brief Additional function to create directly a Literal Attribute Name structure in an Arena
+ * @param arena The Arena where the Attribute Name (and its Literal value) is allocated (NULL to use malloc)
+ * @param value The Literal value
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal_in_arena(WBXMLArena *arena, WB_UTINY *value);
+
+/**
+ * @brief Additional function to create directly a Literal Attribute Name structure with an Allocator
+ * @param allocator The Allocator of the Attribute Name and of its Literal value (NULL to use the default one)
+ * @param value The Literal value
+ * @return The newly created Attribute Name, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_create_literal_with_allocator(WBXMLAllocator *allocator, WB_UTINY *value);
+
 /**
  * @brief Destroy an Attribute Name structure
  * @param name The Attribute Name structure to destroy
@@ -182,6 +300,23 @@ WBXML_DECLARE(void) wbxml_attribute_name_destroy(WBXMLAttributeName *name);
  */
 WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate(WBXMLAttributeName *name);
 
+/**
+ * @brief Duplicate a Attribute Name structure in an Arena
+ * @param arena The Arena where the duplicated Attribute Name is allocated (NULL to use malloc)
+ * @param name The Attribute Name structure to duplicate
+ * @return The duplicated Attribute Name structure, or NULL if not enough memory
+ * @note An Attribute Name created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate_in_arena(WBXMLArena *arena, WBXMLAttributeName *name);
+
+/**
+ * @brief Duplicate a Attribute Name structure with an Allocator
+ * @param allocator The Allocator of the duplicated Attribute Name (NULL to use the default one)
+ * @param name The Attribute Name structure to duplicate
+ * @return The duplicated Attribute Name structure, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttributeName *) wbxml_attribute_name_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLAttributeName *name);
+
 /**
  * @brief Get the XML Name of a WBXML Attribute Name
  * @param name The WBXML Attribute Name
@@ -198,6 +333,21 @@ WBXML_DECLARE(const WB_UTINY *) wbxml_attribute_name_get_xml_name(WBXMLAttribute
  */
 WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create(void);
 
+/**
+ * @brief Create an Attribute structure in an Arena
+ * @param arena The Arena where the Attribute is allocated (NULL to use malloc)
+ * @return The newly created Attribute, or NULL if not enough memory
+ * @note An Attribute created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create_in_arena(WBXMLArena *arena);
+
+/**
+ * @brief Create an Attribute structure with an Allocator
+ * @param allocator The Allocator of the Attribute (NULL to use the default one)
+ * @return The newly created Attribute, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_create_with_allocator(WBXMLAllocator *allocator);
+
 /**
  * @brief Destroy an Attribute structure
  * @param attr The Attribute structure to destroy
@@ -217,6 +367,23 @@ WBXML_DECLARE_NONSTD(void) wbxml_attribute_destroy_item(void *attr);
  */
 WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate(WBXMLAttribute *attr);
 
+/**
+ * @brief Duplicate an Attribute structure in an Arena
+ * @param arena The Arena where the duplicated Attribute is allocated (NULL to use malloc)
+ * @param attr The Attribute structure to duplicate
+ * @return The duplicated Attribute, or NULL if not enough memory
+ * @note An Attribute created in an Arena must not be destroyed: it is released with the Arena
+ */
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate_in_arena(WBXMLArena *arena, WBXMLAttribute *attr);
+
+/**
+ * @brief Duplicate an Attribute structure with an Allocator
+ * @param allocator The Allocator of the duplicated Attribute (NULL to use the default one)
+ * @param attr The Attribute structure to duplicate
+ * @return The duplicated Attribute, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLAttribute *) wbxml_attribute_duplicate_with_allocator(WBXMLAllocator *allocator, WBXMLAttribute *attr);
+
 /**
  * @brief Get the XML Attribute Name of a WBXML Attribute
  * @param attr The WBXML Attribute
@@ -53,11 +53,23 @@
 
 #include <ctype.h> /* For isdigit() */
 
+#include "wbxml_config_internals.h"
 #include "wbxml_encoder.h"
+#include "wbxml_parser.h"
+#include "wbxml_tree_clb_xml.h"
 #include "wbxml_log.h"
 #include "wbxml_internals.h"
 #include "wbxml_base64.h"
 
+/* Text to escape is searched with SIMD instructions, when the compiler targets them */
+#if defined( __GNUC__ ) && defined( __SSE2__ )
+#define WBXML_ENCODER_XML_SSE2
+#include <emmintrin.h>
+#elif defined( __aarch64__ ) && defined( __ARM_NEON )
+#define WBXML_ENCODER_XML_NEON
+#include <arm_neon.h>
+#endif /* __GNUC__ && __SSE2__ */
+
 
 /**
  * Compilation Flag: WBXML_ENCODER_USE_STRTBL
@@ -80,6 +92,19 @@
 #define WBXML_ENCODER_XML_HEADER_MALLOC_BLOCK 250
 #define WBXML_ENCODER_WBXML_HEADER_MALLOC_BLOCK WBXML_HEADER_MAX_LEN
 
+/* Elements stack, and Text buffer, of XML encoding while parsing WBXML */
+#define WBXML_ENCODER_XML_ELTS_MALLOC_BLOCK 16
+#define WBXML_ENCODER_XML_TEXT_MALLOC_BLOCK 256
+
+/* XML document is given by chunks to Expat, while encoding to WBXML (so that Expat does not copy it all) */
+#define WBXML_ENCODER_XML_PARSE_CHUNK 65536
+
+/* Output length from which the output is given to the Write Handler */
+#define WBXML_ENCODER_WRITE_BLOCK 4096
+
+/* Position of a Slot not found yet */
+#define WBXML_ENCODER_NO_SLOT 0xFFFFFFFF
+
 /* WBXML Default Charset: UTF-8 (106) */
 #define WBXML_ENCODER_DEFAULT_CHARSET 0x6a
 
@@ -156,10 +181,16 @@ struct WBXMLEncoder_s {
     WB_BOOL in_content;                     /**< We are in Content Text (used for indentation when generating XML output) */
     WB_BOOL in_cdata;                       /**< We are in a CDATA section (and so, content must be generaed "as is") */
     WBXMLBuffer *cdata;                     /**< Current CDATA Buffer */
+    WBXMLMatcher *attr_value_matcher;       /**< Attribute Values Matcher of a Language Table that is not part of Main Table */
+    const WBXMLLangEntry *attr_value_matcher_lang; /**< Language Table of 'attr_value_matcher' */
 #if defined( WBXML_ENCODER_USE_STRTBL )
     WBXMLList *strstbl;                     /**< String Table we are creating */
+    struct WBXMLStrtblIndex_s *strstbl_index; /**< Hash index of String Table content */
+    WBXMLMatcher *strstbl_matcher;          /**< Matcher of String Table content (NULL if it must be rebuilt) */
     WB_ULONG strstbl_len;                   /**< String Table Length */
     WB_BOOL use_strtbl;                     /**< Do we use String Table when generating WBXML output ? (default: YES) */
+    WB_BOOL optimal_strtbl;                 /**< Do we choose String Table content by bytes saved ? (default: NO) */
+    WBXMLBuffer *strstbl_text;              /**< If not NULL, inline Strings are collected there (cf wbxml_strtbl_optimize()) */
 #endif /* WBXML_ENCODER_USE_STRTBL */
     WB_BOOL xml_encode_header;              /**< Do we generate XML Header ? */
     WB_BOOL produce_anonymous;              /**< Do we produce anonymous documents? (default: NO) */
@@ -168,6 +199,15 @@ struct WBXMLEncoder_s {
     WB_BOOL flow_mode;                      /**< Is Flow Mode encoding activated ? */
     WB_ULONG pre_last_node_len;             /**< Output buffer length before last node encoding */
     WB_BOOL textual_publicid;               /**< Generate textual Public ID instead of token (when generating WBXML output) */
+    WB_BOOL header_in_output;               /**< Is the header already at the start of output ? (built before the body) */
+    WB_ULONG strtbl_pos;                    /**< Position of String Table in header (when generating WBXML output) */
+    WB_ULONG body_pos;                      /**< Position of body in output (0, unless header is in output) */
+    WBXMLEncoderWriteHandler write_handler; /**< Write Handler the output is given to (NULL if output is kept) */
+    void *write_ctx;                        /**< User data of Write Handler */
+    WBXMLTreeNode **slots;                  /**< Text Nodes that are not encoded (Slots of a Template) */
+    WB_ULONG nb_slots;                      /**< Number of Slots */
+    WB_ULONG *slots_pos;                    /**< Position of each Slot in output (NULL if not kept) */
+    WBXMLAllocator *allocator;              /**< Allocator of this Encoder (NULL if default one is used) */
 };
 
 #if defined( WBXML_ENCODER_USE_STRTBL )
@@ -179,7 +219,61 @@ typedef struct WBXMLStringTableElement_t {
     WB_ULONG offset;     /**< Offset of String in String Table */
     WB_ULONG count;      /**< Number of times this String is referenced in the XML Document */
     WB_BOOL stat;        /**< If set to TRUE, this is a static String that we must not destroy in wbxml_strtbl_element_destroy() function */
+    WB_BOOL shared;      /**< If set to TRUE, this String is the end of another one: it is not stored on its own, and 'offset' is given */
+    WBXMLAllocator *allocator; /**< Allocator of this element (the one of the Encoder) */
 } WBXMLStringTableElement;
+
+/**
+ * @brief Hash index of String Table Elements, keyed on String content
+ * @note Open addressing with linear probing. The index does not own the elements.
+ */
+typedef struct WBXMLStrtblIndex_s {
+    WBXMLStringTableElement **slots; /**< Hash slots (NULL if empty) */
+    WB_ULONG size;                   /**< Number of slots (always a power of 2) */
+    WB_ULONG count;                  /**< Number of used slots */
+    WBXMLAllocator *allocator;       /**< Allocator of this index (the one of the Encoder) */
+} WBXMLStrtblIndex;
+
+/**
+ * @brief A String found more than once in collected Strings: an interval of their Suffix Array
+ */
+typedef struct WBXMLStrtblCandidate_s {
+    WB_ULONG lb;  /**< First suffix of this interval */
+    WB_ULONG rb;  /**< Last suffix of this interval */
+    WB_ULONG len; /**< Length of the prefix shared by suffixes of this interval (the String) */
+} WBXMLStrtblCandidate;
+
+/**
+ * @brief A candidate in the heap of wbxml_strtbl_optimize()
+ */
+typedef struct WBXMLStrtblHeapItem_s {
+    WB_LONG score;      /**< Bytes saved (an upper bound, until it is computed again) */
+    WB_ULONG candidate; /**< Index of candidate */
+} WBXMLStrtblHeapItem;
+
+/**
+ * @brief A String chosen by wbxml_strtbl_optimize()
+ */
+typedef struct WBXMLStrtblChoice_s {
+    const WB_UTINY *data; /**< String (in collected Strings) */
+    WB_ULONG len;         /**< String length */
+    WB_ULONG host;        /**< Index of the chosen String it is stored in (itself if stored on its own) */
+    WB_ULONG offset;      /**< Offset in String Table */
+} WBXMLStrtblChoice;
+
+/**
+ * @brief State of wbxml_strtbl_optimize()
+ */
+typedef struct WBXMLStrtblOptimizer_s {
+    const WB_UTINY *text;       /**< Collected Strings, each one followed by a NULL char */
+    WB_ULONG len;               /**< Text length */
+    WB_ULONG *sa;               /**< Suffix Array of text */
+    WB_UTINY *covered;          /**< Text already referenced by a chosen String (and NULL chars) */
+    WB_ULONG *positions;        /**< Occurrences of a candidate (scratch) */
+    WBXMLStrtblChoice *choices; /**< Chosen Strings, in the order they were chosen */
+    WB_ULONG nb_choices;        /**< Number of chosen Strings */
+    WB_ULONG table_len;         /**< Length of String Table with chosen Strings */
+} WBXMLStrtblOptimizer;
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
 /**
@@ -217,8 +311,67 @@ typedef struct WBXMLValueElement_t {
         WB_ULONG    index;                  /**< WBXML_VALUE_ELEMENT_TABLEREF */
 #endif /* WBXML_ENCODER_USE_STRTBL */
     } u;
+    WBXMLAllocator *allocator;      /**< Allocator of this element (the one of the Encoder) */
 } WBXMLValueElement;
 
+/**
+ * @brief An Element encoded to XML while the WBXML document is parsed
+ */
+typedef struct WBXMLEncoderXMLElt_s {
+    WBXMLTag *tag;          /**< Element Tag (it belongs to the WBXML Parser, until the Element end) */
+    WB_BOOL open;           /**< Is the Start Tag still open ? (nothing known about content yet) */
+    WB_BOOL indented;       /**< Is the content indented ? (cf xml_indent_content()) */
+    WB_ULONG content_pos;   /**< Position of content in output (if it starts with a Text) */
+#if defined( WBXML_SUPPORT_SYNCML )
+    WB_BOOL has_meta;       /**< Has a <Meta> child been parsed ? */
+#endif /* WBXML_SUPPORT_SYNCML */
+} WBXMLEncoderXMLElt;
+
+/**
+ * @brief Context of XML encoding while the WBXML document is parsed (WBXML Parser user data)
+ */
+typedef struct WBXMLEncoderXMLCtx_s {
+    WBXMLEncoder *encoder;      /**< The WBXML Encoder */
+    WBXMLParser *parser;        /**< The WBXML Parser */
+    WBXMLEncoderXMLElt *elts;   /**< Stack of open Elements */
+    WB_ULONG depth;             /**< Number of open Elements */
+    WB_ULONG size;              /**< Size of Elements stack */
+    WBXMLBuffer *text;          /**< Text of current Element, not encoded yet */
+    WB_BOOL in_text;            /**< Is there a Text not encoded yet ? (it can be empty once stripped) */
+    WB_BOOL use_tree;           /**< Must the document be encoded from a WBXML Tree ? */
+    WBXMLError error;           /**< Encoding Error */
+} WBXMLEncoderXMLCtx;
+
+#if defined( HAVE_EXPAT )
+
+/**
+ * @brief An Element encoded to WBXML while the XML document is parsed
+ */
+typedef struct WBXMLEncoderWBXMLElt_s {
+    WBXMLTreeNode *node;    /**< Element Node (its content is kept until it is encoded) */
+    WB_ULONG tag_pos;       /**< Position of Tag token in output (its content flag is set once content is found) */
+    WB_BOOL has_content;    /**< Has the Element a content ? */
+#if defined( WBXML_SUPPORT_SYNCML )
+    WB_BOOL has_meta;       /**< Has a <Meta> child been parsed ? */
+#endif /* WBXML_SUPPORT_SYNCML */
+} WBXMLEncoderWBXMLElt;
+
+/**
+ * @brief Context of WBXML encoding while the XML document is parsed (Expat user data)
+ * @note The WBXML Tree only keeps the open Elements, and the content not encoded yet
+ */
+typedef struct WBXMLEncoderWBXMLCtx_s {
+    WBXMLTreeClbCtx tree_ctx;   /**< WBXML Tree building context (MUST be first: it is given as is to wbxml_tree_clb_xml_*()) */
+    WBXMLEncoder *encoder;      /**< The WBXML Encoder */
+    WBXMLEncoderWBXMLElt *elts; /**< Stack of open Elements */
+    WB_ULONG depth;             /**< Number of open Elements */
+    WB_ULONG size;              /**< Size of Elements stack */
+    WB_BOOL use_tree;           /**< Must the document be encoded from a WBXML Tree ? */
+    WBXMLError error;           /**< Encoding Error */
+} WBXMLEncoderWBXMLCtx;
+
+#endif /* HAVE_EXPAT */
+
 
 /***************************************************
  *    Private Functions prototypes
@@ -234,7 +387,15 @@ static WB_BOOL convert_char_to_ucs4(WB_UTINY ch, WB_ULONG *result);
 
 static WBXMLEncoder *encoder_duplicate(WBXMLEncoder *encoder);
 static WBXMLError encoder_encode_tree(WBXMLEncoder *encoder);
+#if defined( WBXML_ENCODER_USE_STRTBL )
+static void encoder_choose_strtbl(WBXMLEncoder *encoder);
+#endif /* WBXML_ENCODER_USE_STRTBL */
 static WB_BOOL encoder_init_output(WBXMLEncoder *encoder);
+static WBXMLError encoder_build_header(WBXMLEncoder *encoder);
+static WBXMLError encoder_output_header_first(WBXMLEncoder *encoder);
+static WBXMLError encoder_take_output(WBXMLEncoder *encoder, WB_UTINY **result, WB_ULONG *result_len);
+static WBXMLError encoder_write_output(WBXMLEncoder *encoder);
+static WB_BOOL encoder_find_slot(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_ULONG *index);
 
 
 /*******************************
@@ -269,6 +430,8 @@ static WBXMLError wbxml_encode_tag_token(WBXMLEncoder *encoder, WB_UTINY token,
 static WBXMLError wbxml_encode_attr(WBXMLEncoder *encoder, WBXMLAttribute *attribute);
 static WBXMLError wbxml_encode_attr_start(WBXMLEncoder *encoder, WBXMLAttribute *attribute, WB_UTINY **value);
 static WBXMLError wbxml_encode_value_element_buffer(WBXMLEncoder *encoder, WB_UTINY *value, WBXMLValueElementCtx ctx);
+static WBXMLError wbxml_encode_value_element_matches(WBXMLEncoder *encoder, WBXMLList *lresult, const WB_UTINY *buffer, WB_ULONG len, WBXMLMatchSet *set, WB_ULONG attr_count);
+static const WBXMLMatcher *wbxml_encoder_get_attr_value_matcher(WBXMLEncoder *encoder);
 static WBXMLError wbxml_encode_value_element_list(WBXMLEncoder *encoder, WBXMLList *list);
 static WBXMLError wbxml_encode_attr_start_literal(WBXMLEncoder *encoder, const WB_UTINY *attr);
 static WBXMLError wbxml_encode_attr_token(WBXMLEncoder *encoder, WB_UTINY token, WB_UTINY page);
@@ -284,7 +447,7 @@ static WBXMLError wbxml_encode_opaque_data(WBXMLEncoder *encoder, WB_UTINY *data
 static WBXMLError wbxml_encode_tableref(WBXMLEncoder *encoder, WB_ULONG offset);
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
-static WBXMLValueElement *wbxml_value_element_create(void);
+static WBXMLValueElement *wbxml_value_element_create(WBXMLAllocator *allocator);
 static void wbxml_value_element_destroy(WBXMLValueElement *elt);
 static void wbxml_value_element_destroy_item(void *elt);
 
@@ -310,7 +473,7 @@ static WBXMLError wbxml_encode_ota_nokia_icon(WBXMLEncoder *encoder, WB_UTINY *b
 
 #if defined( WBXML_ENCODER_USE_STRTBL )
 /* WBXML String Table Functions */
-static WBXMLStringTableElement *wbxml_strtbl_element_create(WBXMLBuffer *string, WB_BOOL is_stat);
+static WBXMLStringTableElement *wbxml_strtbl_element_create(WBXMLAllocator *allocator, WBXMLBuffer *string, WB_BOOL is_stat);
 static void wbxml_strtbl_element_destroy(WBXMLStringTableElement *element);
 static void wbxml_strtbl_element_destroy_item(void *element);
 
@@ -320,6 +483,26 @@ static WBXMLError wbxml_strtbl_collect_words(WBXMLList *elements, WBXMLList **re
 static WBXMLError wbxml_strtbl_construct(WBXMLBuffer *buff, WBXMLList *strstbl);
 static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList **strings, WBXMLList **one_ref, WB_BOOL stat_buff);
 static WB_BOOL wbxml_strtbl_add_element(WBXMLEncoder *encoder, WBXMLStringTableElement *elt, WB_ULONG *index, WB_BOOL *added);
+
+static WBXMLStrtblIndex *wbxml_strtbl_index_create(WBXMLAllocator *allocator);
+static void wbxml_strtbl_index_destroy(WBXMLStrtblIndex *hindex);
+static WBXMLStringTableElement *wbxml_strtbl_index_get(WBXMLStrtblIndex *hindex, WBXMLBuffer *string);
+static WB_BOOL wbxml_strtbl_index_grow(WBXMLStrtblIndex *hindex);
+static WB_BOOL wbxml_strtbl_index_add(WBXMLStrtblIndex *hindex, WBXMLStringTableElement *elt);
+
+static const WBXMLMatcher *wbxml_strtbl_get_matcher(WBXMLEncoder *encoder);
+
+static WBXMLError wbxml_strtbl_optimize(WBXMLEncoder *encoder, WBXMLTreeNode *root);
+static WBXMLError wbxml_strtbl_collect_inline_strings(WBXMLEncoder *encoder, WBXMLTreeNode *root, WBXMLBuffer *text);
+static WB_BOOL wbxml_strtbl_suffix_array(WBXMLAllocator *allocator, const WB_UTINY *text, WB_ULONG len, WB_ULONG *sa, WB_ULONG *rank);
+static void wbxml_strtbl_lcp(const WB_UTINY *text, WB_ULONG len, const WB_ULONG *sa, const WB_ULONG *rank, WB_ULONG *lcp);
+static WBXMLStrtblCandidate *wbxml_strtbl_candidates(WBXMLAllocator *allocator, const WB_ULONG *lcp, WB_ULONG len, WB_ULONG *nb);
+static WB_LONG wbxml_strtbl_opt_references(WBXMLStrtblOptimizer *opt, const WBXMLStrtblCandidate *cand, WB_ULONG index_len, WB_BOOL apply);
+static WB_ULONG wbxml_strtbl_opt_storage(WBXMLStrtblOptimizer *opt, const WB_UTINY *data, WB_ULONG len, WB_ULONG *host, WB_ULONG *absorbed);
+static WB_BOOL wbxml_strtbl_opt_is_run(const WB_UTINY *data, WB_ULONG len);
+static void wbxml_strtbl_heap_push(WBXMLStrtblHeapItem *heap, WB_ULONG *nb, WB_LONG score, WB_ULONG candidate);
+static void wbxml_strtbl_heap_pop(WBXMLStrtblHeapItem *heap, WB_ULONG *nb, WBXMLStrtblHeapItem *top);
+static WB_ULONG wbxml_strtbl_mb_uint_32_len(WB_ULONG value);
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
 
@@ -349,19 +532,37 @@ const WB_UTINY xml_slashr[6] = "&#13;";  /**< &#13; */
 const WB_UTINY xml_slashn[6] = "&#10;";  /**< &#10; */
 const WB_UTINY xml_tab[5]    = "&#9;";   /**< &#9; */
 
+/** Number of text chars escaped at a time (the result is written straight into output) */
+#define WBXML_ENCODER_XML_ESCAPE_CHUNK 4096
+
+/** Chars escaped in XML text: always (1), or only in canonical XML (2) */
+static const WB_UTINY xml_escaped_chars[256] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 0, 0, 2, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 1, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 1, 0
+};
+
 /* Build XML Result */
 static WBXMLError xml_build_result(WBXMLEncoder *encoder, WB_UTINY **xml, WB_ULONG *xml_len);
 static WBXMLError xml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header);
 
 /* XML Encoding Functions */
-static WBXMLError xml_encode_tag(WBXMLEncoder *encoer, WBXMLTreeNode *node);
-static WBXMLError xml_encode_end_tag(WBXMLEncoder *encoder, WBXMLTreeNode *node);
+static WB_BOOL xml_tag_switch_page(WBXMLTag *parent, WBXMLTag *tag);
+static WB_BOOL xml_node_switch_page(WBXMLTreeNode *node);
+static WB_BOOL xml_indent_content(WBXMLEncoder *encoder, WB_BOOL has_child_elt);
+static WB_BOOL xml_node_indent_content(WBXMLEncoder *encoder, WBXMLTreeNode *node);
+
+static WBXMLError xml_encode_tag(WBXMLEncoder *encoer, WBXMLTag *name, WB_BOOL switch_page);
+static WBXMLError xml_encode_end_tag(WBXMLEncoder *encoder, WBXMLTag *name, WB_BOOL indent_content);
 
 static WBXMLError xml_encode_attr(WBXMLEncoder *encoder, WBXMLAttribute *attribute);
-static WBXMLError xml_encode_end_attrs(WBXMLEncoder *encoder, WBXMLTreeNode *node);
+static WBXMLError xml_encode_end_attrs(WBXMLEncoder *encoder, WB_BOOL has_content, WB_BOOL indent_content);
 
-static WBXMLError xml_encode_text(WBXMLEncoder *encoder, WBXMLTreeNode *node);
-static WBXMLError xml_encode_text_entities(WBXMLEncoder *encoder, WBXMLBuffer *buff);
+static WBXMLError xml_encode_text(WBXMLEncoder *encoder, WBXMLBuffer *str, WB_BOOL indent);
+static WBXMLError xml_encode_text_entities(WBXMLEncoder *encoder, const WB_UTINY *data, WB_ULONG len);
+static WB_ULONG xml_text_plain_len(const WB_UTINY *data, WB_ULONG len, WB_BOOL normalize);
 static WB_BOOL xml_encode_new_line(WBXMLBuffer *buff);
 
 static WBXMLError xml_encode_cdata(WBXMLEncoder *encoder);
@@ -369,26 +570,63 @@ static WBXMLError xml_encode_end_cdata(WBXMLEncoder *encoder);
 
 static WBXMLError xml_encode_tree(WBXMLEncoder *encoder, WBXMLTree *tree);
 
+/* XML Encoding while parsing WBXML (WBXML Parser callbacks) */
+static void xml_clb_start_document(void *ctx, WBXMLCharsetMIBEnum charset, const WBXMLLangEntry *lang);
+static void xml_clb_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **attrs);
+static void xml_clb_end_element(void *ctx, WBXMLTag *element);
+static void xml_clb_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length);
+
+static WBXMLError xml_clb_encode_text(WBXMLEncoderXMLCtx *xml_ctx);
+#if defined( WBXML_SUPPORT_SYNCML )
+static WB_BOOL xml_clb_need_tree(WBXMLEncoderXMLCtx *xml_ctx);
+#endif /* WBXML_SUPPORT_SYNCML */
+
+#if defined( HAVE_EXPAT )
+/* WBXML Encoding while parsing XML (Expat callbacks) */
+static void wbxml_clb_start_element(void *ctx, const XML_Char *localName, const XML_Char **attrs);
+static void wbxml_clb_end_element(void *ctx, const XML_Char *localName);
+static void wbxml_clb_characters(void *ctx, const XML_Char *ch, int len);
+
+static void wbxml_clb_start_document(WBXMLEncoderWBXMLCtx *wbxml_ctx);
+static void wbxml_clb_set_content(WBXMLEncoderWBXMLCtx *wbxml_ctx, WBXMLEncoderWBXMLElt *elt);
+static void wbxml_clb_encode_content(WBXMLEncoderWBXMLCtx *wbxml_ctx, WBXMLEncoderWBXMLElt *elt);
+#if defined( WBXML_SUPPORT_SYNCML )
+static WB_BOOL wbxml_clb_need_tree(WBXMLEncoderWBXMLCtx *wbxml_ctx);
+#endif /* WBXML_SUPPORT_SYNCML */
+#endif /* HAVE_EXPAT */
+
 
 /***************************************************
  *    Public Functions
  */
 
 WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_real(void)
+{
+    return wbxml_encoder_create_with_allocator_real(NULL);
+}
+
+
+WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_with_allocator_real(WBXMLAllocator *allocator)
 {
     WBXMLEncoder *encoder = NULL;
 
-    encoder = wbxml_malloc(sizeof(WBXMLEncoder));
+    encoder = wbxml_mem_malloc(allocator, sizeof(WBXMLEncoder));
     if (encoder == NULL) {
         return NULL;
     }
 
+    encoder->allocator = allocator;
+
 #if defined( WBXML_ENCODER_USE_STRTBL )
-    if ((encoder->strstbl = wbxml_list_create()) == NULL) {
-        wbxml_free(encoder);
+    if ((encoder->strstbl = wbxml_list_create_with_allocator(allocator)) == NULL) {
+        wbxml_mem_free(allocator, encoder);
         return NULL;
     }
+    encoder->strstbl_index = NULL;
+    encoder->strstbl_matcher = NULL;
     encoder->use_strtbl = TRUE;
+    encoder->optimal_strtbl = FALSE;
+    encoder->strstbl_text = NULL;
     encoder->strstbl_len = 0;
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
@@ -417,6 +655,9 @@ WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_real(void)
     encoder->in_cdata = FALSE;
     encoder->cdata = NULL;
 
+    encoder->attr_value_matcher = NULL;
+    encoder->attr_value_matcher_lang = NULL;
+
     encoder->xml_encode_header = TRUE;
     encoder->produce_anonymous = FALSE;
 
@@ -433,6 +674,16 @@ WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_real(void)
     encoder->pre_last_node_len = 0;
     encoder->textual_publicid = FALSE;
 
+    encoder->header_in_output = FALSE;
+    encoder->strtbl_pos = 0;
+    encoder->body_pos = 0;
+    encoder->write_handler = NULL;
+    encoder->write_ctx = NULL;
+
+    encoder->slots = NULL;
+    encoder->nb_slots = 0;
+    encoder->slots_pos = NULL;
+
     return encoder;
 }
 
@@ -445,12 +696,15 @@ WBXML_DECLARE(void) wbxml_encoder_destroy(WBXMLEncoder *encoder)
     wbxml_buffer_destroy(encoder->output);
     wbxml_buffer_destroy(encoder->output_header);
     wbxml_buffer_destroy(encoder->cdata);
+    wbxml_matcher_destroy(encoder->attr_value_matcher);
 
 #if defined( WBXML_ENCODER_USE_STRTBL )
     wbxml_list_destroy(encoder->strstbl, wbxml_strtbl_element_destroy_item);
+    wbxml_strtbl_index_destroy(encoder->strstbl_index);
+    wbxml_matcher_destroy(encoder->strstbl_matcher);
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
-    wbxml_free(encoder);
+    wbxml_mem_free(encoder->allocator, encoder);
 }
 
 
@@ -482,9 +736,19 @@ WBXML_DECLARE(void) wbxml_encoder_reset(WBXMLEncoder *encoder)
     
     encoder->pre_last_node_len = 0;
 
+    encoder->header_in_output = FALSE;
+    encoder->strtbl_pos = 0;
+    encoder->body_pos = 0;
+    encoder->write_handler = NULL;
+    encoder->write_ctx = NULL;
+
 #if defined( WBXML_ENCODER_USE_STRTBL )
     wbxml_list_destroy(encoder->strstbl, wbxml_strtbl_element_destroy_item);
     encoder->strstbl = NULL;
+    wbxml_strtbl_index_destroy(encoder->strstbl_index);
+    encoder->strstbl_index = NULL;
+    wbxml_matcher_destroy(encoder->strstbl_matcher);
+    encoder->strstbl_matcher = NULL;
     encoder->strstbl_len = 0;
 #endif /* WBXML_ENCODER_USE_STRTBL */
 }
@@ -529,6 +793,17 @@ WBXML_DECLARE(void) wbxml_encoder_set_use_strtbl(WBXMLEncoder *encoder, WB_BOOL
 }
 
 
+WBXML_DECLARE(void) wbxml_encoder_set_optimal_strtbl(WBXMLEncoder *encoder, WB_BOOL optimal)
+{
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    if (encoder == NULL)
+        return;
+
+    encoder->optimal_strtbl = optimal;
+#endif /* WBXML_ENCODER_USE_STRTBL */
+}
+
+
 WBXML_DECLARE(void) wbxml_encoder_set_produce_anonymous(WBXMLEncoder *encoder, WB_BOOL set_anonymous)
 {
     if (encoder == NULL)
@@ -595,7 +870,61 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_wbxml(WBXMLEncoder *encod
         return ret;
 
     /* Get result */
-    return wbxml_encoder_get_output(encoder, wbxml, wbxml_len);
+    return encoder_take_output(encoder, wbxml, wbxml_len);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_with_slots(WBXMLEncoder *encoder,
+                                                                WBXMLTreeNode **slots,
+                                                                WB_ULONG nb_slots,
+                                                                WB_ULONG *slots_pos,
+                                                                WB_UTINY **wbxml,
+                                                                WB_ULONG *wbxml_len)
+{
+    WB_ULONG body_len = 0, i = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if ((encoder == NULL) || encoder->flow_mode || ((nb_slots > 0) && ((slots == NULL) || (slots_pos == NULL))) ||
+        (wbxml == NULL) || (wbxml_len == NULL))
+    {
+        return WBXML_ERROR_BAD_PARAMETER;
+    }
+
+    for (i = 0; i < nb_slots; i++)
+        slots_pos[i] = WBXML_ENCODER_NO_SLOT;
+
+    encoder->slots = slots;
+    encoder->nb_slots = nb_slots;
+    encoder->slots_pos = slots_pos;
+
+    *wbxml = NULL;
+    *wbxml_len = 0;
+
+    wbxml_encoder_set_output_type(encoder, WBXML_ENCODER_OUTPUT_WBXML);
+
+    if ((ret = encoder_encode_tree(encoder)) == WBXML_OK) {
+        /* Positions are in output: the header may still have to be put before it */
+        body_len = wbxml_buffer_len(encoder->output);
+        ret = encoder_take_output(encoder, wbxml, wbxml_len);
+    }
+
+    for (i = 0; (ret == WBXML_OK) && (i < nb_slots); i++) {
+        if (slots_pos[i] == WBXML_ENCODER_NO_SLOT) {
+            /* This Text Node is not in Tree (or is not encoded) */
+            wbxml_mem_free(encoder->allocator, *wbxml);
+            *wbxml = NULL;
+            *wbxml_len = 0;
+            ret = WBXML_ERROR_BAD_PARAMETER;
+        }
+        else
+            slots_pos[i] += *wbxml_len - body_len;
+    }
+
+    encoder->slots = NULL;
+    encoder->nb_slots = 0;
+    encoder->slots_pos = NULL;
+
+    return ret;
 }
 
 
@@ -619,7 +948,319 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_xml(WBXMLEncoder *encoder
         return ret;
 
     /* Get result */
-    return wbxml_encoder_get_output(encoder, xml, xml_len);
+    return encoder_take_output(encoder, xml, xml_len);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_handler(WBXMLEncoder *encoder,
+                                                               WBXMLEncoderOutputType output_type,
+                                                               WBXMLEncoderWriteHandler handler,
+                                                               void *ctx)
+{
+    WBXMLEncoderOutputPart parts[WBXML_ENCODER_OUTPUT_PARTS];
+    WBXMLError ret = WBXML_OK;
+    WB_ULONG i = 0;
+
+    /* Check Parameters */
+    if ((encoder == NULL) || (handler == NULL) || encoder->flow_mode)
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    wbxml_encoder_set_output_type(encoder, output_type);
+
+    encoder->write_handler = handler;
+    encoder->write_ctx = ctx;
+
+    /* Encode (output is written while encoding, if header is already in output) */
+    if ((ret = encoder_encode_tree(encoder)) == WBXML_OK) {
+        /* Write the rest of document */
+        if ((ret = wbxml_encoder_get_output_parts(encoder, parts)) == WBXML_OK) {
+            for (i = 0; i < WBXML_ENCODER_OUTPUT_PARTS; i++) {
+                if ((parts[i].len > 0) && ((ret = handler(ctx, parts[i].data, parts[i].len)) != WBXML_OK))
+                    break;
+            }
+        }
+    }
+
+    encoder->write_handler = NULL;
+    encoder->write_ctx = NULL;
+
+    /* Nothing is kept */
+    wbxml_buffer_destroy(encoder->output);
+    encoder->output = NULL;
+
+    wbxml_buffer_destroy(encoder->output_header);
+    encoder->output_header = NULL;
+
+    encoder->header_in_output = FALSE;
+    encoder->strtbl_pos = 0;
+    encoder->body_pos = 0;
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_wbxml_to_xml(WBXMLEncoder *encoder,
+                                                            const WB_UTINY *wbxml,
+                                                            WB_ULONG wbxml_len,
+                                                            WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum charset,
+                                                            WB_UTINY **xml,
+                                                            WB_ULONG *xml_len)
+{
+    WBXMLContentHandler xml_content_handler =
+        {
+            xml_clb_start_document,
+            NULL,
+            xml_clb_start_element,
+            xml_clb_end_element,
+            xml_clb_characters,
+            NULL
+        };
+    WBXMLEncoderXMLCtx xml_ctx;
+    const WBXMLLangEntry *encoder_lang = NULL;
+    WBXMLCharsetMIBEnum output_charset = WBXML_CHARSET_UNKNOWN;
+    WBXMLTree *encoder_tree = NULL, *tree = NULL;
+    WB_UTINY indent = 0;
+    WBXMLError ret = WBXML_OK;
+
+    /* Check Parameters */
+    if ((encoder == NULL) || encoder->flow_mode || (wbxml == NULL) || (wbxml_len == 0) || (xml == NULL) || (xml_len == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    /* Init ret values */
+    *xml = NULL;
+    *xml_len = 0;
+
+    /* We output XML */
+    wbxml_encoder_set_output_type(encoder, WBXML_ENCODER_OUTPUT_XML);
+
+    /* Keep what is changed by encoding, in case the document needs a WBXML Tree */
+    encoder_lang = encoder->lang;
+    output_charset = encoder->output_charset;
+    indent = encoder->indent;
+
+    /* Init context */
+    xml_ctx.encoder = encoder;
+    xml_ctx.elts = NULL;
+    xml_ctx.depth = 0;
+    xml_ctx.size = 0;
+    xml_ctx.in_text = FALSE;
+    xml_ctx.use_tree = FALSE;
+    xml_ctx.error = WBXML_OK;
+
+    if ((xml_ctx.parser = wbxml_parser_create_with_allocator(encoder->allocator)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    if ((xml_ctx.text = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_ENCODER_XML_TEXT_MALLOC_BLOCK)) == NULL) {
+        wbxml_parser_destroy(xml_ctx.parser);
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    /* Set Handlers Callbacks */
+    wbxml_parser_set_user_data(xml_ctx.parser, &xml_ctx);
+    wbxml_parser_set_content_handler(xml_ctx.parser, &xml_content_handler);
+
+    /* Give the user the possibility to force Document Language */
+    if (lang != WBXML_LANG_UNKNOWN)
+        wbxml_parser_set_language(xml_ctx.parser, lang);
+
+    /* Give the user the possibility to force the document character set */
+    if (charset != WBXML_CHARSET_UNKNOWN)
+        wbxml_parser_set_meta_charset(xml_ctx.parser, charset);
+
+    /* Text is copied until its end is known */
+    wbxml_parser_set_borrowed_content(xml_ctx.parser, TRUE);
+
+    /* Encode while parsing */
+    if ((ret = wbxml_parser_parse_static(xml_ctx.parser, wbxml, wbxml_len)) == WBXML_OK)
+        ret = xml_ctx.error;
+
+    /* Clean-up */
+    wbxml_parser_destroy(xml_ctx.parser);
+    wbxml_buffer_destroy(xml_ctx.text);
+    wbxml_mem_free(encoder->allocator, xml_ctx.elts);
+
+    if (!xml_ctx.use_tree) {
+        if (ret != WBXML_OK)
+            return ret;
+
+        /* Get result */
+        return encoder_take_output(encoder, xml, xml_len);
+    }
+
+    /* Forget what has been encoded, and start again from a WBXML Tree */
+    wbxml_buffer_destroy(encoder->output);
+    encoder->output = NULL;
+    encoder->header_in_output = FALSE;
+    encoder->lang = encoder_lang;
+    encoder->output_charset = output_charset;
+    encoder->indent = indent;
+    encoder->in_content = FALSE;
+    encoder->current_tag = NULL;
+
+    if ((ret = wbxml_tree_from_wbxml_static(wbxml, wbxml_len, lang, charset, &tree)) != WBXML_OK)
+        return ret;
+
+    encoder_tree = encoder->tree;
+    encoder->tree = tree;
+
+    ret = wbxml_encoder_encode_tree_to_xml(encoder, xml, xml_len);
+
+    encoder->tree = encoder_tree;
+    wbxml_tree_destroy(tree);
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_xml_to_wbxml(WBXMLEncoder *encoder,
+                                                            WB_UTINY *xml,
+                                                            WB_ULONG xml_len,
+                                                            WB_UTINY **wbxml,
+                                                            WB_ULONG *wbxml_len)
+{
+#if defined( HAVE_EXPAT )
+
+    const XML_Feature *feature_list = NULL;
+    XML_Parser xml_parser = NULL;
+    WBXMLEncoderWBXMLCtx wbxml_ctx;
+    const WBXMLLangEntry *encoder_lang = NULL;
+    WBXMLCharsetMIBEnum output_charset = WBXML_CHARSET_UNKNOWN;
+    WB_UTINY tag_code_page = 0, attr_code_page = 0;
+    WB_ULONG pos = 0, len = 0;
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    WB_BOOL use_strtbl = FALSE;
+#endif /* WBXML_ENCODER_USE_STRTBL */
+    WBXMLTree *encoder_tree = NULL, *tree = NULL;
+    WBXMLError ret = WBXML_OK;
+
+    /* Check Parameters */
+    if ((encoder == NULL) || encoder->flow_mode || (xml == NULL) || (xml_len == 0) || (wbxml == NULL) || (wbxml_len == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    /* Init ret values */
+    *wbxml = NULL;
+    *wbxml_len = 0;
+
+    /* We output WBXML */
+    wbxml_encoder_set_output_type(encoder, WBXML_ENCODER_OUTPUT_WBXML);
+
+    /* Keep what is changed by encoding, in case the document needs a WBXML Tree */
+    encoder_lang = encoder->lang;
+    output_charset = encoder->output_charset;
+    tag_code_page = encoder->tagCodePage;
+    attr_code_page = encoder->attrCodePage;
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    use_strtbl = encoder->use_strtbl;
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
+    /* Init context */
+    wbxml_ctx.encoder = encoder;
+    wbxml_ctx.elts = NULL;
+    wbxml_ctx.depth = 0;
+    wbxml_ctx.size = 0;
+    wbxml_ctx.use_tree = FALSE;
+    wbxml_ctx.error = WBXML_OK;
+
+    /* Strings are encoded as Expat gives them: they must be UTF-8 */
+    feature_list = (const XML_Feature *)XML_GetFeatureList();
+    if ((feature_list != NULL) && (feature_list[0].value != sizeof(WB_TINY)))
+        wbxml_ctx.use_tree = TRUE;
+    else {
+        /* Create Expat XML Parser */
+        if ((xml_parser = wbxml_tree_clb_xml_parser_create()) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        /* Init WBXML Tree building context */
+        wbxml_ctx.tree_ctx.current = NULL;
+        wbxml_ctx.tree_ctx.error = WBXML_OK;
+        wbxml_ctx.tree_ctx.skip_lvl = 0;
+        wbxml_ctx.tree_ctx.skip_start = 0;
+        wbxml_ctx.tree_ctx.xml_parser = xml_parser;
+        wbxml_ctx.tree_ctx.input_buff = xml;
+        wbxml_ctx.tree_ctx.expat_utf16 = FALSE;
+
+        if ((wbxml_ctx.tree_ctx.tree = wbxml_tree_create_with_allocator(encoder->allocator, WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN)) == NULL) {
+            XML_ParserFree(xml_parser);
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        /* Set Handlers Callbacks (the WBXML Tree ones are called with the WBXML Tree building context) */
+        XML_SetXmlDeclHandler(xml_parser, wbxml_tree_clb_xml_decl);
+        XML_SetStartDoctypeDeclHandler(xml_parser, wbxml_tree_clb_xml_doctype_decl);
+        XML_SetElementHandler(xml_parser, wbxml_clb_start_element, wbxml_clb_end_element);
+        XML_SetCdataSectionHandler(xml_parser, wbxml_tree_clb_xml_start_cdata, wbxml_tree_clb_xml_end_cdata);
+        XML_SetProcessingInstructionHandler(xml_parser, wbxml_tree_clb_xml_pi);
+        XML_SetCharacterDataHandler(xml_parser, wbxml_clb_characters);
+        XML_SetUserData(xml_parser, (void *) &wbxml_ctx);
+
+        /* Encode while parsing (errors come in the same order than with a WBXML Tree) */
+        for (pos = 0; pos < xml_len; pos += len) {
+            len = xml_len - pos;
+            if (len > WBXML_ENCODER_XML_PARSE_CHUNK)
+                len = WBXML_ENCODER_XML_PARSE_CHUNK;
+
+            if (XML_Parse(xml_parser, (WB_TINY *) xml + pos, (int) len, (pos + len == xml_len)) == XML_STATUS_ERROR) {
+                ret = WBXML_ERROR_XML_PARSING_FAILED;
+                break;
+            }
+        }
+
+        if (ret == WBXML_OK) {
+            if ((ret = wbxml_ctx.tree_ctx.error) == WBXML_OK)
+                ret = wbxml_ctx.error;
+        }
+
+        /* Clean-up */
+        XML_ParserFree(xml_parser);
+        wbxml_tree_destroy(wbxml_ctx.tree_ctx.tree);
+        wbxml_mem_free(encoder->allocator, wbxml_ctx.elts);
+
+        if (!wbxml_ctx.use_tree) {
+            if (ret != WBXML_OK)
+                return ret;
+
+            /* Get result */
+            return encoder_take_output(encoder, wbxml, wbxml_len);
+        }
+    }
+
+    /* Forget what has been encoded, and start again from a WBXML Tree */
+    wbxml_buffer_destroy(encoder->output);
+    encoder->output = NULL;
+    encoder->header_in_output = FALSE;
+    encoder->lang = encoder_lang;
+    encoder->output_charset = output_charset;
+    encoder->tagCodePage = tag_code_page;
+    encoder->attrCodePage = attr_code_page;
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    encoder->use_strtbl = use_strtbl;
+#endif /* WBXML_ENCODER_USE_STRTBL */
+    encoder->current_tag = NULL;
+    encoder->current_node = NULL;
+    encoder->in_cdata = FALSE;
+    wbxml_buffer_destroy(encoder->cdata);
+    encoder->cdata = NULL;
+
+    if ((ret = wbxml_tree_from_xml(xml, xml_len, &tree)) != WBXML_OK)
+        return ret;
+
+    encoder_tree = encoder->tree;
+    encoder->tree = tree;
+
+    ret = wbxml_encoder_encode_tree_to_wbxml(encoder, wbxml, wbxml_len);
+
+    encoder->tree = encoder_tree;
+    wbxml_tree_destroy(tree);
+
+    return ret;
+
+#else /* HAVE_EXPAT */
+
+    /** @note You can add here another XML Parser support */
+    return WBXML_ERROR_NO_XMLPARSER;
+
+#endif /* HAVE_EXPAT */
 }
 
 
@@ -702,25 +1343,7 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_node_with_elt_end(WBXMLEncoder *e
         !((encoder->xml_encode_header == FALSE) && (encoder->output_type == WBXML_ENCODER_OUTPUT_XML)))
     {
         /* Build result header */
-        switch (encoder->output_type) {
-        case WBXML_ENCODER_OUTPUT_XML:
-            if ((encoder->output_header = wbxml_buffer_create("", 0, WBXML_ENCODER_XML_HEADER_MALLOC_BLOCK)) == NULL)
-                ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
-            else
-                ret = xml_fill_header(encoder, encoder->output_header);
-            break;
-            
-        case WBXML_ENCODER_OUTPUT_WBXML:
-            if ((encoder->output_header = wbxml_buffer_create("", 0, WBXML_ENCODER_WBXML_HEADER_MALLOC_BLOCK)) == NULL)
-                ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
-            else
-                ret = wbxml_fill_header(encoder, encoder->output_header);
-            break;
-            
-        default:
-            ret = WBXML_ERROR_BAD_PARAMETER;
-            break;
-        }
+        ret = encoder_build_header(encoder);
     }
     
     if (ret != WBXML_OK)
@@ -804,22 +1427,69 @@ WBXML_DECLARE(WB_ULONG) wbxml_encoder_get_output_len(WBXMLEncoder *encoder)
 }
 
 
-WBXML_DECLARE(void) wbxml_encoder_delete_output_bytes(WBXMLEncoder *encoder, WB_ULONG nb)
+WBXML_DECLARE(WBXMLError) wbxml_encoder_get_output_parts(WBXMLEncoder *encoder, WBXMLEncoderOutputPart parts[WBXML_ENCODER_OUTPUT_PARTS])
 {
-    if (encoder == NULL)
-        return;
-    
-    wbxml_buffer_delete(encoder->output, wbxml_buffer_len(encoder->output) - nb, nb);
-}
-
+    WBXMLBuffer *header     = NULL;
+    WB_ULONG     header_len = 0;
+    WBXMLError   ret        = WBXML_OK;
 
-WBXML_DECLARE(void) wbxml_encoder_delete_last_node(WBXMLEncoder *encoder)
-{
-    if (encoder == NULL)
-        return;
-    
-    wbxml_encoder_delete_output_bytes(encoder, wbxml_buffer_len(encoder->output) - encoder->pre_last_node_len);
-}
+    if ((encoder == NULL) || (parts == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    if (encoder->header_in_output) {
+        /* Header is at start of output */
+        header = encoder->output;
+        header_len = encoder->body_pos;
+    }
+    else {
+        if (encoder->flow_mode == FALSE) {
+            /* Build header now: the String Table is complete */
+            wbxml_buffer_destroy(encoder->output_header);
+            encoder->output_header = NULL;
+
+            if ((ret = encoder_build_header(encoder)) != WBXML_OK)
+                return ret;
+        }
+
+        header = encoder->output_header;
+        header_len = wbxml_buffer_len(header);
+    }
+
+    /* Header */
+    parts[0].data = wbxml_buffer_get_cstr(header);
+    parts[0].len = header_len;
+
+    /* String Table */
+    if ((encoder->output_type == WBXML_ENCODER_OUTPUT_WBXML) && (header_len > 0))
+        parts[0].len = encoder->strtbl_pos;
+
+    parts[1].data = parts[0].data + parts[0].len;
+    parts[1].len = header_len - parts[0].len;
+
+    /* Body */
+    parts[2].data = wbxml_buffer_get_cstr(encoder->output) + encoder->body_pos;
+    parts[2].len = wbxml_buffer_len(encoder->output) - encoder->body_pos;
+
+    return WBXML_OK;
+}
+
+
+WBXML_DECLARE(void) wbxml_encoder_delete_output_bytes(WBXMLEncoder *encoder, WB_ULONG nb)
+{
+    if (encoder == NULL)
+        return;
+    
+    wbxml_buffer_delete(encoder->output, wbxml_buffer_len(encoder->output) - nb, nb);
+}
+
+
+WBXML_DECLARE(void) wbxml_encoder_delete_last_node(WBXMLEncoder *encoder)
+{
+    if (encoder == NULL)
+        return;
+    
+    wbxml_encoder_delete_output_bytes(encoder, wbxml_buffer_len(encoder->output) - encoder->pre_last_node_len);
+}
 
 
 /***************************************************
@@ -855,7 +1525,7 @@ static WBXMLEncoder *encoder_duplicate(WBXMLEncoder *encoder)
 {
     WBXMLEncoder *result = NULL;
 
-    if ((result = wbxml_encoder_create()) == NULL)
+    if ((result = wbxml_encoder_create_with_allocator(encoder->allocator)) == NULL)
         return NULL;
 
     result->ignore_empty_text = encoder->ignore_empty_text;
@@ -869,6 +1539,7 @@ static WBXMLEncoder *encoder_duplicate(WBXMLEncoder *encoder)
 
 #if defined( WBXML_ENCODER_USE_STRTBL )
     result->use_strtbl = encoder->use_strtbl;
+    result->optimal_strtbl = encoder->optimal_strtbl;
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
     /* Do NOT generate XML Header */
@@ -917,27 +1588,7 @@ static WBXMLError encoder_encode_tree(WBXMLEncoder *encoder)
 
     if (encoder->output_type == WBXML_ENCODER_OUTPUT_WBXML) {
         /* Choose if we will use String Table */
-        switch (encoder->lang->langID)
-        {
-    #if defined( WBXML_SUPPORT_WV )
-        /* Wireless-Village CSP 1.1 / 1.2: content can be tokenized, so we mustn't interfere with String Table stuff */
-        case WBXML_LANG_WV_CSP11:
-        case WBXML_LANG_WV_CSP12:
-            encoder->use_strtbl = FALSE;
-            break;
-    #endif /* WBXML_SUPPORT_WV */
-
-    #if defined( WBXML_SUPPORT_OTA_SETTINGS )
-        /* Nokia Ericsson OTA Settings : string tables are not supported */
-        case WBXML_LANG_OTA_SETTINGS:
-            encoder->use_strtbl = FALSE;
-            break;
-    #endif /* WBXML_SUPPORT_OTA_SETTINGS */
-
-        default:
-            /* Use Default Value */
-            break;
-        }
+        encoder_choose_strtbl(encoder);
 
         /* Init String Table */
         if (encoder->use_strtbl) {
@@ -952,10 +1603,52 @@ static WBXMLError encoder_encode_tree(WBXMLEncoder *encoder)
     
 #endif /* WBXML_ENCODER_USE_STRTBL */
 
+    /* Put header first in output, if possible */
+    if ((ret = encoder_output_header_first(encoder)) != WBXML_OK)
+        return ret;
+
     /* Let's begin WBXML Tree Parsing */
-    return parse_node(encoder, encoder->tree->root, TRUE);
+    if ((ret = parse_node(encoder, encoder->tree->root, TRUE)) != WBXML_OK)
+        return ret;
+
+    /* Write what is left, if header is already written */
+    return encoder_write_output(encoder);
+}
+
+
+#if defined( WBXML_ENCODER_USE_STRTBL )
+
+/**
+ * @brief Choose if the String Table is used, given the Language
+ * @param encoder The WBXML Encoder
+ */
+static void encoder_choose_strtbl(WBXMLEncoder *encoder)
+{
+    switch (encoder->lang->langID)
+    {
+#if defined( WBXML_SUPPORT_WV )
+    /* Wireless-Village CSP 1.1 / 1.2: content can be tokenized, so we mustn't interfere with String Table stuff */
+    case WBXML_LANG_WV_CSP11:
+    case WBXML_LANG_WV_CSP12:
+        encoder->use_strtbl = FALSE;
+        break;
+#endif /* WBXML_SUPPORT_WV */
+
+#if defined( WBXML_SUPPORT_OTA_SETTINGS )
+    /* Nokia Ericsson OTA Settings : string tables are not supported */
+    case WBXML_LANG_OTA_SETTINGS:
+        encoder->use_strtbl = FALSE;
+        break;
+#endif /* WBXML_SUPPORT_OTA_SETTINGS */
+
+    default:
+        /* Use Default Value */
+        break;
+    }
 }
 
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
 
 static WB_BOOL encoder_init_output(WBXMLEncoder *encoder)
 {
@@ -975,7 +1668,7 @@ static WB_BOOL encoder_init_output(WBXMLEncoder *encoder)
         malloc_block = WBXML_ENCODER_XML_DOC_MALLOC_BLOCK;
 
     /* Init Output Buffer */
-    encoder->output = wbxml_buffer_create("", 0, malloc_block);
+    encoder->output = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, malloc_block);
     if (encoder->output == NULL)
         return FALSE;
     
@@ -983,6 +1676,159 @@ static WB_BOOL encoder_init_output(WBXMLEncoder *encoder)
 }
 
 
+/**
+ * @brief Build the output header (String Table included)
+ * @param encoder The WBXML Encoder
+ * @return WBXML_OK if built, an error code otherwise
+ */
+static WBXMLError encoder_build_header(WBXMLEncoder *encoder)
+{
+    switch (encoder->output_type) {
+    case WBXML_ENCODER_OUTPUT_XML:
+        if ((encoder->output_header = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_ENCODER_XML_HEADER_MALLOC_BLOCK)) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        if (encoder->xml_encode_header == FALSE)
+            return WBXML_OK;
+
+        return xml_fill_header(encoder, encoder->output_header);
+
+    case WBXML_ENCODER_OUTPUT_WBXML:
+        if ((encoder->output_header = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_ENCODER_WBXML_HEADER_MALLOC_BLOCK)) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        return wbxml_fill_header(encoder, encoder->output_header);
+
+    default:
+        return WBXML_ERROR_BAD_PARAMETER;
+    }
+}
+
+
+/**
+ * @brief Put the header at start of output, before encoding the body
+ * @param encoder The WBXML Encoder
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note This is only possible if the header does not depend on the body: the String Table
+ *       is filled while the body is encoded. Then the document is the output as is: it is
+ *       not copied to be appended to the header, and can be written as it is encoded.
+ */
+static WBXMLError encoder_output_header_first(WBXMLEncoder *encoder)
+{
+    WBXMLError ret = WBXML_OK;
+
+    encoder->header_in_output = FALSE;
+    encoder->strtbl_pos = 0;
+    encoder->body_pos = 0;
+
+    /* Flow Mode has its own header, and output must not already contain something */
+    if (encoder->flow_mode || (wbxml_buffer_len(encoder->output) > 0))
+        return WBXML_OK;
+
+    switch (encoder->output_type) {
+    case WBXML_ENCODER_OUTPUT_XML:
+        if (encoder->xml_encode_header)
+            ret = xml_fill_header(encoder, encoder->output);
+        break;
+
+    case WBXML_ENCODER_OUTPUT_WBXML:
+#if defined( WBXML_ENCODER_USE_STRTBL )
+        if (encoder->use_strtbl)
+            return WBXML_OK;
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
+        ret = wbxml_fill_header(encoder, encoder->output);
+        break;
+
+    default:
+        return WBXML_ERROR_BAD_PARAMETER;
+    }
+
+    if (ret != WBXML_OK)
+        return ret;
+
+    encoder->header_in_output = TRUE;
+    encoder->body_pos = wbxml_buffer_len(encoder->output);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Give the encoded document
+ * @param encoder [in] The WBXML Encoder
+ * @param result [out] The encoded document
+ * @param result_len [out] The encoded document length
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note If header is at start of output, the output memory is given as is: it is not copied.
+ */
+static WBXMLError encoder_take_output(WBXMLEncoder *encoder, WB_UTINY **result, WB_ULONG *result_len)
+{
+    if (encoder->header_in_output) {
+        if ((*result = wbxml_buffer_detach(encoder->output, result_len)) == NULL)
+            return WBXML_ERROR_INTERNAL;
+
+        encoder->header_in_output = FALSE;
+        encoder->strtbl_pos = 0;
+        encoder->body_pos = 0;
+
+        return WBXML_OK;
+    }
+
+    return wbxml_encoder_get_output(encoder, result, result_len);
+}
+
+
+/**
+ * @brief Give the output to the Write Handler
+ * @param encoder The WBXML Encoder
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note Nothing is done if there is no Write Handler, or if the header is not in output yet
+ *       (it is then built, and written, at the end).
+ */
+static WBXMLError encoder_write_output(WBXMLEncoder *encoder)
+{
+    WB_ULONG   len = wbxml_buffer_len(encoder->output);
+    WBXMLError ret = WBXML_OK;
+
+    if ((encoder->write_handler == NULL) || !encoder->header_in_output || (len == 0))
+        return WBXML_OK;
+
+    if ((ret = encoder->write_handler(encoder->write_ctx, wbxml_buffer_get_cstr(encoder->output), len)) != WBXML_OK)
+        return ret;
+
+    /* Output is empty again, and header is written */
+    wbxml_buffer_delete(encoder->output, 0, len);
+    encoder->strtbl_pos = 0;
+    encoder->body_pos = 0;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Check if a Text Node is a Slot (cf wbxml_encoder_encode_tree_with_slots())
+ * @param encoder The WBXML Encoder
+ * @param node    The Text Node
+ * @param index   [out] Index of Slot
+ * @return TRUE if this Node is a Slot, FALSE otherwise
+ * @note There are only a few Slots in a document: they are searched one by one
+ */
+static WB_BOOL encoder_find_slot(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_ULONG *index)
+{
+    WB_ULONG i = 0;
+
+    for (i = 0; i < encoder->nb_slots; i++) {
+        if (encoder->slots[i] == node) {
+            *index = i;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+
 /*********************************
  * WBXML Tree Parsing Functions
  */
@@ -1044,7 +1890,7 @@ static WBXMLError parse_node(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_BOOL
 #endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
 
                     /* Encode end tag */
-                    if ((ret = xml_encode_end_tag(encoder, node)) != WBXML_OK)
+                    if ((ret = xml_encode_end_tag(encoder, node->name, xml_node_indent_content(encoder, node))) != WBXML_OK)
                         return ret;
 
                     WBXML_DEBUG((WBXML_ENCODER, "End Element"));
@@ -1120,6 +1966,12 @@ static WBXMLError parse_node(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_BOOL
     encoder->current_tag = NULL;
     encoder->current_node = NULL;
 
+    /* Give output to the Write Handler, by blocks */
+    if (wbxml_buffer_len(encoder->output) >= WBXML_ENCODER_WRITE_BLOCK) {
+        if ((ret = encoder_write_output(encoder)) != WBXML_OK)
+            return ret;
+    }
+
     /* Parse next node */
     if (node->next != NULL)
         return parse_node(encoder, node->next, TRUE);
@@ -1151,7 +2003,7 @@ static WBXMLError parse_element(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_B
         break;
 
     case WBXML_ENCODER_OUTPUT_XML:
-        if ((ret = xml_encode_tag(encoder, node)) != WBXML_OK)
+        if ((ret = xml_encode_tag(encoder, node->name, xml_node_switch_page(node))) != WBXML_OK)
             return ret;
         break;
 
@@ -1192,7 +2044,7 @@ static WBXMLError parse_element(WBXMLEncoder *encoder, WBXMLTreeNode *node, WB_B
 
     case WBXML_ENCODER_OUTPUT_XML:
         /* Encode end of attributes */
-        if ((ret = xml_encode_end_attrs(encoder, node)) != WBXML_OK)
+        if ((ret = xml_encode_end_attrs(encoder, node->children != NULL, xml_node_indent_content(encoder, node))) != WBXML_OK)
             return ret;
 
         WBXML_DEBUG((WBXML_ENCODER, "End Attributes"));
@@ -1223,7 +2075,7 @@ static WBXMLError parse_element_end(WBXMLEncoder *encoder, WBXMLTreeNode *node,
 #endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
 
             /* Encode end tag */
-            ret = xml_encode_end_tag(encoder, node);
+            ret = xml_encode_end_tag(encoder, node->name, xml_node_indent_content(encoder, node));
 
             WBXML_DEBUG((WBXML_ENCODER, "End Element"));
 
@@ -1286,8 +2138,21 @@ static WBXMLError parse_attribute(WBXMLEncoder *encoder, WBXMLAttribute *attribu
  */
 static WBXMLError parse_text(WBXMLEncoder *encoder, WBXMLTreeNode *node)
 {
+    WBXMLBuffer *text = node->content, *stripped = NULL, *value = NULL;
+    WB_ULONG start = 0, len = 0, slot = 0;
     WBXMLError ret = WBXML_OK;
     
+    /* A Slot is not encoded: its value is inserted later, at this position */
+    if (encoder_find_slot(encoder, node, &slot)) {
+        if (encoder->in_cdata || (encoder->output_type != WBXML_ENCODER_OUTPUT_WBXML))
+            return WBXML_ERROR_XML_NODE_NOT_ALLOWED;
+
+        if (encoder->slots_pos != NULL)
+            encoder->slots_pos[slot] = wbxml_buffer_len(encoder->output);
+
+        return WBXML_OK;
+    }
+
     /* Some elements should be transferred as opaque data */
     if (encoder->output_type == WBXML_ENCODER_OUTPUT_WBXML &&
         encoder->current_tag != NULL &&
@@ -1306,9 +2171,21 @@ static WBXMLError parse_text(WBXMLEncoder *encoder, WBXMLTreeNode *node)
             if ((encoder->ignore_empty_text) && (wbxml_buffer_contains_only_whitespaces(node->content)))
                 return WBXML_OK;
 
-            /* Strip Blanks */
-            if (encoder->remove_text_blanks)
-                wbxml_buffer_strip_blanks(node->content);
+            /**
+             * Strip Blanks. The Tree is never modified (it can be encoded several times,
+             * even at the same time by several encoders): only the stripped part of text
+             * is looked at.
+             */
+            if (encoder->remove_text_blanks) {
+                wbxml_buffer_get_stripped_bounds(node->content, &start, &len);
+
+                if (len < wbxml_buffer_len(node->content)) {
+                    if ((stripped = wbxml_buffer_sta_create_with_allocator(encoder->allocator, wbxml_buffer_get_cstr(node->content) + start, len)) == NULL)
+                        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+                    text = stripped;
+                }
+            }
         }
     }
 
@@ -1332,7 +2209,9 @@ static WBXMLError parse_text(WBXMLEncoder *encoder, WBXMLTreeNode *node)
                 /** @todo We suppose that Opaque Data in SyncML messages can only be vCard or vCal documents. CHANGE THAT ! */
                 if (node->content != NULL) {
                     if (wbxml_buffer_get_cstr(node->content)[0] == 0x0a && wbxml_buffer_len(node->content) == 1) {
-                        wbxml_buffer_insert_cstr(node->content, (WB_UTINY*) "\r", 0);
+                        /* "\n" is encoded as "\r\n" */
+                        if (!wbxml_buffer_append_char(encoder->cdata, '\r'))
+                            return WBXML_ERROR_ENCODER_APPEND_DATA;
                     }
                 }
             }
@@ -1346,19 +2225,38 @@ static WBXMLError parse_text(WBXMLEncoder *encoder, WBXMLTreeNode *node)
             return WBXML_OK;
         }
         else {
+            /* The Value Element encoding needs a NULL terminated text: only copy the stripped
+             * text when its end was stripped */
+            value = text;
+            if ((stripped != NULL) && (start + len < wbxml_buffer_len(node->content))) {
+                if ((value = wbxml_buffer_duplicate(stripped)) == NULL) {
+                    wbxml_buffer_destroy(stripped);
+                    return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+                }
+            }
+
             /* Encode text */
             encoder->current_text_parent = node->parent;
-            ret = wbxml_encode_value_element_buffer(encoder, wbxml_buffer_get_cstr(node->content), WBXML_VALUE_ELEMENT_CTX_CONTENT);
+            ret = wbxml_encode_value_element_buffer(encoder, wbxml_buffer_get_cstr(value), WBXML_VALUE_ELEMENT_CTX_CONTENT);
             encoder->current_text_parent = NULL;
-            return ret;
+
+            if (value != text)
+                wbxml_buffer_destroy(value);
+            break;
         }
 
     case WBXML_ENCODER_OUTPUT_XML:
-        return xml_encode_text(encoder, node);
+        ret = xml_encode_text(encoder, text, xml_node_indent_content(encoder, node));
+        break;
 
     default:
-        return WBXML_ERROR_INTERNAL;
+        ret = WBXML_ERROR_INTERNAL;
+        break;
     }
+
+    wbxml_buffer_destroy(stripped);
+
+    return ret;
 }
 
 
@@ -1385,7 +2283,7 @@ static WBXMLError parse_cdata(WBXMLEncoder *encoder)
         }
 
         /* Create a new CDATA Buffer */
-        if ((encoder->cdata = wbxml_buffer_create("", 0, 0)) == NULL) {
+        if ((encoder->cdata = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, 0)) == NULL) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
 
@@ -1452,13 +2350,17 @@ static WBXMLError wbxml_build_result(WBXMLEncoder *encoder, WB_UTINY **wbxml, WB
     WBXMLBuffer *header = NULL;
     WBXMLError ret = WBXML_OK;
     
-    if (encoder->flow_mode == TRUE) {
+    if (encoder->header_in_output) {
+        /* Header is at start of output */
+        header = NULL;
+    }
+    else if (encoder->flow_mode == TRUE) {
         /* Header already built */
         header = encoder->output_header;
     }
     else {
         /* Create WBXML Header buffer */
-        if ((header = wbxml_buffer_create("", 0, WBXML_ENCODER_WBXML_HEADER_MALLOC_BLOCK)) == NULL)
+        if ((header = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_ENCODER_WBXML_HEADER_MALLOC_BLOCK)) == NULL)
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         
         /* Fill Header Buffer */
@@ -1472,7 +2374,7 @@ static WBXMLError wbxml_build_result(WBXMLEncoder *encoder, WB_UTINY **wbxml, WB
     *wbxml_len = wbxml_buffer_len(header) + wbxml_buffer_len(encoder->output);
 
     /* Create Result Buffer */
-    *wbxml = wbxml_malloc(*wbxml_len * sizeof(WB_UTINY));
+    *wbxml = wbxml_mem_malloc(encoder->allocator, *wbxml_len * sizeof(WB_UTINY));
     if (*wbxml == NULL) {
         if (encoder->flow_mode == FALSE)
             wbxml_buffer_destroy(header);
@@ -1527,16 +2429,16 @@ static WBXMLError wbxml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header)
     {
         if (encoder->lang->publicID->xmlPublicID != NULL)
         {
-            if ((pid = wbxml_buffer_create(encoder->lang->publicID->xmlPublicID,
-                                           WBXML_STRLEN(encoder->lang->publicID->xmlPublicID),
-                                           WBXML_STRLEN(encoder->lang->publicID->xmlPublicID))) == NULL)
+            if ((pid = wbxml_buffer_create_with_allocator(encoder->allocator, encoder->lang->publicID->xmlPublicID,
+                                                          WBXML_STRLEN(encoder->lang->publicID->xmlPublicID),
+                                                          WBXML_STRLEN(encoder->lang->publicID->xmlPublicID))) == NULL)
             {
                 return WBXML_ERROR_NOT_ENOUGH_MEMORY;
             }
 
 #if defined( WBXML_ENCODER_USE_STRTBL )
             if (encoder->use_strtbl) {
-                if ((elt = wbxml_strtbl_element_create(pid, FALSE)) == NULL)
+                if ((elt = wbxml_strtbl_element_create(encoder->allocator, pid, FALSE)) == NULL)
                 {
                     wbxml_buffer_destroy(pid);
                     return WBXML_ERROR_NOT_ENOUGH_MEMORY;
@@ -1555,8 +2457,11 @@ static WBXMLError wbxml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header)
                 /* "added" means that pid was consumed by encoder.
                  * So never free pid if added is TRUE.
                  */
-                if (!added)
+                if (!added) {
+                    /* Already in String Table (header built again): pid is destroyed with elt */
                     wbxml_strtbl_element_destroy(elt);
+                    pid = NULL;
+                }
 
                 strstbl_len = encoder->strstbl_len;
             }
@@ -1603,6 +2508,9 @@ static WBXMLError wbxml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header)
         return WBXML_ERROR_ENCODER_APPEND_DATA;
     }
 
+    /* String Table starts here */
+    encoder->strtbl_pos = wbxml_buffer_len(header);
+
     /* Encode WBXML String Table */
 #if defined( WBXML_ENCODER_USE_STRTBL )
     if (encoder->use_strtbl) {
@@ -1739,8 +2647,8 @@ static WBXMLError wbxml_encode_tag_literal(WBXMLEncoder *encoder, const WB_UTINY
         return WBXML_ERROR_STRTBL_DISABLED;
 
     /* Add tag in String Table */
-    if (((buff = wbxml_buffer_create(tag, WBXML_STRLEN(tag), WBXML_STRLEN(tag))) == NULL) ||
-        ((elt = wbxml_strtbl_element_create(buff, FALSE)) == NULL) ||
+    if (((buff = wbxml_buffer_create_with_allocator(encoder->allocator, tag, WBXML_STRLEN(tag), WBXML_STRLEN(tag))) == NULL) ||
+        ((elt = wbxml_strtbl_element_create(encoder->allocator, buff, FALSE)) == NULL) ||
         (!wbxml_strtbl_add_element(encoder, elt, &index, &added)))
     {
         wbxml_strtbl_element_destroy(elt);
@@ -1936,16 +2844,14 @@ static WBXMLError wbxml_encode_attr_start(WBXMLEncoder *encoder, WBXMLAttribute
 static WBXMLError wbxml_encode_value_element_buffer(WBXMLEncoder *encoder, WB_UTINY *buffer, WBXMLValueElementCtx ctx)
 {
     WBXMLList *lresult = NULL;
-    WBXMLBuffer *buff = NULL;
-    WBXMLValueElement *elt = NULL, *new_elt = NULL;
-    WB_ULONG i = 0, j = 0, index = 0;
+    WBXMLValueElement *elt = NULL;
+    const WBXMLExtValueEntry *ext = NULL;
+    const WBXMLMatcher *matcher = NULL;
+    WBXMLMatchSet set;
+    WB_ULONG len = 0, attr_count = 0;
     WB_UTINY *the_buffer = buffer;
     WBXMLError ret = WBXML_OK;
 
-#if defined( WBXML_ENCODER_USE_STRTBL )
-    WBXMLStringTableElement *strtbl_elt = NULL;
-#endif /* WBXML_ENCODER_USE_STRTBL */
-
     if ((buffer == NULL) || (*buffer == '\0'))
         return WBXML_OK;
 
@@ -2071,264 +2977,248 @@ static WBXMLError wbxml_encode_value_element_buffer(WBXMLEncoder *encoder, WB_UT
      */
 
     /* Create Result List */
-    if ((lresult = wbxml_list_create()) == NULL)
+    if ((lresult = wbxml_list_create_with_allocator(encoder->allocator)) == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-    /* Create primary Buffer */
-    if ((buff = wbxml_buffer_create_from_cstr(the_buffer)) == NULL) {
-        wbxml_list_destroy(lresult, NULL);
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
+    wbxml_match_set_init_with_allocator(&set, encoder->allocator);
 
-    /* Create Value Element for this buffer */
-    if ((elt = wbxml_value_element_create()) == NULL) {
-        wbxml_buffer_destroy(buff);
-        wbxml_list_destroy(lresult, NULL);
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
+    len = WBXML_STRLEN(the_buffer);
 
-    elt->type = WBXML_VALUE_ELEMENT_STRING;
-    elt->u.str = buff;
+    /* If this is a Text Content (not in a CDATA section) */
+    if ((ctx == WBXML_VALUE_ELEMENT_CTX_CONTENT) && (!encoder->in_cdata))
+    {
+        /*********************************************************
+         *  Search for Extension Tokens
+         */
 
-    /* Append this Buffer to Result List */
-    if (!wbxml_list_append(lresult, elt)) {
-        wbxml_value_element_destroy(elt);
-        wbxml_list_destroy(lresult, NULL);
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        /**
+         * The Extension Token must be the whole buffer. Otherwise we can damage normal text
+         * entities like 'My IM-application.' If 'IM' is an Extension Token.
+         * The "1 char Extension Tokens" are ignored.
+         *
+         * Assumption: The buffer is already normalized.
+         */
+        if ((len >= 2) && ((ext = wbxml_tables_get_ext_from_xml(encoder->lang, the_buffer)) != NULL))
+        {
+            /* Create new Value Element */
+            if ((elt = wbxml_value_element_create(encoder->allocator)) == NULL) {
+                ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+                goto error;
+            }
+
+            elt->type = WBXML_VALUE_ELEMENT_EXTENSION;
+            elt->u.ext = ext;
+
+            if (!wbxml_list_append(lresult, elt)) {
+                wbxml_value_element_destroy(elt);
+                ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+                goto error;
+            }
+
+            /* Nothing left to tokenize */
+            len = 0;
+        }
     }
 
+    /**
+     * All the tokens that can be found in buffer are searched in one pass for each Matcher.
+     * The Attribute Value Tokens have the highest priority (in Attribute Values Table order),
+     * then come the String Table References (in String Table order). Where tokens overlap,
+     * the one with the highest priority is kept (cf wbxml_matcher_select()).
+     */
+
     /* If this is an Attribute Value */
-    if (ctx == WBXML_VALUE_ELEMENT_CTX_ATTR)
+    if ((ctx == WBXML_VALUE_ELEMENT_CTX_ATTR) && (encoder->lang->attrValueTable != NULL))
     {
         /*********************************************************
          *  Search for Attribute Value Tokens
          */
 
-        if (encoder->lang->attrValueTable != NULL) {
-            /* For each Attribute Value Token */
-            j = 0;
-            while (encoder->lang->attrValueTable[j].xmlName != NULL)
-            {
-                /* For each Value Element */
-                for (i = 0; i < wbxml_list_len(lresult); i++) {
-                    if ((elt = (WBXMLValueElement *) wbxml_list_get(lresult, i)) == NULL)
-                        continue;
-
-                    if (elt->type != WBXML_VALUE_ELEMENT_STRING)
-                        continue;
-
-                    /* Is this Attribute Value contained in this Buffer ? */
-                    if (wbxml_buffer_search_cstr(elt->u.str, (WB_UTINY *)encoder->lang->attrValueTable[j].xmlName, 0, &index)) {
-                        /* Create new Value Element */
-                        if ((new_elt = wbxml_value_element_create()) == NULL) {
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
+        if (((matcher = wbxml_encoder_get_attr_value_matcher(encoder)) == NULL) ||
+            !wbxml_matcher_search(matcher, the_buffer, len, 0, &set))
+        {
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            goto error;
+        }
 
-                        new_elt->type = WBXML_VALUE_ELEMENT_ATTR_TOKEN;
-                        new_elt->u.attr = &(encoder->lang->attrValueTable[j]);
+        attr_count = wbxml_matcher_count(matcher);
+    }
 
-                        /* Insert new Value Element in List */
-                        if (!wbxml_list_insert(lresult, (void *) new_elt, i + 1)) {
-                            wbxml_value_element_destroy(new_elt);
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
+#if defined( WBXML_ENCODER_USE_STRTBL )
 
-                        /* Check if there is still the end of the String to encode */
-                        if (index + WBXML_STRLEN(encoder->lang->attrValueTable[j].xmlName) < wbxml_buffer_len(elt->u.str)) {
-                            /* Create new Value Element */
-                            if ((new_elt = wbxml_value_element_create()) == NULL) {
-                                wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                            }
+    /***********************************************************************
+     *  Search for String Table References
+     *  (except if this is a Content string and we are in a CDATA section)
+     */
 
-                            new_elt->type = WBXML_VALUE_ELEMENT_STRING;
-                            new_elt->u.str = wbxml_buffer_create_from_cstr(wbxml_buffer_get_cstr(elt->u.str) + index + WBXML_STRLEN(encoder->lang->attrValueTable[j].xmlName));
+    if (encoder->use_strtbl &&
+        !(encoder->in_cdata && (ctx == WBXML_VALUE_ELEMENT_CTX_CONTENT)) &&
+        (wbxml_list_len(encoder->strstbl) > 0))
+    {
+        if (((matcher = wbxml_strtbl_get_matcher(encoder)) == NULL) ||
+            !wbxml_matcher_search(matcher, the_buffer, len, attr_count, &set))
+        {
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            goto error;
+        }
+    }
 
-                            /* Insert new Value Element in List */
-                            if ((new_elt->u.str == NULL) ||
-                                !wbxml_list_insert(lresult, (void *) new_elt, i + 2))
-                            {
-                                wbxml_value_element_destroy(new_elt);
-                                wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                            }
-                        }
+#endif /* WBXML_ENCODER_USE_STRTBL */
 
-                        /* Remove the Attribute Value found in Value Element */
-                        wbxml_buffer_delete(elt->u.str, index, wbxml_buffer_len(elt->u.str) - index);
-                    } /* if */
-                } /* for */
-                j++;
-            } /* while */
-        } /* if */
+    /* Keep tokens by priority, and cut buffer around them */
+    if (!wbxml_matcher_select(&set, len)) {
+        ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        goto error;
     }
 
-    /* If this is a Text Content (not in a CDATA section) */
-    if ((ctx == WBXML_VALUE_ELEMENT_CTX_CONTENT) && (!encoder->in_cdata))
-    {
-        /*********************************************************
-         *  Search for Extension Tokens
-         */
+    if ((ret = wbxml_encode_value_element_matches(encoder, lresult, the_buffer, len, &set, attr_count)) != WBXML_OK)
+        goto error;
 
-        /** @todo Finish Extension Tokens Search */
 
-        if (encoder->lang->extValueTable != NULL) {
-            /* For each Extension Token */
-            j = 0;
-            while (encoder->lang->extValueTable[j].xmlName != NULL)
-            {
-                /* For each Value Element */
-                for (i = 0; i < wbxml_list_len(lresult); i++) {
-                    if ((elt = (WBXMLValueElement *) wbxml_list_get(lresult, i)) == NULL)
-                        continue;
-
-                    if (elt->type != WBXML_VALUE_ELEMENT_STRING)
-                        continue;
-
-                    /* Ignores the "1 char Extension Tokens" */
-                    if (WBXML_STRLEN(encoder->lang->extValueTable[j].xmlName) < 2)
-                        continue;
-
-                    /* Is this Extension Token contained in this Buffer ?
-		     * 
-		     * The Extension Token must start at the beginning of
-		     * the buffer. Otherwise we can damage normal text
-		     * entities like 'My IM-application.' If 'IM' is an
-		     * Extension Token.
-		     *
-		     * Assumption: The buffer is already normalized.
-		     */
-                    if (wbxml_buffer_compare_cstr(elt->u.str, (WB_TINY *) encoder->lang->extValueTable[j].xmlName) == 0)
-                    {
-                        /* Create new Value Element */
-                        if ((new_elt = wbxml_value_element_create()) == NULL) {
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
+    /*********************************************************
+     *  Encode Value Element Buffer
+     */
 
-                        new_elt->type = WBXML_VALUE_ELEMENT_EXTENSION;
-                        new_elt->u.ext = &(encoder->lang->extValueTable[j]);
+    ret = wbxml_encode_value_element_list(encoder, lresult);
 
-                        /* Insert new Value Element in List */
-                        if (!wbxml_list_insert(lresult, (void *) new_elt, i + 1)) {
-                            wbxml_value_element_destroy(new_elt);
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
+error:
+    /* Clean-up */
+    wbxml_match_set_clean(&set);
+    wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
 
-                        /* Check if there is still the end of the String to encode */
-                        if (index + WBXML_STRLEN(encoder->lang->extValueTable[j].xmlName) < wbxml_buffer_len(elt->u.str)) {
-                            /* Create new Value Element */
-                            if ((new_elt = wbxml_value_element_create()) == NULL) {
-                                wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                            }
+    return ret;
+}
 
-                            new_elt->type = WBXML_VALUE_ELEMENT_STRING;
-                            new_elt->u.str = wbxml_buffer_create_from_cstr(wbxml_buffer_get_cstr(elt->u.str) + index + WBXML_STRLEN(encoder->lang->extValueTable[j].xmlName));
 
-                            /* Insert new Value Element in List */
-                            if ((new_elt->u.str == NULL) ||
-                                !wbxml_list_insert(lresult, (void *) new_elt, i + 2))
-                            {
-                                wbxml_value_element_destroy(new_elt);
-                                wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                            }
-                        }
+/**
+ * @brief Build the Value Element List of a buffer, given the tokens found in it
+ * @param encoder The WBXML Encoder
+ * @param lresult The Value Element List to fill
+ * @param buffer The Value Element Buffer
+ * @param len Length of buffer
+ * @param set The tokens found in buffer (sorted by position, not overlapping)
+ * @param attr_count Number of Attribute Value Tokens Patterns (tokens with a greater priority are String Table References)
+ * @return WBXML_OK if list is built, an error code otherwise
+ * @note Each part of buffer that is not a token is appended as an Inline String
+ */
+static WBXMLError wbxml_encode_value_element_matches(WBXMLEncoder *encoder,
+                                                     WBXMLList *lresult,
+                                                     const WB_UTINY *buffer,
+                                                     WB_ULONG len,
+                                                     WBXMLMatchSet *set,
+                                                     WB_ULONG attr_count)
+{
+    WBXMLValueElement *elt = NULL;
+    WBXMLMatch *match = NULL;
+    WB_ULONG i = 0, pos = 0, end = 0;
 
-                        /* Remove the Attribute Value found in Value Element */
-                        wbxml_buffer_delete(elt->u.str, index, wbxml_buffer_len(elt->u.str) - index);
-                    } /* if */
-                } /* for */
-                j++;
-            } /* while */
-        } /* if */
-    }
+    for (i = 0; i <= set->len; i++) {
+        /* String before this token (or before end of buffer) */
+        end = (i < set->len) ? set->matches[i].pos : len;
 
+        if (end > pos) {
+            /* Create new Value Element */
+            if ((elt = wbxml_value_element_create(encoder->allocator)) == NULL)
+                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-#if defined( WBXML_ENCODER_USE_STRTBL )
+            elt->type = WBXML_VALUE_ELEMENT_STRING;
 
-    /***********************************************************************
-     *  Search for String Table References
-     *  (except if this is a Content string and we are in a CDATA section)
-     */
+            if (((elt->u.str = wbxml_buffer_create_with_allocator(encoder->allocator, buffer + pos, end - pos, end - pos)) == NULL) ||
+                !wbxml_list_append(lresult, elt))
+            {
+                wbxml_value_element_destroy(elt);
+                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            }
 
-    if (encoder->use_strtbl && !(encoder->in_cdata && (ctx == WBXML_VALUE_ELEMENT_CTX_CONTENT))) {
-        /* For each String Table Element */
-        for (j = 0; j < wbxml_list_len(encoder->strstbl); j++) {
-            if ((strtbl_elt = (WBXMLStringTableElement *) wbxml_list_get(encoder->strstbl, j)) == NULL)
-                continue;
+#if defined( WBXML_ENCODER_USE_STRTBL )
+            /* Collect it, as a String that could be referenced */
+            if ((encoder->strstbl_text != NULL) &&
+                (!wbxml_buffer_append_data(encoder->strstbl_text, buffer + pos, end - pos) ||
+                 !wbxml_buffer_append_char(encoder->strstbl_text, WBXML_STR_END)))
+            {
+                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            }
+#endif /* WBXML_ENCODER_USE_STRTBL */
+        }
 
-            /* For each Value Element */
-            for (i = 0; i < wbxml_list_len(lresult); i++) {
-                if ((elt = (WBXMLValueElement *) wbxml_list_get(lresult, i)) == NULL)
-                    continue;
+        if (i == set->len)
+            break;
 
-                if (elt->type != WBXML_VALUE_ELEMENT_STRING)
-                    continue;
+        match = &set->matches[i];
 
-                /* Is the String Table Element contained in this Buffer ? */
-                if (wbxml_buffer_search(elt->u.str, strtbl_elt->string, 0, &index)) {
-                    /* Create new Value Element */
-                    if ((new_elt = wbxml_value_element_create()) == NULL) {
-                        wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                    }
+        /* Create new Value Element */
+        if ((elt = wbxml_value_element_create(encoder->allocator)) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-                    new_elt->type = WBXML_VALUE_ELEMENT_TABLEREF;
-                    new_elt->u.index = strtbl_elt->offset;
+#if defined( WBXML_ENCODER_USE_STRTBL )
+        if (match->pattern >= attr_count) {
+            elt->type = WBXML_VALUE_ELEMENT_TABLEREF;
+            elt->u.index = match->value;
+        }
+        else
+#endif /* WBXML_ENCODER_USE_STRTBL */
+        {
+            elt->type = WBXML_VALUE_ELEMENT_ATTR_TOKEN;
+            elt->u.attr = &(encoder->lang->attrValueTable[match->value]);
+        }
 
-                    /* Insert new Value Element in List */
-                    if (!wbxml_list_insert(lresult, (void *) new_elt, i + 1)) {
-                        wbxml_value_element_destroy(new_elt);
-                        wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                    }
+        if (!wbxml_list_append(lresult, elt)) {
+            wbxml_value_element_destroy(elt);
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
 
-                    /* Check if there is still the end of the String to encode */
-                    if (index + wbxml_buffer_len(strtbl_elt->string) < wbxml_buffer_len(elt->u.str)) {
-                        /* Create new Value Element */
-                        if ((new_elt = wbxml_value_element_create()) == NULL) {
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
+        pos = match->pos + match->len;
+    }
 
-                        new_elt->type = WBXML_VALUE_ELEMENT_STRING;
-                        new_elt->u.str = wbxml_buffer_create_from_cstr(wbxml_buffer_get_cstr(elt->u.str) + index + wbxml_buffer_len(strtbl_elt->string));
+    return WBXML_OK;
+}
 
-                        /* Insert new Value Element in List */
-                        if ((new_elt->u.str == NULL) ||
-                            !wbxml_list_insert(lresult, (void *) new_elt, i + 2))
-                        {
-                            wbxml_value_element_destroy(new_elt);
-                            wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
-                            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                        }
-                    }
 
-                    /* Remove the Attribute Value found in Value Element */
-                    wbxml_buffer_delete(elt->u.str, index, wbxml_buffer_len(elt->u.str) - index);
-                } /* if */
-            } /* for */
-        } /* for */
-    } /* if */
+/**
+ * @brief Get the Attribute Values Matcher of current Language
+ * @param encoder The WBXML Encoder
+ * @return The compiled Matcher, or NULL if not enough memory
+ * @note Matchers of Main Table Languages are shared. For a Language Table given by user,
+ *       the Matcher is built by this encoder.
+ */
+static const WBXMLMatcher *wbxml_encoder_get_attr_value_matcher(WBXMLEncoder *encoder)
+{
+    const WBXMLMatcher *matcher = NULL;
+    WB_ULONG i = 0;
 
-#endif /* WBXML_ENCODER_USE_STRTBL */
+    if ((matcher = wbxml_tables_get_attr_value_matcher(encoder->lang)) != NULL)
+        return matcher;
 
+    if ((encoder->attr_value_matcher != NULL) && (encoder->attr_value_matcher_lang == encoder->lang))
+        return encoder->attr_value_matcher;
 
-    /*********************************************************
-     *  Encode Value Element Buffer
-     */
+    /* Build our own Matcher */
+    wbxml_matcher_destroy(encoder->attr_value_matcher);
+    encoder->attr_value_matcher_lang = encoder->lang;
 
-    ret = wbxml_encode_value_element_list(encoder, lresult);
+    if ((encoder->attr_value_matcher = wbxml_matcher_create_with_allocator(encoder->allocator)) == NULL)
+        return NULL;
 
-    /* Clean-up */
-    wbxml_list_destroy(lresult, wbxml_value_element_destroy_item);
+    while (encoder->lang->attrValueTable[i].xmlName != NULL) {
+        if (!wbxml_matcher_add(encoder->attr_value_matcher,
+                               (const WB_UTINY *) encoder->lang->attrValueTable[i].xmlName,
+                               WBXML_STRLEN(encoder->lang->attrValueTable[i].xmlName),
+                               i))
+        {
+            wbxml_matcher_destroy(encoder->attr_value_matcher);
+            encoder->attr_value_matcher = NULL;
+            return NULL;
+        }
+        i++;
+    }
 
-    return ret;
+    if (!wbxml_matcher_compile(encoder->attr_value_matcher)) {
+        wbxml_matcher_destroy(encoder->attr_value_matcher);
+        encoder->attr_value_matcher = NULL;
+        return NULL;
+    }
+
+    return encoder->attr_value_matcher;
 }
 
 
@@ -2417,8 +3307,8 @@ static WBXMLError wbxml_encode_attr_start_literal(WBXMLEncoder *encoder, const W
         return WBXML_ERROR_STRTBL_DISABLED;
 
     /* Add tag in String Table */
-    if (((buff = wbxml_buffer_create(attr, WBXML_STRLEN(attr), WBXML_STRLEN(attr))) == NULL) ||
-        ((elt = wbxml_strtbl_element_create(buff, FALSE)) == NULL) ||
+    if (((buff = wbxml_buffer_create_with_allocator(encoder->allocator, attr, WBXML_STRLEN(attr), WBXML_STRLEN(attr))) == NULL) ||
+        ((elt = wbxml_strtbl_element_create(encoder->allocator, buff, FALSE)) == NULL) ||
         (!wbxml_strtbl_add_element(encoder, elt, &index, &added)))
     {
         wbxml_strtbl_element_destroy(elt);
@@ -2614,17 +3504,19 @@ static WBXMLError wbxml_encode_tableref(WBXMLEncoder *encoder, WB_ULONG offset)
 
 /**
  * @brief Create a WBXMLValueElement structure
+ * @param allocator The Allocator of the element
  * @return The newly created WBXMLValueElement structure, or NULL if not enough memory
  */
-static WBXMLValueElement *wbxml_value_element_create(void)
+static WBXMLValueElement *wbxml_value_element_create(WBXMLAllocator *allocator)
 {
     WBXMLValueElement *elt = NULL;
 
-    if ((elt = wbxml_malloc(sizeof(WBXMLValueElement))) == NULL)
+    if ((elt = wbxml_mem_malloc(allocator, sizeof(WBXMLValueElement))) == NULL)
         return NULL;
 
     elt->type = WBXML_VALUE_ELEMENT_STRING;
     elt->u.str = NULL;
+    elt->allocator = allocator;
 
     return elt;
 }
@@ -2651,7 +3543,7 @@ static void wbxml_value_element_destroy(WBXMLValueElement *elt)
         break;
     }
 
-    wbxml_free((void*) elt);
+    wbxml_mem_free(elt->allocator, (void*) elt);
 }
 
 
@@ -2695,24 +3587,24 @@ static WBXMLError wbxml_encode_tree(WBXMLEncoder *encoder, WBXMLTree *tree)
 
     /* Add WBXML_OPAQUE */
     if (!wbxml_buffer_append_char(encoder->output, WBXML_OPAQUE)) {
-        wbxml_free(wbxml);
+        wbxml_mem_free(encoder->allocator, wbxml);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
     /* Add Length */
     if (!wbxml_buffer_append_mb_uint_32(encoder->output, wbxml_len)) {
-        wbxml_free(wbxml);
+        wbxml_mem_free(encoder->allocator, wbxml);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
     /* Append wbxml to output */
     if (!wbxml_buffer_append_data(encoder->output, wbxml, wbxml_len)) {
-        wbxml_free(wbxml);
+        wbxml_mem_free(encoder->allocator, wbxml);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
     /* Clean-up */
-    wbxml_free(wbxml);
+    wbxml_mem_free(encoder->allocator, wbxml);
 
     return WBXML_OK;
 }
@@ -2743,7 +3635,7 @@ static WBXMLError wbxml_encode_datetime(WBXMLEncoder *encoder, WB_UTINY *buffer)
     WBXMLError ret = WBXML_OK;
 
 
-    if ((tmp = wbxml_buffer_create_from_cstr(buffer)) == NULL)
+    if ((tmp = wbxml_buffer_create_with_allocator(encoder->allocator, (const WB_UTINY *) buffer, WBXML_STRLEN(buffer), WBXML_STRLEN(buffer))) == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
     /* Remove non-digit characters */
@@ -3133,7 +4025,7 @@ static WBXMLError wbxml_encode_wv_datetime_inline(WBXMLEncoder *encoder, WB_UTIN
     WBXMLBuffer *tmp = NULL;
 
     /* Create temp Buffer */
-    if ((tmp = wbxml_buffer_create_from_cstr(buffer)) == NULL) {
+    if ((tmp = wbxml_buffer_create_with_allocator(encoder->allocator, (const WB_UTINY *) buffer, WBXML_STRLEN(buffer), WBXML_STRLEN(buffer))) == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
@@ -3190,7 +4082,7 @@ static WBXMLError wbxml_encode_wv_datetime_opaque(WBXMLEncoder *encoder, WB_UTIN
     len = WBXML_STRLEN(buffer);
 
     /* Create temp Buffer */
-    if ((tmp = wbxml_buffer_create_from_cstr(buffer)) == NULL) {
+    if ((tmp = wbxml_buffer_create_with_allocator(encoder->allocator, (const WB_UTINY *) buffer, WBXML_STRLEN(buffer), WBXML_STRLEN(buffer))) == NULL) {
         ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
         goto error;
     }
@@ -3561,21 +4453,24 @@ static WBXMLError wbxml_encode_ota_nokia_icon(WBXMLEncoder *encoder, WB_UTINY *b
 
 /**
  * @brief Create a String Table element
+ * @param allocator The Allocator of the element
  * @param string The WBXMLBuffer containing the String
  * @param is_stat If set to TRUE, this Buffer won't be destroyed in wbxml_strtbl_element_destroy() function
  * @return The newly created String Table Element, or NULL if not enough memory
  */
-static WBXMLStringTableElement *wbxml_strtbl_element_create(WBXMLBuffer *string, WB_BOOL is_stat)
+static WBXMLStringTableElement *wbxml_strtbl_element_create(WBXMLAllocator *allocator, WBXMLBuffer *string, WB_BOOL is_stat)
 {
     WBXMLStringTableElement *elt = NULL;
 
-    if ((elt = wbxml_malloc(sizeof(WBXMLStringTableElement))) == NULL)
+    if ((elt = wbxml_mem_malloc(allocator, sizeof(WBXMLStringTableElement))) == NULL)
         return NULL;
 
     elt->string = string;
     elt->offset = 0;
     elt->count = 0;
     elt->stat = is_stat;
+    elt->shared = FALSE;
+    elt->allocator = allocator;
 
     return elt;
 }
@@ -3593,7 +4488,7 @@ static void wbxml_strtbl_element_destroy(WBXMLStringTableElement *element)
     if (!element->stat)
         wbxml_buffer_destroy(element->string);
 
-    wbxml_free(element);
+    wbxml_mem_free(element->allocator, element);
 }
 
 
@@ -3615,9 +4510,13 @@ static void wbxml_strtbl_element_destroy_item(void *element)
 static WBXMLError wbxml_strtbl_initialize(WBXMLEncoder *encoder, WBXMLTreeNode *root)
 {
     WBXMLList *strings = NULL, *one_ref = NULL;
-    WBXMLError ret;
+    WBXMLError ret = WBXML_OK;
+
+    /* Choose Strings by bytes saved */
+    if (encoder->optimal_strtbl)
+        return wbxml_strtbl_optimize(encoder, root);
 
-    if ((strings = wbxml_list_create()) == NULL)
+    if ((strings = wbxml_list_create_with_allocator(encoder->allocator)) == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
     /* Collect all Strings:
@@ -3678,8 +4577,8 @@ static void wbxml_strtbl_collect_strings(WBXMLEncoder *encoder, WBXMLTreeNode *n
     switch (node->type)
     {
         case WBXML_TREE_TEXT_NODE:
-            /* Ignore blank nodes */
-            if (wbxml_buffer_contains_only_whitespaces(node->content))
+            /* Ignore blank nodes, and Slots */
+            if (wbxml_buffer_contains_only_whitespaces(node->content) || encoder_find_slot(encoder, node, &i))
                 break;
 
             /** @todo Shrink / Strip Blanks */
@@ -3812,6 +4711,10 @@ static WBXMLError wbxml_strtbl_construct(WBXMLBuffer *buff, WBXMLList *strstbl)
     {
         if ((elt = wbxml_list_get(strstbl, i)) == NULL)
             continue;
+
+        /* Stored at the end of another String */
+        if (elt->shared)
+            continue;
         
         if (!wbxml_buffer_append(buff, elt->string))
             return WBXML_ERROR_ENCODER_APPEND_DATA;
@@ -3837,9 +4740,9 @@ static WBXMLError wbxml_strtbl_construct(WBXMLBuffer *buff, WBXMLList *strstbl)
 static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList **strings, WBXMLList **one_ref, WB_BOOL stat_buff)
 {
     WBXMLList *referenced = NULL, *result = NULL;
+    WBXMLStrtblIndex *seen = NULL;
     WBXMLBuffer *string = NULL;
     WBXMLStringTableElement *ref = NULL;
-    WB_ULONG j = 0;
     WB_BOOL added = FALSE;
 
     if ((strings == NULL) || (one_ref == NULL))
@@ -3848,8 +4751,14 @@ static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList
     *one_ref = NULL;
 
     /* Create list of String References */
-    if ((referenced = wbxml_list_create()) == NULL)
+    if ((referenced = wbxml_list_create_with_allocator(encoder->allocator)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    /* Create index of String References (so that each String is only hashed once) */
+    if ((seen = wbxml_strtbl_index_create(encoder->allocator)) == NULL) {
+        wbxml_list_destroy(referenced, NULL);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
 
 
     /*********************
@@ -3861,65 +4770,64 @@ static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList
         string = (WBXMLBuffer *) wbxml_list_extract_first(*strings);
 
         /* Check if we have already found this String */
-        for (j = 0; j < wbxml_list_len(referenced); j++)
+        if ((ref = wbxml_strtbl_index_get(seen, string)) != NULL)
         {
-            ref = (WBXMLStringTableElement *) wbxml_list_get(referenced, j);
-            if (ref == NULL) 
-            {
-                /* There is a bug inside wbxml_strtbl_check_references.
-                   wbxml_list must be used in a wrong way.
-                 */
-            	if (!stat_buff)
-                    wbxml_buffer_destroy(string);
-                string = NULL;
-                wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
-                return WBXML_ERROR_INTERNAL;
-            }
-
-            if (wbxml_buffer_compare(ref->string, string) == 0)
-            {
-                if (!stat_buff)
-                    wbxml_buffer_destroy(string);
+            if (!stat_buff)
+                wbxml_buffer_destroy(string);
 
-                string = NULL;
-                ref->count++;
-                break;
-            }
+            ref->count++;
+            continue;
         }
 
-        if (string != NULL)
+        /* New Reference Element */
+        if ((ref = wbxml_strtbl_element_create(encoder->allocator, string, stat_buff)) == NULL)
         {
-            /* New Reference Element */
-            if ((ref = wbxml_strtbl_element_create(string, stat_buff)) == NULL)
-            {
-                wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
+            wbxml_strtbl_index_destroy(seen);
+            wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
 
-                if (!stat_buff)
-                    wbxml_list_destroy(*strings, wbxml_buffer_destroy_item);
-                else
-                    wbxml_list_destroy(*strings, NULL);
+            if (!stat_buff)
+                wbxml_list_destroy(*strings, wbxml_buffer_destroy_item);
+            else
+                wbxml_list_destroy(*strings, NULL);
 
-                *strings = NULL;
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-            }
+            *strings = NULL;
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
 
-            ref->count++;
+        if (!wbxml_list_append(referenced, (void *) ref))
+        {
+            wbxml_strtbl_element_destroy(ref);
+            wbxml_strtbl_index_destroy(seen);
+            wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
 
-            if (!wbxml_list_append(referenced, (void *) ref))
-            {
-                wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
+            if (!stat_buff)
+                wbxml_list_destroy(*strings, wbxml_buffer_destroy_item);
+            else
+                wbxml_list_destroy(*strings, NULL);
 
-                if (!stat_buff)
-                    wbxml_list_destroy(*strings, wbxml_buffer_destroy_item);
-                else
-                    wbxml_list_destroy(*strings, NULL);
+            *strings = NULL;
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
 
-                *strings = NULL;
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-            }
+        /* 'ref' is now owned by 'referenced' list */
+        if (!wbxml_strtbl_index_add(seen, ref))
+        {
+            wbxml_strtbl_index_destroy(seen);
+            wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
+
+            if (!stat_buff)
+                wbxml_list_destroy(*strings, wbxml_buffer_destroy_item);
+            else
+                wbxml_list_destroy(*strings, NULL);
+
+            *strings = NULL;
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
+
+        ref->count++;
     }
 
+    wbxml_strtbl_index_destroy(seen);
 
     wbxml_list_destroy(*strings, NULL);
     *strings = NULL;
@@ -3929,7 +4837,7 @@ static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList
      * Remove Strings that have only One reference
      */
 
-    if ((result = wbxml_list_create()) == NULL) {
+    if ((result = wbxml_list_create_with_allocator(encoder->allocator)) == NULL) {
         wbxml_list_destroy(referenced, wbxml_strtbl_element_destroy_item);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
@@ -3980,714 +4888,2343 @@ static WBXMLError wbxml_strtbl_check_references(WBXMLEncoder *encoder, WBXMLList
 static WB_BOOL wbxml_strtbl_add_element(WBXMLEncoder *encoder, WBXMLStringTableElement *elt, WB_ULONG *index, WB_BOOL *added)
 {
     WBXMLStringTableElement *elt_tmp = NULL;
-    WB_ULONG i = 0;
 
     if ((encoder == NULL) || (encoder->strstbl == NULL) || (elt == NULL) || (elt->string == NULL))
         return FALSE;
 
     *added = FALSE;
 
-    /* Check if this element already exists in String Table */
-    for (i = 0; i < wbxml_list_len(encoder->strstbl); i++)
+    /* Create String Table index */
+    if ((encoder->strstbl_index == NULL) &&
+        ((encoder->strstbl_index = wbxml_strtbl_index_create(encoder->allocator)) == NULL))
     {
-        if ((elt_tmp = wbxml_list_get(encoder->strstbl, i)) == NULL)
-            continue;
+        return FALSE;
+    }
 
-        if ((wbxml_buffer_len(elt_tmp->string) == wbxml_buffer_len(elt->string)) &&
-            (wbxml_buffer_compare(elt_tmp->string, elt->string) == 0))
-        {
-            /* The String already exists in the String Table */
-            if (index != NULL)
-                *index = elt_tmp->offset;
-            return TRUE;
-        }
+    /* Create String Table matcher (if this fails, it will be rebuilt when needed) */
+    if ((encoder->strstbl_matcher == NULL) && (wbxml_list_len(encoder->strstbl) == 0))
+        encoder->strstbl_matcher = wbxml_matcher_create_with_allocator(encoder->allocator);
+
+    /* Check if this element already exists in String Table */
+    if ((elt_tmp = wbxml_strtbl_index_get(encoder->strstbl_index, elt->string)) != NULL)
+    {
+        /* The String already exists in the String Table */
+        if (index != NULL)
+            *index = elt_tmp->offset;
+        return TRUE;
     }
 
-    /* Add this string to String Table */
-    elt->offset = encoder->strstbl_len;
+    /* Add this string to String Table (unless it is stored at the end of another one) */
+    if (!elt->shared)
+        elt->offset = encoder->strstbl_len;
+
+    /* Make room in index first, so that indexing can't fail once the element is in String Table */
+    if (!wbxml_strtbl_index_grow(encoder->strstbl_index))
+        return FALSE;
 
     if (!wbxml_list_append(encoder->strstbl, (void *) elt))
         return FALSE;
 
+    wbxml_strtbl_index_add(encoder->strstbl_index, elt);
+
+    /* Element is in String Table: if matcher can't follow, drop it so that it is rebuilt when needed */
+    if ((encoder->strstbl_matcher != NULL) &&
+        !wbxml_matcher_add(encoder->strstbl_matcher, wbxml_buffer_get_cstr(elt->string), wbxml_buffer_len(elt->string), elt->offset))
+    {
+        wbxml_matcher_destroy(encoder->strstbl_matcher);
+        encoder->strstbl_matcher = NULL;
+    }
+
     /* Index in String Table */
     if (index != NULL)
-        *index = encoder->strstbl_len;
+        *index = elt->offset;
 
     /* New String Table length */
-    encoder->strstbl_len += wbxml_buffer_len(elt->string) + 1;
+    if (!elt->shared)
+        encoder->strstbl_len += wbxml_buffer_len(elt->string) + 1;
 
     *added = TRUE;
 
     return TRUE;
 }
 
-#endif /* WBXML_ENCODER_USE_STRTBL */
-
-
-/*****************************************
- *  XML Output Functions
- */
-
-/****************************
- * Build XML Result
- */
 
 /**
- * @brief Build XML Result
- * @param encoder [in] The WBXML Encoder
- * @param xml     [out] Resulting XML document
- * @param xml_len [out] XML document length
- * @return WBXML_OK if built is OK, an error code otherwise
+ * @brief Get the Matcher of String Table content
+ * @param encoder The WBXML Encoder
+ * @return The compiled Matcher, or NULL if not enough memory
+ * @note The Matcher is kept in sync by wbxml_strtbl_add_element(). Each Pattern value is the
+ *       offset of its String in String Table.
  */
-static WBXMLError xml_build_result(WBXMLEncoder *encoder, WB_UTINY **xml, WB_ULONG *xml_len)
+static const WBXMLMatcher *wbxml_strtbl_get_matcher(WBXMLEncoder *encoder)
 {
-    WBXMLBuffer *header = NULL;
-    WB_ULONG     len    = 0;
-    WBXMLError   ret    = WBXML_OK;
+    WBXMLStringTableElement *elt = NULL;
+    WB_ULONG i = 0;
 
-    if (xml == NULL)
-        return WBXML_ERROR_BAD_PARAMETER;
-    
-    /* Init */
-    if (xml_len != NULL)
-        *xml_len = 0;
-    
-    if (encoder->flow_mode == TRUE) {
-        /* Header already built */
-        header = encoder->output_header;
-    }
-    else {
-        /* Create Header Buffer */
-        if ((header = wbxml_buffer_create("", 0, WBXML_ENCODER_XML_HEADER_MALLOC_BLOCK)) == NULL)
-            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    /* Rebuild Matcher, if it could not follow String Table */
+    if (encoder->strstbl_matcher == NULL) {
+        if ((encoder->strstbl_matcher = wbxml_matcher_create_with_allocator(encoder->allocator)) == NULL)
+            return NULL;
 
-        /* Fill Header Buffer */
-        if (encoder->xml_encode_header) {
-            if ((ret = xml_fill_header(encoder, header)) != WBXML_OK) {
-                wbxml_buffer_destroy(header);
-                return ret;
+        for (i = 0; i < wbxml_list_len(encoder->strstbl); i++) {
+            if ((elt = (WBXMLStringTableElement *) wbxml_list_get(encoder->strstbl, i)) == NULL)
+                continue;
+
+            if (!wbxml_matcher_add(encoder->strstbl_matcher, wbxml_buffer_get_cstr(elt->string), wbxml_buffer_len(elt->string), elt->offset)) {
+                wbxml_matcher_destroy(encoder->strstbl_matcher);
+                encoder->strstbl_matcher = NULL;
+                return NULL;
             }
         }
     }
 
-    /* Result Buffer Length */
-    len = wbxml_buffer_len(header) + wbxml_buffer_len(encoder->output);
+    /* Compile new Strings */
+    if (!wbxml_matcher_compile(encoder->strstbl_matcher))
+        return NULL;
 
-    /* Create Result Buffer */
-    *xml = wbxml_malloc((len + 1) * sizeof(WB_UTINY));
-    if (*xml == NULL) {
-        if (encoder->flow_mode == FALSE)
-            wbxml_buffer_destroy(header);
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    return encoder->strstbl_matcher;
+}
+
+
+/** Initial number of slots of a String Table index (must be a power of 2) */
+#define WBXML_STRTBL_INDEX_INIT_SIZE 64
+
+/**
+ * @brief Hash a String (FNV-1a)
+ * @param string The String to hash
+ * @return The hash value
+ */
+static WB_ULONG wbxml_strtbl_index_hash(WBXMLBuffer *string)
+{
+    const WB_UTINY *data = wbxml_buffer_get_cstr(string);
+    WB_ULONG len = wbxml_buffer_len(string);
+    WB_ULONG hash = 2166136261UL;
+    WB_ULONG i = 0;
+
+    for (i = 0; i < len; i++) {
+        hash ^= data[i];
+        hash *= 16777619UL;
     }
 
-    /** @todo Use the 'output_charset' field */
+    return hash;
+}
 
-    /* Copy Header to Result */
-    memcpy(*xml, wbxml_buffer_get_cstr(header), wbxml_buffer_len(header));
 
-    /* Copy XML Document to Result */
-    memcpy(*xml + wbxml_buffer_len(header), wbxml_buffer_get_cstr(encoder->output), wbxml_buffer_len(encoder->output));
+/**
+ * @brief Create a String Table index
+ * @param allocator The Allocator of the index
+ * @return The new index, or NULL if not enough memory
+ */
+static WBXMLStrtblIndex *wbxml_strtbl_index_create(WBXMLAllocator *allocator)
+{
+    WBXMLStrtblIndex *hindex = NULL;
 
-    /** @todo Remove this NULL char if not needed by charset */
+    if ((hindex = wbxml_mem_malloc(allocator, sizeof(WBXMLStrtblIndex))) == NULL)
+        return NULL;
 
-    /* NULL Terminated Buffer */
-    (*xml)[len] = '\0';
+    if ((hindex->slots = wbxml_mem_malloc(allocator, WBXML_STRTBL_INDEX_INIT_SIZE * sizeof(WBXMLStringTableElement *))) == NULL) {
+        wbxml_mem_free(allocator, hindex);
+        return NULL;
+    }
 
-    /* Set length */
-    if (xml_len != NULL)
-        *xml_len = len;
+    memset(hindex->slots, 0, WBXML_STRTBL_INDEX_INIT_SIZE * sizeof(WBXMLStringTableElement *));
+    hindex->size = WBXML_STRTBL_INDEX_INIT_SIZE;
+    hindex->count = 0;
+    hindex->allocator = allocator;
 
-    /* Clean-up */
-    if (encoder->flow_mode == FALSE)
-        wbxml_buffer_destroy(header);
+    return hindex;
+}
 
-    return WBXML_OK;
+
+/**
+ * @brief Destroy a String Table index
+ * @param hindex The index to destroy
+ * @note Indexed elements are not destroyed
+ */
+static void wbxml_strtbl_index_destroy(WBXMLStrtblIndex *hindex)
+{
+    if (hindex == NULL)
+        return;
+
+    wbxml_mem_free(hindex->allocator, hindex->slots);
+    wbxml_mem_free(hindex->allocator, hindex);
 }
 
 
 /**
- * @brief Fill the XML Header
- * @param encoder The WBXML Encoder
- * @param header The Buffer to Fill
- * @return WBXML_OK if built is OK, an error code otherwise
+ * @brief Get the element indexed with a String
+ * @param hindex The index
+ * @param string The String to search
+ * @return The element whose String is equal to 'string', or NULL if not found
  */
-static WBXMLError xml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header)
+static WBXMLStringTableElement *wbxml_strtbl_index_get(WBXMLStrtblIndex *hindex, WBXMLBuffer *string)
 {
-    if ((encoder == NULL) || (header == NULL))
-        return WBXML_ERROR_BAD_PARAMETER;
+    WBXMLStringTableElement *elt = NULL;
+    WB_ULONG i = 0;
 
-    /** @todo Add 'encoding' info */
+    if ((hindex == NULL) || (string == NULL))
+        return NULL;
 
-    /* <?xml version=\"1.0\"?> */
-    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_HEADER))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    i = wbxml_strtbl_index_hash(string) & (hindex->size - 1);
 
-    /* New Line */
-    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
-        if (!xml_encode_new_line(header))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    while ((elt = hindex->slots[i]) != NULL) {
+        if ((wbxml_buffer_len(elt->string) == wbxml_buffer_len(string)) &&
+            (wbxml_buffer_compare(elt->string, string) == 0))
+        {
+            return elt;
+        }
+
+        i = (i + 1) & (hindex->size - 1);
     }
 
-    /* <!DOCTYPE */
-    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_DOCTYPE))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    return NULL;
+}
 
-    /* Check that the language is set */
-    if (encoder->lang == NULL)
-        return WBXML_ERROR_LANG_TABLE_UNDEFINED;
 
-    /* Root Element */
-    if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlRootElt))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+/**
+ * @brief Make room in a String Table index for one more element
+ * @param hindex The index
+ * @return TRUE if there is room for one more element, FALSE if not enough memory
+ * @note Once this function succeeded, next call to wbxml_strtbl_index_add() can't fail
+ */
+static WB_BOOL wbxml_strtbl_index_grow(WBXMLStrtblIndex *hindex)
+{
+    WBXMLStringTableElement **slots = NULL;
+    WB_ULONG size = 0, i = 0, j = 0;
 
-    if (encoder->lang->publicID->xmlPublicID &&
-        WBXML_STRLEN(encoder->lang->publicID->xmlPublicID)) {
+    if (hindex == NULL)
+        return FALSE;
 
-        /*  PUBLIC " */
-        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_PUBLIC_START))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    /* Keep load factor under 1/2 */
+    if ((hindex->count + 1) * 2 <= hindex->size)
+        return TRUE;
 
-        /* Public ID */
-        if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlPublicID))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    size = hindex->size * 2;
 
-        /* " */
-        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_PUBLIC_END))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
-    } else {
-	/*  SYSTEM */
-        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_SYSTEM))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
-    }
+    if ((slots = wbxml_mem_malloc(hindex->allocator, size * sizeof(WBXMLStringTableElement *))) == NULL)
+        return FALSE;
 
-    /* DTD */
-    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_DTD))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    memset(slots, 0, size * sizeof(WBXMLStringTableElement *));
 
-    /* DTD */
-    if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlDTD))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    for (i = 0; i < hindex->size; i++) {
+        if (hindex->slots[i] == NULL)
+            continue;
 
-    /* "> */
-    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_END_DTD))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+        j = wbxml_strtbl_index_hash(hindex->slots[i]->string) & (size - 1);
+        while (slots[j] != NULL)
+            j = (j + 1) & (size - 1);
 
-    /* New Line */
-    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
-        if (!xml_encode_new_line(header))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+        slots[j] = hindex->slots[i];
     }
 
-    return WBXML_OK;
+    wbxml_mem_free(hindex->allocator, hindex->slots);
+    hindex->slots = slots;
+    hindex->size = size;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Add an element to a String Table index
+ * @param hindex The index
+ * @param elt    The element to add (its String must not already be indexed)
+ * @return TRUE if added, FALSE if not enough memory
+ */
+static WB_BOOL wbxml_strtbl_index_add(WBXMLStrtblIndex *hindex, WBXMLStringTableElement *elt)
+{
+    WB_ULONG i = 0;
+
+    if ((hindex == NULL) || (elt == NULL) || (elt->string == NULL))
+        return FALSE;
+
+    if (!wbxml_strtbl_index_grow(hindex))
+        return FALSE;
+
+    i = wbxml_strtbl_index_hash(elt->string) & (hindex->size - 1);
+    while (hindex->slots[i] != NULL)
+        i = (i + 1) & (hindex->size - 1);
+
+    hindex->slots[i] = elt;
+    hindex->count++;
+
+    return TRUE;
 }
 
 
 /****************************
- * XML Encoding Functions
+ * Optimal String Table
  */
 
+/** Initial size of the Buffer where Strings are collected by wbxml_strtbl_optimize() */
+#define WBXML_STRTBL_OPT_MALLOC_BLOCK 1024
+
+/** Longest pattern of a run that is not taken as a candidate by wbxml_strtbl_optimize() */
+#define WBXML_STRTBL_OPT_RUN_PERIOD 8
+
+/** Rank of suffix at 'i' in wbxml_strtbl_suffix_array(), plus one (0 if this is past end of text) */
+#define WBXML_STRTBL_RANK_AT(rank, len, i) (((i) < (len)) ? (rank)[i] + 1 : 0)
+
 /**
- * @brief Encode an XML Tag
+ * @brief Fill String Table with the Strings that save the most bytes
  * @param encoder The WBXML Encoder
- * @param node The element to encode
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @param root The root element of WBXML Tree
+ * @return WBXML_OK if no error, another error code otherwise
+ * @note Strings are collected as they are encoded without String Table (cf wbxml_strtbl_collect_inline_strings()).
+ *       Every String found more than once in collected Strings is a candidate: they are the intervals
+ *       of the Suffix Array of collected Strings. The candidate that saves the most bytes, given the
+ *       ones already chosen, is chosen first. Bytes saved are the inline bytes replaced by 'STR_T index'
+ *       references (mb_u_int32 index length included), minus the bytes added to String Table.
+ *       A String that ends a String already in String Table is not stored again: it is referenced
+ *       inside the other one. And a String stored on its own that ends the chosen one is moved into it.
+ * @note Strings are added to String Table in the order they are chosen, which is the priority they
+ *       are given when searching references (cf wbxml_matcher_select()). So references are found
+ *       in the same way bytes saved are computed, only index lengths are estimated.
  */
-static WBXMLError xml_encode_tag(WBXMLEncoder *encoder, WBXMLTreeNode *node)
+static WBXMLError wbxml_strtbl_optimize(WBXMLEncoder *encoder, WBXMLTreeNode *root)
 {
-    const WB_TINY *ns = NULL;
-    WB_UTINY i;
+    WBXMLStrtblOptimizer opt;
+    WBXMLStrtblCandidate *candidates = NULL, *cand = NULL;
+    WBXMLStrtblHeapItem *heap = NULL, top;
+    WBXMLStrtblChoice *choice = NULL;
+    WBXMLStringTableElement *elt = NULL;
+    WBXMLBuffer *text = NULL, *string = NULL;
+    WB_ULONG *rank = NULL, *lcp = NULL;
+    WB_ULONG nb_candidates = 0, nb_heap = 0, i = 0, len = 0;
+    WB_ULONG index_len = 0, storage = 0, host = 0, absorbed = 0;
+    WB_LONG score = 0;
+    WB_BOOL added = FALSE;
+    WBXMLError ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-    /* Set as current Tag */
-    if (node->name->type == WBXML_VALUE_TOKEN)
-        encoder->current_tag = node->name->u.token;
-    else
-        encoder->current_tag = NULL;
+    memset(&opt, 0, sizeof(WBXMLStrtblOptimizer));
 
-    /* Indent */
-    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
-        for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
-            if (!wbxml_buffer_append_char(encoder->output, ' '))
-                return WBXML_ERROR_ENCODER_APPEND_DATA;
-        }
+    /* Inline Strings, each one followed by a NULL char */
+    if ((text = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_STRTBL_OPT_MALLOC_BLOCK)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    if ((ret = wbxml_strtbl_collect_inline_strings(encoder, root, text)) != WBXML_OK) {
+        wbxml_buffer_destroy(text);
+        return ret;
     }
 
-    /* Append < */
-    if (!wbxml_buffer_append_char(encoder->output, '<'))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-    /* Append Element Name */
-    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_tag_get_xml_name(node->name)))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    opt.text = wbxml_buffer_get_cstr(text);
+    opt.len = wbxml_buffer_len(text);
 
-    /* NameSpace handling: Check if Current Node Code Page is different than Parent Node Code Page */
-    if ((encoder->lang->nsTable != NULL) &&
-        ((node->parent == NULL) ||
-         ((node->parent->type == WBXML_TREE_ELEMENT_NODE) &&
-          (node->parent->name->type == WBXML_VALUE_TOKEN) &&
-          (node->type == WBXML_TREE_ELEMENT_NODE) &&
-          (node->name->type == WBXML_VALUE_TOKEN) &&
-          (node->parent->name->u.token->wbxmlCodePage != node->name->u.token->wbxmlCodePage))))
+    if (opt.len == 0) {
+        ret = WBXML_OK;
+        goto cleanup;
+    }
+
+    /* Find candidates */
+    if (((opt.sa = wbxml_mem_malloc(encoder->allocator, opt.len * sizeof(WB_ULONG))) == NULL) ||
+        ((rank = wbxml_mem_malloc(encoder->allocator, opt.len * sizeof(WB_ULONG))) == NULL) ||
+        ((lcp = wbxml_mem_malloc(encoder->allocator, opt.len * sizeof(WB_ULONG))) == NULL) ||
+        !wbxml_strtbl_suffix_array(encoder->allocator, opt.text, opt.len, opt.sa, rank))
     {
-        if ((ns = wbxml_tables_get_xmlns(encoder->lang->nsTable, node->name->u.token->wbxmlCodePage)) != NULL)
-        {
-            /* Append xmlns=" */
-            if (!wbxml_buffer_append_cstr(encoder->output, " xmlns=\""))
-                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        goto cleanup;
+    }
 
-            /* Append NameSpace */
-            if (!wbxml_buffer_append_cstr(encoder->output, ns))
-                return WBXML_ERROR_ENCODER_APPEND_DATA;
+    wbxml_strtbl_lcp(opt.text, opt.len, opt.sa, rank, lcp);
 
-            /* Append " */
-            if (!wbxml_buffer_append_char(encoder->output, '"'))
-                return WBXML_ERROR_ENCODER_APPEND_DATA;
-        }
+    wbxml_mem_free(encoder->allocator, rank);
+    rank = NULL;
+
+    if ((candidates = wbxml_strtbl_candidates(encoder->allocator, lcp, opt.len, &nb_candidates)) == NULL)
+        goto cleanup;
+
+    wbxml_mem_free(encoder->allocator, lcp);
+    lcp = NULL;
+
+    if (((opt.covered = wbxml_mem_malloc(encoder->allocator, opt.len)) == NULL) ||
+        ((opt.positions = wbxml_mem_malloc(encoder->allocator, opt.len * sizeof(WB_ULONG))) == NULL) ||
+        ((opt.choices = wbxml_mem_malloc(encoder->allocator, (nb_candidates + 1) * sizeof(WBXMLStrtblChoice))) == NULL) ||
+        ((heap = wbxml_mem_malloc(encoder->allocator, (nb_candidates + 1) * sizeof(WBXMLStrtblHeapItem))) == NULL))
+    {
+        goto cleanup;
     }
 
-    return WBXML_OK;
-}
+    /* NULL chars can't be referenced */
+    for (i = 0; i < opt.len; i++)
+        opt.covered[i] = (WB_UTINY) (opt.text[i] == WBXML_STR_END);
 
+    /* A candidate can't save more than its length, for each occurrence */
+    for (i = 0; i < nb_candidates; i++) {
+        if (wbxml_strtbl_opt_is_run(opt.text + opt.sa[candidates[i].lb], candidates[i].len))
+            continue;
 
-/**
- * @brief Encode an XML End Tag
- * @param encoder The WBXML Encoder
- * @param node Tag
- * @return WBXML_OK if encoding is OK, an error code otherwise
- */
-static WBXMLError xml_encode_end_tag(WBXMLEncoder *encoder, WBXMLTreeNode *node)
-{
-    WB_UTINY i;
+        wbxml_strtbl_heap_push(heap, &nb_heap, (WB_LONG) ((candidates[i].rb - candidates[i].lb + 1) * candidates[i].len), i);
+    }
 
-    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+    /* Choose candidates */
+    while (nb_heap > 0) {
+        wbxml_strtbl_heap_pop(heap, &nb_heap, &top);
+        cand = &candidates[top.candidate];
 
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
-        if (wbxml_tree_node_have_child_elt(node)) {
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
+        /* Bytes saved now, in document body... */
+        index_len = wbxml_strtbl_mb_uint_32_len(encoder->strstbl_len + opt.table_len);
+        score = wbxml_strtbl_opt_references(&opt, cand, index_len, FALSE);
 
-            /* Add a New Line if there were content in this element */
-            if (encoder->in_content) {
-                if (!xml_encode_new_line(encoder->output))
-                    return WBXML_ERROR_ENCODER_APPEND_DATA;
-            }
+        if (score <= 0)
+            continue;
+
+        if ((nb_heap > 0) && (score < heap[0].score)) {
+            wbxml_strtbl_heap_push(heap, &nb_heap, score, top.candidate);
+            continue;
+        }
 
-            encoder->indent--;
+        /* ... minus bytes added to String Table */
+        storage = wbxml_strtbl_opt_storage(&opt, opt.text + opt.sa[cand->lb], cand->len, &host, &absorbed);
+        score -= (WB_LONG) storage;
 
-            /* Indent End Element */
-            for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
-                if (!wbxml_buffer_append_char(encoder->output, ' '))
-                    return WBXML_ERROR_ENCODER_APPEND_DATA;
+        if (score <= 0)
+            continue;
+
+        /* Another candidate may save more */
+        if ((nb_heap > 0) && (score < heap[0].score)) {
+            wbxml_strtbl_heap_push(heap, &nb_heap, score, top.candidate);
+            continue;
+        }
+
+        wbxml_strtbl_opt_references(&opt, cand, index_len, TRUE);
+
+        choice = &opt.choices[opt.nb_choices];
+        choice->data = opt.text + opt.sa[cand->lb];
+        choice->len = cand->len;
+        choice->host = (host < opt.nb_choices) ? host : opt.nb_choices;
+        choice->offset = 0;
+
+        if (absorbed < opt.nb_choices) {
+            for (i = 0; i < opt.nb_choices; i++) {
+                if (opt.choices[i].host == absorbed)
+                    opt.choices[i].host = opt.nb_choices;
             }
+        }
 
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
+        opt.table_len += storage;
+        opt.nb_choices++;
+    }
+
+    /* Strings stored on their own follow each other, others are at their end */
+    len = encoder->strstbl_len;
+
+    for (i = 0; i < opt.nb_choices; i++) {
+        if (opt.choices[i].host == i) {
+            opt.choices[i].offset = len;
+            len += opt.choices[i].len + 1;
         }
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
+    }
 
+    for (i = 0; i < opt.nb_choices; i++) {
+        choice = &opt.choices[i];
+        if (choice->host != i)
+            choice->offset = opt.choices[choice->host].offset + opt.choices[choice->host].len - choice->len;
     }
 
-    /* Append </ */
-    if (!wbxml_buffer_append_cstr(encoder->output, "</"))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    /* Add them to String Table, in the order they were chosen */
+    for (i = 0; i < opt.nb_choices; i++) {
+        choice = &opt.choices[i];
 
-    /* Append Element Name */
-    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_tag_get_xml_name(node->name)))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+        if (((string = wbxml_buffer_create_with_allocator(encoder->allocator, choice->data, choice->len, choice->len)) == NULL) ||
+            ((elt = wbxml_strtbl_element_create(encoder->allocator, string, FALSE)) == NULL))
+        {
+            wbxml_buffer_destroy(string);
+            goto cleanup;
+        }
 
-    /* Append > */
-    if (!wbxml_buffer_append_char(encoder->output, '>'))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+        elt->offset = choice->offset;
+        elt->shared = (WB_BOOL) (choice->host != i);
 
-    /* New Line */
-    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
-        if (!xml_encode_new_line(encoder->output))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+        WBXML_DEBUG((WBXML_ENCODER, "Strtbl - Choosing String: %s", wbxml_buffer_get_cstr(string)));
+
+        if (!wbxml_strtbl_add_element(encoder, elt, NULL, &added)) {
+            wbxml_strtbl_element_destroy(elt);
+            goto cleanup;
+        }
+
+        if (!added)
+            wbxml_strtbl_element_destroy(elt);
     }
 
-    /* No more in content */
-    encoder->in_content = FALSE;
+    ret = WBXML_OK;
 
-    return WBXML_OK;
+cleanup:
+    wbxml_mem_free(encoder->allocator, heap);
+    wbxml_mem_free(encoder->allocator, opt.choices);
+    wbxml_mem_free(encoder->allocator, opt.positions);
+    wbxml_mem_free(encoder->allocator, opt.covered);
+    wbxml_mem_free(encoder->allocator, candidates);
+    wbxml_mem_free(encoder->allocator, lcp);
+    wbxml_mem_free(encoder->allocator, rank);
+    wbxml_mem_free(encoder->allocator, opt.sa);
+    wbxml_buffer_destroy(text);
+
+    return ret;
 }
 
 
 /**
- * @brief Encode a XML Attribute
- * @param encoder [in] The WBXML Encoder
- * @param attribute [in] The Attribute to encode
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Collect the inline Strings of a document, as they are encoded without String Table
+ * @param encoder The WBXML Encoder
+ * @param root The root element of WBXML Tree
+ * @param text [out] The Buffer where Strings are appended, each one followed by a NULL char
+ * @return WBXML_OK if no error, another error code otherwise
+ * @note The document is encoded by another Encoder with the same options (and its output dropped), so
+ *       that text encoded as Opaque, Extension or Attribute Value Tokens is not collected.
  */
-static WBXMLError xml_encode_attr(WBXMLEncoder *encoder, WBXMLAttribute *attribute)
+static WBXMLError wbxml_strtbl_collect_inline_strings(WBXMLEncoder *encoder, WBXMLTreeNode *root, WBXMLBuffer *text)
 {
-    /* Append a space */
-    if (!wbxml_buffer_append_char(encoder->output, ' '))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
-
-    /* Append Attribute Name */
-    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_attribute_get_xml_name(attribute)))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
-
-    /* Append =" */
-    if (!wbxml_buffer_append_cstr(encoder->output, "=\""))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    WBXMLEncoder *collector = NULL;
+    WBXMLError ret = WBXML_OK;
 
-    if (wbxml_attribute_get_xml_value(attribute) != NULL) {
-        /* Fix Attribute Value text */
-        WBXMLBuffer *tmp = NULL;
+    if ((collector = encoder_duplicate(encoder)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-        /* Work with a temporary copy */
-        if ((tmp = wbxml_buffer_create_from_cstr(wbxml_attribute_get_xml_value(attribute))) == NULL)
-            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    collector->tree = encoder->tree;
+    collector->lang = encoder->lang;
+    collector->output_charset = encoder->output_charset;
+    collector->optimal_strtbl = FALSE;
+    collector->strstbl_text = text;
 
-        /* Fix text */
-        if (xml_encode_text_entities(encoder, tmp)) {
-            wbxml_buffer_destroy(tmp);
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
-        }
+    /* Slots are not collected */
+    collector->slots = encoder->slots;
+    collector->nb_slots = encoder->nb_slots;
 
-        wbxml_buffer_destroy(tmp);
-    }
+    if (!encoder_init_output(collector))
+        ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    else
+        ret = parse_node(collector, root, TRUE);
 
-    /* Append " */
-    if (!wbxml_buffer_append_char(encoder->output, '"'))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    wbxml_encoder_destroy(collector);
 
-    return WBXML_OK;
+    return ret;
 }
 
 
 /**
- * @brief Encode a End of XML Attributes List
- * @param encoder [in] The WBXML Encoder
- * @param node    [in] Current node
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Build the Suffix Array of a text (prefix doubling, with radix sorts)
+ * @param allocator The Allocator of temporary memory
+ * @param text The text
+ * @param len  Text length (not 0)
+ * @param sa   [out] Positions of suffixes, in lexicographic order
+ * @param rank [out] Position of each suffix in 'sa'
+ * @return TRUE if built, FALSE if not enough memory
+ * @note Each NULL char is sorted as a distinct char (before any other one), so that suffixes are
+ *       only compared up to the end of their String: the number of passes depends on the length
+ *       of collected Strings, not on how many times they are repeated.
  */
-static WBXMLError xml_encode_end_attrs(WBXMLEncoder *encoder, WBXMLTreeNode *node)
+static WB_BOOL wbxml_strtbl_suffix_array(WBXMLAllocator *allocator, const WB_UTINY *text, WB_ULONG len, WB_ULONG *sa, WB_ULONG *rank)
 {
-#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+    WB_ULONG *tmp = NULL, *count = NULL;
+    WB_ULONG classes = 0, k = 0, i = 0, j = 0;
 
-    if (node->children == NULL) {
-        /* Append " />" */
-        if (!wbxml_buffer_append_cstr(encoder->output, "/>"))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    if (((tmp = wbxml_mem_malloc(allocator, len * sizeof(WB_ULONG))) == NULL) ||
+        ((count = wbxml_mem_malloc(allocator, (len + 257) * sizeof(WB_ULONG))) == NULL))
+    {
+        wbxml_mem_free(allocator, tmp);
+        return FALSE;
+    }
 
-        /* New Line */
-        if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
-            if (!xml_encode_new_line(encoder->output))
-                return WBXML_ERROR_ENCODER_APPEND_DATA;
-        }
+    for (i = 0; i < len; i++) {
+        if (text[i] == WBXML_STR_END)
+            classes++;
     }
-    else {
 
-#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
-            
-        /* Append > */
-        if (!wbxml_buffer_append_char(encoder->output, '>'))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    for (i = 0, j = 0; i < len; i++)
+        rank[i] = (text[i] == WBXML_STR_END) ? j++ : classes + text[i];
 
-        /* New Line */
-        if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+    classes += 256;
 
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
-            if (wbxml_tree_node_have_child_elt(node)) {
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
+    for (k = 1; ; k *= 2) {
+        /* Sort by rank of suffix at i + k... */
+        memset(count, 0, (classes + 1) * sizeof(WB_ULONG));
 
-                if (!xml_encode_new_line(encoder->output))
-                    return WBXML_ERROR_ENCODER_APPEND_DATA;
+        for (i = 0; i < len; i++)
+            count[WBXML_STRTBL_RANK_AT(rank, len, i + k)]++;
 
-                /* Increment indentation */
-                encoder->indent++;
+        for (i = 1; i <= classes; i++)
+            count[i] += count[i - 1];
 
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
-            }
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
+        for (i = len; i > 0; i--)
+            tmp[--count[WBXML_STRTBL_RANK_AT(rank, len, i - 1 + k)]] = i - 1;
+
+        /* ... then by rank of suffix at i (stable) */
+        memset(count, 0, (classes + 1) * sizeof(WB_ULONG));
+
+        for (i = 0; i < len; i++)
+            count[rank[i]]++;
+
+        for (i = 1; i <= classes; i++)
+            count[i] += count[i - 1];
 
+        for (j = len; j > 0; j--)
+            sa[--count[rank[tmp[j - 1]]]] = tmp[j - 1];
+
+        /* Suffixes with the same 2k first chars have the same rank */
+        tmp[sa[0]] = 0;
+
+        for (j = 1; j < len; j++) {
+            tmp[sa[j]] = tmp[sa[j - 1]];
+
+            if ((rank[sa[j]] != rank[sa[j - 1]]) ||
+                (WBXML_STRTBL_RANK_AT(rank, len, sa[j] + k) != WBXML_STRTBL_RANK_AT(rank, len, sa[j - 1] + k)))
+            {
+                tmp[sa[j]]++;
+            }
         }
 
-#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+        memcpy(rank, tmp, len * sizeof(WB_ULONG));
+        classes = rank[sa[len - 1]] + 1;
 
+        if (classes == len)
+            break;
     }
 
-#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
+    wbxml_mem_free(allocator, count);
+    wbxml_mem_free(allocator, tmp);
 
-    return WBXML_OK;
+    return TRUE;
 }
 
+
 /**
- * @brief Encode an XML Text
- * @param encoder The WBXML Encoder
- * @param node    The node containing XML Text to encode
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Compute the length of the prefix shared by each suffix of a Suffix Array and the previous one (Kasai)
+ * @param text The text
+ * @param len  Text length
+ * @param sa   Suffix Array of text
+ * @param rank Position of each suffix in 'sa'
+ * @param lcp  [out] Length of shared prefixes ('lcp[0]' is 0)
+ * @note Shared prefixes stop at NULL chars, so that a String never spans two collected Strings
  */
-static WBXMLError xml_encode_text(WBXMLEncoder *encoder, WBXMLTreeNode *node)
+static void wbxml_strtbl_lcp(const WB_UTINY *text, WB_ULONG len, const WB_ULONG *sa, const WB_ULONG *rank, WB_ULONG *lcp)
 {
-    WBXMLBuffer *str = node->content;
-    WBXMLBuffer *tmp = NULL;
-    WB_UTINY i = 0;
+    WB_ULONG i = 0, j = 0, h = 0;
 
-    if (encoder->in_cdata) {
-        /* If we are in a CDATA section, do not modify the text to encode */
-        if (!wbxml_buffer_append(encoder->output, str))
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    lcp[0] = 0;
+
+    for (i = 0; i < len; i++) {
+        if (rank[i] == 0) {
+            h = 0;
+            continue;
+        }
+
+        j = sa[rank[i] - 1];
+
+        while ((i + h < len) && (j + h < len) && (text[i + h] == text[j + h]) && (text[i + h] != WBXML_STR_END))
+            h++;
+
+        lcp[rank[i]] = h;
+
+        /* Next suffix shares at least h - 1 chars with the one before it */
+        if (h > 0)
+            h--;
     }
-    else {
-        /* Work with a temporary copy */
-        if ((tmp = wbxml_buffer_duplicate(str)) == NULL)
-            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+}
 
-        /* Indent */
-        if ((encoder->xml_gen_type == WBXML_GEN_XML_INDENT) &&
-            (!encoder->in_content))
-        {
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
-            if (wbxml_tree_node_have_child_elt(node)) {
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
 
-                /* Indent Content (only indent in first call to xml_encode_text()) */
-                for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
-                    if (!wbxml_buffer_append_char(encoder->output, ' ')) {
-                        wbxml_buffer_destroy(tmp);
-                        return WBXML_ERROR_ENCODER_APPEND_DATA;
-                    }
-                }
+/**
+ * @brief Get the Strings found more than once in a text: the intervals of its Suffix Array
+ * @param allocator The Allocator of the result
+ * @param lcp The shared prefixes lengths of Suffix Array
+ * @param len Text length
+ * @param nb  [out] Number of candidates
+ * @return The candidates longer than WBXML_ENCODER_STRING_TABLE_MIN, or NULL if not enough memory
+ */
+static WBXMLStrtblCandidate *wbxml_strtbl_candidates(WBXMLAllocator *allocator, const WB_ULONG *lcp, WB_ULONG len, WB_ULONG *nb)
+{
+    WBXMLStrtblCandidate *result = NULL, *stack = NULL;
+    WB_ULONG top = 0, i = 0, lb = 0, cur = 0;
 
-#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
-            }
-#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
-        }
+    *nb = 0;
 
-#if defined( WBXML_SUPPORT_SYNCML )
-        /* Change text in <Type> from "application/vnd.syncml-devinf+wbxml" to "application/vnd.syncml-devinf+xml" */
-        if (((encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML10) ||
-             (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML11) ||
-             (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML12)) &&
-            (encoder->current_tag != NULL) &&
-            (encoder->current_tag->wbxmlCodePage == 0x01 ) &&
-            (encoder->current_tag->wbxmlToken == 0x13 ) &&
-            (wbxml_buffer_compare_cstr(tmp, "application/vnd.syncml-devinf+wbxml") == 0))
-        {
-            wbxml_buffer_destroy(tmp);
+    if (((result = wbxml_mem_malloc(allocator, (len + 1) * sizeof(WBXMLStrtblCandidate))) == NULL) ||
+        ((stack = wbxml_mem_malloc(allocator, (len + 1) * sizeof(WBXMLStrtblCandidate))) == NULL))
+    {
+        wbxml_mem_free(allocator, result);
+        return NULL;
+    }
 
-            /* Change Content */
-            if ((tmp = wbxml_buffer_create_from_cstr("application/vnd.syncml-devinf+xml")) == NULL)
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-        }
-        /* Change text in <Type> from "application/vnd.syncml.dmtnds+wbxml" to "application/vnd.syncml.dmtnds+xml" */
-        if ((encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML12) &&
-            (encoder->current_tag != NULL) &&
-            (encoder->current_tag->wbxmlCodePage == 0x01 ) &&
-            (encoder->current_tag->wbxmlToken == 0x13 ) &&
-            (wbxml_buffer_compare_cstr(tmp, "application/vnd.syncml.dmtnds+wbxml") == 0))
-        {
-            wbxml_buffer_destroy(tmp);
+    stack[0].lb = 0;
+    stack[0].len = 0;
+    top = 1;
 
-            /* Change Content */
-            if ((tmp = wbxml_buffer_create_from_cstr("application/vnd.syncml.dmtnds+xml")) == NULL)
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-        }
-#endif /* WBXML_SUPPORT_SYNCML */
+    for (i = 1; i <= len; i++) {
+        cur = (i < len) ? lcp[i] : 0;
+        lb = i - 1;
 
-        /* Some elements are transferred as WBXML opaque data. They contain
-         * binary data that isn't necessary valid in XML, so return them in Base
-         * 64.
-         */
-        if (encoder->current_tag != NULL &&
-            encoder->current_tag->options & WBXML_TAG_OPTION_BINARY)
-        {
-            WBXMLError ret;
-            if ((ret = wbxml_buffer_encode_base64(tmp)) != WBXML_OK) {
-                wbxml_buffer_destroy(tmp);
-                return ret;
-            }
-        }
+        /* Intervals that end here */
+        while (cur < stack[top - 1].len) {
+            top--;
+            stack[top].rb = i - 1;
 
-        /* Fix text */
-        if (xml_encode_text_entities(encoder, tmp)) {
-            wbxml_buffer_destroy(tmp);
-            return WBXML_ERROR_ENCODER_APPEND_DATA;
+            if (stack[top].len > WBXML_ENCODER_STRING_TABLE_MIN)
+                result[(*nb)++] = stack[top];
+
+            lb = stack[top].lb;
         }
 
-        /* Clean-up */
-        wbxml_buffer_destroy(tmp);
+        /* Interval that starts before */
+        if (cur > stack[top - 1].len) {
+            stack[top].lb = lb;
+            stack[top].len = cur;
+            top++;
+        }
     }
 
-    encoder->in_content = TRUE;
+    wbxml_mem_free(allocator, stack);
 
-    return WBXML_OK;
+    return result;
 }
 
 
 /**
- * @brief Append a New Line to a Buffer
- * @param buff The Buffer
- * @return TRUE if added, FALSE otherwise
+ * @brief Compare two positions (for qsort())
  */
-static WB_BOOL xml_encode_new_line(WBXMLBuffer *buff)
+static int wbxml_strtbl_opt_cmp_pos(const void *a, const void *b)
 {
-    if (buff == NULL)
-        return FALSE;
+    WB_ULONG pos_a = *(const WB_ULONG *) a, pos_b = *(const WB_ULONG *) b;
 
-    return wbxml_buffer_append_data(buff, WBXML_ENCODER_XML_NEW_LINE, WBXML_STRLEN(WBXML_ENCODER_XML_NEW_LINE));
+    return (pos_a < pos_b) ? -1 : ((pos_a > pos_b) ? 1 : 0);
 }
 
 
 /**
- * @brief Fix an XML text buffer (content text or attribute value)
- * @param buff The Buffer to fix
- * @param normalize Normalize text ?
- * @return WBXML_OK if ok, an Error Code otherwise
- * @note Reference: http://www.w3.org/TR/2004/REC-xml-20040204/#syntax
+ * @brief Compute the bytes saved by references to a candidate, where text is not already referenced
+ * @param opt       The optimizer
+ * @param cand      The candidate
+ * @param index_len Length of the mb_u_int32 index of candidate
+ * @param apply     If TRUE, referenced text is marked as covered
+ * @return Bytes saved in document body
+ * @note Occurrences are referenced from left to right. Text is in inline Strings ('STR_I chars END'):
+ *       referencing a whole one saves 2 more bytes, but cutting one in two costs 2 more bytes.
  */
-static WBXMLError xml_encode_text_entities(WBXMLEncoder *encoder, WBXMLBuffer *buff)
+static WB_LONG wbxml_strtbl_opt_references(WBXMLStrtblOptimizer *opt, const WBXMLStrtblCandidate *cand, WB_ULONG index_len, WB_BOOL apply)
 {
-    WB_ULONG i = 0;
-    WB_UTINY ch;
-    WB_BOOL normalize = (WB_BOOL) (encoder->xml_gen_type == WBXML_GEN_XML_CANONICAL);
+    WB_ULONG nb = 0, i = 0, j = 0, pos = 0, end = 0;
+    WB_LONG saved = 0;
 
-    for (i = 0; i < wbxml_buffer_len(buff); i++) {
-        if (!wbxml_buffer_get_char(buff, i, &ch))
-            continue;
+    /* Occurrences that start in text not referenced yet */
+    for (i = cand->lb; i <= cand->rb; i++) {
+        if (!opt->covered[opt->sa[i]])
+            opt->positions[nb++] = opt->sa[i];
+    }
 
-        switch (ch) {
-        case '<':
-            /* Write "&lt;" */
-            if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_lt))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    qsort(opt->positions, nb, sizeof(WB_ULONG), wbxml_strtbl_opt_cmp_pos);
 
-            break;
+    for (i = 0; i < nb; i++) {
+        pos = opt->positions[i];
 
-        case '>':
-            /* Write "&gt;" */
-            if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_gt))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        /* Overlaps previous occurrence */
+        if (pos < end)
+            continue;
 
-            break;
+        for (j = 1; j < cand->len; j++) {
+            if (opt->covered[pos + j])
+                break;
+        }
 
-        case '&':
-            /* Write "&amp;" */
-            if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_amp))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        if (j < cand->len)
+            continue;
 
-            break;
+        /* 'STR_I chars END' becomes 'STR_T index' */
+        saved += (WB_LONG) (cand->len + 2) - (WB_LONG) (1 + index_len);
 
-        case '"':
-            /* Write "&quot;" */
-            if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_quot))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        /* Text left before... */
+        if ((pos > 0) && (pos != end) && !opt->covered[pos - 1])
+            saved -= 2;
 
-            break;
+        /* ... and after: both are inline Strings */
+        if (!opt->covered[pos + cand->len])
+            saved -= 2;
 
-        case '\'':
-            /* Write "&apos;" */
-            if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_apos))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        if (apply)
+            memset(opt->covered + pos, 1, cand->len);
 
-            break;
+        end = pos + cand->len;
+    }
 
-        case '\r':
-            if (normalize) {
-                /* Write "&#13;" */
-                if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_slashr))
-                    return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    return saved;
+}
 
-                break;
-            }
 
-        case '\n':
-            if (normalize) {
-                /* Write "&#10;" */
-                if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_slashn))
-                    return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                break;
-            }
+/**
+ * @brief Compute the bytes added to String Table by a candidate
+ * @param opt      The optimizer
+ * @param data     The candidate String
+ * @param len      The candidate length
+ * @param host     [out] Chosen String it would be stored in, or 'nb_choices' if it would be stored on its own
+ * @param absorbed [out] Chosen String stored on its own that would be stored in it, or 'nb_choices' if none
+ * @return Bytes added to String Table
+ */
+static WB_ULONG wbxml_strtbl_opt_storage(WBXMLStrtblOptimizer *opt, const WB_UTINY *data, WB_ULONG len, WB_ULONG *host, WB_ULONG *absorbed)
+{
+    WBXMLStrtblChoice *choice = NULL;
+    WB_ULONG i = 0;
 
-        case '\t':
-            if (normalize) {
-                /* Write "&#9;" */
-                if (!wbxml_buffer_append_cstr(encoder->output, (WB_UTINY *) xml_tab))
-                    return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-                break;
-            }
+    *host = opt->nb_choices;
+    *absorbed = opt->nb_choices;
 
-        default:
-            if (!wbxml_buffer_append_char(encoder->output, ch))
-                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    for (i = 0; i < opt->nb_choices; i++) {
+        choice = &opt->choices[i];
 
-            break;
+        /* It ends a chosen String */
+        if ((choice->len > len) && (memcmp(choice->data + choice->len - len, data, len) == 0)) {
+            *host = choice->host;
+            return 0;
         }
+
+        /* A chosen String stored on its own ends it (there is only one) */
+        if ((choice->len < len) && (choice->host == i) && (memcmp(data + len - choice->len, choice->data, choice->len) == 0))
+            *absorbed = i;
     }
 
-    return WBXML_OK;
+    if (*absorbed < opt->nb_choices)
+        return len - opt->choices[*absorbed].len;
+
+    return len + 1;
 }
 
 
 /**
- * @brief Encode a begin of CDATA section
- * @param encoder The WBXML Encoder
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Check if a candidate is a run of a short pattern ("xxxx", "abab"...)
+ * @param data The candidate String
+ * @param len  The candidate length
+ * @return TRUE if it repeats a pattern of WBXML_STRTBL_OPT_RUN_PERIOD chars or less, at least twice
+ * @note Every part of a long run is a candidate too, found nearly as many times as there are chars
+ *       in run: as their occurrences overlap, they save few bytes but they would be evaluated over
+ *       and over. They are not taken as candidates.
  */
-static WBXMLError xml_encode_cdata(WBXMLEncoder *encoder)
+static WB_BOOL wbxml_strtbl_opt_is_run(const WB_UTINY *data, WB_ULONG len)
 {
-    /* Append <![CDATA[ */
-    if (!wbxml_buffer_append_cstr(encoder->output, "<![CDATA["))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    WB_ULONG period = 0;
 
-    return WBXML_OK;
+    for (period = 1; (period <= WBXML_STRTBL_OPT_RUN_PERIOD) && (2 * period <= len); period++) {
+        if (memcmp(data, data + period, len - period) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
 }
 
 
 /**
- * @brief Encode an end of CDATA section
- * @param encoder The WBXML Encoder
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Push a candidate in the heap of wbxml_strtbl_optimize() (the highest score on top)
+ * @param heap      The heap
+ * @param nb        [in/out] Number of candidates in heap
+ * @param score     Score of candidate
+ * @param candidate Index of candidate
  */
-static WBXMLError xml_encode_end_cdata(WBXMLEncoder *encoder)
+static void wbxml_strtbl_heap_push(WBXMLStrtblHeapItem *heap, WB_ULONG *nb, WB_LONG score, WB_ULONG candidate)
 {
-    /* Append ]]> */
-    if (!wbxml_buffer_append_cstr(encoder->output, "]]>"))
-        return WBXML_ERROR_ENCODER_APPEND_DATA;
+    WB_ULONG i = (*nb)++;
 
-    return WBXML_OK;
+    while ((i > 0) && (heap[(i - 1) / 2].score < score)) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+
+    heap[i].score = score;
+    heap[i].candidate = candidate;
 }
 
 
 /**
- * @brief Encode an encapsulated WBXML Tree to XML
- * @param encoder [in] The WBXML Encoder
- * @param tree    [in] The WBXML Tree to encode
- * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @brief Pop the candidate with the highest score from the heap of wbxml_strtbl_optimize()
+ * @param heap The heap (not empty)
+ * @param nb   [in/out] Number of candidates in heap
+ * @param top  [out] The candidate
  */
-static WBXMLError xml_encode_tree(WBXMLEncoder *encoder, WBXMLTree *tree)
+static void wbxml_strtbl_heap_pop(WBXMLStrtblHeapItem *heap, WB_ULONG *nb, WBXMLStrtblHeapItem *top)
 {
-    WBXMLEncoder *new_encoder = NULL;
-    WB_UTINY     *xml         = NULL;
-    WB_ULONG      xml_len     = 0;
-    WBXMLError    ret         = WBXML_OK;
+    WBXMLStrtblHeapItem last;
+    WB_ULONG i = 0, child = 0;
 
-    if ((new_encoder = encoder_duplicate(encoder)) == NULL)
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    *top = heap[0];
+    last = heap[--(*nb)];
 
-    /* Set Tree */
-    new_encoder->tree = tree;
+    while ((child = 2 * i + 1) < *nb) {
+        if ((child + 1 < *nb) && (heap[child + 1].score > heap[child].score))
+            child++;
 
-    /* Encode to XML */
-    if ((ret = wbxml_encoder_encode_tree_to_xml(new_encoder, &xml, &xml_len)) != WBXML_OK) {
-        wbxml_encoder_destroy(new_encoder);
-        return ret;
+        if (heap[child].score <= last.score)
+            break;
+
+        heap[i] = heap[child];
+        i = child;
     }
 
-    /* Clean-up */
-    wbxml_encoder_destroy(new_encoder);
+    heap[i] = last;
+}
 
-    /** @bug Handle output_charset ! */
 
-    /* Append xml to output */
-    if (!wbxml_buffer_append_cstr(encoder->output, xml)) {
-        wbxml_free(xml);
+/**
+ * @brief Get the number of bytes of a value encoded as a mb_u_int32
+ * @param value The value
+ * @return Its length
+ */
+static WB_ULONG wbxml_strtbl_mb_uint_32_len(WB_ULONG value)
+{
+    WB_ULONG len = 1;
+
+    while ((value >>= 7) > 0)
+        len++;
+
+    return len;
+}
+
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
+
+/*****************************************
+ *  XML Output Functions
+ */
+
+/****************************
+ * Build XML Result
+ */
+
+/**
+ * @brief Build XML Result
+ * @param encoder [in] The WBXML Encoder
+ * @param xml     [out] Resulting XML document
+ * @param xml_len [out] XML document length
+ * @return WBXML_OK if built is OK, an error code otherwise
+ */
+static WBXMLError xml_build_result(WBXMLEncoder *encoder, WB_UTINY **xml, WB_ULONG *xml_len)
+{
+    WBXMLBuffer *header = NULL;
+    WB_ULONG     len    = 0;
+    WBXMLError   ret    = WBXML_OK;
+
+    if (xml == NULL)
+        return WBXML_ERROR_BAD_PARAMETER;
+    
+    /* Init */
+    if (xml_len != NULL)
+        *xml_len = 0;
+    
+    if (encoder->header_in_output) {
+        /* Header is at start of output */
+        header = NULL;
+    }
+    else if (encoder->flow_mode == TRUE) {
+        /* Header already built */
+        header = encoder->output_header;
+    }
+    else {
+        /* Create Header Buffer */
+        if ((header = wbxml_buffer_create_with_allocator(encoder->allocator, "", 0, WBXML_ENCODER_XML_HEADER_MALLOC_BLOCK)) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        /* Fill Header Buffer */
+        if (encoder->xml_encode_header) {
+            if ((ret = xml_fill_header(encoder, header)) != WBXML_OK) {
+                wbxml_buffer_destroy(header);
+                return ret;
+            }
+        }
+    }
+
+    /* Result Buffer Length */
+    len = wbxml_buffer_len(header) + wbxml_buffer_len(encoder->output);
+
+    /* Create Result Buffer */
+    *xml = wbxml_mem_malloc(encoder->allocator, (len + 1) * sizeof(WB_UTINY));
+    if (*xml == NULL) {
+        if (encoder->flow_mode == FALSE)
+            wbxml_buffer_destroy(header);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
+    /** @todo Use the 'output_charset' field */
+
+    /* Copy Header to Result */
+    memcpy(*xml, wbxml_buffer_get_cstr(header), wbxml_buffer_len(header));
+
+    /* Copy XML Document to Result */
+    memcpy(*xml + wbxml_buffer_len(header), wbxml_buffer_get_cstr(encoder->output), wbxml_buffer_len(encoder->output));
+
+    /** @todo Remove this NULL char if not needed by charset */
+
+    /* NULL Terminated Buffer */
+    (*xml)[len] = '\0';
+
+    /* Set length */
+    if (xml_len != NULL)
+        *xml_len = len;
+
     /* Clean-up */
-    wbxml_free(xml);
+    if (encoder->flow_mode == FALSE)
+        wbxml_buffer_destroy(header);
 
     return WBXML_OK;
 }
+
+
+/**
+ * @brief Fill the XML Header
+ * @param encoder The WBXML Encoder
+ * @param header The Buffer to Fill
+ * @return WBXML_OK if built is OK, an error code otherwise
+ */
+static WBXMLError xml_fill_header(WBXMLEncoder *encoder, WBXMLBuffer *header)
+{
+    if ((encoder == NULL) || (header == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    /** @todo Add 'encoding' info */
+
+    /* <?xml version=\"1.0\"?> */
+    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_HEADER))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* New Line */
+    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+        if (!xml_encode_new_line(header))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    }
+
+    /* <!DOCTYPE */
+    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_DOCTYPE))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Check that the language is set */
+    if (encoder->lang == NULL)
+        return WBXML_ERROR_LANG_TABLE_UNDEFINED;
+
+    /* Root Element */
+    if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlRootElt))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    if (encoder->lang->publicID->xmlPublicID &&
+        WBXML_STRLEN(encoder->lang->publicID->xmlPublicID)) {
+
+        /*  PUBLIC " */
+        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_PUBLIC_START))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+        /* Public ID */
+        if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlPublicID))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+        /* " */
+        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_PUBLIC_END))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    } else {
+	/*  SYSTEM */
+        if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_SYSTEM))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    }
+
+    /* DTD */
+    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_DTD))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* DTD */
+    if (!wbxml_buffer_append_cstr(header, encoder->lang->publicID->xmlDTD))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* "> */
+    if (!wbxml_buffer_append_cstr(header, WBXML_ENCODER_XML_END_DTD))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* New Line */
+    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+        if (!xml_encode_new_line(header))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    }
+
+    return WBXML_OK;
+}
+
+
+/****************************
+ * XML Encoding Functions
+ */
+
+/**
+ * @brief Tell if an Element Code Page is different than its Parent one
+ * @param parent The Parent Element Tag (NULL for Root Element)
+ * @param tag    The Element Tag
+ * @return TRUE if this is the Root Element, or if Code Pages are different
+ */
+static WB_BOOL xml_tag_switch_page(WBXMLTag *parent, WBXMLTag *tag)
+{
+    return (WB_BOOL) ((parent == NULL) ||
+                      ((parent->type == WBXML_VALUE_TOKEN) &&
+                       (tag->type == WBXML_VALUE_TOKEN) &&
+                       (parent->u.token->wbxmlCodePage != tag->u.token->wbxmlCodePage)));
+}
+
+
+/**
+ * @brief Tell if an Element Node Code Page is different than its Parent Node one
+ * @param node The Element Node
+ * @return TRUE if this is the Root Element, or if Code Pages are different
+ */
+static WB_BOOL xml_node_switch_page(WBXMLTreeNode *node)
+{
+    if (node->parent == NULL)
+        return TRUE;
+
+    return (WB_BOOL) ((node->parent->type == WBXML_TREE_ELEMENT_NODE) &&
+                      (node->type == WBXML_TREE_ELEMENT_NODE) &&
+                      xml_tag_switch_page(node->parent->name, node->name));
+}
+
+
+/**
+ * @brief Tell if an Element content is indented
+ * @param encoder The WBXML Encoder
+ * @param has_child_elt Does the Element have an Element child ?
+ * @return TRUE if content is indented
+ */
+static WB_BOOL xml_indent_content(WBXMLEncoder *encoder, WB_BOOL has_child_elt)
+{
+    if (encoder->xml_gen_type != WBXML_GEN_XML_INDENT)
+        return FALSE;
+
+#if defined( WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT )
+    return has_child_elt;
+#else
+    return TRUE;
+#endif /* WBXML_ENCODER_XML_NO_EMPTY_ELT_INDENT */
+}
+
+
+/**
+ * @brief Tell if a Node content is indented
+ * @param encoder The WBXML Encoder
+ * @param node The Node
+ * @return TRUE if content is indented
+ */
+static WB_BOOL xml_node_indent_content(WBXMLEncoder *encoder, WBXMLTreeNode *node)
+{
+    if (encoder->xml_gen_type != WBXML_GEN_XML_INDENT)
+        return FALSE;
+
+    return xml_indent_content(encoder, wbxml_tree_node_have_child_elt(node));
+}
+
+
+/**
+ * @brief Encode an XML Tag
+ * @param encoder The WBXML Encoder
+ * @param name The Tag of element to encode
+ * @param switch_page Is the element Code Page different than its parent one ? (cf xml_tag_switch_page())
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_tag(WBXMLEncoder *encoder, WBXMLTag *name, WB_BOOL switch_page)
+{
+    const WB_TINY *ns = NULL;
+    WB_UTINY i;
+
+    /* Set as current Tag */
+    if (name->type == WBXML_VALUE_TOKEN)
+        encoder->current_tag = name->u.token;
+    else
+        encoder->current_tag = NULL;
+
+    /* Indent */
+    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+        for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
+            if (!wbxml_buffer_append_char(encoder->output, ' '))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+    }
+
+    /* Append < */
+    if (!wbxml_buffer_append_char(encoder->output, '<'))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Append Element Name */
+    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_tag_get_xml_name(name)))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* NameSpace handling: Check if Current Node Code Page is different than Parent Node Code Page */
+    if ((encoder->lang->nsTable != NULL) && switch_page)
+    {
+        if ((ns = wbxml_tables_get_xmlns(encoder->lang->nsTable, name->u.token->wbxmlCodePage)) != NULL)
+        {
+            /* Append xmlns=" */
+            if (!wbxml_buffer_append_cstr(encoder->output, " xmlns=\""))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+            /* Append NameSpace */
+            if (!wbxml_buffer_append_cstr(encoder->output, ns))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+            /* Append " */
+            if (!wbxml_buffer_append_char(encoder->output, '"'))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Encode an XML End Tag
+ * @param encoder The WBXML Encoder
+ * @param name Tag
+ * @param indent_content Is the element content indented ? (cf xml_indent_content())
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_end_tag(WBXMLEncoder *encoder, WBXMLTag *name, WB_BOOL indent_content)
+{
+    WB_UTINY i;
+
+    if (indent_content) {
+        /* Add a New Line if there were content in this element */
+        if (encoder->in_content) {
+            if (!xml_encode_new_line(encoder->output))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+
+        encoder->indent--;
+
+        /* Indent End Element */
+        for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
+            if (!wbxml_buffer_append_char(encoder->output, ' '))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+    }
+
+    /* Append </ */
+    if (!wbxml_buffer_append_cstr(encoder->output, "</"))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Append Element Name */
+    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_tag_get_xml_name(name)))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Append > */
+    if (!wbxml_buffer_append_char(encoder->output, '>'))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* New Line */
+    if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+        if (!xml_encode_new_line(encoder->output))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    }
+
+    /* No more in content */
+    encoder->in_content = FALSE;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Encode a XML Attribute
+ * @param encoder [in] The WBXML Encoder
+ * @param attribute [in] The Attribute to encode
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_attr(WBXMLEncoder *encoder, WBXMLAttribute *attribute)
+{
+    /* Append a space */
+    if (!wbxml_buffer_append_char(encoder->output, ' '))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Append Attribute Name */
+    if (!wbxml_buffer_append_cstr(encoder->output, wbxml_attribute_get_xml_name(attribute)))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    /* Append =" */
+    if (!wbxml_buffer_append_cstr(encoder->output, "=\""))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    if (wbxml_attribute_get_xml_value(attribute) != NULL) {
+        /* Fix Attribute Value text */
+        if (xml_encode_text_entities(encoder,
+                                     wbxml_attribute_get_xml_value(attribute),
+                                     WBXML_STRLEN(wbxml_attribute_get_xml_value(attribute))))
+        {
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+    }
+
+    /* Append " */
+    if (!wbxml_buffer_append_char(encoder->output, '"'))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Encode a End of XML Attributes List
+ * @param encoder        [in] The WBXML Encoder
+ * @param has_content    [in] Does current element have a content ?
+ * @param indent_content [in] Is current element content indented ? (cf xml_indent_content())
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_end_attrs(WBXMLEncoder *encoder, WB_BOOL has_content, WB_BOOL indent_content)
+{
+#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+
+    if (!has_content) {
+        /* Append " />" */
+        if (!wbxml_buffer_append_cstr(encoder->output, "/>"))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+        /* New Line */
+        if (encoder->xml_gen_type == WBXML_GEN_XML_INDENT) {
+            if (!xml_encode_new_line(encoder->output))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+    }
+    else {
+
+#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
+            
+        /* Append > */
+        if (!wbxml_buffer_append_char(encoder->output, '>'))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+        /* New Line */
+        if (indent_content) {
+            if (!xml_encode_new_line(encoder->output))
+                return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+            /* Increment indentation */
+            encoder->indent++;
+        }
+
+#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+
+    }
+
+#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
+
+    return WBXML_OK;
+}
+
+/**
+ * @brief Encode an XML Text
+ * @param encoder The WBXML Encoder
+ * @param str     The XML Text to encode
+ * @param indent  Is the text indented ? (cf xml_indent_content())
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_text(WBXMLEncoder *encoder, WBXMLBuffer *str, WB_BOOL indent)
+{
+    WBXMLBuffer *tmp = NULL;
+    const WB_UTINY *data = NULL;
+    WB_ULONG len = 0;
+    WB_UTINY i = 0;
+
+    if (encoder->in_cdata) {
+        /* If we are in a CDATA section, do not modify the text to encode */
+        if (!wbxml_buffer_append(encoder->output, str))
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+    }
+    else {
+        /* The text is not modified: escape it as is, unless changed below */
+        data = wbxml_buffer_get_cstr(str);
+        len = wbxml_buffer_len(str);
+
+        /* Indent */
+        if (indent && !encoder->in_content) {
+            /* Indent Content (only indent in first call to xml_encode_text()) */
+            for (i=0; i<(encoder->indent * encoder->indent_delta); i++) {
+                if (!wbxml_buffer_append_char(encoder->output, ' '))
+                    return WBXML_ERROR_ENCODER_APPEND_DATA;
+            }
+        }
+
+#if defined( WBXML_SUPPORT_SYNCML )
+        /* Change text in <Type> from "application/vnd.syncml-devinf+wbxml" to "application/vnd.syncml-devinf+xml" */
+        if (((encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML10) ||
+             (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML11) ||
+             (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML12)) &&
+            (encoder->current_tag != NULL) &&
+            (encoder->current_tag->wbxmlCodePage == 0x01 ) &&
+            (encoder->current_tag->wbxmlToken == 0x13 ) &&
+            (wbxml_buffer_compare_cstr(str, "application/vnd.syncml-devinf+wbxml") == 0))
+        {
+            /* Change Content */
+            data = (const WB_UTINY *) "application/vnd.syncml-devinf+xml";
+            len = WBXML_STRLEN(data);
+        }
+        /* Change text in <Type> from "application/vnd.syncml.dmtnds+wbxml" to "application/vnd.syncml.dmtnds+xml" */
+        if ((encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML12) &&
+            (encoder->current_tag != NULL) &&
+            (encoder->current_tag->wbxmlCodePage == 0x01 ) &&
+            (encoder->current_tag->wbxmlToken == 0x13 ) &&
+            (wbxml_buffer_compare_cstr(str, "application/vnd.syncml.dmtnds+wbxml") == 0))
+        {
+            /* Change Content */
+            data = (const WB_UTINY *) "application/vnd.syncml.dmtnds+xml";
+            len = WBXML_STRLEN(data);
+        }
+#endif /* WBXML_SUPPORT_SYNCML */
+
+        /* Some elements are transferred as WBXML opaque data. They contain
+         * binary data that isn't necessary valid in XML, so return them in Base
+         * 64.
+         */
+        if (encoder->current_tag != NULL &&
+            encoder->current_tag->options & WBXML_TAG_OPTION_BINARY)
+        {
+            WBXMLError ret;
+
+            /* Work with a temporary copy */
+            if ((tmp = wbxml_buffer_create_with_allocator(encoder->allocator, data, len, len)) == NULL)
+                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+            if ((ret = wbxml_buffer_encode_base64(tmp)) != WBXML_OK) {
+                wbxml_buffer_destroy(tmp);
+                return ret;
+            }
+
+            data = wbxml_buffer_get_cstr(tmp);
+            len = wbxml_buffer_len(tmp);
+        }
+
+        /* Fix text */
+        if (xml_encode_text_entities(encoder, data, len)) {
+            wbxml_buffer_destroy(tmp);
+            return WBXML_ERROR_ENCODER_APPEND_DATA;
+        }
+
+        /* Clean-up */
+        wbxml_buffer_destroy(tmp);
+    }
+
+    encoder->in_content = TRUE;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Append a New Line to a Buffer
+ * @param buff The Buffer
+ * @return TRUE if added, FALSE otherwise
+ */
+static WB_BOOL xml_encode_new_line(WBXMLBuffer *buff)
+{
+    if (buff == NULL)
+        return FALSE;
+
+    return wbxml_buffer_append_data(buff, WBXML_ENCODER_XML_NEW_LINE, WBXML_STRLEN(WBXML_ENCODER_XML_NEW_LINE));
+}
+
+
+/**
+ * @brief Fix an XML text (content text or attribute value)
+ * @param encoder The WBXML Encoder
+ * @param data The text to fix
+ * @param len Text length
+ * @return WBXML_OK if ok, an Error Code otherwise
+ * @note Reference: http://www.w3.org/TR/2004/REC-xml-20040204/#syntax
+ * @note Text is normalized when generating canonical XML
+ */
+static WBXMLError xml_encode_text_entities(WBXMLEncoder *encoder, const WB_UTINY *data, WB_ULONG len)
+{
+    const WB_UTINY *entity = NULL;
+    WB_UTINY *out = NULL;
+    WB_ULONG i = 0, end = 0, plain = 0, room = 0, out_len = 0, entity_len = 0;
+    WB_BOOL normalize = (WB_BOOL) (encoder->xml_gen_type == WBXML_GEN_XML_CANONICAL);
+
+    /* Most of the text is copied as is */
+    if (!wbxml_buffer_reserve(encoder->output, len))
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    while (i < len) {
+        /* Write a chunk of text straight into output, with room for the longest result */
+        end = (len - i > WBXML_ENCODER_XML_ESCAPE_CHUNK) ? i + WBXML_ENCODER_XML_ESCAPE_CHUNK : len;
+        room = (end - i) * (sizeof(xml_quot) - 1);
+
+        if ((out = wbxml_buffer_append_space(encoder->output, room)) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        out_len = 0;
+
+        while (i < end) {
+            /* Copy chars that are not escaped, in one go */
+            plain = xml_text_plain_len(data + i, end - i, normalize);
+            memcpy(out + out_len, data + i, plain);
+            out_len += plain;
+
+            if ((i += plain) == end)
+                break;
+
+            switch (data[i]) {
+            case '<':
+                /* Write "&lt;" */
+                entity = xml_lt;
+                entity_len = sizeof(xml_lt) - 1;
+                break;
+
+            case '>':
+                /* Write "&gt;" */
+                entity = xml_gt;
+                entity_len = sizeof(xml_gt) - 1;
+                break;
+
+            case '&':
+                /* Write "&amp;" */
+                entity = xml_amp;
+                entity_len = sizeof(xml_amp) - 1;
+                break;
+
+            case '"':
+                /* Write "&quot;" */
+                entity = xml_quot;
+                entity_len = sizeof(xml_quot) - 1;
+                break;
+
+            case '\'':
+                /* Write "&apos;" */
+                entity = xml_apos;
+                entity_len = sizeof(xml_apos) - 1;
+                break;
+
+            case '\r':
+                /* Write "&#13;" */
+                entity = xml_slashr;
+                entity_len = sizeof(xml_slashr) - 1;
+                break;
+
+            case '\n':
+                /* Write "&#10;" */
+                entity = xml_slashn;
+                entity_len = sizeof(xml_slashn) - 1;
+                break;
+
+            default:
+                /* Write "&#9;" */
+                entity = xml_tab;
+                entity_len = sizeof(xml_tab) - 1;
+                break;
+            }
+
+            memcpy(out + out_len, entity, entity_len);
+            out_len += entity_len;
+            i++;
+        }
+
+        /* Remove unused room */
+        wbxml_buffer_delete(encoder->output, wbxml_buffer_len(encoder->output) - (room - out_len), room - out_len);
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Get the length of the beginning of an XML text that is not escaped
+ * @param data The text
+ * @param len Text length
+ * @param normalize Is '\r', '\n' and '\t' escaped ? (canonical XML)
+ * @return Number of chars before the first one to escape ('len' if none)
+ * @note 16 chars are checked at a time, when possible
+ */
+static WB_ULONG xml_text_plain_len(const WB_UTINY *data, WB_ULONG len, WB_BOOL normalize)
+{
+    WB_UTINY mask = (WB_UTINY) (normalize ? 3 : 1);
+    WB_ULONG i = 0;
+
+#if defined( WBXML_ENCODER_XML_SSE2 )
+    const __m128i lt = _mm_set1_epi8('<'), gt = _mm_set1_epi8('>'), amp = _mm_set1_epi8('&');
+    const __m128i quot = _mm_set1_epi8('"'), apos = _mm_set1_epi8('\'');
+    const __m128i cr = _mm_set1_epi8('\r'), lf = _mm_set1_epi8('\n'), tab = _mm_set1_epi8('\t');
+    __m128i chars, found;
+    int bits = 0;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        chars = _mm_loadu_si128((const __m128i *) (data + i));
+
+        found = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, lt), _mm_cmpeq_epi8(chars, gt)),
+                             _mm_or_si128(_mm_cmpeq_epi8(chars, amp),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chars, quot), _mm_cmpeq_epi8(chars, apos))));
+        if (normalize) {
+            found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(chars, cr),
+                                                     _mm_or_si128(_mm_cmpeq_epi8(chars, lf), _mm_cmpeq_epi8(chars, tab))));
+        }
+
+        if ((bits = _mm_movemask_epi8(found)) != 0)
+            return i + (WB_ULONG) __builtin_ctz((unsigned int) bits);
+    }
+#elif defined( WBXML_ENCODER_XML_NEON )
+    const uint8x16_t lt = vdupq_n_u8('<'), gt = vdupq_n_u8('>'), amp = vdupq_n_u8('&');
+    const uint8x16_t quot = vdupq_n_u8('"'), apos = vdupq_n_u8('\'');
+    const uint8x16_t cr = vdupq_n_u8('\r'), lf = vdupq_n_u8('\n'), tab = vdupq_n_u8('\t');
+    uint8x16_t chars, found;
+
+    for (i = 0; i + 16 <= len; i += 16) {
+        chars = vld1q_u8(data + i);
+
+        found = vorrq_u8(vorrq_u8(vceqq_u8(chars, lt), vceqq_u8(chars, gt)),
+                         vorrq_u8(vceqq_u8(chars, amp), vorrq_u8(vceqq_u8(chars, quot), vceqq_u8(chars, apos))));
+        if (normalize)
+            found = vorrq_u8(found, vorrq_u8(vceqq_u8(chars, cr), vorrq_u8(vceqq_u8(chars, lf), vceqq_u8(chars, tab))));
+
+        /* Found: locate it below */
+        if (vmaxvq_u8(found) != 0)
+            break;
+    }
+#endif /* WBXML_ENCODER_XML_SSE2 */
+
+    for (; i < len; i++) {
+        if (xml_escaped_chars[data[i]] & mask)
+            return i;
+    }
+
+    return len;
+}
+
+
+/**
+ * @brief Encode a begin of CDATA section
+ * @param encoder The WBXML Encoder
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_cdata(WBXMLEncoder *encoder)
+{
+    /* Append <![CDATA[ */
+    if (!wbxml_buffer_append_cstr(encoder->output, "<![CDATA["))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Encode an end of CDATA section
+ * @param encoder The WBXML Encoder
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_end_cdata(WBXMLEncoder *encoder)
+{
+    /* Append ]]> */
+    if (!wbxml_buffer_append_cstr(encoder->output, "]]>"))
+        return WBXML_ERROR_ENCODER_APPEND_DATA;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Encode an encapsulated WBXML Tree to XML
+ * @param encoder [in] The WBXML Encoder
+ * @param tree    [in] The WBXML Tree to encode
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ */
+static WBXMLError xml_encode_tree(WBXMLEncoder *encoder, WBXMLTree *tree)
+{
+    WBXMLEncoder *new_encoder = NULL;
+    WB_UTINY     *xml         = NULL;
+    WB_ULONG      xml_len     = 0;
+    WBXMLError    ret         = WBXML_OK;
+
+    if ((new_encoder = encoder_duplicate(encoder)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    /* Set Tree */
+    new_encoder->tree = tree;
+
+    /* Encode to XML */
+    if ((ret = wbxml_encoder_encode_tree_to_xml(new_encoder, &xml, &xml_len)) != WBXML_OK) {
+        wbxml_encoder_destroy(new_encoder);
+        return ret;
+    }
+
+    /* Clean-up */
+    wbxml_encoder_destroy(new_encoder);
+
+    /** @bug Handle output_charset ! */
+
+    /* Append xml to output */
+    if (!wbxml_buffer_append_cstr(encoder->output, xml)) {
+        wbxml_mem_free(encoder->allocator, xml);
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    /* Clean-up */
+    wbxml_mem_free(encoder->allocator, xml);
+
+    return WBXML_OK;
+}
+
+
+/****************************
+ * XML Encoding while parsing WBXML
+ */
+
+/**
+ * @brief WBXMLStartDocumentHandler of XML encoding while parsing WBXML
+ * @param ctx     The context (WBXMLEncoderXMLCtx)
+ * @param charset The document Charset
+ * @param lang    The document Language Table
+ */
+static void xml_clb_start_document(void *ctx, WBXMLCharsetMIBEnum charset, const WBXMLLangEntry *lang)
+{
+    WBXMLEncoderXMLCtx *xml_ctx = (WBXMLEncoderXMLCtx *) ctx;
+    WBXMLEncoder *encoder = xml_ctx->encoder;
+
+    if ((xml_ctx->error != WBXML_OK) || xml_ctx->use_tree)
+        return;
+
+#if defined( WBXML_SUPPORT_SYNCML )
+    /* SyncML <Data> content needs a WBXML Tree: don't even try */
+    if ((lang != NULL) &&
+        ((lang->langID == WBXML_LANG_SYNCML_SYNCML10) ||
+         (lang->langID == WBXML_LANG_SYNCML_SYNCML11) ||
+         (lang->langID == WBXML_LANG_SYNCML_SYNCML12)))
+    {
+        xml_ctx->use_tree = TRUE;
+        return;
+    }
+#endif /* WBXML_SUPPORT_SYNCML */
+
+    if (encoder->lang == NULL)
+        encoder->lang = lang;
+
+    if (encoder->lang == NULL) {
+        xml_ctx->error = WBXML_ERROR_BAD_PARAMETER;
+        return;
+    }
+
+    /* Choose Output Charset (as for a WBXML Tree) */
+    if (encoder->output_charset == WBXML_CHARSET_UNKNOWN) {
+        if (charset != WBXML_CHARSET_UNKNOWN)
+            encoder->output_charset = charset;
+        else
+            encoder->output_charset = WBXML_ENCODER_XML_DEFAULT_CHARSET;
+    }
+
+    /* Init Output Buffer */
+    if (!encoder_init_output(encoder)) {
+        xml_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        return;
+    }
+
+    /* Put header first in output */
+    xml_ctx->error = encoder_output_header_first(encoder);
+}
+
+
+/**
+ * @brief WBXMLStartElementHandler of XML encoding while parsing WBXML
+ * @param ctx     The context (WBXMLEncoderXMLCtx)
+ * @param element The Element Tag
+ * @param attrs   The Element Attributes
+ * @note The Start Tag is ended once the Element content is known (cf xml_encode_end_attrs())
+ */
+static void xml_clb_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **attrs)
+{
+    WBXMLEncoderXMLCtx *xml_ctx = (WBXMLEncoderXMLCtx *) ctx;
+    WBXMLEncoder *encoder = xml_ctx->encoder;
+    WBXMLEncoderXMLElt *parent = NULL, *elts = NULL;
+    WB_ULONG i = 0;
+
+    if (xml_ctx->use_tree) {
+        /* Nothing more to encode */
+        wbxml_parser_skip_element(xml_ctx->parser);
+        return;
+    }
+
+    if (xml_ctx->error != WBXML_OK)
+        return;
+
+    /* Encode the Text that comes before */
+    if ((xml_ctx->error = xml_clb_encode_text(xml_ctx)) != WBXML_OK)
+        return;
+
+    if (xml_ctx->depth > 0) {
+        parent = &xml_ctx->elts[xml_ctx->depth - 1];
+
+        if (parent->open) {
+            /* Parent content starts with this Element */
+            parent->open = FALSE;
+            parent->indented = xml_indent_content(encoder, TRUE);
+
+            if ((xml_ctx->error = xml_encode_end_attrs(encoder, TRUE, parent->indented)) != WBXML_OK)
+                return;
+        }
+        else if (!parent->indented && xml_indent_content(encoder, TRUE)) {
+            /* Parent content starts with a Text: it is indented after all */
+            if (!wbxml_buffer_insert_cstr(encoder->output, WBXML_ENCODER_XML_NEW_LINE, parent->content_pos)) {
+                xml_ctx->error = WBXML_ERROR_ENCODER_APPEND_DATA;
+                return;
+            }
+
+            encoder->indent++;
+            parent->indented = TRUE;
+        }
+
+#if defined( WBXML_SUPPORT_SYNCML )
+        if (WBXML_STRCMP(wbxml_tag_get_xml_name(element), "Meta") == 0)
+            parent->has_meta = TRUE;
+#endif /* WBXML_SUPPORT_SYNCML */
+    }
+
+    /* Encode Element Name */
+    if ((xml_ctx->error = xml_encode_tag(encoder, element, xml_tag_switch_page((parent != NULL) ? parent->tag : NULL, element))) != WBXML_OK)
+        return;
+
+    /* Encode Attributes */
+    if ((attrs != NULL) && (encoder->lang->attrTable != NULL)) {
+        for (i = 0; attrs[i] != NULL; i++) {
+            /* Check that this attribute has a name */
+            if (attrs[i]->name == NULL) {
+                xml_ctx->error = WBXML_ERROR_XML_NULL_ATTR_NAME;
+                return;
+            }
+
+            if ((xml_ctx->error = xml_encode_attr(encoder, attrs[i])) != WBXML_OK)
+                return;
+        }
+    }
+
+    /* Push Element */
+    if (xml_ctx->depth == xml_ctx->size) {
+        if ((elts = wbxml_mem_realloc(xml_ctx->encoder->allocator, xml_ctx->elts,
+                                      (xml_ctx->size + WBXML_ENCODER_XML_ELTS_MALLOC_BLOCK) * sizeof(*elts))) == NULL)
+        {
+            xml_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            return;
+        }
+
+        xml_ctx->elts = elts;
+        xml_ctx->size += WBXML_ENCODER_XML_ELTS_MALLOC_BLOCK;
+    }
+
+    xml_ctx->elts[xml_ctx->depth].tag = element;
+    xml_ctx->elts[xml_ctx->depth].open = TRUE;
+    xml_ctx->elts[xml_ctx->depth].indented = FALSE;
+    xml_ctx->elts[xml_ctx->depth].content_pos = 0;
+#if defined( WBXML_SUPPORT_SYNCML )
+    xml_ctx->elts[xml_ctx->depth].has_meta = FALSE;
+#endif /* WBXML_SUPPORT_SYNCML */
+    xml_ctx->depth++;
+}
+
+
+/**
+ * @brief WBXMLEndElementHandler of XML encoding while parsing WBXML
+ * @param ctx     The context (WBXMLEncoderXMLCtx)
+ * @param element The Element Tag
+ */
+static void xml_clb_end_element(void *ctx, WBXMLTag *element)
+{
+    WBXMLEncoderXMLCtx *xml_ctx = (WBXMLEncoderXMLCtx *) ctx;
+    WBXMLEncoder *encoder = xml_ctx->encoder;
+    WBXMLEncoderXMLElt *elt = NULL;
+
+    if ((xml_ctx->error != WBXML_OK) || xml_ctx->use_tree)
+        return;
+
+    if (xml_ctx->depth == 0) {
+        xml_ctx->error = WBXML_ERROR_INTERNAL;
+        return;
+    }
+
+    /* Encode the Text that comes before */
+    if ((xml_ctx->error = xml_clb_encode_text(xml_ctx)) != WBXML_OK)
+        return;
+
+    elt = &xml_ctx->elts[xml_ctx->depth - 1];
+
+    if (elt->open) {
+        /* No content */
+        elt->indented = xml_indent_content(encoder, FALSE);
+
+        if ((xml_ctx->error = xml_encode_end_attrs(encoder, FALSE, elt->indented)) != WBXML_OK)
+            return;
+    }
+
+#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+    if (!elt->open) {
+#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
+
+        /* Encode end tag */
+        if ((xml_ctx->error = xml_encode_end_tag(encoder, elt->tag, elt->indented)) != WBXML_OK)
+            return;
+
+#if defined( WBXML_ENCODER_XML_GEN_EMPTY_ELT )
+    }
+#endif /* WBXML_ENCODER_XML_GEN_EMPTY_ELT */
+
+    /* Pop Element, and reset Current Tag */
+    xml_ctx->depth--;
+    encoder->current_tag = NULL;
+}
+
+
+/**
+ * @brief WBXMLCharactersHandler of XML encoding while parsing WBXML
+ * @param ctx    The context (WBXMLEncoderXMLCtx)
+ * @param ch     The content
+ * @param start  Start of content in 'ch'
+ * @param length Content length
+ * @note As with a WBXML Tree, contiguous contents are one Text: it is encoded at next Element start or end
+ */
+static void xml_clb_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length)
+{
+    WBXMLEncoderXMLCtx *xml_ctx = (WBXMLEncoderXMLCtx *) ctx;
+
+    if ((xml_ctx->error != WBXML_OK) || xml_ctx->use_tree)
+        return;
+
+    if (xml_ctx->depth == 0) {
+        xml_ctx->error = WBXML_ERROR_INTERNAL;
+        return;
+    }
+
+#if defined( WBXML_SUPPORT_SYNCML )
+    if (xml_clb_need_tree(xml_ctx)) {
+        xml_ctx->use_tree = TRUE;
+        return;
+    }
+#endif /* WBXML_SUPPORT_SYNCML */
+
+    if (!wbxml_buffer_append_data(xml_ctx->text, ch + start, length)) {
+        xml_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        return;
+    }
+
+    xml_ctx->in_text = TRUE;
+}
+
+
+/**
+ * @brief Encode the Text of current Element
+ * @param xml_ctx The context
+ * @return WBXML_OK if encoding is OK, an error code otherwise
+ * @note Same rules than parse_text()
+ */
+static WBXMLError xml_clb_encode_text(WBXMLEncoderXMLCtx *xml_ctx)
+{
+    WBXMLEncoder *encoder = xml_ctx->encoder;
+    WBXMLEncoderXMLElt *elt = NULL;
+    WB_BOOL ignore = FALSE;
+    WBXMLError ret = WBXML_OK;
+
+    if (!xml_ctx->in_text)
+        return WBXML_OK;
+
+    elt = &xml_ctx->elts[xml_ctx->depth - 1];
+
+    if (elt->open) {
+        /* Content starts with this Text: it is indented if an Element comes next */
+        elt->open = FALSE;
+        elt->indented = xml_indent_content(encoder, FALSE);
+
+        if ((ret = xml_encode_end_attrs(encoder, TRUE, elt->indented)) != WBXML_OK)
+            return ret;
+
+        elt->content_pos = wbxml_buffer_len(encoder->output);
+    }
+
+    /* Do not modify text inside a BINARY section */
+    /* If Canonical Form: "Ignorable white space is considered significant and is treated equivalently to data" */
+    if (!((encoder->current_tag != NULL) && (encoder->current_tag->options & WBXML_TAG_OPTION_BINARY)) &&
+        (encoder->xml_gen_type != WBXML_GEN_XML_CANONICAL))
+    {
+        if ((encoder->ignore_empty_text) && (wbxml_buffer_contains_only_whitespaces(xml_ctx->text))) {
+            /* Ignore blank text */
+            ignore = TRUE;
+        }
+        else if (encoder->remove_text_blanks) {
+            /* Strip Blanks */
+            wbxml_buffer_strip_blanks(xml_ctx->text);
+        }
+    }
+
+    if (!ignore)
+        ret = xml_encode_text(encoder, xml_ctx->text, xml_indent_content(encoder, FALSE));
+
+    /* Text is done, and there is no more Current Tag */
+    wbxml_buffer_delete(xml_ctx->text, 0, wbxml_buffer_len(xml_ctx->text));
+    xml_ctx->in_text = FALSE;
+    encoder->current_tag = NULL;
+
+    return ret;
+}
+
+
+#if defined( WBXML_SUPPORT_SYNCML )
+
+/**
+ * @brief Tell if the Text of current Element needs a WBXML Tree to be encoded
+ * @param xml_ctx The context
+ * @return TRUE if the document must be encoded from a WBXML Tree
+ * @note This is the case of a <Data> Text that may be an embedded document, or a CDATA section:
+ *       its type is found in the <Meta> of its parent, or grand-parent, or is guessed from an <Add>
+ *       or <Replace> grand-parent (cf wbxml_tree_node_get_syncml_data_type())
+ */
+static WB_BOOL xml_clb_need_tree(WBXMLEncoderXMLCtx *xml_ctx)
+{
+    WBXMLEncoderXMLElt *parent = NULL, *grand_parent = NULL;
+    const WB_TINY *name = NULL;
+
+    if (WBXML_STRCMP(wbxml_tag_get_xml_name(xml_ctx->elts[xml_ctx->depth - 1].tag), "Data") != 0)
+        return FALSE;
+
+    if (xml_ctx->depth < 2)
+        return FALSE;
+
+    parent = &xml_ctx->elts[xml_ctx->depth - 2];
+    if (parent->has_meta)
+        return TRUE;
+
+    if (xml_ctx->depth < 3)
+        return FALSE;
+
+    grand_parent = &xml_ctx->elts[xml_ctx->depth - 3];
+    if (grand_parent->has_meta)
+        return TRUE;
+
+    name = (const WB_TINY *) wbxml_tag_get_xml_name(grand_parent->tag);
+
+    return (WB_BOOL) ((WBXML_STRCMP(name, "Add") == 0) || (WBXML_STRCMP(name, "Replace") == 0));
+}
+
+#endif /* WBXML_SUPPORT_SYNCML */
+
+
+#if defined( HAVE_EXPAT )
+
+/****************************
+ * WBXML Encoding while parsing XML
+ */
+
+/**
+ * @brief Expat Start Element Handler of WBXML encoding while parsing XML
+ * @param ctx       The context (WBXMLEncoderWBXMLCtx)
+ * @param localName The Element name
+ * @param attrs     The Element attributes
+ * @note The Element is encoded as soon as it starts, without content: its Tag token gets
+ *       the content flag once a content is found (cf wbxml_clb_set_content())
+ */
+static void wbxml_clb_start_element(void *ctx, const XML_Char *localName, const XML_Char **attrs)
+{
+    WBXMLEncoderWBXMLCtx *wbxml_ctx = (WBXMLEncoderWBXMLCtx *) ctx;
+    WBXMLEncoder *encoder = wbxml_ctx->encoder;
+    WBXMLEncoderWBXMLElt *parent = NULL, *elt = NULL, *elts = NULL;
+    WBXMLTreeNode *node = NULL;
+    WB_UTINY ch = 0;
+    WB_ULONG pos = 0;
+
+    if (wbxml_ctx->use_tree || (wbxml_ctx->tree_ctx.error != WBXML_OK))
+        return;
+
+    /* Are we skipping a whole node ? */
+    if (wbxml_ctx->tree_ctx.skip_lvl > 0) {
+        wbxml_tree_clb_xml_start_element(ctx, localName, attrs);
+        return;
+    }
+
+    if (wbxml_ctx->depth > 0) {
+        parent = &wbxml_ctx->elts[wbxml_ctx->depth - 1];
+
+        /* Encode the content that comes before */
+        wbxml_clb_encode_content(wbxml_ctx, parent);
+    }
+
+    /* Add Element Node */
+    wbxml_tree_clb_xml_start_element(ctx, localName, attrs);
+
+    node = wbxml_ctx->tree_ctx.current;
+    if ((wbxml_ctx->tree_ctx.error != WBXML_OK) || (node == NULL) || ((parent != NULL) && (node == parent->node))) {
+        /* Error, or skipped Element */
+        return;
+    }
+
+    if (parent == NULL) {
+        /* Root Element: the document Language is known */
+        wbxml_clb_start_document(wbxml_ctx);
+
+        if (wbxml_ctx->use_tree) {
+            XML_StopParser(wbxml_ctx->tree_ctx.xml_parser, XML_FALSE);
+            return;
+        }
+    }
+    else {
+        /* Parent content starts, or goes on, with this Element */
+        wbxml_clb_set_content(wbxml_ctx, parent);
+
+#if defined( WBXML_SUPPORT_SYNCML )
+        if (WBXML_STRCMP(wbxml_tag_get_xml_name(node->name), "Meta") == 0)
+            parent->has_meta = TRUE;
+#endif /* WBXML_SUPPORT_SYNCML */
+    }
+
+    /* Push Element */
+    if (wbxml_ctx->depth == wbxml_ctx->size) {
+        if ((elts = wbxml_mem_realloc(wbxml_ctx->encoder->allocator, wbxml_ctx->elts,
+                                      (wbxml_ctx->size + WBXML_ENCODER_XML_ELTS_MALLOC_BLOCK) * sizeof(*elts))) == NULL)
+        {
+            wbxml_ctx->tree_ctx.error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            return;
+        }
+
+        wbxml_ctx->elts = elts;
+        wbxml_ctx->size += WBXML_ENCODER_XML_ELTS_MALLOC_BLOCK;
+    }
+
+    elt = &wbxml_ctx->elts[wbxml_ctx->depth++];
+    elt->node = node;
+    elt->tag_pos = 0;
+    elt->has_content = FALSE;
+#if defined( WBXML_SUPPORT_SYNCML )
+    elt->has_meta = FALSE;
+#endif /* WBXML_SUPPORT_SYNCML */
+
+    if (wbxml_ctx->error != WBXML_OK)
+        return;
+
+    /* Encode Element, and its Attributes */
+    pos = wbxml_buffer_len(encoder->output);
+    encoder->current_node = node;
+
+    if ((wbxml_ctx->error = parse_element(encoder, node, FALSE)) != WBXML_OK)
+        return;
+
+    /* The Tag token comes after a Switch Page (cf wbxml_encode_tag_token()) */
+    if (wbxml_buffer_get_char(encoder->output, pos, &ch) && (ch == WBXML_SWITCH_PAGE))
+        pos += 2;
+
+    elt->tag_pos = pos;
+}
+
+
+/**
+ * @brief Expat End Element Handler of WBXML encoding while parsing XML
+ * @param ctx       The context (WBXMLEncoderWBXMLCtx)
+ * @param localName The Element name
+ * @note Once encoded, the Element is removed from the WBXML Tree
+ */
+static void wbxml_clb_end_element(void *ctx, const XML_Char *localName)
+{
+    WBXMLEncoderWBXMLCtx *wbxml_ctx = (WBXMLEncoderWBXMLCtx *) ctx;
+    WBXMLEncoder *encoder = wbxml_ctx->encoder;
+    WBXMLEncoderWBXMLElt *elt = NULL;
+    WBXMLTreeNode *node = NULL;
+
+    if (wbxml_ctx->use_tree || (wbxml_ctx->tree_ctx.error != WBXML_OK))
+        return;
+
+    /* Are we skipping a whole node ? */
+    if (wbxml_ctx->tree_ctx.skip_lvl > 0) {
+        wbxml_tree_clb_xml_end_element(ctx, localName);
+        return;
+    }
+
+    if (wbxml_ctx->depth == 0) {
+        wbxml_ctx->tree_ctx.error = WBXML_ERROR_INTERNAL;
+        return;
+    }
+
+    elt = &wbxml_ctx->elts[wbxml_ctx->depth - 1];
+    node = elt->node;
+
+    /* End Element Node (a Binary content is added now) */
+    wbxml_tree_clb_xml_end_element(ctx, localName);
+
+    if (wbxml_ctx->tree_ctx.error != WBXML_OK)
+        return;
+
+    /* Encode the content that comes before */
+    wbxml_clb_encode_content(wbxml_ctx, elt);
+
+    /* Encode Element end */
+    if (wbxml_ctx->error == WBXML_OK)
+        wbxml_ctx->error = parse_element_end(encoder, node, elt->has_content);
+
+    /* Pop Element, and reset Current Tag and Current Node (as parse_node() does) */
+    wbxml_ctx->depth--;
+    encoder->current_tag = NULL;
+    encoder->current_node = NULL;
+
+    /* Forget it */
+    wbxml_tree_extract_node(wbxml_ctx->tree_ctx.tree, node);
+    wbxml_tree_node_destroy(node);
+
+    if (wbxml_ctx->depth == 0)
+        wbxml_ctx->tree_ctx.current = NULL;
+}
+
+
+/**
+ * @brief Expat Characters Handler of WBXML encoding while parsing XML
+ * @param ctx The context (WBXMLEncoderWBXMLCtx)
+ * @param ch  The content
+ * @param len Content length
+ * @note As with a WBXML Tree, contiguous contents are one Text: it is encoded at next Element start or end
+ */
+static void wbxml_clb_characters(void *ctx, const XML_Char *ch, int len)
+{
+    WBXMLEncoderWBXMLCtx *wbxml_ctx = (WBXMLEncoderWBXMLCtx *) ctx;
+
+    if (wbxml_ctx->use_tree)
+        return;
+
+#if defined( WBXML_SUPPORT_SYNCML )
+    if ((wbxml_ctx->tree_ctx.error == WBXML_OK) &&
+        (wbxml_ctx->tree_ctx.skip_lvl == 0) &&
+        wbxml_clb_need_tree(wbxml_ctx))
+    {
+        wbxml_ctx->use_tree = TRUE;
+        XML_StopParser(wbxml_ctx->tree_ctx.xml_parser, XML_FALSE);
+        return;
+    }
+#endif /* WBXML_SUPPORT_SYNCML */
+
+    /* Add Text Node */
+    wbxml_tree_clb_xml_characters(ctx, ch, len);
+}
+
+
+/**
+ * @brief Start encoding the document, once its Language is known
+ * @param wbxml_ctx The context
+ * @note The document is encoded from a WBXML Tree if this is a SyncML one, or if it uses
+ *       a String Table (it is only known once the whole document has been parsed).
+ */
+static void wbxml_clb_start_document(WBXMLEncoderWBXMLCtx *wbxml_ctx)
+{
+    WBXMLEncoder *encoder = wbxml_ctx->encoder;
+    WBXMLTree *tree = wbxml_ctx->tree_ctx.tree;
+
+    if (encoder->lang == NULL)
+        encoder->lang = tree->lang;
+
+    if (encoder->lang == NULL) {
+        wbxml_ctx->error = WBXML_ERROR_BAD_PARAMETER;
+        return;
+    }
+
+#if defined( WBXML_SUPPORT_SYNCML )
+    /* SyncML <Data> content needs a WBXML Tree: don't even try */
+    if ((encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML10) ||
+        (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML11) ||
+        (encoder->lang->langID == WBXML_LANG_SYNCML_SYNCML12))
+    {
+        wbxml_ctx->use_tree = TRUE;
+        return;
+    }
+#endif /* WBXML_SUPPORT_SYNCML */
+
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    /* Choose if we will use String Table */
+    encoder_choose_strtbl(encoder);
+
+    if (encoder->use_strtbl) {
+        wbxml_ctx->use_tree = TRUE;
+        return;
+    }
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
+    /* Choose Output Charset (as for a WBXML Tree) */
+    if (encoder->output_charset == WBXML_CHARSET_UNKNOWN) {
+        if (tree->orig_charset != WBXML_CHARSET_UNKNOWN)
+            encoder->output_charset = tree->orig_charset;
+        else
+            encoder->output_charset = WBXML_ENCODER_XML_DEFAULT_CHARSET;
+    }
+
+    /* Init Output Buffer */
+    if (!encoder_init_output(encoder)) {
+        wbxml_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        return;
+    }
+
+    /* Put header first in output */
+    wbxml_ctx->error = encoder_output_header_first(encoder);
+}
+
+
+/**
+ * @brief Set the content flag of an Element Tag token
+ * @param wbxml_ctx The context
+ * @param elt       The Element
+ */
+static void wbxml_clb_set_content(WBXMLEncoderWBXMLCtx *wbxml_ctx, WBXMLEncoderWBXMLElt *elt)
+{
+    WB_UTINY token = 0;
+
+    if (elt->has_content)
+        return;
+
+    elt->has_content = TRUE;
+
+    if ((wbxml_ctx->error == WBXML_OK) && wbxml_buffer_get_char(wbxml_ctx->encoder->output, elt->tag_pos, &token))
+        wbxml_buffer_set_char(wbxml_ctx->encoder->output, elt->tag_pos, (WB_UTINY) (token | WBXML_TOKEN_WITH_CONTENT));
+}
+
+
+/**
+ * @brief Encode the content of an Element that is not encoded yet, and remove it from the WBXML Tree
+ * @param wbxml_ctx The context
+ * @param elt       The Element
+ * @note This is the Texts and CDATA sections (and embedded documents) since the last Element start or end
+ */
+static void wbxml_clb_encode_content(WBXMLEncoderWBXMLCtx *wbxml_ctx, WBXMLEncoderWBXMLElt *elt)
+{
+    WBXMLTreeNode *child = NULL;
+
+    if (elt->node->children == NULL)
+        return;
+
+    wbxml_clb_set_content(wbxml_ctx, elt);
+
+    if (wbxml_ctx->error == WBXML_OK)
+        wbxml_ctx->error = parse_node(wbxml_ctx->encoder, elt->node->children, TRUE);
+
+    while ((child = elt->node->children) != NULL) {
+        wbxml_tree_extract_node(wbxml_ctx->tree_ctx.tree, child);
+        wbxml_tree_node_destroy_all(child);
+    }
+}
+
+
+#if defined( WBXML_SUPPORT_SYNCML )
+
+/**
+ * @brief Tell if the Text of current Element needs a WBXML Tree to be built
+ * @param wbxml_ctx The context
+ * @return TRUE if the document must be encoded from a WBXML Tree
+ * @note This is the case of a <Data> Text that may be changed while building the WBXML Tree: its type is
+ *       found in the <Meta> of its parent, or grand-parent, that may already be encoded (cf xml_clb_need_tree())
+ */
+static WB_BOOL wbxml_clb_need_tree(WBXMLEncoderWBXMLCtx *wbxml_ctx)
+{
+    WBXMLEncoderWBXMLElt *parent = NULL, *grand_parent = NULL;
+    const WB_TINY *name = NULL;
+
+    if (wbxml_ctx->depth == 0)
+        return FALSE;
+
+    if (WBXML_STRCMP(wbxml_tag_get_xml_name(wbxml_ctx->elts[wbxml_ctx->depth - 1].node->name), "Data") != 0)
+        return FALSE;
+
+    if (wbxml_ctx->depth < 2)
+        return FALSE;
+
+    parent = &wbxml_ctx->elts[wbxml_ctx->depth - 2];
+    if (parent->has_meta)
+        return TRUE;
+
+    if (wbxml_ctx->depth < 3)
+        return FALSE;
+
+    grand_parent = &wbxml_ctx->elts[wbxml_ctx->depth - 3];
+    if (grand_parent->has_meta)
+        return TRUE;
+
+    name = (const WB_TINY *) wbxml_tag_get_xml_name(grand_parent->node->name);
+
+    return (WB_BOOL) ((WBXML_STRCMP(name, "Add") == 0) || (WBXML_STRCMP(name, "Replace") == 0));
+}
+
+#endif /* WBXML_SUPPORT_SYNCML */
+
+#endif /* HAVE_EXPAT */
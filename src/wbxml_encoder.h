@@ -60,6 +60,27 @@ typedef enum WBXMLEncoderOutputType_e {
     WBXML_ENCODER_OUTPUT_XML
 } WBXMLEncoderOutputType;
 
+/**
+ * @brief WBXML Encoder Write Handler
+ * @param ctx  User data given to wbxml_encoder_encode_tree_to_handler()
+ * @param data Next bytes of the output document
+ * @param len  Number of bytes
+ * @return WBXML_OK to go on encoding, an error code (returned by the encoder) to stop it
+ */
+typedef WBXMLError (*WBXMLEncoderWriteHandler)(void *ctx, const WB_UTINY *data, WB_ULONG len);
+
+/** Number of parts of an encoded document (see wbxml_encoder_get_output_parts()) */
+#define WBXML_ENCODER_OUTPUT_PARTS 3
+
+/**
+ * @brief A part of an encoded document
+ * @note Copy 'data' and 'len' to the fields of a 'struct iovec' to write parts with writev()
+ */
+typedef struct WBXMLEncoderOutputPart_s {
+    const WB_UTINY *data; /**< Part data (owned by the encoder) */
+    WB_ULONG        len;  /**< Part length (can be 0) */
+} WBXMLEncoderOutputPart;
+
 
 /**
  * @brief Create a WBXML Encoder
@@ -69,6 +90,17 @@ typedef enum WBXMLEncoderOutputType_e {
 WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_real(void);
 #define wbxml_encoder_create() wbxml_mem_cleam(wbxml_encoder_create_real())
 
+/**
+ * @brief Create a WBXML Encoder with an Allocator
+ * @param allocator The Allocator of the Encoder (NULL to use the default one)
+ * @result Return the newly created WBXMLEncoder, or NULL if not enough memory
+ * @note All the memory of the Encoder, and the documents it gives, are allocated with this
+ *       Allocator: these documents must be freed with wbxml_mem_free(allocator, ...).
+ * @warning Do NOT use this function directly, use wbxml_encoder_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLEncoder *) wbxml_encoder_create_with_allocator_real(WBXMLAllocator *allocator);
+#define wbxml_encoder_create_with_allocator(a) wbxml_mem_cleam(wbxml_encoder_create_with_allocator_real(a))
+
 /**
  * @brief Destroy a WBXML Encoder
  * @param encoder The WBXMLEncoder to free
@@ -120,6 +152,18 @@ WBXML_DECLARE(void) wbxml_encoder_set_output_charset(WBXMLEncoder *encoder, WBXM
  */
 WBXML_DECLARE(void) wbxml_encoder_set_use_strtbl(WBXMLEncoder *encoder, WB_BOOL use_strtbl);
 
+/**
+ * @brief Set if String Table content is chosen by bytes saved [Default: FALSE]
+ * @param encoder [in] The WBXML Encoder
+ * @param optimal [in] TRUE to choose any String found more than once (a whole text, or a part of it) that
+ *                     saves bytes, the ones that save the most first. FALSE to choose texts, then words,
+ *                     found more than once.
+ * @note Documents are smaller, but encoding takes longer. A String that ends another one of String Table
+ *       is referenced inside it, instead of being stored again.
+ * @note This function has no effect if WBXML_ENCODER_USE_STRTBL compilation flag is not set
+ */
+WBXML_DECLARE(void) wbxml_encoder_set_optimal_strtbl(WBXMLEncoder *encoder, WB_BOOL optimal);
+
 /**
  * @brief Set if we want to produce anonymous WBXML documents [Default: FALSE]
  * @param encoder [in] The WBXML encoder
@@ -157,6 +201,8 @@ WBXML_DECLARE(void) wbxml_encoder_set_indent(WBXMLEncoder *encoder, WB_UTINY ind
  *
  * @param encoder [in] The WBXML Encoder to use
  * @param tree [in] The WBXML Tree to encode
+ * @note The Tree is only read, never modified, by encoding: it can be encoded several times,
+ *       and at the same time by several encoders (one per thread).
  */
 WBXML_DECLARE(void) wbxml_encoder_set_tree(WBXMLEncoder *encoder, WBXMLTree *tree);
 
@@ -169,6 +215,8 @@ WBXML_DECLARE(void) wbxml_encoder_set_tree(WBXMLEncoder *encoder, WBXMLTree *tre
  * @param wbxml [out] Resulting WBXML document
  * @param wbxml_len [out] The resulting WBXML document length
  * @return Return WBXML_OK if no error, an error code otherwise
+ * @note When no String Table is used, the encoder output memory is given as is (without being copied):
+ *       the encoder output is then empty.
  * @warning The 'encoder->tree' WBXMLLib Tree MUST be already set with a call to wbxml_encoder_set_tree() function
  */
 WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_wbxml(WBXMLEncoder *encoder, WB_UTINY **wbxml, WB_ULONG *wbxml_len);
@@ -176,6 +224,33 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_wbxml(WBXMLEncoder *encod
 /* BC */
 #define wbxml_encoder_encode_to_wbxml(a,b,c) wbxml_encoder_encode_tree_to_wbxml(a,b,c)
 
+/**
+ * @brief Encode the WBXML Tree attached to this encoder into WBXML, leaving out some Text Nodes
+ *
+ * Call wbxml_encoder_set_tree() before using this method.
+ *
+ * The Text Nodes given as Slots are not encoded, nor put in String Table: the position where each
+ * one would have been encoded is given instead, so that any value can be inserted there later
+ * (cf wbxml_template_create()).
+ *
+ * @param encoder   [in]  The WBXML Encoder to use
+ * @param slots     [in]  The Text Nodes to leave out
+ * @param nb_slots  [in]  Number of Text Nodes
+ * @param slots_pos [out] Position of each Text Node in WBXML document ('nb_slots' items)
+ * @param wbxml     [out] Resulting WBXML document
+ * @param wbxml_len [out] The resulting WBXML document length
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @note A Text Node that is not found (not in Tree, or in an embedded Tree) gives WBXML_ERROR_BAD_PARAMETER,
+ *       and a Text Node in a CDATA section gives WBXML_ERROR_XML_NODE_NOT_ALLOWED.
+ * @note Flow Mode can't be used.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_with_slots(WBXMLEncoder *encoder,
+                                                                WBXMLTreeNode **slots,
+                                                                WB_ULONG nb_slots,
+                                                                WB_ULONG *slots_pos,
+                                                                WB_UTINY **wbxml,
+                                                                WB_ULONG *wbxml_len);
+
 /**
  * @brief Encode the WBXML Tree attached to this encoder into XML
  *
@@ -185,6 +260,7 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_wbxml(WBXMLEncoder *encod
  * @param xml     [out] Resulting XML document
  * @param xml_len [out] XML document length
  * @return Return WBXML_OK if no error, an error code otherwise
+ * @note The encoder output memory is given as is (without being copied): the encoder output is then empty.
  * @warning The 'encoder->tree' WBXMLLib Tree MUST be already set with a call to wbxml_encoder_set_tree() function
  */
 WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_xml(WBXMLEncoder *encoder, WB_UTINY **xml, WB_ULONG *xml_len);
@@ -192,6 +268,81 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_xml(WBXMLEncoder *encoder
 /* BC */
 #define wbxml_encoder_encode_to_xml(a,b,c) wbxml_encoder_encode_tree_to_xml(a,b,c)
 
+/**
+ * @brief Encode the WBXML Tree attached to this encoder, giving the output document to a Write Handler
+ *
+ * Call wbxml_encoder_set_tree() before using this method.
+ *
+ * The output is not kept in memory to be copied at the end: if no String Table is needed (XML output,
+ * or WBXML output without String Table), the header is written first, and then the document as it is
+ * encoded, by blocks. Else the header can only be built once the whole document is encoded: the body is
+ * then kept, and written just after the header and String Table.
+ *
+ * @param encoder     [in] The WBXML Encoder to use
+ * @param output_type [in] The output type (WBXML_ENCODER_OUTPUT_XML | WBXML_ENCODER_OUTPUT_WBXML)
+ * @param handler     [in] The Write Handler, called with the successive parts of the output document
+ * @param ctx         [in] User data given to the Write Handler
+ * @return Return WBXML_OK if no error, an error code otherwise (the document is then partially written)
+ * @warning This method can't be used in 'Flow Mode'
+ */
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_tree_to_handler(WBXMLEncoder *encoder,
+                                                               WBXMLEncoderOutputType output_type,
+                                                               WBXMLEncoderWriteHandler handler,
+                                                               void *ctx);
+
+/**
+ * @brief Encode a WBXML document into XML, while it is parsed
+ *
+ * No WBXML Tree is built: each Element is encoded as soon as it is parsed, so that memory only depends on
+ * the nesting depth of Elements (and on the output). The resulting XML is the same as the one of
+ * wbxml_encoder_encode_tree_to_xml() with a tree built by wbxml_tree_from_wbxml().
+ *
+ * A SyncML document still needs a WBXML Tree, as the type of a <Data> content is found in other Elements
+ * (it can be an embedded document): it is then built and encoded as usual.
+ *
+ * @param encoder   [in] The WBXML Encoder to use
+ * @param wbxml     [in] The WBXML document to encode (parsed in place, see wbxml_parser_parse_static())
+ * @param wbxml_len [in] The WBXML document length
+ * @param lang      [in] Can be used to force parsing of a given Language (set it to WBXML_LANG_UNKNOWN if you don't want to force anything)
+ * @param charset   [in] This is the document charset to use if it is not specified in the document (set it to WBXML_CHARSET_UNKNOWN if you don't want to force anything)
+ * @param xml       [out] Resulting XML document
+ * @param xml_len   [out] XML document length
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @warning This method can't be used in 'Flow Mode'
+ */
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_wbxml_to_xml(WBXMLEncoder *encoder,
+                                                            const WB_UTINY *wbxml,
+                                                            WB_ULONG wbxml_len,
+                                                            WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum charset,
+                                                            WB_UTINY **xml,
+                                                            WB_ULONG *xml_len);
+
+/**
+ * @brief Encode an XML document into WBXML, while it is parsed
+ *
+ * Without String Table (see wbxml_encoder_set_use_strtbl()), no WBXML Tree of the whole document is built:
+ * each Element is encoded as soon as it is parsed, and then forgotten, so that memory only depends on the
+ * nesting depth of Elements (and on the output). The resulting WBXML is the same as the one of
+ * wbxml_encoder_encode_tree_to_wbxml() with a tree built by wbxml_tree_from_xml().
+ *
+ * A document that uses a String Table (it is only known at the end of document), or a SyncML document,
+ * still needs a WBXML Tree: it is then built and encoded as usual.
+ *
+ * @param encoder   [in] The WBXML Encoder to use
+ * @param xml       [in] The XML document to encode
+ * @param xml_len   [in] The XML document length
+ * @param wbxml     [out] Resulting WBXML document
+ * @param wbxml_len [out] WBXML document length
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @warning This method can't be used in 'Flow Mode'
+ */
+WBXML_DECLARE(WBXMLError) wbxml_encoder_encode_xml_to_wbxml(WBXMLEncoder *encoder,
+                                                            WB_UTINY *xml,
+                                                            WB_ULONG xml_len,
+                                                            WB_UTINY **wbxml,
+                                                            WB_ULONG *wbxml_len);
+
 
 /**
  * @brief Set the encoder into 'Flow Mode' (to encode nodes directly)
@@ -297,6 +448,20 @@ WBXML_DECLARE(WBXMLError) wbxml_encoder_get_output(WBXMLEncoder *encoder, WB_UTI
  */
 WBXML_DECLARE(WB_ULONG) wbxml_encoder_get_output_len(WBXMLEncoder *encoder);
 
+/**
+ * @brief Get currently encoded document, as parts that are not concatenated
+ *
+ * Parts are the header, the String Table and the body of the document (for XML output, the String Table
+ * part is always empty). The document is their concatenation, but nothing is copied: this is the way
+ * to send a document with a scatter-gather call like writev().
+ *
+ * @param encoder [in] The WBXML Encoder to use
+ * @param parts   [out] The WBXML_ENCODER_OUTPUT_PARTS parts of document
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @warning Parts data are owned by the encoder: they are valid until the encoder is modified, reset or destroyed
+ */
+WBXML_DECLARE(WBXMLError) wbxml_encoder_get_output_parts(WBXMLEncoder *encoder, WBXMLEncoderOutputPart parts[WBXML_ENCODER_OUTPUT_PARTS]);
+
 /**
  * @brief Delete bytes from output buffer (from end of buffer)
  * @param encoder [in] The WBXML Encoder to use
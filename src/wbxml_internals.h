@@ -90,6 +90,13 @@ typedef enum WBXMLWVDataType_e {
 /** Generic macro to get number of elements in a table */
 #define WBXML_TABLE_SIZE(table) ((WB_LONG)(sizeof(table) / sizeof(table[0])))
 
+/** Storage of a variable that has its own value in each thread (not defined if unknown for this compiler) */
+#if defined( WIN32 )
+#define WBXML_THREAD_LOCAL __declspec(thread)
+#elif defined( __GNUC__ )
+#define WBXML_THREAD_LOCAL __thread
+#endif /* WIN32 */
+
 /* We are good coders and we don't want to ignore Warnings :) */
 #ifdef WIN32
 #pragma warning(error: 4001) /**< nonstandard extension 'single line comment' was used (disallow "//" C++ comments) */
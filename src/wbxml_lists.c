@@ -36,26 +36,23 @@
 #include "wbxml.h"
 #include "wbxml_lists.h"
 
-/** Element of this list */
-typedef struct WBXMLListElt_s
-{
-    void *item;                     /**< Element item */
-    struct WBXMLListElt_s *next;    /**< Next Element */  
-} WBXMLListElt;
+/** Initial number of items of a List array */
+#define WBXML_LIST_MALLOC_BLOCK 8
 
 /** The Generic List type */
 struct WBXMLList_s
 {
-    WBXMLListElt *head;         /**< Head of the list */
-    WBXMLListElt *tail;         /**< Tail of the list */
+    void **items;               /**< Array of items (the List is 'items[first]' to 'items[first + len - 1]') */
+    WB_ULONG first;             /**< Index of first item in array (items before were extracted) */
     WB_ULONG len;               /**< Number of elements in List */
+    WB_ULONG size;              /**< Number of items the array can hold */
+    WBXMLArena *arena;          /**< Arena where List and array are allocated (NULL if malloced) */
+    WBXMLAllocator *allocator;  /**< Allocator of List and array (NULL if default one is used) */
 };
 
 /* Private functions prototypes */
-static WBXMLListElt *wbxml_elt_create_real(void *item);
-#define wbxml_elt_create(a) wbxml_mem_cleam(wbxml_elt_create_real(a))
-
-static void wbxml_elt_destroy(WBXMLListElt *elt, WBXMLListEltCleaner *destructor);
+static void wbxml_list_init(WBXMLList *list, WBXMLArena *arena, WBXMLAllocator *allocator);
+static WB_BOOL wbxml_list_grow(WBXMLList *list);
 
 
 /**********************************
@@ -63,36 +60,56 @@ static void wbxml_elt_destroy(WBXMLListElt *elt, WBXMLListEltCleaner *destructor
  */
 
 WBXML_DECLARE(WBXMLList *) wbxml_list_create_real(void)
+{
+    return wbxml_list_create_with_allocator_real(NULL);
+}
+
+
+WBXML_DECLARE(WBXMLList *) wbxml_list_create_with_allocator_real(WBXMLAllocator *allocator)
 {
     WBXMLList *list = NULL;
     
-    if ((list = wbxml_malloc(sizeof(WBXMLList))) == NULL)
+    if ((list = wbxml_mem_malloc(allocator, sizeof(WBXMLList))) == NULL)
         return NULL;
 
-    list->head = NULL;
-    list->tail = NULL;
-    list->len = 0;
+    wbxml_list_init(list, NULL, allocator);
     
     return list;    
 }
 
 
+WBXML_DECLARE(WBXMLList *) wbxml_list_create_in_arena_real(WBXMLArena *arena)
+{
+    WBXMLList *list = NULL;
+
+    if (arena == NULL)
+        return wbxml_list_create_real();
+
+    if ((list = wbxml_arena_alloc(arena, sizeof(WBXMLList))) == NULL)
+        return NULL;
+
+    wbxml_list_init(list, arena, wbxml_arena_get_allocator(arena));
+
+    return list;
+}
+
+
 WBXML_DECLARE(void) wbxml_list_destroy(WBXMLList *list, WBXMLListEltCleaner *destructor)
 {
-    WBXMLListElt *elt = NULL, *next = NULL;
+    WB_ULONG i = 0;
 
     if (list == NULL)
         return;
 
-    elt = list->head;
-
-    while (elt != NULL) {
-        next = elt->next;
-        wbxml_elt_destroy(elt, destructor);
-        elt = next;
+    if (destructor != NULL) {
+        for (i = 0; i < list->len; i++)
+            destructor(list->items[list->first + i]);
     }
 
-    wbxml_free(list);
+    if (list->arena == NULL) {
+        wbxml_mem_free(list->allocator, list->items);
+        wbxml_mem_free(list->allocator, list);
+    }
 }
 
 
@@ -113,21 +130,10 @@ WBXML_DECLARE(WB_BOOL) wbxml_list_append(WBXMLList *list, void *item)
     if (item == NULL)
         return FALSE;
 
-    if (list->head == NULL) {
-        /* Empty list */
-        if ((list->head = wbxml_elt_create(item)) == NULL)
-            return FALSE;
-
-        list->tail = list->head;
-    }
-    else {
-        /* Element is the new Tail */
-        if ((list->tail->next = wbxml_elt_create(item)) == NULL)
-            return FALSE;
-
-        list->tail = list->tail->next;
-    }
+    if ((list->first + list->len == list->size) && !wbxml_list_grow(list))
+        return FALSE;
 
+    list->items[list->first + list->len] = item;
     list->len++;
 
     return TRUE;
@@ -136,51 +142,31 @@ WBXML_DECLARE(WB_BOOL) wbxml_list_append(WBXMLList *list, void *item)
 
 WBXML_DECLARE(WB_BOOL) wbxml_list_insert(WBXMLList *list, void *item, WB_ULONG pos)
 {
-    WBXMLListElt *elt = NULL, *prev = NULL, *new_elt = NULL;
-    WB_ULONG i = 0;
-
     if (list == NULL)
         return FALSE;
 
     if (item == NULL)
         return FALSE;
 
-    if ((new_elt = wbxml_elt_create(item)) == NULL)
-        return FALSE;
+    /* If position is greater than list length, just append it at tail */
+    if (pos >= list->len)
+        return wbxml_list_append(list, item);
 
-    /* Empty List */
-    if (list->len == 0) {
-        list->head = new_elt;
-        list->tail = list->head;
+    if ((pos == 0) && (list->first > 0)) {
+        /* Insert at Head, in place of an extracted item */
+        list->first--;
     }
     else {
-        /* Insert at Head */
-        if (pos == 0) {
-            /* New Head */
-            new_elt->next = list->head;
-            list->head = new_elt;
-        }
-        else {
-            /* If position is greater than list length, just append it at tail */
-            if (pos >= list->len) {
-                list->tail->next = new_elt;
-                list->tail = list->tail->next;
-            }
-            else {
-                /* Insert Element */
-                elt = list->head;
-
-                for (i=0; i<pos; i++) {
-                    prev = elt;
-                    elt = elt->next;
-                }
-
-                prev->next = new_elt;
-                new_elt->next = elt;
-            }
-        }
+        if ((list->first + list->len == list->size) && !wbxml_list_grow(list))
+            return FALSE;
+
+        /* Move next items */
+        memmove(list->items + list->first + pos + 1,
+                list->items + list->first + pos,
+                (list->len - pos) * sizeof(void *));
     }
 
+    list->items[list->first + pos] = item;
     list->len++;
 
     return TRUE;
@@ -189,40 +175,30 @@ WBXML_DECLARE(WB_BOOL) wbxml_list_insert(WBXMLList *list, void *item, WB_ULONG p
 
 WBXML_DECLARE(void *) wbxml_list_get(WBXMLList *list, WB_ULONG index)
 {
-    WBXMLListElt *elt = NULL;
-    WB_ULONG i = 0;
-
-    if ((list == NULL) || (index >= wbxml_list_len(list)))
+    if ((list == NULL) || (index >= list->len))
         return NULL;    
 
-    /* We start to search from head */
-    elt = list->head;
-
-    for (i=0; i<index; i++)
-        elt = elt->next;
-
-    return elt->item;
+    return list->items[list->first + index];
 }
 
 
 WBXML_DECLARE(void *) wbxml_list_extract_first(WBXMLList *list)
 {
-    WBXMLListElt *elt = NULL;
     void *result = NULL;
 
-    if ((list == NULL) || (wbxml_list_len(list) == 0))
+    if ((list == NULL) || (list->len == 0))
         return NULL;
 
-    elt = list->head;
-    result = elt->item;
-
-    if ((list->head = list->head->next) == NULL)
-        list->tail = NULL;
-
-    wbxml_elt_destroy(elt, NULL);
+    result = list->items[list->first];
 
     list->len--;
 
+    /* Array is reused from start when list is empty */
+    if (list->len == 0)
+        list->first = 0;
+    else
+        list->first++;
+
     return result;
 }
 
@@ -232,40 +208,53 @@ WBXML_DECLARE(void *) wbxml_list_extract_first(WBXMLList *list)
  */
 
 /**
- * @brief Create a List Element
- * @param item Item of Element to create
- * @return The newly created Element, or NULL if not enough memory
- * @warning Do NOT use this function directly, use wbxml_list_create() macro instead
+ * @brief Initialize an empty List (the array is allocated with first item)
+ * @param list  The List
+ * @param arena The Arena where List array is allocated (NULL to use malloc)
+ * @param allocator The Allocator of List array (NULL to use the default one)
  */
-static WBXMLListElt *wbxml_elt_create_real(void *item)
+static void wbxml_list_init(WBXMLList *list, WBXMLArena *arena, WBXMLAllocator *allocator)
 {
-    WBXMLListElt *elt = NULL;
-
-    if (item == NULL)
-        return NULL;
-
-    if ((elt = wbxml_malloc(sizeof(WBXMLListElt))) == NULL)
-        return NULL;
-
-    elt->item = item;
-    elt->next = NULL;
-
-    return elt;
+    list->items = NULL;
+    list->first = 0;
+    list->len = 0;
+    list->size = 0;
+    list->arena = arena;
+    list->allocator = allocator;
 }
 
 
 /**
- * @brief Destroy a List Element
- * @param elt The element to destroy
- * @param destructor The Destructor Function to clean Element Item (can be NULL)
+ * @brief Make room for one more item at end of List array
+ * @param list The List (its array is full)
+ * @return TRUE if done, FALSE if not enough memory
+ * @note If at least half of array was freed by wbxml_list_extract_first(), items are moved
+ *       to start of array. Else array size is doubled, so that appending is done in
+ *       amortized constant time.
  */
-static void wbxml_elt_destroy(WBXMLListElt *elt, WBXMLListEltCleaner *destructor)
+static WB_BOOL wbxml_list_grow(WBXMLList *list)
 {
-    if (elt == NULL)
-        return;
+    void **items = NULL;
+    WB_ULONG size = 0;
+
+    if ((list->first > 0) && (list->first >= list->size / 2)) {
+        memmove(list->items, list->items + list->first, list->len * sizeof(void *));
+        list->first = 0;
+        return TRUE;
+    }
+
+    size = (list->size == 0) ? WBXML_LIST_MALLOC_BLOCK : list->size * 2;
 
-    if (destructor != NULL)
-        destructor(elt->item);
+    if (list->arena != NULL)
+        items = wbxml_arena_realloc(list->arena, list->items, list->size * sizeof(void *), size * sizeof(void *));
+    else
+        items = wbxml_mem_realloc(list->allocator, list->items, size * sizeof(void *));
 
-    wbxml_free(elt);
+    if (items == NULL)
+        return FALSE;
+
+    list->items = items;
+    list->size = size;
+
+    return TRUE;
 }
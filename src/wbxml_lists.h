@@ -37,6 +37,7 @@
 #define WBXML_LISTS_H
 
 #include "wbxml_mem.h"
+#include "wbxml_arena.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,6 +67,26 @@ typedef void WBXMLListEltCleaner(void *item);
 WBXML_DECLARE(WBXMLList *) wbxml_list_create_real(void);
 #define wbxml_list_create() wbxml_mem_cleam(wbxml_list_create_real())
 
+/**
+ * @brief Create a List with an Allocator
+ * @param allocator The Allocator of the List (NULL to use the default one)
+ * @return The newly created List, or NULL if not enough memory
+ * @warning Do NOT use this function directly, use wbxml_list_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLList *) wbxml_list_create_with_allocator_real(WBXMLAllocator *allocator);
+#define wbxml_list_create_with_allocator(a) wbxml_mem_cleam(wbxml_list_create_with_allocator_real(a))
+
+/**
+ * @brief Create a List in an Arena
+ * @param arena The Arena where the List (and its elements) are allocated (NULL to use malloc)
+ * @return The newly created List, or NULL if not enough memory
+ * @note The List memory is only released with the Arena: wbxml_list_destroy() only calls
+ *       the destructor on each item.
+ * @warning Do NOT use this function directly, use wbxml_list_create_in_arena() macro instead
+ */
+WBXML_DECLARE(WBXMLList *) wbxml_list_create_in_arena_real(WBXMLArena *arena);
+#define wbxml_list_create_in_arena(a) wbxml_mem_cleam(wbxml_list_create_in_arena_real(a))
+
 /**
  * @brief Destroy a List
  * @param list The List to destroy
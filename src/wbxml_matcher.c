@@ -0,0 +1,476 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_matcher.c
+ * @ingroup wbxml_matcher
+ *
+ * @date 26/10/17
+ *
+ * @brief Multi-Pattern String Matcher (Aho-Corasick)
+ */
+
+#include "wbxml.h"
+#include "wbxml_matcher.h"
+
+/** Default number of allocated nodes */
+#define WBXML_MATCHER_DEFAULT_NODES 64
+
+/** Default number of allocated occurrences in a Match Set */
+#define WBXML_MATCHER_DEFAULT_MATCHES 16
+
+/**
+ * @brief A Pattern
+ */
+typedef struct WBXMLMatcherPattern_s {
+    WB_ULONG len;   /**< Pattern length */
+    WB_ULONG value; /**< Pattern value */
+} WBXMLMatcherPattern;
+
+/**
+ * @brief Node of the Patterns tree
+ * @note Nodes are referenced by their position in the Matcher 'nodes' array. Node 0 is the root.
+ *       As the root can never be a child, a fail or a dictionary node, 0 also means "no node".
+ */
+typedef struct WBXMLMatcherNode_s {
+    WB_ULONG child;   /**< First child */
+    WB_ULONG sibling; /**< Next sibling */
+    WB_ULONG fail;    /**< Longest proper suffix of this node which is also in the tree */
+    WB_ULONG dict;    /**< Next node in fail chain that ends a Pattern (0 if none) */
+    WB_ULONG out;     /**< Index + 1 of the Pattern ending at this node (0 if none) */
+    WB_UTINY c;       /**< Character leading to this node from its parent */
+} WBXMLMatcherNode;
+
+/** The Matcher type */
+struct WBXMLMatcher_s {
+    WBXMLMatcherNode    *nodes;         /**< Patterns tree */
+    WB_ULONG             nodes_len;     /**< Number of nodes */
+    WB_ULONG             nodes_size;    /**< Number of allocated nodes */
+    WB_ULONG             root[256];     /**< Children of the root, indexed by character (0 if none) */
+    WBXMLMatcherPattern *patterns;      /**< Patterns */
+    WB_ULONG             count;         /**< Number of Patterns */
+    WB_ULONG             patterns_size; /**< Number of allocated Patterns */
+    WB_BOOL              compiled;      /**< Is this Matcher ready for search ? */
+    WBXMLAllocator      *allocator;     /**< Allocator of this Matcher (NULL if default one is used) */
+};
+
+
+/* Private functions prototypes */
+static WB_ULONG matcher_child(const WBXMLMatcher *matcher, WB_ULONG node, WB_UTINY c);
+static WB_ULONG matcher_new_node(WBXMLMatcher *matcher, WB_ULONG parent, WB_UTINY c);
+static WB_BOOL match_set_append(WBXMLMatchSet *set, WB_ULONG pattern, WB_ULONG pos, const WBXMLMatcherPattern *elt);
+static int match_cmp_priority(const void *a, const void *b);
+static int match_cmp_pos(const void *a, const void *b);
+
+
+/***************************************************
+ *    Public Functions
+ */
+
+WBXML_DECLARE(WBXMLMatcher *) wbxml_matcher_create_real(void)
+{
+    return wbxml_matcher_create_with_allocator_real(NULL);
+}
+
+
+WBXML_DECLARE(WBXMLMatcher *) wbxml_matcher_create_with_allocator_real(WBXMLAllocator *allocator)
+{
+    WBXMLMatcher *matcher = NULL;
+
+    if ((matcher = wbxml_mem_malloc(allocator, sizeof(WBXMLMatcher))) == NULL)
+        return NULL;
+
+    memset(matcher, 0, sizeof(WBXMLMatcher));
+    matcher->allocator = allocator;
+
+    if ((matcher->nodes = wbxml_mem_malloc(allocator, WBXML_MATCHER_DEFAULT_NODES * sizeof(WBXMLMatcherNode))) == NULL) {
+        wbxml_mem_free(allocator, matcher);
+        return NULL;
+    }
+
+    /* Root node */
+    memset(matcher->nodes, 0, sizeof(WBXMLMatcherNode));
+    matcher->nodes_len = 1;
+    matcher->nodes_size = WBXML_MATCHER_DEFAULT_NODES;
+
+    /* An empty Matcher is ready for search */
+    matcher->compiled = TRUE;
+
+    return matcher;
+}
+
+
+WBXML_DECLARE(void) wbxml_matcher_destroy(WBXMLMatcher *matcher)
+{
+    if (matcher == NULL)
+        return;
+
+    wbxml_mem_free(matcher->allocator, matcher->nodes);
+    wbxml_mem_free(matcher->allocator, matcher->patterns);
+    wbxml_mem_free(matcher->allocator, matcher);
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_add(WBXMLMatcher *matcher, const WB_UTINY *pattern, WB_ULONG len, WB_ULONG value)
+{
+    WBXMLMatcherPattern *patterns = NULL;
+    WB_ULONG node = 0, next = 0, i = 0;
+
+    if ((matcher == NULL) || ((pattern == NULL) && (len > 0)))
+        return FALSE;
+
+    /* Room for Pattern */
+    if (matcher->count == matcher->patterns_size) {
+        if ((patterns = wbxml_mem_realloc(matcher->allocator, matcher->patterns, (matcher->patterns_size + WBXML_MATCHER_DEFAULT_NODES) * sizeof(WBXMLMatcherPattern))) == NULL)
+            return FALSE;
+
+        matcher->patterns = patterns;
+        matcher->patterns_size += WBXML_MATCHER_DEFAULT_NODES;
+    }
+
+    /* Insert Pattern in tree */
+    for (i = 0; i < len; i++) {
+        if ((next = matcher_child(matcher, node, pattern[i])) == 0) {
+            if ((next = matcher_new_node(matcher, node, pattern[i])) == 0)
+                return FALSE;
+        }
+
+        node = next;
+    }
+
+    /* Keep the first Pattern (an empty Pattern is never found) */
+    if ((node != 0) && (matcher->nodes[node].out == 0))
+        matcher->nodes[node].out = matcher->count + 1;
+
+    matcher->patterns[matcher->count].len = len;
+    matcher->patterns[matcher->count].value = value;
+    matcher->count++;
+    matcher->compiled = FALSE;
+
+    return TRUE;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_matcher_count(const WBXMLMatcher *matcher)
+{
+    if (matcher == NULL)
+        return 0;
+
+    return matcher->count;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_compile(WBXMLMatcher *matcher)
+{
+    WBXMLMatcherNode *nodes = NULL;
+    WB_ULONG *queue = NULL;
+    WB_ULONG head = 0, tail = 0, node = 0, child = 0, fail = 0, c = 0;
+
+    if (matcher == NULL)
+        return FALSE;
+
+    if (matcher->compiled)
+        return TRUE;
+
+    if ((queue = wbxml_mem_malloc(matcher->allocator, matcher->nodes_len * sizeof(WB_ULONG))) == NULL)
+        return FALSE;
+
+    nodes = matcher->nodes;
+
+    /* Children of root fail to root */
+    for (c = 0; c < 256; c++) {
+        if ((child = matcher->root[c]) != 0) {
+            nodes[child].fail = 0;
+            nodes[child].dict = 0;
+            queue[tail++] = child;
+        }
+    }
+
+    /* Breadth-first: the fail node of a node is always computed before its children */
+    while (head < tail) {
+        node = queue[head++];
+
+        for (child = nodes[node].child; child != 0; child = nodes[child].sibling) {
+            fail = nodes[node].fail;
+
+            while ((fail != 0) && (matcher_child(matcher, fail, nodes[child].c) == 0))
+                fail = nodes[fail].fail;
+
+            nodes[child].fail = matcher_child(matcher, fail, nodes[child].c);
+
+            if (nodes[nodes[child].fail].out != 0)
+                nodes[child].dict = nodes[child].fail;
+            else
+                nodes[child].dict = nodes[nodes[child].fail].dict;
+
+            queue[tail++] = child;
+        }
+    }
+
+    wbxml_mem_free(matcher->allocator, queue);
+
+    matcher->compiled = TRUE;
+
+    return TRUE;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_search(const WBXMLMatcher *matcher,
+                                            const WB_UTINY *text,
+                                            WB_ULONG len,
+                                            WB_ULONG base,
+                                            WBXMLMatchSet *set)
+{
+    const WBXMLMatcherNode *nodes = NULL;
+    WB_ULONG node = 0, out = 0, i = 0;
+
+    if ((matcher == NULL) || !matcher->compiled || (set == NULL) || ((text == NULL) && (len > 0)))
+        return FALSE;
+
+    nodes = matcher->nodes;
+
+    for (i = 0; i < len; i++) {
+        while ((node != 0) && (matcher_child(matcher, node, text[i]) == 0))
+            node = nodes[node].fail;
+
+        node = matcher_child(matcher, node, text[i]);
+
+        /* Report all Patterns ending here */
+        out = (nodes[node].out != 0) ? node : nodes[node].dict;
+
+        while (out != 0) {
+            if (!match_set_append(set,
+                                  base + nodes[out].out - 1,
+                                  i + 1 - matcher->patterns[nodes[out].out - 1].len,
+                                  &matcher->patterns[nodes[out].out - 1]))
+            {
+                return FALSE;
+            }
+
+            out = nodes[out].dict;
+        }
+    }
+
+    return TRUE;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_select(WBXMLMatchSet *set, WB_ULONG text_len)
+{
+    WB_UTINY *covered = NULL;
+    WB_ULONG i = 0, j = 0, kept = 0;
+
+    if (set == NULL)
+        return FALSE;
+
+    if (set->len < 2)
+        return TRUE;
+
+    if ((covered = wbxml_mem_malloc(set->allocator, text_len + 1)) == NULL)
+        return FALSE;
+
+    memset(covered, 0, text_len + 1);
+
+    qsort(set->matches, set->len, sizeof(WBXMLMatch), match_cmp_priority);
+
+    for (i = 0; i < set->len; i++) {
+        for (j = 0; j < set->matches[i].len; j++) {
+            if (covered[set->matches[i].pos + j])
+                break;
+        }
+
+        /* Overlaps an occurrence of a higher priority (or a previous one of the same Pattern) */
+        if (j < set->matches[i].len)
+            continue;
+
+        memset(covered + set->matches[i].pos, 1, set->matches[i].len);
+        set->matches[kept++] = set->matches[i];
+    }
+
+    set->len = kept;
+
+    qsort(set->matches, set->len, sizeof(WBXMLMatch), match_cmp_pos);
+
+    wbxml_mem_free(set->allocator, covered);
+
+    return TRUE;
+}
+
+
+WBXML_DECLARE(void) wbxml_match_set_init(WBXMLMatchSet *set)
+{
+    wbxml_match_set_init_with_allocator(set, NULL);
+}
+
+
+WBXML_DECLARE(void) wbxml_match_set_init_with_allocator(WBXMLMatchSet *set, WBXMLAllocator *allocator)
+{
+    if (set == NULL)
+        return;
+
+    set->matches = NULL;
+    set->len = 0;
+    set->size = 0;
+    set->allocator = allocator;
+}
+
+
+WBXML_DECLARE(void) wbxml_match_set_clean(WBXMLMatchSet *set)
+{
+    if (set == NULL)
+        return;
+
+    wbxml_mem_free(set->allocator, set->matches);
+    wbxml_match_set_init_with_allocator(set, set->allocator);
+}
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Get the child of a node
+ * @param matcher The Matcher
+ * @param node    The parent node
+ * @param c       The character leading to child
+ * @return The child node, or 0 if not found
+ */
+static WB_ULONG matcher_child(const WBXMLMatcher *matcher, WB_ULONG node, WB_UTINY c)
+{
+    WB_ULONG child = 0;
+
+    if (node == 0)
+        return matcher->root[c];
+
+    for (child = matcher->nodes[node].child; child != 0; child = matcher->nodes[child].sibling) {
+        if (matcher->nodes[child].c == c)
+            return child;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Create a new node
+ * @param matcher The Matcher
+ * @param parent  The parent node
+ * @param c       The character leading to new node
+ * @return The new node, or 0 if not enough memory
+ */
+static WB_ULONG matcher_new_node(WBXMLMatcher *matcher, WB_ULONG parent, WB_UTINY c)
+{
+    WBXMLMatcherNode *nodes = NULL;
+    WB_ULONG node = 0;
+
+    if (matcher->nodes_len == matcher->nodes_size) {
+        if ((nodes = wbxml_mem_realloc(matcher->allocator, matcher->nodes, matcher->nodes_size * 2 * sizeof(WBXMLMatcherNode))) == NULL)
+            return 0;
+
+        matcher->nodes = nodes;
+        matcher->nodes_size *= 2;
+    }
+
+    node = matcher->nodes_len++;
+
+    memset(&matcher->nodes[node], 0, sizeof(WBXMLMatcherNode));
+    matcher->nodes[node].c = c;
+
+    if (parent == 0)
+        matcher->root[c] = node;
+    else {
+        matcher->nodes[node].sibling = matcher->nodes[parent].child;
+        matcher->nodes[parent].child = node;
+    }
+
+    return node;
+}
+
+
+/**
+ * @brief Append an occurrence to a Set
+ * @param set     The Set
+ * @param pattern The Pattern priority
+ * @param pos     The occurrence position
+ * @param elt     The Pattern
+ * @return TRUE if appended, FALSE if not enough memory
+ */
+static WB_BOOL match_set_append(WBXMLMatchSet *set, WB_ULONG pattern, WB_ULONG pos, const WBXMLMatcherPattern *elt)
+{
+    WBXMLMatch *matches = NULL;
+    WB_ULONG size = 0;
+
+    if (set->len == set->size) {
+        size = (set->size == 0) ? WBXML_MATCHER_DEFAULT_MATCHES : set->size * 2;
+
+        if ((matches = wbxml_mem_realloc(set->allocator, set->matches, size * sizeof(WBXMLMatch))) == NULL)
+            return FALSE;
+
+        set->matches = matches;
+        set->size = size;
+    }
+
+    set->matches[set->len].pattern = pattern;
+    set->matches[set->len].pos = pos;
+    set->matches[set->len].len = elt->len;
+    set->matches[set->len].value = elt->value;
+    set->len++;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Compare two occurrences by Pattern priority, then by position
+ */
+static int match_cmp_priority(const void *a, const void *b)
+{
+    const WBXMLMatch *ma = (const WBXMLMatch *) a;
+    const WBXMLMatch *mb = (const WBXMLMatch *) b;
+
+    if (ma->pattern != mb->pattern)
+        return (ma->pattern < mb->pattern) ? -1 : 1;
+
+    if (ma->pos != mb->pos)
+        return (ma->pos < mb->pos) ? -1 : 1;
+
+    return 0;
+}
+
+
+/**
+ * @brief Compare two occurrences by position
+ */
+static int match_cmp_pos(const void *a, const void *b)
+{
+    const WBXMLMatch *ma = (const WBXMLMatch *) a;
+    const WBXMLMatch *mb = (const WBXMLMatch *) b;
+
+    if (ma->pos != mb->pos)
+        return (ma->pos < mb->pos) ? -1 : 1;
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_matcher.h
+ * @ingroup wbxml_matcher
+ *
+ * @date 26/10/17
+ *
+ * @brief Multi-Pattern String Matcher (Aho-Corasick)
+ */
+
+#ifndef WBXML_MATCHER_H
+#define WBXML_MATCHER_H
+
+#include "wbxml_mem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/**
+ * @brief WBXML Multi-Pattern Matcher
+ */
+typedef struct WBXMLMatcher_s WBXMLMatcher;
+
+/**
+ * @brief A Pattern occurrence
+ */
+typedef struct WBXMLMatch_s {
+    WB_ULONG pattern; /**< Pattern priority (index of the Pattern in its Matcher, plus the 'base' given to wbxml_matcher_search()) */
+    WB_ULONG pos;     /**< Position of the occurrence in searched text */
+    WB_ULONG len;     /**< Pattern length */
+    WB_ULONG value;   /**< Pattern value */
+} WBXMLMatch;
+
+/**
+ * @brief A set of Pattern occurrences
+ */
+typedef struct WBXMLMatchSet_s {
+    WBXMLMatch *matches; /**< Occurrences */
+    WB_ULONG    len;     /**< Number of occurrences */
+    WB_ULONG    size;    /**< Number of allocated occurrences */
+    WBXMLAllocator *allocator; /**< Allocator of occurrences (NULL if default one is used) */
+} WBXMLMatchSet;
+
+
+/** @addtogroup wbxml_matcher
+ *  @{
+ */
+
+/**
+ * @brief Create a Matcher
+ * @return The newly created Matcher, or NULL if not enough memory
+ * @warning Do NOT use this function directly, use wbxml_matcher_create() macro instead
+ */
+WBXML_DECLARE(WBXMLMatcher *) wbxml_matcher_create_real(void);
+#define wbxml_matcher_create() wbxml_mem_cleam(wbxml_matcher_create_real())
+
+/**
+ * @brief Create a Matcher with an Allocator
+ * @param allocator The Allocator of the Matcher (NULL to use the default one)
+ * @return The newly created Matcher, or NULL if not enough memory
+ * @warning Do NOT use this function directly, use wbxml_matcher_create_with_allocator() macro instead
+ */
+WBXML_DECLARE(WBXMLMatcher *) wbxml_matcher_create_with_allocator_real(WBXMLAllocator *allocator);
+#define wbxml_matcher_create_with_allocator(a) wbxml_mem_cleam(wbxml_matcher_create_with_allocator_real(a))
+
+/**
+ * @brief Destroy a Matcher
+ * @param matcher The Matcher to destroy
+ */
+WBXML_DECLARE(void) wbxml_matcher_destroy(WBXMLMatcher *matcher);
+
+/**
+ * @brief Add a Pattern to a Matcher
+ * @param matcher The Matcher
+ * @param pattern The Pattern
+ * @param len     The Pattern length
+ * @param value   The Pattern value, given back with each occurrence of this Pattern
+ * @return TRUE if added, FALSE if not enough memory
+ * @note Patterns are numbered in the order they are added. An empty Pattern is numbered, but never found.
+ *       If the same Pattern is added twice, only the first one is found.
+ * @note Patterns can be added after wbxml_matcher_compile() was called, but then the Matcher must be compiled again.
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_add(WBXMLMatcher *matcher, const WB_UTINY *pattern, WB_ULONG len, WB_ULONG value);
+
+/**
+ * @brief Get the number of Patterns in a Matcher
+ * @param matcher The Matcher
+ * @return The number of Patterns added
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_matcher_count(const WBXMLMatcher *matcher);
+
+/**
+ * @brief Compile a Matcher, so that it can be used to search
+ * @param matcher The Matcher
+ * @return TRUE if compiled, FALSE if not enough memory
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_compile(WBXMLMatcher *matcher);
+
+/**
+ * @brief Find all occurrences of all Patterns in a text, in one pass
+ * @param matcher The compiled Matcher
+ * @param text    The text to search in
+ * @param len     The text length
+ * @param base    Value added to each Pattern index in the resulting occurrences
+ * @param set     [out] The Set where occurrences are appended
+ * @return TRUE if search is done, FALSE if not enough memory (or if Matcher is not compiled)
+ * @note A compiled Matcher is only read by this function, so it can be shared between threads.
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_search(const WBXMLMatcher *matcher,
+                                            const WB_UTINY *text,
+                                            WB_ULONG len,
+                                            WB_ULONG base,
+                                            WBXMLMatchSet *set);
+
+/**
+ * @brief Keep only the occurrences of a Set that are chosen by priority
+ * @param set      The Set of occurrences
+ * @param text_len Length of the text where occurrences were found
+ * @return TRUE if done, FALSE if not enough memory
+ * @note Occurrences are considered by Pattern priority (lower first), then from left to right.
+ *       An occurrence is kept if it does not overlap an occurrence already kept.
+ *       This gives the same result as cutting each Pattern (in priority order) out of the
+ *       text fragments left by the previous ones, leftmost occurrence first.
+ *       Kept occurrences are sorted by position.
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_matcher_select(WBXMLMatchSet *set, WB_ULONG text_len);
+
+/**
+ * @brief Initialize a Set of occurrences
+ * @param set The Set
+ */
+WBXML_DECLARE(void) wbxml_match_set_init(WBXMLMatchSet *set);
+
+/**
+ * @brief Initialize a Set of occurrences, allocated with an Allocator
+ * @param set The Set
+ * @param allocator The Allocator of occurrences (NULL to use the default one)
+ */
+WBXML_DECLARE(void) wbxml_match_set_init_with_allocator(WBXMLMatchSet *set, WBXMLAllocator *allocator);
+
+/**
+ * @brief Free the occurrences of a Set
+ * @param set The Set
+ */
+WBXML_DECLARE(void) wbxml_match_set_clean(WBXMLMatchSet *set);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WBXML_MATCHER_H */
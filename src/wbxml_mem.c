@@ -34,14 +34,73 @@
  */
 
 #include "wbxml_mem.h"
+#include "wbxml_internals.h"
+
+#if defined( WIN32 )
+#include <windows.h> /* For InterlockedExchangeAdd() */
+#endif /* WIN32 */
+
+
+/**
+ * @brief Atomically add a value to a counter of an Allocator
+ * @note If no such primitive is known for this compiler, counters are not protected
+ *       against updates from several threads at the same time.
+ */
+#if defined( WIN32 )
+#define WBXML_MEM_ADD(counter, value) InterlockedExchangeAdd((LONG volatile *) &(counter), (LONG) (value))
+#if defined( _WIN64 )
+#define WBXML_MEM_ADD_SIZE(counter, value) InterlockedExchangeAdd64((LONG64 volatile *) &(counter), (LONG64) (value))
+#else
+#define WBXML_MEM_ADD_SIZE(counter, value) WBXML_MEM_ADD(counter, value)
+#endif /* _WIN64 */
+#elif defined( __GNUC__ )
+#define WBXML_MEM_ADD(counter, value) __sync_fetch_and_add(&(counter), (value))
+#define WBXML_MEM_ADD_SIZE(counter, value) __sync_fetch_and_add(&(counter), (value))
+#else
+#define WBXML_MEM_ADD(counter, value) ((counter) += (value))
+#define WBXML_MEM_ADD_SIZE(counter, value) ((counter) += (value))
+#endif /* WIN32 */
+
+
+/** Default Allocator (NULL if standard C functions are used) */
+static WBXMLAllocator *sv_allocator = NULL;
 
 
 /***************************************************
  *    Public Functions
  */
 
-WBXML_DECLARE(void *) wbxml_malloc(size_t size)
+WBXML_DECLARE(void) wbxml_mem_set_allocator(WBXMLAllocator *allocator)
 {
+    sv_allocator = allocator;
+}
+
+
+WBXML_DECLARE(WBXMLAllocator *) wbxml_mem_get_allocator(void)
+{
+    return sv_allocator;
+}
+
+
+WBXML_DECLARE(void *) wbxml_mem_malloc(WBXMLAllocator *allocator, size_t size)
+{
+    void *result = NULL;
+
+    if (allocator == NULL)
+        allocator = sv_allocator;
+
+    if (allocator != NULL) {
+        if ((result = allocator->malloc_clb(allocator->ctx, size)) == NULL) {
+            WBXML_MEM_ADD(allocator->failures, 1);
+            return NULL;
+        }
+
+        WBXML_MEM_ADD(allocator->allocs, 1);
+        WBXML_MEM_ADD_SIZE(allocator->bytes, size);
+
+        return result;
+    }
+
 #ifdef WBXML_USE_LEAKTRACKER
     return lt_malloc(size);
 #else
@@ -50,8 +109,19 @@ WBXML_DECLARE(void *) wbxml_malloc(size_t size)
 }
 
 
-WBXML_DECLARE(void) wbxml_free(void *memblock)
+WBXML_DECLARE(void) wbxml_mem_free(WBXMLAllocator *allocator, void *memblock)
 {
+    if (allocator == NULL)
+        allocator = sv_allocator;
+
+    if (allocator != NULL) {
+        if (memblock != NULL) {
+            allocator->free_clb(allocator->ctx, memblock);
+            WBXML_MEM_ADD(allocator->frees, 1);
+        }
+        return;
+    }
+
 #ifdef WBXML_USE_LEAKTRACKER
     lt_free(memblock);
 #else
@@ -60,8 +130,28 @@ WBXML_DECLARE(void) wbxml_free(void *memblock)
 }
 
 
-WBXML_DECLARE(void *) wbxml_realloc(void *memblock, size_t size)
+WBXML_DECLARE(void *) wbxml_mem_realloc(WBXMLAllocator *allocator, void *memblock, size_t size)
 {
+    void *result = NULL;
+
+    if (allocator == NULL)
+        allocator = sv_allocator;
+
+    if (allocator != NULL) {
+        if ((result = allocator->realloc_clb(allocator->ctx, memblock, size)) == NULL) {
+            WBXML_MEM_ADD(allocator->failures, 1);
+            return NULL;
+        }
+
+        if (memblock == NULL)
+            WBXML_MEM_ADD(allocator->allocs, 1);
+        else
+            WBXML_MEM_ADD(allocator->reallocs, 1);
+        WBXML_MEM_ADD_SIZE(allocator->bytes, size);
+
+        return result;
+    }
+
 #ifdef WBXML_USE_LEAKTRACKER
     return lt_realloc(memblock, size);
 #else
@@ -70,11 +160,47 @@ WBXML_DECLARE(void *) wbxml_realloc(void *memblock, size_t size)
 }
 
 
-WBXML_DECLARE(char *) wbxml_strdup(const char *str)
+WBXML_DECLARE(char *) wbxml_mem_strdup(WBXMLAllocator *allocator, const char *str)
 {
+    char *result = NULL;
+    size_t len = 0;
+
+    if ((allocator != NULL) || (sv_allocator != NULL)) {
+        len = strlen(str) + 1;
+
+        if ((result = wbxml_mem_malloc(allocator, len)) == NULL)
+            return NULL;
+
+        return memcpy(result, str, len);
+    }
+
 #ifdef WBXML_USE_LEAKTRACKER
     return lt_strdup(str);
 #else
     return strdup(str);
 #endif
 }
+
+
+WBXML_DECLARE(void *) wbxml_malloc(size_t size)
+{
+    return wbxml_mem_malloc(NULL, size);
+}
+
+
+WBXML_DECLARE(void) wbxml_free(void *memblock)
+{
+    wbxml_mem_free(NULL, memblock);
+}
+
+
+WBXML_DECLARE(void *) wbxml_realloc(void *memblock, size_t size)
+{
+    return wbxml_mem_realloc(NULL, memblock, size);
+}
+
+
+WBXML_DECLARE(char *) wbxml_strdup(const char *str)
+{
+    return wbxml_mem_strdup(NULL, str);
+}
@@ -54,6 +54,77 @@ extern "C" {
  *  @{ 
  */
 
+/**
+ * @brief Memory Allocator given by user
+ *
+ * All the memory of an object created with an Allocator (cf wbxml_parser_create_with_allocator(),
+ * wbxml_encoder_create_with_allocator(), wbxml_tree_create_with_allocator() ...) is allocated and
+ * freed with its callbacks, which are given the user context 'ctx'. Its counters are updated
+ * by the library, and can be read (or reset) by the user at any time.
+ *
+ * @note Counters are updated atomically (if this is supported for this compiler): an Allocator
+ *       can be shared by objects used in several threads, if its callbacks can.
+ */
+typedef struct WBXMLAllocator_s {
+    void *(*malloc_clb)(void *ctx, size_t size);                    /**< Allocate memory (as malloc()) */
+    void *(*realloc_clb)(void *ctx, void *memblock, size_t size);   /**< Resize memory (as realloc()) */
+    void  (*free_clb)(void *ctx, void *memblock);                   /**< Free memory (as free(), never called with NULL) */
+    void  *ctx;                                                     /**< User context given to callbacks */
+    WB_ULONG allocs;    /**< Number of Memory Blocks allocated (realloc() of NULL included) */
+    WB_ULONG reallocs;  /**< Number of Memory Blocks resized */
+    WB_ULONG frees;     /**< Number of Memory Blocks freed */
+    WB_ULONG failures;  /**< Number of failed allocations */
+    size_t   bytes;     /**< Total size asked for allocations and resizes */
+} WBXMLAllocator;
+
+/**
+ * @brief Set the Allocator used by default
+ * @param allocator The Allocator (NULL to use the standard C functions)
+ * @note It must be set before any use of the library: it is used by all objects created
+ *       without an Allocator, and by wbxml_malloc(), wbxml_realloc(), wbxml_free() and wbxml_strdup().
+ */
+WBXML_DECLARE(void) wbxml_mem_set_allocator(WBXMLAllocator *allocator);
+
+/**
+ * @brief Get the Allocator used by default
+ * @return The default Allocator (NULL if standard C functions are used)
+ */
+WBXML_DECLARE(WBXMLAllocator *) wbxml_mem_get_allocator(void);
+
+/**
+ * @brief Alloc a Memory Block with an Allocator
+ * @param allocator The Allocator (NULL to use the default one)
+ * @param size Size of Memory to alloc
+ * @return The newly malloced Memory Block, or NULL if not enough memory
+ */
+WBXML_DECLARE(void *) wbxml_mem_malloc(WBXMLAllocator *allocator, size_t size);
+
+/**
+ * @brief Free a Memory Block with the Allocator it was allocated with
+ * @param allocator The Allocator (NULL to use the default one)
+ * @param memblock The Memory Block to free
+ * @note Memory given to user by an object of the library (for example a converted
+ *       document) must be freed with the Allocator of this object.
+ */
+WBXML_DECLARE(void) wbxml_mem_free(WBXMLAllocator *allocator, void *memblock);
+
+/**
+ * @brief Realloc a Memory Block with the Allocator it was allocated with
+ * @param allocator The Allocator (NULL to use the default one)
+ * @param memblock The Memory Block to realloc
+ * @param size Size of Memory to realloc
+ * @return The newly realloced Memory Block, or NULL if not enough memory
+ */
+WBXML_DECLARE(void *) wbxml_mem_realloc(WBXMLAllocator *allocator, void *memblock, size_t size);
+
+/**
+ * @brief Duplicate a C String with an Allocator
+ * @param allocator The Allocator (NULL to use the default one)
+ * @param str The C String to duplicate
+ * @return The newly duplicated C String, or NULL if not enough memory
+ */
+WBXML_DECLARE(char *) wbxml_mem_strdup(WBXMLAllocator *allocator, const char *str);
+
 /**
  * @brief Alloc a Memory Block
  * @param size Size of Memory to alloc
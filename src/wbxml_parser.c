@@ -54,6 +54,11 @@
 #define WBXML_PARSER_MALLOC_BLOCK 5000
 #define WBXML_PARSER_STRING_TABLE_MALLOC_BLOCK 200
 #define WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK 100
+#define WBXML_PARSER_ELEMENTS_MALLOC_BLOCK 16
+#define WBXML_PARSER_STRTBL_CACHE_MIN_SIZE 16
+
+/** First slot of a String Table entry in 'strtbl_cache' (offsets of entries are already spread) */
+#define WBXML_PARSER_STRTBL_CACHE_SLOT(index, size) ((index) & ((size) - 1))
 
 /** Set it to '1' for Best Effort mode */
 #define WBXML_PARSER_BEST_EFFORT 1
@@ -61,6 +66,9 @@
 /** For unknown Tag Name or Attribute Name (in Best Effort Mode) */
 #define WBXML_PARSER_UNKNOWN_STRING ((WB_UTINY *)"unknown")
 
+/** Name given to an Attribute that references index 0 of a missing String Table (cf get_strtbl_slice()) */
+#define WBXML_PARSER_NOKIA_XMLNS ((const WB_UTINY *)"xmlns")
+
 /**
  * @brief The WBXML Application Token types
  */
@@ -69,6 +77,27 @@ typedef enum WBXMLTokenType_e {
     WBXML_ATTR_TOKEN        /**< Attribute token */
 } WBXMLTokenType;
 
+/**
+ * @brief The WBXML Parser states (what is parsed next)
+ */
+typedef enum WBXMLParserState_e {
+    WBXML_PARSER_STATE_HEADER,  /**< Header: version, publicid, charset and strtbl */
+    WBXML_PARSER_STATE_BODY,    /**< A pi, or the root Element start */
+    WBXML_PARSER_STATE_ELEMENT, /**< An END, an Element start or a content, in root Element */
+    WBXML_PARSER_STATE_SKIP,    /**< An END, an Element start or a content, in a skipped Element */
+    WBXML_PARSER_STATE_END,     /**< A pi, after root Element */
+    WBXML_PARSER_STATE_DONE     /**< Nothing: the Document is parsed */
+} WBXMLParserState;
+
+
+/**
+ * @brief A String Table entry decoded to UTF-8 (cf get_strtbl_slice())
+ */
+typedef struct WBXMLStrtblEntry_s {
+    WB_ULONG     index;     /**< Offset of entry in String Table */
+    WBXMLBuffer *decoded;   /**< The entry, in UTF-8 (NULL for an empty slot) */
+} WBXMLStrtblEntry;
+
 
 /**
  * @brief The WBXML Parser
@@ -81,6 +110,9 @@ struct WBXMLParser_s {
     WBXMLContentHandler  *content_hdl;     /**< Content Handlers Callbacks */
     WBXMLBuffer          *wbxml;           /**< The wbxml we are parsing */    
     WBXMLBuffer          *strstbl;         /**< String Table specified in WBXML document */
+    WBXMLStrtblEntry     *strtbl_cache;    /**< String Table entries already decoded, hashed by offset */
+    WB_ULONG              strtbl_cache_size; /**< Number of slots in strtbl_cache (a power of two) */
+    WB_ULONG              strtbl_cache_nb; /**< Number of entries in strtbl_cache */
     const WBXMLLangEntry *langTable;       /**< Current document Language Table */
     const WBXMLLangEntry *mainTable;       /**< Main WBXML Languages Table */
     const WBXMLTagEntry  *current_tag;     /**< Current Tag */
@@ -96,6 +128,19 @@ struct WBXMLParser_s {
     WBXMLVersion          version;         /**< WBXML Version field specified in WBXML document */
     WB_UTINY              tagCodePage;     /**< Current Tag Code Page */
     WB_UTINY              attrCodePage;    /**< Current Attribute Code Page */
+    WBXMLTag            **elements;        /**< Stack of open Elements */
+    WB_ULONG              depth;           /**< Number of open Elements */
+    WB_ULONG              elements_size;   /**< Number of allocated Elements in stack */
+    WB_ULONG              max_depth;       /**< Maximum number of nested Elements (0: no limit) */
+    WBXMLParserState      state;           /**< What is parsed next */
+    WB_BOOL               feeding;         /**< TRUE while a Document is fed by chunks */
+    WB_ULONG              consumed;        /**< Number of parsed bytes dropped from wbxml (when fed by chunks) */
+    WB_ULONG              termstr_pos;     /**< Position of the last termstr found incomplete (when fed by chunks) */
+    WB_ULONG              termstr_end;     /**< Position where the search of this termstr terminator goes on */
+    WB_BOOL               borrow_content;  /**< TRUE if opaque content can be given to callbacks without copy */
+    WB_BOOL               skip;            /**< TRUE if the Element being started must be skipped */
+    WB_ULONG              skip_depth;      /**< Number of open Elements in the skipped Element */
+    WBXMLAllocator       *allocator;       /**< Allocator of this Parser (NULL if default one is used) */
 };
 
 
@@ -105,6 +150,7 @@ struct WBXMLParser_s {
  */
 
 /* WBXML Parser functions */
+static WBXMLError wbxml_parser_parse_document(WBXMLParser *parser);
 static void wbxml_parser_reinit(WBXMLParser *parser);
 
 /* Check functions */
@@ -113,31 +159,59 @@ static WB_BOOL is_literal(WBXMLParser *parser);
 static WB_BOOL is_attr_value(WBXMLParser *parser);
 static WB_BOOL is_string(WBXMLParser *parser);
 static WB_BOOL is_extension(WBXMLParser *parser);
+static WB_BOOL is_extension_token(WB_UTINY byte);
+static WB_BOOL is_element(WBXMLParser *parser);
 static WB_BOOL check_public_id(WBXMLParser *parser);
+static WB_BOOL is_part_complete(WBXMLParser *parser);
+
+/* Skip functions */
+static WBXMLError skip_header(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_pi(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_element_start(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_attribute(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_attr_start(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_attr_value(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_content(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_extension(WBXMLParser *parser, WBXMLTokenType code_space, WB_ULONG *pos);
+static WBXMLError skip_switch_page(WBXMLParser *parser, WBXMLTokenType code_space, WB_ULONG *pos);
+static WBXMLError skip_string(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_opaque(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_termstr(WBXMLParser *parser, WB_ULONG *pos);
+static WBXMLError skip_uint8(WBXMLParser *parser, WB_ULONG *pos, WB_UTINY *result);
+static WBXMLError skip_mb_uint32(WBXMLParser *parser, WB_ULONG *pos, WB_ULONG *result);
 
 /* Parse functions */
+static WBXMLError parse_header(WBXMLParser *parser);
 static WBXMLError parse_version(WBXMLParser *parser);
 static WBXMLError parse_publicid(WBXMLParser *parser);
 static WBXMLError parse_charset(WBXMLParser *parser);
 static WBXMLError parse_strtbl(WBXMLParser *parser);
 static WBXMLError parse_body(WBXMLParser *parser);
+static WBXMLError parse_body_part(WBXMLParser *parser);
 
 static WBXMLError parse_pi(WBXMLParser *parser);
 static WBXMLError parse_element(WBXMLParser *parser);
-static void free_attrs_table(WBXMLAttribute **attrs);
+static WBXMLError parse_skipped_part(WBXMLParser *parser);
+static WBXMLError parse_element_start(WBXMLParser *parser, WBXMLTag **element, WB_BOOL *is_empty);
+static WBXMLError open_element(WBXMLParser *parser, WBXMLTag *element, WB_BOOL is_empty);
+static void parse_element_end(WBXMLParser *parser, WBXMLTag *element);
+static WBXMLError push_element(WBXMLParser *parser, WBXMLTag *element);
+static void free_elements(WBXMLParser *parser);
+static void free_attrs_table(WBXMLParser *parser, WBXMLAttribute **attrs);
 
 static WBXMLError parse_switch_page(WBXMLParser *parser, WBXMLTokenType  code_space);
 static WBXMLError parse_stag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **element);
 static WBXMLError parse_tag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **element);
 static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr);
 static WBXMLError parse_content(WBXMLParser *parser, WBXMLBuffer **result);
+static WB_BOOL get_content_slice(WBXMLParser *parser, const WB_UTINY **data, WB_ULONG *len);
 
 static WBXMLError parse_string(WBXMLParser *parser, WBXMLBuffer **result);
 static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space, WBXMLBuffer **result);
 static WBXMLError parse_entity(WBXMLParser *parser, WBXMLBuffer **result);
 static WBXMLError parse_opaque(WBXMLParser *parser, WBXMLBuffer **result);
 
-static WBXMLError parse_literal(WBXMLParser *parser, WB_UTINY *tag, WBXMLBuffer **result);
+static WBXMLError parse_literal(WBXMLParser *parser, WB_UTINY *tag, const WB_UTINY **result);
 
 static WBXMLError parse_attr_start(WBXMLParser *parser, WBXMLAttributeName **name, const WB_UTINY **value);
 static WBXMLError parse_attr_value(WBXMLParser *parser, WBXMLBuffer **result);
@@ -148,6 +222,9 @@ static WBXMLError parse_tableref(WBXMLParser *parser, WBXMLBuffer **result);
 static WBXMLError parse_entcode(WBXMLParser *parser, WB_ULONG *result);
 
 static WBXMLError get_strtbl_reference(WBXMLParser *parser, WB_ULONG index, WBXMLBuffer **result);
+static WBXMLError get_strtbl_slice(WBXMLParser *parser, WB_ULONG index, const WB_UTINY **data, WB_ULONG *len);
+static WBXMLError cache_strtbl_entry(WBXMLParser *parser, WB_ULONG index, WBXMLBuffer *decoded);
+static void free_strtbl_cache(WBXMLParser *parser);
 
 /* Basic Types Parse functions */
 static WBXMLError parse_uint8(WBXMLParser *parser, WB_UTINY *result);
@@ -160,6 +237,7 @@ static WBXMLError decode_base64_value(WBXMLBuffer **data);
 static WBXMLError decode_datetime(WBXMLBuffer *buff);
 #endif /* WBXML_SUPPORT_SI || WBXML_SUPPORT_EMN */
 
+static WB_BOOL is_opaque_content_decoded(WBXMLParser *parser);
 static WBXMLError decode_opaque_content(WBXMLParser *parser, WBXMLBuffer **data);
 static WBXMLError decode_opaque_attr_value(WBXMLParser *parser, WBXMLBuffer **data);
 
@@ -178,18 +256,28 @@ static WBXMLError decode_wv_datetime(WBXMLBuffer **data);
  */
 
 WBXML_DECLARE(WBXMLParser *) wbxml_parser_create(void)
+{
+    return wbxml_parser_create_with_allocator(NULL);
+}
+
+
+WBXML_DECLARE(WBXMLParser *) wbxml_parser_create_with_allocator(WBXMLAllocator *allocator)
 {
     WBXMLParser *parser = NULL;
 
-    parser = wbxml_malloc(sizeof(WBXMLParser));
+    parser = wbxml_mem_malloc(allocator, sizeof(WBXMLParser));
     if (parser == NULL) {
         return NULL;
     }
     
+    parser->allocator = allocator;
     parser->wbxml = NULL;
     parser->user_data = NULL;
     parser->content_hdl = NULL;
     parser->strstbl = NULL;
+    parser->strtbl_cache = NULL;
+    parser->strtbl_cache_size = 0;
+    parser->strtbl_cache_nb = 0;
     parser->langTable = NULL;
 
     /* Default Main WBXML Languages Table */
@@ -208,6 +296,20 @@ WBXML_DECLARE(WBXMLParser *) wbxml_parser_create(void)
     parser->tagCodePage = 0;
     parser->attrCodePage = 0;
 
+    parser->elements = NULL;
+    parser->depth = 0;
+    parser->elements_size = 0;
+    parser->max_depth = 0;
+    parser->borrow_content = FALSE;
+
+    parser->state = WBXML_PARSER_STATE_HEADER;
+    parser->feeding = FALSE;
+    parser->consumed = 0;
+    parser->termstr_pos = 0;
+    parser->termstr_end = 0;
+    parser->skip = FALSE;
+    parser->skip_depth = 0;
+
     return parser;
 }
 
@@ -219,15 +321,35 @@ WBXML_DECLARE(void) wbxml_parser_destroy(WBXMLParser *parser)
     
     wbxml_buffer_destroy(parser->wbxml);
     wbxml_buffer_destroy(parser->strstbl);
+    free_strtbl_cache(parser);
+    free_elements(parser);
+    wbxml_mem_free(parser->allocator, parser->elements);
 
-    wbxml_free(parser);
+    wbxml_mem_free(parser->allocator, parser);
 }
 
 
 WBXML_DECLARE(WBXMLError) wbxml_parser_parse(WBXMLParser *parser, WB_UTINY *wbxml, WB_ULONG wbxml_len)
 {
-    WBXMLError ret = WBXML_OK;
+    if (parser == NULL)
+        return WBXML_ERROR_NULL_PARSER;
+
+    if ((wbxml == NULL) || (wbxml_len <= 0))
+        return WBXML_ERROR_EMPTY_WBXML;
+
+    /* Reinitialize WBXML Parser */
+    wbxml_parser_reinit(parser);
 
+    parser->wbxml = wbxml_buffer_create_with_allocator(parser->allocator, wbxml, wbxml_len, WBXML_PARSER_MALLOC_BLOCK);
+    if (parser->wbxml == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    return wbxml_parser_parse_document(parser);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_parser_parse_static(WBXMLParser *parser, const WB_UTINY *wbxml, WB_ULONG wbxml_len)
+{
     if (parser == NULL)
         return WBXML_ERROR_NULL_PARSER;
 
@@ -237,78 +359,107 @@ WBXML_DECLARE(WBXMLError) wbxml_parser_parse(WBXMLParser *parser, WB_UTINY *wbxm
     /* Reinitialize WBXML Parser */
     wbxml_parser_reinit(parser);
 
-    parser->wbxml = wbxml_buffer_create(wbxml, wbxml_len, WBXML_PARSER_MALLOC_BLOCK);
+    /* Borrow the caller's memory: only the buffer structure is allocated */
+    parser->wbxml = wbxml_buffer_sta_create_with_allocator(parser->allocator, wbxml, wbxml_len);
     if (parser->wbxml == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-    /* WBXML Version */
-    ret = parse_version(parser);
-    CHECK_ERROR
+    return wbxml_parser_parse_document(parser);
+}
 
-    if ((WB_UTINY)parser->version > WBXML_VERSION_13) {
-        WBXML_WARNING((WBXML_PARSER, "This library only supports WBXML %s.", WBXML_VERSION_TEXT_13));
+
+WBXML_DECLARE(WBXMLError) wbxml_parser_feed(WBXMLParser *parser, const WB_UTINY *chunk, WB_ULONG chunk_len, WB_BOOL is_final)
+{
+    WBXMLError ret = WBXML_OK;
+
+    if (parser == NULL)
+        return WBXML_ERROR_NULL_PARSER;
+
+    /* First chunk of a Document */
+    if (!parser->feeding) {
+        /* Reinitialize WBXML Parser */
+        wbxml_parser_reinit(parser);
+
+        parser->wbxml = wbxml_buffer_create_with_allocator(parser->allocator, NULL, 0, WBXML_PARSER_MALLOC_BLOCK);
+        if (parser->wbxml == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        parser->feeding = TRUE;
     }
 
-    /* WBXML Public ID */
-    ret = parse_publicid(parser);
-    CHECK_ERROR
+    /* Append chunk to the bytes not parsed yet (ignore it if Document is already parsed) */
+    if ((chunk != NULL) && (chunk_len > 0) && (parser->state != WBXML_PARSER_STATE_DONE)) {
+        if (!wbxml_buffer_append_data(parser->wbxml, chunk, chunk_len)) {
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            goto error;
+        }
+    }
 
-    /* Ignore Document Public ID if user has forced use of another Public ID */
-    if (parser->lang_forced != WBXML_LANG_UNKNOWN)
-        parser->public_id = wbxml_tables_get_wbxml_publicid(wbxml_tables_get_main(), parser->lang_forced);
+    if (is_final && (parser->consumed == 0) && (wbxml_buffer_len(parser->wbxml) == 0)) {
+        ret = WBXML_ERROR_EMPTY_WBXML;
+        goto error;
+    }
 
-    /* No charset in WBXML 1.0 */
-    if (parser->version != WBXML_VERSION_10) {
-        ret = parse_charset(parser);
-        CHECK_ERROR
+    /* Parse all complete parts (or everything, with last chunk) */
+    while (parser->state != WBXML_PARSER_STATE_DONE) {
+        if (!is_final && !is_part_complete(parser))
+            break;
+
+        if (parser->state == WBXML_PARSER_STATE_HEADER)
+            ret = parse_header(parser);
+        else
+            ret = parse_body_part(parser);
+
+        if (ret != WBXML_OK)
+            goto error;
     }
 
-    /* Check charset */
-    if (parser->charset == WBXML_CHARSET_UNKNOWN) {
-        if (parser->meta_charset != WBXML_CHARSET_UNKNOWN) {
-            /* Use meta-information provided by user */
-            parser->charset = parser->meta_charset;
-      
-            WBXML_DEBUG((WBXML_PARSER,
-                        "Using provided meta charset: %ld",
-                        parser->meta_charset));
+    /* Only keep bytes not parsed yet */
+    if (parser->state == WBXML_PARSER_STATE_DONE)
+        parser->pos = wbxml_buffer_len(parser->wbxml);
+
+    if (parser->pos > 0) {
+        wbxml_buffer_delete(parser->wbxml, 0, parser->pos);
+
+        /* Keep the search of an incomplete termstr terminator where it is */
+        if (parser->termstr_pos >= parser->pos) {
+            parser->termstr_pos -= parser->pos;
+            parser->termstr_end -= parser->pos;
         }
         else {
-            /* Default Charset Encoding: UTF-8 */
-            parser->charset = WBXML_PARSER_DEFAULT_CHARSET;
-      
-            WBXML_WARNING((WBXML_PARSER,
-                           "No charset information found, using default : %x",
-                           WBXML_PARSER_DEFAULT_CHARSET));
+            parser->termstr_pos = 0;
+            parser->termstr_end = 0;
         }
+
+        parser->consumed += parser->pos;
+        parser->pos = 0;
     }
 
-    /* WBXML String Table */
-    ret = parse_strtbl(parser);
-    CHECK_ERROR
+    if (is_final) {
+        parser->feeding = FALSE;
 
-    /* Now that we have parsed String Table, we can check Public ID */
-    if (!check_public_id(parser)) {
-        WBXML_ERROR((WBXML_PARSER, "PublicID not found"));
-        return WBXML_ERROR_UNKNOWN_PUBLIC_ID;
+        /* Call to WBXMLEndDocumentHandler */
+        if ((parser->content_hdl != NULL) && (parser->content_hdl->end_document_clb != NULL))
+            parser->content_hdl->end_document_clb(parser->user_data);
     }
 
-    /* Call to WBXMLStartDocumentHandler */
-    if ((parser->content_hdl != NULL) && (parser->content_hdl->start_document_clb != NULL))
-        parser->content_hdl->start_document_clb(parser->user_data, parser->charset, parser->langTable);
-
-    /* WBXML Body */
-    ret = parse_body(parser);
-    CHECK_ERROR
+    return WBXML_OK;
 
-    /* Call to WBXMLEndDocumentHandler */
-    if ((parser->content_hdl != NULL) && (parser->content_hdl->end_document_clb != NULL))
-        parser->content_hdl->end_document_clb(parser->user_data);
+error:
+    free_elements(parser);
+    parser->feeding = FALSE;
 
     return ret;
 }
 
 
+WBXML_DECLARE(void) wbxml_parser_skip_element(WBXMLParser *parser)
+{
+    if (parser != NULL)
+        parser->skip = TRUE;
+}
+
+
 WBXML_DECLARE(void) wbxml_parser_set_user_data(WBXMLParser *parser, void *user_data)
 {
     if (parser != NULL)
@@ -341,6 +492,20 @@ WBXML_DECLARE(WB_BOOL) wbxml_parser_set_language(WBXMLParser *parser, WBXMLLangu
 }
 
 
+WBXML_DECLARE(void) wbxml_parser_set_max_depth(WBXMLParser *parser, WB_ULONG max_depth)
+{
+    if (parser != NULL)
+        parser->max_depth = max_depth;
+}
+
+
+WBXML_DECLARE(void) wbxml_parser_set_borrowed_content(WBXMLParser *parser, WB_BOOL borrowed)
+{
+    if (parser != NULL)
+        parser->borrow_content = borrowed;
+}
+
+
 WBXML_DECLARE(WB_BOOL) wbxml_parser_set_meta_charset(WBXMLParser *parser,
                                                      WBXMLCharsetMIBEnum charset)
 {
@@ -383,7 +548,7 @@ WBXML_DECLARE(WBXMLVersion) wbxml_parser_get_wbxml_version(WBXMLParser *parser)
 WBXML_DECLARE(WB_LONG) wbxml_parser_get_current_byte_index(WBXMLParser *parser)
 {
     if (parser != NULL)
-        return parser->pos - 1;
+        return parser->consumed + parser->pos - 1;
     else
         return 0;
 }
@@ -397,6 +562,33 @@ WBXML_DECLARE(WB_LONG) wbxml_parser_get_current_byte_index(WBXMLParser *parser)
  * WBXML Parser functions
  */
 
+/**
+ * @brief Parse the WBXML document attached to a WBXML Parser
+ * @param parser The WBXMLParser, with its 'wbxml' buffer already set
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note The 'wbxml' buffer may be a static one (see wbxml_parser_parse_static()),
+ *       so it must only be read here.
+ */
+static WBXMLError wbxml_parser_parse_document(WBXMLParser *parser)
+{
+    WBXMLError ret = WBXML_OK;
+
+    /* WBXML Header */
+    ret = parse_header(parser);
+    CHECK_ERROR
+
+    /* WBXML Body */
+    ret = parse_body(parser);
+    CHECK_ERROR
+
+    /* Call to WBXMLEndDocumentHandler */
+    if ((parser->content_hdl != NULL) && (parser->content_hdl->end_document_clb != NULL))
+        parser->content_hdl->end_document_clb(parser->user_data);
+
+    return ret;
+}
+
+
 /**
  * @brief Reinitialize a WBXML Parser
  * @param parser The WBXMLParser to reinitialize
@@ -413,6 +605,8 @@ static void wbxml_parser_reinit(WBXMLParser *parser)
   
     wbxml_buffer_destroy(parser->strstbl);
     parser->strstbl         = NULL;
+
+    free_strtbl_cache(parser);
   
     parser->langTable       = NULL;
     parser->current_tag     = NULL;
@@ -425,6 +619,16 @@ static void wbxml_parser_reinit(WBXMLParser *parser)
     parser->pos             = 0;
     parser->tagCodePage     = 0;
     parser->attrCodePage    = 0;    
+
+    free_elements(parser);
+
+    parser->state           = WBXML_PARSER_STATE_HEADER;
+    parser->feeding         = FALSE;
+    parser->consumed        = 0;
+    parser->termstr_pos     = 0;
+    parser->termstr_end     = 0;
+    parser->skip            = FALSE;
+    parser->skip_depth      = 0;
 }
 
 
@@ -531,9 +735,44 @@ static WB_BOOL is_extension(WBXMLParser *parser)
             return FALSE;
     }
 
-    return (WB_BOOL) ((cur_byte == WBXML_EXT_I_0) || (cur_byte == WBXML_EXT_I_1) || (cur_byte == WBXML_EXT_I_2) ||
-            (cur_byte == WBXML_EXT_T_0) || (cur_byte == WBXML_EXT_T_1) || (cur_byte == WBXML_EXT_T_2) ||
-            (cur_byte == WBXML_EXT_0)   || (cur_byte == WBXML_EXT_1)   || (cur_byte == WBXML_EXT_2));
+    return is_extension_token(cur_byte);
+}
+
+
+/**
+ * @brief Check if a byte is an extension token
+ * @param byte The byte to check
+ * @return TRUE if this byte is an EXT_I, EXT_T or EXT token, FALSE otherwise
+ */
+static WB_BOOL is_extension_token(WB_UTINY byte)
+{
+    return (WB_BOOL) ((byte == WBXML_EXT_I_0) || (byte == WBXML_EXT_I_1) || (byte == WBXML_EXT_I_2) ||
+            (byte == WBXML_EXT_T_0) || (byte == WBXML_EXT_T_1) || (byte == WBXML_EXT_T_2) ||
+            (byte == WBXML_EXT_0)   || (byte == WBXML_EXT_1)   || (byte == WBXML_EXT_2));
+}
+
+
+/**
+ * @brief Check if current byte starts an Element, in Content
+ * @param parser The WBXML Parser
+ * @return TRUE if current byte starts an Element, FALSE otherwise
+ * @note In Content, anything that is not END, string, extension, entity, pi, opaque or switchPage
+ *       is an Element (cf parse_content())
+ */
+static WB_BOOL is_element(WBXMLParser *parser)
+{
+    WB_UTINY cur_byte;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, parser->pos, &cur_byte))
+        return FALSE;
+
+    return (WB_BOOL) !((cur_byte == WBXML_END) ||
+                       (cur_byte == WBXML_ENTITY) ||
+                       (cur_byte == WBXML_OPAQUE) ||
+                       (cur_byte == WBXML_PI) ||
+                       (cur_byte == WBXML_SWITCH_PAGE) ||
+                       is_string(parser) ||
+                       is_extension(parser));
 }
 
 
@@ -642,94 +881,815 @@ static WB_BOOL check_public_id(WBXMLParser *parser)
 
 
 
-/***************************
- *    WBXML Parse functions
- */
-
 /**
- * @brief Parse WBXML version
+ * @brief Check if the next part of Document to parse is complete
  * @param parser The WBXML Parser
- * @return WBXML_OK if parsing is OK, an error code otherwise
- * @note version = u_int8
+ * @return TRUE if the next part to parse (cf parser state) is entirely in 'wbxml' buffer, FALSE if more bytes are needed
+ * @note Used when the Document is fed by chunks: a part is only parsed when it is complete, so that
+ *       parsing never stops in the middle of a token. A malformed part is said to be complete, so that
+ *       its parsing reports the error.
  */
-static WBXMLError parse_version(WBXMLParser *parser)
-{   
+static WB_BOOL is_part_complete(WBXMLParser *parser)
+{
+    WB_ULONG   pos = parser->pos;
+    WB_UTINY   cur_byte;
     WBXMLError ret = WBXML_OK;
-    
-    /* Initialize version: 1.0 
-     *
-     * Do NOT keep 'WBXML_VERSION_UNKNOWN' (0xffffffff) because only one byte will change.
-     * (for example, if the version is 0x02, then parser->version will be 0xffffff02)
-     */
-    WB_UTINY version = WBXML_VERSION_10;
-    
-    if ((ret = parse_uint8(parser, &version)) != WBXML_OK)
-        return ret;
-    
-    parser->version = version;
 
-    WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed version: 1.%d", parser->pos - 1, parser->version));
+    switch (parser->state) {
+    case WBXML_PARSER_STATE_HEADER:
+        ret = skip_header(parser, &pos);
+        break;
 
-    return WBXML_OK;
+    case WBXML_PARSER_STATE_BODY:
+    case WBXML_PARSER_STATE_END:
+        if (!wbxml_buffer_get_char(parser->wbxml, pos, &cur_byte))
+            return FALSE;
+
+        if (cur_byte == WBXML_PI)
+            ret = skip_pi(parser, &pos);
+        else if (parser->state == WBXML_PARSER_STATE_BODY)
+            ret = skip_element_start(parser, &pos);
+        break;
+
+    case WBXML_PARSER_STATE_ELEMENT:
+    case WBXML_PARSER_STATE_SKIP:
+        if (!wbxml_buffer_get_char(parser->wbxml, pos, &cur_byte))
+            return FALSE;
+
+        if (cur_byte == WBXML_END)
+            break;
+
+        if (is_element(parser))
+            ret = skip_element_start(parser, &pos);
+        else
+            ret = skip_content(parser, &pos);
+        break;
+
+    default:
+        break;
+    }
+
+    return (WB_BOOL) (ret != WBXML_ERROR_END_OF_BUFFER);
 }
 
 
+
+/***************************
+ *    WBXML Skip functions
+ */
+
+/*
+ * These functions follow the grammar of parse functions, but only move 'pos' past the
+ * parsed tokens: nothing is decoded, nor created, and no callback is called. They return
+ * WBXML_ERROR_END_OF_BUFFER if 'wbxml' buffer ends before the skipped tokens.
+ * When an Element is skipped (cf parse_skipped_part()), switchPage tokens are applied too.
+ */
+
 /**
- * @brief Parse WBXML public id
+ * @brief Skip WBXML header
  * @param parser The WBXML Parser
- * @return WBXML_OK if parsing is OK, an error code otherwise
- * @note publicid = mb_u_int32 | ( zero index )
- * @note index = mb_u_int32
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note header = version publicid charset strtbl
  */
-static WBXMLError parse_publicid(WBXMLParser *parser)
+static WBXMLError skip_header(WBXMLParser *parser, WB_ULONG *pos)
 {
-    WB_UTINY public_id;
-    WBXMLError ret;
+    WB_UTINY   version    = 0;
+    WB_UTINY   public_id  = 0;
+    WB_ULONG   strtbl_len = 0;
+    WBXMLError ret        = WBXML_OK;
 
-    if (!wbxml_buffer_get_char(parser->wbxml, parser->pos, &public_id))
-        return WBXML_ERROR_END_OF_BUFFER;
+    /* version */
+    if ((ret = skip_uint8(parser, pos, &version)) != WBXML_OK)
+        return ret;
 
-    WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id value: '0x%X'", parser->pos, public_id));
+    /* publicid */
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &public_id))
+        return WBXML_ERROR_END_OF_BUFFER;
 
-    if (public_id == 0x00) {
-        parser->pos++;
+    if (public_id == 0x00)
+        (*pos)++;
 
-        /* Get index (we will retrieve the Public ID later from string table) */
-        ret = parse_mb_uint32(parser, (WB_ULONG *)&parser->public_id_index);
-        WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id index: '0x%x'", parser->pos-1, parser->public_id_index));
+    if ((ret = skip_mb_uint32(parser, pos, NULL)) != WBXML_OK)
         return ret;
+
+    /* charset (none in WBXML 1.0) */
+    if (version != (WB_UTINY) WBXML_VERSION_10) {
+        if ((ret = skip_mb_uint32(parser, pos, NULL)) != WBXML_OK)
+            return ret;
     }
-    else {
-        /* Get Public ID */
-        ret = parse_mb_uint32(parser, &parser->public_id);        
-        WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id: '0x%x'", parser->pos-1, parser->public_id));
+
+    /* strtbl */
+    if ((ret = skip_mb_uint32(parser, pos, &strtbl_len)) != WBXML_OK)
         return ret;
-    }
+
+    if (strtbl_len > wbxml_buffer_len(parser->wbxml) - *pos)
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    *pos += strtbl_len;
+
+    return WBXML_OK;
 }
 
 
 /**
- * @brief Parse WBXML charset
+ * @brief Skip WBXML pi
  * @param parser The WBXML Parser
- * @return WBXML_OK if parsing is OK, an error code otherwise
- * @note charset = mb_u_int32
- * @note "The binary XML format contains a representation of the XML document character encoding.
- *        This is the WBXML equivalent of the XML document format encoding attribute,
- *        which is specified in the ?xml processing instruction. The character set is encoded as
- *        a multi-byte positive integer value, representing the IANA-assigned MIB number for
- *        a character set. A value of zero indicates an unknown document encoding. In the case of
- *        an unknown encoding, transport meta-information should be used to determine the character
- *        encoding. If transport meta-information is unavailable, the default encoding of UTF-8
- *        should be assumed."
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note pi = PI attrStart *attrValue END
  */
-static WBXMLError parse_charset(WBXMLParser *parser)
+static WBXMLError skip_pi(WBXMLParser *parser, WB_ULONG *pos)
 {
-    /* definitions first ... or some compilers don't like it */
-    const char *charset_name = NULL;
+    WB_UTINY   cur_byte;
+    WBXMLError ret = WBXML_OK;
 
-#if defined( WBXML_LIB_VERBOSE )
-    WB_ULONG startpos = parser->pos;
-#endif /* WBXML_LIB_VERBOSE */
+    /* Skip PI */
+    (*pos)++;
+
+    if ((ret = skip_attr_start(parser, pos)) != WBXML_OK)
+        return ret;
+
+    for (;;) {
+        if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        if (cur_byte == WBXML_END)
+            break;
+
+        if ((ret = skip_attr_value(parser, pos)) != WBXML_OK)
+            return ret;
+    }
+
+    /* Skip END */
+    (*pos)++;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Skip the start of a WBXML element
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note ([switchPage] stag) [ 1*attribute END ]
+ */
+static WBXMLError skip_element_start(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY   cur_byte;
+    WB_UTINY   tag = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* switchPage */
+    if (cur_byte == WBXML_SWITCH_PAGE) {
+        if ((ret = skip_switch_page(parser, WBXML_TAG_TOKEN, pos)) != WBXML_OK)
+            return ret;
+    }
+
+    /* stag = TAG | (literalTag index) */
+    if ((ret = skip_uint8(parser, pos, &tag)) != WBXML_OK)
+        return ret;
+
+    if ((tag == WBXML_LITERAL) || (tag == WBXML_LITERAL_A) || (tag == WBXML_LITERAL_C) || (tag == WBXML_LITERAL_AC)) {
+        if ((ret = skip_mb_uint32(parser, pos, NULL)) != WBXML_OK)
+            return ret;
+    }
+
+    /* Attributes (the ATTR bit has the same meaning for TAG and literalTag) */
+    if (tag & WBXML_TOKEN_WITH_ATTRS) {
+        do {
+            if ((ret = skip_attribute(parser, pos)) != WBXML_OK)
+                return ret;
+
+            if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+                return WBXML_ERROR_END_OF_BUFFER;
+        } while (cur_byte != WBXML_END);
+
+        /* Skip END */
+        (*pos)++;
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Skip WBXML attribute
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note attribute = attrStart *attrValue
+ */
+static WBXMLError skip_attribute(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY   cur_byte, next_byte;
+    WBXMLError ret = WBXML_OK;
+
+    if ((ret = skip_attr_start(parser, pos)) != WBXML_OK)
+        return ret;
+
+    /* Same checks than is_attr_value() */
+    for (;;) {
+        if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        next_byte = cur_byte;
+
+        if ((cur_byte == WBXML_SWITCH_PAGE) && !wbxml_buffer_get_char(parser->wbxml, *pos + 2, &next_byte))
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        if (!(((cur_byte == WBXML_SWITCH_PAGE) && ((next_byte & 0x80) == 0x80)) ||
+              ((cur_byte & 0x80) == 0x80) ||
+              (cur_byte == WBXML_STR_I) ||
+              (cur_byte == WBXML_STR_T) ||
+              is_extension_token(next_byte) ||
+              (cur_byte == WBXML_ENTITY) ||
+              (cur_byte == WBXML_OPAQUE)))
+        {
+            return WBXML_OK;
+        }
+
+        if ((ret = skip_attr_value(parser, pos)) != WBXML_OK)
+            return ret;
+    }
+}
+
+
+/**
+ * @brief Skip WBXML attrStart
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note attrStart = ([switchPage] ATTRSTART) | ( LITERAL index )
+ */
+static WBXMLError skip_attr_start(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY   cur_byte;
+    WBXMLError ret = WBXML_OK;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* ( LITERAL index ) */
+    if (cur_byte == WBXML_LITERAL) {
+        (*pos)++;
+        return skip_mb_uint32(parser, pos, NULL);
+    }
+
+    /* ( [switchPage] ATTRSTART ) */
+    if (cur_byte == WBXML_SWITCH_PAGE) {
+        if ((ret = skip_switch_page(parser, WBXML_ATTR_TOKEN, pos)) != WBXML_OK)
+            return ret;
+    }
+
+    return skip_uint8(parser, pos, NULL);
+}
+
+
+/**
+ * @brief Skip WBXML attrValue
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note attrValue = ([switchPage] ATTRVALUE) | string | extension | entity | opaque
+ */
+static WBXMLError skip_attr_value(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY   cur_byte, next_byte;
+    WBXMLError ret = WBXML_OK;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    next_byte = cur_byte;
+
+    if ((cur_byte == WBXML_SWITCH_PAGE) && !wbxml_buffer_get_char(parser->wbxml, *pos + 2, &next_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* extension */
+    if (is_extension_token(next_byte))
+        return skip_extension(parser, WBXML_ATTR_TOKEN, pos);
+
+    /* entity = ENTITY entcode */
+    if (cur_byte == WBXML_ENTITY) {
+        (*pos)++;
+        return skip_mb_uint32(parser, pos, NULL);
+    }
+
+    /* string */
+    if ((cur_byte == WBXML_STR_I) || (cur_byte == WBXML_STR_T))
+        return skip_string(parser, pos);
+
+    /* opaque */
+    if (cur_byte == WBXML_OPAQUE)
+        return skip_opaque(parser, pos);
+
+    /* ([switchPage] ATTRVALUE) */
+    if (cur_byte == WBXML_SWITCH_PAGE) {
+        if ((ret = skip_switch_page(parser, WBXML_ATTR_TOKEN, pos)) != WBXML_OK)
+            return ret;
+    }
+
+    return skip_uint8(parser, pos, NULL);
+}
+
+
+/**
+ * @brief Skip WBXML content, that is not an Element
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note content = string | extension | entity | pi | opaque (plus misplaced switchPage, cf parse_content())
+ */
+static WBXMLError skip_content(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY cur_byte, next_byte;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    next_byte = cur_byte;
+
+    if ((cur_byte == WBXML_SWITCH_PAGE) && !wbxml_buffer_get_char(parser->wbxml, *pos + 2, &next_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* extension */
+    if (is_extension_token(next_byte))
+        return skip_extension(parser, WBXML_TAG_TOKEN, pos);
+
+    switch (cur_byte) {
+    case WBXML_ENTITY:
+        (*pos)++;
+        return skip_mb_uint32(parser, pos, NULL);
+
+    case WBXML_STR_I:
+    case WBXML_STR_T:
+        return skip_string(parser, pos);
+
+    case WBXML_OPAQUE:
+        return skip_opaque(parser, pos);
+
+    case WBXML_PI:
+        return skip_pi(parser, pos);
+
+    case WBXML_SWITCH_PAGE:
+        return skip_switch_page(parser, WBXML_TAG_TOKEN, pos);
+
+    default:
+        /* element: not a content for this function */
+        return WBXML_ERROR_INTERNAL;
+    }
+}
+
+
+/**
+ * @brief Skip WBXML extension
+ * @param parser The WBXML Parser
+ * @param code_space The token code space
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note extension = [switchPage] (( EXT_I termstr ) | ( EXT_T index ) | EXT)
+ * @note As in parse_extension(), what follows the extension token depends on Language
+ */
+static WBXMLError skip_extension(WBXMLParser *parser, WBXMLTokenType code_space, WB_ULONG *pos)
+{
+    WB_UTINY   cur_byte;
+    WB_UTINY   token = 0;
+    WBXMLError ret   = WBXML_OK;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* switchPage */
+    if (cur_byte == WBXML_SWITCH_PAGE) {
+        if ((ret = skip_switch_page(parser, code_space, pos)) != WBXML_OK)
+            return ret;
+    }
+
+    /* Extension Token */
+    if ((ret = skip_uint8(parser, pos, &token)) != WBXML_OK)
+        return ret;
+
+    if (parser->langTable == NULL)
+        return WBXML_ERROR_LANG_TABLE_UNDEFINED;
+
+    switch (parser->langTable->langID) {
+
+#if defined( WBXML_SUPPORT_WML )
+
+    case WBXML_LANG_WML10:
+    case WBXML_LANG_WML11:
+    case WBXML_LANG_WML12:
+    case WBXML_LANG_WML13:
+
+#endif /* WBXML_SUPPORT_WML */
+
+#if defined( WBXML_SUPPORT_WTA )
+
+    case WBXML_LANG_WTAWML12:
+
+#endif /* WBXML_SUPPORT_WTA */
+
+#if ( defined( WBXML_SUPPORT_WML ) || defined( WBXML_SUPPORT_WTA ) )
+
+        switch (token) {
+        case WBXML_EXT_I_0:
+        case WBXML_EXT_I_1:
+        case WBXML_EXT_I_2:
+            return skip_termstr(parser, pos);
+
+        case WBXML_EXT_T_0:
+        case WBXML_EXT_T_1:
+        case WBXML_EXT_T_2:
+            return skip_mb_uint32(parser, pos, NULL);
+
+        default:
+            return WBXML_OK;
+        }
+
+#endif /* WBXML_SUPPORT_WML || WBXML_SUPPORT_WTA */
+
+#if defined( WBXML_SUPPORT_WV )
+
+    case WBXML_LANG_WV_CSP11:
+    case WBXML_LANG_WV_CSP12:
+        if (token == WBXML_EXT_T_0)
+            return skip_mb_uint32(parser, pos, NULL);
+
+        return WBXML_OK;
+
+#endif /* WBXML_SUPPORT_WV */
+
+    default:
+        return WBXML_OK;
+    }
+}
+
+
+/**
+ * @brief Skip WBXML switchPage
+ * @param parser The WBXML Parser
+ * @param code_space The token code space
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note switchPage = SWITCH_PAGE pageindex
+ * @note In a skipped Element, the Code Page is changed as by parse_switch_page(). This is also done
+ *       when checking if a part of it is complete: the same part is skipped again once complete, so
+ *       Code Pages end with the same values (and none of them is used until the skipped Element ends).
+ */
+static WBXMLError skip_switch_page(WBXMLParser *parser, WBXMLTokenType code_space, WB_ULONG *pos)
+{
+    WB_UTINY   code_page = 0;
+    WBXMLError ret       = WBXML_OK;
+
+    /* Skip SWITCH_PAGE */
+    (*pos)++;
+
+    if ((ret = skip_uint8(parser, pos, &code_page)) != WBXML_OK)
+        return ret;
+
+    if (parser->state == WBXML_PARSER_STATE_SKIP) {
+        if (code_space == WBXML_TAG_TOKEN)
+            parser->tagCodePage = code_page;
+        else
+            parser->attrCodePage = code_page;
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Skip WBXML string
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note string = inline | tableref
+ */
+static WBXMLError skip_string(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_UTINY cur_byte;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    /* inline = STR_I termstr */
+    if (cur_byte == WBXML_STR_I) {
+        (*pos)++;
+        return skip_termstr(parser, pos);
+    }
+
+    /* tableref = STR_T index */
+    if (cur_byte == WBXML_STR_T) {
+        (*pos)++;
+        return skip_mb_uint32(parser, pos, NULL);
+    }
+
+    return WBXML_ERROR_STRING_EXPECTED;
+}
+
+
+/**
+ * @brief Skip WBXML opaque
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note opaque = OPAQUE length *byte
+ */
+static WBXMLError skip_opaque(WBXMLParser *parser, WB_ULONG *pos)
+{
+    WB_ULONG   len = 0;
+    WBXMLError ret = WBXML_OK;
+
+    /* Skip OPAQUE */
+    (*pos)++;
+
+    if ((ret = skip_mb_uint32(parser, pos, &len)) != WBXML_OK)
+        return ret;
+
+    if (len > wbxml_buffer_len(parser->wbxml) - *pos)
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    *pos += len;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Skip WBXML termstr
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note termstr = charset-dependent string with termination
+ * @note If the terminator is not found, the search goes on from where it stopped on next call
+ *       for the same termstr (when Document is fed by chunks, the same part is checked again
+ *       with each chunk: this keeps a long termstr from being searched from its start each time).
+ */
+static WBXMLError skip_termstr(WBXMLParser *parser, WB_ULONG *pos)
+{
+    const WB_UTINY *data = wbxml_buffer_get_cstr(parser->wbxml);
+    const WB_UTINY *term = NULL;
+    WB_ULONG        len  = wbxml_buffer_len(parser->wbxml);
+    WB_ULONG        cur  = *pos;
+
+    if ((parser->termstr_pos == *pos) && (parser->termstr_end > cur))
+        cur = parser->termstr_end;
+
+    if (cur > len)
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    switch (parser->charset) {
+    case WBXML_CHARSET_ISO_10646_UCS_2:
+    case WBXML_CHARSET_UTF_16:
+        /* Terminated by two NULL char ("\0\0"), cf wbxml_charset_conv_term() */
+        for (; cur + 2 <= len; cur += 2) {
+            if ((data[cur] == '\0') && (data[cur + 1] == '\0')) {
+                *pos = cur + 2;
+                return WBXML_OK;
+            }
+        }
+        break;
+
+    default:
+        /* Terminated by a simple NULL char ('\0') */
+        if ((term = memchr(data + cur, '\0', len - cur)) != NULL) {
+            *pos = (WB_ULONG) (term - data) + 1;
+            return WBXML_OK;
+        }
+
+        cur = len;
+        break;
+    }
+
+    parser->termstr_pos = *pos;
+    parser->termstr_end = cur;
+
+    return WBXML_ERROR_END_OF_BUFFER;
+}
+
+
+/**
+ * @brief Skip UINT8
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @param result [out] The skipped UINT8 (can be NULL)
+ * @return WBXML_OK if skipped, an error code otherwise
+ */
+static WBXMLError skip_uint8(WBXMLParser *parser, WB_ULONG *pos, WB_UTINY *result)
+{
+    WB_UTINY cur_byte;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    (*pos)++;
+
+    if (result != NULL)
+        *result = cur_byte;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Skip a MultiByte UINT32
+ * @param parser The WBXML Parser
+ * @param pos [in/out] The position in wbxml
+ * @param result [out] The skipped MultiByte value (can be NULL)
+ * @return WBXML_OK if skipped, an error code otherwise
+ */
+static WBXMLError skip_mb_uint32(WBXMLParser *parser, WB_ULONG *pos, WB_ULONG *result)
+{
+    WB_ULONG uint = 0, byte_pos;
+    WB_UTINY cur_byte;
+
+    for (byte_pos = 0; byte_pos < 5; byte_pos++) {
+        if (!wbxml_buffer_get_char(parser->wbxml, *pos, &cur_byte))
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        (*pos)++;
+
+        uint = (uint << 7) | ((WB_UTINY)cur_byte & 0x7F);
+
+        if (!((WB_UTINY)cur_byte & 0x80)) {
+            if (result != NULL)
+                *result = uint;
+
+            return WBXML_OK;
+        }
+    }
+
+    return WBXML_ERROR_UNVALID_MBUINT32;
+}
+
+
+
+/***************************
+ *    WBXML Parse functions
+ */
+
+/**
+ * @brief Parse WBXML header
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note header = version publicid charset strtbl
+ * @note The WBXMLStartDocumentHandler callback is called here
+ */
+static WBXMLError parse_header(WBXMLParser *parser)
+{
+    WBXMLError ret = WBXML_OK;
+
+    /* WBXML Version */
+    ret = parse_version(parser);
+    CHECK_ERROR
+
+    if ((WB_UTINY)parser->version > WBXML_VERSION_13) {
+        WBXML_WARNING((WBXML_PARSER, "This library only supports WBXML %s.", WBXML_VERSION_TEXT_13));
+    }
+
+    /* WBXML Public ID */
+    ret = parse_publicid(parser);
+    CHECK_ERROR
+
+    /* Ignore Document Public ID if user has forced use of another Public ID */
+    if (parser->lang_forced != WBXML_LANG_UNKNOWN)
+        parser->public_id = wbxml_tables_get_wbxml_publicid(wbxml_tables_get_main(), parser->lang_forced);
+
+    /* No charset in WBXML 1.0 */
+    if (parser->version != WBXML_VERSION_10) {
+        ret = parse_charset(parser);
+        CHECK_ERROR
+    }
+
+    /* Check charset */
+    if (parser->charset == WBXML_CHARSET_UNKNOWN) {
+        if (parser->meta_charset != WBXML_CHARSET_UNKNOWN) {
+            /* Use meta-information provided by user */
+            parser->charset = parser->meta_charset;
+      
+            WBXML_DEBUG((WBXML_PARSER,
+                        "Using provided meta charset: %ld",
+                        parser->meta_charset));
+        }
+        else {
+            /* Default Charset Encoding: UTF-8 */
+            parser->charset = WBXML_PARSER_DEFAULT_CHARSET;
+      
+            WBXML_WARNING((WBXML_PARSER,
+                           "No charset information found, using default : %x",
+                           WBXML_PARSER_DEFAULT_CHARSET));
+        }
+    }
+
+    /* WBXML String Table */
+    ret = parse_strtbl(parser);
+    CHECK_ERROR
+
+    /* Now that we have parsed String Table, we can check Public ID */
+    if (!check_public_id(parser)) {
+        WBXML_ERROR((WBXML_PARSER, "PublicID not found"));
+        return WBXML_ERROR_UNKNOWN_PUBLIC_ID;
+    }
+
+    parser->state = WBXML_PARSER_STATE_BODY;
+
+    /* Call to WBXMLStartDocumentHandler */
+    if ((parser->content_hdl != NULL) && (parser->content_hdl->start_document_clb != NULL))
+        parser->content_hdl->start_document_clb(parser->user_data, parser->charset, parser->langTable);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Parse WBXML version
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note version = u_int8
+ */
+static WBXMLError parse_version(WBXMLParser *parser)
+{   
+    WBXMLError ret = WBXML_OK;
+    
+    /* Initialize version: 1.0 
+     *
+     * Do NOT keep 'WBXML_VERSION_UNKNOWN' (0xffffffff) because only one byte will change.
+     * (for example, if the version is 0x02, then parser->version will be 0xffffff02)
+     */
+    WB_UTINY version = WBXML_VERSION_10;
+    
+    if ((ret = parse_uint8(parser, &version)) != WBXML_OK)
+        return ret;
+    
+    parser->version = version;
+
+    WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed version: 1.%d", parser->pos - 1, parser->version));
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Parse WBXML public id
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note publicid = mb_u_int32 | ( zero index )
+ * @note index = mb_u_int32
+ */
+static WBXMLError parse_publicid(WBXMLParser *parser)
+{
+    WB_UTINY public_id;
+    WBXMLError ret;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, parser->pos, &public_id))
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id value: '0x%X'", parser->pos, public_id));
+
+    if (public_id == 0x00) {
+        parser->pos++;
+
+        /* Get index (we will retrieve the Public ID later from string table) */
+        ret = parse_mb_uint32(parser, (WB_ULONG *)&parser->public_id_index);
+        WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id index: '0x%x'", parser->pos-1, parser->public_id_index));
+        return ret;
+    }
+    else {
+        /* Get Public ID */
+        ret = parse_mb_uint32(parser, &parser->public_id);        
+        WBXML_DEBUG((WBXML_PARSER, "(%d) Parsed public id: '0x%x'", parser->pos-1, parser->public_id));
+        return ret;
+    }
+}
+
+
+/**
+ * @brief Parse WBXML charset
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note charset = mb_u_int32
+ * @note "The binary XML format contains a representation of the XML document character encoding.
+ *        This is the WBXML equivalent of the XML document format encoding attribute,
+ *        which is specified in the ?xml processing instruction. The character set is encoded as
+ *        a multi-byte positive integer value, representing the IANA-assigned MIB number for
+ *        a character set. A value of zero indicates an unknown document encoding. In the case of
+ *        an unknown encoding, transport meta-information should be used to determine the character
+ *        encoding. If transport meta-information is unavailable, the default encoding of UTF-8
+ *        should be assumed."
+ */
+static WBXMLError parse_charset(WBXMLParser *parser)
+{
+    /* definitions first ... or some compilers don't like it */
+    const char *charset_name = NULL;
+
+#if defined( WBXML_LIB_VERBOSE )
+    WB_ULONG startpos = parser->pos;
+#endif /* WBXML_LIB_VERBOSE */
 
     unsigned int charset = 0;
     WBXMLError ret = parse_mb_uint32(parser, &charset);
@@ -792,7 +1752,7 @@ static WBXMLError parse_strtbl(WBXMLParser *parser)
 
         /* Get String Table */
         data = wbxml_buffer_get_cstr(parser->wbxml);
-        parser->strstbl = wbxml_buffer_create(data + parser->pos, strtbl_len, WBXML_PARSER_STRING_TABLE_MALLOC_BLOCK);
+        parser->strstbl = wbxml_buffer_create_with_allocator(parser->allocator, data + parser->pos, strtbl_len, WBXML_PARSER_STRING_TABLE_MALLOC_BLOCK);
         if (parser->strstbl == NULL)
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
@@ -850,20 +1810,62 @@ static WBXMLError parse_body(WBXMLParser *parser)
 
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing body", parser->pos));
 
-    while (is_token(parser, WBXML_PI)) {
-        if ((ret = parse_pi(parser)) != WBXML_OK)
+    while (parser->state != WBXML_PARSER_STATE_DONE) {
+        if ((ret = parse_body_part(parser)) != WBXML_OK) {
+            /* Free Elements left open */
+            free_elements(parser);
             return ret;
+        }
     }
 
-    if ((ret = parse_element(parser)) != WBXML_OK)
-        return ret;
+    return WBXML_OK;
+}
+
 
-    while (is_token(parser, WBXML_PI)) {
-        if ((ret = parse_pi(parser)) != WBXML_OK)
+/**
+ * @brief Parse next part of WBXML body
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note The part parsed depends on the parser state: a pi, the root Element start,
+ *       or a part of root Element (cf parse_element()). The state is updated accordingly.
+ */
+static WBXMLError parse_body_part(WBXMLParser *parser)
+{
+    WBXMLTag   *element  = NULL;
+    WBXMLError  ret      = WBXML_OK;
+    WB_BOOL     is_empty = FALSE;
+
+    switch (parser->state) {
+    case WBXML_PARSER_STATE_BODY:
+        /* *pi */
+        if (is_token(parser, WBXML_PI))
+            return parse_pi(parser);
+
+        /* Root Element start */
+        if ((ret = parse_element_start(parser, &element, &is_empty)) != WBXML_OK)
             return ret;
-    }
 
-    return WBXML_OK;
+        parser->state = WBXML_PARSER_STATE_ELEMENT;
+
+        return open_element(parser, element, is_empty);
+
+    case WBXML_PARSER_STATE_ELEMENT:
+        return parse_element(parser);
+
+    case WBXML_PARSER_STATE_SKIP:
+        return parse_skipped_part(parser);
+
+    case WBXML_PARSER_STATE_END:
+        /* *pi */
+        if (is_token(parser, WBXML_PI))
+            return parse_pi(parser);
+
+        parser->state = WBXML_PARSER_STATE_DONE;
+        return WBXML_OK;
+
+    default:
+        return WBXML_ERROR_INTERNAL;
+    }
 }
 
 
@@ -896,15 +1898,15 @@ static WBXMLError parse_pi(WBXMLParser *parser)
       
     if (start_value != NULL ) {
         /* Create a buffer from attribute start value */
-        attr_value = wbxml_buffer_create(start_value,
-                                         WBXML_STRLEN(start_value),
-                                         WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
+        attr_value = wbxml_buffer_create_with_allocator(parser->allocator, start_value,
+                                                        WBXML_STRLEN(start_value),
+                                                        WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
     }
     else {
         /* Create an empty buffer */
-        attr_value = wbxml_buffer_create(NULL,
-                                         0,
-                                         WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
+        attr_value = wbxml_buffer_create_with_allocator(parser->allocator, NULL,
+                                                        0,
+                                                        WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
     }
       
     if (attr_value == NULL) {
@@ -965,22 +1967,156 @@ static WBXMLError parse_pi(WBXMLParser *parser)
 
 
 /**
- * @brief Parse WBXML element
+ * @brief Parse next part of WBXML element
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note element = ([switchPage] stag) [ 1*attribute END ] [ *content END ]
+ * @note The next part of the innermost open Element is parsed: its END, the start of an Element
+ *       found in its content, or another content. Open Elements are kept on an explicit stack,
+ *       so that nesting depth does not consume the call stack.
+ */
+static WBXMLError parse_element(WBXMLParser *parser)
+{
+    WBXMLTag       *element  = NULL;
+    WBXMLBuffer    *content  = NULL;
+    const WB_UTINY *data     = NULL;
+    WB_ULONG        len      = 0;
+    WBXMLError      ret      = WBXML_OK;
+    WB_BOOL         is_empty = FALSE;
+
+    if (is_token(parser, WBXML_END)) {
+        WBXML_DEBUG((WBXML_PARSER, "(%d) End of Element", parser->pos));
+
+        /* Skip END */
+        parser->pos++;
+
+        parse_element_end(parser, parser->elements[--parser->depth]);
+
+        /* All Elements are closed */
+        if (parser->depth == 0)
+            parser->state = WBXML_PARSER_STATE_END;
+
+        return WBXML_OK;
+    }
+
+    if (is_element(parser)) {
+        /* Check depth limit */
+        if ((parser->max_depth != 0) && (parser->depth >= parser->max_depth)) {
+            WBXML_ERROR((WBXML_PARSER, "Maximum Element depth exceeded (%d)", parser->max_depth));
+            return WBXML_ERROR_MAX_DEPTH_EXCEEDED;
+        }
+
+        /* Parse Element start */
+        if ((ret = parse_element_start(parser, &element, &is_empty)) != WBXML_OK)
+            return ret;
+
+        return open_element(parser, element, is_empty);
+    }
+
+    /* Content given as is: callback WBXMLCharactersHandler if content is not empty */
+    if (get_content_slice(parser, &data, &len)) {
+        if ((len != 0) &&
+            (parser->content_hdl != NULL) &&
+            (parser->content_hdl->characters_clb != NULL))
+        {
+            parser->content_hdl->characters_clb(parser->user_data, (WB_UTINY *) data, 0, len);
+        }
+
+        return WBXML_OK;
+    }
+
+    /* Parse content */
+    if ((ret = parse_content(parser, &content)) != WBXML_OK)
+        return ret;
+
+    /* Callback WBXMLCharactersHandler if content is not NULL */
+    if ((content != NULL) &&
+        (wbxml_buffer_len(content) != 0) &&
+        (parser->content_hdl != NULL) &&
+        (parser->content_hdl->characters_clb != NULL))
+    {
+        parser->content_hdl->characters_clb(parser->user_data,
+                                            wbxml_buffer_get_cstr(content),
+                                            0,
+                                            wbxml_buffer_len(content));
+    }
+
+    /* Free content */
+    wbxml_buffer_destroy(content);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Parse next parts of a skipped WBXML element
+ * @param parser The WBXML Parser
+ * @return WBXML_OK if parsing is OK, an error code otherwise
+ * @note Same parts than parse_element(), but they are only skipped: no Tag, Attribute or content
+ *       is created, strings and opaque data are not decoded, and no callback is called. Only the
+ *       switchPage tokens are applied, so that what follows is parsed with the right Code Pages.
+ * @note The whole skipped Element is skipped at once, but when the Document is fed by chunks
+ *       (one part at a time, cf is_part_complete()). Its END is parsed by parse_element().
+ */
+static WBXMLError parse_skipped_part(WBXMLParser *parser)
+{
+    WB_UTINY   cur_byte;
+    WBXMLError ret = WBXML_OK;
+
+    do {
+        if (!wbxml_buffer_get_char(parser->wbxml, parser->pos, &cur_byte))
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        if (cur_byte == WBXML_END) {
+            /* End of skipped Element */
+            if (parser->skip_depth == 0) {
+                parser->state = WBXML_PARSER_STATE_ELEMENT;
+                return parse_element(parser);
+            }
+
+            /* Skip END */
+            parser->pos++;
+            parser->skip_depth--;
+        }
+        else if (is_element(parser)) {
+            /* Check depth limit */
+            if ((parser->max_depth != 0) && (parser->depth + parser->skip_depth >= parser->max_depth)) {
+                WBXML_ERROR((WBXML_PARSER, "Maximum Element depth exceeded (%d)", parser->max_depth));
+                return WBXML_ERROR_MAX_DEPTH_EXCEEDED;
+            }
+
+            /* The tag tells if this Element has a content (a switchPage is skipped as a content) */
+            if ((ret = skip_element_start(parser, &parser->pos)) == WBXML_OK) {
+                if (cur_byte & WBXML_TOKEN_WITH_CONTENT)
+                    parser->skip_depth++;
+            }
+        }
+        else
+            ret = skip_content(parser, &parser->pos);
+    } while ((ret == WBXML_OK) && !parser->feeding);
+
+    return ret;
+}
+
+
+/**
+ * @brief Parse the start of a WBXML element
  * @param parser The WBXML Parser
+ * @param element [out] The parsed Element Tag
+ * @param is_empty [out] TRUE if this Element has no content
  * @return WBXML_OK if parsing is OK, an error code otherwise
- * @note element = ([switchPage] stag) [ 1*attribute END ] [ *content END ]
+ * @note ([switchPage] stag) [ 1*attribute END ]
+ * @note The WBXMLStartElementHandler callback is called here: it can ask to skip this Element
+ *       (cf wbxml_parser_skip_element())
  */
-static WBXMLError parse_element(WBXMLParser *parser)
+static WBXMLError parse_element_start(WBXMLParser *parser, WBXMLTag **element, WB_BOOL *is_empty)
 {
-    WBXMLTag        *element        = NULL;
     WBXMLAttribute  *attr           = NULL;
     WBXMLAttribute **attrs          = NULL;
-    WBXMLBuffer     *content        = NULL;
   
     WB_ULONG         attrs_nb       = 0;
     WBXMLError       ret            = WBXML_OK;
     WB_UTINY         tag            = 0;
-    WB_BOOL          is_empty       = FALSE;
   
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing element", parser->pos));
   
@@ -991,15 +2127,15 @@ static WBXMLError parse_element(WBXMLParser *parser)
     }
   
     /* Parse Tag */
-    if ((ret = parse_stag(parser, &tag, &element)) != WBXML_OK ) {
+    if ((ret = parse_stag(parser, &tag, element)) != WBXML_OK ) {
         return ret;
     }
 
-    WBXML_DEBUG((WBXML_PARSER, "<%s>", wbxml_tag_get_xml_name(element)));
+    WBXML_DEBUG((WBXML_PARSER, "<%s>", wbxml_tag_get_xml_name(*element)));
   
     /* Set Current Tag */
-    if (element->type == WBXML_VALUE_TOKEN) {
-        parser->current_tag = element->u.token;
+    if ((*element)->type == WBXML_VALUE_TOKEN) {
+        parser->current_tag = (*element)->u.token;
     }
   
     /* Parse Attributes */
@@ -1010,21 +2146,23 @@ static WBXMLError parse_element(WBXMLParser *parser)
         do {
             /* Parse attribute */
             if ((ret = parse_attribute(parser, &attr)) != WBXML_OK) {
-                wbxml_tag_destroy(element);
-                free_attrs_table(attrs);
+                wbxml_tag_destroy(*element);
+                *element = NULL;
+                free_attrs_table(parser, attrs);
                 return ret;
             }
           
             /* Append this attribute in WBXMLAttribute **attrs table */
             attrs_nb++;
     
-            if ((attrs = wbxml_realloc(attrs,
-                                        (attrs_nb + 1) * sizeof(*attrs))) == NULL)
+            if ((attrs = wbxml_mem_realloc(parser->allocator, attrs,
+                                           (attrs_nb + 1) * sizeof(*attrs))) == NULL)
             {
                 /* Clean-up */
-                wbxml_tag_destroy(element);
+                wbxml_tag_destroy(*element);
+                *element = NULL;
                 wbxml_attribute_destroy(attr);
-                free_attrs_table(attrs);
+                free_attrs_table(parser, attrs);
                 return WBXML_ERROR_NOT_ENOUGH_MEMORY;
             }
     
@@ -1037,55 +2175,66 @@ static WBXMLError parse_element(WBXMLParser *parser)
     }
     
     /* Is it an empty element ? */
-    is_empty = (WB_BOOL) !(tag & WBXML_TOKEN_WITH_CONTENT);
+    *is_empty = (WB_BOOL) !(tag & WBXML_TOKEN_WITH_CONTENT);
       
     /* Callback WBXMLStartElementHandler */
+    parser->skip = FALSE;
+
     if ((parser->content_hdl != NULL) &&
         (parser->content_hdl->start_element_clb != NULL))
     {
         parser->content_hdl->start_element_clb(parser->user_data,
-                                               element,
+                                               *element,
                                                attrs);
     }
     
     /* Free Attributes */
-    free_attrs_table(attrs);
-    
-    
-    /* Parse *content */
-    if (!is_empty) {
-        /* There can be NO content */
-        while (!is_token(parser, WBXML_END)) {
-            /* Parse content */
-            if ((ret = parse_content(parser, &content)) != WBXML_OK)
-            {
-                wbxml_tag_destroy(element);
-                return ret;
-            }
-    
-            /* Callback WBXMLCharactersHandler if content is not NULL */
-            if ((content != NULL) &&
-                (wbxml_buffer_len(content) != 0) &&
-                (parser->content_hdl != NULL) &&
-                (parser->content_hdl->characters_clb != NULL))
-            {
-                parser->content_hdl->characters_clb(parser->user_data,
-                                                    wbxml_buffer_get_cstr(content),
-                                                    0,
-                                                    wbxml_buffer_len(content));
-            }
-          
-            /* Free content */
-            wbxml_buffer_destroy(content);
-            content = NULL;
-        }
-        
-        WBXML_DEBUG((WBXML_PARSER, "(%d) End of Element", parser->pos - 1));
-        
-        /* Skip END */
-        parser->pos++;
+    free_attrs_table(parser, attrs);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Open a WBXML element, which start was just parsed
+ * @param parser The WBXML Parser
+ * @param element The Element Tag (freed by this function if not pushed)
+ * @param is_empty TRUE if this Element has no content
+ * @return WBXML_OK if opened, WBXML_ERROR_NOT_ENOUGH_MEMORY otherwise
+ * @note An empty Element is ended at once, else it is pushed on the stack of open Elements.
+ *       If it must be skipped, its content is then skipped up to its END (cf parse_skipped_part()).
+ */
+static WBXMLError open_element(WBXMLParser *parser, WBXMLTag *element, WB_BOOL is_empty)
+{
+    WBXMLError ret = WBXML_OK;
+
+    if (is_empty)
+        parse_element_end(parser, element);
+    else if ((ret = push_element(parser, element)) != WBXML_OK)
+        wbxml_tag_destroy(element);
+    else if (parser->skip) {
+        parser->state = WBXML_PARSER_STATE_SKIP;
+        parser->skip_depth = 0;
     }
-      
+
+    parser->skip = FALSE;
+
+    /* All Elements are closed */
+    if (parser->depth == 0)
+        parser->state = WBXML_PARSER_STATE_END;
+
+    return ret;
+}
+
+
+/**
+ * @brief End a WBXML element
+ * @param parser The WBXML Parser
+ * @param element The Element Tag (freed by this function)
+ * @note The WBXMLEndElementHandler callback is called here
+ */
+static void parse_element_end(WBXMLParser *parser, WBXMLTag *element)
+{
     /* Callback WBXMLEndElementHandler */
     if ((parser->content_hdl != NULL) &&
         (parser->content_hdl->end_element_clb != NULL))
@@ -1101,16 +2250,53 @@ static WBXMLError parse_element(WBXMLParser *parser)
       
     /* Reset Current Tag */
     parser->current_tag = NULL;
-      
+}
+
+
+/**
+ * @brief Push an Element on the stack of open Elements
+ * @param parser The WBXML Parser
+ * @param element The Element Tag
+ * @return WBXML_OK if pushed, WBXML_ERROR_NOT_ENOUGH_MEMORY otherwise
+ */
+static WBXMLError push_element(WBXMLParser *parser, WBXMLTag *element)
+{
+    WBXMLTag **elements = NULL;
+
+    if (parser->depth == parser->elements_size) {
+        if ((elements = wbxml_mem_realloc(parser->allocator, parser->elements,
+                                          (parser->elements_size + WBXML_PARSER_ELEMENTS_MALLOC_BLOCK) * sizeof(*elements))) == NULL)
+        {
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        parser->elements = elements;
+        parser->elements_size += WBXML_PARSER_ELEMENTS_MALLOC_BLOCK;
+    }
+
+    parser->elements[parser->depth++] = element;
+
     return WBXML_OK;
 }
 
 
+/**
+ * @brief Free the Elements left open (on error, or if parsing is abandoned)
+ * @param parser The WBXML Parser
+ */
+static void free_elements(WBXMLParser *parser)
+{
+    while (parser->depth > 0)
+        wbxml_tag_destroy(parser->elements[--parser->depth]);
+}
+
+
 /**
  * @brief Free a (WBXMLAttribute *) table
+ * @param parser The WBXML Parser
  * @param attrs The table to ree
  */
-static void free_attrs_table(WBXMLAttribute **attrs)
+static void free_attrs_table(WBXMLParser *parser, WBXMLAttribute **attrs)
 {
     WB_LONG i = 0;
 
@@ -1119,7 +2305,7 @@ static void free_attrs_table(WBXMLAttribute **attrs)
             /* Free attribute */
             wbxml_attribute_destroy(attrs[i++]);
         }
-        wbxml_free(attrs);
+        wbxml_mem_free(parser->allocator, attrs);
     }
 }
 
@@ -1163,8 +2349,8 @@ static WBXMLError parse_switch_page(WBXMLParser *parser, WBXMLTokenType code_spa
  */
 static WBXMLError parse_stag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **element)
 {
-    WBXMLBuffer *name = NULL;
-    WBXMLError   ret  = WBXML_OK;
+    const WB_UTINY *name = NULL;
+    WBXMLError      ret  = WBXML_OK;
   
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing stag", parser->pos));
   
@@ -1175,11 +2361,10 @@ static WBXMLError parse_stag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **elem
         }
     
         /* Create Element Tag */
-        if ((*element = wbxml_tag_create_literal(wbxml_buffer_get_cstr(name))) == NULL) {
+        if ((*element = wbxml_tag_create_literal_with_allocator(parser->allocator, (WB_UTINY *) name)) == NULL) {
             ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
 
-        wbxml_buffer_destroy(name);
         return ret;
     }
 
@@ -1197,7 +2382,7 @@ static WBXMLError parse_stag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **elem
  */
 static WBXMLError parse_tag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **element)
 {
-    WB_ULONG index = 0;
+    const WBXMLTagEntry *entry = NULL;
     WB_UTINY token;
     WBXMLError ret = WBXML_OK;
 
@@ -1217,17 +2402,10 @@ static WBXMLError parse_tag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **eleme
         return WBXML_ERROR_TAG_TABLE_UNDEFINED;
 
     
-    while ((parser->langTable->tagTable[index].xmlName != NULL) &&
-           ((parser->langTable->tagTable[index].wbxmlToken != token) ||
-            (parser->langTable->tagTable[index].wbxmlCodePage != parser->tagCodePage))) {
-        index++;
-    }
-
-
-    if (parser->langTable->tagTable[index].xmlName == NULL) {
+    if ((entry = wbxml_tables_get_tag_from_token(parser->langTable, parser->tagCodePage, token)) == NULL) {
 #if WBXML_PARSER_BEST_EFFORT
         /* Create "unknown" Tag Element */
-        if ((*element = wbxml_tag_create_literal(WBXML_PARSER_UNKNOWN_STRING)) == NULL)
+        if ((*element = wbxml_tag_create_literal_with_allocator(parser->allocator, WBXML_PARSER_UNKNOWN_STRING)) == NULL)
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
         return WBXML_OK;
@@ -1236,10 +2414,10 @@ static WBXMLError parse_tag(WBXMLParser *parser, WB_UTINY *tag, WBXMLTag **eleme
 #endif /* WBXML_PARSER_BEST_EFFORT */
     }
 
-    if ((*element = wbxml_tag_create(WBXML_VALUE_TOKEN)) == NULL)
+    if ((*element = wbxml_tag_create_with_allocator(parser->allocator, WBXML_VALUE_TOKEN)) == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
-    (*element)->u.token = &(parser->langTable->tagTable[index]);
+    (*element)->u.token = entry;
 
     WBXML_DEBUG((WBXML_PARSER, "(%d) Token: 0x%X", parser->pos - 1, token));
     
@@ -1259,8 +2437,11 @@ static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr)
 {
     WBXMLAttributeName *attr_name    = NULL;
     const WB_UTINY     *start_value  = NULL;
+    const WB_UTINY     *str          = NULL;
     WBXMLBuffer        *attr_value   = NULL;
     WBXMLBuffer        *tmp_value    = NULL;
+    WB_ULONG            index        = 0;
+    WB_ULONG            len          = 0;
     WBXMLError          ret          = WBXML_OK;
   
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing attribute", parser->pos));
@@ -1275,15 +2456,15 @@ static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr)
   
     if ( start_value != NULL ) {
         /* Create a buffer from attribute start value */
-        attr_value = wbxml_buffer_create(start_value,
-                                         WBXML_STRLEN(start_value),
-                                         WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
+        attr_value = wbxml_buffer_create_with_allocator(parser->allocator, start_value,
+                                                        WBXML_STRLEN(start_value),
+                                                        WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
     }
     else {
         /* Create an empty buffer */
-        attr_value = wbxml_buffer_create(NULL,
-                                         0,
-                                         WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
+        attr_value = wbxml_buffer_create_with_allocator(parser->allocator, NULL,
+                                                        0,
+                                                        WBXML_PARSER_ATTR_VALUE_MALLOC_BLOCK);
     }
   
     if (attr_value == NULL) {
@@ -1294,6 +2475,27 @@ static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr)
   
     /* Construct Attribute Value */
     while (is_attr_value(parser)) {
+        /* String Table reference: appended as is, without creating a Buffer */
+        if (is_token(parser, WBXML_STR_T)) {
+            parser->pos++;
+
+            if (((ret = parse_mb_uint32(parser, &index)) != WBXML_OK) ||
+                ((ret = get_strtbl_slice(parser, index, &str, &len)) != WBXML_OK))
+            {
+                wbxml_attribute_name_destroy(attr_name);
+                wbxml_buffer_destroy(attr_value);
+                return ret;
+            }
+
+            if (!wbxml_buffer_append_data(attr_value, str, len)) {
+                wbxml_attribute_name_destroy(attr_name);
+                wbxml_buffer_destroy(attr_value);
+                return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+            }
+
+            continue;
+        }
+
         /* Parse attrValue */
         if ((ret = parse_attr_value(parser, &tmp_value)) != WBXML_OK) {
             wbxml_attribute_name_destroy(attr_name);
@@ -1363,7 +2565,7 @@ static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr)
         }
     }
   
-    if ((*attr = wbxml_attribute_create()) == NULL) {
+    if ((*attr = wbxml_attribute_create_with_allocator(parser->allocator)) == NULL) {
         wbxml_attribute_name_destroy(attr_name);
         wbxml_buffer_destroy(attr_value);
 
@@ -1380,9 +2582,10 @@ static WBXMLError parse_attribute(WBXMLParser *parser, WBXMLAttribute **attr)
 /**
  * @brief Parse WBXML content
  * @param parser The WBXML Parser
- * @param result Resulting parsed content, if content is not an Element
+ * @param result Resulting parsed content
  * @return WBXML_OK if parsing is OK, an error code otherwise
  * @note content = element | string | extension | entity | pi | opaque
+ * @note Elements are not parsed here, but in parse_element() loop (cf is_element())
  */
 static WBXMLError parse_content(WBXMLParser *parser, WBXMLBuffer **result)
 {
@@ -1439,8 +2642,91 @@ static WBXMLError parse_content(WBXMLParser *parser, WBXMLBuffer **result)
     if ( is_token(parser, WBXML_SWITCH_PAGE) )
       return parse_switch_page(parser, WBXML_TAG_TOKEN);
 
-    /** @note We have recurrency here ! */
-    return parse_element(parser);
+    /* element: parsed by caller */
+    return WBXML_ERROR_INTERNAL;
+}
+
+
+/**
+ * @brief Get WBXML content as a slice of Document, if it needs no decoding
+ * @param parser The WBXML Parser
+ * @param data [out] The content, in 'wbxml' or in String Table
+ * @param len [out] The content length
+ * @return TRUE if content is parsed, FALSE if it must be parsed by parse_content()
+ * @note A string needs no decoding in an US-ASCII or UTF-8 Document, so as an opaque that is not
+ *       decoded by decode_opaque_content(): it is given as is, without creating a buffer.
+ *       In other charsets, a String Table reference is given as converted by get_strtbl_slice().
+ *       Opaque content is only given this way if accepted by user (cf wbxml_parser_set_borrowed_content()).
+ * @note Other content, or malformed content, is left to parse_content() ('pos' is not moved)
+ */
+static WB_BOOL get_content_slice(WBXMLParser *parser, const WB_UTINY **data, WB_ULONG *len)
+{
+    const WB_UTINY *str      = NULL;
+    const WB_UTINY *term     = NULL;
+    WB_ULONG        pos      = parser->pos;
+    WB_ULONG        str_len  = 0;
+    WB_UTINY        cur_byte = 0;
+
+    if (!wbxml_buffer_get_char(parser->wbxml, pos, &cur_byte))
+        return FALSE;
+
+    switch (cur_byte) {
+    case WBXML_STR_I:
+        /* inline = STR_I termstr */
+        if ((parser->charset != WBXML_CHARSET_US_ASCII) && (parser->charset != WBXML_CHARSET_UTF_8))
+            return FALSE;
+
+        pos++;
+
+        str = wbxml_buffer_get_cstr(parser->wbxml) + pos;
+        str_len = wbxml_buffer_len(parser->wbxml) - pos;
+
+        /* US-ASCII and UTF-8 are NULL terminated */
+        if ((term = memchr(str, '\0', str_len)) == NULL)
+            return FALSE;
+
+        str_len = (WB_ULONG) (term - str);
+        pos += str_len + 1;
+        break;
+
+    case WBXML_STR_T:
+        /* tableref = STR_T index (converted once, in other charsets) */
+        pos++;
+
+        if ((parser->strstbl == NULL) ||
+            (skip_mb_uint32(parser, &pos, &str_len) != WBXML_OK) ||
+            (get_strtbl_slice(parser, str_len, &str, &str_len) != WBXML_OK))
+        {
+            return FALSE;
+        }
+        break;
+
+    case WBXML_OPAQUE:
+        /* opaque = OPAQUE length *byte */
+        if (!parser->borrow_content || (parser->langTable == NULL) || is_opaque_content_decoded(parser))
+            return FALSE;
+
+        pos++;
+
+        if ((skip_mb_uint32(parser, &pos, &str_len) != WBXML_OK) ||
+            (str_len > wbxml_buffer_len(parser->wbxml) - pos))
+        {
+            return FALSE;
+        }
+
+        str = wbxml_buffer_get_cstr(parser->wbxml) + pos;
+        pos += str_len;
+        break;
+
+    default:
+        return FALSE;
+    }
+
+    *data = str;
+    *len = str_len;
+    parser->pos = pos;
+
+    return TRUE;
 }
 
 
@@ -1498,7 +2784,7 @@ static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space
   
 #if defined ( WBXML_SUPPORT_WV )
     WB_ULONG ext_value = 0;
-    WB_UTINY tab_index = 0;
+    const WBXMLExtValueEntry *ext_entry = NULL;
 #endif /* WBXML_SUPPORT_WV */
   
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing extension", parser->pos));
@@ -1581,10 +2867,10 @@ static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space
         }
 
         /* Build Variable */
-        ext = wbxml_malloc(WBXML_STRLEN(var_begin) +
-                                       wbxml_buffer_len(var_value) +
-                                       WBXML_STRLEN(escape) +
-                                       WBXML_STRLEN(var_end) + 1);
+        ext = wbxml_mem_malloc(parser->allocator, WBXML_STRLEN(var_begin) +
+                               wbxml_buffer_len(var_value) +
+                               WBXML_STRLEN(escape) +
+                               WBXML_STRLEN(var_end) + 1);
         if (ext == NULL) {
             wbxml_buffer_destroy(var_value);
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
@@ -1624,7 +2910,7 @@ static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space
             break;
 
         default:
-            wbxml_free(ext);
+            wbxml_mem_free(parser->allocator, ext);
             return WBXML_ERROR_UNKNOWN_EXTENSION_TOKEN;
         }
     
@@ -1660,27 +2946,19 @@ static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space
             return WBXML_ERROR_EXT_VALUE_TABLE_UNDEFINED;
         }
     
-        tab_index = 0;
-    
-        while ((parser->langTable->extValueTable[tab_index].xmlName != NULL) &&
-               (parser->langTable->extValueTable[tab_index].wbxmlToken != ext_value) )
-        {
-            tab_index++;
-        }
-    
-        if (parser->langTable->extValueTable[tab_index].xmlName == NULL) {
+        if ((ext_entry = wbxml_tables_get_ext_from_token(parser->langTable, ext_value)) == NULL) {
 #if WBXML_PARSER_BEST_EFFORT
-            ext = (WB_UTINY *) wbxml_strdup((const WB_TINY*) WBXML_PARSER_UNKNOWN_STRING);
+            ext = (WB_UTINY *) wbxml_mem_strdup(parser->allocator, (const WB_TINY*) WBXML_PARSER_UNKNOWN_STRING);
             len = WBXML_STRLEN(WBXML_PARSER_UNKNOWN_STRING);
-            wbxml_free(ext);
+            wbxml_mem_free(parser->allocator, ext);
             return WBXML_OK;
 #else
             return WBXML_ERROR_UNKNOWN_EXTENSION_VALUE;
 #endif /* WBXML_PARSER_BEST_EFFORT */
         }
     
-        ext = (WB_UTINY *) wbxml_strdup((const WB_TINY*) parser->langTable->extValueTable[tab_index].xmlName);
-        len = WBXML_STRLEN(parser->langTable->extValueTable[tab_index].xmlName);
+        ext = (WB_UTINY *) wbxml_mem_strdup(parser->allocator, (const WB_TINY*) ext_entry->xmlName);
+        len = WBXML_STRLEN(ext_entry->xmlName);
         break;
 
 #endif /* WBXML_SUPPORT_WV */
@@ -1694,13 +2972,13 @@ static WBXMLError parse_extension(WBXMLParser *parser, WBXMLTokenType code_space
         *result = NULL;
     }
     else {
-        if ((*result = wbxml_buffer_create(ext, len, len)) == NULL) {
-            wbxml_free(ext);
+        if ((*result = wbxml_buffer_create_with_allocator(parser->allocator, ext, len, len)) == NULL) {
+            wbxml_mem_free(parser->allocator, ext);
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
 
         /** @todo Replace this local var by the direct creation of the result Buffer */
-        wbxml_free(ext);
+        wbxml_mem_free(parser->allocator, ext);
     }
   
     return WBXML_OK;
@@ -1750,7 +3028,7 @@ static WBXMLError parse_entity(WBXMLParser *parser, WBXMLBuffer **result)
         WB_TINY entity[2] = {(WB_TINY)code, 0};
 
         /* Create result buffer */
-        if ( (*result = wbxml_buffer_create_from_cstr(entity)) == NULL ) {
+        if ( (*result = wbxml_buffer_create_with_allocator(parser->allocator, entity, WBXML_STRLEN(entity), WBXML_STRLEN(entity))) == NULL ) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
       
@@ -1770,7 +3048,7 @@ static WBXMLError parse_entity(WBXMLParser *parser, WBXMLBuffer **result)
         entity[index] = masks[index] | code;
 
         /* Create result buffer */
-        if ( (*result = wbxml_buffer_create_from_cstr((WB_TINY *) entity + index)) == NULL ) {
+        if ( (*result = wbxml_buffer_create_with_allocator(parser->allocator, (WB_TINY *) entity + index, WBXML_STRLEN((WB_TINY *) entity + index), WBXML_STRLEN((WB_TINY *) entity + index))) == NULL ) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
       
@@ -1814,7 +3092,7 @@ static WBXMLError parse_opaque(WBXMLParser *parser, WBXMLBuffer **result)
      * Create result buffer (don't create a static buffer, because this can be
      * modified while trying to decode this content)
      */
-    *result = wbxml_buffer_create(wbxml_buffer_get_cstr(parser->wbxml) + parser->pos, len, len);
+    *result = wbxml_buffer_create_with_allocator(parser->allocator, wbxml_buffer_get_cstr(parser->wbxml) + parser->pos, len, len);
     if (*result == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
@@ -1832,18 +3110,19 @@ static WBXMLError parse_opaque(WBXMLParser *parser, WBXMLBuffer **result)
  *                                   WBXML_TOKEN_WITH_CONTENT  |
  *                                   WBXML_TOKEN_WITH_ATTRS    |
  *                                   (WBXML_TOKEN_WITH_CONTENT || WBXML_TOKEN_WITH_ATTRS))
- * @param result The resulting parsed literal
+ * @param result The resulting parsed literal (NULL terminated, in String Table: must not be freed)
  * @return WBXML_OK if parsing is OK, an error code otherwise
  * @note    result = ( literalTag index )
  *            literalTag = LITERAL | LITERAL_A | LITERAL_C | LITERAL_AC
  */
-static WBXMLError parse_literal(WBXMLParser  *parser,
-                                WB_UTINY     *mask,
-                                WBXMLBuffer **result)
+static WBXMLError parse_literal(WBXMLParser     *parser,
+                                WB_UTINY        *mask,
+                                const WB_UTINY **result)
 {
     WBXMLError ret     = WBXML_OK;
     WB_UTINY   token   = 0;
     WB_ULONG   index   = 0;
+    WB_ULONG   len     = 0;
   
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing literalTag", parser->pos));
   
@@ -1858,7 +3137,7 @@ static WBXMLError parse_literal(WBXMLParser  *parser,
     }
   
     /* Get string */
-    if ( (ret = get_strtbl_reference(parser, index, result)) != WBXML_OK ) {
+    if ( (ret = get_strtbl_slice(parser, index, result, &len)) != WBXML_OK ) {
         return ret;
     }
 
@@ -1900,11 +3179,11 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
                                    WBXMLAttributeName **name,
                                    const WB_UTINY     **value)
 {
-    WBXMLBuffer *literal_str = NULL;
+    const WB_UTINY *literal_str = NULL;
     WB_UTINY     literal     = 0;    
     WB_UTINY     tag         = 0;
     WBXMLError   ret         = WBXML_OK;
-    WB_ULONG     index       = 0;
+    const WBXMLAttrEntry *entry = NULL;
 
     WBXML_DEBUG((WBXML_PARSER, "(%d) Parsing attrStart", parser->pos));
   
@@ -1918,7 +3197,7 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
             return ret;
         }
     
-        if ((*name = wbxml_attribute_name_create_literal(wbxml_buffer_get_cstr(literal_str))) == NULL) {
+        if ((*name = wbxml_attribute_name_create_literal_with_allocator(parser->allocator, (WB_UTINY *) literal_str)) == NULL) {
             ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
     
@@ -1927,7 +3206,6 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
          *       LITERAL_A, nor LITERAL_C, nor LITERAL_AC
          */
 
-        wbxml_buffer_destroy(literal_str);
         return WBXML_OK;
     }
   
@@ -1959,17 +3237,10 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
         return WBXML_ERROR_ATTR_TABLE_UNDEFINED;
     }
 
-    while ((parser->langTable->attrTable[index].xmlName != NULL) &&
-           ((parser->langTable->attrTable[index].wbxmlToken != tag) ||
-            (parser->langTable->attrTable[index].wbxmlCodePage != parser->attrCodePage)))
-    {
-        index++;
-    }
-  
-    if (parser->langTable->attrTable[index].xmlName == NULL) {
+    if ((entry = wbxml_tables_get_attr_from_token(parser->langTable, parser->attrCodePage, tag)) == NULL) {
 #if WBXML_PARSER_BEST_EFFORT
         /* Create "unknown" Attribute Name */
-        if ((*name = wbxml_attribute_name_create_literal(WBXML_PARSER_UNKNOWN_STRING)) == NULL) {
+        if ((*name = wbxml_attribute_name_create_literal_with_allocator(parser->allocator, WBXML_PARSER_UNKNOWN_STRING)) == NULL) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
     
@@ -1980,15 +3251,15 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
     }
   
     /* Create Token Attribute Name */
-    if ((*name = wbxml_attribute_name_create(WBXML_VALUE_TOKEN)) == NULL) {
+    if ((*name = wbxml_attribute_name_create_with_allocator(parser->allocator, WBXML_VALUE_TOKEN)) == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
   
-    (*name)->u.token = &(parser->langTable->attrTable[index]);
+    (*name)->u.token = entry;
   
     /* Get Attribute start value (if any) */
-    if (parser->langTable->attrTable[index].xmlValue != NULL) {
-        *value = (const WB_UTINY *) parser->langTable->attrTable[index].xmlValue;
+    if (entry->xmlValue != NULL) {
+        *value = (const WB_UTINY *) entry->xmlValue;
     }
   
     return WBXML_OK;
@@ -2005,7 +3276,7 @@ static WBXMLError parse_attr_start(WBXMLParser         *parser,
 static WBXMLError parse_attr_value(WBXMLParser  *parser,
                                    WBXMLBuffer **result)
 {
-    WB_ULONG   index = 0;
+    const WBXMLAttrValueEntry *entry = NULL;
     WB_UTINY   tag   = 0;
     WBXMLError ret   = WBXML_OK;
   
@@ -2066,18 +3337,11 @@ static WBXMLError parse_attr_value(WBXMLParser  *parser,
         return WBXML_ERROR_ATTR_VALUE_TABLE_UNDEFINED;
     }
   
-    while ((parser->langTable->attrValueTable[index].xmlName != NULL) &&
-           ((parser->langTable->attrValueTable[index].wbxmlToken != tag) ||
-            (parser->langTable->attrValueTable[index].wbxmlCodePage != parser->attrCodePage)))
-    {
-        index++;
-    }
-  
-    if (parser->langTable->attrValueTable[index].xmlName == NULL) {
+    if ((entry = wbxml_tables_get_attr_value_from_token(parser->langTable, parser->attrCodePage, tag)) == NULL) {
         return WBXML_ERROR_UNKNOWN_ATTR_VALUE;
     }
 
-    *result = wbxml_buffer_sta_create_from_cstr(parser->langTable->attrValueTable[index].xmlName);
+    *result = wbxml_buffer_sta_create_with_allocator(parser->allocator, entry->xmlName, WBXML_STRLEN(entry->xmlName));
 
     return WBXML_OK;
 }
@@ -2102,11 +3366,11 @@ static WBXMLError parse_termstr(WBXMLParser  *parser,
     max_len = wbxml_buffer_len(parser->wbxml) - parser->pos;
   
     /* Convert to UTF-8 Buffer */
-    if ((ret = wbxml_charset_conv_term((const WB_TINY *) (wbxml_buffer_get_cstr(parser->wbxml) + parser->pos),
-                                       &max_len,
-                                       parser->charset,
-                                       result,
-                                       WBXML_CHARSET_UTF_8)) != WBXML_OK) {
+    if ((ret = wbxml_charset_conv_term_with_allocator(parser->allocator, (const WB_TINY *) (wbxml_buffer_get_cstr(parser->wbxml) + parser->pos),
+                                                      &max_len,
+                                                      parser->charset,
+                                                      result,
+                                                      WBXML_CHARSET_UTF_8)) != WBXML_OK) {
         return ret;
     }
 
@@ -2187,13 +3451,51 @@ static WBXMLError parse_entcode(WBXMLParser *parser,
  * @param index  Index of string in String Table
  * @param result The resulting parsed string
  * @return WBXML_OK if OK, an error code otherwise
+ * @note The resulting Buffer is static: it must be freed, but not modified (cf get_strtbl_slice())
  */
 static WBXMLError get_strtbl_reference(WBXMLParser  *parser,
                                        WB_ULONG      index,
                                        WBXMLBuffer **result)
 {
-    WB_ULONG   max_len = 0;
-    WBXMLError ret     = WBXML_OK;
+    const WB_UTINY *data = NULL;
+    WB_ULONG        len  = 0;
+    WBXMLError      ret  = WBXML_OK;
+
+    if ((ret = get_strtbl_slice(parser, index, &data, &len)) != WBXML_OK)
+        return ret;
+
+    if ((*result = wbxml_buffer_sta_create_with_allocator(parser->allocator, data, len)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    WBXML_DEBUG((WBXML_PARSER, "(%d) String Table Reference: %s", parser->pos, data));
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Get a string from String Table, in UTF-8
+ * @param parser The WBXML Parser
+ * @param index  Index of string in String Table
+ * @param data   [out] The string, NULL terminated (it must not be freed, nor modified)
+ * @param len    [out] The string length
+ * @return WBXML_OK if OK, an error code otherwise
+ * @note In an US-ASCII or UTF-8 Document, the string is given as is in String Table.
+ *       In other charsets, it is converted to UTF-8 the first time it is referenced, and kept
+ *       in 'strtbl_cache' until the end of Document: documents that reference the same strings
+ *       again and again (SyncML LocURIs, namespaces...) only convert them once.
+ */
+static WBXMLError get_strtbl_slice(WBXMLParser     *parser,
+                                   WB_ULONG         index,
+                                   const WB_UTINY **data,
+                                   WB_ULONG        *len)
+{
+    WBXMLBuffer *decoded = NULL;
+    const WB_UTINY *str  = NULL;
+    const WB_UTINY *term = NULL;
+    WB_ULONG     max_len = 0;
+    WB_ULONG     slot    = 0;
+    WBXMLError   ret     = WBXML_OK;
 
     /* WORKAROUND: 2011-Jan-21 Michael Bell
      * WORKAROUND:
@@ -2214,10 +3516,9 @@ static WBXMLError get_strtbl_reference(WBXMLParser  *parser,
         WBXML_DEBUG((WBXML_PARSER, "(%d) Workaround Nokia: NO string table, index 0 => encoded xmlns", parser->pos));
 
         /* UTF-8 xmlns */
-        if ((*result = wbxml_buffer_create_from_cstr("xmlns")) == NULL) {
-            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-        }
-        
+        *data = WBXML_PARSER_NOKIA_XMLNS;
+        *len = WBXML_STRLEN(WBXML_PARSER_NOKIA_XMLNS);
+
         return WBXML_OK;
     }
   
@@ -2231,23 +3532,130 @@ static WBXMLError get_strtbl_reference(WBXMLParser  *parser,
     }
 
     /* Get max possible string length */
+    str = wbxml_buffer_get_cstr(parser->strstbl) + index;
     max_len = wbxml_buffer_len(parser->strstbl) - index;
 
+    /* US-ASCII and UTF-8: nothing to convert */
+    if ((parser->charset == WBXML_CHARSET_US_ASCII) || (parser->charset == WBXML_CHARSET_UTF_8)) {
+        /* NULL terminated (parse_strtbl() terminates the String Table) */
+        if ((term = memchr(str, '\0', max_len)) == NULL)
+            return WBXML_ERROR_CHARSET_STR_LEN;
+
+        *data = str;
+        *len = (WB_ULONG) (term - str);
+
+        return WBXML_OK;
+    }
+
+    /* Already converted ? */
+    if (parser->strtbl_cache != NULL) {
+        slot = WBXML_PARSER_STRTBL_CACHE_SLOT(index, parser->strtbl_cache_size);
+
+        while (parser->strtbl_cache[slot].decoded != NULL) {
+            if (parser->strtbl_cache[slot].index == index) {
+                *data = wbxml_buffer_get_cstr(parser->strtbl_cache[slot].decoded);
+                *len = wbxml_buffer_len(parser->strtbl_cache[slot].decoded);
+
+                return WBXML_OK;
+            }
+
+            slot = (slot + 1) & (parser->strtbl_cache_size - 1);
+        }
+    }
+
     /* Convert to UTF-8 Buffer */
-    if ((ret = wbxml_charset_conv_term((const WB_TINY *) (wbxml_buffer_get_cstr(parser->strstbl) + index),
-                                       &max_len,
-                                       parser->charset,
-                                       result,
-                                       WBXML_CHARSET_UTF_8)) != WBXML_OK) {
+    if ((ret = wbxml_charset_conv_term_with_allocator(parser->allocator, (const WB_TINY *) str,
+                                                      &max_len,
+                                                      parser->charset,
+                                                      &decoded,
+                                                      WBXML_CHARSET_UTF_8)) != WBXML_OK) {
         return ret;
     }
 
-    WBXML_DEBUG((WBXML_PARSER, "(%d) String Table Reference: %s", parser->pos, wbxml_buffer_get_cstr(*result)));
+    if ((ret = cache_strtbl_entry(parser, index, decoded)) != WBXML_OK) {
+        wbxml_buffer_destroy(decoded);
+        return ret;
+    }
+
+    *data = wbxml_buffer_get_cstr(decoded);
+    *len = wbxml_buffer_len(decoded);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Keep a String Table entry converted to UTF-8
+ * @param parser  The WBXML Parser
+ * @param index   Index of string in String Table
+ * @param decoded The converted string (given to Parser if this function succeeds)
+ * @return WBXML_OK if OK, an error code otherwise
+ * @note 'strtbl_cache' is an open addressing hash table (with linear probing), keyed by 'index'.
+ *       It is kept at most half full.
+ */
+static WBXMLError cache_strtbl_entry(WBXMLParser *parser, WB_ULONG index, WBXMLBuffer *decoded)
+{
+    WBXMLStrtblEntry *entries = NULL;
+    WB_ULONG          size    = 0;
+    WB_ULONG          slot    = 0;
+    WB_ULONG          i       = 0;
+
+    if (2 * (parser->strtbl_cache_nb + 1) > parser->strtbl_cache_size) {
+        /* Rehash in a bigger table */
+        size = (parser->strtbl_cache_size == 0) ? WBXML_PARSER_STRTBL_CACHE_MIN_SIZE : 2 * parser->strtbl_cache_size;
+
+        if ((entries = wbxml_mem_malloc(parser->allocator, size * sizeof(WBXMLStrtblEntry))) == NULL)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        memset(entries, 0, size * sizeof(WBXMLStrtblEntry));
+
+        for (i = 0; i < parser->strtbl_cache_size; i++) {
+            if (parser->strtbl_cache[i].decoded == NULL)
+                continue;
+
+            slot = WBXML_PARSER_STRTBL_CACHE_SLOT(parser->strtbl_cache[i].index, size);
+            while (entries[slot].decoded != NULL)
+                slot = (slot + 1) & (size - 1);
+
+            entries[slot] = parser->strtbl_cache[i];
+        }
+
+        wbxml_mem_free(parser->allocator, parser->strtbl_cache);
+        parser->strtbl_cache = entries;
+        parser->strtbl_cache_size = size;
+    }
+
+    slot = WBXML_PARSER_STRTBL_CACHE_SLOT(index, parser->strtbl_cache_size);
+    while (parser->strtbl_cache[slot].decoded != NULL)
+        slot = (slot + 1) & (parser->strtbl_cache_size - 1);
+
+    parser->strtbl_cache[slot].index = index;
+    parser->strtbl_cache[slot].decoded = decoded;
+    parser->strtbl_cache_nb++;
 
     return WBXML_OK;
 }
 
 
+/**
+ * @brief Free String Table entries converted to UTF-8
+ * @param parser The WBXML Parser
+ */
+static void free_strtbl_cache(WBXMLParser *parser)
+{
+    WB_ULONG i = 0;
+
+    for (i = 0; i < parser->strtbl_cache_size; i++)
+        wbxml_buffer_destroy(parser->strtbl_cache[i].decoded);
+
+    wbxml_mem_free(parser->allocator, parser->strtbl_cache);
+
+    parser->strtbl_cache = NULL;
+    parser->strtbl_cache_size = 0;
+    parser->strtbl_cache_nb = 0;
+}
+
+
 /********************************
  *    Basic Types Parse functions
  */
@@ -2331,30 +3739,12 @@ static WBXMLError parse_mb_uint32(WBXMLParser *parser, WB_ULONG *result)
  */
 static WBXMLError decode_base64_value(WBXMLBuffer **data)
 {
-    WB_UTINY   *result = NULL;
-    WBXMLError  ret    = WBXML_OK;
-    
     if ((data == NULL) || (*data == NULL)) {
         return WBXML_ERROR_INTERNAL;
     }
     
-    if ((result = wbxml_base64_encode((const WB_UTINY *) wbxml_buffer_get_cstr(*data),
-                                      wbxml_buffer_len(*data))) == NULL)
-    {
-        return WBXML_ERROR_B64_ENC;
-    }
-    
-    /* Reset buffer */
-    wbxml_buffer_delete(*data, 0, wbxml_buffer_len(*data));
-    
-    /* Set data */
-    if (!wbxml_buffer_append_cstr(*data, result)) {
-        ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
-    
-    wbxml_free(result);
-    
-    return ret;
+    /* Encoded in place */
+    return wbxml_buffer_encode_base64(*data);
 }
 
 
@@ -2442,13 +3832,12 @@ static WBXMLError decode_datetime(WBXMLBuffer *buff)
 
 
 /**
- * @brief Decode an Opaque Content buffer
+ * @brief Check if an Opaque Content is decoded
  * @param parser The WBXML Parser
- * @param data The Opaque data buffer
- * @return WBXML_OK if OK, another error code otherwise
+ * @return TRUE if the Opaque Content of current Tag is decoded by decode_opaque_content(),
+ *         FALSE if it is kept as is
  */
-static WBXMLError decode_opaque_content(WBXMLParser  *parser,
-                                        WBXMLBuffer **data)
+static WB_BOOL is_opaque_content_decoded(WBXMLParser *parser)
 {
     switch (parser->langTable->langID) 
     {
@@ -2457,8 +3846,7 @@ static WBXMLError decode_opaque_content(WBXMLParser  *parser,
 
     case WBXML_LANG_WV_CSP11:
     case WBXML_LANG_WV_CSP12:
-        return decode_wv_content(parser, data);
-        break;
+        return TRUE;
 
 #endif /* WBXML_SUPPORT_WV */
     
@@ -2466,14 +3854,9 @@ static WBXMLError decode_opaque_content(WBXMLParser  *parser,
 
     case WBXML_LANG_DRMREL10:
         /* ds:KeyValue */
-        if ((parser->current_tag) &&
-            (parser->current_tag->wbxmlCodePage == 0x00) &&
-            (parser->current_tag->wbxmlToken == 0x0C))
-        {
-            /* Decode base64 value */ 
-            return decode_base64_value(data);
-        }
-        break;
+        return (WB_BOOL) ((parser->current_tag) &&
+                          (parser->current_tag->wbxmlCodePage == 0x00) &&
+                          (parser->current_tag->wbxmlToken == 0x0C));
 
 #endif /* WBXML_SUPPORT_DRMREL */    
 
@@ -2483,23 +3866,42 @@ static WBXMLError decode_opaque_content(WBXMLParser  *parser,
     case WBXML_LANG_SYNCML_SYNCML11: 
     case WBXML_LANG_SYNCML_SYNCML12: 
         /* NextNonce */
-        if ((parser->current_tag) &&
-            (parser->current_tag->wbxmlCodePage == 0x01) &&
-            (parser->current_tag->wbxmlToken == 0x10)) 
-        {
-            /* Decode base64 value */ 
-            return decode_base64_value(data);
-        }
-        break;
+        return (WB_BOOL) ((parser->current_tag) &&
+                          (parser->current_tag->wbxmlCodePage == 0x01) &&
+                          (parser->current_tag->wbxmlToken == 0x10));
 
 #endif /* WBXML_SUPPORT_SYNCML */    
 
     default:
-        /* NOP */
-        break;
+        return FALSE;
     } /* switch */
-  
-    return WBXML_OK;
+}
+
+
+/**
+ * @brief Decode an Opaque Content buffer
+ * @param parser The WBXML Parser
+ * @param data The Opaque data buffer
+ * @return WBXML_OK if OK, another error code otherwise
+ */
+static WBXMLError decode_opaque_content(WBXMLParser  *parser,
+                                        WBXMLBuffer **data)
+{
+    if (!is_opaque_content_decoded(parser))
+        return WBXML_OK;
+
+#if defined( WBXML_SUPPORT_WV )
+
+    if ((parser->langTable->langID == WBXML_LANG_WV_CSP11) ||
+        (parser->langTable->langID == WBXML_LANG_WV_CSP12))
+    {
+        return decode_wv_content(parser, data);
+    }
+
+#endif /* WBXML_SUPPORT_WV */
+
+    /* Decode base64 value (DRMREL ds:KeyValue, SyncML NextNonce) */
+    return decode_base64_value(data);
 }
 
 
@@ -63,6 +63,15 @@ typedef struct WBXMLParser_s WBXMLParser;
  */
 WBXML_DECLARE(WBXMLParser *) wbxml_parser_create(void);
 
+/**
+ * @brief Create a WBXML Parser with an Allocator
+ * @param allocator The Allocator of the Parser (NULL to use the default one)
+ * @return Return the newly created WBXMLParser, or NULL if not enough memory
+ * @note All the memory of the Parser, and the Tags and Attributes given to callbacks,
+ *       are allocated with this Allocator.
+ */
+WBXML_DECLARE(WBXMLParser *) wbxml_parser_create_with_allocator(WBXMLAllocator *allocator);
+
 /**
  * @brief Destroy a WBXML Parser
  * @param parser The WBXMLParser to destroy
@@ -78,6 +87,53 @@ WBXML_DECLARE(void) wbxml_parser_destroy(WBXMLParser *parser);
  */
 WBXML_DECLARE(WBXMLError) wbxml_parser_parse(WBXMLParser *parser, WB_UTINY *wbxml, WB_ULONG wbxml_len);
 
+/**
+ * @brief Parse a WBXML document without copying it, using User Defined callbacks
+ * @param parser The WBXML Parser to use for parsing
+ * @param wbxml The WBXML document to parse
+ * @param wbxml_len The WBXML document length
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @note Unlike wbxml_parser_parse(), the document is not duplicated: the parser reads
+ *       directly from the caller's memory. This saves a copy of the document (plus
+ *       the parser malloc block) for each parse.
+ * @warning The 'wbxml' memory is borrowed: it MUST stay valid and MUST NOT be modified
+ *          until this function returns. It is never written, nor needs to be NULL
+ *          terminated. Data given to the Content Handler callbacks (UTF-8 and US-ASCII
+ *          strings, or String Table references) can point into 'wbxml': it is only valid
+ *          for the duration of the callback, and MUST NOT be modified by it.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_parser_parse_static(WBXMLParser *parser, const WB_UTINY *wbxml, WB_ULONG wbxml_len);
+
+/**
+ * @brief Parse a WBXML document given by chunks, using User Defined callbacks
+ * @param parser The WBXML Parser to use for parsing
+ * @param chunk The next chunk of WBXML document (can be NULL if 'chunk_len' is 0)
+ * @param chunk_len The chunk length
+ * @param is_final TRUE if this is the last chunk of document
+ * @return Return WBXML_OK if no error, an error code otherwise
+ * @note The first call starts parsing a new document, the call with 'is_final' set ends it.
+ *       Chunks can be cut anywhere, even in the middle of a token. Callbacks are called as soon
+ *       as a chunk completes the tokens they report: the WBXMLEndDocumentHandler callback is only
+ *       called with the last chunk.
+ * @note Only the bytes not parsed yet (the start of a token cut by the chunk end) and the
+ *       String Table are kept between calls: the chunk memory can be reused as soon as this
+ *       function returns.
+ * @note After an error, parsing of this document is over: next call starts a new document.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_parser_feed(WBXMLParser *parser, const WB_UTINY *chunk, WB_ULONG chunk_len, WB_BOOL is_final);
+
+/**
+ * @brief Skip the content of the Element being started
+ * @param parser The WBXML Parser
+ * @note Only to be called from the WBXMLStartElementHandler callback: the content of this Element
+ *       (Elements, Attributes and strings included) is then skipped up to its end. Nothing is created
+ *       nor decoded for it, and no callback is called, but the WBXMLEndElementHandler one of this
+ *       Element. It is the way to only look at some parts of big documents (for example the
+ *       SyncKey of an ActiveSync Sync, but not its ApplicationData).
+ * @note It has no effect on an empty Element
+ */
+WBXML_DECLARE(void) wbxml_parser_skip_element(WBXMLParser *parser);
+
 /**
  * @brief Set User Data for a WBXML Parser
  * @param parser The WBXML Parser
@@ -110,6 +166,26 @@ WBXML_DECLARE(void) wbxml_parser_set_main_table(WBXMLParser *parser, const WBXML
  */
 WBXML_DECLARE(WB_BOOL) wbxml_parser_set_language(WBXMLParser *parser, WBXMLLanguage lang);
 
+/**
+ * @brief Set the maximum nesting depth of Elements
+ * @param parser The WBXML Parser
+ * @param max_depth The maximum number of nested Elements (0: no limit, this is the default)
+ * @note Parsing a Document that is nested deeper fails with WBXML_ERROR_MAX_DEPTH_EXCEEDED
+ */
+WBXML_DECLARE(void) wbxml_parser_set_max_depth(WBXMLParser *parser, WB_ULONG max_depth);
+
+/**
+ * @brief Accept borrowed content in the WBXMLCharactersHandler callback
+ * @param parser The WBXML Parser
+ * @param borrowed TRUE to accept borrowed content (FALSE is the default)
+ * @note A content that needs no decoding is always given as is: a string of an US-ASCII or UTF-8
+ *       Document is a NULL terminated slice of the Document, or of its String Table. With borrowed
+ *       content, an opaque content that is not decoded is also given as is, instead of being copied:
+ *       it is then a slice of the Document that is NOT NULL terminated.
+ * @warning Borrowed content is only valid during the callback, and MUST NOT be modified
+ */
+WBXML_DECLARE(void) wbxml_parser_set_borrowed_content(WBXMLParser *parser, WB_BOOL borrowed);
+
 /**
  * @brief Set additionnal meta-information to help determining the Charset Encoding of the Document to parse
  * @param parser The WBXML Parser
@@ -0,0 +1,1226 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_reader.c
+ * @ingroup wbxml_reader
+ *
+ * @date 26/10/17
+ *
+ * @brief WBXML Reader - Read a WBXML document event by event (pull parsing)
+ *
+ * @note The Reader follows the same grammar as the WBXML Parser (cf wbxml_parser.c), but nothing
+ *       is decoded nor converted: Events point to the Language Tables, or into the document itself.
+ *       The only memory allocated is the stack of open Elements, which is kept from one document
+ *       to another.
+ */
+
+#include "wbxml_reader.h"
+#include "wbxml_log.h"
+#include "wbxml_internals.h"
+#include "wbxml_charset.h"
+
+
+/* Memory management related defines */
+#define WBXML_READER_ELEMENTS_MALLOC_BLOCK 16
+
+/** Default charset of a WBXML document which does not specify it */
+#define WBXML_READER_DEFAULT_CHARSET WBXML_CHARSET_UTF_8
+
+/** For unknown Tag Name or Attribute Name */
+#define WBXML_READER_UNKNOWN_STRING ((const WB_UTINY *)"unknown")
+
+/** Name given to an Attribute that references index 0 of a missing String Table (cf get_strtbl_string()) */
+#define WBXML_READER_XMLNS_STRING ((const WB_UTINY *)"xmlns")
+
+
+/**
+ * @brief The WBXML Application Token types
+ */
+typedef enum WBXMLReaderTokenType_e {
+    WBXML_READER_TAG_TOKEN,        /**< Tag token */
+    WBXML_READER_ATTR_TOKEN        /**< Attribute token */
+} WBXMLReaderTokenType;
+
+/**
+ * @brief The WBXML Reader states (what is read next)
+ */
+typedef enum WBXMLReaderState_e {
+    WBXML_READER_STATE_NONE,        /**< Nothing: no Document is set */
+    WBXML_READER_STATE_HEADER,      /**< Header: version, publicid, charset and strtbl */
+    WBXML_READER_STATE_BODY,        /**< A pi, or the root Element start */
+    WBXML_READER_STATE_ATTRIBUTES,  /**< An Attribute start, or the END of Attributes of last started Element */
+    WBXML_READER_STATE_ATTR_VALUES, /**< A value of current Attribute, if any */
+    WBXML_READER_STATE_PI_VALUES,   /**< A value of current pi, or its END */
+    WBXML_READER_STATE_CONTENT,     /**< An END, an Element start or a content, in innermost open Element */
+    WBXML_READER_STATE_EMPTY_END,   /**< Nothing: the END_ELEMENT of an empty Element */
+    WBXML_READER_STATE_END,         /**< A pi, after root Element */
+    WBXML_READER_STATE_DONE         /**< Nothing: the Document is read */
+} WBXMLReaderState;
+
+/**
+ * @brief An open Element
+ */
+typedef struct WBXMLReaderElement_s {
+    const WBXMLTagEntry *tag;         /**< Tag entry (NULL if literal, or unknown) */
+    const WB_UTINY      *name;        /**< Name */
+    WB_ULONG             name_len;    /**< Name length */
+    WB_BOOL              has_content; /**< FALSE if Element is empty */
+} WBXMLReaderElement;
+
+/**
+ * @brief The WBXML Reader
+ */
+struct WBXMLReader_s {
+    const WB_UTINY       *wbxml;          /**< The wbxml we are reading (borrowed) */
+    WB_ULONG              wbxml_len;      /**< Length of wbxml */
+    WB_ULONG              pos;            /**< Position of reading cursor in wbxml */
+    const WB_UTINY       *strtbl;         /**< String Table specified in WBXML document (in wbxml) */
+    WB_ULONG              strtbl_len;     /**< Length of String Table */
+    const WBXMLLangEntry *langTable;      /**< Current document Language Table */
+    const WBXMLLangEntry *mainTable;      /**< Main WBXML Languages Table */
+
+    WBXMLLanguage         lang_forced;    /**< Language forced by User */
+    WB_ULONG              public_id;      /**< Public ID specified in WBXML document */
+    WB_LONG               public_id_index;/**< If Public ID is a String Table reference,
+                                               this is the index defined in the strtbl */
+    WBXMLCharsetMIBEnum   charset;        /**< Charset of WBXML document */
+    WBXMLCharsetMIBEnum   meta_charset;   /**< Meta-info provided by user: only used if
+                                               Charset is not specified in WBXML document */
+    WBXMLVersion          version;        /**< WBXML Version field specified in WBXML document */
+    WB_UTINY              tagCodePage;    /**< Current Tag Code Page */
+    WB_UTINY              attrCodePage;   /**< Current Attribute Code Page */
+
+    WBXMLReaderElement   *elements;       /**< Stack of open Elements */
+    WB_ULONG              depth;          /**< Number of open Elements */
+    WB_ULONG              elements_size;  /**< Number of allocated Elements in stack */
+    WBXMLReaderState      state;          /**< What is read next */
+    WBXMLReaderState      pi_state;       /**< What is read after current pi */
+    WBXMLError            error;          /**< Error met while reading Document (returned again on next calls) */
+};
+
+
+/***************************************************
+ *    Private Functions prototypes
+ */
+
+static WBXMLError read_event(WBXMLReader *reader, WBXMLReaderEvent *event);
+static WBXMLError read_header(WBXMLReader *reader);
+static WBXMLError check_public_id(WBXMLReader *reader);
+static WBXMLError read_pi(WBXMLReader *reader, WBXMLReaderEvent *event, WBXMLReaderState next_state);
+static WBXMLError read_element_start(WBXMLReader *reader, WBXMLReaderEvent *event);
+static WBXMLError read_element_end(WBXMLReader *reader, WBXMLReaderEvent *event);
+static WBXMLError read_attr_start(WBXMLReader *reader, WBXMLReaderEvent *event);
+static WBXMLError read_value(WBXMLReader *reader, WBXMLReaderTokenType code_space, WBXMLReaderEvent *event);
+static WBXMLError read_extension(WBXMLReader *reader, WBXMLReaderTokenType code_space, WBXMLReaderEvent *event);
+static WBXMLError read_switch_page(WBXMLReader *reader, WBXMLReaderTokenType code_space);
+static WBXMLError read_literal(WBXMLReader *reader, WB_UTINY *mask, const WB_UTINY **name, WB_ULONG *name_len);
+static WBXMLError read_termstr(WBXMLReader *reader, const WB_UTINY **data, WB_ULONG *len);
+static WBXMLError read_uint8(WBXMLReader *reader, WB_UTINY *result);
+static WBXMLError read_mb_uint32(WBXMLReader *reader, WB_ULONG *result);
+static WBXMLError get_strtbl_string(WBXMLReader *reader, WB_ULONG index, const WB_UTINY **data, WB_ULONG *len);
+static WB_ULONG string_len(WBXMLReader *reader, const WB_UTINY *data, WB_ULONG max_len, WB_BOOL *terminated);
+
+static WB_BOOL is_token(WBXMLReader *reader, WB_UTINY token);
+static WB_BOOL is_extension(WBXMLReader *reader);
+static WB_BOOL is_attr_value(WBXMLReader *reader);
+static WB_BOOL is_element(WBXMLReader *reader);
+
+
+/***************************************************
+ *    Public Functions
+ */
+
+WBXML_DECLARE(WBXMLReader *) wbxml_reader_create(void)
+{
+    WBXMLReader *reader = NULL;
+
+    if ((reader = wbxml_malloc(sizeof(WBXMLReader))) == NULL)
+        return NULL;
+
+    reader->mainTable    = wbxml_tables_get_main();
+    reader->lang_forced  = WBXML_LANG_UNKNOWN;
+    reader->meta_charset = WBXML_CHARSET_UNKNOWN;
+
+    reader->elements      = NULL;
+    reader->elements_size = 0;
+
+    wbxml_reader_set_input(reader, NULL, 0);
+
+    return reader;
+}
+
+
+WBXML_DECLARE(void) wbxml_reader_destroy(WBXMLReader *reader)
+{
+    if (reader == NULL)
+        return;
+
+    wbxml_free(reader->elements);
+    wbxml_free(reader);
+}
+
+
+WBXML_DECLARE(void) wbxml_reader_set_main_table(WBXMLReader *reader, const WBXMLLangEntry *main_table)
+{
+    if (reader != NULL)
+        reader->mainTable = main_table;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_reader_set_language(WBXMLReader *reader, WBXMLLanguage lang)
+{
+    if (reader != NULL) {
+        reader->lang_forced = lang;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+WBXML_DECLARE(WB_BOOL) wbxml_reader_set_meta_charset(WBXMLReader *reader, WBXMLCharsetMIBEnum charset)
+{
+    if (reader != NULL) {
+        reader->meta_charset = charset;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_reader_set_input(WBXMLReader *reader, const WB_UTINY *wbxml, WB_ULONG wbxml_len)
+{
+    if (reader == NULL)
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    reader->wbxml           = wbxml;
+    reader->wbxml_len       = wbxml_len;
+    reader->pos             = 0;
+    reader->strtbl          = NULL;
+    reader->strtbl_len      = 0;
+    reader->langTable       = NULL;
+
+    reader->public_id       = WBXML_PUBLIC_ID_UNKNOWN;
+    reader->public_id_index = -1;
+    reader->charset         = WBXML_CHARSET_UNKNOWN;
+    reader->version         = WBXML_VERSION_UNKNOWN;
+    reader->tagCodePage     = 0;
+    reader->attrCodePage    = 0;
+
+    reader->depth           = 0;
+    reader->state           = WBXML_READER_STATE_HEADER;
+    reader->pi_state        = WBXML_READER_STATE_NONE;
+    reader->error           = WBXML_OK;
+
+    if ((wbxml == NULL) || (wbxml_len == 0)) {
+        reader->state = WBXML_READER_STATE_NONE;
+        reader->error = WBXML_ERROR_EMPTY_WBXML;
+    }
+
+    return reader->error;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_reader_next(WBXMLReader *reader, WBXMLReaderEvent *event)
+{
+    if ((reader == NULL) || (event == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    if (reader->error != WBXML_OK)
+        return reader->error;
+
+    memset(event, 0, sizeof(WBXMLReaderEvent));
+
+    if ((reader->error = read_event(reader, event)) != WBXML_OK) {
+        WBXML_ERROR((WBXML_PARSER, "Reader error at byte %d: %s", reader->pos, wbxml_errors_string(reader->error)));
+    }
+
+    return reader->error;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_reader_skip(WBXMLReader *reader)
+{
+    WBXMLReaderEvent event;
+    WBXMLError       ret   = WBXML_OK;
+    WB_ULONG         depth = 0;
+
+    if (reader == NULL)
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    if (reader->error != WBXML_OK)
+        return reader->error;
+
+    /* No open Element */
+    if (reader->depth == 0)
+        return WBXML_OK;
+
+    depth = reader->depth;
+
+    do {
+        if ((ret = wbxml_reader_next(reader, &event)) != WBXML_OK)
+            return ret;
+    } while ((event.type != WBXML_READER_END_ELEMENT) || (event.depth != depth));
+
+    return WBXML_OK;
+}
+
+
+WBXML_DECLARE(const WBXMLLangEntry *) wbxml_reader_get_lang_table(WBXMLReader *reader)
+{
+    if (reader != NULL)
+        return reader->langTable;
+    else
+        return NULL;
+}
+
+
+WBXML_DECLARE(WBXMLCharsetMIBEnum) wbxml_reader_get_charset(WBXMLReader *reader)
+{
+    if (reader != NULL)
+        return reader->charset;
+    else
+        return WBXML_CHARSET_UNKNOWN;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_reader_get_current_byte_index(WBXMLReader *reader)
+{
+    if (reader != NULL)
+        return reader->pos;
+    else
+        return 0;
+}
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Read next Event
+ * @param reader The WBXML Reader
+ * @param event [out] The Event read (zeroed by caller)
+ * @return WBXML_OK if an Event is read, an error code otherwise
+ * @note The reader state tells what is read next. States that read nothing but a token
+ *       (END of Attributes, switchPage in content...) go on to the next state.
+ */
+static WBXMLError read_event(WBXMLReader *reader, WBXMLReaderEvent *event)
+{
+    WBXMLError ret = WBXML_OK;
+
+    for (;;) {
+        switch (reader->state) {
+        case WBXML_READER_STATE_HEADER:
+            if ((ret = read_header(reader)) != WBXML_OK)
+                return ret;
+
+            reader->state = WBXML_READER_STATE_BODY;
+            event->type = WBXML_READER_START_DOCUMENT;
+            return WBXML_OK;
+
+        case WBXML_READER_STATE_BODY:
+            /* *pi */
+            if (is_token(reader, WBXML_PI))
+                return read_pi(reader, event, WBXML_READER_STATE_BODY);
+
+            /* Root Element start */
+            return read_element_start(reader, event);
+
+        case WBXML_READER_STATE_ATTRIBUTES:
+            if (reader->pos >= reader->wbxml_len)
+                return WBXML_ERROR_END_OF_BUFFER;
+
+            if (is_token(reader, WBXML_END)) {
+                /* Skip END */
+                reader->pos++;
+
+                if (reader->elements[reader->depth - 1].has_content)
+                    reader->state = WBXML_READER_STATE_CONTENT;
+                else
+                    reader->state = WBXML_READER_STATE_EMPTY_END;
+
+                continue;
+            }
+
+            return read_attr_start(reader, event);
+
+        case WBXML_READER_STATE_ATTR_VALUES:
+            if (!is_attr_value(reader)) {
+                reader->state = WBXML_READER_STATE_ATTRIBUTES;
+                continue;
+            }
+
+            event->type = WBXML_READER_VALUE;
+            return read_value(reader, WBXML_READER_ATTR_TOKEN, event);
+
+        case WBXML_READER_STATE_PI_VALUES:
+            if (reader->pos >= reader->wbxml_len)
+                return WBXML_ERROR_END_OF_BUFFER;
+
+            if (is_token(reader, WBXML_END)) {
+                /* Skip END */
+                reader->pos++;
+
+                reader->state = reader->pi_state;
+                continue;
+            }
+
+            event->type = WBXML_READER_VALUE;
+            return read_value(reader, WBXML_READER_ATTR_TOKEN, event);
+
+        case WBXML_READER_STATE_CONTENT:
+            if (reader->pos >= reader->wbxml_len)
+                return WBXML_ERROR_END_OF_BUFFER;
+
+            if (is_token(reader, WBXML_END)) {
+                /* Skip END */
+                reader->pos++;
+
+                return read_element_end(reader, event);
+            }
+
+            if (is_element(reader))
+                return read_element_start(reader, event);
+
+            if (is_token(reader, WBXML_PI))
+                return read_pi(reader, event, WBXML_READER_STATE_CONTENT);
+
+            /* switchPage (cf parse_content(): may be found in wrong places) */
+            if (is_token(reader, WBXML_SWITCH_PAGE) && !is_extension(reader)) {
+                if ((ret = read_switch_page(reader, WBXML_READER_TAG_TOKEN)) != WBXML_OK)
+                    return ret;
+
+                continue;
+            }
+
+            event->type = WBXML_READER_CONTENT;
+            return read_value(reader, WBXML_READER_TAG_TOKEN, event);
+
+        case WBXML_READER_STATE_EMPTY_END:
+            return read_element_end(reader, event);
+
+        case WBXML_READER_STATE_END:
+            /* *pi */
+            if (is_token(reader, WBXML_PI))
+                return read_pi(reader, event, WBXML_READER_STATE_END);
+
+            reader->state = WBXML_READER_STATE_DONE;
+            continue;
+
+        case WBXML_READER_STATE_DONE:
+            event->type = WBXML_READER_END_DOCUMENT;
+            return WBXML_OK;
+
+        default:
+            return WBXML_ERROR_INTERNAL;
+        }
+    }
+}
+
+
+/**
+ * @brief Read WBXML header
+ * @param reader The WBXML Reader
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note header = version publicid charset strtbl
+ * @note publicid = mb_u_int32 | ( zero index )
+ * @note strtbl = length *byte
+ */
+static WBXMLError read_header(WBXMLReader *reader)
+{
+    const char *charset_name = NULL;
+    WB_UTINY    version      = WBXML_VERSION_10;
+    WB_ULONG    index        = 0;
+    WB_ULONG    charset      = 0;
+    WBXMLError  ret          = WBXML_OK;
+
+    /* WBXML Version */
+    if ((ret = read_uint8(reader, &version)) != WBXML_OK)
+        return ret;
+
+    reader->version = (WBXMLVersion) version;
+
+    /* WBXML Public ID */
+    if (is_token(reader, 0x00)) {
+        reader->pos++;
+
+        /* Index of Public ID in String Table */
+        if ((ret = read_mb_uint32(reader, &index)) != WBXML_OK)
+            return ret;
+
+        reader->public_id_index = (WB_LONG) index;
+    }
+    else {
+        if ((ret = read_mb_uint32(reader, &reader->public_id)) != WBXML_OK)
+            return ret;
+    }
+
+    /* Ignore Document Public ID if user has forced use of another Public ID */
+    if (reader->lang_forced != WBXML_LANG_UNKNOWN)
+        reader->public_id = wbxml_tables_get_wbxml_publicid(wbxml_tables_get_main(), reader->lang_forced);
+
+    /* WBXML Charset (none in WBXML 1.0) */
+    if (reader->version != WBXML_VERSION_10) {
+        if ((ret = read_mb_uint32(reader, &charset)) != WBXML_OK)
+            return ret;
+
+        if (charset == 0) {
+            if (reader->meta_charset != WBXML_CHARSET_UNKNOWN)
+                charset = reader->meta_charset;
+            else
+                charset = WBXML_CHARSET_UTF_8;
+        }
+
+        if (!wbxml_charset_get_name((WBXMLCharsetMIBEnum) charset, &charset_name))
+            return WBXML_ERROR_CHARSET_NOT_FOUND;
+
+        reader->charset = (WBXMLCharsetMIBEnum) charset;
+    }
+    else {
+        if (reader->meta_charset != WBXML_CHARSET_UNKNOWN)
+            reader->charset = reader->meta_charset;
+        else
+            reader->charset = WBXML_READER_DEFAULT_CHARSET;
+    }
+
+    /* WBXML String Table */
+    if (read_mb_uint32(reader, &reader->strtbl_len) != WBXML_OK)
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    if (reader->strtbl_len > 0) {
+        if (reader->strtbl_len > reader->wbxml_len - reader->pos)
+            return WBXML_ERROR_STRTBL_LENGTH;
+
+        reader->strtbl = reader->wbxml + reader->pos;
+        reader->pos += reader->strtbl_len;
+    }
+
+    /* Now that we have read String Table, we can check Public ID */
+    return check_public_id(reader);
+}
+
+
+/**
+ * @brief Check the Public ID, and set the Language Table
+ * @param reader The WBXML Reader
+ * @return WBXML_OK if Public ID is found, WBXML_ERROR_UNKNOWN_PUBLIC_ID otherwise
+ * @note Same search as the WBXML Parser: forced Language, then Public ID token,
+ *       then Public ID referenced in String Table
+ */
+static WBXMLError check_public_id(WBXMLReader *reader)
+{
+    const WB_UTINY *public_id = NULL;
+    WB_ULONG        len       = 0;
+    WB_ULONG        index     = 0;
+
+    if (reader->mainTable == NULL)
+        return WBXML_ERROR_LANG_TABLE_UNDEFINED;
+
+    /* Case 1: Language is forced by user */
+    if (reader->lang_forced != WBXML_LANG_UNKNOWN) {
+        for (index = 0; reader->mainTable[index].langID != WBXML_LANG_UNKNOWN; index++) {
+            if (reader->mainTable[index].langID == reader->lang_forced) {
+                reader->langTable = &(reader->mainTable[index]);
+                return WBXML_OK;
+            }
+        }
+    }
+
+    /* Case 2: Public ID is a normal token */
+    if (reader->public_id != WBXML_PUBLIC_ID_UNKNOWN) {
+        for (index = 0; reader->mainTable[index].publicID != NULL; index++) {
+            if (reader->mainTable[index].publicID->wbxmlPublicID == reader->public_id) {
+                reader->langTable = &(reader->mainTable[index]);
+                return WBXML_OK;
+            }
+        }
+    }
+
+    /* Case 3: Public ID referenced in String Table */
+    if ((reader->public_id_index != -1) &&
+        (get_strtbl_string(reader, (WB_ULONG) reader->public_id_index, &public_id, &len) == WBXML_OK))
+    {
+        for (index = 0; reader->mainTable[index].publicID != NULL; index++) {
+            if ((reader->mainTable[index].publicID->xmlPublicID != NULL) &&
+                (WBXML_STRLEN(reader->mainTable[index].publicID->xmlPublicID) == len) &&
+                (WBXML_STRNCASECMP(reader->mainTable[index].publicID->xmlPublicID, public_id, len) == 0))
+            {
+                reader->langTable = &(reader->mainTable[index]);
+                return WBXML_OK;
+            }
+        }
+    }
+
+    WBXML_ERROR((WBXML_PARSER, "PublicID not found"));
+    return WBXML_ERROR_UNKNOWN_PUBLIC_ID;
+}
+
+
+/**
+ * @brief Read the start of a WBXML pi
+ * @param reader The WBXML Reader
+ * @param event [out] The PI Event
+ * @param next_state The state to go back to after this pi
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note pi = PI attrStart *attrValue END
+ * @note The attrValues and END are read in WBXML_READER_STATE_PI_VALUES state
+ */
+static WBXMLError read_pi(WBXMLReader *reader, WBXMLReaderEvent *event, WBXMLReaderState next_state)
+{
+    WBXMLError ret = WBXML_OK;
+
+    /* Skip PI */
+    reader->pos++;
+
+    if ((ret = read_attr_start(reader, event)) != WBXML_OK)
+        return ret;
+
+    event->type = WBXML_READER_PI;
+
+    reader->pi_state = next_state;
+    reader->state = WBXML_READER_STATE_PI_VALUES;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read the start of a WBXML element
+ * @param reader The WBXML Reader
+ * @param event [out] The START_ELEMENT Event
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note ([switchPage] stag) [ 1*attribute END ]
+ * @note stag = TAG | (literalTag index)
+ * @note The Element is pushed on the stack of open Elements (even if empty: it is popped by its END_ELEMENT)
+ */
+static WBXMLError read_element_start(WBXMLReader *reader, WBXMLReaderEvent *event)
+{
+    WBXMLReaderElement *elements = NULL;
+    WBXMLReaderElement *element  = NULL;
+    WB_UTINY            tag      = 0;
+    WBXMLError          ret      = WBXML_OK;
+
+    /* Make room for this Element */
+    if (reader->depth == reader->elements_size) {
+        if ((elements = wbxml_realloc(reader->elements,
+                                      (reader->elements_size + WBXML_READER_ELEMENTS_MALLOC_BLOCK) * sizeof(*elements))) == NULL)
+        {
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        reader->elements = elements;
+        reader->elements_size += WBXML_READER_ELEMENTS_MALLOC_BLOCK;
+    }
+
+    element = &reader->elements[reader->depth];
+
+    if (is_token(reader, WBXML_SWITCH_PAGE)) {
+        if ((ret = read_switch_page(reader, WBXML_READER_TAG_TOKEN)) != WBXML_OK)
+            return ret;
+    }
+
+    if (is_token(reader, WBXML_LITERAL) || is_token(reader, WBXML_LITERAL_A) ||
+        is_token(reader, WBXML_LITERAL_C) || is_token(reader, WBXML_LITERAL_AC))
+    {
+        /* (literalTag index) */
+        if ((ret = read_literal(reader, &tag, &element->name, &element->name_len)) != WBXML_OK)
+            return ret;
+
+        element->tag = NULL;
+    }
+    else {
+        /* TAG */
+        if ((ret = read_uint8(reader, &tag)) != WBXML_OK)
+            return ret;
+
+        if (reader->langTable->tagTable == NULL)
+            return WBXML_ERROR_TAG_TABLE_UNDEFINED;
+
+        if ((element->tag = wbxml_tables_get_tag_from_token(reader->langTable,
+                                                            reader->tagCodePage,
+                                                            (WB_UTINY) (tag & WBXML_TOKEN_MASK))) != NULL)
+        {
+            element->name = (const WB_UTINY *) element->tag->xmlName;
+            element->name_len = WBXML_STRLEN(element->tag->xmlName);
+        }
+        else {
+            element->name = WBXML_READER_UNKNOWN_STRING;
+            element->name_len = WBXML_STRLEN(WBXML_READER_UNKNOWN_STRING);
+        }
+    }
+
+    element->has_content = (WB_BOOL) ((tag & WBXML_TOKEN_WITH_CONTENT) == WBXML_TOKEN_WITH_CONTENT);
+    reader->depth++;
+
+    if (tag & WBXML_TOKEN_WITH_ATTRS)
+        reader->state = WBXML_READER_STATE_ATTRIBUTES;
+    else if (element->has_content)
+        reader->state = WBXML_READER_STATE_CONTENT;
+    else
+        reader->state = WBXML_READER_STATE_EMPTY_END;
+
+    event->type        = WBXML_READER_START_ELEMENT;
+    event->depth       = reader->depth;
+    event->tag         = element->tag;
+    event->name        = element->name;
+    event->name_len    = element->name_len;
+    event->has_content = element->has_content;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief End the innermost open Element
+ * @param reader The WBXML Reader
+ * @param event [out] The END_ELEMENT Event
+ * @return WBXML_OK
+ */
+static WBXMLError read_element_end(WBXMLReader *reader, WBXMLReaderEvent *event)
+{
+    WBXMLReaderElement *element = &reader->elements[reader->depth - 1];
+
+    event->type        = WBXML_READER_END_ELEMENT;
+    event->depth       = reader->depth;
+    event->tag         = element->tag;
+    event->name        = element->name;
+    event->name_len    = element->name_len;
+    event->has_content = element->has_content;
+
+    /* All Elements are closed */
+    if (--reader->depth == 0)
+        reader->state = WBXML_READER_STATE_END;
+    else
+        reader->state = WBXML_READER_STATE_CONTENT;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read WBXML attrStart
+ * @param reader The WBXML Reader
+ * @param event [out] The ATTRIBUTE Event
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note attrStart = ([switchPage] ATTRSTART) | ( LITERAL index )
+ * @note The attrValues are read in WBXML_READER_STATE_ATTR_VALUES state
+ */
+static WBXMLError read_attr_start(WBXMLReader *reader, WBXMLReaderEvent *event)
+{
+    WB_UTINY   token = 0;
+    WBXMLError ret   = WBXML_OK;
+
+    event->type  = WBXML_READER_ATTRIBUTE;
+    event->depth = reader->depth;
+
+    reader->state = WBXML_READER_STATE_ATTR_VALUES;
+
+    /* ( LITERAL index ) */
+    if (is_token(reader, WBXML_LITERAL))
+        return read_literal(reader, &token, &event->name, &event->name_len);
+
+    /* ( [switchPage] ATTRSTART ) */
+    if (is_token(reader, WBXML_SWITCH_PAGE)) {
+        if ((ret = read_switch_page(reader, WBXML_READER_ATTR_TOKEN)) != WBXML_OK)
+            return ret;
+    }
+
+    if ((ret = read_uint8(reader, &token)) != WBXML_OK)
+        return ret;
+
+    if (reader->langTable->attrTable == NULL)
+        return WBXML_ERROR_ATTR_TABLE_UNDEFINED;
+
+    if ((event->attr = wbxml_tables_get_attr_from_token(reader->langTable, reader->attrCodePage, token)) == NULL) {
+        event->name = WBXML_READER_UNKNOWN_STRING;
+        event->name_len = WBXML_STRLEN(WBXML_READER_UNKNOWN_STRING);
+        return WBXML_OK;
+    }
+
+    event->name = (const WB_UTINY *) event->attr->xmlName;
+    event->name_len = WBXML_STRLEN(event->attr->xmlName);
+
+    /* Attribute start value */
+    if (event->attr->xmlValue != NULL) {
+        event->value_type = WBXML_READER_VALUE_STRING;
+        event->data = (const WB_UTINY *) event->attr->xmlValue;
+        event->len = WBXML_STRLEN(event->attr->xmlValue);
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read a WBXML attrValue, or a content which is not an Element
+ * @param reader The WBXML Reader
+ * @param code_space WBXML_READER_ATTR_TOKEN for an attrValue, WBXML_READER_TAG_TOKEN for a content
+ * @param event [out] The Event which value is read
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note attrValue = ([switchPage] ATTRVALUE) | string | extension | entity | opaque
+ * @note content = string | extension | entity | opaque (Elements and pi are read by caller)
+ */
+static WBXMLError read_value(WBXMLReader *reader, WBXMLReaderTokenType code_space, WBXMLReaderEvent *event)
+{
+    const WBXMLAttrValueEntry *entry = NULL;
+    WB_ULONG   index = 0;
+    WB_UTINY   token = 0;
+    WBXMLError ret   = WBXML_OK;
+
+    event->depth = reader->depth;
+
+    /* extension */
+    if (is_extension(reader))
+        return read_extension(reader, code_space, event);
+
+    /* entity = ENTITY entcode */
+    if (is_token(reader, WBXML_ENTITY)) {
+        reader->pos++;
+
+        event->value_type = WBXML_READER_VALUE_ENTITY;
+        return read_mb_uint32(reader, &event->code);
+    }
+
+    /* inline = STR_I termstr */
+    if (is_token(reader, WBXML_STR_I)) {
+        reader->pos++;
+
+        event->value_type = WBXML_READER_VALUE_STRING;
+        return read_termstr(reader, &event->data, &event->len);
+    }
+
+    /* tableref = STR_T index */
+    if (is_token(reader, WBXML_STR_T)) {
+        reader->pos++;
+
+        if ((ret = read_mb_uint32(reader, &index)) != WBXML_OK)
+            return ret;
+
+        event->value_type = WBXML_READER_VALUE_STRING;
+        return get_strtbl_string(reader, index, &event->data, &event->len);
+    }
+
+    /* opaque = OPAQUE length *byte */
+    if (is_token(reader, WBXML_OPAQUE)) {
+        reader->pos++;
+
+        if ((ret = read_mb_uint32(reader, &event->len)) != WBXML_OK)
+            return ret;
+
+        if (event->len > reader->wbxml_len - reader->pos)
+            return WBXML_ERROR_BAD_OPAQUE_LENGTH;
+
+        event->value_type = WBXML_READER_VALUE_OPAQUE;
+        event->data = reader->wbxml + reader->pos;
+        reader->pos += event->len;
+
+        return WBXML_OK;
+    }
+
+    /* Element, pi or END: read by caller */
+    if (code_space != WBXML_READER_ATTR_TOKEN)
+        return WBXML_ERROR_INTERNAL;
+
+    /* ([switchPage] ATTRVALUE) */
+    if (is_token(reader, WBXML_SWITCH_PAGE)) {
+        if ((ret = read_switch_page(reader, WBXML_READER_ATTR_TOKEN)) != WBXML_OK)
+            return ret;
+    }
+
+    if ((ret = read_uint8(reader, &token)) != WBXML_OK)
+        return ret;
+
+    if (reader->langTable->attrValueTable == NULL)
+        return WBXML_ERROR_ATTR_VALUE_TABLE_UNDEFINED;
+
+    if ((entry = wbxml_tables_get_attr_value_from_token(reader->langTable, reader->attrCodePage, token)) == NULL)
+        return WBXML_ERROR_UNKNOWN_ATTR_VALUE;
+
+    event->value_type = WBXML_READER_VALUE_STRING;
+    event->data = (const WB_UTINY *) entry->xmlName;
+    event->len = WBXML_STRLEN(entry->xmlName);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read WBXML extension
+ * @param reader The WBXML Reader
+ * @param code_space The token code space
+ * @param event [out] The Event which value is read
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note extension = [switchPage] (( EXT_I termstr ) | ( EXT_T index ) | EXT)
+ * @note Its meaning depends on Language (WML variable, Wireless Village extension value...),
+ *       so the token and its raw value are given as is.
+ */
+static WBXMLError read_extension(WBXMLReader *reader, WBXMLReaderTokenType code_space, WBXMLReaderEvent *event)
+{
+    WBXMLError ret = WBXML_OK;
+
+    if (is_token(reader, WBXML_SWITCH_PAGE)) {
+        if ((ret = read_switch_page(reader, code_space)) != WBXML_OK)
+            return ret;
+    }
+
+    if ((ret = read_uint8(reader, &event->token)) != WBXML_OK)
+        return ret;
+
+    event->value_type = WBXML_READER_VALUE_EXTENSION;
+
+    switch (event->token) {
+    case WBXML_EXT_I_0:
+    case WBXML_EXT_I_1:
+    case WBXML_EXT_I_2:
+        return read_termstr(reader, &event->data, &event->len);
+
+    case WBXML_EXT_T_0:
+    case WBXML_EXT_T_1:
+    case WBXML_EXT_T_2:
+        return read_mb_uint32(reader, &event->code);
+
+    default:
+        return WBXML_OK;
+    }
+}
+
+
+/**
+ * @brief Read WBXML switchPage
+ * @param reader The WBXML Reader
+ * @param code_space The token code space
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note switchPage = SWITCH_PAGE pageindex
+ */
+static WBXMLError read_switch_page(WBXMLReader *reader, WBXMLReaderTokenType code_space)
+{
+    /* Skip SWITCH_PAGE token */
+    reader->pos++;
+
+    if (code_space == WBXML_READER_TAG_TOKEN)
+        return read_uint8(reader, &reader->tagCodePage);
+    else
+        return read_uint8(reader, &reader->attrCodePage);
+}
+
+
+/**
+ * @brief Read WBXML literalTag
+ * @param reader The WBXML Reader
+ * @param mask [out] Resulting tag mask (as for a TAG token)
+ * @param name [out] The literal name, in String Table
+ * @param name_len [out] The literal name length
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note ( literalTag index )
+ *       literalTag = LITERAL | LITERAL_A | LITERAL_C | LITERAL_AC
+ */
+static WBXMLError read_literal(WBXMLReader *reader, WB_UTINY *mask, const WB_UTINY **name, WB_ULONG *name_len)
+{
+    WB_UTINY   token = 0;
+    WB_ULONG   index = 0;
+    WBXMLError ret   = WBXML_OK;
+
+    if ((ret = read_uint8(reader, &token)) != WBXML_OK)
+        return ret;
+
+    if ((ret = read_mb_uint32(reader, &index)) != WBXML_OK)
+        return ret;
+
+    if ((ret = get_strtbl_string(reader, index, name, name_len)) != WBXML_OK)
+        return ret;
+
+    switch (token) {
+    case WBXML_LITERAL:
+        *mask = WBXML_TOKEN_MASK;
+        break;
+
+    case WBXML_LITERAL_C:
+        *mask = WBXML_TOKEN_WITH_CONTENT;
+        break;
+
+    case WBXML_LITERAL_A:
+        *mask = WBXML_TOKEN_WITH_ATTRS;
+        break;
+
+    case WBXML_LITERAL_AC:
+        *mask = (WBXML_TOKEN_WITH_CONTENT | WBXML_TOKEN_WITH_ATTRS);
+        break;
+
+    default:
+        return WBXML_ERROR_INTERNAL;
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read WBXML termstr
+ * @param reader The WBXML Reader
+ * @param data [out] The string, in wbxml
+ * @param len [out] The string length (without terminator)
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note termstr = charset-dependent string with termination
+ */
+static WBXMLError read_termstr(WBXMLReader *reader, const WB_UTINY **data, WB_ULONG *len)
+{
+    WB_BOOL terminated = FALSE;
+
+    *data = reader->wbxml + reader->pos;
+    *len = string_len(reader, *data, reader->wbxml_len - reader->pos, &terminated);
+
+    if (!terminated)
+        return WBXML_ERROR_CHARSET_STR_LEN;
+
+    /* Skip string and its terminator */
+    if ((reader->charset == WBXML_CHARSET_ISO_10646_UCS_2) || (reader->charset == WBXML_CHARSET_UTF_16))
+        reader->pos += *len + 2;
+    else
+        reader->pos += *len + 1;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read UINT8
+ * @param reader The WBXML Reader
+ * @param result [out] Read UINT8
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ */
+static WBXMLError read_uint8(WBXMLReader *reader, WB_UTINY *result)
+{
+    if (reader->pos >= reader->wbxml_len)
+        return WBXML_ERROR_END_OF_BUFFER;
+
+    *result = reader->wbxml[reader->pos++];
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Read a MultiByte UINT32
+ * @param reader The WBXML Reader
+ * @param result [out] The read MultiByte
+ * @return WBXML_OK if reading is OK, an error code otherwise
+ * @note mb_u_int32 = 32 bit unsigned integer, encoded in multi-byte format
+ */
+static WBXMLError read_mb_uint32(WBXMLReader *reader, WB_ULONG *result)
+{
+    WB_ULONG uint = 0, byte_pos;
+    WB_UTINY cur_byte;
+
+    /* It's a 32bit integer, and so it fits to a maximum of 4 bytes */
+    for (byte_pos = 0; byte_pos < 5; byte_pos++) {
+        if (reader->pos >= reader->wbxml_len)
+            return WBXML_ERROR_END_OF_BUFFER;
+
+        cur_byte = reader->wbxml[reader->pos++];
+
+        uint = (uint << 7) | (cur_byte & 0x7F);
+
+        if (!(cur_byte & 0x80)) {
+            *result = uint;
+            return WBXML_OK;
+        }
+    }
+
+    return WBXML_ERROR_UNVALID_MBUINT32;
+}
+
+
+/**
+ * @brief Get a string from String Table
+ * @param reader The WBXML Reader
+ * @param index Index of string in String Table
+ * @param data [out] The string, in String Table
+ * @param len [out] The string length (without terminator)
+ * @return WBXML_OK if OK, an error code otherwise
+ * @note A last string not terminated in String Table ends with it (as with the WBXML Parser)
+ * @note Nokia workaround: index 0 without String Table is "xmlns" (cf get_strtbl_reference() in wbxml_parser.c)
+ */
+static WBXMLError get_strtbl_string(WBXMLReader *reader, WB_ULONG index, const WB_UTINY **data, WB_ULONG *len)
+{
+    WB_BOOL terminated = FALSE;
+
+    if ((reader->strtbl == NULL) && (index == 0)) {
+        *data = WBXML_READER_XMLNS_STRING;
+        *len = WBXML_STRLEN(WBXML_READER_XMLNS_STRING);
+        return WBXML_OK;
+    }
+
+    if (reader->strtbl == NULL)
+        return WBXML_ERROR_NULL_STRING_TABLE;
+
+    if (index >= reader->strtbl_len)
+        return WBXML_ERROR_INVALID_STRTBL_INDEX;
+
+    *data = reader->strtbl + index;
+    *len = string_len(reader, *data, reader->strtbl_len - index, &terminated);
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Get the length of a string, in document charset
+ * @param reader The WBXML Reader
+ * @param data The string
+ * @param max_len The maximum string length
+ * @param terminated [out] TRUE if the string terminator is found before 'max_len'
+ * @return The string length, without terminator ('max_len' if not terminated)
+ */
+static WB_ULONG string_len(WBXMLReader *reader, const WB_UTINY *data, WB_ULONG max_len, WB_BOOL *terminated)
+{
+    const WB_UTINY *term = NULL;
+    WB_ULONG        len  = 0;
+
+    switch (reader->charset) {
+    case WBXML_CHARSET_ISO_10646_UCS_2:
+    case WBXML_CHARSET_UTF_16:
+        /* Terminated by two NULL char ("\0\0"), cf wbxml_charset_conv_term() */
+        for (len = 0; len + 2 <= max_len; len += 2) {
+            if ((data[len] == '\0') && (data[len + 1] == '\0')) {
+                *terminated = TRUE;
+                return len;
+            }
+        }
+        break;
+
+    default:
+        /* Terminated by a simple NULL char ('\0') */
+        if ((term = memchr(data, '\0', max_len)) != NULL) {
+            *terminated = TRUE;
+            return (WB_ULONG) (term - data);
+        }
+        break;
+    }
+
+    *terminated = FALSE;
+    return max_len;
+}
+
+
+/******************
+ * Check functions
+ */
+
+/**
+ * @brief Check if current byte a specified WBXML token
+ * @param reader The WBXML Reader
+ * @param token The WBXML token
+ * @return TRUE is current byte is the specified token, FALSE otherwise
+ */
+static WB_BOOL is_token(WBXMLReader *reader, WB_UTINY token)
+{
+    return (WB_BOOL) ((reader->pos < reader->wbxml_len) && (reader->wbxml[reader->pos] == token));
+}
+
+
+/**
+ * @brief Check if current byte is an extension
+ * @param reader The WBXML Reader
+ * @return TRUE if current byte is an extension, FALSE otherwise
+ */
+static WB_BOOL is_extension(WBXMLReader *reader)
+{
+    WB_ULONG pos = reader->pos;
+    WB_UTINY cur_byte;
+
+    /* If current byte is a switch page, check the following token */
+    if (is_token(reader, WBXML_SWITCH_PAGE))
+        pos += 2;
+
+    if (pos >= reader->wbxml_len)
+        return FALSE;
+
+    cur_byte = reader->wbxml[pos];
+
+    return (WB_BOOL) ((cur_byte == WBXML_EXT_I_0) || (cur_byte == WBXML_EXT_I_1) || (cur_byte == WBXML_EXT_I_2) ||
+            (cur_byte == WBXML_EXT_T_0) || (cur_byte == WBXML_EXT_T_1) || (cur_byte == WBXML_EXT_T_2) ||
+            (cur_byte == WBXML_EXT_0)   || (cur_byte == WBXML_EXT_1)   || (cur_byte == WBXML_EXT_2));
+}
+
+
+/**
+ * @brief Check if next token to read is an Attribute Value
+ * @param reader The WBXML Reader
+ * @return TRUE if next token to read is an Attribute Value, FALSE otherwise
+ * @note attrValue    = ([switchPage] ATTRVALUE | string | extension | entity | opaque)
+ */
+static WB_BOOL is_attr_value(WBXMLReader *reader)
+{
+    WB_UTINY cur_byte;
+
+    if (reader->pos >= reader->wbxml_len)
+        return FALSE;
+
+    cur_byte = reader->wbxml[reader->pos];
+
+    /* If current byte is a switch page, check that following token is an Attribute Value token */
+    if ((cur_byte == WBXML_SWITCH_PAGE) &&
+        (reader->pos + 2 < reader->wbxml_len) &&
+        ((reader->wbxml[reader->pos + 2] & 0x80) == 0x80))
+    {
+        return TRUE;
+    }
+
+    return (WB_BOOL) (((cur_byte & 0x80) == 0x80) ||
+                      (cur_byte == WBXML_STR_I) ||
+                      (cur_byte == WBXML_ENTITY) ||
+                      (cur_byte == WBXML_OPAQUE) ||
+                      is_extension(reader));
+}
+
+
+/**
+ * @brief Check if current byte starts an Element, in Content
+ * @param reader The WBXML Reader
+ * @return TRUE if current byte starts an Element, FALSE otherwise
+ * @note In Content, anything that is not END, string, extension, entity, pi, opaque or switchPage
+ *       is an Element
+ */
+static WB_BOOL is_element(WBXMLReader *reader)
+{
+    WB_UTINY cur_byte;
+
+    if (reader->pos >= reader->wbxml_len)
+        return FALSE;
+
+    cur_byte = reader->wbxml[reader->pos];
+
+    return (WB_BOOL) !((cur_byte == WBXML_END) ||
+                       (cur_byte == WBXML_ENTITY) ||
+                       (cur_byte == WBXML_OPAQUE) ||
+                       (cur_byte == WBXML_PI) ||
+                       (cur_byte == WBXML_SWITCH_PAGE) ||
+                       (cur_byte == WBXML_STR_I) ||
+                       (cur_byte == WBXML_STR_T) ||
+                       is_extension(reader));
+}
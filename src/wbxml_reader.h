@@ -0,0 +1,197 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_reader.h
+ * @ingroup wbxml_reader
+ *
+ * @date 26/10/17
+ *
+ * @brief WBXML Reader - Read a WBXML document event by event (pull parsing)
+ */
+
+#ifndef WBXML_READER_H
+#define WBXML_READER_H
+
+#include "wbxml.h"
+#include "wbxml_tables.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wbxml_reader
+ *  @{
+ */
+
+typedef struct WBXMLReader_s WBXMLReader;
+
+/**
+ * @brief WBXML Reader Event types
+ */
+typedef enum WBXMLReaderEventType_e {
+    WBXML_READER_START_DOCUMENT = 0, /**< Header is read: Language and Charset are known */
+    WBXML_READER_END_DOCUMENT,       /**< Document is read (this event is then returned again) */
+    WBXML_READER_START_ELEMENT,      /**< Start of an Element: 'tag', 'name', 'has_content' */
+    WBXML_READER_END_ELEMENT,        /**< End of an Element: 'tag', 'name' */
+    WBXML_READER_ATTRIBUTE,          /**< Attribute of last started Element: 'attr', 'name', and start of value */
+    WBXML_READER_PI,                 /**< Processing Instruction: 'attr', 'name', and start of value */
+    WBXML_READER_VALUE,              /**< Part of the value of last ATTRIBUTE or PI */
+    WBXML_READER_CONTENT             /**< Content of current Element */
+} WBXMLReaderEventType;
+
+/**
+ * @brief WBXML Reader Value types
+ */
+typedef enum WBXMLReaderValueType_e {
+    WBXML_READER_VALUE_NONE = 0,     /**< No value */
+    WBXML_READER_VALUE_STRING,       /**< 'data' and 'len': a string (not NULL terminated) */
+    WBXML_READER_VALUE_OPAQUE,       /**< 'data' and 'len': opaque data, as found in document */
+    WBXML_READER_VALUE_ENTITY,       /**< 'code': an UCS-4 character code */
+    WBXML_READER_VALUE_EXTENSION     /**< 'token': the extension token. For EXT_I, 'data' and 'len' are its string,
+                                          for EXT_T, 'code' is its index (or value) */
+} WBXMLReaderValueType;
+
+/**
+ * @brief WBXML Reader Event
+ * @note Nothing is allocated for an Event: its pointers reference the Language Table entries,
+ *       or the document itself (String Table included). So they are valid as long as the document
+ *       given to wbxml_reader_set_input() is.
+ * @note Strings read from document are not converted: they are in document charset
+ *       (see wbxml_reader_get_charset()). Strings read from Language Tables are ASCII.
+ */
+typedef struct WBXMLReaderEvent_s {
+    WBXMLReaderEventType  type;        /**< Event type */
+    WB_ULONG              depth;       /**< Number of open Elements (START_ELEMENT and END_ELEMENT: this Element included) */
+    const WBXMLTagEntry  *tag;         /**< START_ELEMENT, END_ELEMENT: Tag entry (NULL if literal, or unknown) */
+    const WBXMLAttrEntry *attr;        /**< ATTRIBUTE, PI: Attribute entry (NULL if literal, or unknown) */
+    const WB_UTINY       *name;        /**< START_ELEMENT, END_ELEMENT, ATTRIBUTE, PI: Name */
+    WB_ULONG              name_len;    /**< Name length */
+    WB_BOOL               has_content; /**< START_ELEMENT: FALSE if Element is empty (END_ELEMENT follows its attributes) */
+    WBXMLReaderValueType  value_type;  /**< VALUE, CONTENT: Value type. ATTRIBUTE, PI: STRING if Attribute entry has a start of value */
+    const WB_UTINY       *data;        /**< Value data */
+    WB_ULONG              len;         /**< Value data length */
+    WB_ULONG              code;        /**< Value code */
+    WB_UTINY              token;       /**< Value token */
+} WBXMLReaderEvent;
+
+/**
+ * @brief Create a WBXML Reader
+ * @return The newly created WBXMLReader, or NULL if not enough memory
+ */
+WBXML_DECLARE(WBXMLReader *) wbxml_reader_create(void);
+
+/**
+ * @brief Destroy a WBXML Reader
+ * @param reader The WBXMLReader to destroy
+ */
+WBXML_DECLARE(void) wbxml_reader_destroy(WBXMLReader *reader);
+
+/**
+ * @brief Set Main WBXML Languages Table
+ * @param reader The WBXML Reader
+ * @param main_table The Main WBXML Languages Table to set
+ */
+WBXML_DECLARE(void) wbxml_reader_set_main_table(WBXMLReader *reader, const WBXMLLangEntry *main_table);
+
+/**
+ * @brief Force to read the Document as a given Language
+ * @param reader The WBXML Reader
+ * @param lang The Language
+ * @return TRUE if Language is set, FALSE otherwise
+ * @note As with wbxml_parser_set_language(), the Public ID of the Document is then ignored
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_reader_set_language(WBXMLReader *reader, WBXMLLanguage lang);
+
+/**
+ * @brief Set the Charset to use if it is not specified in Document
+ * @param reader The WBXML Reader
+ * @param charset The Charset MIBEnum
+ * @return TRUE if Charset is set, FALSE otherwise
+ */
+WBXML_DECLARE(WB_BOOL) wbxml_reader_set_meta_charset(WBXMLReader *reader, WBXMLCharsetMIBEnum charset);
+
+/**
+ * @brief Set the WBXML Document to read
+ * @param reader The WBXML Reader
+ * @param wbxml The WBXML Document
+ * @param wbxml_len The WBXML Document length
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note The Reader starts again from the beginning of this Document. It can be called at any time,
+ *       for example to stop reading a Document once the needed Elements are found.
+ * @warning The 'wbxml' memory is borrowed: it MUST stay valid, and MUST NOT be modified, as long as
+ *          it is read, and as long as Events read from it are used.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_reader_set_input(WBXMLReader *reader, const WB_UTINY *wbxml, WB_ULONG wbxml_len);
+
+/**
+ * @brief Read next Event
+ * @param reader The WBXML Reader
+ * @param event [out] The Event read
+ * @return WBXML_OK if an Event is read, an error code otherwise
+ * @note Events come in Document order: START_DOCUMENT, then for each Element a START_ELEMENT,
+ *       its ATTRIBUTEs (each followed by the VALUEs that end its value), its CONTENTs and Elements,
+ *       and an END_ELEMENT. A PI is followed by the VALUEs that end its value. Last Event is END_DOCUMENT.
+ * @note After an error, the same error is returned until another Document is set.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_reader_next(WBXMLReader *reader, WBXMLReaderEvent *event);
+
+/**
+ * @brief Skip the rest of current Element
+ * @param reader The WBXML Reader
+ * @return WBXML_OK if skipped, an error code otherwise
+ * @note Events are read up to the END_ELEMENT of the innermost open Element (included), but not returned.
+ *       For example, call it after a START_ELEMENT to skip this whole Element.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_reader_skip(WBXMLReader *reader);
+
+/**
+ * @brief Get the Language Table of Document
+ * @param reader The WBXML Reader
+ * @return The Language Table (available after START_DOCUMENT Event), or NULL
+ */
+WBXML_DECLARE(const WBXMLLangEntry *) wbxml_reader_get_lang_table(WBXMLReader *reader);
+
+/**
+ * @brief Get the Charset of Document
+ * @param reader The WBXML Reader
+ * @return The Charset (available after START_DOCUMENT Event), or WBXML_CHARSET_UNKNOWN
+ */
+WBXML_DECLARE(WBXMLCharsetMIBEnum) wbxml_reader_get_charset(WBXMLReader *reader);
+
+/**
+ * @brief Return current reading position in WBXML
+ * @param reader The WBXML Reader
+ * @return The reading position in WBXML
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_reader_get_current_byte_index(WBXMLReader *reader);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WBXML_READER_H */
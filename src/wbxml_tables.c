@@ -37,6 +37,11 @@
 #include "wbxml_tables.h"
 #include "wbxml_internals.h"
 #include "wbxml_log.h"
+#include "wbxml_mem.h"
+
+#if defined( WIN32 )
+#include <windows.h> /* For InterlockedCompareExchangePointer() */
+#endif /* WIN32 */
 
 /** 
  * @brief If undefined, only the WML 1.3 tables are used for all WML versions (WML 1.0 / WML 1.1 / WML 1.2 / WML 1.3).
@@ -3592,6 +3597,566 @@ const WBXMLLangEntry sv_table_entry[] = {
 };
 
 
+/******************************
+ *    Token Index
+ */
+
+/**
+ * @brief Atomically publish a pointer, if it is still NULL (WBXML_TABLES_PUBLISH), and
+ *        read a published pointer (WBXML_TABLES_LOAD)
+ * @note The read is an acquire load: once the pointer is seen, the content it points to
+ *       (filled before being published) is seen too, even on weakly ordered CPUs.
+ * @note If no such primitives are known for this platform, Token Index is disabled
+ *       and all lookups fall back to a sequential search in the tables.
+ */
+#if defined( WIN32 )
+#define WBXML_TABLES_PUBLISH(slot, ptr) (InterlockedCompareExchangePointer((PVOID volatile *) (slot), (PVOID) (ptr), NULL) == NULL)
+#define WBXML_TABLES_LOAD(slot) InterlockedCompareExchangePointer((PVOID volatile *) (slot), NULL, NULL)
+#elif defined( __GNUC__ )
+#define WBXML_TABLES_PUBLISH(slot, ptr) __sync_bool_compare_and_swap((slot), NULL, (ptr))
+#define WBXML_TABLES_LOAD(slot) __atomic_load_n((slot), __ATOMIC_ACQUIRE)
+#endif
+
+/** Number of entries in Main Table (including the terminating one) */
+#define WBXML_TABLES_MAIN_LEN (sizeof(sv_table_entry) / sizeof(sv_table_entry[0]))
+
+/**
+ * @brief Direct Token Index of a Language Table
+ * @note For each kind of token, this is an array of 256 Code Pages. Each Code Page is NULL
+ *       if no entry use it, or else an array of 256 pointers into the static Language Table,
+ *       indexed by WBXML Token (NULL if this token is not defined in this Code Page).
+ *       When a token is defined several times in a Code Page, the first entry is kept,
+ *       as a sequential search would do.
+ */
+typedef struct WBXMLTokenIndex_s {
+    const WBXMLTagEntry       **tags[256];       /**< Tags, indexed by [Code Page][Token] */
+    const WBXMLAttrEntry      **attrs[256];      /**< Attributes, indexed by [Code Page][Token] */
+    const WBXMLAttrValueEntry **attr_values[256]; /**< Attribute Values, indexed by [Code Page][Token] */
+    const WBXMLExtValueEntry  *ext_values[256];  /**< Extension Values, indexed by [Token] */
+} WBXMLTokenIndex;
+
+/**
+ * @brief Token Indexes of Main Table Languages (same order than sv_table_entry)
+ * @note Each index is built the first time it is needed, then it is only read.
+ *       Indexes live until the process exits.
+ */
+static WBXMLTokenIndex * volatile sv_token_index[WBXML_TABLES_MAIN_LEN];
+
+
+/**
+ * @brief Add an entry in a Token Index Code Page array
+ * @param pages     The Code Page array
+ * @param code_page The entry Code Page
+ * @param token     The entry Token
+ * @param entry     The entry
+ * @return TRUE if added (or if a previous entry was already there), FALSE if not enough memory
+ */
+static WB_BOOL wbxml_tables_token_index_set(const void ***pages, WB_UTINY code_page, WB_UTINY token, const void *entry)
+{
+    if (pages[code_page] == NULL) {
+        if ((pages[code_page] = wbxml_malloc(256 * sizeof(void *))) == NULL)
+            return FALSE;
+
+        memset((void *) pages[code_page], 0, 256 * sizeof(void *));
+    }
+
+    /* Keep the first entry */
+    if (pages[code_page][token] == NULL)
+        pages[code_page][token] = entry;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Destroy a Token Index
+ * @param token_index The Token Index to destroy
+ */
+static void wbxml_tables_token_index_destroy(WBXMLTokenIndex *token_index)
+{
+    WB_ULONG i = 0;
+
+    if (token_index == NULL)
+        return;
+
+    for (i = 0; i < 256; i++) {
+        wbxml_free((void *) token_index->tags[i]);
+        wbxml_free((void *) token_index->attrs[i]);
+        wbxml_free((void *) token_index->attr_values[i]);
+    }
+
+    wbxml_free(token_index);
+}
+
+
+/**
+ * @brief Build a Token Index
+ * @param lang_table The Language Table to index
+ * @return The new Token Index, or NULL if not enough memory
+ */
+static WBXMLTokenIndex *wbxml_tables_token_index_create(const WBXMLLangEntry *lang_table)
+{
+    WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    if ((token_index = wbxml_malloc(sizeof(WBXMLTokenIndex))) == NULL)
+        return NULL;
+
+    memset(token_index, 0, sizeof(WBXMLTokenIndex));
+
+    for (i = 0; (lang_table->tagTable != NULL) && (lang_table->tagTable[i].xmlName != NULL); i++) {
+        if (!wbxml_tables_token_index_set((const void ***) token_index->tags,
+                                          lang_table->tagTable[i].wbxmlCodePage,
+                                          lang_table->tagTable[i].wbxmlToken,
+                                          &lang_table->tagTable[i]))
+        {
+            wbxml_tables_token_index_destroy(token_index);
+            return NULL;
+        }
+    }
+
+    for (i = 0; (lang_table->attrTable != NULL) && (lang_table->attrTable[i].xmlName != NULL); i++) {
+        if (!wbxml_tables_token_index_set((const void ***) token_index->attrs,
+                                          lang_table->attrTable[i].wbxmlCodePage,
+                                          lang_table->attrTable[i].wbxmlToken,
+                                          &lang_table->attrTable[i]))
+        {
+            wbxml_tables_token_index_destroy(token_index);
+            return NULL;
+        }
+    }
+
+    for (i = 0; (lang_table->attrValueTable != NULL) && (lang_table->attrValueTable[i].xmlName != NULL); i++) {
+        if (!wbxml_tables_token_index_set((const void ***) token_index->attr_values,
+                                          lang_table->attrValueTable[i].wbxmlCodePage,
+                                          lang_table->attrValueTable[i].wbxmlToken,
+                                          &lang_table->attrValueTable[i]))
+        {
+            wbxml_tables_token_index_destroy(token_index);
+            return NULL;
+        }
+    }
+
+    for (i = 0; (lang_table->extValueTable != NULL) && (lang_table->extValueTable[i].xmlName != NULL); i++) {
+        /* Keep the first entry */
+        if (token_index->ext_values[lang_table->extValueTable[i].wbxmlToken] == NULL)
+            token_index->ext_values[lang_table->extValueTable[i].wbxmlToken] = &lang_table->extValueTable[i];
+    }
+
+    return token_index;
+}
+
+
+/**
+ * @brief Get the Token Index of a Language Table
+ * @param lang_table The Language Table
+ * @return The Token Index, or NULL if this Language Table is not part of the Main Table,
+ *         or if the Token Index can't be built (in this case, caller must search sequentially)
+ * @note The first call for a given Language Table builds its Token Index. If several threads
+ *       build it at the same time, only one index is published and the others are destroyed.
+ */
+static const WBXMLTokenIndex *wbxml_tables_get_token_index(const WBXMLLangEntry *lang_table)
+{
+#if defined( WBXML_TABLES_PUBLISH )
+    WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    /* Only Main Table Languages are indexed (tables given by user may not be static) */
+    if ((lang_table < sv_table_entry) || (lang_table >= sv_table_entry + WBXML_TABLES_MAIN_LEN))
+        return NULL;
+
+    i = (WB_ULONG) (lang_table - sv_table_entry);
+
+    if ((token_index = WBXML_TABLES_LOAD(&sv_token_index[i])) != NULL)
+        return token_index;
+
+    /* It is kept until the process exits: it is allocated with the default Allocator */
+    if ((token_index = wbxml_tables_token_index_create(lang_table)) == NULL)
+        return NULL;
+
+    if (!WBXML_TABLES_PUBLISH(&sv_token_index[i], token_index)) {
+        /* Another thread was faster */
+        wbxml_tables_token_index_destroy(token_index);
+        token_index = WBXML_TABLES_LOAD(&sv_token_index[i]);
+    }
+
+    return token_index;
+#else
+    return NULL;
+#endif /* WBXML_TABLES_PUBLISH */
+}
+
+
+/******************************
+ *    Name Index
+ */
+
+/**
+ * @brief Node of an Attribute Values prefix tree
+ * @note Nodes are referenced by their position in WBXMLNameIndex 'attr_nodes' array. Position 0 means "no node".
+ */
+typedef struct WBXMLAttrValueNode_s {
+    WB_UTINY              c;       /**< Character leading to this node from its parent */
+    WB_ULONG              child;   /**< First child node */
+    WB_ULONG              sibling; /**< Next sibling node */
+    const WBXMLAttrEntry *entry;   /**< First Attribute Entry whose Value ends here (NULL if none) */
+} WBXMLAttrValueNode;
+
+/**
+ * @brief All Attribute Entries sharing the same XML Name
+ */
+typedef struct WBXMLAttrNameGroup_s {
+    const WB_TINY        *xmlName;    /**< XML Attribute Name */
+    const WBXMLAttrEntry *null_value; /**< First Attribute Entry with this Name and a NULL Value (NULL if none) */
+    WB_ULONG              root;       /**< Root node of the Attribute Values prefix tree */
+} WBXMLAttrNameGroup;
+
+/**
+ * @brief XML Name Index of a Language Table
+ * @note Tags: a hash table of XML Names gives the first Tag Entry with this Name, and entries with
+ *       the same Name are chained in table order. Each Tag Entry is also flagged if it belongs to the
+ *       first run of entries of its Code Page, as this is the only part of a Code Page that is
+ *       searched first by wbxml_tables_get_tag_from_xml().
+ *       Attributes: a hash table of XML Names gives the group of Attribute Entries with this Name,
+ *       whose Values are stored in a prefix tree.
+ */
+typedef struct WBXMLNameIndex_s {
+    WB_ULONG            tag_slots_len;  /**< Number of slots in Tags hash table (always a power of 2) */
+    WB_ULONG           *tag_slots;      /**< Tags hash table: Tag Table index + 1 (0 if empty slot) */
+    WB_ULONG           *tag_next;       /**< Next Tag Table index + 1 with the same XML Name (0 if none) */
+    WB_BOOL            *tag_first_run;  /**< Is this Tag Table entry in the first run of its Code Page ? */
+    WB_ULONG            attr_slots_len; /**< Number of slots in Attributes hash table (always a power of 2) */
+    WB_ULONG           *attr_slots;     /**< Attributes hash table: Attribute group index + 1 (0 if empty slot) */
+    WBXMLAttrNameGroup *attr_groups;    /**< Attribute groups */
+    WBXMLAttrValueNode *attr_nodes;     /**< Attribute Values prefix tree nodes */
+    WB_ULONG            attr_nodes_len; /**< Number of used Attribute Values prefix tree nodes */
+} WBXMLNameIndex;
+
+/**
+ * @brief Name Indexes of Main Table Languages (same order than sv_table_entry)
+ * @note Same life cycle than Token Indexes.
+ */
+static WBXMLNameIndex * volatile sv_name_index[WBXML_TABLES_MAIN_LEN];
+
+
+/**
+ * @brief Hash an XML Name (FNV-1a)
+ * @param name The XML Name
+ * @return The hash value
+ */
+static WB_ULONG wbxml_tables_name_hash(const WB_UTINY *name)
+{
+    WB_ULONG hash = 2166136261UL;
+
+    while (*name != '\0') {
+        hash ^= *name++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+
+/**
+ * @brief Get a hash table size for a number of entries
+ * @param count Number of entries
+ * @return A power of 2, at least twice 'count'
+ */
+static WB_ULONG wbxml_tables_name_slots_len(WB_ULONG count)
+{
+    WB_ULONG len = 16;
+
+    while (len < count * 2)
+        len *= 2;
+
+    return len;
+}
+
+
+/**
+ * @brief Destroy a Name Index
+ * @param name_index The Name Index to destroy
+ */
+static void wbxml_tables_name_index_destroy(WBXMLNameIndex *name_index)
+{
+    if (name_index == NULL)
+        return;
+
+    wbxml_free(name_index->tag_slots);
+    wbxml_free(name_index->tag_next);
+    wbxml_free(name_index->tag_first_run);
+    wbxml_free(name_index->attr_slots);
+    wbxml_free(name_index->attr_groups);
+    wbxml_free(name_index->attr_nodes);
+    wbxml_free(name_index);
+}
+
+
+/**
+ * @brief Index the Tags Table of a Language Table
+ * @param name_index The Name Index to fill
+ * @param tag_table  The Tags Table
+ * @return TRUE if indexed, FALSE if not enough memory
+ */
+static WB_BOOL wbxml_tables_name_index_tags(WBXMLNameIndex *name_index, const WBXMLTagEntry *tag_table)
+{
+    WB_BOOL closed[256];
+    WB_ULONG count = 0, i = 0, slot = 0, last = 0;
+
+    while (tag_table[count].xmlName != NULL)
+        count++;
+
+    name_index->tag_slots_len = wbxml_tables_name_slots_len(count);
+
+    if (((name_index->tag_slots = wbxml_malloc(name_index->tag_slots_len * sizeof(WB_ULONG))) == NULL) ||
+        ((name_index->tag_next = wbxml_malloc((count + 1) * sizeof(WB_ULONG))) == NULL) ||
+        ((name_index->tag_first_run = wbxml_malloc((count + 1) * sizeof(WB_BOOL))) == NULL))
+    {
+        return FALSE;
+    }
+
+    memset(name_index->tag_slots, 0, name_index->tag_slots_len * sizeof(WB_ULONG));
+    memset(closed, 0, sizeof(closed));
+
+    for (i = 0; i < count; i++) {
+        /* A Code Page run ends as soon as another Code Page is found */
+        if ((i > 0) && (tag_table[i].wbxmlCodePage != tag_table[i - 1].wbxmlCodePage))
+            closed[tag_table[i - 1].wbxmlCodePage] = TRUE;
+
+        name_index->tag_first_run[i] = !closed[tag_table[i].wbxmlCodePage];
+        name_index->tag_next[i] = 0;
+
+        /* Search this Name in hash table */
+        slot = wbxml_tables_name_hash((const WB_UTINY *) tag_table[i].xmlName) & (name_index->tag_slots_len - 1);
+
+        while ((name_index->tag_slots[slot] != 0) &&
+               (WBXML_STRCMP(tag_table[name_index->tag_slots[slot] - 1].xmlName, tag_table[i].xmlName) != 0))
+        {
+            slot = (slot + 1) & (name_index->tag_slots_len - 1);
+        }
+
+        if (name_index->tag_slots[slot] == 0) {
+            /* New Name */
+            name_index->tag_slots[slot] = i + 1;
+        }
+        else {
+            /* Append to the chain of this Name */
+            last = name_index->tag_slots[slot] - 1;
+            while (name_index->tag_next[last] != 0)
+                last = name_index->tag_next[last] - 1;
+
+            name_index->tag_next[last] = i + 1;
+        }
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Index the Attributes Table of a Language Table
+ * @param name_index The Name Index to fill
+ * @param attr_table The Attributes Table
+ * @return TRUE if indexed, FALSE if not enough memory
+ */
+static WB_BOOL wbxml_tables_name_index_attrs(WBXMLNameIndex *name_index, const WBXMLAttrEntry *attr_table)
+{
+    WBXMLAttrNameGroup *group = NULL;
+    WBXMLAttrValueNode *node = NULL;
+    const WB_UTINY *value = NULL;
+    WB_ULONG count = 0, nodes_max = 1, groups_len = 0, i = 0, slot = 0, cur = 0, child = 0;
+
+    for (count = 0; attr_table[count].xmlName != NULL; count++) {
+        /* One root per group, and at most one node per Value character */
+        nodes_max++;
+        if (attr_table[count].xmlValue != NULL)
+            nodes_max += WBXML_STRLEN(attr_table[count].xmlValue);
+    }
+
+    name_index->attr_slots_len = wbxml_tables_name_slots_len(count);
+
+    if (((name_index->attr_slots = wbxml_malloc(name_index->attr_slots_len * sizeof(WB_ULONG))) == NULL) ||
+        ((name_index->attr_groups = wbxml_malloc((count + 1) * sizeof(WBXMLAttrNameGroup))) == NULL) ||
+        ((name_index->attr_nodes = wbxml_malloc(nodes_max * sizeof(WBXMLAttrValueNode))) == NULL))
+    {
+        return FALSE;
+    }
+
+    memset(name_index->attr_slots, 0, name_index->attr_slots_len * sizeof(WB_ULONG));
+    memset(name_index->attr_nodes, 0, nodes_max * sizeof(WBXMLAttrValueNode));
+
+    /* Node 0 is never used */
+    name_index->attr_nodes_len = 1;
+
+    for (i = 0; i < count; i++) {
+        /* Search this Name in hash table */
+        slot = wbxml_tables_name_hash((const WB_UTINY *) attr_table[i].xmlName) & (name_index->attr_slots_len - 1);
+
+        while ((name_index->attr_slots[slot] != 0) &&
+               (WBXML_STRCMP(name_index->attr_groups[name_index->attr_slots[slot] - 1].xmlName, attr_table[i].xmlName) != 0))
+        {
+            slot = (slot + 1) & (name_index->attr_slots_len - 1);
+        }
+
+        if (name_index->attr_slots[slot] == 0) {
+            /* New Name */
+            group = &name_index->attr_groups[groups_len++];
+            group->xmlName = attr_table[i].xmlName;
+            group->null_value = NULL;
+            group->root = name_index->attr_nodes_len++;
+
+            name_index->attr_slots[slot] = groups_len;
+        }
+        else
+            group = &name_index->attr_groups[name_index->attr_slots[slot] - 1];
+
+        if (attr_table[i].xmlValue == NULL) {
+            /* Keep the first entry */
+            if (group->null_value == NULL)
+                group->null_value = &attr_table[i];
+
+            continue;
+        }
+
+        /* Insert Value in prefix tree */
+        cur = group->root;
+
+        for (value = (const WB_UTINY *) attr_table[i].xmlValue; *value != '\0'; value++) {
+            child = name_index->attr_nodes[cur].child;
+
+            while ((child != 0) && (name_index->attr_nodes[child].c != *value))
+                child = name_index->attr_nodes[child].sibling;
+
+            if (child == 0) {
+                child = name_index->attr_nodes_len++;
+
+                node = &name_index->attr_nodes[child];
+                node->c = *value;
+                node->sibling = name_index->attr_nodes[cur].child;
+                name_index->attr_nodes[cur].child = child;
+            }
+
+            cur = child;
+        }
+
+        /* Keep the first entry */
+        if (name_index->attr_nodes[cur].entry == NULL)
+            name_index->attr_nodes[cur].entry = &attr_table[i];
+    }
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Build a Name Index
+ * @param lang_table The Language Table to index
+ * @return The new Name Index, or NULL if not enough memory
+ */
+static WBXMLNameIndex *wbxml_tables_name_index_create(const WBXMLLangEntry *lang_table)
+{
+    WBXMLNameIndex *name_index = NULL;
+
+    if ((name_index = wbxml_malloc(sizeof(WBXMLNameIndex))) == NULL)
+        return NULL;
+
+    memset(name_index, 0, sizeof(WBXMLNameIndex));
+
+    if (((lang_table->tagTable != NULL) && !wbxml_tables_name_index_tags(name_index, lang_table->tagTable)) ||
+        ((lang_table->attrTable != NULL) && !wbxml_tables_name_index_attrs(name_index, lang_table->attrTable)))
+    {
+        wbxml_tables_name_index_destroy(name_index);
+        return NULL;
+    }
+
+    return name_index;
+}
+
+
+/**
+ * @brief Get the Name Index of a Language Table
+ * @param lang_table The Language Table
+ * @return The Name Index, or NULL if this Language Table is not part of the Main Table,
+ *         or if the Name Index can't be built (in this case, caller must search sequentially)
+ * @note See wbxml_tables_get_token_index()
+ */
+static const WBXMLNameIndex *wbxml_tables_get_name_index(const WBXMLLangEntry *lang_table)
+{
+#if defined( WBXML_TABLES_PUBLISH )
+    WBXMLNameIndex *name_index = NULL;
+    WB_ULONG i = 0;
+
+    /* Only Main Table Languages are indexed (tables given by user may not be static) */
+    if ((lang_table < sv_table_entry) || (lang_table >= sv_table_entry + WBXML_TABLES_MAIN_LEN))
+        return NULL;
+
+    i = (WB_ULONG) (lang_table - sv_table_entry);
+
+    if ((name_index = WBXML_TABLES_LOAD(&sv_name_index[i])) != NULL)
+        return name_index;
+
+    if ((name_index = wbxml_tables_name_index_create(lang_table)) == NULL)
+        return NULL;
+
+    if (!WBXML_TABLES_PUBLISH(&sv_name_index[i], name_index)) {
+        /* Another thread was faster */
+        wbxml_tables_name_index_destroy(name_index);
+        name_index = WBXML_TABLES_LOAD(&sv_name_index[i]);
+    }
+
+    return name_index;
+#else
+    return NULL;
+#endif /* WBXML_TABLES_PUBLISH */
+}
+
+
+/******************************
+ *    Attribute Value Matcher
+ */
+
+/**
+ * @brief Attribute Value Matchers of Main Table Languages (same order than sv_table_entry)
+ * @note Same life cycle than Token Indexes.
+ */
+static WBXMLMatcher * volatile sv_attr_value_matcher[WBXML_TABLES_MAIN_LEN];
+
+
+/**
+ * @brief Build the Attribute Value Matcher of a Language Table
+ * @param lang_table The Language Table
+ * @return The new compiled Matcher, or NULL if not enough memory
+ * @note Each Pattern value is the position of its entry in Attribute Values Table
+ */
+static WBXMLMatcher *wbxml_tables_attr_value_matcher_create(const WBXMLLangEntry *lang_table)
+{
+    WBXMLMatcher *matcher = NULL;
+    WB_ULONG i = 0;
+
+    if ((matcher = wbxml_matcher_create()) == NULL)
+        return NULL;
+
+    while (lang_table->attrValueTable[i].xmlName != NULL) {
+        if (!wbxml_matcher_add(matcher,
+                               (const WB_UTINY *) lang_table->attrValueTable[i].xmlName,
+                               WBXML_STRLEN(lang_table->attrValueTable[i].xmlName),
+                               i))
+        {
+            wbxml_matcher_destroy(matcher);
+            return NULL;
+        }
+        i++;
+    }
+
+    if (!wbxml_matcher_compile(matcher)) {
+        wbxml_matcher_destroy(matcher);
+        return NULL;
+    }
+
+    return matcher;
+}
+
+
 /******************************
  * Public Functions
  */
@@ -3710,16 +4275,160 @@ WBXML_DECLARE(WB_ULONG) wbxml_tables_get_wbxml_publicid(const WBXMLLangEntry *ma
 }
 
 
+WBXML_DECLARE(const WBXMLTagEntry *) wbxml_tables_get_tag_from_token(const WBXMLLangEntry *lang_table,
+                                                                     WB_UTINY code_page,
+                                                                     WB_UTINY token)
+{
+    const WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    if ((lang_table == NULL) || (lang_table->tagTable == NULL))
+        return NULL;
+
+    if ((token_index = wbxml_tables_get_token_index(lang_table)) != NULL) {
+        if (token_index->tags[code_page] == NULL)
+            return NULL;
+
+        return token_index->tags[code_page][token];
+    }
+
+    while (lang_table->tagTable[i].xmlName != NULL) {
+        if ((lang_table->tagTable[i].wbxmlToken == token) &&
+            (lang_table->tagTable[i].wbxmlCodePage == code_page))
+        {
+            return &(lang_table->tagTable[i]);
+        }
+        i++;
+    }
+
+    return NULL;
+}
+
+
+WBXML_DECLARE(const WBXMLAttrEntry *) wbxml_tables_get_attr_from_token(const WBXMLLangEntry *lang_table,
+                                                                       WB_UTINY code_page,
+                                                                       WB_UTINY token)
+{
+    const WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    if ((lang_table == NULL) || (lang_table->attrTable == NULL))
+        return NULL;
+
+    if ((token_index = wbxml_tables_get_token_index(lang_table)) != NULL) {
+        if (token_index->attrs[code_page] == NULL)
+            return NULL;
+
+        return token_index->attrs[code_page][token];
+    }
+
+    while (lang_table->attrTable[i].xmlName != NULL) {
+        if ((lang_table->attrTable[i].wbxmlToken == token) &&
+            (lang_table->attrTable[i].wbxmlCodePage == code_page))
+        {
+            return &(lang_table->attrTable[i]);
+        }
+        i++;
+    }
+
+    return NULL;
+}
+
+
+WBXML_DECLARE(const WBXMLAttrValueEntry *) wbxml_tables_get_attr_value_from_token(const WBXMLLangEntry *lang_table,
+                                                                                 WB_UTINY code_page,
+                                                                                 WB_UTINY token)
+{
+    const WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    if ((lang_table == NULL) || (lang_table->attrValueTable == NULL))
+        return NULL;
+
+    if ((token_index = wbxml_tables_get_token_index(lang_table)) != NULL) {
+        if (token_index->attr_values[code_page] == NULL)
+            return NULL;
+
+        return token_index->attr_values[code_page][token];
+    }
+
+    while (lang_table->attrValueTable[i].xmlName != NULL) {
+        if ((lang_table->attrValueTable[i].wbxmlToken == token) &&
+            (lang_table->attrValueTable[i].wbxmlCodePage == code_page))
+        {
+            return &(lang_table->attrValueTable[i]);
+        }
+        i++;
+    }
+
+    return NULL;
+}
+
+
+WBXML_DECLARE(const WBXMLExtValueEntry *) wbxml_tables_get_ext_from_token(const WBXMLLangEntry *lang_table,
+                                                                          WB_ULONG token)
+{
+    const WBXMLTokenIndex *token_index = NULL;
+    WB_ULONG i = 0;
+
+    if ((lang_table == NULL) || (lang_table->extValueTable == NULL))
+        return NULL;
+
+    /* Extension Value Tokens are only one byte long in tables */
+    if (token > 0xFF)
+        return NULL;
+
+    if ((token_index = wbxml_tables_get_token_index(lang_table)) != NULL)
+        return token_index->ext_values[token];
+
+    while (lang_table->extValueTable[i].xmlName != NULL) {
+        if (lang_table->extValueTable[i].wbxmlToken == token)
+            return &(lang_table->extValueTable[i]);
+        i++;
+    }
+
+    return NULL;
+}
+
+
 WBXML_DECLARE(const WBXMLTagEntry *) wbxml_tables_get_tag_from_xml(const WBXMLLangEntry *lang_table,
                                                                    const int cur_code_page,
                                                                    const WB_UTINY *xml_name)
 {
-    WB_ULONG i;
+    const WBXMLNameIndex *name_index = NULL;
+    WB_ULONG i, slot, first;
     WB_BOOL found_current = FALSE;
 
     if ((lang_table == NULL) || (lang_table->tagTable == NULL) || (xml_name == NULL))
         return NULL;
 
+    if ((name_index = wbxml_tables_get_name_index(lang_table)) != NULL) {
+        slot = wbxml_tables_name_hash(xml_name) & (name_index->tag_slots_len - 1);
+
+        while ((name_index->tag_slots[slot] != 0) &&
+               (WBXML_STRCMP(lang_table->tagTable[name_index->tag_slots[slot] - 1].xmlName, xml_name) != 0))
+        {
+            slot = (slot + 1) & (name_index->tag_slots_len - 1);
+        }
+
+        if ((first = name_index->tag_slots[slot]) == 0)
+            return NULL;
+
+        /* First off, try to find it in the first run of the current code page, if provided */
+        for (i = first; cur_code_page >= 0 && i != 0; i = name_index->tag_next[i - 1]) {
+            if ((lang_table->tagTable[i - 1].wbxmlCodePage == cur_code_page) && name_index->tag_first_run[i - 1])
+                return &lang_table->tagTable[i - 1];
+        }
+
+        /* Then try all others */
+        for (i = first; i != 0; i = name_index->tag_next[i - 1]) {
+            if (cur_code_page < 0 || lang_table->tagTable[i - 1].wbxmlCodePage != cur_code_page)
+                return &lang_table->tagTable[i - 1];
+        }
+
+        return NULL;
+    }
+
     /* First off, try to find it in the current code page, if provided */
     for (i = 0; cur_code_page >= 0 && lang_table->tagTable[i].xmlName != NULL; i++) {
         const WBXMLTagEntry *entry = &lang_table->tagTable[i];
@@ -3756,7 +4465,10 @@ WBXML_DECLARE(const WBXMLAttrEntry *) wbxml_tables_get_attr_from_xml(const WBXML
                                                                      WB_UTINY *xml_value,
                                                                      WB_UTINY **value_left)
 {
-    WB_ULONG i = 0;
+    const WBXMLNameIndex *name_index = NULL;
+    const WBXMLAttrNameGroup *group = NULL;
+    const WBXMLAttrEntry *best = NULL;
+    WB_ULONG i = 0, slot = 0, node = 0;
     WB_ULONG found_index = 0, found_comp = 0;
     WB_BOOL found = FALSE;
 
@@ -3766,6 +4478,65 @@ WBXML_DECLARE(const WBXMLAttrEntry *) wbxml_tables_get_attr_from_xml(const WBXML
     if (value_left != NULL)
         *value_left = xml_value;
 
+    if ((name_index = wbxml_tables_get_name_index(lang_table)) != NULL) {
+        slot = wbxml_tables_name_hash(xml_name) & (name_index->attr_slots_len - 1);
+
+        while ((name_index->attr_slots[slot] != 0) &&
+               (WBXML_STRCMP(name_index->attr_groups[name_index->attr_slots[slot] - 1].xmlName, xml_name) != 0))
+        {
+            slot = (slot + 1) & (name_index->attr_slots_len - 1);
+        }
+
+        /* Attribute Name NOT found */
+        if (name_index->attr_slots[slot] == 0)
+            return NULL;
+
+        group = &name_index->attr_groups[name_index->attr_slots[slot] - 1];
+
+        /* This is the token with a NULL Attribute Value */
+        if (xml_value == NULL)
+            return group->null_value;
+
+        /* Walk down the Attribute Values prefix tree: the deepest Value found is the longest one */
+        node = group->root;
+
+        for (i = 0; ; i++) {
+            if (xml_value[i] == '\0') {
+                if (name_index->attr_nodes[node].entry != NULL) {
+                    /* We have found the EXACT Attribute Name / Value pair we are searching, well done boy */
+                    if (value_left != NULL)
+                        *value_left = NULL;
+
+                    return name_index->attr_nodes[node].entry;
+                }
+                break;
+            }
+
+            if ((i > 0) && (name_index->attr_nodes[node].entry != NULL)) {
+                /* We have found a better Attribute Value */
+                best = name_index->attr_nodes[node].entry;
+                found_comp = i;
+            }
+
+            node = name_index->attr_nodes[node].child;
+            while ((node != 0) && (name_index->attr_nodes[node].c != xml_value[i]))
+                node = name_index->attr_nodes[node].sibling;
+
+            if (node == 0)
+                break;
+        }
+
+        if (best == NULL)
+            best = group->null_value;
+
+        /* Attribute Name / Value pair not found, but an entry with this Attribute Name,
+         * and (maybe) start of this Attribute Value was found */
+        if ((best != NULL) && (value_left != NULL))
+            *value_left = xml_value + found_comp;
+
+        return best;
+    }
+
     /* Iterate in Attribute Table */
     while (lang_table->attrTable[i].xmlName != NULL) {
         /* Search for Attribute Name */
@@ -3871,6 +4642,40 @@ WBXML_DECLARE(WB_BOOL) wbxml_tables_contains_attr_value_from_xml(const WBXMLLang
 }
 
 
+WBXML_DECLARE(const WBXMLMatcher *) wbxml_tables_get_attr_value_matcher(const WBXMLLangEntry *lang_table)
+{
+#if defined( WBXML_TABLES_PUBLISH )
+    WBXMLMatcher *matcher = NULL;
+    WB_ULONG i = 0;
+
+    if ((lang_table == NULL) || (lang_table->attrValueTable == NULL))
+        return NULL;
+
+    /* Only Main Table Languages are cached (tables given by user may not be static) */
+    if ((lang_table < sv_table_entry) || (lang_table >= sv_table_entry + WBXML_TABLES_MAIN_LEN))
+        return NULL;
+
+    i = (WB_ULONG) (lang_table - sv_table_entry);
+
+    if ((matcher = WBXML_TABLES_LOAD(&sv_attr_value_matcher[i])) != NULL)
+        return matcher;
+
+    if ((matcher = wbxml_tables_attr_value_matcher_create(lang_table)) == NULL)
+        return NULL;
+
+    if (!WBXML_TABLES_PUBLISH(&sv_attr_value_matcher[i], matcher)) {
+        /* Another thread was faster */
+        wbxml_matcher_destroy(matcher);
+        matcher = WBXML_TABLES_LOAD(&sv_attr_value_matcher[i]);
+    }
+
+    return matcher;
+#else
+    return NULL;
+#endif /* WBXML_TABLES_PUBLISH */
+}
+
+
 WBXML_DECLARE(const WB_TINY *) wbxml_tables_get_xmlns(const WBXMLNameSpaceEntry *ns_table, WB_UTINY code_page)
 {
     WB_ULONG i = 0;
@@ -37,6 +37,7 @@
 #define WBXML_TABLES_H
 
 #include "wbxml.h"
+#include "wbxml_matcher.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -276,6 +277,53 @@ WBXML_DECLARE(const WBXMLLangEntry *) wbxml_tables_search_table(const WBXMLLangE
 WBXML_DECLARE(WB_ULONG) wbxml_tables_get_wbxml_publicid(const WBXMLLangEntry *main_table,
                                                         WBXMLLanguage lang_id);
 
+/**
+ * @brief Search for a Tag Entry in Language Table, given its WBXML Code Page and Token
+ * @param lang_table The Language Table to search in
+ * @param code_page The WBXML Code Page of the Tag
+ * @param token The WBXML Token of the Tag (without ATTR and CONTENT bits)
+ * @return The first Tag Entry with this Code Page and Token in Language Table, or NULL if not found
+ * @note For Main Table Languages, this is a direct lookup in an index built on first call.
+ *       This function can be called concurrently from several threads.
+ */
+WBXML_DECLARE(const WBXMLTagEntry *) wbxml_tables_get_tag_from_token(const WBXMLLangEntry *lang_table,
+                                                                     WB_UTINY code_page,
+                                                                     WB_UTINY token);
+
+/**
+ * @brief Search for an Attribute Entry in Language Table, given its WBXML Code Page and Token
+ * @param lang_table The Language Table to search in
+ * @param code_page The WBXML Code Page of the Attribute
+ * @param token The WBXML Attribute Start Token
+ * @return The first Attribute Entry with this Code Page and Token in Language Table, or NULL if not found
+ * @note See wbxml_tables_get_tag_from_token()
+ */
+WBXML_DECLARE(const WBXMLAttrEntry *) wbxml_tables_get_attr_from_token(const WBXMLLangEntry *lang_table,
+                                                                       WB_UTINY code_page,
+                                                                       WB_UTINY token);
+
+/**
+ * @brief Search for an Attribute Value Entry in Language Table, given its WBXML Code Page and Token
+ * @param lang_table The Language Table to search in
+ * @param code_page The WBXML Code Page of the Attribute Value
+ * @param token The WBXML Attribute Value Token
+ * @return The first Attribute Value Entry with this Code Page and Token in Language Table, or NULL if not found
+ * @note See wbxml_tables_get_tag_from_token()
+ */
+WBXML_DECLARE(const WBXMLAttrValueEntry *) wbxml_tables_get_attr_value_from_token(const WBXMLLangEntry *lang_table,
+                                                                                 WB_UTINY code_page,
+                                                                                 WB_UTINY token);
+
+/**
+ * @brief Search for an Extension Value Entry in Language Table, given its WBXML Token
+ * @param lang_table The Language Table to search in
+ * @param token The WBXML Extension Value Token
+ * @return The first Extension Value Entry with this Token in Language Table, or NULL if not found
+ * @note See wbxml_tables_get_tag_from_token()
+ */
+WBXML_DECLARE(const WBXMLExtValueEntry *) wbxml_tables_get_ext_from_token(const WBXMLLangEntry *lang_table,
+                                                                          WB_ULONG token);
+
 /**
  * @brief Search for a Tag Entry in Language Table, given the XML Name of the Tag
  * @param lang_table The Language Table to search in
@@ -316,6 +364,17 @@ WBXML_DECLARE(const WBXMLAttrEntry *) wbxml_tables_get_attr_from_xml(const WBXML
 WBXML_DECLARE(const WBXMLExtValueEntry *) wbxml_tables_get_ext_from_xml(const WBXMLLangEntry *lang_table,
                                                                         WB_UTINY *xml_value);
 
+/**
+ * @brief Get the Matcher of all Attribute Values defined in a Language Attribute Values Table
+ * @param lang_table The Language Table
+ * @return The compiled Matcher, or NULL if this Language Table is not part of the Main Table
+ *         (or has no Attribute Values Table, or if not enough memory)
+ * @note Patterns are the Attribute Values, in table order. The value of each Pattern is
+ *       the position of its entry in Attribute Values Table.
+ * @note The Matcher is built the first time it is asked for, and then shared: it must not be modified.
+ */
+WBXML_DECLARE(const WBXMLMatcher *) wbxml_tables_get_attr_value_matcher(const WBXMLLangEntry *lang_table);
+
 /**
  * @brief Check if an XML Attribute Value contains at least one Attribute Value defined in Language Attribute Values Table
  * @param lang_table The Language Table to search in
@@ -0,0 +1,382 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_template.c
+ * @ingroup wbxml_template
+ *
+ * @date 26/10/17
+ *
+ * @brief WBXML Templates: documents encoded once, with values inserted in Slots
+ */
+
+#include "wbxml_template.h"
+#include "wbxml_encoder.h"
+#include "wbxml_internals.h"
+
+/** Maximum number of Slots (so that their arrays can be allocated) */
+#define WBXML_TEMPLATE_MAX_SLOTS (0xFFFFFFFF / sizeof(WBXMLTemplateSlot))
+
+/** String Terminating NULL Char */
+#define WBXML_STR_END '\0'
+
+/** A Slot of Template */
+typedef struct WBXMLTemplateSlot_s {
+    WB_ULONG pos;   /**< Position in document */
+    WB_ULONG index; /**< Index of its value */
+} WBXMLTemplateSlot;
+
+/** The Template type */
+struct WBXMLTemplate_s {
+    WB_UTINY          *data;      /**< WBXML document, without Slots */
+    WB_ULONG           len;       /**< WBXML document length */
+    WBXMLTemplateSlot *slots;     /**< Slots, in document order */
+    WB_ULONG           nb_slots;  /**< Number of Slots */
+    WBXMLAllocator    *allocator; /**< Allocator of this Template (NULL if default one is used) */
+};
+
+
+/* Private functions prototypes */
+static WBXMLError template_encode(WBXMLTree *tree,
+                                  WBXMLTreeNode **slots,
+                                  WB_ULONG nb_slots,
+                                  WBXMLGenWBXMLParams *params,
+                                  WBXMLTemplate *tmpl);
+static int template_slot_compare(const void *a, const void *b);
+static WB_ULONG template_mb_uint_32_len(WB_ULONG value);
+static WBXMLError template_value_len(const WBXMLTemplateValue *value, WB_ULONG *len);
+static WB_BOOL template_append_value(WBXMLBuffer *output, const WBXMLTemplateValue *value);
+
+
+/***************************************************
+ *    Public Functions
+ */
+
+WBXML_DECLARE(WBXMLError) wbxml_template_create(WBXMLTree *tree,
+                                                WBXMLTreeNode **slots,
+                                                WB_ULONG nb_slots,
+                                                WBXMLGenWBXMLParams *params,
+                                                WBXMLTemplate **result)
+{
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLError ret = WBXML_OK;
+
+    if ((tree == NULL) || ((nb_slots > 0) && (slots == NULL)) || (result == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    *result = NULL;
+
+    /* The Template gets the Allocator of the Tree */
+    if ((tmpl = wbxml_mem_malloc(tree->allocator, sizeof(WBXMLTemplate))) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    tmpl->data = NULL;
+    tmpl->len = 0;
+    tmpl->slots = NULL;
+    tmpl->nb_slots = nb_slots;
+    tmpl->allocator = tree->allocator;
+
+    if ((ret = template_encode(tree, slots, nb_slots, params, tmpl)) != WBXML_OK) {
+        wbxml_template_destroy(tmpl);
+        tmpl = NULL;
+    }
+
+    *result = tmpl;
+
+    return ret;
+}
+
+
+WBXML_DECLARE(void) wbxml_template_destroy(WBXMLTemplate *tmpl)
+{
+    if (tmpl == NULL)
+        return;
+
+    wbxml_mem_free(tmpl->allocator, tmpl->data);
+    wbxml_mem_free(tmpl->allocator, tmpl->slots);
+    wbxml_mem_free(tmpl->allocator, tmpl);
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_template_get_nb_slots(WBXMLTemplate *tmpl)
+{
+    if (tmpl == NULL)
+        return 0;
+
+    return tmpl->nb_slots;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_template_fill_buffer(WBXMLTemplate *tmpl,
+                                                     const WBXMLTemplateValue *values,
+                                                     WBXMLBuffer *output)
+{
+    const WBXMLTemplateSlot *slot = NULL;
+    WB_ULONG total = 0, len = 0, pos = 0, i = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if ((tmpl == NULL) || ((tmpl->nb_slots > 0) && (values == NULL)) || (output == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    /* Check values, and compute document length */
+    total = tmpl->len;
+
+    for (i = 0; i < tmpl->nb_slots; i++) {
+        if ((ret = template_value_len(&values[i], &len)) != WBXML_OK)
+            return ret;
+
+        if (total + len < total)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        total += len;
+    }
+
+    /* The document is then copied without reallocation */
+    if (!wbxml_buffer_reserve(output, total))
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    /* Copy the document, and insert values between its parts */
+    for (i = 0; i < tmpl->nb_slots; i++) {
+        slot = &tmpl->slots[i];
+
+        if (!wbxml_buffer_append_data(output, tmpl->data + pos, slot->pos - pos) ||
+            !template_append_value(output, &values[slot->index]))
+        {
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        pos = slot->pos;
+    }
+
+    if (!wbxml_buffer_append_data(output, tmpl->data + pos, tmpl->len - pos))
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    return WBXML_OK;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_template_fill(WBXMLTemplate *tmpl,
+                                              const WBXMLTemplateValue *values,
+                                              WB_UTINY **wbxml,
+                                              WB_ULONG *wbxml_len)
+{
+    WBXMLBuffer *output = NULL;
+    WBXMLError ret = WBXML_OK;
+
+    if ((tmpl == NULL) || (wbxml == NULL) || (wbxml_len == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    *wbxml = NULL;
+    *wbxml_len = 0;
+
+    if ((output = wbxml_buffer_create_with_allocator(tmpl->allocator, (const WB_UTINY *) "", 0, 0)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    if ((ret = wbxml_template_fill_buffer(tmpl, values, output)) == WBXML_OK) {
+        if ((*wbxml = wbxml_buffer_detach(output, wbxml_len)) == NULL)
+            ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    wbxml_buffer_destroy(output);
+
+    return ret;
+}
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Encode a Template
+ * @param tree     The WBXML Tree to encode
+ * @param slots    The Text Nodes that are the Slots
+ * @param nb_slots Number of Slots
+ * @param params   Parameters (can be NULL)
+ * @param tmpl     The Template to fill
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError template_encode(WBXMLTree *tree,
+                                  WBXMLTreeNode **slots,
+                                  WB_ULONG nb_slots,
+                                  WBXMLGenWBXMLParams *params,
+                                  WBXMLTemplate *tmpl)
+{
+    WBXMLEncoder *encoder = NULL;
+    WB_ULONG *slots_pos = NULL;
+    WB_ULONG i = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if (nb_slots > 0) {
+        if ((nb_slots > WBXML_TEMPLATE_MAX_SLOTS) ||
+            ((slots_pos = wbxml_mem_malloc(tmpl->allocator, nb_slots * sizeof(WB_ULONG))) == NULL) ||
+            ((tmpl->slots = wbxml_mem_malloc(tmpl->allocator, nb_slots * sizeof(WBXMLTemplateSlot))) == NULL))
+        {
+            wbxml_mem_free(tmpl->allocator, slots_pos);
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+    }
+
+    if ((encoder = wbxml_encoder_create_with_allocator(tmpl->allocator)) == NULL) {
+        wbxml_mem_free(tmpl->allocator, slots_pos);
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    /* Set the WBXML Tree to encode */
+    wbxml_encoder_set_tree(encoder, tree);
+
+    /* Set encoder parameters, as wbxml_tree_to_wbxml() does */
+    if (params == NULL) {
+        /* Default Parameters */
+        wbxml_encoder_set_ignore_empty_text(encoder, TRUE);
+        wbxml_encoder_set_remove_text_blanks(encoder, TRUE);
+        wbxml_encoder_set_use_strtbl(encoder, TRUE);
+        wbxml_encoder_set_produce_anonymous(encoder, FALSE);
+    }
+    else {
+        wbxml_encoder_set_wbxml_version(encoder, params->wbxml_version);
+
+        if (!params->keep_ignorable_ws) {
+            wbxml_encoder_set_ignore_empty_text(encoder, TRUE);
+            wbxml_encoder_set_remove_text_blanks(encoder, TRUE);
+        }
+
+        wbxml_encoder_set_use_strtbl(encoder, params->use_strtbl);
+        wbxml_encoder_set_produce_anonymous(encoder, params->produce_anonymous);
+    }
+
+    /* Encode, but the Slots */
+    ret = wbxml_encoder_encode_tree_with_slots(encoder, slots, nb_slots, slots_pos, &tmpl->data, &tmpl->len);
+
+    wbxml_encoder_destroy(encoder);
+
+    if (ret == WBXML_OK) {
+        /* Sort Slots in document order (adjacent ones in the order they are given) */
+        for (i = 0; i < nb_slots; i++) {
+            tmpl->slots[i].pos = slots_pos[i];
+            tmpl->slots[i].index = i;
+        }
+
+        if (nb_slots > 1)
+            qsort(tmpl->slots, nb_slots, sizeof(WBXMLTemplateSlot), template_slot_compare);
+    }
+
+    wbxml_mem_free(tmpl->allocator, slots_pos);
+
+    return ret;
+}
+
+
+/**
+ * @brief Compare two Slots (for qsort())
+ * @param a The first Slot
+ * @param b The second Slot
+ * @return The difference of their positions (or of their indexes, at the same position)
+ */
+static int template_slot_compare(const void *a, const void *b)
+{
+    const WBXMLTemplateSlot *slot_a = (const WBXMLTemplateSlot *) a;
+    const WBXMLTemplateSlot *slot_b = (const WBXMLTemplateSlot *) b;
+
+    if (slot_a->pos != slot_b->pos)
+        return (slot_a->pos < slot_b->pos) ? -1 : 1;
+
+    if (slot_a->index != slot_b->index)
+        return (slot_a->index < slot_b->index) ? -1 : 1;
+
+    return 0;
+}
+
+
+/**
+ * @brief Get the length of a Multi-byte Integer
+ * @param value The integer
+ * @return The number of bytes of its mb_u_int32 encoding
+ */
+static WB_ULONG template_mb_uint_32_len(WB_ULONG value)
+{
+    WB_ULONG len = 1;
+
+    while (value > 0x7f) {
+        value >>= 7;
+        len++;
+    }
+
+    return len;
+}
+
+
+/**
+ * @brief Get the encoded length of a Slot value
+ * @param value The value
+ * @param len   [out] Its length, once encoded
+ * @return WBXML_OK if the value can be encoded, an error code otherwise
+ */
+static WBXMLError template_value_len(const WBXMLTemplateValue *value, WB_ULONG *len)
+{
+    if ((value->len > 0) && (value->data == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    if (value->opaque) {
+        /* OPAQUE length data */
+        *len = 1 + template_mb_uint_32_len(value->len) + value->len;
+    }
+    else {
+        /* An Inline String is NULL terminated */
+        if ((value->len > 0) && (memchr(value->data, WBXML_STR_END, value->len) != NULL))
+            return WBXML_ERROR_BAD_PARAMETER;
+
+        /* STR_I string NULL (nothing for an empty string) */
+        *len = (value->len > 0) ? value->len + 2 : 0;
+    }
+
+    if (*len < value->len)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Append an encoded Slot value to a Buffer
+ * @param output The Buffer
+ * @param value  The value (already checked)
+ * @return TRUE if appended, FALSE if not enough memory
+ */
+static WB_BOOL template_append_value(WBXMLBuffer *output, const WBXMLTemplateValue *value)
+{
+    if (value->opaque) {
+        return (wbxml_buffer_append_char(output, WBXML_OPAQUE) &&
+                wbxml_buffer_append_mb_uint_32(output, value->len) &&
+                wbxml_buffer_append_data(output, value->data, value->len));
+    }
+
+    if (value->len == 0)
+        return TRUE;
+
+    return (wbxml_buffer_append_char(output, WBXML_STR_I) &&
+            wbxml_buffer_append_data(output, value->data, value->len) &&
+            wbxml_buffer_append_char(output, WBXML_STR_END));
+}
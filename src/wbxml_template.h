@@ -0,0 +1,138 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_template.h
+ * @ingroup wbxml_template
+ *
+ * @date 26/10/17
+ *
+ * @brief WBXML Templates: documents encoded once, with values inserted in Slots
+ */
+
+#ifndef WBXML_TEMPLATE_H
+#define WBXML_TEMPLATE_H
+
+#include "wbxml.h"
+#include "wbxml_buffers.h"
+#include "wbxml_tree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wbxml_template
+ *  @{
+ */
+
+/**
+ * @brief WBXML Template
+ *
+ * A WBXML Tree is encoded once, but for some of its Text Nodes (the Slots): the Template is the
+ * resulting document, and the position of each Slot in it. A document is then built by copying
+ * the Template, and inserting a value at each Slot: the cost of it only depends on the size of
+ * values, the Tree is not encoded again.
+ */
+typedef struct WBXMLTemplate_s WBXMLTemplate;
+
+/**
+ * @brief Value of a Slot
+ */
+typedef struct WBXMLTemplateValue_s
+{
+    const WB_UTINY *data;   /**< Value (UTF-8, as the WBXML document) */
+    WB_ULONG        len;    /**< Value length */
+    WB_BOOL         opaque; /**< Encoded as Opaque Data (TRUE), or as an Inline String (FALSE) */
+} WBXMLTemplateValue;
+
+
+/**
+ * @brief Create a Template
+ * @param tree     [in]  The WBXML Tree to encode
+ * @param slots    [in]  The Text Nodes of Tree that are the Slots (their content is not used)
+ * @param nb_slots [in]  Number of Slots
+ * @param params   [in]  Parameters (if NULL, default values are used, cf wbxml_tree_to_wbxml())
+ * @param result   [out] The newly created Template
+ * @return WBXML_OK if no error, an error code otherwise (cf wbxml_encoder_encode_tree_with_slots())
+ * @note A Slot must be the only child of its Element, or the Element must not contain other Text
+ *       (adjacent Inline Strings are read as one text)
+ * @note The Tree is not modified, nor used anymore once the Template is created
+ */
+WBXML_DECLARE(WBXMLError) wbxml_template_create(WBXMLTree *tree,
+                                                WBXMLTreeNode **slots,
+                                                WB_ULONG nb_slots,
+                                                WBXMLGenWBXMLParams *params,
+                                                WBXMLTemplate **result);
+
+/**
+ * @brief Destroy a Template
+ * @param tmpl The Template to destroy
+ */
+WBXML_DECLARE(void) wbxml_template_destroy(WBXMLTemplate *tmpl);
+
+/**
+ * @brief Get the number of Slots of a Template
+ * @param tmpl The Template
+ * @return The number of Slots
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_template_get_nb_slots(WBXMLTemplate *tmpl);
+
+/**
+ * @brief Build a WBXML document from a Template, and append it to a Buffer
+ * @param tmpl   The Template
+ * @param values The value of each Slot (in the order Slots were given to wbxml_template_create())
+ * @param output The Buffer where the document is appended
+ * @return WBXML_OK if no error, an error code otherwise (the Buffer is then not modified)
+ * @note An Inline String can't contain a NULL char (WBXML_ERROR_BAD_PARAMETER): use Opaque Data for it
+ * @note An empty Inline String is not encoded
+ * @note The Buffer can be reused from one document to another: it then only grows to the size of the
+ *       biggest one
+ */
+WBXML_DECLARE(WBXMLError) wbxml_template_fill_buffer(WBXMLTemplate *tmpl,
+                                                     const WBXMLTemplateValue *values,
+                                                     WBXMLBuffer *output);
+
+/**
+ * @brief Build a WBXML document from a Template
+ * @param tmpl      [in]  The Template
+ * @param values    [in]  The value of each Slot (cf wbxml_template_fill_buffer())
+ * @param wbxml     [out] The resulting WBXML document
+ * @param wbxml_len [out] The resulting WBXML document length
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note The document is allocated with the Allocator of the Tree given to wbxml_template_create()
+ *       (cf wbxml_mem_free())
+ */
+WBXML_DECLARE(WBXMLError) wbxml_template_fill(WBXMLTemplate *tmpl,
+                                              const WBXMLTemplateValue *values,
+                                              WB_UTINY **wbxml,
+                                              WB_ULONG *wbxml_len);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WBXML_TEMPLATE_H */
@@ -42,6 +42,22 @@
 #include "wbxml_tree_clb_wbxml.h"
 #include "wbxml_internals.h"
 
+
+/***************************************************
+ *    Private Functions prototypes
+ */
+
+static WBXMLError tree_from_wbxml(WBXMLAllocator *allocator,
+                                  const WB_UTINY *wbxml,
+                                  WB_ULONG wbxml_len,
+                                  WBXMLLanguage lang,
+                                  WBXMLCharsetMIBEnum charset,
+                                  WBXMLTree **tree,
+                                  WB_BOOL borrow);
+static WBXMLTreeNode *tree_node_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLTreeNodeType type);
+static void tree_node_link(WBXMLArena *arena, WBXMLTreeNode *node);
+
+
 /***************************************************
  *    Public Functions
  */
@@ -52,77 +68,28 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml(WB_UTINY *wbxml,
                                                 WBXMLCharsetMIBEnum charset,
                                                 WBXMLTree **tree)
 {
-    WBXMLParser *wbxml_parser = NULL;
-#if defined( WBXML_LIB_VERBOSE )
-    WB_LONG error_index;
-#endif
-    WBXMLTreeClbCtx wbxml_tree_clb_ctx;
-    WBXMLError ret = WBXML_OK;
-    WBXMLContentHandler wbxml_tree_content_handler = 
-        {
-            wbxml_tree_clb_wbxml_start_document,
-            wbxml_tree_clb_wbxml_end_document,
-            wbxml_tree_clb_wbxml_start_element,
-            wbxml_tree_clb_wbxml_end_element,
-            wbxml_tree_clb_wbxml_characters,
-            wbxml_tree_clb_wbxml_pi
-        };
-
-    if (tree != NULL)
-        *tree = NULL;
-
-    /* Create WBXML Parser */
-    if((wbxml_parser = wbxml_parser_create()) == NULL) {
-        WBXML_ERROR((WBXML_PARSER, "Can't create WBXML Parser"));
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
-
-    /* Init context */
-    wbxml_tree_clb_ctx.error = WBXML_OK;
-    wbxml_tree_clb_ctx.current = NULL;
-    if ((wbxml_tree_clb_ctx.tree = wbxml_tree_create(WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN)) == NULL) {
-        wbxml_parser_destroy(wbxml_parser);
-        WBXML_ERROR((WBXML_PARSER, "Can't create WBXML Tree"));
-        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
-    }
-    
-    /* Set Handlers Callbacks */
-    wbxml_parser_set_user_data(wbxml_parser, &wbxml_tree_clb_ctx);
-    wbxml_parser_set_content_handler(wbxml_parser, &wbxml_tree_content_handler);
-
-    /* Give the user the possibility to force Document Language */
-    if (lang != WBXML_LANG_UNKNOWN)
-        wbxml_parser_set_language(wbxml_parser, lang);
+    return tree_from_wbxml(NULL, wbxml, wbxml_len, lang, charset, tree, FALSE);
+}
 
-    /* Give the user the possibility to force the document character set */
-    if (charset != WBXML_CHARSET_UNKNOWN)
-        wbxml_parser_set_meta_charset(wbxml_parser, charset);
 
-    /* Parse the WBXML document to WBXML Tree */
-    ret = wbxml_parser_parse(wbxml_parser, wbxml, wbxml_len);
-    if ((ret != WBXML_OK) || (wbxml_tree_clb_ctx.error != WBXML_OK)) 
-    {
-#if defined( WBXML_LIB_VERBOSE )
-        error_index = wbxml_parser_get_current_byte_index(wbxml_parser);
-        WBXML_ERROR((WBXML_PARSER, "WBXML Parser failed at %ld - token: %x (%s)", 
-                                   error_index,
-                                   wbxml[error_index],
-                                   ret != WBXML_OK ? wbxml_errors_string(ret) : wbxml_errors_string(wbxml_tree_clb_ctx.error)));
-#endif
-        
-        wbxml_tree_destroy(wbxml_tree_clb_ctx.tree);
-    }
-    else {
-        *tree = wbxml_tree_clb_ctx.tree;
-    }
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml_with_allocator(WBXMLAllocator *allocator,
+                                                               WB_UTINY *wbxml,
+                                                               WB_ULONG wbxml_len,
+                                                               WBXMLLanguage lang,
+                                                               WBXMLCharsetMIBEnum charset,
+                                                               WBXMLTree **tree)
+{
+    return tree_from_wbxml(allocator, wbxml, wbxml_len, lang, charset, tree, FALSE);
+}
 
-    /* Clean-up */
-    wbxml_parser_destroy(wbxml_parser);
 
-    if (ret != WBXML_OK)
-        return ret;
-    else
-        return wbxml_tree_clb_ctx.error;
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml_static(const WB_UTINY *wbxml,
+                                                       WB_ULONG wbxml_len,
+                                                       WBXMLLanguage lang,
+                                                       WBXMLCharsetMIBEnum charset,
+                                                       WBXMLTree **tree)
+{
+    return tree_from_wbxml(NULL, wbxml, wbxml_len, lang, charset, tree, TRUE);
 }
 
 
@@ -135,7 +102,7 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_to_wbxml(WBXMLTree *tree,
     WBXMLError ret = WBXML_OK;
 
     /* Encode WBXML Tree to WBXML Document */
-    if ((wbxml_encoder = wbxml_encoder_create()) == NULL) {
+    if ((wbxml_encoder = wbxml_encoder_create_with_allocator(tree->allocator)) == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
@@ -192,6 +159,15 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_to_wbxml(WBXMLTree *tree,
 
 
 WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml(WB_UTINY *xml, WB_ULONG xml_len, WBXMLTree **tree)
+{
+    return wbxml_tree_from_xml_with_allocator(NULL, xml, xml_len, tree);
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml_with_allocator(WBXMLAllocator *allocator,
+                                                             WB_UTINY *xml,
+                                                             WB_ULONG xml_len,
+                                                             WBXMLTree **tree)
 {
 #if defined( HAVE_EXPAT )
 
@@ -221,7 +197,7 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml(WB_UTINY *xml, WB_ULONG xml_len, W
     }
 
     /* Create Expat XML Parser */
-    if ((xml_parser = XML_ParserCreateNS(NULL, WBXML_NAMESPACE_SEPARATOR)) == NULL)
+    if ((xml_parser = wbxml_tree_clb_xml_parser_create()) == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
     /* Init context */
@@ -234,7 +210,7 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml(WB_UTINY *xml, WB_ULONG xml_len, W
     wbxml_tree_clb_ctx.expat_utf16 = expat_utf16;
 
     /* Create WBXML Tree */
-    if ((wbxml_tree_clb_ctx.tree = wbxml_tree_create(WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN)) == NULL) {
+    if ((wbxml_tree_clb_ctx.tree = wbxml_tree_create_in_arena_with_allocator(allocator, WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN)) == NULL) {
         XML_ParserFree(xml_parser);
         WBXML_ERROR((WBXML_PARSER, "Can't create WBXML Tree"));
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
@@ -311,7 +287,7 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_to_xml(WBXMLTree *tree,
     WBXMLError ret = WBXML_OK;
 
     /* Create WBXML Encoder */
-    if ((wbxml_encoder = wbxml_encoder_create()) == NULL) {
+    if ((wbxml_encoder = wbxml_encoder_create_with_allocator(tree->allocator)) == NULL) {
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
@@ -385,23 +361,19 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_to_libxml_doc(WBXMLTree *tree,
 
 WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create(WBXMLTreeNodeType type)
 {
-    WBXMLTreeNode *result = NULL;
-    
-    if ((result = wbxml_malloc(sizeof(WBXMLTreeNode))) == NULL)
-        return NULL;
+    return tree_node_create(NULL, NULL, type);
+}
 
-    result->type = type;
-    result->name = NULL;
-    result->attrs = NULL;
-    result->content = NULL;
-    result->tree = NULL;
 
-    result->parent = NULL;
-    result->children = NULL;
-    result->next = NULL;
-    result->prev = NULL;
+WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create_with_allocator(WBXMLAllocator *allocator, WBXMLTreeNodeType type)
+{
+    return tree_node_create(NULL, allocator, type);
+}
 
-    return result;
+
+WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create_in_arena(WBXMLArena *arena, WBXMLTreeNodeType type)
+{
+    return tree_node_create(arena, NULL, type);
 }
 
 
@@ -410,12 +382,19 @@ WBXML_DECLARE(void) wbxml_tree_node_destroy(WBXMLTreeNode *node)
     if (node == NULL)
         return;
 
+    if (node->arena != NULL) {
+        /* Node is released with its Arena, but an embedded Tree has its own memory */
+        wbxml_tree_destroy(node->tree);
+        node->tree = NULL;
+        return;
+    }
+
     wbxml_tag_destroy(node->name);
     wbxml_list_destroy(node->attrs, wbxml_attribute_destroy_item);
     wbxml_buffer_destroy(node->content);
     wbxml_tree_destroy(node->tree);
 
-    wbxml_free(node);
+    wbxml_mem_free(node->allocator, node);
 }
 
 
@@ -627,6 +606,9 @@ WBXML_DECLARE(WB_BOOL) wbxml_tree_node_add_child(WBXMLTreeNode *parent,
     /* Set parent to new node */
     node->parent = parent;    
 
+    /* Parent memory may be released with an Arena */
+    tree_node_link(parent->arena, node);
+
     /* Search for previous sibbling element */
     if (parent->children != NULL) {
         /* Add this Node to end of Sibbling Node list of Parent */
@@ -658,18 +640,29 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_node_add_attr(WBXMLTreeNode *node,
 
     /* Create list if needed */
     if (node->attrs == NULL) {
-        if ((node->attrs = wbxml_list_create()) == NULL) {
+        if (node->arena != NULL)
+            node->attrs = wbxml_list_create_in_arena(node->arena);
+        else
+            node->attrs = wbxml_list_create_with_allocator(node->allocator);
+
+        if (node->attrs == NULL) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
     }
 
     /* Duplicate Attribute */
-    if ((new_attr = wbxml_attribute_duplicate(attr)) == NULL)
+    if (node->arena != NULL)
+        new_attr = wbxml_attribute_duplicate_in_arena(node->arena, attr);
+    else
+        new_attr = wbxml_attribute_duplicate_with_allocator(node->allocator, attr);
+
+    if (new_attr == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     
     /* Add attribute to list */
     if (!wbxml_list_append(node->attrs, new_attr)) {
-        wbxml_attribute_destroy(attr);
+        if (node->arena == NULL)
+            wbxml_attribute_destroy(new_attr);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
@@ -708,36 +701,61 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_node_add_xml_attr(const WBXMLLangEntry *lan
 
     /* Create list if needed */
     if (node->attrs == NULL) {
-        if ((node->attrs = wbxml_list_create()) == NULL) {
+        if (node->arena != NULL)
+            node->attrs = wbxml_list_create_in_arena(node->arena);
+        else
+            node->attrs = wbxml_list_create_with_allocator(node->allocator);
+
+        if (node->attrs == NULL) {
             return WBXML_ERROR_NOT_ENOUGH_MEMORY;
         }
     }
 
     /* Create Attribute */
-    if ((attr = wbxml_attribute_create()) == NULL)
+    if (node->arena != NULL)
+        attr = wbxml_attribute_create_in_arena(node->arena);
+    else
+        attr = wbxml_attribute_create_with_allocator(node->allocator);
+
+    if (attr == NULL)
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
 
     /* Set Attribute Name */
-    if ((attr_entry = wbxml_tables_get_attr_from_xml(lang_table, (WB_UTINY *)name, (WB_UTINY *)value, NULL)) != NULL)
-        attr->name = wbxml_attribute_name_create_token(attr_entry);
-    else
-        attr->name = wbxml_attribute_name_create_literal((WB_UTINY *)name);
+    attr_entry = wbxml_tables_get_attr_from_xml(lang_table, (WB_UTINY *)name, (WB_UTINY *)value, NULL);
+    if (node->arena != NULL) {
+        if (attr_entry != NULL)
+            attr->name = wbxml_attribute_name_create_token_in_arena(node->arena, attr_entry);
+        else
+            attr->name = wbxml_attribute_name_create_literal_in_arena(node->arena, (WB_UTINY *)name);
+    }
+    else {
+        if (attr_entry != NULL)
+            attr->name = wbxml_attribute_name_create_token_with_allocator(node->allocator, attr_entry);
+        else
+            attr->name = wbxml_attribute_name_create_literal_with_allocator(node->allocator, (WB_UTINY *)name);
+    }
 
     if (attr->name == NULL) {
-        wbxml_attribute_destroy(attr);
+        if (node->arena == NULL)
+            wbxml_attribute_destroy(attr);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
     /* Set Attribute Value */
-    attr->value = wbxml_buffer_create_real(value, WBXML_STRLEN(value), WBXML_STRLEN(value));
+    if (node->arena != NULL)
+        attr->value = wbxml_buffer_create_in_arena(node->arena, value, WBXML_STRLEN(value));
+    else
+        attr->value = wbxml_buffer_create_with_allocator(node->allocator, value, WBXML_STRLEN(value), WBXML_STRLEN(value));
     if (attr->value == NULL) {
-        wbxml_attribute_destroy(attr);
+        if (node->arena == NULL)
+            wbxml_attribute_destroy(attr);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
     /* Add attribute to list */
     if (!wbxml_list_append(node->attrs, attr)) {
-        wbxml_attribute_destroy(attr);
+        if (node->arena == NULL)
+            wbxml_attribute_destroy(attr);
         return WBXML_ERROR_NOT_ENOUGH_MEMORY;
     }
 
@@ -973,16 +991,60 @@ WBXML_DECLARE(WBXMLList*) wbxml_tree_node_get_all_children(WBXMLTreeNode *node)
 
 WBXML_DECLARE(WBXMLTree *) wbxml_tree_create(WBXMLLanguage lang,
                                              WBXMLCharsetMIBEnum orig_charset)
+{
+    return wbxml_tree_create_with_allocator(NULL, lang, orig_charset);
+}
+
+
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_with_allocator(WBXMLAllocator *allocator,
+                                                            WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum orig_charset)
 {
     WBXMLTree *result = NULL;
     
-    if ((result = wbxml_malloc(sizeof(WBXMLTree))) == NULL)
+    if ((result = wbxml_mem_malloc(allocator, sizeof(WBXMLTree))) == NULL)
         return NULL;
 
     result->lang = wbxml_tables_get_table(lang);
     result->root = NULL;
     result->orig_charset = orig_charset;
     result->cur_code_page = 0;
+    result->arena = NULL;
+    result->allocator = allocator;
+
+    return result;
+}
+
+
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_in_arena(WBXMLLanguage lang,
+                                                      WBXMLCharsetMIBEnum orig_charset)
+{
+    return wbxml_tree_create_in_arena_with_allocator(NULL, lang, orig_charset);
+}
+
+
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_in_arena_with_allocator(WBXMLAllocator *allocator,
+                                                                     WBXMLLanguage lang,
+                                                                     WBXMLCharsetMIBEnum orig_charset)
+{
+    WBXMLArena *arena = NULL;
+    WBXMLTree *result = NULL;
+
+    if ((arena = wbxml_arena_create_with_allocator(allocator)) == NULL)
+        return NULL;
+
+    /* The Tree itself is released with its Arena */
+    if ((result = wbxml_arena_alloc(arena, sizeof(WBXMLTree))) == NULL) {
+        wbxml_arena_destroy(arena);
+        return NULL;
+    }
+
+    result->lang = wbxml_tables_get_table(lang);
+    result->root = NULL;
+    result->orig_charset = orig_charset;
+    result->cur_code_page = 0;
+    result->arena = arena;
+    result->allocator = allocator;
 
     return result;
 }
@@ -991,11 +1053,21 @@ WBXML_DECLARE(WBXMLTree *) wbxml_tree_create(WBXMLLanguage lang,
 WBXML_DECLARE(void) wbxml_tree_destroy(WBXMLTree *tree)
 {
     if (tree != NULL) {
-        /* Destroy root node and all its children */
-        wbxml_tree_node_destroy_all(tree->root);
+        if (tree->arena != NULL) {
+            /* Only malloced Nodes (and embedded Trees) must be freed one by one */
+            if (wbxml_arena_has_foreign(tree->arena))
+                wbxml_tree_node_destroy_all(tree->root);
 
-        /* Free tree */
-        wbxml_free(tree);
+            /* Free tree, and all the nodes allocated with it */
+            wbxml_arena_destroy(tree->arena);
+        }
+        else {
+            /* Destroy root node and all its children */
+            wbxml_tree_node_destroy_all(tree->root);
+
+            /* Free tree */
+            wbxml_mem_free(tree->allocator, tree);
+        }
     }
 }
 
@@ -1011,6 +1083,9 @@ WBXML_DECLARE(WB_BOOL) wbxml_tree_add_node(WBXMLTree *tree, WBXMLTreeNode *paren
     /* Set parent to new node */
     node->parent = parent;    
 
+    /* Tree memory may be released with an Arena */
+    tree_node_link(tree->arena, node);
+
     /* Check if this is the Root Element */
     if (parent != NULL) {
         /* This is not the Root Element... search for previous sibbling element */
@@ -1120,12 +1195,17 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_elt(WBXMLTree *tree,
     WBXMLTreeNode *node = NULL;
 
     /* Create a new Node */
-    if ((node = wbxml_tree_node_create(WBXML_TREE_ELEMENT_NODE)) == NULL) {
+    if ((node = tree_node_create(tree->arena, tree->allocator, WBXML_TREE_ELEMENT_NODE)) == NULL) {
         return NULL;
     }
 
     /* Set Element */
-    if ((node->name = wbxml_tag_duplicate(tag)) == NULL) {
+    if (tree->arena != NULL)
+        node->name = wbxml_tag_duplicate_in_arena(tree->arena, tag);
+    else
+        node->name = wbxml_tag_duplicate_with_allocator(tree->allocator, tag);
+
+    if (node->name == NULL) {
         wbxml_tree_node_destroy(node);
         return NULL;
     }
@@ -1204,11 +1284,17 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_xml_elt(WBXMLTree *tree,
         tree->cur_code_page = tag_entry->wbxmlCodePage;
 
         /* Found : token tag */
-        tag = wbxml_tag_create_token(tag_entry);
+        if (tree->arena != NULL)
+            tag = wbxml_tag_create_token_in_arena(tree->arena, tag_entry);
+        else
+            tag = wbxml_tag_create_token_with_allocator(tree->allocator, tag_entry);
     }
     else {
         /* Not found : literal tag */
-        tag = wbxml_tag_create_literal(element_name);
+        if (tree->arena != NULL)
+            tag = wbxml_tag_create_literal_in_arena(tree->arena, element_name);
+        else
+            tag = wbxml_tag_create_literal_with_allocator(tree->allocator, element_name);
     }
 
     if (sep != NULL) {
@@ -1220,8 +1306,9 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_xml_elt(WBXMLTree *tree,
         return NULL;
 
     /* Create a new Node */
-    if ((node = wbxml_tree_node_create(WBXML_TREE_ELEMENT_NODE)) == NULL) {
-        wbxml_tag_destroy(tag);
+    if ((node = tree_node_create(tree->arena, tree->allocator, WBXML_TREE_ELEMENT_NODE)) == NULL) {
+        if (tree->arena == NULL)
+            wbxml_tag_destroy(tag);
         return NULL;
     }
     
@@ -1274,12 +1361,17 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_text(WBXMLTree *tree,
     WBXMLTreeNode *node = NULL;
 
     /* Create a new Node */
-    if ((node = wbxml_tree_node_create(WBXML_TREE_TEXT_NODE)) == NULL) {
+    if ((node = tree_node_create(tree->arena, tree->allocator, WBXML_TREE_TEXT_NODE)) == NULL) {
         return NULL;
     }
 
     /* Set Content */
-    if ((node->content = wbxml_buffer_create(text, len, len)) == NULL) {
+    if (tree->arena != NULL)
+        node->content = wbxml_buffer_create_in_arena(tree->arena, text, len);
+    else
+        node->content = wbxml_buffer_create_with_allocator(tree->allocator, text, len, len);
+
+    if (node->content == NULL) {
         wbxml_tree_node_destroy(node);
         return NULL;
     }
@@ -1301,7 +1393,7 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_cdata(WBXMLTree *tree,
     WBXMLTreeNode *node = NULL;
 
     /* Create a new Node */
-    if ((node = wbxml_tree_node_create(WBXML_TREE_CDATA_NODE)) == NULL) {
+    if ((node = tree_node_create(tree->arena, tree->allocator, WBXML_TREE_CDATA_NODE)) == NULL) {
         return NULL;
     }
 
@@ -1326,7 +1418,7 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_tree(WBXMLTree *tree,
     WBXMLTreeNode *node = NULL;
 
     /* Create a new Node */
-    if ((node = wbxml_tree_node_create(WBXML_TREE_TREE_NODE)) == NULL) {        
+    if ((node = tree_node_create(tree->arena, tree->allocator, WBXML_TREE_TREE_NODE)) == NULL) {        
         return NULL;
     }
 
@@ -1339,6 +1431,10 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_tree(WBXMLTree *tree,
     /* Set Tree */
     node->tree = new_tree;
 
+    /* Embedded Tree must be destroyed with this Tree */
+    if (tree->arena != NULL)
+        wbxml_arena_add_foreign(tree->arena);
+
     return node;
 }
 
@@ -1367,3 +1463,161 @@ WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_add_xml_elt_with_attrs_and_text(WBXMLT
     
     return new_node;
 }
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Parse a WBXML document, and construct a WBXML Tree
+ * @param allocator [in]  The Allocator of the Tree and of the Parser (NULL to use the default one)
+ * @param wbxml     [in]  The WBXML document to parse
+ * @param wbxml_len [in]  The WBXML document length
+ * @param lang      [in]  Language to force (WBXML_LANG_UNKNOWN if none)
+ * @param charset   [in]  Charset to use if not found in document (WBXML_CHARSET_UNKNOWN if none)
+ * @param tree      [out] The resulting WBXML Tree
+ * @param borrow    [in]  If TRUE, the parser reads directly from 'wbxml' instead of a copy
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError tree_from_wbxml(WBXMLAllocator *allocator,
+                                  const WB_UTINY *wbxml,
+                                  WB_ULONG wbxml_len,
+                                  WBXMLLanguage lang,
+                                  WBXMLCharsetMIBEnum charset,
+                                  WBXMLTree **tree,
+                                  WB_BOOL borrow)
+{
+    WBXMLParser *wbxml_parser = NULL;
+#if defined( WBXML_LIB_VERBOSE )
+    WB_LONG error_index;
+#endif
+    WBXMLTreeClbCtx wbxml_tree_clb_ctx;
+    WBXMLError ret = WBXML_OK;
+    WBXMLContentHandler wbxml_tree_content_handler = 
+        {
+            wbxml_tree_clb_wbxml_start_document,
+            wbxml_tree_clb_wbxml_end_document,
+            wbxml_tree_clb_wbxml_start_element,
+            wbxml_tree_clb_wbxml_end_element,
+            wbxml_tree_clb_wbxml_characters,
+            wbxml_tree_clb_wbxml_pi
+        };
+
+    if (tree != NULL)
+        *tree = NULL;
+
+    /* Create WBXML Parser */
+    if((wbxml_parser = wbxml_parser_create_with_allocator(allocator)) == NULL) {
+        WBXML_ERROR((WBXML_PARSER, "Can't create WBXML Parser"));
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    /* Init context */
+    wbxml_tree_clb_ctx.error = WBXML_OK;
+    wbxml_tree_clb_ctx.current = NULL;
+    if ((wbxml_tree_clb_ctx.tree = wbxml_tree_create_in_arena_with_allocator(allocator, WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN)) == NULL) {
+        wbxml_parser_destroy(wbxml_parser);
+        WBXML_ERROR((WBXML_PARSER, "Can't create WBXML Tree"));
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+    
+    /* Set Handlers Callbacks */
+    wbxml_parser_set_user_data(wbxml_parser, &wbxml_tree_clb_ctx);
+    wbxml_parser_set_content_handler(wbxml_parser, &wbxml_tree_content_handler);
+
+    /* Give the user the possibility to force Document Language */
+    if (lang != WBXML_LANG_UNKNOWN)
+        wbxml_parser_set_language(wbxml_parser, lang);
+
+    /* Give the user the possibility to force the document character set */
+    if (charset != WBXML_CHARSET_UNKNOWN)
+        wbxml_parser_set_meta_charset(wbxml_parser, charset);
+
+    /* Text Nodes copy the content they are given */
+    wbxml_parser_set_borrowed_content(wbxml_parser, TRUE);
+
+    /* Parse the WBXML document to WBXML Tree */
+    if (borrow)
+        ret = wbxml_parser_parse_static(wbxml_parser, wbxml, wbxml_len);
+    else
+        ret = wbxml_parser_parse(wbxml_parser, (WB_UTINY *) wbxml, wbxml_len);
+    if ((ret != WBXML_OK) || (wbxml_tree_clb_ctx.error != WBXML_OK)) 
+    {
+#if defined( WBXML_LIB_VERBOSE )
+        error_index = wbxml_parser_get_current_byte_index(wbxml_parser);
+        WBXML_ERROR((WBXML_PARSER, "WBXML Parser failed at %ld - token: %x (%s)", 
+                                   error_index,
+                                   wbxml[error_index],
+                                   ret != WBXML_OK ? wbxml_errors_string(ret) : wbxml_errors_string(wbxml_tree_clb_ctx.error)));
+#endif
+        
+        wbxml_tree_destroy(wbxml_tree_clb_ctx.tree);
+    }
+    else {
+        *tree = wbxml_tree_clb_ctx.tree;
+    }
+
+    /* Clean-up */
+    wbxml_parser_destroy(wbxml_parser);
+
+    if (ret != WBXML_OK)
+        return ret;
+    else
+        return wbxml_tree_clb_ctx.error;
+}
+
+
+/**
+ * @brief Create a Tree Node structure
+ * @param arena     The Arena where the Node is allocated (NULL to use the Allocator)
+ * @param allocator The Allocator of the Node if there is no Arena (NULL to use the default one)
+ * @param type      Node type
+ * @return The newly created Tree Node, or NULL if not enough memory
+ */
+static WBXMLTreeNode *tree_node_create(WBXMLArena *arena, WBXMLAllocator *allocator, WBXMLTreeNodeType type)
+{
+    WBXMLTreeNode *result = NULL;
+
+    if (arena != NULL) {
+        result = wbxml_arena_alloc(arena, sizeof(WBXMLTreeNode));
+
+        /* Objects that the Node owns are allocated with the Allocator of its Arena */
+        allocator = wbxml_arena_get_allocator(arena);
+    }
+    else
+        result = wbxml_mem_malloc(allocator, sizeof(WBXMLTreeNode));
+
+    if (result == NULL)
+        return NULL;
+
+    result->type = type;
+    result->name = NULL;
+    result->attrs = NULL;
+    result->content = NULL;
+    result->tree = NULL;
+
+    result->parent = NULL;
+    result->children = NULL;
+    result->next = NULL;
+    result->prev = NULL;
+
+    result->arena = arena;
+    result->allocator = allocator;
+
+    return result;
+}
+
+
+/**
+ * @brief Check a Tree Node that is linked to Nodes allocated in an Arena
+ * @param arena The Arena of the Tree (or parent Node) where the Node is linked (can be NULL)
+ * @param node  The linked Tree Node
+ * @note If the Node is not allocated in this Arena, it will have to be freed on its
+ *       own: the Tree can't be released by only destroying its Arena.
+ */
+static void tree_node_link(WBXMLArena *arena, WBXMLTreeNode *node)
+{
+    if ((arena != NULL) && ((node->arena != arena) || (node->tree != NULL)))
+        wbxml_arena_add_foreign(arena);
+}
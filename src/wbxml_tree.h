@@ -82,6 +82,9 @@ typedef struct WBXMLTreeNode_s
     struct WBXMLTreeNode_s  *children;  /**< Children Node */
     struct WBXMLTreeNode_s  *next;      /**< Next sibling Node */
     struct WBXMLTreeNode_s  *prev;      /**< Previous sibling Node */
+
+    WBXMLArena          *arena;     /**< Arena where this Node is allocated (NULL if malloced) */
+    WBXMLAllocator      *allocator; /**< Allocator of this Node, and of what it owns (NULL if default one is used) */
 } WBXMLTreeNode;
 
 
@@ -97,6 +100,7 @@ typedef struct WBXMLTreeNode_s
  *   - orig_charset: the original charset encoding of the parsed document
  *
  * @note All the strings inside the WBXML Tree are encoded into UTF-8
+ * @note A parsed Tree is built in an Arena (cf wbxml_tree_create_in_arena())
  */
 typedef struct WBXMLTree_s
 {    
@@ -104,6 +108,8 @@ typedef struct WBXMLTree_s
     WBXMLTreeNode        *root;         /**< Root Element */
     WBXMLCharsetMIBEnum   orig_charset; /**< Charset encoding of original document */
     WB_UTINY              cur_code_page;/**< Last seen code page */
+    WBXMLArena           *arena;        /**< Arena where this Tree and its Nodes are allocated (NULL if malloced) */
+    WBXMLAllocator       *allocator;    /**< Allocator of this Tree (NULL if default one is used) */
 } WBXMLTree;
 
 
@@ -161,6 +167,40 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml(WB_UTINY *wbxml,
                                                 WBXMLCharsetMIBEnum charset,
                                                 WBXMLTree **tree);
 
+/**
+ * @brief Parse a WBXML document, and construct a WBXML Tree with an Allocator
+ * @param allocator [in]  The Allocator of the Tree (NULL to use the default one)
+ * @param wbxml     [in]  The WBXML document to parse
+ * @param wbxml_len [in]  The WBXML document length
+ * @param lang      [in]  Can be used to force parsing of a given Language (set it to WBXML_LANG_UNKNOWN if you don't want to force anything)
+ * @param tree      [out] The resulting WBXML Tree
+ * @result Return WBXML_OK if no error, an error code otherwise
+ * @note The Parser used to build the Tree is created with the same Allocator
+ */
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml_with_allocator(WBXMLAllocator *allocator,
+                                                               WB_UTINY *wbxml,
+                                                               WB_ULONG wbxml_len,
+                                                               WBXMLLanguage lang,
+                                                               WBXMLCharsetMIBEnum charset,
+                                                               WBXMLTree **tree);
+
+/**
+ * @brief Parse a WBXML document without copying it, and construct a WBXML Tree
+ * @param wbxml     [in]  The WBXML document to parse
+ * @param wbxml_len [in]  The WBXML document length
+ * @param lang      [in]  Can be used to force parsing of a given Language (set it to WBXML_LANG_UNKNOWN if you don't want to force anything)
+ * @param tree      [out] The resulting WBXML Tree
+ * @result Return WBXML_OK if no error, an error code otherwise
+ * @note Same as wbxml_tree_from_wbxml(), but the document is parsed with wbxml_parser_parse_static().
+ *       The 'wbxml' memory must stay valid and unmodified until this function returns.
+ *       The resulting Tree holds its own copies of all data, so 'wbxml' can be released afterwards.
+ */
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml_static(const WB_UTINY *wbxml,
+                                                       WB_ULONG wbxml_len,
+                                                       WBXMLLanguage lang,
+                                                       WBXMLCharsetMIBEnum charset,
+                                                       WBXMLTree **tree);
+
 /**
  * @brief Convert a WBXML Tree to a WBXML document
  * @param tree      [in]  The WBXML Tree to convert
@@ -168,6 +208,8 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_wbxml(WB_UTINY *wbxml,
  * @param wbxml_len [out] The resulting WBXML document length
  * @param params    [in]  Parameters (if NULL, default values are used)
  * @result Return WBXML_OK if no error, an error code otherwise
+ * @note The Tree is not modified: it can be converted at the same time by several threads
+ * @note The document is allocated with the Allocator of the Tree (cf wbxml_mem_free())
  */
 WBXML_DECLARE(WBXMLError) wbxml_tree_to_wbxml(WBXMLTree *tree,
                                               WB_UTINY **wbxml,
@@ -186,6 +228,21 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml(WB_UTINY *xml,
                                               WB_ULONG xml_len,
                                               WBXMLTree **tree);
 
+/**
+ * @brief Parse an XML document, and construct a WBXML Tree with an Allocator
+ * @param allocator [in]  The Allocator of the Tree (NULL to use the default one)
+ * @param xml       [in]  The XML document to parse
+ * @param xml_len   [in]  Length of the XML document
+ * @param tree      [out] The resulting WBXML Tree
+ * @result Return WBXML_OK if no error, an error code otherwise
+ * @note Needs 'HAVE_EXPAT' compile flag
+ * @note Expat has no context in its memory functions: its own memory comes from the default Allocator
+ */
+WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml_with_allocator(WBXMLAllocator *allocator,
+                                                             WB_UTINY *xml,
+                                                             WB_ULONG xml_len,
+                                                             WBXMLTree **tree);
+
 /**
  * @brief Convert a WBXML Tree to an XML document
  * @param tree    [in]  The WBXML Tree to convert
@@ -193,6 +250,8 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_from_xml(WB_UTINY *xml,
  * @param xml_len [out] The resulting XML document length
  * @param params  [in]  Parameters (if NULL, default values are used)
  * @result Return WBXML_OK if no error, an error code otherwise
+ * @note The Tree is not modified: it can be converted at the same time by several threads
+ * @note The document is allocated with the Allocator of the Tree (cf wbxml_mem_free())
  */
 WBXML_DECLARE(WBXMLError) wbxml_tree_to_xml(WBXMLTree *tree,
                                             WB_UTINY **xml,
@@ -236,10 +295,30 @@ WBXML_DECLARE(WBXMLError) wbxml_tree_to_libxml_doc(WBXMLTree *tree,
  */
 WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create(WBXMLTreeNodeType type);
 
+/**
+ * @brief Create a Tree Node structure with an Allocator
+ * @param allocator The Allocator of the Node (NULL to use the default one)
+ * @param type      Node type
+ * @return The newly created Tree Node, or NULL if not enough memory
+ * @note The Node, and the attributes added to it, are freed with this Allocator: it can be
+ *       added to a Tree that uses another one.
+ */
+WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create_with_allocator(WBXMLAllocator *allocator, WBXMLTreeNodeType type);
+
+/**
+ * @brief Create a Tree Node structure in an Arena
+ * @param arena The Arena where the Node is allocated (NULL to use malloc)
+ * @param type  Node type
+ * @return The newly created Tree Node, or NULL if not enough memory
+ * @note The Node must only be linked to a Tree whose Nodes are allocated in the same Arena
+ */
+WBXML_DECLARE(WBXMLTreeNode *) wbxml_tree_node_create_in_arena(WBXMLArena *arena, WBXMLTreeNodeType type);
+
 /**
  * @brief Destroy a Tree Node structure
  * @param node The Tree Node structure to destroy
  * @note The Node is freed, but not extracted from its WBXML Tree (use wbxml_tree_extract_node() before)
+ * @note A Node allocated in an Arena is not freed: it is released with its Tree
  */
 WBXML_DECLARE(void) wbxml_tree_node_destroy(WBXMLTreeNode *node);
 
@@ -418,6 +497,47 @@ WBXML_DECLARE(WBXMLList*) wbxml_tree_node_get_all_children(WBXMLTreeNode *node);
 WBXML_DECLARE(WBXMLTree *) wbxml_tree_create(WBXMLLanguage lang,
                                              WBXMLCharsetMIBEnum orig_charset);
 
+/**
+ * @brief Create a Tree structure with an Allocator
+ * @param allocator The Allocator of the Tree (NULL to use the default one)
+ * @param lang Tree Language
+ * @param orig_charset Original tree charset
+ * @return The newly created Tree, or NULL if not enough memory
+ * @note The Nodes added with the wbxml_tree_add_*() functions are allocated with this
+ *       Allocator. A Node created on its own keeps its Allocator when it is added.
+ */
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_with_allocator(WBXMLAllocator *allocator,
+                                                            WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum orig_charset);
+
+/**
+ * @brief Create a Tree structure, whose Nodes are allocated in an Arena
+ * @param lang Tree Language
+ * @param orig_charset Original tree charset
+ * @return The newly created Tree, or NULL if not enough memory
+ * @note The Nodes added with the wbxml_tree_add_*() functions (with their names, attributes
+ *       and contents) are taken from big blocks, and wbxml_tree_destroy() releases these
+ *       blocks without walking the Tree.
+ * @note Nodes created with wbxml_tree_node_create_*() can still be added to this Tree: they
+ *       are then freed one by one by wbxml_tree_destroy().
+ * @warning A Node of this Tree must not be moved to another Tree, nor be used after
+ *          the Tree is destroyed.
+ */
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_in_arena(WBXMLLanguage lang,
+                                                      WBXMLCharsetMIBEnum orig_charset);
+
+/**
+ * @brief Create a Tree structure, whose Nodes are allocated in an Arena with an Allocator
+ * @param allocator The Allocator of the Arena (NULL to use the default one)
+ * @param lang Tree Language
+ * @param orig_charset Original tree charset
+ * @return The newly created Tree, or NULL if not enough memory
+ * @note Same as wbxml_tree_create_in_arena(), but the blocks of the Arena come from 'allocator'
+ */
+WBXML_DECLARE(WBXMLTree *) wbxml_tree_create_in_arena_with_allocator(WBXMLAllocator *allocator,
+                                                                     WBXMLLanguage lang,
+                                                                     WBXMLCharsetMIBEnum orig_charset);
+
 /**
  * @brief Destroy a Tree structure, and all its nodes
  * @param tree The Tree structure to destroy
@@ -44,6 +44,22 @@
 #include "wbxml_charset.h"
 #include "wbxml_base64.h"
 
+/************************************
+ *  Private Functions prototypes
+ */
+
+static void *clb_xml_malloc(size_t size);
+static void *clb_xml_realloc(void *ptr, size_t size);
+static void clb_xml_free(void *ptr);
+
+/** Expat Memory Handling Suite */
+static const XML_Memory_Handling_Suite clb_xml_memsuite = {
+    clb_xml_malloc,
+    clb_xml_realloc,
+    clb_xml_free
+};
+
+
 /************************************
  *  Public Functions
  */
@@ -263,9 +279,10 @@ void wbxml_tree_clb_xml_end_element(void           *ctx,
 		const WBXMLLangEntry *lang;
 
                 /* Get embedded DevInf or DM DDF Document */
-                embed_doc = wbxml_buffer_create(tree_ctx->input_buff + tree_ctx->skip_start, 
-                                                 XML_GetCurrentByteIndex(tree_ctx->xml_parser) - tree_ctx->skip_start,
-                                                 XML_GetCurrentByteIndex(tree_ctx->xml_parser) - tree_ctx->skip_start + 10);
+                embed_doc = wbxml_buffer_create_with_allocator(tree_ctx->tree->allocator,
+                                                               tree_ctx->input_buff + tree_ctx->skip_start, 
+                                                               XML_GetCurrentByteIndex(tree_ctx->xml_parser) - tree_ctx->skip_start,
+                                                               XML_GetCurrentByteIndex(tree_ctx->xml_parser) - tree_ctx->skip_start + 10);
                 if (embed_doc == NULL) {
                     tree_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
                     wbxml_buffer_destroy(embed_doc);
@@ -340,9 +357,10 @@ void wbxml_tree_clb_xml_end_element(void           *ctx,
                 WBXML_DEBUG((WBXML_PARSER, "\t Embedded Doc : '%s'", wbxml_buffer_get_cstr(embed_doc)));
 
                 /* Parse 'DevInf' Document */
-                if ((ret = wbxml_tree_from_xml(wbxml_buffer_get_cstr(embed_doc),
-                                               wbxml_buffer_len(embed_doc),
-                                               &tree)) != WBXML_OK)
+                if ((ret = wbxml_tree_from_xml_with_allocator(tree_ctx->tree->allocator,
+                                                              wbxml_buffer_get_cstr(embed_doc),
+                                                              wbxml_buffer_len(embed_doc),
+                                                              &tree)) != WBXML_OK)
                 {
                     tree_ctx->error = ret;
                     wbxml_buffer_destroy(embed_doc);
@@ -598,7 +616,10 @@ void wbxml_tree_clb_xml_characters(void           *ctx,
         WBXML_DEBUG((WBXML_PARSER, "    Binary tag: Caching base64 encoded data for later conversion."));
         if (node->content == NULL)
         {
-            node->content = wbxml_buffer_create(ch, len, 1);
+            if (node->arena != NULL)
+                node->content = wbxml_buffer_create_in_arena(node->arena, ch, len);
+            else
+                node->content = wbxml_buffer_create_with_allocator(node->allocator, ch, len, len);
             if (node->content == NULL)
                 tree_ctx->error = WBXML_ERROR_NOT_ENOUGH_MEMORY;
         } else {
@@ -640,4 +661,34 @@ void wbxml_tree_clb_xml_pi(void           *ctx,
     /** @todo wbxml2xml_clb_pi() */
 }
 
+
+XML_Parser wbxml_tree_clb_xml_parser_create(void)
+{
+    return XML_ParserCreate_MM(NULL, &clb_xml_memsuite, WBXML_NAMESPACE_SEPARATOR_STR);
+}
+
+
+/************************************
+ *  Private Functions
+ */
+
+/* Expat needs functions with its own calling convention: wbxml_malloc() and friends may not have it */
+
+static void *clb_xml_malloc(size_t size)
+{
+    return wbxml_malloc(size);
+}
+
+
+static void *clb_xml_realloc(void *ptr, size_t size)
+{
+    return wbxml_realloc(ptr, size);
+}
+
+
+static void clb_xml_free(void *ptr)
+{
+    wbxml_free(ptr);
+}
+
 #endif /* HAVE_EXPAT */
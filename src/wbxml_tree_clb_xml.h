@@ -115,6 +115,13 @@ void wbxml_tree_clb_xml_characters(void *ctx, const XML_Char *ch, int len);
  */
 void wbxml_tree_clb_xml_pi(void *ctx, const XML_Char *target, const XML_Char *data);
 
+/**
+ * @brief Create an Expat Parser with Namespace processing
+ * @return The new Expat Parser, or NULL if not enough memory
+ * @note The memory of Expat Parser is allocated with wbxml_malloc(), so with the default Allocator
+ */
+XML_Parser wbxml_tree_clb_xml_parser_create(void);
+
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,822 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_tree_compact.c
+ * @ingroup wbxml_tree_compact
+ *
+ * @date 26/10/17
+ *
+ * @brief Compact WBXML Tree: Nodes in arrays, linked by indexes
+ */
+
+#include "wbxml_tree_compact.h"
+#include "wbxml_internals.h"
+
+/** Number of Nodes (or Attributes) allocated the first time */
+#define WBXML_COMPACT_FIRST_SIZE 16
+
+/** Size of the first block of strings pool */
+#define WBXML_COMPACT_POOL_BLOCK 256
+
+
+/* Private functions prototypes */
+static WB_ULONG compact_add_node(WBXMLCompactTree *tree, WB_ULONG parent, WBXMLTreeNodeType type);
+static WB_ULONG compact_add_attr(WBXMLCompactTree *tree, WB_ULONG node);
+static WB_ULONG compact_add_str(WBXMLCompactTree *tree, const WB_UTINY *str, WB_ULONG len);
+static WB_ULONG compact_do_add_xml_elt(WBXMLCompactTree *tree, WB_ULONG parent, const WB_UTINY *name);
+static WBXMLError compact_do_add_xml_attr(WBXMLCompactTree *tree,
+                                          WB_ULONG node,
+                                          const WB_UTINY *name,
+                                          const WB_UTINY *value);
+static WBXMLError compact_add_tree_node(WBXMLCompactTree *ctree,
+                                        WB_ULONG parent,
+                                        WBXMLTreeNode *node,
+                                        WB_ULONG *index);
+static WBXMLError compact_do_to_tree(WBXMLCompactTree *ctree, WBXMLTree **tree);
+static WBXMLTreeNode *compact_create_tree_node(WBXMLCompactTree *ctree, WBXMLArena *arena, WB_ULONG index);
+
+
+/***************************************************
+ *    Public Functions
+ */
+
+WBXML_DECLARE(WBXMLCompactTree *) wbxml_compact_tree_create(WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum orig_charset)
+{
+    WBXMLCompactTree *result = NULL;
+
+    if ((result = wbxml_malloc(sizeof(WBXMLCompactTree))) == NULL)
+        return NULL;
+
+    if ((result->pool = wbxml_buffer_create("", 0, WBXML_COMPACT_POOL_BLOCK)) == NULL) {
+        wbxml_free(result);
+        return NULL;
+    }
+
+    result->lang = wbxml_tables_get_table(lang);
+    result->orig_charset = orig_charset;
+    result->nodes = NULL;
+    result->nb_nodes = 0;
+    result->nodes_size = 0;
+    result->attrs = NULL;
+    result->nb_attrs = 0;
+    result->attrs_size = 0;
+    result->root = WBXML_COMPACT_NONE;
+    result->allocator = wbxml_mem_get_allocator();
+
+    return result;
+}
+
+
+WBXML_DECLARE(void) wbxml_compact_tree_destroy(WBXMLCompactTree *tree)
+{
+
+    if (tree == NULL)
+        return;
+
+    wbxml_free(tree->nodes);
+    wbxml_free(tree->attrs);
+    wbxml_buffer_destroy(tree->pool);
+    wbxml_free(tree);
+}
+
+
+WBXML_DECLARE(const WB_UTINY *) wbxml_compact_tree_get_str(WBXMLCompactTree *tree, WB_ULONG offset)
+{
+    if ((tree == NULL) || (offset == WBXML_COMPACT_NONE) || (offset >= wbxml_buffer_len(tree->pool)))
+        return NULL;
+
+    return wbxml_buffer_get_cstr(tree->pool) + offset;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_elt(WBXMLCompactTree *tree,
+                                                   WB_ULONG parent,
+                                                   const WBXMLTagEntry *tag)
+{
+    WB_ULONG index = WBXML_COMPACT_NONE;
+
+    if ((tree == NULL) || (tag == NULL))
+        return WBXML_COMPACT_NONE;
+
+    if ((index = compact_add_node(tree, parent, WBXML_TREE_ELEMENT_NODE)) != WBXML_COMPACT_NONE)
+        tree->nodes[index].tag = tag;
+
+    return index;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_literal_elt(WBXMLCompactTree *tree,
+                                                           WB_ULONG parent,
+                                                           const WB_UTINY *name)
+{
+    WB_ULONG index = WBXML_COMPACT_NONE;
+    WB_ULONG offset = 0;
+
+    if ((tree == NULL) || (name == NULL))
+        return WBXML_COMPACT_NONE;
+
+    /* Add the name first: the Node is not added if there is no memory for it */
+    if ((offset = compact_add_str(tree, name, WBXML_STRLEN(name))) != WBXML_COMPACT_NONE) {
+        if ((index = compact_add_node(tree, parent, WBXML_TREE_ELEMENT_NODE)) != WBXML_COMPACT_NONE)
+            tree->nodes[index].name = offset;
+    }
+
+    return index;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_xml_elt(WBXMLCompactTree *tree,
+                                                       WB_ULONG parent,
+                                                       const WB_UTINY *name)
+{
+    WB_ULONG index = WBXML_COMPACT_NONE;
+
+    if ((tree == NULL) || (name == NULL))
+        return WBXML_COMPACT_NONE;
+
+    index = compact_do_add_xml_elt(tree, parent, name);
+
+    return index;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_attr(WBXMLCompactTree *tree,
+                                                      WB_ULONG node,
+                                                      const WBXMLAttrEntry *attr,
+                                                      const WB_UTINY *value,
+                                                      WB_ULONG value_len)
+{
+    WB_ULONG offset = 0, index = 0;
+    WBXMLError ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    if ((tree == NULL) || (attr == NULL) || (node >= tree->nb_nodes) ||
+        (tree->nodes[node].type != WBXML_TREE_ELEMENT_NODE))
+    {
+        return WBXML_ERROR_BAD_PARAMETER;
+    }
+
+    if ((offset = compact_add_str(tree, value, value_len)) != WBXML_COMPACT_NONE) {
+        if ((index = compact_add_attr(tree, node)) != WBXML_COMPACT_NONE) {
+            tree->attrs[index].attr = attr;
+            tree->attrs[index].value = offset;
+            tree->attrs[index].value_len = value_len;
+            ret = WBXML_OK;
+        }
+    }
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_literal_attr(WBXMLCompactTree *tree,
+                                                              WB_ULONG node,
+                                                              const WB_UTINY *name,
+                                                              const WB_UTINY *value,
+                                                              WB_ULONG value_len)
+{
+    WB_ULONG name_offset = 0, value_offset = 0, index = 0;
+    WBXMLError ret = WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    if ((tree == NULL) || (name == NULL) || (node >= tree->nb_nodes) ||
+        (tree->nodes[node].type != WBXML_TREE_ELEMENT_NODE))
+    {
+        return WBXML_ERROR_BAD_PARAMETER;
+    }
+
+    if (((name_offset = compact_add_str(tree, name, WBXML_STRLEN(name))) != WBXML_COMPACT_NONE) &&
+        ((value_offset = compact_add_str(tree, value, value_len)) != WBXML_COMPACT_NONE) &&
+        ((index = compact_add_attr(tree, node)) != WBXML_COMPACT_NONE))
+    {
+        tree->attrs[index].name = name_offset;
+        tree->attrs[index].value = value_offset;
+        tree->attrs[index].value_len = value_len;
+        ret = WBXML_OK;
+    }
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_xml_attr(WBXMLCompactTree *tree,
+                                                          WB_ULONG node,
+                                                          const WB_UTINY *name,
+                                                          const WB_UTINY *value)
+{
+    WBXMLError ret = WBXML_OK;
+
+    if ((tree == NULL) || (name == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    ret = compact_do_add_xml_attr(tree, node, name, value);
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_text(WBXMLCompactTree *tree,
+                                                    WB_ULONG parent,
+                                                    const WB_UTINY *text,
+                                                    WB_ULONG len)
+{
+    WB_ULONG index = WBXML_COMPACT_NONE;
+    WB_ULONG offset = 0;
+
+    if ((tree == NULL) || (parent == WBXML_COMPACT_NONE))
+        return WBXML_COMPACT_NONE;
+
+    if ((offset = compact_add_str(tree, text, len)) != WBXML_COMPACT_NONE) {
+        if ((index = compact_add_node(tree, parent, WBXML_TREE_TEXT_NODE)) != WBXML_COMPACT_NONE) {
+            tree->nodes[index].text = offset;
+            tree->nodes[index].text_len = len;
+        }
+    }
+
+    return index;
+}
+
+
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_cdata(WBXMLCompactTree *tree, WB_ULONG parent)
+{
+    WB_ULONG index = WBXML_COMPACT_NONE;
+
+    if ((tree == NULL) || (parent == WBXML_COMPACT_NONE))
+        return WBXML_COMPACT_NONE;
+
+    index = compact_add_node(tree, parent, WBXML_TREE_CDATA_NODE);
+
+    return index;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_from_tree(WBXMLTree *tree, WBXMLCompactTree **ctree)
+{
+    WBXMLCompactTree *result = NULL;
+    WBXMLTreeNode *node = NULL;
+    WB_ULONG parent = WBXML_COMPACT_NONE;
+    WB_ULONG index = WBXML_COMPACT_NONE;
+    WBXMLError ret = WBXML_OK;
+
+    if ((tree == NULL) || (ctree == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    *ctree = NULL;
+
+    /* The Compact Tree gets the Allocator of the Tree */
+    result = wbxml_compact_tree_create(WBXML_LANG_UNKNOWN, tree->orig_charset);
+
+    if (result == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    result->lang = tree->lang;
+
+    /* Walk the Tree in document order: a Node is always added after its parent and previous sibling */
+    node = tree->root;
+
+    while (node != NULL) {
+        if ((ret = compact_add_tree_node(result, parent, node, &index)) != WBXML_OK)
+            break;
+
+        if (node->children != NULL) {
+            /* Go down */
+            parent = index;
+            node = node->children;
+            continue;
+        }
+
+        /* Go up, until a Node with a next sibling is found */
+        while ((node != NULL) && (node->next == NULL)) {
+            node = node->parent;
+            index = result->nodes[index].parent;
+        }
+
+        if (node != NULL) {
+            parent = result->nodes[index].parent;
+            node = node->next;
+        }
+    }
+
+    if (ret != WBXML_OK) {
+        wbxml_compact_tree_destroy(result);
+        return ret;
+    }
+
+    *ctree = result;
+
+    return WBXML_OK;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_tree(WBXMLCompactTree *ctree, WBXMLTree **tree)
+{
+    WBXMLError ret = WBXML_OK;
+
+    if ((ctree == NULL) || (tree == NULL))
+        return WBXML_ERROR_BAD_PARAMETER;
+
+    ret = compact_do_to_tree(ctree, tree);
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_wbxml(WBXMLCompactTree *tree,
+                                                      WB_UTINY **wbxml,
+                                                      WB_ULONG  *wbxml_len,
+                                                      WBXMLGenWBXMLParams *params)
+{
+    WBXMLTree *wbxml_tree = NULL;
+    WBXMLError ret = WBXML_OK;
+
+    if ((ret = wbxml_compact_tree_to_tree(tree, &wbxml_tree)) != WBXML_OK)
+        return ret;
+
+    ret = wbxml_tree_to_wbxml(wbxml_tree, wbxml, wbxml_len, params);
+
+    wbxml_tree_destroy(wbxml_tree);
+
+    return ret;
+}
+
+
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_xml(WBXMLCompactTree *tree,
+                                                    WB_UTINY **xml,
+                                                    WB_ULONG  *xml_len,
+                                                    WBXMLGenXMLParams *params)
+{
+    WBXMLTree *wbxml_tree = NULL;
+    WBXMLError ret = WBXML_OK;
+
+    if ((ret = wbxml_compact_tree_to_tree(tree, &wbxml_tree)) != WBXML_OK)
+        return ret;
+
+    ret = wbxml_tree_to_xml(wbxml_tree, xml, xml_len, params);
+
+    wbxml_tree_destroy(wbxml_tree);
+
+    return ret;
+}
+
+
+/***************************************************
+ *    Private Functions
+ */
+
+/**
+ * @brief Add a Node to a Compact Tree
+ * @param tree   The Compact Tree
+ * @param parent Parent Node (WBXML_COMPACT_NONE to add the Root Element)
+ * @param type   Node Type
+ * @return The index of the new Node (appended to children of parent), or WBXML_COMPACT_NONE if error
+ */
+static WB_ULONG compact_add_node(WBXMLCompactTree *tree, WB_ULONG parent, WBXMLTreeNodeType type)
+{
+    WBXMLCompactNode *nodes = NULL;
+    WBXMLCompactNode *node = NULL;
+    WB_ULONG new_size = 0;
+    WB_ULONG index = 0;
+
+    if (parent == WBXML_COMPACT_NONE) {
+        /* Only one Root Element */
+        if ((tree->root != WBXML_COMPACT_NONE) || (type != WBXML_TREE_ELEMENT_NODE))
+            return WBXML_COMPACT_NONE;
+    }
+    else {
+        /* Text has no children */
+        if ((parent >= tree->nb_nodes) || (tree->nodes[parent].type == WBXML_TREE_TEXT_NODE))
+            return WBXML_COMPACT_NONE;
+    }
+
+    if (tree->nb_nodes == tree->nodes_size) {
+        if (tree->nodes_size == 0)
+            new_size = WBXML_COMPACT_FIRST_SIZE;
+        else
+            new_size = tree->nodes_size * 2;
+
+        /* Indexes must stay below WBXML_COMPACT_NONE */
+        if ((new_size <= tree->nodes_size) || (new_size > WBXML_COMPACT_NONE / sizeof(WBXMLCompactNode)))
+            return WBXML_COMPACT_NONE;
+
+        if ((nodes = wbxml_realloc(tree->nodes, new_size * sizeof(WBXMLCompactNode))) == NULL)
+            return WBXML_COMPACT_NONE;
+
+        tree->nodes = nodes;
+        tree->nodes_size = new_size;
+    }
+
+    index = tree->nb_nodes++;
+    node = &tree->nodes[index];
+
+    node->type = type;
+    node->tag = NULL;
+    node->name = WBXML_COMPACT_NONE;
+    node->parent = parent;
+    node->children = WBXML_COMPACT_NONE;
+    node->last = WBXML_COMPACT_NONE;
+    node->next = WBXML_COMPACT_NONE;
+    node->prev = WBXML_COMPACT_NONE;
+    node->attrs = WBXML_COMPACT_NONE;
+    node->last_attr = WBXML_COMPACT_NONE;
+    node->text = WBXML_COMPACT_NONE;
+    node->text_len = 0;
+
+    if (parent == WBXML_COMPACT_NONE) {
+        tree->root = index;
+        return index;
+    }
+
+    /* Append to children of parent */
+    node->prev = tree->nodes[parent].last;
+
+    if (node->prev != WBXML_COMPACT_NONE)
+        tree->nodes[node->prev].next = index;
+    else
+        tree->nodes[parent].children = index;
+
+    tree->nodes[parent].last = index;
+
+    return index;
+}
+
+
+/**
+ * @brief Add an Attribute to an Element of a Compact Tree
+ * @param tree The Compact Tree
+ * @param node The Element (already checked)
+ * @return The index of the new Attribute (appended to attributes of Element), or WBXML_COMPACT_NONE if error
+ */
+static WB_ULONG compact_add_attr(WBXMLCompactTree *tree, WB_ULONG node)
+{
+    WBXMLCompactAttr *attrs = NULL;
+    WBXMLCompactAttr *attr = NULL;
+    WB_ULONG new_size = 0;
+    WB_ULONG index = 0;
+
+    if (tree->nb_attrs == tree->attrs_size) {
+        if (tree->attrs_size == 0)
+            new_size = WBXML_COMPACT_FIRST_SIZE;
+        else
+            new_size = tree->attrs_size * 2;
+
+        if ((new_size <= tree->attrs_size) || (new_size > WBXML_COMPACT_NONE / sizeof(WBXMLCompactAttr)))
+            return WBXML_COMPACT_NONE;
+
+        if ((attrs = wbxml_realloc(tree->attrs, new_size * sizeof(WBXMLCompactAttr))) == NULL)
+            return WBXML_COMPACT_NONE;
+
+        tree->attrs = attrs;
+        tree->attrs_size = new_size;
+    }
+
+    index = tree->nb_attrs++;
+    attr = &tree->attrs[index];
+
+    attr->attr = NULL;
+    attr->name = WBXML_COMPACT_NONE;
+    attr->value = WBXML_COMPACT_NONE;
+    attr->value_len = 0;
+    attr->next = WBXML_COMPACT_NONE;
+
+    if (tree->nodes[node].last_attr != WBXML_COMPACT_NONE)
+        tree->attrs[tree->nodes[node].last_attr].next = index;
+    else
+        tree->nodes[node].attrs = index;
+
+    tree->nodes[node].last_attr = index;
+
+    return index;
+}
+
+
+/**
+ * @brief Add a string to the pool of a Compact Tree
+ * @param tree The Compact Tree
+ * @param str  The string (can be NULL if 'len' is 0)
+ * @param len  The string length
+ * @return The offset of string in pool, or WBXML_COMPACT_NONE if not enough memory
+ */
+static WB_ULONG compact_add_str(WBXMLCompactTree *tree, const WB_UTINY *str, WB_ULONG len)
+{
+    WB_ULONG offset = wbxml_buffer_len(tree->pool);
+
+    if ((len > 0) && (str == NULL))
+        return WBXML_COMPACT_NONE;
+
+    if ((offset + len + 1 <= offset) || (offset + len + 1 >= WBXML_COMPACT_NONE))
+        return WBXML_COMPACT_NONE;
+
+    if (!wbxml_buffer_append_data(tree->pool, str, len) ||
+        !wbxml_buffer_append_char(tree->pool, '\0'))
+    {
+        return WBXML_COMPACT_NONE;
+    }
+
+    return offset;
+}
+
+
+/**
+ * @brief Add an Element to a Compact Tree, given its XML name
+ * @param tree   The Compact Tree
+ * @param parent Parent Node
+ * @param name   XML name of Element (can be prefixed by a namespace)
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ */
+static WB_ULONG compact_do_add_xml_elt(WBXMLCompactTree *tree, WB_ULONG parent, const WB_UTINY *name)
+{
+    const WBXMLTagEntry *tag_entry = NULL;
+    const WB_UTINY *sep = NULL;
+    WB_UTINY *namespace_name = NULL;
+    int code_page = -1;
+
+    /* Search in the code page of parent first */
+    if ((parent < tree->nb_nodes) && (tree->nodes[parent].tag != NULL))
+        code_page = tree->nodes[parent].tag->wbxmlCodePage;
+
+    /* Or in the code page of namespace */
+    sep = (const WB_UTINY *) strrchr((const WB_TINY *) name, WBXML_NAMESPACE_SEPARATOR);
+    if ((sep != NULL) && (tree->lang != NULL)) {
+        if ((namespace_name = (WB_UTINY *) wbxml_strdup((const WB_TINY *) name)) == NULL)
+            return WBXML_COMPACT_NONE;
+
+        namespace_name[sep - name] = '\0';
+        code_page = wbxml_tables_get_code_page(tree->lang->nsTable, (const WB_TINY *) namespace_name);
+        wbxml_free(namespace_name);
+    }
+
+    if (sep != NULL)
+        name = sep + 1;
+
+    if ((tree->lang != NULL) &&
+        ((tag_entry = wbxml_tables_get_tag_from_xml(tree->lang, code_page, name)) != NULL))
+    {
+        /* Found : token tag */
+        return wbxml_compact_tree_add_elt(tree, parent, tag_entry);
+    }
+
+    /* Not found : literal tag */
+    return wbxml_compact_tree_add_literal_elt(tree, parent, name);
+}
+
+
+/**
+ * @brief Add an Attribute to an Element of a Compact Tree, given its XML name and value
+ * @param tree  The Compact Tree
+ * @param node  The Element
+ * @param name  XML name of Attribute
+ * @param value XML value of Attribute (can be NULL)
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError compact_do_add_xml_attr(WBXMLCompactTree *tree,
+                                          WB_ULONG node,
+                                          const WB_UTINY *name,
+                                          const WB_UTINY *value)
+{
+    const WBXMLAttrEntry *attr_entry = NULL;
+    WB_ULONG value_len = 0;
+
+    if (value != NULL)
+        value_len = WBXML_STRLEN(value);
+
+    if ((tree->lang != NULL) &&
+        ((attr_entry = wbxml_tables_get_attr_from_xml(tree->lang, (WB_UTINY *) name, (WB_UTINY *) value, NULL)) != NULL))
+    {
+        return wbxml_compact_tree_add_attr(tree, node, attr_entry, value, value_len);
+    }
+
+    return wbxml_compact_tree_add_literal_attr(tree, node, name, value, value_len);
+}
+
+
+/**
+ * @brief Add a copy of a WBXML Tree Node to a Compact Tree
+ * @param ctree  The Compact Tree
+ * @param parent Parent Node in Compact Tree
+ * @param node   The WBXML Tree Node (its children are not added)
+ * @param index  [out] Index of the new Node
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError compact_add_tree_node(WBXMLCompactTree *ctree,
+                                        WB_ULONG parent,
+                                        WBXMLTreeNode *node,
+                                        WB_ULONG *index)
+{
+    WBXMLAttribute *attr = NULL;
+    WB_ULONG i = 0, nb = 0;
+    WBXMLError ret = WBXML_OK;
+
+    switch (node->type) {
+    case WBXML_TREE_ELEMENT_NODE:
+        if (node->name == NULL)
+            return WBXML_ERROR_BAD_PARAMETER;
+
+        if (node->name->type == WBXML_VALUE_TOKEN)
+            *index = wbxml_compact_tree_add_elt(ctree, parent, node->name->u.token);
+        else
+            *index = wbxml_compact_tree_add_literal_elt(ctree, parent, wbxml_buffer_get_cstr(node->name->u.literal));
+
+        if (*index == WBXML_COMPACT_NONE)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+        nb = wbxml_list_len(node->attrs);
+
+        for (i = 0; i < nb; i++) {
+            attr = (WBXMLAttribute *) wbxml_list_get(node->attrs, i);
+
+            if (attr->name->type == WBXML_VALUE_TOKEN)
+                ret = wbxml_compact_tree_add_attr(ctree, *index, attr->name->u.token,
+                                                  wbxml_buffer_get_cstr(attr->value),
+                                                  wbxml_buffer_len(attr->value));
+            else
+                ret = wbxml_compact_tree_add_literal_attr(ctree, *index,
+                                                          wbxml_buffer_get_cstr(attr->name->u.literal),
+                                                          wbxml_buffer_get_cstr(attr->value),
+                                                          wbxml_buffer_len(attr->value));
+
+            if (ret != WBXML_OK)
+                return ret;
+        }
+        break;
+
+    case WBXML_TREE_TEXT_NODE:
+        *index = wbxml_compact_tree_add_text(ctree, parent,
+                                             wbxml_buffer_get_cstr(node->content),
+                                             wbxml_buffer_len(node->content));
+        if (*index == WBXML_COMPACT_NONE)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        break;
+
+    case WBXML_TREE_CDATA_NODE:
+        if ((*index = wbxml_compact_tree_add_cdata(ctree, parent)) == WBXML_COMPACT_NONE)
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        break;
+
+    default:
+        /* Embedded Trees and PIs are not handled */
+        return WBXML_ERROR_XML_NODE_NOT_ALLOWED;
+    }
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Convert a Compact Tree to a WBXML Tree
+ * @param ctree The Compact Tree to convert
+ * @param tree  [out] The resulting WBXML Tree
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+static WBXMLError compact_do_to_tree(WBXMLCompactTree *ctree, WBXMLTree **tree)
+{
+    WBXMLTree *result = NULL;
+    WBXMLTreeNode **map = NULL;
+    WBXMLTreeNode *node = NULL;
+    WBXMLCompactNode *cnode = NULL;
+    WB_ULONG i = 0;
+
+    *tree = NULL;
+
+    if ((result = wbxml_tree_create_in_arena(WBXML_LANG_UNKNOWN, ctree->orig_charset)) == NULL)
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+
+    result->lang = ctree->lang;
+
+    if (ctree->nb_nodes == 0) {
+        *tree = result;
+        return WBXML_OK;
+    }
+
+    /* Tree Node of each index */
+    if ((map = wbxml_malloc(ctree->nb_nodes * sizeof(WBXMLTreeNode *))) == NULL) {
+        wbxml_tree_destroy(result);
+        return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+    }
+
+    /* A Node always comes after its parent and its previous sibling */
+    for (i = 0; i < ctree->nb_nodes; i++) {
+        if ((node = compact_create_tree_node(ctree, result->arena, i)) == NULL) {
+            wbxml_free(map);
+            wbxml_tree_destroy(result);
+            return WBXML_ERROR_NOT_ENOUGH_MEMORY;
+        }
+
+        map[i] = node;
+        cnode = &ctree->nodes[i];
+
+        if (cnode->parent == WBXML_COMPACT_NONE) {
+            result->root = node;
+            continue;
+        }
+
+        node->parent = map[cnode->parent];
+
+        if (cnode->prev != WBXML_COMPACT_NONE) {
+            node->prev = map[cnode->prev];
+            node->prev->next = node;
+        }
+        else
+            node->parent->children = node;
+    }
+
+    wbxml_free(map);
+
+    *tree = result;
+
+    return WBXML_OK;
+}
+
+
+/**
+ * @brief Create a WBXML Tree Node (not linked) from a Compact Tree Node
+ * @param ctree The Compact Tree
+ * @param arena The Arena where the Node is allocated
+ * @param index Index of Compact Tree Node
+ * @return The new Tree Node, or NULL if not enough memory
+ */
+static WBXMLTreeNode *compact_create_tree_node(WBXMLCompactTree *ctree, WBXMLArena *arena, WB_ULONG index)
+{
+    WBXMLCompactNode *cnode = &ctree->nodes[index];
+    WBXMLCompactAttr *cattr = NULL;
+    WBXMLTreeNode *node = NULL;
+    WBXMLAttribute *attr = NULL;
+    WB_ULONG i = 0;
+
+    if ((node = wbxml_tree_node_create_in_arena(arena, cnode->type)) == NULL)
+        return NULL;
+
+    switch (cnode->type) {
+    case WBXML_TREE_ELEMENT_NODE:
+        if (cnode->tag != NULL)
+            node->name = wbxml_tag_create_token_in_arena(arena, cnode->tag);
+        else
+            node->name = wbxml_tag_create_literal_in_arena(arena, (WB_UTINY *) wbxml_compact_tree_get_str(ctree, cnode->name));
+
+        if (node->name == NULL)
+            return NULL;
+
+        if (cnode->attrs == WBXML_COMPACT_NONE)
+            break;
+
+        if ((node->attrs = wbxml_list_create_in_arena(arena)) == NULL)
+            return NULL;
+
+        for (i = cnode->attrs; i != WBXML_COMPACT_NONE; i = cattr->next) {
+            cattr = &ctree->attrs[i];
+
+            if ((attr = wbxml_attribute_create_in_arena(arena)) == NULL)
+                return NULL;
+
+            if (cattr->attr != NULL)
+                attr->name = wbxml_attribute_name_create_token_in_arena(arena, cattr->attr);
+            else
+                attr->name = wbxml_attribute_name_create_literal_in_arena(arena, (WB_UTINY *) wbxml_compact_tree_get_str(ctree, cattr->name));
+
+            if (attr->name == NULL)
+                return NULL;
+
+            attr->value = wbxml_buffer_create_in_arena(arena,
+                                                       wbxml_compact_tree_get_str(ctree, cattr->value),
+                                                       cattr->value_len);
+
+            if ((attr->value == NULL) || !wbxml_list_append(node->attrs, attr))
+                return NULL;
+        }
+        break;
+
+    case WBXML_TREE_TEXT_NODE:
+        node->content = wbxml_buffer_create_in_arena(arena,
+                                                     wbxml_compact_tree_get_str(ctree, cnode->text),
+                                                     cnode->text_len);
+        if (node->content == NULL)
+            return NULL;
+        break;
+
+    default:
+        break;
+    }
+
+    return node;
+}
@@ -0,0 +1,299 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_tree_compact.h
+ * @ingroup wbxml_tree_compact
+ *
+ * @date 26/10/17
+ *
+ * @brief Compact WBXML Tree: Nodes in arrays, linked by indexes
+ */
+
+#ifndef WBXML_TREE_COMPACT_H
+#define WBXML_TREE_COMPACT_H
+
+#include "wbxml.h"
+#include "wbxml_tree.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/** @addtogroup wbxml_tree_compact
+ *  @{
+ */
+
+
+/****************************************************
+ *	Compact WBXML Tree Structures
+ */
+
+/** No Node, no Attribute, or no String */
+#define WBXML_COMPACT_NONE 0xFFFFFFFF
+
+/**
+ * @brief Compact WBXML Tree Node
+ * @note All the links are indexes in the 'nodes' and 'attrs' arrays of the Tree, and all the
+ *       strings are offsets in its 'pool'
+ */
+typedef struct WBXMLCompactNode_s
+{
+    WBXMLTreeNodeType    type;      /**< Node Type (Element, Text or CDATA) */
+    const WBXMLTagEntry *tag;       /**< Token Tag (if type is 'WBXML_TREE_ELEMENT_NODE', NULL if Literal Tag) */
+    WB_ULONG             name;      /**< Literal Tag Name (if 'tag' is NULL) */
+    WB_ULONG             parent;    /**< Parent Node */
+    WB_ULONG             children;  /**< First Child Node */
+    WB_ULONG             last;      /**< Last Child Node */
+    WB_ULONG             next;      /**< Next sibling Node */
+    WB_ULONG             prev;      /**< Previous sibling Node */
+    WB_ULONG             attrs;     /**< First Attribute */
+    WB_ULONG             last_attr; /**< Last Attribute */
+    WB_ULONG             text;      /**< Content (if type is 'WBXML_TREE_TEXT_NODE') */
+    WB_ULONG             text_len;  /**< Content length */
+} WBXMLCompactNode;
+
+/**
+ * @brief Compact WBXML Tree Attribute
+ */
+typedef struct WBXMLCompactAttr_s
+{
+    const WBXMLAttrEntry *attr;      /**< Token Attribute Name (NULL if Literal Attribute Name) */
+    WB_ULONG              name;      /**< Literal Attribute Name (if 'attr' is NULL) */
+    WB_ULONG              value;     /**< Full Attribute Value */
+    WB_ULONG              value_len; /**< Attribute Value length */
+    WB_ULONG              next;      /**< Next Attribute of the same Node */
+} WBXMLCompactAttr;
+
+/**
+ * @brief Compact WBXML Tree structure
+ *
+ * It holds the same documents as a WBXMLTree (but embedded Trees and PIs), with all its Nodes
+ * in one array, all its Attributes in another one, and all its strings in one buffer: building
+ * it, and walking it, only touches a few memory blocks.
+ *
+ * @note Strings in 'pool' are NULL terminated
+ */
+typedef struct WBXMLCompactTree_s
+{
+    const WBXMLLangEntry *lang;         /**< Language Table */
+    WBXMLCharsetMIBEnum   orig_charset; /**< Charset encoding of original document */
+    WBXMLCompactNode     *nodes;        /**< Nodes */
+    WB_ULONG              nb_nodes;     /**< Number of Nodes */
+    WB_ULONG              nodes_size;   /**< Number of allocated Nodes */
+    WBXMLCompactAttr     *attrs;        /**< Attributes */
+    WB_ULONG              nb_attrs;     /**< Number of Attributes */
+    WB_ULONG              attrs_size;   /**< Number of allocated Attributes */
+    WBXMLBuffer          *pool;         /**< Strings */
+    WB_ULONG              root;         /**< Root Element */
+    WBXMLAllocator       *allocator;    /**< Allocator of this Tree (NULL if default one is used) */
+} WBXMLCompactTree;
+
+
+/****************************************************
+ *	Compact WBXML Tree Functions
+ */
+
+/**
+ * @brief Create a Compact Tree
+ * @param lang Tree Language
+ * @param orig_charset Original tree charset
+ * @return The newly created Compact Tree, or NULL if not enough memory
+ * @note The Tree keeps the Allocator in use (cf wbxml_mem_use_allocator())
+ */
+WBXML_DECLARE(WBXMLCompactTree *) wbxml_compact_tree_create(WBXMLLanguage lang,
+                                                            WBXMLCharsetMIBEnum orig_charset);
+
+/**
+ * @brief Destroy a Compact Tree
+ * @param tree The Compact Tree to destroy
+ */
+WBXML_DECLARE(void) wbxml_compact_tree_destroy(WBXMLCompactTree *tree);
+
+/**
+ * @brief Get a string of a Compact Tree
+ * @param tree   The Compact Tree
+ * @param offset Offset of string in Tree pool
+ * @return The string, or NULL if 'offset' is WBXML_COMPACT_NONE
+ * @note The string is only valid until another string is added to the Tree
+ */
+WBXML_DECLARE(const WB_UTINY *) wbxml_compact_tree_get_str(WBXMLCompactTree *tree, WB_ULONG offset);
+
+/**
+ * @brief Add a Token Element to a Compact Tree
+ * @param tree   The Compact Tree
+ * @param parent Parent Node (WBXML_COMPACT_NONE to add the Root Element)
+ * @param tag    Tag Entry of Element
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_elt(WBXMLCompactTree *tree,
+                                                   WB_ULONG parent,
+                                                   const WBXMLTagEntry *tag);
+
+/**
+ * @brief Add a Literal Element to a Compact Tree
+ * @param tree   The Compact Tree
+ * @param parent Parent Node (WBXML_COMPACT_NONE to add the Root Element)
+ * @param name   Element name
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_literal_elt(WBXMLCompactTree *tree,
+                                                           WB_ULONG parent,
+                                                           const WB_UTINY *name);
+
+/**
+ * @brief Add an Element to a Compact Tree, given its XML name
+ * @param tree   The Compact Tree
+ * @param parent Parent Node (WBXML_COMPACT_NONE to add the Root Element)
+ * @param name   XML name of Element
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ * @note The Element is a Token Element if its name is found in the Language Table
+ *       (the code page of parent is searched first), a Literal Element otherwise
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_xml_elt(WBXMLCompactTree *tree,
+                                                       WB_ULONG parent,
+                                                       const WB_UTINY *name);
+
+/**
+ * @brief Add a Token Attribute to an Element of a Compact Tree
+ * @param tree      The Compact Tree
+ * @param node      The Element
+ * @param attr      Attribute Entry
+ * @param value     Full Attribute Value (its start can be given by Attribute Entry)
+ * @param value_len Attribute Value length
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_attr(WBXMLCompactTree *tree,
+                                                      WB_ULONG node,
+                                                      const WBXMLAttrEntry *attr,
+                                                      const WB_UTINY *value,
+                                                      WB_ULONG value_len);
+
+/**
+ * @brief Add a Literal Attribute to an Element of a Compact Tree
+ * @param tree      The Compact Tree
+ * @param node      The Element
+ * @param name      Attribute name
+ * @param value     Attribute Value
+ * @param value_len Attribute Value length
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_literal_attr(WBXMLCompactTree *tree,
+                                                              WB_ULONG node,
+                                                              const WB_UTINY *name,
+                                                              const WB_UTINY *value,
+                                                              WB_ULONG value_len);
+
+/**
+ * @brief Add an Attribute to an Element of a Compact Tree, given its XML name and value
+ * @param tree  The Compact Tree
+ * @param node  The Element
+ * @param name  XML name of Attribute
+ * @param value XML value of Attribute
+ * @return WBXML_OK if no error, an error code otherwise
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_add_xml_attr(WBXMLCompactTree *tree,
+                                                          WB_ULONG node,
+                                                          const WB_UTINY *name,
+                                                          const WB_UTINY *value);
+
+/**
+ * @brief Add a Text Node to a Compact Tree
+ * @param tree   The Compact Tree
+ * @param parent Parent Node
+ * @param text   Text
+ * @param len    Text length
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_text(WBXMLCompactTree *tree,
+                                                    WB_ULONG parent,
+                                                    const WB_UTINY *text,
+                                                    WB_ULONG len);
+
+/**
+ * @brief Add a CDATA Node to a Compact Tree
+ * @param tree   The Compact Tree
+ * @param parent Parent Node
+ * @return The index of the new Node, or WBXML_COMPACT_NONE if error
+ * @note The content of CDATA is given by the Text Nodes added to it
+ */
+WBXML_DECLARE(WB_ULONG) wbxml_compact_tree_add_cdata(WBXMLCompactTree *tree, WB_ULONG parent);
+
+/**
+ * @brief Convert a WBXML Tree to a Compact Tree
+ * @param tree  [in]  The WBXML Tree to convert
+ * @param ctree [out] The resulting Compact Tree
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note Trees with embedded Trees or PIs can't be converted (WBXML_ERROR_XML_NODE_NOT_ALLOWED)
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_from_tree(WBXMLTree *tree, WBXMLCompactTree **ctree);
+
+/**
+ * @brief Convert a Compact Tree to a WBXML Tree
+ * @param ctree [in]  The Compact Tree to convert
+ * @param tree  [out] The resulting WBXML Tree
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note The WBXML Tree is built in an Arena (cf wbxml_tree_create_in_arena()), and its Nodes
+ *       are linked without searching the last child of their parent
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_tree(WBXMLCompactTree *ctree, WBXMLTree **tree);
+
+/**
+ * @brief Convert a Compact Tree to a WBXML document
+ * @param tree      [in]  The Compact Tree to convert
+ * @param wbxml     [out] The resulting WBXML document
+ * @param wbxml_len [out] The resulting WBXML document length
+ * @param params    [in]  Parameters (if NULL, default values are used)
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note Same parameters as wbxml_tree_to_wbxml()
+ * @note The Compact Tree is first expanded to a WBXML Tree (cf wbxml_compact_tree_to_tree())
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_wbxml(WBXMLCompactTree *tree,
+                                                      WB_UTINY **wbxml,
+                                                      WB_ULONG  *wbxml_len,
+                                                      WBXMLGenWBXMLParams *params);
+
+/**
+ * @brief Convert a Compact Tree to an XML document
+ * @param tree    [in]  The Compact Tree to convert
+ * @param xml     [out] The resulting XML document
+ * @param xml_len [out] The resulting XML document length
+ * @param params  [in]  Parameters (if NULL, default values are used)
+ * @return WBXML_OK if no error, an error code otherwise
+ * @note Same parameters as wbxml_tree_to_xml()
+ * @note The Compact Tree is first expanded to a WBXML Tree (cf wbxml_compact_tree_to_tree())
+ */
+WBXML_DECLARE(WBXMLError) wbxml_compact_tree_to_xml(WBXMLCompactTree *tree,
+                                                    WB_UTINY **xml,
+                                                    WB_ULONG  *xml_len,
+                                                    WBXMLGenXMLParams *params);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* WBXML_TREE_COMPACT_H */
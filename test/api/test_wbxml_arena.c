@@ -0,0 +1,143 @@
+#include "api_test.h"
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_arena.h"
+
+START_TEST (test_arena_alloc)
+{
+    WBXMLArena *arena = NULL;
+    WB_UTINY *p[1000];
+    WB_ULONG i = 0, j = 0;
+
+    arena = wbxml_arena_create();
+    ck_assert(arena != NULL);
+    ck_assert(wbxml_arena_blocks(arena) == 0);
+
+    /* Small allocations, of every size, are aligned and do not overlap */
+    for (i = 0; i < 1000; i++) {
+        p[i] = wbxml_arena_alloc(arena, i % 50);
+        ck_assert(p[i] != NULL);
+        ck_assert(((unsigned long) p[i]) % sizeof(void *) == 0);
+        memset(p[i], (int) (i & 0xff), i % 50);
+    }
+
+    for (i = 0; i < 1000; i++) {
+        for (j = 0; j < i % 50; j++)
+            ck_assert(p[i][j] == (WB_UTINY) (i & 0xff));
+    }
+
+    /* They are taken from a few blocks */
+    ck_assert(wbxml_arena_blocks(arena) > 0);
+    ck_assert(wbxml_arena_blocks(arena) < 10);
+
+    wbxml_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST (test_arena_big_alloc)
+{
+    WBXMLArena *arena = NULL;
+    WB_UTINY *small = NULL, *big = NULL, *next = NULL;
+
+    arena = wbxml_arena_create();
+    ck_assert(arena != NULL);
+
+    small = wbxml_arena_alloc(arena, 10);
+    ck_assert(small != NULL);
+    ck_assert(wbxml_arena_blocks(arena) == 1);
+
+    /* A big allocation gets its own block... */
+    big = wbxml_arena_alloc(arena, 100000);
+    ck_assert(big != NULL);
+    memset(big, 'b', 100000);
+    ck_assert(wbxml_arena_blocks(arena) == 2);
+
+    /* ... and the current block is still used */
+    next = wbxml_arena_alloc(arena, 10);
+    ck_assert(next != NULL);
+    ck_assert(next > small);
+    ck_assert(next - small < 100);
+    ck_assert(wbxml_arena_blocks(arena) == 2);
+
+    wbxml_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST (test_arena_realloc)
+{
+    WBXMLArena *arena = NULL;
+    WB_UTINY *p = NULL, *q = NULL, *r = NULL;
+    WB_ULONG i = 0;
+
+    arena = wbxml_arena_create();
+    ck_assert(arena != NULL);
+
+    /* NULL pointer: allocate */
+    p = wbxml_arena_realloc(arena, NULL, 0, 8);
+    ck_assert(p != NULL);
+    memcpy(p, "1234567", 8);
+
+    /* Last allocation: extended in place */
+    q = wbxml_arena_realloc(arena, p, 8, 100);
+    ck_assert(q == p);
+    ck_assert(memcmp(q, "1234567", 8) == 0);
+
+    /* Smaller: left as is */
+    ck_assert(wbxml_arena_realloc(arena, q, 100, 50) == q);
+
+    /* Not the last one anymore: copied */
+    r = wbxml_arena_alloc(arena, 16);
+    ck_assert(r != NULL);
+    q = wbxml_arena_realloc(arena, p, 100, 200);
+    ck_assert(q != NULL);
+    ck_assert(q != p);
+    ck_assert(memcmp(q, "1234567", 8) == 0);
+
+    /* Growing past a block, as a buffer does */
+    for (i = 200; i < 300000; i *= 2) {
+        q = wbxml_arena_realloc(arena, q, i, i * 2);
+        ck_assert(q != NULL);
+        ck_assert(memcmp(q, "1234567", 8) == 0);
+        memset(q + i, 'x', i);
+    }
+
+    wbxml_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST (test_arena_foreign)
+{
+    WBXMLArena *arena = NULL;
+
+    arena = wbxml_arena_create();
+    ck_assert(arena != NULL);
+
+    ck_assert(!wbxml_arena_has_foreign(arena));
+    wbxml_arena_add_foreign(arena);
+    ck_assert(wbxml_arena_has_foreign(arena));
+
+    wbxml_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST (test_arena_null_params)
+{
+    ck_assert(wbxml_arena_alloc(NULL, 10) == NULL);
+    ck_assert(wbxml_arena_realloc(NULL, NULL, 0, 10) == NULL);
+    ck_assert(!wbxml_arena_has_foreign(NULL));
+    ck_assert(wbxml_arena_blocks(NULL) == 0);
+
+    wbxml_arena_add_foreign(NULL);
+    wbxml_arena_destroy(NULL);
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_arena)
+
+    ADD_TEST(test_arena_alloc);
+    ADD_TEST(test_arena_big_alloc);
+    ADD_TEST(test_arena_realloc);
+    ADD_TEST(test_arena_foreign);
+    ADD_TEST(test_arena_null_params);
+
+END_TESTS
@@ -3,6 +3,17 @@
 #include "../../src/wbxml_base64.h"
 #include "../../src/wbxml_mem.h"
 
+#include <stdlib.h>
+
+#define TEST_BASE64_MAX_LEN 300
+
+/* Implementations to check against the scalar one */
+static const WBXMLBase64Impl test_base64_impls[] = {
+    WBXML_BASE64_IMPL_SSSE3,
+    WBXML_BASE64_IMPL_AVX2,
+    WBXML_BASE64_IMPL_NEON
+};
+
 START_TEST (test_encode)
 {
     WB_UTINY *result;
@@ -61,11 +72,96 @@ START_TEST (test_encode_and_decode)
 }
 END_TEST
 
+START_TEST (test_encode_to)
+{
+    WB_UTINY out[WBXML_BASE64_ENCODED_LEN(5)];
+
+    ck_assert(wbxml_base64_encode_to((const WB_UTINY*) "tests", 5, out) == 8);
+    ck_assert(WBXML_STRNCMP(out, "dGVzdHM=", 8) == 0);
+
+    ck_assert(wbxml_base64_encode_to((const WB_UTINY*) "tests", 0, out) == 0);
+    ck_assert(wbxml_base64_encode_to(NULL, 5, out) == 0);
+}
+END_TEST
+
+START_TEST (test_decode_in_place)
+{
+    WB_UTINY buf[] = "dGVzdHM=";
+
+    /* Stops at padding */
+    ck_assert(wbxml_base64_decode_to(buf, 8, buf) == 5);
+    ck_assert(WBXML_STRNCMP(buf, "tests", 5) == 0);
+}
+END_TEST
+
+START_TEST (test_simd)
+{
+    WB_UTINY data[TEST_BASE64_MAX_LEN];
+    WB_UTINY ref_enc[WBXML_BASE64_ENCODED_LEN(TEST_BASE64_MAX_LEN)];
+    WB_UTINY enc[WBXML_BASE64_ENCODED_LEN(TEST_BASE64_MAX_LEN)];
+    WB_UTINY ref_dec[TEST_BASE64_MAX_LEN];
+    WB_UTINY dec[TEST_BASE64_MAX_LEN];
+    WB_ULONG len = 0, enc_len = 0, dec_len = 0, pos = 0, i = 0;
+    int impl = 0;
+
+    srand(42);
+    for (i = 0; i < TEST_BASE64_MAX_LEN; i++)
+        data[i] = (WB_UTINY) rand();
+
+    for (impl = 0; impl < (int) (sizeof(test_base64_impls) / sizeof(test_base64_impls[0])); impl++) {
+        /* Not supported by this build or this CPU */
+        if (!wbxml_base64_set_impl(test_base64_impls[impl]))
+            continue;
+
+        ck_assert(wbxml_base64_get_impl() == test_base64_impls[impl]);
+
+        for (len = 0; len < TEST_BASE64_MAX_LEN; len++) {
+            /* Same encoding as scalar code */
+            ck_assert(wbxml_base64_set_impl(WBXML_BASE64_IMPL_SCALAR));
+            enc_len = wbxml_base64_encode_to(data, len, ref_enc);
+            ck_assert(enc_len == WBXML_BASE64_ENCODED_LEN(len));
+
+            ck_assert(wbxml_base64_set_impl(test_base64_impls[impl]));
+            ck_assert(wbxml_base64_encode_to(data, len, enc) == enc_len);
+            ck_assert(memcmp(enc, ref_enc, enc_len) == 0);
+
+            /* Decoded back */
+            dec_len = wbxml_base64_decode_to(enc, enc_len, dec);
+            ck_assert(dec_len == len);
+            ck_assert(memcmp(dec, data, len) == 0);
+
+            /* Same decoding as scalar code, with a wrong character anywhere */
+            for (pos = 0; pos < enc_len; pos += 7) {
+                memcpy(enc, ref_enc, enc_len);
+                enc[pos] = (WB_UTINY) ((pos & 1) ? '-' : 0xc3);
+
+                ck_assert(wbxml_base64_set_impl(WBXML_BASE64_IMPL_SCALAR));
+                dec_len = wbxml_base64_decode_to(enc, enc_len, ref_dec);
+
+                ck_assert(wbxml_base64_set_impl(test_base64_impls[impl]));
+                ck_assert(wbxml_base64_decode_to(enc, enc_len, dec) == dec_len);
+                ck_assert(memcmp(dec, ref_dec, dec_len) == 0);
+
+                /* In place */
+                ck_assert(wbxml_base64_decode_to(enc, enc_len, enc) == dec_len);
+                ck_assert(memcmp(enc, ref_dec, dec_len) == 0);
+            }
+        }
+    }
+
+    ck_assert(wbxml_base64_set_impl(WBXML_BASE64_IMPL_AUTO));
+    ck_assert(wbxml_base64_get_impl() != WBXML_BASE64_IMPL_AUTO);
+}
+END_TEST
+
 BEGIN_TESTS(wbxml_base64)
 
     ADD_TEST(test_encode);
     ADD_TEST(test_decode);
     ADD_TEST(test_encode_and_decode);
+    ADD_TEST(test_encode_to);
+    ADD_TEST(test_decode_in_place);
+    ADD_TEST(test_simd);
 
 END_TESTS
 
@@ -187,6 +187,31 @@ START_TEST (test_append)
 }
 END_TEST
 
+START_TEST (test_reserve)
+{
+    WBXMLBuffer *buf;
+    WB_UTINY *data;
+
+    buf = wbxml_buffer_create("test", 4, 4);
+    ck_assert(buf != NULL);
+
+    /* appending reserved bytes does not move data */
+    ck_assert(wbxml_buffer_reserve(buf, 100));
+    data = wbxml_buffer_get_cstr(buf);
+    ck_assert(wbxml_buffer_append_data(buf, (const WB_UTINY *) " data", 5));
+    ck_assert(wbxml_buffer_get_cstr(buf) == data);
+    ck_assert(wbxml_buffer_compare_cstr(buf, "test data") == 0);
+
+    wbxml_buffer_destroy(buf);
+
+    /* static buffers can't be extended */
+    buf = wbxml_buffer_sta_create_from_cstr("test");
+    ck_assert(!wbxml_buffer_reserve(buf, 10));
+    ck_assert(!wbxml_buffer_reserve(NULL, 10));
+    wbxml_buffer_destroy(buf);
+}
+END_TEST
+
 START_TEST (test_insert)
 {
     WBXMLBuffer *buf, *buf2;
@@ -294,6 +319,53 @@ START_TEST (test_delete)
 }
 END_TEST
 
+START_TEST (test_detach)
+{
+    WBXMLBuffer *buf;
+    WB_UTINY *data;
+    WB_ULONG len = 1;
+
+    /* nothing to take from an empty or a static buffer */
+
+    buf = wbxml_buffer_create_from_cstr("");
+    ck_assert(buf != NULL);
+    ck_assert(wbxml_buffer_detach(buf, &len) == NULL);
+    ck_assert(len == 0);
+    wbxml_buffer_destroy(buf);
+
+    buf = wbxml_buffer_sta_create_from_cstr("test");
+    ck_assert(buf != NULL);
+    ck_assert(wbxml_buffer_detach(buf, NULL) == NULL);
+    ck_assert(wbxml_buffer_len(buf) == 4);
+    wbxml_buffer_destroy(buf);
+
+    /* take data */
+
+    buf = wbxml_buffer_create("test", 4, 100);
+    ck_assert(buf != NULL);
+    ck_assert(wbxml_buffer_append_cstr(buf, " 1"));
+
+    data = wbxml_buffer_detach(buf, &len);
+    ck_assert(data != NULL);
+    ck_assert(len == 6);
+    ck_assert(strcmp((const char *) data, "test 1") == 0);
+    wbxml_free(data);
+
+    /* buffer is empty, and still usable */
+
+    ck_assert(wbxml_buffer_len(buf) == 0);
+    ck_assert(wbxml_buffer_append_cstr(buf, "again"));
+    ck_assert(wbxml_buffer_compare_cstr(buf, "again") == 0);
+
+    data = wbxml_buffer_detach(buf, NULL);
+    ck_assert(data != NULL);
+    ck_assert(strcmp((const char *) data, "again") == 0);
+    wbxml_free(data);
+
+    wbxml_buffer_destroy(buf);
+}
+END_TEST
+
 START_TEST (test_compare)
 {
     WBXMLBuffer *buf, *buf2;
@@ -528,6 +600,54 @@ START_TEST (test_conversion_base64)
     ck_assert(wbxml_buffer_decode_base64(buf) == WBXML_OK);
     ck_assert(wbxml_buffer_compare_cstr(buf, bin) == 0);
     wbxml_buffer_destroy(buf);
+
+    /* test convert to binary, with line breaks (MIME) */
+
+    buf = wbxml_buffer_create_from_cstr("dGVzdCBp\r\nbWFnZQo=\r\n");
+    ck_assert(wbxml_buffer_decode_base64(buf) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(buf, bin) == 0);
+    wbxml_buffer_destroy(buf);
+
+    /* test wrong base64 data */
+
+    buf = wbxml_buffer_create_from_cstr("=abc");
+    ck_assert(wbxml_buffer_decode_base64(buf) == WBXML_ERROR_B64_DEC);
+    ck_assert(wbxml_buffer_compare_cstr(buf, "=abc") == 0);
+    wbxml_buffer_destroy(buf);
+}
+END_TEST
+
+START_TEST (test_append_base64)
+{
+    WBXMLBuffer *buf;
+    const char *bin = "test image\n";
+    const char *b64 = "dGVzdCBpbWFnZQo=";
+
+    /* test append to base64 */
+
+    buf = wbxml_buffer_create_from_cstr("data: ");
+    ck_assert(wbxml_buffer_append_base64_encoded(buf, (const WB_UTINY *) bin, WBXML_STRLEN(bin)) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(buf, "data: dGVzdCBpbWFnZQo=") == 0);
+
+    /* test append part of buffer itself */
+
+    ck_assert(wbxml_buffer_append_base64_encoded(buf, wbxml_buffer_get_cstr(buf), 4) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(buf, "data: dGVzdCBpbWFnZQo=ZGF0YQ==") == 0);
+    wbxml_buffer_destroy(buf);
+
+    /* test append to binary, stopping at padding */
+
+    buf = wbxml_buffer_create_from_cstr("bin: ");
+    ck_assert(wbxml_buffer_append_base64_decoded(buf, (const WB_UTINY *) b64, WBXML_STRLEN(b64)) == WBXML_OK);
+    ck_assert(wbxml_buffer_len(buf) == 5 + WBXML_STRLEN(bin));
+    ck_assert(wbxml_buffer_compare_cstr(buf, "bin: test image\n") == 0);
+
+    /* test wrong parameters */
+
+    ck_assert(wbxml_buffer_append_base64_decoded(buf, wbxml_buffer_get_cstr(buf), 4) == WBXML_ERROR_INTERNAL);
+    ck_assert(wbxml_buffer_append_base64_decoded(NULL, (const WB_UTINY *) b64, 4) == WBXML_ERROR_INTERNAL);
+    ck_assert(wbxml_buffer_append_base64_encoded(NULL, (const WB_UTINY *) bin, 4) == WBXML_ERROR_INTERNAL);
+    wbxml_buffer_destroy(buf);
 }
 END_TEST
 
@@ -571,6 +691,41 @@ START_TEST (test_strip_blanks)
 }
 END_TEST
 
+START_TEST (test_get_stripped_bounds)
+{
+    WBXMLBuffer *buf;
+    const char *raw = " \n\t\f\rtest image\t\v \n";
+    WB_ULONG start = 0, len = 0;
+
+    /* static buffer: it is not modified */
+
+    buf = wbxml_buffer_sta_create_from_cstr(raw);
+    ck_assert(buf != NULL);
+
+    wbxml_buffer_get_stripped_bounds(buf, &start, &len);
+    ck_assert(start == 5);
+    ck_assert(len == strlen("test image"));
+    ck_assert(wbxml_buffer_compare_cstr(buf, raw) == 0);
+
+    wbxml_buffer_destroy(buf);
+
+    /* blank and empty buffers */
+
+    buf = wbxml_buffer_create_from_cstr(" \t\n");
+    ck_assert(buf != NULL);
+    wbxml_buffer_get_stripped_bounds(buf, &start, &len);
+    ck_assert(len == 0);
+    wbxml_buffer_destroy(buf);
+
+    buf = wbxml_buffer_create("", 0, 0);
+    ck_assert(buf != NULL);
+    wbxml_buffer_get_stripped_bounds(buf, &start, &len);
+    ck_assert(start == 0);
+    ck_assert(len == 0);
+    wbxml_buffer_destroy(buf);
+}
+END_TEST
+
 START_TEST (test_remove_trailing_zeros)
 {
     WBXMLBuffer *buf;
@@ -626,8 +781,10 @@ BEGIN_TESTS(wbxml_buffers)
     /* write operations */
     ADD_TEST(test_set_char);
     ADD_TEST(test_append);
+    ADD_TEST(test_reserve);
     ADD_TEST(test_insert);
     ADD_TEST(test_delete);
+    ADD_TEST(test_detach);
 
     /* read operations */
     ADD_TEST(test_compare);
@@ -640,10 +797,12 @@ BEGIN_TESTS(wbxml_buffers)
     /* conversion */
     ADD_TEST(test_conversion_hex);
     ADD_TEST(test_conversion_base64);
+    ADD_TEST(test_append_base64);
 
     /* handle whitespaces */
     ADD_TEST(test_shrink_blanks);
     ADD_TEST(test_strip_blanks);
+    ADD_TEST(test_get_stripped_bounds);
     ADD_TEST(test_remove_trailing_zeros);
 
     /* found bugs - test driven development */
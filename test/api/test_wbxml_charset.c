@@ -1,6 +1,23 @@
 #include "api_test.h"
 
 #include "../../src/wbxml_charset.h"
+#include "../../src/wbxml_buffers.h"
+
+/* Converts a buffer and checks the result, and the number of bytes left */
+static void test_charset_check(const char *in, WB_ULONG in_len, WBXMLCharsetMIBEnum from,
+                               const char *out, WB_ULONG out_len, WBXMLCharsetMIBEnum to,
+                               WB_ULONG left)
+{
+    WBXMLBuffer *result = NULL;
+    WB_ULONG len = in_len;
+
+    ck_assert(wbxml_charset_conv(in, &len, from, &result, to) == WBXML_OK);
+    ck_assert(wbxml_buffer_len(result) == out_len);
+    ck_assert(memcmp(wbxml_buffer_get_cstr(result), out, out_len) == 0);
+    ck_assert(len == left);
+
+    wbxml_buffer_destroy(result);
+}
 
 START_TEST (test_charset_existence)
 {
@@ -18,9 +35,113 @@ START_TEST (test_charset_existence)
 }
 END_TEST
 
+START_TEST (test_charset_latin1)
+{
+    test_charset_check("caf\xe9 \xff\x00", 7, WBXML_CHARSET_ISO_8859_1,
+                       "caf\xc3\xa9 \xc3\xbf", 8, WBXML_CHARSET_UTF_8, 0);
+    test_charset_check("caf\xc3\xa9 \xc3\xbf", 8, WBXML_CHARSET_UTF_8,
+                       "caf\xe9 \xff", 6, WBXML_CHARSET_ISO_8859_1, 0);
+
+    /* Stops at a character that is not in ISO-8859-1 */
+    test_charset_check("a\xc3\xa9\xe2\x82\xac", 6, WBXML_CHARSET_UTF_8,
+                       "a\xe9", 2, WBXML_CHARSET_ISO_8859_1, 3);
+}
+END_TEST
+
+START_TEST (test_charset_utf16)
+{
+    /* Big Endian by default, or as told by the Byte Order Mark */
+    test_charset_check("\x00" "a\x00\xe9\x20\xac\x00\x00", 8, WBXML_CHARSET_UTF_16,
+                       "a\xc3\xa9\xe2\x82\xac", 6, WBXML_CHARSET_UTF_8, 0);
+    test_charset_check("\xfe\xff\x00" "a\x00\xe9", 6, WBXML_CHARSET_UTF_16,
+                       "a\xc3\xa9", 3, WBXML_CHARSET_UTF_8, 0);
+    test_charset_check("\xff\xfe" "a\x00\xe9\x00\xac\x20", 8, WBXML_CHARSET_UTF_16,
+                       "a\xc3\xa9\xe2\x82\xac", 6, WBXML_CHARSET_UTF_8, 0);
+
+    /* Surrogate pair */
+    test_charset_check("\xd8\x3d\xde\x00", 4, WBXML_CHARSET_UTF_16,
+                       "\xf0\x9f\x98\x80", 4, WBXML_CHARSET_UTF_8, 0);
+
+    /* Stops at a lone surrogate, or an odd byte */
+    test_charset_check("\x00" "a\xdc\x00\x00" "b", 6, WBXML_CHARSET_UTF_16,
+                       "a", 1, WBXML_CHARSET_UTF_8, 4);
+    test_charset_check("\x00" "a\xd8\x3d\x00" "b", 6, WBXML_CHARSET_UTF_16,
+                       "a", 1, WBXML_CHARSET_UTF_8, 4);
+    test_charset_check("\x00" "a\x00", 3, WBXML_CHARSET_UTF_16,
+                       "a", 1, WBXML_CHARSET_UTF_8, 1);
+
+    /* Written as Big Endian, after a Byte Order Mark */
+    test_charset_check("a\xc3\xa9\xf0\x9f\x98\x80", 8, WBXML_CHARSET_UTF_8,
+                       "\xfe\xff\x00" "a\x00\xe9\xd8\x3d\xde\x00", 10, WBXML_CHARSET_UTF_16, 0);
+}
+END_TEST
+
+START_TEST (test_charset_ucs2)
+{
+    test_charset_check("\x00" "a\x20\xac", 4, WBXML_CHARSET_ISO_10646_UCS_2,
+                       "a\xe2\x82\xac", 4, WBXML_CHARSET_UTF_8, 0);
+    test_charset_check("a\xe2\x82\xac", 4, WBXML_CHARSET_UTF_8,
+                       "\x00" "a\x20\xac", 4, WBXML_CHARSET_ISO_10646_UCS_2, 0);
+
+    /* No surrogates in UCS-2 */
+    test_charset_check("\x00" "a\xd8\x3d\xde\x00", 6, WBXML_CHARSET_ISO_10646_UCS_2,
+                       "a", 1, WBXML_CHARSET_UTF_8, 4);
+    test_charset_check("a\xf0\x9f\x98\x80", 5, WBXML_CHARSET_UTF_8,
+                       "\x00" "a", 2, WBXML_CHARSET_ISO_10646_UCS_2, 4);
+}
+END_TEST
+
+START_TEST (test_charset_invalid_utf8)
+{
+    WBXMLBuffer *result = NULL;
+    WB_ULONG len = 2;
+
+    /* Overlong sequence, surrogate, incomplete sequence */
+    test_charset_check("a\xc0\xaf", 3, WBXML_CHARSET_UTF_8,
+                       "a", 1, WBXML_CHARSET_ISO_8859_1, 2);
+    test_charset_check("a\xed\xa0\x80", 4, WBXML_CHARSET_UTF_8,
+                       "\x00" "a", 2, WBXML_CHARSET_ISO_10646_UCS_2, 3);
+    test_charset_check("a\xe2\x82", 3, WBXML_CHARSET_UTF_8,
+                       "\xfe\xff\x00" "a", 4, WBXML_CHARSET_UTF_16, 2);
+
+    /* Nothing converted */
+    ck_assert(wbxml_charset_conv("\xff" "a", &len, WBXML_CHARSET_UTF_8,
+                                 &result, WBXML_CHARSET_ISO_8859_1) == WBXML_ERROR_CHARSET_CONV);
+    ck_assert(result == NULL);
+}
+END_TEST
+
+START_TEST (test_charset_conv_term)
+{
+    WBXMLBuffer *result = NULL;
+    WB_ULONG len = 10;
+
+    ck_assert(wbxml_charset_conv_term("\x00" "a\x00" "b\x00\x00\x00" "c\x00\x00", &len,
+                                      WBXML_CHARSET_UTF_16, &result, WBXML_CHARSET_UTF_8) == WBXML_OK);
+    ck_assert(len == 6);
+    ck_assert(wbxml_buffer_len(result) == 2);
+    ck_assert(strcmp((const char *) wbxml_buffer_get_cstr(result), "ab") == 0);
+    wbxml_buffer_destroy(result);
+
+    len = 6;
+    ck_assert(wbxml_charset_conv_term("caf\xe9\x00" "x", &len,
+                                      WBXML_CHARSET_ISO_8859_1, &result, WBXML_CHARSET_UTF_8) == WBXML_OK);
+    ck_assert(len == 5);
+    ck_assert(strcmp((const char *) wbxml_buffer_get_cstr(result), "caf\xc3\xa9") == 0);
+    wbxml_buffer_destroy(result);
+
+    wbxml_charset_conv_cleanup();
+}
+END_TEST
+
 BEGIN_TESTS(wbxml_charset)
 
     ADD_TEST(test_charset_existence);
+    ADD_TEST(test_charset_latin1);
+    ADD_TEST(test_charset_utf16);
+    ADD_TEST(test_charset_ucs2);
+    ADD_TEST(test_charset_invalid_utf8);
+    ADD_TEST(test_charset_conv_term);
 
 END_TESTS
 
@@ -1,6 +1,106 @@
 #include "api_test.h"
 
+#include <pthread.h>
+
 #include "../../src/wbxml_conv.h"
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_encoder.h"
+#include "../../src/wbxml_mem.h"
+
+#define TEST_CONV_SI_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE si PUBLIC \"-//WAPFORUM//DTD SI 1.0//EN\" \"http://www.wapforum.org/DTD/si.dtd\">" \
+    "<si><indication href=\"http://www.example.com/\">You have mail</indication></si>"
+
+/* Mixed content, empty Elements, and blank texts */
+#define TEST_CONV_AIRSYNC_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE AirSync PUBLIC \"-//AIRSYNC//DTD AirSync//EN\" \"http://www.microsoft.com/\">" \
+    "<Sync xmlns=\"http://synce.org/formats/airsync_wm5/airsync\">" \
+    "<Collections> before <Collection><SyncKey>1</SyncKey><CollectionId/>" \
+    "<Class>  Email  </Class></Collection> between <Collection/> after </Collections>" \
+    "<Wait>   </Wait><Limit/></Sync>"
+
+/* A <Data> with a <Meta> type: it needs a WBXML Tree */
+#define TEST_CONV_SYNCML_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE SyncML PUBLIC \"-//SYNCML//DTD SyncML 1.2//EN\" \"http://www.openmobilealliance.org/tech/DTD/OMA-TS-SyncML_RepPro_DTD-V1_2.dtd\">" \
+    "<SyncML xmlns=\"SYNCML:SYNCML1.2\"><SyncHdr><VerDTD>1.2</VerDTD><VerProto>SyncML/1.2</VerProto>" \
+    "<SessionID>1</SessionID><MsgID>1</MsgID><Target><LocURI>a</LocURI></Target><Source><LocURI>b</LocURI></Source>" \
+    "</SyncHdr><SyncBody><Replace><CmdID>2</CmdID><Meta><Type xmlns=\"syncml:metinf\">text/x-vcard</Type></Meta>" \
+    "<Item><Source><LocURI>1</LocURI></Source><Data>BEGIN:VCARD\nVERSION:2.1\nN:Doe;John\nEND:VCARD\n</Data>" \
+    "</Item></Replace><Final/></SyncBody></SyncML>"
+
+/* A vCard in a CDATA section: its lines are encoded with "\r\n" */
+#define TEST_CONV_SYNCML_CDATA_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE SyncML PUBLIC \"-//SYNCML//DTD SyncML 1.1//EN\" \"http://www.syncml.org/docs/syncml_represent_v11_20020213.dtd\">" \
+    "<SyncML xmlns=\"SYNCML:SYNCML1.1\"><SyncHdr><VerDTD>1.1</VerDTD><VerProto>SyncML/1.1</VerProto>" \
+    "<SessionID>1</SessionID><MsgID>1</MsgID><Target><LocURI>a</LocURI></Target><Source><LocURI>b</LocURI></Source>" \
+    "</SyncHdr><SyncBody><Add><CmdID>2</CmdID><Item><Source><LocURI>1</LocURI></Source>" \
+    "<Data><![CDATA[BEGIN:VCARD\nVERSION:2.1\nN:Doe;John\nEND:VCARD\n]]></Data>" \
+    "</Item></Add><Final/></SyncBody></SyncML>"
+
+#define TEST_CONV_THREADS    8
+#define TEST_CONV_ITERATIONS 20
+
+/* One WBXML Tree, encoded by several threads at the same time */
+typedef struct TestConvShared_s {
+    WBXMLTree *tree;
+    WB_UTINY  *wbxml;
+    WB_ULONG   wbxml_len;
+    WB_UTINY  *xml;
+    WB_ULONG   xml_len;
+    int        errors;
+} TestConvShared;
+
+static void test_conv_shared_params(WBXMLGenWBXMLParams *wbxml_params, WBXMLGenXMLParams *xml_params)
+{
+    /* Blanks are stripped, and the String Table is used */
+    wbxml_params->wbxml_version = WBXML_VERSION_13;
+    wbxml_params->keep_ignorable_ws = FALSE;
+    wbxml_params->use_strtbl = TRUE;
+    wbxml_params->produce_anonymous = FALSE;
+
+    xml_params->gen_type = WBXML_GEN_XML_INDENT;
+    xml_params->lang = WBXML_LANG_UNKNOWN;
+    xml_params->charset = WBXML_CHARSET_UNKNOWN;
+    xml_params->indent = 2;
+    xml_params->keep_ignorable_ws = FALSE;
+}
+
+static void *test_conv_shared_encode(void *data)
+{
+    TestConvShared *shared = (TestConvShared *) data;
+    WBXMLGenWBXMLParams wbxml_params;
+    WBXMLGenXMLParams xml_params;
+    WB_UTINY *wbxml = NULL, *xml = NULL;
+    WB_ULONG wbxml_len = 0, xml_len = 0;
+    int i = 0, errors = 0;
+
+    test_conv_shared_params(&wbxml_params, &xml_params);
+
+    for (i = 0; i < TEST_CONV_ITERATIONS; i++) {
+        if ((wbxml_tree_to_wbxml(shared->tree, &wbxml, &wbxml_len, &wbxml_params) != WBXML_OK) ||
+            (wbxml_len != shared->wbxml_len) || (memcmp(wbxml, shared->wbxml, wbxml_len) != 0))
+        {
+            errors++;
+        }
+        wbxml_free(wbxml);
+        wbxml = NULL;
+
+        if ((wbxml_tree_to_xml(shared->tree, &xml, &xml_len, &xml_params) != WBXML_OK) ||
+            (xml_len != shared->xml_len) || (memcmp(xml, shared->xml, xml_len) != 0))
+        {
+            errors++;
+        }
+        wbxml_free(xml);
+        xml = NULL;
+    }
+
+    /* Only read by the main thread once all threads are joined */
+    return (void *) (long) errors;
+}
 
 START_TEST (security_test_conv_init_null_reference)
 {
@@ -10,9 +110,335 @@ START_TEST (security_test_conv_init_null_reference)
 }
 END_TEST
 
+START_TEST (test_conv_wbxml2xml_run_borrowed)
+{
+    WB_UTINY *wbxml = NULL, *borrowed = NULL, *xml = NULL, *xml_static = NULL;
+    WB_ULONG wbxml_len = 0, xml_len = 0, xml_static_len = 0;
+    WBXMLConvXML2WBXML *xml2wbxml = NULL;
+    WBXMLConvWBXML2XML *conv = NULL;
+
+    ck_assert(wbxml_conv_xml2wbxml_create(&xml2wbxml) == WBXML_OK);
+    ck_assert(wbxml_conv_xml2wbxml_run(xml2wbxml, (WB_UTINY *) TEST_CONV_SI_XML, strlen(TEST_CONV_SI_XML),
+                                       &wbxml, &wbxml_len) == WBXML_OK);
+    wbxml_conv_xml2wbxml_destroy(xml2wbxml);
+
+    /* Exact size copy: the borrowed document is not NULL terminated */
+    borrowed = wbxml_malloc(wbxml_len);
+    ck_assert(borrowed != NULL);
+    memcpy(borrowed, wbxml, wbxml_len);
+
+    ck_assert(wbxml_conv_wbxml2xml_create(&conv) == WBXML_OK);
+    ck_assert(wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len, &xml, &xml_len) == WBXML_OK);
+    ck_assert(wbxml_conv_wbxml2xml_run(conv, borrowed, wbxml_len, &xml_static, &xml_static_len) == WBXML_OK);
+
+    /* Same result, and the borrowed document is left untouched */
+    ck_assert(xml_len == xml_static_len);
+    ck_assert(memcmp(xml, xml_static, xml_len) == 0);
+    ck_assert(memcmp(wbxml, borrowed, wbxml_len) == 0);
+    wbxml_free(xml_static);
+
+    /* A truncated inline string must not be read past the end of the document */
+    ck_assert(wbxml_conv_wbxml2xml_run(conv, borrowed, wbxml_len - 3, &xml_static, &xml_static_len) != WBXML_OK);
+
+    wbxml_conv_wbxml2xml_destroy(conv);
+    wbxml_free(xml);
+    wbxml_free(borrowed);
+    wbxml_free(wbxml);
+}
+END_TEST
+
+START_TEST (test_conv_wbxml2xml_stream)
+{
+    const char *docs[] = {
+        TEST_CONV_SI_XML,
+#if defined( WBXML_SUPPORT_AIRSYNC )
+        TEST_CONV_AIRSYNC_XML,
+#endif /* WBXML_SUPPORT_AIRSYNC */
+#if defined( WBXML_SUPPORT_SYNCML )
+        TEST_CONV_SYNCML_XML,
+#endif /* WBXML_SUPPORT_SYNCML */
+        NULL
+    };
+    WB_UTINY *wbxml = NULL, *xml = NULL, *xml_tree = NULL;
+    WB_ULONG wbxml_len = 0, xml_len = 0, xml_tree_len = 0;
+    WBXMLConvXML2WBXML *xml2wbxml = NULL;
+    WBXMLConvWBXML2XML *conv = NULL;
+    WBXMLGenXMLParams params;
+    WBXMLTree *tree = NULL;
+    WBXMLEncoder *encoder = NULL;
+    int i = 0, gen_type = 0, keep_ws = 0;
+
+    for (i = 0; docs[i] != NULL; i++) {
+        ck_assert(wbxml_conv_xml2wbxml_create(&xml2wbxml) == WBXML_OK);
+        if (i > 0)
+            wbxml_conv_xml2wbxml_enable_preserve_whitespaces(xml2wbxml);
+        ck_assert(wbxml_conv_xml2wbxml_run(xml2wbxml, (WB_UTINY *) docs[i], strlen(docs[i]),
+                                           &wbxml, &wbxml_len) == WBXML_OK);
+        wbxml_conv_xml2wbxml_destroy(xml2wbxml);
+
+        for (gen_type = WBXML_GEN_XML_COMPACT; gen_type <= WBXML_GEN_XML_CANONICAL; gen_type++) {
+            for (keep_ws = 0; keep_ws < 2; keep_ws++) {
+                /* Reference: from the WBXML Tree */
+                ck_assert(wbxml_tree_from_wbxml(wbxml, wbxml_len, WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN, &tree) == WBXML_OK);
+                params.gen_type = (WBXMLGenXMLType) gen_type;
+                params.lang = WBXML_LANG_UNKNOWN;
+                params.charset = WBXML_CHARSET_UNKNOWN;
+                params.indent = 2;
+                params.keep_ignorable_ws = (WB_BOOL) keep_ws;
+                ck_assert(wbxml_tree_to_xml(tree, &xml_tree, &xml_tree_len, &params) == WBXML_OK);
+                wbxml_tree_destroy(tree);
+
+                /* Encoded while parsed */
+                ck_assert(wbxml_conv_wbxml2xml_create(&conv) == WBXML_OK);
+                wbxml_conv_wbxml2xml_set_gen_type(conv, (WBXMLGenXMLType) gen_type);
+                wbxml_conv_wbxml2xml_set_indent(conv, 2);
+                if (keep_ws)
+                    wbxml_conv_wbxml2xml_enable_preserve_whitespaces(conv);
+                ck_assert(wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len, &xml, &xml_len) == WBXML_OK);
+                wbxml_conv_wbxml2xml_destroy(conv);
+
+                ck_assert(xml_len == xml_tree_len);
+                ck_assert(memcmp(xml, xml_tree, xml_len) == 0);
+                ck_assert(xml[xml_len] == '\0');
+
+                wbxml_free(xml);
+                wbxml_free(xml_tree);
+            }
+        }
+
+        /* A broken document gives an error, and no result */
+        ck_assert(wbxml_conv_wbxml2xml_create(&conv) == WBXML_OK);
+        ck_assert(wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len - 2, &xml, &xml_len) != WBXML_OK);
+        ck_assert(xml == NULL);
+        ck_assert(xml_len == 0);
+        wbxml_conv_wbxml2xml_destroy(conv);
+
+        wbxml_free(wbxml);
+    }
+
+    /* Not in Flow Mode */
+    encoder = wbxml_encoder_create();
+    ck_assert(encoder != NULL);
+    wbxml_encoder_set_flow_mode(encoder, TRUE);
+    ck_assert(wbxml_encoder_encode_wbxml_to_xml(encoder, (const WB_UTINY *) "\x03\x01\x6a\x00\x45\x01", 6,
+                                                WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN,
+                                                &xml, &xml_len) == WBXML_ERROR_BAD_PARAMETER);
+    wbxml_encoder_destroy(encoder);
+}
+END_TEST
+
+START_TEST (test_conv_xml2wbxml_stream)
+{
+    const char *docs[] = {
+        TEST_CONV_SI_XML,
+#if defined( WBXML_SUPPORT_AIRSYNC )
+        TEST_CONV_AIRSYNC_XML,
+#endif /* WBXML_SUPPORT_AIRSYNC */
+#if defined( WBXML_SUPPORT_SYNCML )
+        TEST_CONV_SYNCML_XML,
+#endif /* WBXML_SUPPORT_SYNCML */
+        NULL
+    };
+    WB_UTINY *wbxml = NULL, *wbxml_tree = NULL;
+    WB_ULONG wbxml_len = 0, wbxml_tree_len = 0;
+    WBXMLConvXML2WBXML *conv = NULL;
+    WBXMLGenWBXMLParams params;
+    WBXMLTree *tree = NULL;
+    WBXMLEncoder *encoder = NULL;
+    int i = 0, keep_ws = 0;
+
+    for (i = 0; docs[i] != NULL; i++) {
+        for (keep_ws = 0; keep_ws < 2; keep_ws++) {
+            /* Reference: from the WBXML Tree */
+            ck_assert(wbxml_tree_from_xml((WB_UTINY *) docs[i], strlen(docs[i]), &tree) == WBXML_OK);
+            params.wbxml_version = WBXML_VERSION_13;
+            params.keep_ignorable_ws = (WB_BOOL) keep_ws;
+            params.use_strtbl = FALSE;
+            params.produce_anonymous = FALSE;
+            ck_assert(wbxml_tree_to_wbxml(tree, &wbxml_tree, &wbxml_tree_len, &params) == WBXML_OK);
+            wbxml_tree_destroy(tree);
+
+            /* Encoded while parsed */
+            ck_assert(wbxml_conv_xml2wbxml_create(&conv) == WBXML_OK);
+            wbxml_conv_xml2wbxml_disable_string_table(conv);
+            if (keep_ws)
+                wbxml_conv_xml2wbxml_enable_preserve_whitespaces(conv);
+            ck_assert(wbxml_conv_xml2wbxml_run(conv, (WB_UTINY *) docs[i], strlen(docs[i]), &wbxml, &wbxml_len) == WBXML_OK);
+            wbxml_conv_xml2wbxml_destroy(conv);
+
+            ck_assert(wbxml_len == wbxml_tree_len);
+            ck_assert(memcmp(wbxml, wbxml_tree, wbxml_len) == 0);
+
+            wbxml_free(wbxml);
+            wbxml_free(wbxml_tree);
+        }
+
+        /* A broken document gives an error, and no result */
+        ck_assert(wbxml_conv_xml2wbxml_create(&conv) == WBXML_OK);
+        wbxml_conv_xml2wbxml_disable_string_table(conv);
+        ck_assert(wbxml_conv_xml2wbxml_run(conv, (WB_UTINY *) docs[i], strlen(docs[i]) - 2, &wbxml, &wbxml_len) == WBXML_ERROR_XML_PARSING_FAILED);
+        ck_assert(wbxml == NULL);
+        ck_assert(wbxml_len == 0);
+        wbxml_conv_xml2wbxml_destroy(conv);
+    }
+
+    /* Not in Flow Mode */
+    encoder = wbxml_encoder_create();
+    ck_assert(encoder != NULL);
+    wbxml_encoder_set_flow_mode(encoder, TRUE);
+    ck_assert(wbxml_encoder_encode_xml_to_wbxml(encoder, (WB_UTINY *) TEST_CONV_SI_XML, strlen(TEST_CONV_SI_XML),
+                                                &wbxml, &wbxml_len) == WBXML_ERROR_BAD_PARAMETER);
+    wbxml_encoder_destroy(encoder);
+}
+END_TEST
+
+START_TEST (test_conv_tree_shared)
+{
+    const char *docs[] = {
+        TEST_CONV_SI_XML,
+#if defined( WBXML_SUPPORT_AIRSYNC )
+        TEST_CONV_AIRSYNC_XML,
+#endif /* WBXML_SUPPORT_AIRSYNC */
+#if defined( WBXML_SUPPORT_SYNCML )
+        TEST_CONV_SYNCML_XML,
+        TEST_CONV_SYNCML_CDATA_XML,
+#endif /* WBXML_SUPPORT_SYNCML */
+        NULL
+    };
+    pthread_t threads[TEST_CONV_THREADS];
+    TestConvShared shared;
+    WBXMLGenWBXMLParams wbxml_params;
+    WBXMLGenXMLParams xml_params, keep_params;
+    WB_UTINY *before = NULL, *after = NULL;
+    WB_ULONG before_len = 0, after_len = 0;
+    void *errors = NULL;
+    int i = 0, t = 0;
+
+    test_conv_shared_params(&wbxml_params, &xml_params);
+
+    /* Snapshot of the whole Tree, blanks included */
+    keep_params = xml_params;
+    keep_params.gen_type = WBXML_GEN_XML_CANONICAL;
+    keep_params.keep_ignorable_ws = TRUE;
+
+    for (i = 0; docs[i] != NULL; i++) {
+        memset(&shared, 0, sizeof(shared));
+        ck_assert(wbxml_tree_from_xml((WB_UTINY *) docs[i], strlen(docs[i]), &shared.tree) == WBXML_OK);
+        ck_assert(wbxml_tree_to_xml(shared.tree, &before, &before_len, &keep_params) == WBXML_OK);
+
+        /* References: encoded once */
+        ck_assert(wbxml_tree_to_wbxml(shared.tree, &shared.wbxml, &shared.wbxml_len, &wbxml_params) == WBXML_OK);
+        ck_assert(wbxml_tree_to_xml(shared.tree, &shared.xml, &shared.xml_len, &xml_params) == WBXML_OK);
+
+        /* Encoding does not modify the Tree... */
+        ck_assert(wbxml_tree_to_xml(shared.tree, &after, &after_len, &keep_params) == WBXML_OK);
+        ck_assert(after_len == before_len);
+        ck_assert(memcmp(after, before, after_len) == 0);
+        wbxml_free(after);
+
+        /* ... so it can be encoded again, even at the same time by several threads */
+        for (t = 0; t < TEST_CONV_THREADS; t++)
+            ck_assert(pthread_create(&threads[t], NULL, test_conv_shared_encode, &shared) == 0);
+
+        for (t = 0; t < TEST_CONV_THREADS; t++) {
+            ck_assert(pthread_join(threads[t], &errors) == 0);
+            shared.errors += (int) (long) errors;
+        }
+
+        ck_assert(shared.errors == 0);
+
+        ck_assert(wbxml_tree_to_xml(shared.tree, &after, &after_len, &keep_params) == WBXML_OK);
+        ck_assert(after_len == before_len);
+        ck_assert(memcmp(after, before, after_len) == 0);
+        wbxml_free(after);
+
+        wbxml_free(before);
+        wbxml_free(shared.wbxml);
+        wbxml_free(shared.xml);
+        wbxml_tree_destroy(shared.tree);
+    }
+}
+END_TEST
+
+START_TEST (test_conv_tree_arena)
+{
+    const char *expected =
+        "<?xml version=\"1.0\"?>"
+        "<!DOCTYPE si PUBLIC \"-//WAPFORUM//DTD SI 1.0//EN\" \"http://www.wapforum.org/DTD/si.dtd\">"
+        "<si><indication href=\"http://www.example.com/\" si-id=\"1\">You have mail, twice!</indication>"
+        "<indication href=\"http://www.example.org/\">Second</indication></si>";
+    WBXMLGenWBXMLParams wbxml_params;
+    WBXMLGenXMLParams xml_params;
+    WBXMLTree *tree = NULL, *wbxml_tree = NULL;
+    WBXMLTreeNode *indication = NULL, *node = NULL;
+    WB_UTINY *xml = NULL, *wbxml = NULL, *again = NULL;
+    WB_ULONG xml_len = 0, wbxml_len = 0, again_len = 0;
+
+    test_conv_shared_params(&wbxml_params, &xml_params);
+    xml_params.gen_type = WBXML_GEN_XML_COMPACT;
+
+    /* Parsed Trees are built in an Arena */
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) TEST_CONV_SI_XML, strlen(TEST_CONV_SI_XML), &tree) == WBXML_OK);
+    ck_assert(tree->arena != NULL);
+    ck_assert(tree->root->arena == tree->arena);
+    indication = tree->root->children;
+    ck_assert(indication != NULL);
+
+    /* Attribute and joined Text Nodes in the Arena */
+    ck_assert(wbxml_tree_node_add_xml_attr(tree->lang, indication, (const WB_UTINY *) "si-id", (const WB_UTINY *) "1") == WBXML_OK);
+    ck_assert(wbxml_tree_add_text(tree, indication, (const WB_UTINY *) ", twice", 7) != NULL);
+    ck_assert(indication->children->next == NULL);
+
+    /* Malloced Nodes: joined to a Text Node of the Arena, and added as a child */
+    node = wbxml_tree_node_create_text((const WB_UTINY *) "!", 1);
+    ck_assert(node != NULL);
+    ck_assert(wbxml_tree_add_node(tree, indication, node));
+    ck_assert(indication->children == node);
+    ck_assert(node->next == NULL);
+
+    node = wbxml_tree_node_create_xml_elt_with_text(tree->lang, (const WB_UTINY *) "indication", (const WB_UTINY *) "Second", 6);
+    ck_assert(node != NULL);
+    ck_assert(node->arena == NULL);
+    ck_assert(wbxml_tree_node_add_xml_attr(tree->lang, node, (const WB_UTINY *) "href", (const WB_UTINY *) "http://www.example.org/") == WBXML_OK);
+    ck_assert(wbxml_tree_node_add_child(tree->root, node));
+
+    ck_assert(wbxml_tree_to_xml(tree, &xml, &xml_len, &xml_params) == WBXML_OK);
+    ck_assert(xml_len == strlen(expected));
+    ck_assert(memcmp(xml, expected, xml_len) == 0);
+
+    /* Same document, back from WBXML */
+    ck_assert(wbxml_tree_to_wbxml(tree, &wbxml, &wbxml_len, &wbxml_params) == WBXML_OK);
+    ck_assert(wbxml_tree_from_wbxml(wbxml, wbxml_len, WBXML_LANG_UNKNOWN, WBXML_CHARSET_UNKNOWN, &wbxml_tree) == WBXML_OK);
+    ck_assert(wbxml_tree->arena != NULL);
+    ck_assert(wbxml_tree_to_xml(wbxml_tree, &again, &again_len, &xml_params) == WBXML_OK);
+    ck_assert(again_len == xml_len);
+    ck_assert(memcmp(again, xml, xml_len) == 0);
+
+    /* Malloced Nodes are freed with the Tree */
+    wbxml_tree_destroy(wbxml_tree);
+    wbxml_tree_destroy(tree);
+    wbxml_free(again);
+    wbxml_free(wbxml);
+    wbxml_free(xml);
+
+    /* Tree Nodes created as before */
+    tree = wbxml_tree_create(WBXML_LANG_SI10, WBXML_CHARSET_UTF_8);
+    ck_assert(tree != NULL);
+    ck_assert(tree->arena == NULL);
+    ck_assert(wbxml_tree_add_xml_elt(tree, NULL, (WB_UTINY *) "si") != NULL);
+    ck_assert(tree->root->arena == NULL);
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
 BEGIN_TESTS(wbxml_conv)
 
     ADD_TEST(security_test_conv_init_null_reference);
+    ADD_TEST(test_conv_wbxml2xml_run_borrowed);
+    ADD_TEST(test_conv_wbxml2xml_stream);
+    ADD_TEST(test_conv_xml2wbxml_stream);
+    ADD_TEST(test_conv_tree_shared);
+    ADD_TEST(test_conv_tree_arena);
 
 END_TESTS
 
@@ -1,6 +1,7 @@
 #include "api_test.h"
 
 #include "../../src/wbxml_encoder.c"
+#include "../../src/wbxml_conv.h"
 
 START_TEST (security_test_xml_build_result_null_params)
 {
@@ -20,9 +21,327 @@ START_TEST (security_test_xml_build_result_null_params)
 }
 END_TEST
 
+#if defined( WBXML_ENCODER_USE_STRTBL )
+START_TEST (test_strtbl_add_element_dedup)
+{
+    WBXMLEncoder *enc = NULL;
+    WBXMLStringTableElement *elt = NULL;
+    WBXMLBuffer *buff = NULL;
+    WB_UTINY str[32];
+    WB_ULONG offsets[1000];
+    WB_ULONG i = 0, index = 0, len = 0;
+    WB_BOOL added = FALSE;
+
+    enc = wbxml_encoder_create();
+    ck_assert(enc != NULL);
+
+    /* Enough Strings to make the String Table index grow */
+    for (i = 0; i < 1000; i++) {
+        sprintf((char *) str, "string-%lu", (unsigned long) i);
+        buff = wbxml_buffer_create(str, WBXML_STRLEN(str), WBXML_STRLEN(str));
+        ck_assert(buff != NULL);
+        elt = wbxml_strtbl_element_create(buff, FALSE);
+        ck_assert(elt != NULL);
+        ck_assert(wbxml_strtbl_add_element(enc, elt, &index, &added));
+        ck_assert(added == TRUE);
+        ck_assert(index == len);
+        offsets[i] = index;
+        len += WBXML_STRLEN(str) + 1;
+    }
+    ck_assert(enc->strstbl_len == len);
+
+    /* Duplicates must give back the offset of the first occurrence */
+    for (i = 0; i < 1000; i += 7) {
+        sprintf((char *) str, "string-%lu", (unsigned long) i);
+        buff = wbxml_buffer_create(str, WBXML_STRLEN(str), WBXML_STRLEN(str));
+        ck_assert(buff != NULL);
+        elt = wbxml_strtbl_element_create(buff, FALSE);
+        ck_assert(elt != NULL);
+        ck_assert(wbxml_strtbl_add_element(enc, elt, &index, &added));
+        ck_assert(added == FALSE);
+        ck_assert(index == offsets[i]);
+        wbxml_strtbl_element_destroy(elt);
+    }
+    ck_assert(enc->strstbl_len == len);
+    ck_assert(wbxml_list_len(enc->strstbl) == 1000);
+
+    wbxml_encoder_destroy(enc);
+}
+END_TEST
+#endif /* WBXML_ENCODER_USE_STRTBL */
+
+#if defined( WBXML_SUPPORT_AIRSYNC ) && defined( WBXML_ENCODER_USE_STRTBL )
+/* Collects what is given to the Write Handler */
+typedef struct WriteContext_s {
+    WBXMLBuffer *output;
+    WB_ULONG     calls;
+    WBXMLError   ret;
+} WriteContext;
+
+static WBXMLError write_output(void *ctx, const WB_UTINY *data, WB_ULONG len)
+{
+    WriteContext *write = (WriteContext *) ctx;
+
+    ck_assert(len > 0);
+    ck_assert(wbxml_buffer_append_data(write->output, data, len));
+    write->calls++;
+
+    return write->ret;
+}
+
+/* Big enough to be written by several blocks, with Strings going to the String Table */
+static WBXMLTree *create_output_tree(void)
+{
+    WBXMLBuffer *xml = NULL;
+    WBXMLTree *tree = NULL;
+    WB_UTINY str[64];
+    WB_ULONG i = 0;
+
+    xml = wbxml_buffer_create_from_cstr("<?xml version=\"1.0\"?>"
+                                        "<!DOCTYPE ActiveSync PUBLIC \"-//MICROSOFT//DTD ActiveSync//EN\" \"http://www.microsoft.com/\">"
+                                        "<FolderSync xmlns=\"FolderHierarchy:\">");
+    ck_assert(xml != NULL);
+
+    for (i = 0; i < 2000; i++) {
+        sprintf((char *) str, "<SyncKey>key-%lu &amp; more</SyncKey>", (unsigned long) (i % 50));
+        ck_assert(wbxml_buffer_append_cstr(xml, str));
+    }
+    ck_assert(wbxml_buffer_append_cstr(xml, "</FolderSync>"));
+
+    ck_assert(wbxml_tree_from_xml(wbxml_buffer_get_cstr(xml), wbxml_buffer_len(xml), &tree) == WBXML_OK);
+    wbxml_buffer_destroy(xml);
+
+    return tree;
+}
+
+static WBXMLEncoder *create_output_encoder(WBXMLTree *tree, int mode)
+{
+    WBXMLEncoder *enc = wbxml_encoder_create();
+
+    ck_assert(enc != NULL);
+    wbxml_encoder_set_tree(enc, tree);
+    wbxml_encoder_set_use_strtbl(enc, mode == 0);
+
+    if (mode == 3)
+        wbxml_encoder_set_xml_gen_type(enc, WBXML_GEN_XML_INDENT);
+
+    return enc;
+}
+
+START_TEST (test_encoder_output_handler)
+{
+    WBXMLTree *tree = NULL;
+    WBXMLEncoder *enc = NULL;
+    WBXMLEncoderOutputType type = WBXML_ENCODER_OUTPUT_WBXML;
+    WBXMLEncoderOutputPart parts[WBXML_ENCODER_OUTPUT_PARTS];
+    WriteContext write;
+    WB_UTINY *result = NULL;
+    WB_ULONG result_len = 0, pos = 0, i = 0;
+    int mode = 0;
+
+    tree = create_output_tree();
+    ck_assert(tree != NULL);
+
+    /* WBXML with String Table, WBXML without String Table, XML, indented XML */
+    for (mode = 0; mode < 4; mode++) {
+        type = (mode < 2) ? WBXML_ENCODER_OUTPUT_WBXML : WBXML_ENCODER_OUTPUT_XML;
+
+        /* Reference */
+        enc = create_output_encoder(tree, mode);
+        if (type == WBXML_ENCODER_OUTPUT_WBXML)
+            ck_assert(wbxml_encoder_encode_tree_to_wbxml(enc, &result, &result_len) == WBXML_OK);
+        else {
+            ck_assert(wbxml_encoder_encode_tree_to_xml(enc, &result, &result_len) == WBXML_OK);
+            ck_assert(result[result_len] == '\0');
+        }
+
+        /* The result is given without being copied, unless the String Table is used */
+        ck_assert(enc->header_in_output == FALSE);
+        ck_assert(wbxml_buffer_len(enc->output) == ((mode == 0) ? result_len - enc->strtbl_pos - enc->strstbl_len : 0));
+        wbxml_encoder_destroy(enc);
+
+        /* Write Handler */
+        write.output = wbxml_buffer_create("", 0, 1000);
+        ck_assert(write.output != NULL);
+        write.calls = 0;
+        write.ret = WBXML_OK;
+
+        enc = create_output_encoder(tree, mode);
+        ck_assert(wbxml_encoder_encode_tree_to_handler(enc, type, write_output, &write) == WBXML_OK);
+        ck_assert(wbxml_buffer_len(write.output) == result_len);
+        ck_assert(memcmp(wbxml_buffer_get_cstr(write.output), result, result_len) == 0);
+
+        /* With the String Table: header, String Table and body. Else the output is written while encoding */
+        if (mode == 0)
+            ck_assert(write.calls == 3);
+        else
+            ck_assert(write.calls > result_len / WBXML_ENCODER_WRITE_BLOCK);
+
+        /* Nothing is kept */
+        ck_assert(wbxml_encoder_get_output_len(enc) == 0);
+        wbxml_encoder_destroy(enc);
+
+        /* An error of Write Handler stops encoding */
+        wbxml_buffer_delete(write.output, 0, wbxml_buffer_len(write.output));
+        write.calls = 0;
+        write.ret = WBXML_ERROR_INTERNAL;
+
+        enc = create_output_encoder(tree, mode);
+        ck_assert(wbxml_encoder_encode_tree_to_handler(enc, type, write_output, &write) == WBXML_ERROR_INTERNAL);
+        ck_assert(write.calls == 1);
+        wbxml_encoder_destroy(enc);
+
+        wbxml_buffer_destroy(write.output);
+
+        /* Parts */
+        enc = create_output_encoder(tree, mode);
+        wbxml_encoder_set_output_type(enc, type);
+        ck_assert(encoder_encode_tree(enc) == WBXML_OK);
+        ck_assert(wbxml_encoder_get_output_parts(enc, parts) == WBXML_OK);
+
+        /* ActiveSync has no WBXML Public ID: the XML one is in String Table, even if it is not used */
+        ck_assert(parts[0].len > 0);
+        if (type == WBXML_ENCODER_OUTPUT_WBXML) {
+            ck_assert(parts[1].len > 0);
+            ck_assert(parts[1].data[parts[1].len - 1] == '\0');
+            if (mode == 0)
+                ck_assert(parts[1].len == enc->strstbl_len);
+        }
+        else
+            ck_assert(parts[1].len == 0);
+
+        for (i = 0, pos = 0; i < WBXML_ENCODER_OUTPUT_PARTS; i++) {
+            ck_assert(pos + parts[i].len <= result_len);
+            ck_assert(memcmp(parts[i].data, result + pos, parts[i].len) == 0);
+            pos += parts[i].len;
+        }
+        ck_assert(pos == result_len);
+        wbxml_free(result);
+
+        /* Parts did not change the output */
+        ck_assert(wbxml_encoder_get_output(enc, &result, &result_len) == WBXML_OK);
+        ck_assert(result_len == pos);
+        wbxml_free(result);
+
+        wbxml_encoder_destroy(enc);
+    }
+
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
+/* Strings repeated as a whole, and some of them repeated at the end of others */
+static WBXMLTree *create_strtbl_tree(void)
+{
+    WBXMLBuffer *xml = NULL;
+    WBXMLTree *tree = NULL;
+    WB_UTINY str[128];
+    WB_ULONG i = 0;
+
+    xml = wbxml_buffer_create_from_cstr("<?xml version=\"1.0\"?>"
+                                        "<!DOCTYPE ActiveSync PUBLIC \"-//MICROSOFT//DTD ActiveSync//EN\" \"http://www.microsoft.com/\">"
+                                        "<FolderSync xmlns=\"FolderHierarchy:\">");
+    ck_assert(xml != NULL);
+
+    for (i = 0; i < 60; i++) {
+        if (i % 4 < 2)
+            sprintf((char *) str, "<SyncKey>shared/folder-name</SyncKey>");
+        else if (i % 4 == 2)
+            sprintf((char *) str, "<SyncKey>folder-name</SyncKey>");
+        else
+            sprintf((char *) str, "<SyncKey>item %lu of calendar-collection</SyncKey>", (unsigned long) i);
+        ck_assert(wbxml_buffer_append_cstr(xml, str));
+    }
+    ck_assert(wbxml_buffer_append_cstr(xml, "</FolderSync>"));
+
+    ck_assert(wbxml_tree_from_xml(wbxml_buffer_get_cstr(xml), wbxml_buffer_len(xml), &tree) == WBXML_OK);
+    wbxml_buffer_destroy(xml);
+
+    return tree;
+}
+
+static WB_UTINY *decode_airsync(WB_UTINY *wbxml, WB_ULONG wbxml_len, WB_ULONG *xml_len)
+{
+    WBXMLConvWBXML2XML *conv = NULL;
+    WB_UTINY *xml = NULL;
+
+    ck_assert(wbxml_conv_wbxml2xml_create(&conv) == WBXML_OK);
+    wbxml_conv_wbxml2xml_set_language(conv, WBXML_LANG_AIRSYNC);
+    ck_assert(wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len, &xml, xml_len) == WBXML_OK);
+    wbxml_conv_wbxml2xml_destroy(conv);
+
+    return xml;
+}
+
+START_TEST (test_strtbl_optimal)
+{
+    WBXMLTree *tree = NULL;
+    WBXMLEncoder *enc = NULL;
+    WBXMLStringTableElement *elt = NULL;
+    WB_UTINY *wbxml[2] = { NULL, NULL }, *xml[2] = { NULL, NULL };
+    WB_ULONG wbxml_len[2] = { 0, 0 }, xml_len[2] = { 0, 0 };
+    WB_ULONG i = 0, stored = 0, shared = 0, len = 0;
+    int mode = 0;
+
+    tree = create_strtbl_tree();
+    ck_assert(tree != NULL);
+
+    /* Default String Table, then the one that saves the most bytes */
+    for (mode = 0; mode < 2; mode++) {
+        enc = wbxml_encoder_create();
+        ck_assert(enc != NULL);
+        wbxml_encoder_set_tree(enc, tree);
+        wbxml_encoder_set_optimal_strtbl(enc, mode == 1);
+        ck_assert(wbxml_encoder_encode_tree_to_wbxml(enc, &wbxml[mode], &wbxml_len[mode]) == WBXML_OK);
+
+        if (mode == 1) {
+            /* "folder-name" is the end of "shared/folder-name": it is not stored again */
+            for (i = 0, len = 0; i < wbxml_list_len(enc->strstbl); i++) {
+                elt = (WBXMLStringTableElement *) wbxml_list_get(enc->strstbl, i);
+                if (elt->shared) {
+                    shared++;
+                    continue;
+                }
+                stored++;
+                len += wbxml_buffer_len(elt->string) + 1;
+            }
+            ck_assert(shared > 0);
+            ck_assert(stored > 0);
+            ck_assert(enc->strstbl_len == len);
+        }
+
+        wbxml_encoder_destroy(enc);
+    }
+
+    ck_assert(wbxml_len[1] < wbxml_len[0]);
+
+    /* Both give the same document */
+    xml[0] = decode_airsync(wbxml[0], wbxml_len[0], &xml_len[0]);
+    xml[1] = decode_airsync(wbxml[1], wbxml_len[1], &xml_len[1]);
+    ck_assert(xml_len[0] == xml_len[1]);
+    ck_assert(memcmp(xml[0], xml[1], xml_len[0]) == 0);
+    ck_assert(strstr((const char *) xml[1], "<SyncKey>folder-name</SyncKey>") != NULL);
+
+    for (mode = 0; mode < 2; mode++) {
+        wbxml_free(wbxml[mode]);
+        wbxml_free(xml[mode]);
+    }
+
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+#endif /* WBXML_SUPPORT_AIRSYNC && WBXML_ENCODER_USE_STRTBL */
+
 BEGIN_TESTS(wbxml_encoder_internals)
 
     ADD_TEST(security_test_xml_build_result_null_params);
+#if defined( WBXML_ENCODER_USE_STRTBL )
+    ADD_TEST(test_strtbl_add_element_dedup);
+#endif /* WBXML_ENCODER_USE_STRTBL */
+#if defined( WBXML_SUPPORT_AIRSYNC ) && defined( WBXML_ENCODER_USE_STRTBL )
+    ADD_TEST(test_encoder_output_handler);
+    ADD_TEST(test_strtbl_optimal);
+#endif /* WBXML_SUPPORT_AIRSYNC && WBXML_ENCODER_USE_STRTBL */
 
 END_TESTS
 
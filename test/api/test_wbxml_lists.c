@@ -141,6 +141,96 @@ START_TEST (test_destructor)
 }
 END_TEST
 
+START_TEST (test_in_arena)
+{
+    WBXMLArena *arena;
+    WBXMLList *list;
+    int i = 1, j = 2;
+
+    arena = wbxml_arena_create();
+    list = wbxml_list_create_in_arena(arena);
+    ck_assert(list != NULL);
+    ck_assert(wbxml_list_append(list, &i) == TRUE);
+    ck_assert(wbxml_list_insert(list, &j, 0) == TRUE);
+    ck_assert(wbxml_list_len(list) == 2);
+    ck_assert(wbxml_list_extract_first(list) == &j);
+    ck_assert(wbxml_list_get(list, 0) == &i);
+    wbxml_list_destroy(list, (void *)(void *) &list_element_destructor);
+    ck_assert(i == 0);
+    ck_assert(j == 2);
+    wbxml_arena_destroy(arena);
+}
+END_TEST
+
+START_TEST (test_many_items)
+{
+    WBXMLArena *arena = NULL;
+    WBXMLList *list;
+    int items[1000], *expected[2000];
+    WB_ULONG first = 0, len = 0, i = 0, j = 0;
+    int in_arena = 0;
+
+    for (i = 0; i < 1000; i++)
+        items[i] = (int) i;
+
+    for (in_arena = 0; in_arena < 2; in_arena++) {
+        if (in_arena) {
+            arena = wbxml_arena_create();
+            list = wbxml_list_create_in_arena(arena);
+        }
+        else
+            list = wbxml_list_create();
+        ck_assert(list != NULL);
+
+        /* Appends, inserts and extractions, as a queue: the array grows, and items are moved */
+        first = 1000;
+        len = 0;
+        for (i = 0; i < 1000; i++) {
+            if (i % 5 == 4) {
+                ck_assert(wbxml_list_extract_first(list) == expected[first]);
+                first++;
+                len--;
+            }
+            else if (i % 7 == 3) {
+                ck_assert(wbxml_list_insert(list, &items[i], 0) == TRUE);
+                expected[--first] = &items[i];
+                len++;
+            }
+            else if (i % 11 == 6) {
+                ck_assert(wbxml_list_insert(list, &items[i], len / 2) == TRUE);
+                memmove(expected + first + len / 2 + 1, expected + first + len / 2, (len - len / 2) * sizeof(int *));
+                expected[first + len / 2] = &items[i];
+                len++;
+            }
+            else {
+                ck_assert(wbxml_list_append(list, &items[i]) == TRUE);
+                expected[first + len] = &items[i];
+                len++;
+            }
+
+            ck_assert(wbxml_list_len(list) == len);
+            for (j = 0; j < len; j++)
+                ck_assert(wbxml_list_get(list, j) == expected[first + j]);
+            ck_assert(wbxml_list_get(list, len) == NULL);
+        }
+
+        /* Empty, then reused */
+        while (len > 0) {
+            ck_assert(wbxml_list_extract_first(list) == expected[first++]);
+            len--;
+        }
+        ck_assert(wbxml_list_extract_first(list) == NULL);
+        ck_assert(wbxml_list_append(list, &items[0]) == TRUE);
+        ck_assert(wbxml_list_get(list, 0) == &items[0]);
+        ck_assert(wbxml_list_len(list) == 1);
+
+        wbxml_list_destroy(list, NULL);
+        wbxml_arena_destroy(arena);
+        arena = NULL;
+    }
+}
+END_TEST
+
 BEGIN_TESTS(wbxml_lists)
 
     ADD_TEST(test_init_and_destroy);
@@ -151,6 +241,8 @@ BEGIN_TESTS(wbxml_lists)
     ADD_TEST(test_insert);
     ADD_TEST(test_extract_first);
     ADD_TEST(test_destructor);
+    ADD_TEST(test_in_arena);
+    ADD_TEST(test_many_items);
 
 END_TESTS
 
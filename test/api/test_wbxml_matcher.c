@@ -0,0 +1,232 @@
+#include "api_test.h"
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_matcher.h"
+
+/* Cut each Pattern (in priority order) out of the text, leftmost occurrence first,
+ * as the encoder did before Matcher. Returns the number of occurrences cut. */
+static WB_ULONG cut_patterns(const char **patterns, WB_ULONG count, const char *text, WBXMLMatch *result)
+{
+    WB_UTINY covered[256];
+    WB_ULONG len = strlen(text), i = 0, pos = 0, end = 0, plen = 0, nb = 0, j = 0;
+    const char *found = NULL;
+    char fragment[256];
+
+    memset(covered, 0, sizeof(covered));
+
+    for (i = 0; i < count; i++) {
+        plen = strlen(patterns[i]);
+        if (plen == 0)
+            continue;
+
+        /* For each fragment not yet cut */
+        pos = 0;
+        while (pos < len) {
+            if (covered[pos]) {
+                pos++;
+                continue;
+            }
+
+            for (end = pos; (end < len) && !covered[end]; end++)
+                ;
+
+            memcpy(fragment, text + pos, end - pos);
+            fragment[end - pos] = '\0';
+
+            if ((found = strstr(fragment, patterns[i])) != NULL) {
+                result[nb].pattern = i;
+                result[nb].pos = pos + (found - fragment);
+                result[nb].len = plen;
+                nb++;
+
+                memset(covered + result[nb - 1].pos, 1, plen);
+
+                /* Search again the end of this fragment */
+                pos = result[nb - 1].pos + plen;
+            }
+            else
+                pos = end;
+        }
+    }
+
+    /* Sort by position */
+    for (i = 1; i < nb; i++) {
+        for (j = i; (j > 0) && (result[j - 1].pos > result[j].pos); j--) {
+            WBXMLMatch tmp = result[j];
+            result[j] = result[j - 1];
+            result[j - 1] = tmp;
+        }
+    }
+
+    return nb;
+}
+
+/* Simple pseudo-random generator, so that test is the same everywhere */
+static WB_ULONG next_random(WB_ULONG *seed)
+{
+    *seed = *seed * 1103515245UL + 12345UL;
+    return (*seed >> 16) & 0x7fff;
+}
+
+START_TEST (test_matcher_search)
+{
+    const char *patterns[] = { "he", "she", "his", "hers" };
+    const char *text = "ushers";
+    WBXMLMatcher *matcher = wbxml_matcher_create();
+    WBXMLMatchSet set;
+    WB_ULONG i = 0;
+
+    ck_assert(matcher != NULL);
+
+    for (i = 0; i < 4; i++)
+        ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) patterns[i], strlen(patterns[i]), i * 10));
+
+    ck_assert(wbxml_matcher_count(matcher) == 4);
+
+    wbxml_match_set_init(&set);
+
+    /* Not compiled */
+    ck_assert(!wbxml_matcher_search(matcher, (const WB_UTINY *) text, strlen(text), 0, &set));
+
+    ck_assert(wbxml_matcher_compile(matcher));
+    ck_assert(wbxml_matcher_search(matcher, (const WB_UTINY *) text, strlen(text), 100, &set));
+
+    /* "she" and "he" end at 3, "hers" ends at 5 */
+    ck_assert(set.len == 3);
+
+    for (i = 0; i < set.len; i++) {
+        ck_assert(set.matches[i].pattern >= 100);
+        ck_assert(set.matches[i].len == strlen(patterns[set.matches[i].pattern - 100]));
+        ck_assert(set.matches[i].value == (set.matches[i].pattern - 100) * 10);
+        ck_assert(memcmp(text + set.matches[i].pos, patterns[set.matches[i].pattern - 100], set.matches[i].len) == 0);
+    }
+
+    /* "he" has priority over "she" and "hers" */
+    ck_assert(wbxml_matcher_select(&set, strlen(text)));
+    ck_assert(set.len == 1);
+    ck_assert(set.matches[0].pattern == 100);
+    ck_assert(set.matches[0].pos == 2);
+
+    wbxml_match_set_clean(&set);
+    ck_assert(set.matches == NULL);
+    ck_assert(set.len == 0);
+
+    wbxml_matcher_destroy(matcher);
+}
+END_TEST
+
+START_TEST (test_matcher_empty_and_duplicate)
+{
+    WBXMLMatcher *matcher = wbxml_matcher_create();
+    WBXMLMatchSet set;
+
+    ck_assert(matcher != NULL);
+
+    ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) "", 0, 0));
+    ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) "ab", 2, 1));
+    ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) "ab", 2, 2));
+    ck_assert(wbxml_matcher_count(matcher) == 3);
+    ck_assert(wbxml_matcher_compile(matcher));
+
+    wbxml_match_set_init(&set);
+
+    /* Empty Pattern is never found, and only first "ab" is */
+    ck_assert(wbxml_matcher_search(matcher, (const WB_UTINY *) "abab", 4, 0, &set));
+    ck_assert(set.len == 2);
+    ck_assert((set.matches[0].pattern == 1) && (set.matches[0].value == 1) && (set.matches[0].pos == 0));
+    ck_assert((set.matches[1].pattern == 1) && (set.matches[1].value == 1) && (set.matches[1].pos == 2));
+
+    /* Empty text */
+    ck_assert(wbxml_matcher_search(matcher, NULL, 0, 0, &set));
+    ck_assert(set.len == 2);
+
+    /* Pattern added after compilation */
+    ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) "ba", 2, 3));
+    ck_assert(!wbxml_matcher_search(matcher, (const WB_UTINY *) "abab", 4, 0, &set));
+    ck_assert(wbxml_matcher_compile(matcher));
+
+    set.len = 0;
+    ck_assert(wbxml_matcher_search(matcher, (const WB_UTINY *) "abab", 4, 0, &set));
+    ck_assert(set.len == 3);
+
+    wbxml_match_set_clean(&set);
+    wbxml_matcher_destroy(matcher);
+}
+END_TEST
+
+START_TEST (test_matcher_select_as_cut)
+{
+    const char *alphabet[] = { "a", "b", "ab", "ba", "aa", "aba", "bab", "abab", "bb", "aab", "c", "ca" };
+    const char *patterns[8];
+    char text[64];
+    WBXMLMatch expected[64];
+    WBXMLMatcher *matcher = NULL;
+    WBXMLMatchSet set;
+    WB_ULONG round = 0, count = 0, len = 0, nb = 0, i = 0;
+    WB_ULONG seed = 1;
+
+    wbxml_match_set_init(&set);
+
+    for (round = 0; round < 2000; round++) {
+        count = 1 + (next_random(&seed) % 8);
+        for (i = 0; i < count; i++)
+            patterns[i] = alphabet[next_random(&seed) % (sizeof(alphabet) / sizeof(alphabet[0]))];
+
+        len = next_random(&seed) % (sizeof(text) - 1);
+        for (i = 0; i < len; i++)
+            text[i] = "abc"[next_random(&seed) % 3];
+        text[len] = '\0';
+
+        ck_assert((matcher = wbxml_matcher_create()) != NULL);
+
+        for (i = 0; i < count; i++)
+            ck_assert(wbxml_matcher_add(matcher, (const WB_UTINY *) patterns[i], strlen(patterns[i]), i));
+
+        ck_assert(wbxml_matcher_compile(matcher));
+
+        set.len = 0;
+        ck_assert(wbxml_matcher_search(matcher, (const WB_UTINY *) text, len, 0, &set));
+        ck_assert(wbxml_matcher_select(&set, len));
+
+        nb = cut_patterns(patterns, count, text, expected);
+
+        ck_assert(set.len == nb);
+        for (i = 0; i < nb; i++) {
+            ck_assert(set.matches[i].pattern == expected[i].pattern);
+            ck_assert(set.matches[i].pos == expected[i].pos);
+            ck_assert(set.matches[i].len == expected[i].len);
+        }
+
+        wbxml_matcher_destroy(matcher);
+    }
+
+    wbxml_match_set_clean(&set);
+}
+END_TEST
+
+START_TEST (test_matcher_null_params)
+{
+    WBXMLMatchSet set;
+
+    wbxml_match_set_init(&set);
+
+    ck_assert(!wbxml_matcher_add(NULL, (const WB_UTINY *) "a", 1, 0));
+    ck_assert(wbxml_matcher_count(NULL) == 0);
+    ck_assert(!wbxml_matcher_compile(NULL));
+    ck_assert(!wbxml_matcher_search(NULL, (const WB_UTINY *) "a", 1, 0, &set));
+    ck_assert(!wbxml_matcher_select(NULL, 0));
+    ck_assert(wbxml_matcher_select(&set, 0));
+
+    wbxml_matcher_destroy(NULL);
+    wbxml_match_set_clean(NULL);
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_matcher)
+
+    ADD_TEST(test_matcher_search);
+    ADD_TEST(test_matcher_empty_and_duplicate);
+    ADD_TEST(test_matcher_select_as_cut);
+    ADD_TEST(test_matcher_null_params);
+
+END_TESTS
@@ -0,0 +1,326 @@
+#include "api_test.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "../../src/wbxml_conv.h"
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_parser.h"
+#include "../../src/wbxml_mem.h"
+
+#define TEST_MEM_SI_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE si PUBLIC \"-//WAPFORUM//DTD SI 1.0//EN\" \"http://www.wapforum.org/DTD/si.dtd\">" \
+    "<si><indication href=\"http://www.example.com/\">You have mail</indication></si>"
+
+#define TEST_MEM_THREADS    4
+#define TEST_MEM_ITERATIONS 20
+
+/* Counts the Memory Blocks not freed yet */
+typedef struct TestMemCtx_s {
+    long live;
+} TestMemCtx;
+
+static void *test_mem_malloc(void *ctx, size_t size)
+{
+    void *result = malloc(size);
+
+    if (result != NULL)
+        ((TestMemCtx *) ctx)->live++;
+
+    return result;
+}
+
+static void *test_mem_realloc(void *ctx, void *memblock, size_t size)
+{
+    void *result = realloc(memblock, size);
+
+    if ((result != NULL) && (memblock == NULL))
+        ((TestMemCtx *) ctx)->live++;
+
+    return result;
+}
+
+static void test_mem_free(void *ctx, void *memblock)
+{
+    ((TestMemCtx *) ctx)->live--;
+    free(memblock);
+}
+
+static void test_mem_init(WBXMLAllocator *allocator, TestMemCtx *ctx)
+{
+    memset(allocator, 0, sizeof(WBXMLAllocator));
+    allocator->malloc_clb = test_mem_malloc;
+    allocator->realloc_clb = test_mem_realloc;
+    allocator->free_clb = test_mem_free;
+    allocator->ctx = ctx;
+
+    ctx->live = 0;
+}
+
+/* Converts a document with a Converter bound to the Allocator in use */
+static WB_BOOL test_mem_convert(void)
+{
+    WBXMLConvXML2WBXML *xml2wbxml = NULL;
+    WBXMLConvWBXML2XML *wbxml2xml = NULL;
+    WB_UTINY *wbxml = NULL, *xml = NULL;
+    WB_ULONG wbxml_len = 0, xml_len = 0;
+    WB_BOOL result = FALSE;
+
+    if (wbxml_conv_xml2wbxml_create(&xml2wbxml) != WBXML_OK)
+        return FALSE;
+
+    if (wbxml_conv_wbxml2xml_create(&wbxml2xml) != WBXML_OK) {
+        wbxml_conv_xml2wbxml_destroy(xml2wbxml);
+        return FALSE;
+    }
+
+    if ((wbxml_conv_xml2wbxml_run(xml2wbxml, (WB_UTINY *) TEST_MEM_SI_XML, strlen(TEST_MEM_SI_XML),
+                                  &wbxml, &wbxml_len) == WBXML_OK) &&
+        (wbxml_conv_wbxml2xml_run(wbxml2xml, wbxml, wbxml_len, &xml, &xml_len) == WBXML_OK))
+    {
+        result = (strstr((const char *) xml, "You have mail") != NULL);
+    }
+
+    wbxml_free(wbxml);
+    wbxml_free(xml);
+    wbxml_conv_wbxml2xml_destroy(wbxml2xml);
+    wbxml_conv_xml2wbxml_destroy(xml2wbxml);
+
+    return result;
+}
+
+START_TEST (test_mem_allocator_counters)
+{
+    WBXMLAllocator allocator, *previous = NULL;
+    TestMemCtx ctx;
+    void *p = NULL;
+    char *str = NULL;
+
+    test_mem_init(&allocator, &ctx);
+
+    previous = wbxml_mem_use_allocator(&allocator);
+    ck_assert(wbxml_mem_get_allocator() == &allocator);
+
+    p = wbxml_malloc(10);
+    ck_assert(p != NULL);
+    p = wbxml_realloc(p, 100);
+    ck_assert(p != NULL);
+    str = wbxml_strdup("allocator");
+    ck_assert(str != NULL);
+    ck_assert(strcmp(str, "allocator") == 0);
+
+    ck_assert(ctx.live == 2);
+    ck_assert(allocator.allocs == 2);
+    ck_assert(allocator.reallocs == 1);
+    ck_assert(allocator.bytes == 10 + 100 + 10);
+
+    wbxml_free(p);
+    wbxml_free(str);
+    wbxml_free(NULL);
+
+    ck_assert(wbxml_mem_use_allocator(previous) == &allocator);
+
+    ck_assert(ctx.live == 0);
+    ck_assert(allocator.frees == 2);
+    ck_assert(allocator.failures == 0);
+}
+END_TEST
+
+START_TEST (test_mem_allocator_scopes)
+{
+    WBXMLAllocator global, local, *previous = NULL;
+    TestMemCtx global_ctx, local_ctx;
+    void *p = NULL;
+
+    test_mem_init(&global, &global_ctx);
+    test_mem_init(&local, &local_ctx);
+
+    /* The Allocator of calling thread is used before the default one */
+    wbxml_mem_set_allocator(&global);
+    ck_assert(wbxml_mem_get_allocator() == &global);
+
+    previous = wbxml_mem_use_allocator(&local);
+    ck_assert(previous == NULL);
+    ck_assert(wbxml_mem_get_allocator() == &local);
+
+    p = wbxml_malloc(16);
+    wbxml_free(p);
+    ck_assert(local.allocs == 1);
+    ck_assert(global.allocs == 0);
+
+    wbxml_mem_use_allocator(previous);
+    ck_assert(wbxml_mem_get_allocator() == &global);
+
+    p = wbxml_malloc(16);
+    wbxml_free(p);
+    ck_assert(global.allocs == 1);
+    ck_assert(local.allocs == 1);
+
+    wbxml_mem_set_allocator(NULL);
+    ck_assert(wbxml_mem_get_allocator() == NULL);
+}
+END_TEST
+
+START_TEST (test_mem_allocator_parser)
+{
+    WBXMLAllocator allocator, *previous = NULL;
+    WBXMLConvXML2WBXML *conv = NULL;
+    WBXMLParser *parser = NULL;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG wbxml_len = 0;
+    TestMemCtx ctx;
+
+    ck_assert(wbxml_conv_xml2wbxml_create(&conv) == WBXML_OK);
+    ck_assert(wbxml_conv_xml2wbxml_run(conv, (WB_UTINY *) TEST_MEM_SI_XML, strlen(TEST_MEM_SI_XML),
+                                       &wbxml, &wbxml_len) == WBXML_OK);
+    wbxml_conv_xml2wbxml_destroy(conv);
+
+    test_mem_init(&allocator, &ctx);
+
+    /* The Parser keeps the Allocator in use when it is created... */
+    previous = wbxml_mem_use_allocator(&allocator);
+    parser = wbxml_parser_create();
+    wbxml_mem_use_allocator(previous);
+
+    ck_assert(parser != NULL);
+    ck_assert(allocator.allocs == 1);
+
+    /* ... and uses it when parsing, and when destroyed */
+    ck_assert(wbxml_parser_parse_static(parser, wbxml, wbxml_len) == WBXML_OK);
+    ck_assert(allocator.allocs > 1);
+    ck_assert(wbxml_mem_get_allocator() == NULL);
+
+    wbxml_parser_destroy(parser);
+
+    ck_assert(ctx.live == 0);
+    ck_assert(allocator.allocs == allocator.frees);
+
+    wbxml_free(wbxml);
+}
+END_TEST
+
+START_TEST (test_mem_allocator_tree)
+{
+    WBXMLAllocator allocator, *previous = NULL;
+    WBXMLTree *tree = NULL;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG wbxml_len = 0, allocs = 0;
+    TestMemCtx ctx;
+
+    test_mem_init(&allocator, &ctx);
+
+    /* The Tree, built with Expat, is bound to the Allocator */
+    previous = wbxml_mem_use_allocator(&allocator);
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) TEST_MEM_SI_XML, strlen(TEST_MEM_SI_XML), &tree) == WBXML_OK);
+    wbxml_mem_use_allocator(previous);
+
+    ck_assert(allocator.allocs > 0);
+    ck_assert(ctx.live > 0);
+
+    /* Encoding it allocates with the same Allocator */
+    allocs = allocator.allocs;
+    ck_assert(wbxml_tree_add_text(tree, tree->root, (const WB_UTINY *) "text", 4) != NULL);
+    ck_assert(wbxml_tree_to_wbxml(tree, &wbxml, &wbxml_len, NULL) == WBXML_OK);
+    ck_assert(allocator.allocs > allocs);
+
+    wbxml_tree_destroy(tree);
+
+    /* Only the WBXML document is left */
+    ck_assert(ctx.live == 1);
+
+    previous = wbxml_mem_use_allocator(&allocator);
+    wbxml_free(wbxml);
+    wbxml_mem_use_allocator(previous);
+
+    ck_assert(ctx.live == 0);
+    ck_assert(allocator.allocs == allocator.frees);
+    ck_assert(allocator.bytes > 0);
+}
+END_TEST
+
+START_TEST (test_mem_allocator_conv)
+{
+    WBXMLAllocator allocator, *previous = NULL;
+    TestMemCtx ctx;
+    WB_ULONG i = 0;
+
+    /* Tables indexes are kept by the library: build them first */
+    ck_assert(test_mem_convert());
+
+    test_mem_init(&allocator, &ctx);
+
+    previous = wbxml_mem_use_allocator(&allocator);
+    for (i = 0; i < 3; i++)
+        ck_assert(test_mem_convert());
+    wbxml_mem_use_allocator(previous);
+
+    /* Every Memory Block is given back, and the same is done for each document */
+    ck_assert(ctx.live == 0);
+    ck_assert(allocator.allocs == allocator.frees);
+    ck_assert(allocator.allocs % 3 == 0);
+}
+END_TEST
+
+typedef struct TestMemThread_s {
+    WBXMLAllocator allocator;
+    TestMemCtx     ctx;
+    int            errors;
+} TestMemThread;
+
+static void *test_mem_thread(void *arg)
+{
+    TestMemThread *thread = (TestMemThread *) arg;
+    WB_ULONG i = 0;
+
+    wbxml_mem_use_allocator(&thread->allocator);
+
+    for (i = 0; i < TEST_MEM_ITERATIONS; i++) {
+        if (!test_mem_convert())
+            thread->errors++;
+    }
+
+    wbxml_mem_use_allocator(NULL);
+
+    return NULL;
+}
+
+START_TEST (test_mem_allocator_threads)
+{
+    TestMemThread threads[TEST_MEM_THREADS];
+    pthread_t ids[TEST_MEM_THREADS];
+    int i = 0;
+
+    ck_assert(test_mem_convert());
+
+    for (i = 0; i < TEST_MEM_THREADS; i++) {
+        test_mem_init(&threads[i].allocator, &threads[i].ctx);
+        threads[i].errors = 0;
+    }
+
+    for (i = 0; i < TEST_MEM_THREADS; i++)
+        ck_assert(pthread_create(&ids[i], NULL, test_mem_thread, &threads[i]) == 0);
+
+    for (i = 0; i < TEST_MEM_THREADS; i++)
+        ck_assert(pthread_join(ids[i], NULL) == 0);
+
+    /* Each thread only used its own Allocator */
+    for (i = 0; i < TEST_MEM_THREADS; i++) {
+        ck_assert(threads[i].errors == 0);
+        ck_assert(threads[i].ctx.live == 0);
+        ck_assert(threads[i].allocator.allocs == threads[0].allocator.allocs);
+        ck_assert(threads[i].allocator.bytes == threads[0].allocator.bytes);
+    }
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_mem)
+
+    ADD_TEST(test_mem_allocator_counters);
+    ADD_TEST(test_mem_allocator_scopes);
+    ADD_TEST(test_mem_allocator_parser);
+    ADD_TEST(test_mem_allocator_tree);
+    ADD_TEST(test_mem_allocator_conv);
+    ADD_TEST(test_mem_allocator_threads);
+
+END_TESTS
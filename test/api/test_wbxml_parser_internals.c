@@ -65,11 +65,583 @@ END_TEST
 
 #endif /* WBXML_SUPPORT_SI || WBXML_SUPPORT_EMN */
 
+#if defined( WBXML_SUPPORT_SI )
+
+/* Elements counters */
+typedef struct DepthCounters_s {
+    WB_ULONG depth;
+    WB_ULONG max_depth;
+    WB_ULONG starts;
+    WB_ULONG ends;
+} DepthCounters;
+
+static void depth_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **atts)
+{
+    DepthCounters *counters = (DepthCounters *) ctx;
+
+    counters->starts++;
+    if (++counters->depth > counters->max_depth)
+        counters->max_depth = counters->depth;
+}
+
+static void depth_end_element(void *ctx, WBXMLTag *element)
+{
+    DepthCounters *counters = (DepthCounters *) ctx;
+
+    counters->ends++;
+    counters->depth--;
+}
+
+/* SI 1.0 document with 'depth' nested <si> elements (the deepest one being empty) */
+static WB_UTINY *build_deep_document(WB_ULONG depth, WB_ULONG *len)
+{
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG i = 0, pos = 0;
+
+    if ((wbxml = wbxml_malloc(4 + 2 * depth)) == NULL)
+        return NULL;
+
+    /* WBXML 1.3, SI 1.0, UTF-8, no String Table */
+    wbxml[pos++] = 0x03;
+    wbxml[pos++] = 0x05;
+    wbxml[pos++] = 0x6A;
+    wbxml[pos++] = 0x00;
+
+    for (i = 0; i < depth - 1; i++)
+        wbxml[pos++] = 0x45;
+
+    wbxml[pos++] = 0x05;
+
+    for (i = 0; i < depth - 1; i++)
+        wbxml[pos++] = 0x01;
+
+    *len = pos;
+
+    return wbxml;
+}
+
+static WBXMLError parse_deep_document(WB_ULONG depth, WB_ULONG max_depth, WB_ULONG truncate, DepthCounters *counters)
+{
+    WBXMLContentHandler handler = { NULL, NULL, depth_start_element, depth_end_element, NULL, NULL };
+    WBXMLParser *parser = NULL;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG len = 0;
+    WBXMLError ret = WBXML_OK;
+
+    memset(counters, 0, sizeof(DepthCounters));
+
+    ck_assert((wbxml = build_deep_document(depth, &len)) != NULL);
+    ck_assert((parser = wbxml_parser_create()) != NULL);
+
+    wbxml_parser_set_user_data(parser, counters);
+    wbxml_parser_set_content_handler(parser, &handler);
+    wbxml_parser_set_max_depth(parser, max_depth);
+
+    ret = wbxml_parser_parse_static(parser, wbxml, len - truncate);
+
+    wbxml_parser_destroy(parser);
+    wbxml_free(wbxml);
+
+    return ret;
+}
+
+START_TEST (test_parser_deep_document)
+{
+    DepthCounters counters;
+
+    /* Nesting depth does not use the call stack */
+    ck_assert(parse_deep_document(200000, 0, 0, &counters) == WBXML_OK);
+    ck_assert(counters.starts == 200000);
+    ck_assert(counters.ends == 200000);
+    ck_assert(counters.max_depth == 200000);
+    ck_assert(counters.depth == 0);
+
+    /* Missing END tokens */
+    ck_assert(parse_deep_document(200000, 0, 10, &counters) == WBXML_ERROR_END_OF_BUFFER);
+    ck_assert(counters.starts == 200000);
+    ck_assert(counters.ends == 200000 - 10);
+}
+END_TEST
+
+START_TEST (test_parser_max_depth)
+{
+    DepthCounters counters;
+
+    /* Depth limit reached */
+    ck_assert(parse_deep_document(10, 10, 0, &counters) == WBXML_OK);
+    ck_assert(counters.starts == 10);
+    ck_assert(counters.ends == 10);
+
+    ck_assert(parse_deep_document(1, 1, 0, &counters) == WBXML_OK);
+    ck_assert(counters.starts == 1);
+
+    /* Depth limit exceeded (the deepest Element is empty) */
+    ck_assert(parse_deep_document(11, 10, 0, &counters) == WBXML_ERROR_MAX_DEPTH_EXCEEDED);
+    ck_assert(counters.starts == 10);
+    ck_assert(counters.ends == 0);
+
+    ck_assert(parse_deep_document(100000, 10, 0, &counters) == WBXML_ERROR_MAX_DEPTH_EXCEEDED);
+    ck_assert(counters.max_depth == 10);
+
+    /* NULL parser */
+    wbxml_parser_set_max_depth(NULL, 10);
+}
+END_TEST
+
+/* SI 1.0 document with a String Table, attributes, opaque, entity and strings */
+static const WB_UTINY feed_document[] = {
+    /* WBXML 1.3, SI 1.0, UTF-8, String Table: "abc" */
+    0x03, 0x05, 0x6A, 0x04, 'a', 'b', 'c', 0x00,
+    /* <si> */
+    0x45,
+    /* <indication href="http://x.com/" created="2002-04-16T00:00:00Z" si-id="abc"> */
+    0xC6,
+    0x0C, 0x03, 'x', 0x00, 0x85,
+    0x0A, 0xC3, 0x04, 0x20, 0x02, 0x04, 0x16,
+    0x11, 0x83, 0x00,
+    0x01,
+    /* Hello &#233; abc */
+    0x03, 'H', 'e', 'l', 'l', 'o', ' ', 0x00,
+    0x02, 0x81, 0x69,
+    0x83, 0x00,
+    /* </indication> </si> */
+    0x01,
+    0x01
+};
+
+/* Longest part of this document (the <indication> start) */
+#define FEED_DOCUMENT_LONGEST_PART 17
+
+/* Log of callbacks */
+static void log_start_document(void *ctx, WBXMLCharsetMIBEnum charset, const WBXMLLangEntry *lang)
+{
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "[start]");
+}
+
+static void log_end_document(void *ctx)
+{
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "[end]");
+}
+
+static void log_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **atts)
+{
+    WB_ULONG i = 0;
+
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "<");
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, wbxml_tag_get_xml_name(element));
+
+    for (i = 0; (atts != NULL) && (atts[i] != NULL); i++) {
+        wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, " ");
+        wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, wbxml_attribute_get_xml_name(atts[i]));
+        wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "=");
+        wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, wbxml_attribute_get_xml_value(atts[i]));
+    }
+
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, ">");
+}
+
+static void log_end_element(void *ctx, WBXMLTag *element)
+{
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "</");
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, wbxml_tag_get_xml_name(element));
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, ">");
+}
+
+static void log_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length)
+{
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "[");
+    wbxml_buffer_append_data((WBXMLBuffer *) ctx, ch + start, length);
+    wbxml_buffer_append_cstr((WBXMLBuffer *) ctx, "]");
+}
+
+static WBXMLContentHandler log_handler = {
+    log_start_document,
+    log_end_document,
+    log_start_element,
+    log_end_element,
+    log_characters,
+    NULL
+};
+
+/* Feed a document by chunks of 'chunk_len' bytes, the last one being final */
+static WBXMLError feed_document_by_chunks(WBXMLParser *parser, const WB_UTINY *wbxml, WB_ULONG len, WB_ULONG chunk_len, WB_ULONG *max_kept)
+{
+    WB_ULONG pos = 0, size = 0;
+    WBXMLError ret = WBXML_OK;
+
+    do {
+        size = (len - pos < chunk_len) ? len - pos : chunk_len;
+
+        if ((ret = wbxml_parser_feed(parser, wbxml + pos, size, (WB_BOOL) (pos + size == len))) != WBXML_OK)
+            return ret;
+
+        pos += size;
+
+        /* Only unconsumed bytes are kept */
+        if ((max_kept != NULL) && (parser->wbxml != NULL) && (wbxml_buffer_len(parser->wbxml) > *max_kept))
+            *max_kept = wbxml_buffer_len(parser->wbxml);
+    } while (pos < len);
+
+    return WBXML_OK;
+}
+
+START_TEST (test_parser_feed)
+{
+    WBXMLParser *parser = NULL;
+    WBXMLBuffer *expected = NULL, *log = NULL;
+    WB_ULONG chunk_len = 0, max_kept = 0;
+
+    ck_assert((parser = wbxml_parser_create()) != NULL);
+    ck_assert((expected = wbxml_buffer_create("", 0, 100)) != NULL);
+    ck_assert((log = wbxml_buffer_create("", 0, 100)) != NULL);
+
+    wbxml_parser_set_content_handler(parser, &log_handler);
+
+    /* Parsed at once */
+    wbxml_parser_set_user_data(parser, expected);
+    ck_assert(wbxml_parser_parse_static(parser, feed_document, sizeof(feed_document)) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(expected,
+              "[start]<si><indication href=http://x.com/ created=2002-04-16T00:00:00Z si-id=abc>"
+              "[Hello ][\xC3\xA9][abc]</indication></si>[end]") == 0);
+
+    /* Parsed by chunks: chunks cut tokens everywhere, and callbacks are the same */
+    wbxml_parser_set_user_data(parser, log);
+
+    for (chunk_len = 1; chunk_len <= sizeof(feed_document); chunk_len++) {
+        wbxml_buffer_delete(log, 0, wbxml_buffer_len(log));
+        max_kept = 0;
+
+        ck_assert(feed_document_by_chunks(parser, feed_document, sizeof(feed_document), chunk_len, &max_kept) == WBXML_OK);
+        ck_assert(wbxml_buffer_compare(log, expected) == 0);
+        ck_assert(max_kept < FEED_DOCUMENT_LONGEST_PART + chunk_len);
+    }
+
+    /* Callbacks are called as soon as possible: with the byte ending <si>, then with the one ending <indication> */
+    wbxml_buffer_delete(log, 0, wbxml_buffer_len(log));
+    ck_assert(wbxml_parser_feed(parser, feed_document, 9, FALSE) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(log, "[start]<si>") == 0);
+    ck_assert(wbxml_parser_feed(parser, feed_document + 9, 16, FALSE) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(log, "[start]<si>") == 0);
+    ck_assert(wbxml_parser_feed(parser, feed_document + 25, 1, FALSE) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(log, "[start]<si><indication href=http://x.com/ created=2002-04-16T00:00:00Z si-id=abc>") == 0);
+    ck_assert(wbxml_parser_feed(parser, feed_document + 26, sizeof(feed_document) - 26, FALSE) == WBXML_OK);
+    ck_assert(wbxml_parser_feed(parser, NULL, 0, TRUE) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare(log, expected) == 0);
+
+    /* Truncated document */
+    ck_assert(wbxml_parser_feed(parser, feed_document, sizeof(feed_document) - 1, FALSE) == WBXML_OK);
+    ck_assert(wbxml_parser_feed(parser, NULL, 0, TRUE) == WBXML_ERROR_END_OF_BUFFER);
+
+    /* Next call starts a new document */
+    wbxml_buffer_delete(log, 0, wbxml_buffer_len(log));
+    ck_assert(feed_document_by_chunks(parser, feed_document, sizeof(feed_document), 5, NULL) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare(log, expected) == 0);
+
+    /* Empty document */
+    ck_assert(wbxml_parser_feed(parser, NULL, 0, TRUE) == WBXML_ERROR_EMPTY_WBXML);
+    ck_assert(wbxml_parser_feed(NULL, feed_document, 1, TRUE) == WBXML_ERROR_NULL_PARSER);
+
+    wbxml_buffer_destroy(expected);
+    wbxml_buffer_destroy(log);
+    wbxml_parser_destroy(parser);
+}
+END_TEST
+
+START_TEST (test_parser_feed_deep_document)
+{
+    WBXMLContentHandler handler = { NULL, NULL, depth_start_element, depth_end_element, NULL, NULL };
+    WBXMLParser *parser = NULL;
+    DepthCounters counters;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG len = 0, max_kept = 0;
+
+    memset(&counters, 0, sizeof(DepthCounters));
+
+    ck_assert((wbxml = build_deep_document(200000, &len)) != NULL);
+    ck_assert((parser = wbxml_parser_create()) != NULL);
+
+    wbxml_parser_set_user_data(parser, &counters);
+    wbxml_parser_set_content_handler(parser, &handler);
+
+    /* Parsed bytes are not kept */
+    ck_assert(feed_document_by_chunks(parser, wbxml, len, 1000, &max_kept) == WBXML_OK);
+    ck_assert(counters.starts == 200000);
+    ck_assert(counters.ends == 200000);
+    ck_assert(max_kept <= 1000);
+
+    /* Abandoned in the middle of the document: open Elements are freed */
+    ck_assert(wbxml_parser_feed(parser, wbxml, len / 2, FALSE) == WBXML_OK);
+    ck_assert(parser->depth > 0);
+
+    wbxml_parser_destroy(parser);
+    wbxml_free(wbxml);
+}
+END_TEST
+
+#if defined( WBXML_SUPPORT_AIRSYNC )
+
+/* ActiveSync Sync, with Code Page switches */
+static const WB_UTINY skip_document[] = {
+    /* WBXML 1.3, unknown Public ID, UTF-8, no String Table */
+    0x03, 0x01, 0x6A, 0x00,
+    /* <Sync><Collections><Collection> */
+    0x45, 0x5C, 0x4F,
+    /* <SyncKey>42</SyncKey> <GetChanges/> */
+    0x4B, 0x03, '4', '2', 0x00, 0x01,
+    0x13,
+    /* <Commands><Add><ServerId>1:1</ServerId><ApplicationData><email:Body>Hello</email:Body></ApplicationData></Add></Commands> */
+    0x56, 0x47,
+    0x4D, 0x03, '1', ':', '1', 0x00, 0x01,
+    0x5D, 0x00, 0x02, 0x4C, 0xC3, 0x05, 'H', 'e', 'l', 'l', 'o', 0x01, 0x01,
+    0x01, 0x01,
+    /* <email:Body>B</email:Body> (Code Page switched in Commands) */
+    0x4C, 0x03, 'B', 0x00, 0x01,
+    /* <AirSync:Status>1</AirSync:Status> */
+    0x00, 0x00, 0x4E, 0x03, '1', 0x00, 0x01,
+    /* </Collection></Collections></Sync> */
+    0x01, 0x01, 0x01
+};
+
+/* Log of callbacks, skipping Elements with a given name */
+typedef struct SkipContext_s {
+    WBXMLParser *parser;
+    WBXMLBuffer *log;
+    const char  *skipped;
+} SkipContext;
+
+static void skip_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **atts)
+{
+    SkipContext *skip = (SkipContext *) ctx;
+
+    log_start_element(skip->log, element, atts);
+
+    if (strcmp((const char *) wbxml_tag_get_xml_name(element), skip->skipped) == 0)
+        wbxml_parser_skip_element(skip->parser);
+}
+
+static void skip_end_element(void *ctx, WBXMLTag *element)
+{
+    log_end_element(((SkipContext *) ctx)->log, element);
+}
+
+static void skip_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length)
+{
+    log_characters(((SkipContext *) ctx)->log, ch, start, length);
+}
+
+static WBXMLContentHandler skip_handler = {
+    NULL,
+    NULL,
+    skip_start_element,
+    skip_end_element,
+    skip_characters,
+    NULL
+};
+
+static void check_skip(SkipContext *skip, const char *skipped, const char *expected)
+{
+    WB_ULONG chunk_len = 0;
+
+    skip->skipped = skipped;
+
+    /* Parsed at once */
+    wbxml_buffer_delete(skip->log, 0, wbxml_buffer_len(skip->log));
+    ck_assert(wbxml_parser_parse_static(skip->parser, skip_document, sizeof(skip_document)) == WBXML_OK);
+    ck_assert(wbxml_buffer_compare_cstr(skip->log, expected) == 0);
+
+    /* Parsed by chunks */
+    for (chunk_len = 1; chunk_len <= sizeof(skip_document); chunk_len++) {
+        wbxml_buffer_delete(skip->log, 0, wbxml_buffer_len(skip->log));
+        ck_assert(feed_document_by_chunks(skip->parser, skip_document, sizeof(skip_document), chunk_len, NULL) == WBXML_OK);
+        ck_assert(wbxml_buffer_compare_cstr(skip->log, expected) == 0);
+    }
+}
+
+START_TEST (test_parser_skip_element)
+{
+    SkipContext skip;
+
+    ck_assert((skip.parser = wbxml_parser_create()) != NULL);
+    ck_assert((skip.log = wbxml_buffer_create("", 0, 100)) != NULL);
+
+    wbxml_parser_set_language(skip.parser, WBXML_LANG_ACTIVESYNC);
+    wbxml_parser_set_user_data(skip.parser, &skip);
+    wbxml_parser_set_content_handler(skip.parser, &skip_handler);
+
+    /* Nothing skipped */
+    check_skip(&skip, "",
+               "<Sync><Collections><Collection><SyncKey>[42]</SyncKey><GetChanges></GetChanges>"
+               "<Commands><Add><ServerId>[1:1]</ServerId><ApplicationData><Body>[Hello]</Body></ApplicationData></Add></Commands>"
+               "<Body>[B]</Body><Status>[1]</Status></Collection></Collections></Sync>");
+
+    /* Opaque content, and Code Page switch, skipped */
+    check_skip(&skip, "ApplicationData",
+               "<Sync><Collections><Collection><SyncKey>[42]</SyncKey><GetChanges></GetChanges>"
+               "<Commands><Add><ServerId>[1:1]</ServerId><ApplicationData></ApplicationData></Add></Commands>"
+               "<Body>[B]</Body><Status>[1]</Status></Collection></Collections></Sync>");
+
+    /* Nested Elements skipped */
+    check_skip(&skip, "Commands",
+               "<Sync><Collections><Collection><SyncKey>[42]</SyncKey><GetChanges></GetChanges>"
+               "<Commands></Commands>"
+               "<Body>[B]</Body><Status>[1]</Status></Collection></Collections></Sync>");
+
+    /* Root Element skipped */
+    check_skip(&skip, "Sync", "<Sync></Sync>");
+
+    /* Empty Element: nothing to skip */
+    check_skip(&skip, "GetChanges",
+               "<Sync><Collections><Collection><SyncKey>[42]</SyncKey><GetChanges></GetChanges>"
+               "<Commands><Add><ServerId>[1:1]</ServerId><ApplicationData><Body>[Hello]</Body></ApplicationData></Add></Commands>"
+               "<Body>[B]</Body><Status>[1]</Status></Collection></Collections></Sync>");
+
+    /* Depth limit still applies to skipped Elements */
+    skip.skipped = "Commands";
+    wbxml_parser_set_max_depth(skip.parser, 7);
+    ck_assert(wbxml_parser_parse_static(skip.parser, skip_document, sizeof(skip_document)) == WBXML_OK);
+    wbxml_parser_set_max_depth(skip.parser, 6);
+    ck_assert(wbxml_parser_parse_static(skip.parser, skip_document, sizeof(skip_document)) == WBXML_ERROR_MAX_DEPTH_EXCEEDED);
+
+    /* Truncated in skipped Element */
+    wbxml_parser_set_max_depth(skip.parser, 0);
+    ck_assert(wbxml_parser_parse_static(skip.parser, skip_document, 30) == WBXML_ERROR_END_OF_BUFFER);
+
+    /* NULL parser */
+    wbxml_parser_skip_element(NULL);
+
+    wbxml_buffer_destroy(skip.log);
+    wbxml_parser_destroy(skip.parser);
+}
+END_TEST
+
+/* Contents given to callback */
+typedef struct SliceLog_s {
+    const WB_UTINY *data[8];
+    WB_ULONG        len[8];
+    WB_ULONG        nb;
+} SliceLog;
+
+static void slice_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length)
+{
+    SliceLog *slices = (SliceLog *) ctx;
+
+    if (slices->nb < 8) {
+        slices->data[slices->nb] = ch + start;
+        slices->len[slices->nb] = length;
+        slices->nb++;
+    }
+}
+
+START_TEST (test_parser_content_slices)
+{
+    WBXMLContentHandler handler = { NULL, NULL, NULL, NULL, slice_characters, NULL };
+    WBXMLParser *parser = NULL;
+    SliceLog slices;
+
+    ck_assert((parser = wbxml_parser_create()) != NULL);
+
+    wbxml_parser_set_user_data(parser, &slices);
+    wbxml_parser_set_content_handler(parser, &handler);
+
+    /* Inline strings are given as is, opaque content is copied */
+    memset(&slices, 0, sizeof(SliceLog));
+    wbxml_parser_set_language(parser, WBXML_LANG_ACTIVESYNC);
+    ck_assert(wbxml_parser_parse_static(parser, skip_document, sizeof(skip_document)) == WBXML_OK);
+    ck_assert(slices.nb == 5);
+    ck_assert((slices.data[0] == skip_document + 9) && (slices.len[0] == 2));
+    ck_assert((slices.data[1] == skip_document + 18) && (slices.len[1] == 3));
+    ck_assert((slices.data[2] != skip_document + 29) && (slices.len[2] == 5));
+
+    /* Borrowed content: opaque content is given as is too */
+    memset(&slices, 0, sizeof(SliceLog));
+    wbxml_parser_set_borrowed_content(parser, TRUE);
+    ck_assert(wbxml_parser_parse_static(parser, skip_document, sizeof(skip_document)) == WBXML_OK);
+    ck_assert(slices.nb == 5);
+    ck_assert((slices.data[2] == skip_document + 29) && (slices.len[2] == 5));
+
+    /* String Table references are given as is, entities are converted */
+    memset(&slices, 0, sizeof(SliceLog));
+    wbxml_parser_set_language(parser, WBXML_LANG_UNKNOWN);
+    ck_assert(wbxml_parser_parse_static(parser, feed_document, sizeof(feed_document)) == WBXML_OK);
+    ck_assert(slices.nb == 3);
+    ck_assert((slices.data[0] == feed_document + 27) && (slices.len[0] == 6));
+    ck_assert((slices.data[1] != feed_document + 35) && (slices.len[1] == 2));
+    ck_assert((slices.data[2] == wbxml_buffer_get_cstr(parser->strstbl)) && (slices.len[2] == 3));
+
+    /* NULL parser */
+    wbxml_parser_set_borrowed_content(NULL, TRUE);
+
+    wbxml_parser_destroy(parser);
+}
+END_TEST
+
+/* WBXML 1.3, SI 1.0, ISO-8859-1, String Table: "abc" "d\xE9f" */
+static const WB_UTINY latin1_document[] = {
+    0x03, 0x05, 0x04, 0x08, 'a', 'b', 'c', 0x00, 'd', 0xE9, 'f', 0x00,
+    /* <si> <indication si-id="abc"> */
+    0x45,
+    0xC6, 0x11, 0x83, 0x00, 0x01,
+    /* déf déf éf */
+    0x83, 0x04,
+    0x83, 0x04,
+    0x83, 0x05,
+    /* </indication> </si> */
+    0x01,
+    0x01
+};
+
+START_TEST (test_parser_strtbl_cache)
+{
+    WBXMLContentHandler handler = { NULL, NULL, NULL, NULL, slice_characters, NULL };
+    WBXMLParser *parser = NULL;
+    SliceLog slices;
+
+    ck_assert((parser = wbxml_parser_create()) != NULL);
+
+    wbxml_parser_set_user_data(parser, &slices);
+    wbxml_parser_set_content_handler(parser, &handler);
+
+    /* Each String Table entry is converted once, even when referenced from its middle */
+    memset(&slices, 0, sizeof(SliceLog));
+    ck_assert(wbxml_parser_parse_static(parser, latin1_document, sizeof(latin1_document)) == WBXML_OK);
+    ck_assert(slices.nb == 3);
+    ck_assert((slices.len[0] == 4) && (memcmp(slices.data[0], "d\xC3\xA9" "f", 4) == 0));
+    ck_assert((slices.data[1] == slices.data[0]) && (slices.len[1] == 4));
+    ck_assert((slices.len[2] == 3) && (memcmp(slices.data[2], "\xC3\xA9" "f", 3) == 0));
+    ck_assert(parser->strtbl_cache_nb == 3);
+
+    /* The cache is emptied for next Document: in UTF-8, nothing is converted */
+    memset(&slices, 0, sizeof(SliceLog));
+    ck_assert(wbxml_parser_parse_static(parser, feed_document, sizeof(feed_document)) == WBXML_OK);
+    ck_assert(slices.nb == 3);
+    ck_assert(parser->strtbl_cache_nb == 0);
+
+    wbxml_parser_destroy(parser);
+}
+END_TEST
+
+#endif /* WBXML_SUPPORT_AIRSYNC */
+
+#endif /* WBXML_SUPPORT_SI */
+
 BEGIN_TESTS(wbxml_parser_internals)
 
 #if ( defined( WBXML_SUPPORT_SI ) || defined( WBXML_SUPPORT_EMN ) )
     ADD_TEST(test_parser_decode_datetime);
 #endif /* WBXML_SUPPORT_SI || WBXML_SUPPORT_EMN */
 
+#if defined( WBXML_SUPPORT_SI )
+    ADD_TEST(test_parser_deep_document);
+    ADD_TEST(test_parser_max_depth);
+    ADD_TEST(test_parser_feed);
+    ADD_TEST(test_parser_feed_deep_document);
+
+#if defined( WBXML_SUPPORT_AIRSYNC )
+    ADD_TEST(test_parser_skip_element);
+    ADD_TEST(test_parser_content_slices);
+    ADD_TEST(test_parser_strtbl_cache);
+#endif /* WBXML_SUPPORT_AIRSYNC */
+#endif /* WBXML_SUPPORT_SI */
+
 END_TESTS
 
@@ -0,0 +1,275 @@
+#include "api_test.h"
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_reader.h"
+#include "../../src/wbxml_internals.h"
+
+#if defined( WBXML_SUPPORT_SI )
+
+static const WB_UTINY si_document[] = {
+    /* WBXML 1.3, SI 1.0, UTF-8, String Table: "abc" */
+    0x03, 0x05, 0x6A, 0x04, 'a', 'b', 'c', 0x00,
+    /* <si> */
+    0x45,
+    /* <indication href="http://x.com/" created="2002-04-16T00:00:00Z" si-id="abc"> */
+    0xC6,
+    0x0C, 0x03, 'x', 0x00, 0x85,
+    0x0A, 0xC3, 0x04, 0x20, 0x02, 0x04, 0x16,
+    0x11, 0x83, 0x00,
+    0x01,
+    /* Hello &#233; abc */
+    0x03, 'H', 'e', 'l', 'l', 'o', ' ', 0x00,
+    0x02, 0x81, 0x69,
+    0x83, 0x00,
+    /* </indication> </si> */
+    0x01,
+    0x01
+};
+
+static void check_next(WBXMLReader *reader, WBXMLReaderEvent *event, WBXMLReaderEventType type, WB_ULONG depth, const char *name)
+{
+    ck_assert(wbxml_reader_next(reader, event) == WBXML_OK);
+    ck_assert(event->type == type);
+    ck_assert(event->depth == depth);
+
+    if (name != NULL) {
+        ck_assert(event->name_len == strlen(name));
+        ck_assert(memcmp(event->name, name, event->name_len) == 0);
+    }
+}
+
+static void check_value(WBXMLReaderEvent *event, WBXMLReaderValueType type, const char *data)
+{
+    ck_assert(event->value_type == type);
+    ck_assert(event->len == strlen(data));
+    ck_assert(memcmp(event->data, data, event->len) == 0);
+}
+
+START_TEST (test_reader_events)
+{
+    WBXMLReader *reader = wbxml_reader_create();
+    WBXMLReaderEvent event;
+
+    ck_assert(reader != NULL);
+    ck_assert(wbxml_reader_set_input(reader, si_document, sizeof(si_document)) == WBXML_OK);
+
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    ck_assert(wbxml_reader_get_lang_table(reader) != NULL);
+    ck_assert(wbxml_reader_get_lang_table(reader)->langID == WBXML_LANG_SI10);
+    ck_assert(wbxml_reader_get_charset(reader) == WBXML_CHARSET_UTF_8);
+
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "si");
+    ck_assert(event.tag != NULL);
+    ck_assert(event.has_content);
+
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 2, "indication");
+
+    /* href="http://" "x" ".com/" */
+    check_next(reader, &event, WBXML_READER_ATTRIBUTE, 2, "href");
+    ck_assert(event.attr != NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "http://");
+
+    check_next(reader, &event, WBXML_READER_VALUE, 2, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "x");
+    ck_assert(event.data == si_document + 12);
+
+    check_next(reader, &event, WBXML_READER_VALUE, 2, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, ".com/");
+
+    /* Opaque date is not decoded */
+    check_next(reader, &event, WBXML_READER_ATTRIBUTE, 2, "created");
+    ck_assert(event.value_type == WBXML_READER_VALUE_NONE);
+
+    check_next(reader, &event, WBXML_READER_VALUE, 2, NULL);
+    ck_assert(event.value_type == WBXML_READER_VALUE_OPAQUE);
+    ck_assert(event.len == 4);
+    ck_assert(event.data == si_document + 18);
+
+    /* String Table reference */
+    check_next(reader, &event, WBXML_READER_ATTRIBUTE, 2, "si-id");
+    check_next(reader, &event, WBXML_READER_VALUE, 2, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "abc");
+    ck_assert(event.data == si_document + 4);
+
+    /* Contents */
+    check_next(reader, &event, WBXML_READER_CONTENT, 2, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "Hello ");
+
+    check_next(reader, &event, WBXML_READER_CONTENT, 2, NULL);
+    ck_assert(event.value_type == WBXML_READER_VALUE_ENTITY);
+    ck_assert(event.code == 0xE9);
+
+    check_next(reader, &event, WBXML_READER_CONTENT, 2, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "abc");
+
+    check_next(reader, &event, WBXML_READER_END_ELEMENT, 2, "indication");
+    check_next(reader, &event, WBXML_READER_END_ELEMENT, 1, "si");
+    check_next(reader, &event, WBXML_READER_END_DOCUMENT, 0, NULL);
+    ck_assert(wbxml_reader_get_current_byte_index(reader) == sizeof(si_document));
+
+    /* Last Event is returned again */
+    check_next(reader, &event, WBXML_READER_END_DOCUMENT, 0, NULL);
+
+    /* Read again */
+    ck_assert(wbxml_reader_set_input(reader, si_document, sizeof(si_document)) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "si");
+
+    wbxml_reader_destroy(reader);
+}
+END_TEST
+
+START_TEST (test_reader_errors)
+{
+    WBXMLReader *reader = wbxml_reader_create();
+    WBXMLReaderEvent event;
+    WBXMLError ret = WBXML_OK;
+    WB_UTINY unknown[sizeof(si_document)];
+    WB_ULONG len = 0;
+
+    ck_assert(reader != NULL);
+
+    ck_assert(wbxml_reader_set_input(NULL, si_document, sizeof(si_document)) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_reader_next(NULL, &event) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_reader_next(reader, NULL) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_reader_skip(NULL) == WBXML_ERROR_BAD_PARAMETER);
+
+    /* No Document */
+    ck_assert(wbxml_reader_next(reader, &event) == WBXML_ERROR_EMPTY_WBXML);
+    ck_assert(wbxml_reader_set_input(reader, si_document, 0) == WBXML_ERROR_EMPTY_WBXML);
+    ck_assert(wbxml_reader_next(reader, &event) == WBXML_ERROR_EMPTY_WBXML);
+
+    /* Truncated Document: an error is met, and returned again */
+    for (len = 1; len < sizeof(si_document); len++) {
+        ck_assert(wbxml_reader_set_input(reader, si_document, len) == WBXML_OK);
+
+        while ((ret = wbxml_reader_next(reader, &event)) == WBXML_OK)
+            ck_assert(event.type != WBXML_READER_END_DOCUMENT);
+
+        ck_assert(wbxml_reader_next(reader, &event) == ret);
+        ck_assert(wbxml_reader_get_current_byte_index(reader) <= len);
+    }
+
+    /* Unknown Public ID, unless Language is forced */
+    memcpy(unknown, si_document, sizeof(si_document));
+    unknown[1] = 0x01;
+
+    ck_assert(wbxml_reader_set_input(reader, unknown, sizeof(unknown)) == WBXML_OK);
+    ck_assert(wbxml_reader_next(reader, &event) == WBXML_ERROR_UNKNOWN_PUBLIC_ID);
+
+    ck_assert(wbxml_reader_set_language(reader, WBXML_LANG_SI10));
+    ck_assert(wbxml_reader_set_input(reader, unknown, sizeof(unknown)) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "si");
+
+    wbxml_reader_destroy(reader);
+}
+END_TEST
+
+#endif /* WBXML_SUPPORT_SI */
+
+#if defined( WBXML_SUPPORT_AIRSYNC )
+
+static const WB_UTINY activesync_document[] = {
+    /* WBXML 1.3, unknown Public ID, UTF-8, no String Table */
+    0x03, 0x01, 0x6A, 0x00,
+    /* <Sync><Collections><Collection> */
+    0x45, 0x5C, 0x4F,
+    /* <SyncKey>42</SyncKey> <CollectionId>1</CollectionId> <GetChanges/> */
+    0x4B, 0x03, '4', '2', 0x00, 0x01,
+    0x52, 0x03, '1', 0x00, 0x01,
+    0x13,
+    /* <Commands><Add><ServerId>1:1</ServerId><ApplicationData><email:Body>Hello</email:Body></ApplicationData></Add></Commands> */
+    0x56, 0x47,
+    0x4D, 0x03, '1', ':', '1', 0x00, 0x01,
+    0x5D, 0x00, 0x02, 0x4C, 0x03, 'H', 'e', 'l', 'l', 'o', 0x00, 0x01, 0x01,
+    0x01, 0x01,
+    /* <AirSync:Status>1</AirSync:Status> */
+    0x00, 0x00, 0x4E, 0x03, '1', 0x00, 0x01,
+    /* </Collection></Collections></Sync> */
+    0x01, 0x01, 0x01
+};
+
+START_TEST (test_reader_skip)
+{
+    WBXMLReader *reader = wbxml_reader_create();
+    WBXMLReaderEvent event;
+
+    ck_assert(reader != NULL);
+    ck_assert(wbxml_reader_set_language(reader, WBXML_LANG_ACTIVESYNC));
+    ck_assert(wbxml_reader_set_input(reader, activesync_document, sizeof(activesync_document)) == WBXML_OK);
+
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "Sync");
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 2, "Collections");
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 3, "Collection");
+
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 4, "SyncKey");
+    check_next(reader, &event, WBXML_READER_CONTENT, 4, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "42");
+    ck_assert(event.data == activesync_document + 9);
+
+    /* Skip rest of SyncKey */
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+
+    /* Skip whole CollectionId */
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 4, "CollectionId");
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+
+    /* Empty Element */
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 4, "GetChanges");
+    ck_assert(!event.has_content);
+    check_next(reader, &event, WBXML_READER_END_ELEMENT, 4, "GetChanges");
+
+    /* Skip Commands: Code Page switched inside is kept */
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 4, "Commands");
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 4, "Status");
+    ck_assert(event.tag != NULL);
+    ck_assert(event.tag->wbxmlCodePage == 0x00);
+    check_next(reader, &event, WBXML_READER_CONTENT, 4, NULL);
+    check_value(&event, WBXML_READER_VALUE_STRING, "1");
+
+    /* Skip up to the end of Document */
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_END_DOCUMENT, 0, NULL);
+
+    /* No open Element */
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+
+    /* Stop reading in the middle of Document, and read it again */
+    ck_assert(wbxml_reader_set_input(reader, activesync_document, sizeof(activesync_document)) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "Sync");
+    ck_assert(wbxml_reader_skip(reader) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_END_DOCUMENT, 0, NULL);
+
+    /* Skip in a truncated Document */
+    ck_assert(wbxml_reader_set_input(reader, activesync_document, sizeof(activesync_document) - 1) == WBXML_OK);
+    check_next(reader, &event, WBXML_READER_START_DOCUMENT, 0, NULL);
+    check_next(reader, &event, WBXML_READER_START_ELEMENT, 1, "Sync");
+    ck_assert(wbxml_reader_skip(reader) == WBXML_ERROR_END_OF_BUFFER);
+    ck_assert(wbxml_reader_next(reader, &event) == WBXML_ERROR_END_OF_BUFFER);
+
+    wbxml_reader_destroy(reader);
+}
+END_TEST
+
+#endif /* WBXML_SUPPORT_AIRSYNC */
+
+BEGIN_TESTS(wbxml_reader)
+
+#if defined( WBXML_SUPPORT_SI )
+    ADD_TEST(test_reader_events);
+    ADD_TEST(test_reader_errors);
+#endif /* WBXML_SUPPORT_SI */
+
+#if defined( WBXML_SUPPORT_AIRSYNC )
+    ADD_TEST(test_reader_skip);
+#endif /* WBXML_SUPPORT_AIRSYNC */
+
+END_TESTS
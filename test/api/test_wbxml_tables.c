@@ -0,0 +1,273 @@
+#include "api_test.h"
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_tables.h"
+
+/* Sequential search, as parser did before Token Index */
+static const WBXMLTagEntry *search_tag(const WBXMLLangEntry *lang, WB_UTINY code_page, WB_UTINY token)
+{
+    WB_ULONG i = 0;
+
+    while (lang->tagTable[i].xmlName != NULL) {
+        if ((lang->tagTable[i].wbxmlToken == token) && (lang->tagTable[i].wbxmlCodePage == code_page))
+            return &(lang->tagTable[i]);
+        i++;
+    }
+
+    return NULL;
+}
+
+static const WBXMLAttrEntry *search_attr(const WBXMLLangEntry *lang, WB_UTINY code_page, WB_UTINY token)
+{
+    WB_ULONG i = 0;
+
+    while (lang->attrTable[i].xmlName != NULL) {
+        if ((lang->attrTable[i].wbxmlToken == token) && (lang->attrTable[i].wbxmlCodePage == code_page))
+            return &(lang->attrTable[i]);
+        i++;
+    }
+
+    return NULL;
+}
+
+static const WBXMLAttrValueEntry *search_attr_value(const WBXMLLangEntry *lang, WB_UTINY code_page, WB_UTINY token)
+{
+    WB_ULONG i = 0;
+
+    while (lang->attrValueTable[i].xmlName != NULL) {
+        if ((lang->attrValueTable[i].wbxmlToken == token) && (lang->attrValueTable[i].wbxmlCodePage == code_page))
+            return &(lang->attrValueTable[i]);
+        i++;
+    }
+
+    return NULL;
+}
+
+static const WBXMLExtValueEntry *search_ext(const WBXMLLangEntry *lang, WB_ULONG token)
+{
+    WB_ULONG i = 0;
+
+    while (lang->extValueTable[i].xmlName != NULL) {
+        if (lang->extValueTable[i].wbxmlToken == token)
+            return &(lang->extValueTable[i]);
+        i++;
+    }
+
+    return NULL;
+}
+
+static void check_lang_tokens(const WBXMLLangEntry *lang)
+{
+    WB_ULONG code_page = 0, token = 0;
+
+    for (code_page = 0; code_page < 256; code_page++) {
+        for (token = 0; token < 256; token++) {
+            if (lang->tagTable != NULL)
+                ck_assert(wbxml_tables_get_tag_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) ==
+                          search_tag(lang, (WB_UTINY) code_page, (WB_UTINY) token));
+            else
+                ck_assert(wbxml_tables_get_tag_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) == NULL);
+
+            if (lang->attrTable != NULL)
+                ck_assert(wbxml_tables_get_attr_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) ==
+                          search_attr(lang, (WB_UTINY) code_page, (WB_UTINY) token));
+            else
+                ck_assert(wbxml_tables_get_attr_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) == NULL);
+
+            if (lang->attrValueTable != NULL)
+                ck_assert(wbxml_tables_get_attr_value_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) ==
+                          search_attr_value(lang, (WB_UTINY) code_page, (WB_UTINY) token));
+            else
+                ck_assert(wbxml_tables_get_attr_value_from_token(lang, (WB_UTINY) code_page, (WB_UTINY) token) == NULL);
+        }
+    }
+
+    for (token = 0; token < 512; token++) {
+        if (lang->extValueTable != NULL)
+            ck_assert(wbxml_tables_get_ext_from_token(lang, token) == search_ext(lang, token));
+        else
+            ck_assert(wbxml_tables_get_ext_from_token(lang, token) == NULL);
+    }
+}
+
+START_TEST (test_tables_token_lookup_main_table)
+{
+    const WBXMLLangEntry *main_table = wbxml_tables_get_main();
+    WB_ULONG i = 0;
+
+    ck_assert(main_table != NULL);
+
+    /* Twice: first call builds Token Index, second one uses it */
+    for (i = 0; main_table[i].langID != WBXML_LANG_UNKNOWN; i++) {
+        check_lang_tokens(&main_table[i]);
+        check_lang_tokens(&main_table[i]);
+    }
+}
+END_TEST
+
+START_TEST (test_tables_token_lookup_user_table)
+{
+    const WBXMLLangEntry *main_table = wbxml_tables_get_main();
+    WBXMLLangEntry user_table;
+    WB_ULONG i = 0;
+
+    ck_assert(main_table != NULL);
+
+    /* A Language Table that is not part of Main Table is searched sequentially */
+    for (i = 0; main_table[i].langID != WBXML_LANG_UNKNOWN; i++) {
+        memcpy(&user_table, &main_table[i], sizeof(WBXMLLangEntry));
+        check_lang_tokens(&user_table);
+    }
+}
+END_TEST
+
+static void check_tag_from_xml(const WBXMLLangEntry *lang, const WBXMLLangEntry *user_table, const WB_UTINY *name)
+{
+    int code_page = 0;
+
+    for (code_page = -1; code_page < 300; code_page++)
+        ck_assert(wbxml_tables_get_tag_from_xml(lang, code_page, name) ==
+                  wbxml_tables_get_tag_from_xml(user_table, code_page, name));
+}
+
+static void check_attr_from_xml(const WBXMLLangEntry *lang, const WBXMLLangEntry *user_table, WB_UTINY *name, WB_UTINY *value)
+{
+    WB_UTINY *left = NULL, *user_left = NULL;
+
+    ck_assert(wbxml_tables_get_attr_from_xml(lang, name, value, &left) ==
+              wbxml_tables_get_attr_from_xml(user_table, name, value, &user_left));
+    ck_assert(left == user_left);
+}
+
+START_TEST (test_tables_name_lookup)
+{
+    const WBXMLLangEntry *main_table = wbxml_tables_get_main();
+    const WBXMLLangEntry *lang = NULL;
+    WBXMLLangEntry user_table;
+    WB_UTINY value[256];
+    WB_ULONG i = 0, j = 0, k = 0, len = 0;
+
+    ck_assert(main_table != NULL);
+
+    for (i = 0; main_table[i].langID != WBXML_LANG_UNKNOWN; i++) {
+        lang = &main_table[i];
+
+        /* Not part of Main Table: searched sequentially */
+        memcpy(&user_table, lang, sizeof(WBXMLLangEntry));
+
+        check_tag_from_xml(lang, &user_table, (const WB_UTINY *) "unknown-tag");
+
+        for (j = 0; (lang->tagTable != NULL) && (lang->tagTable[j].xmlName != NULL); j++)
+            check_tag_from_xml(lang, &user_table, (const WB_UTINY *) lang->tagTable[j].xmlName);
+
+        if (lang->attrTable == NULL)
+            continue;
+
+        check_attr_from_xml(lang, &user_table, (WB_UTINY *) "unknown-attr", NULL);
+        check_attr_from_xml(lang, &user_table, (WB_UTINY *) "unknown-attr", (WB_UTINY *) "value");
+
+        for (j = 0; lang->attrTable[j].xmlName != NULL; j++) {
+            WB_UTINY *name = (WB_UTINY *) lang->attrTable[j].xmlName;
+
+            check_attr_from_xml(lang, &user_table, name, NULL);
+            check_attr_from_xml(lang, &user_table, name, (WB_UTINY *) "");
+            check_attr_from_xml(lang, &user_table, name, (WB_UTINY *) "value");
+
+            for (k = 0; lang->attrTable[k].xmlName != NULL; k++) {
+                if (lang->attrTable[k].xmlValue == NULL)
+                    continue;
+
+                len = WBXML_STRLEN(lang->attrTable[k].xmlValue);
+                if (len + 8 > sizeof(value))
+                    continue;
+
+                /* Exact Value */
+                memcpy(value, lang->attrTable[k].xmlValue, len + 1);
+                check_attr_from_xml(lang, &user_table, name, value);
+
+                /* Value followed by something else */
+                memcpy(value + len, "/x.wml", 7);
+                check_attr_from_xml(lang, &user_table, name, value);
+
+                /* Start of Value */
+                if (len > 1) {
+                    value[len - 1] = '\0';
+                    check_attr_from_xml(lang, &user_table, name, value);
+                }
+            }
+        }
+    }
+}
+END_TEST
+
+START_TEST (test_tables_attr_value_matcher)
+{
+    const WBXMLLangEntry *main_table = wbxml_tables_get_main();
+    const WBXMLMatcher *matcher = NULL;
+    WBXMLLangEntry user_table;
+    WBXMLMatchSet set;
+    WB_ULONG i = 0, j = 0;
+
+    ck_assert(main_table != NULL);
+
+    wbxml_match_set_init(&set);
+
+    for (i = 0; main_table[i].langID != WBXML_LANG_UNKNOWN; i++) {
+        if (main_table[i].attrValueTable == NULL) {
+            ck_assert(wbxml_tables_get_attr_value_matcher(&main_table[i]) == NULL);
+            continue;
+        }
+
+        /* Built once, then shared */
+        ck_assert((matcher = wbxml_tables_get_attr_value_matcher(&main_table[i])) != NULL);
+        ck_assert(wbxml_tables_get_attr_value_matcher(&main_table[i]) == matcher);
+
+        /* Each Attribute Value is found, with the position of its (first) entry in table */
+        for (j = 0; main_table[i].attrValueTable[j].xmlName != NULL; j++) {
+            const WB_TINY *name = main_table[i].attrValueTable[j].xmlName;
+            WB_ULONG k = 0;
+
+            set.len = 0;
+            ck_assert(wbxml_matcher_search(matcher, (const WB_UTINY *) name, WBXML_STRLEN(name), 0, &set));
+
+            for (k = 0; k < set.len; k++) {
+                if ((set.matches[k].pos == 0) && (set.matches[k].len == WBXML_STRLEN(name)))
+                    break;
+            }
+
+            ck_assert(k < set.len);
+            ck_assert(set.matches[k].value == set.matches[k].pattern);
+            ck_assert(set.matches[k].value <= j);
+            ck_assert(WBXML_STRCMP(main_table[i].attrValueTable[set.matches[k].value].xmlName, name) == 0);
+        }
+
+        ck_assert(wbxml_matcher_count(matcher) == j);
+
+        /* Not part of Main Table */
+        memcpy(&user_table, &main_table[i], sizeof(WBXMLLangEntry));
+        ck_assert(wbxml_tables_get_attr_value_matcher(&user_table) == NULL);
+    }
+
+    wbxml_match_set_clean(&set);
+}
+END_TEST
+
+START_TEST (test_tables_token_lookup_null_params)
+{
+    ck_assert(wbxml_tables_get_tag_from_token(NULL, 0, 0x05) == NULL);
+    ck_assert(wbxml_tables_get_attr_from_token(NULL, 0, 0x05) == NULL);
+    ck_assert(wbxml_tables_get_attr_value_from_token(NULL, 0, 0x85) == NULL);
+    ck_assert(wbxml_tables_get_ext_from_token(NULL, 0x05) == NULL);
+    ck_assert(wbxml_tables_get_attr_value_matcher(NULL) == NULL);
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_tables)
+
+    ADD_TEST(test_tables_token_lookup_main_table);
+    ADD_TEST(test_tables_token_lookup_user_table);
+    ADD_TEST(test_tables_token_lookup_null_params);
+    ADD_TEST(test_tables_name_lookup);
+    ADD_TEST(test_tables_attr_value_matcher);
+
+END_TESTS
@@ -0,0 +1,307 @@
+#include "api_test.h"
+
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_template.h"
+#include "../../src/wbxml_encoder.h"
+#include "../../src/wbxml_mem.h"
+
+#define TEST_TEMPLATE_FOLDERSYNC_XML(sync_key, calendar, contacts) \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE ActiveSync PUBLIC \"-//MICROSOFT//DTD ActiveSync//EN\" \"http://www.microsoft.com/\">" \
+    "<FolderSync xmlns=\"FolderHierarchy:\"><Status>1</Status><SyncKey>" sync_key "</SyncKey>" \
+    "<Changes><Count>2</Count>" \
+    "<Add><ServerId>1</ServerId><ParentId>0</ParentId><DisplayName>" calendar "</DisplayName><Type>8</Type></Add>" \
+    "<Add><ServerId>2</ServerId><ParentId>0</ParentId><DisplayName>" contacts "</DisplayName><Type>9</Type></Add>" \
+    "</Changes></FolderSync>"
+
+/* Encodes a XML document, as Templates are */
+static void test_template_encode(const WB_TINY *xml, WB_UTINY **wbxml, WB_ULONG *wbxml_len)
+{
+    WBXMLTree *tree = NULL;
+    WBXMLGenWBXMLParams params;
+
+    params.wbxml_version = WBXML_VERSION_13;
+    params.keep_ignorable_ws = FALSE;
+    params.use_strtbl = FALSE;
+    params.produce_anonymous = FALSE;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) xml, strlen(xml), &tree) == WBXML_OK);
+    ck_assert(wbxml_tree_to_wbxml(tree, wbxml, wbxml_len, &params) == WBXML_OK);
+
+    wbxml_tree_destroy(tree);
+}
+
+/* Creates the FolderSync Template: Slots are the SyncKey, and the second and first DisplayName */
+static WBXMLTemplate *test_template_create_foldersync(void)
+{
+    const WB_TINY *xml = TEST_TEMPLATE_FOLDERSYNC_XML("x", "x", "x");
+    WBXMLTree *tree = NULL;
+    WBXMLTreeNode *slots[3], *calendar = NULL;
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLGenWBXMLParams params;
+
+    params.wbxml_version = WBXML_VERSION_13;
+    params.keep_ignorable_ws = FALSE;
+    params.use_strtbl = FALSE;
+    params.produce_anonymous = FALSE;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) xml, strlen(xml), &tree) == WBXML_OK);
+
+    calendar = wbxml_tree_node_elt_get_from_name(tree->root, "DisplayName", TRUE);
+    ck_assert(calendar != NULL);
+
+    slots[0] = wbxml_tree_node_elt_get_from_name(tree->root, "SyncKey", TRUE)->children;
+    slots[1] = wbxml_tree_node_elt_get_from_name(calendar->parent->next, "DisplayName", TRUE)->children;
+    slots[2] = calendar->children;
+
+    ck_assert(wbxml_template_create(tree, slots, 3, &params, &tmpl) == WBXML_OK);
+    ck_assert(tmpl != NULL);
+    ck_assert(wbxml_template_get_nb_slots(tmpl) == 3);
+
+    /* The Tree is not needed anymore */
+    wbxml_tree_destroy(tree);
+
+    return tmpl;
+}
+
+/* Counts the Memory Blocks not freed yet */
+static void *test_template_malloc(void *ctx, size_t size)
+{
+    (*(long *) ctx)++;
+    return malloc(size);
+}
+
+static void *test_template_realloc(void *ctx, void *memblock, size_t size)
+{
+    if (memblock == NULL)
+        (*(long *) ctx)++;
+    return realloc(memblock, size);
+}
+
+static void test_template_free(void *ctx, void *memblock)
+{
+    (*(long *) ctx)--;
+    free(memblock);
+}
+
+static void test_template_set_value(WBXMLTemplateValue *value, const WB_TINY *data, WB_BOOL opaque)
+{
+    value->data = (const WB_UTINY *) data;
+    value->len = strlen(data);
+    value->opaque = opaque;
+}
+
+START_TEST (test_template_fill)
+{
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLTemplateValue values[3];
+    WB_UTINY *wbxml = NULL, *expected = NULL;
+    WB_ULONG wbxml_len = 0, expected_len = 0;
+
+    tmpl = test_template_create_foldersync();
+
+    /* Values are given in the order of Slots, not in document order */
+    test_template_set_value(&values[0], "{6b4e8a2c-1f3d}", FALSE);
+    test_template_set_value(&values[1], "Contacts", FALSE);
+    test_template_set_value(&values[2], "Calendar", FALSE);
+
+    ck_assert(wbxml_template_fill(tmpl, values, &wbxml, &wbxml_len) == WBXML_OK);
+    test_template_encode(TEST_TEMPLATE_FOLDERSYNC_XML("{6b4e8a2c-1f3d}", "Calendar", "Contacts"),
+                         &expected, &expected_len);
+
+    ck_assert(wbxml_len == expected_len);
+    ck_assert(memcmp(wbxml, expected, expected_len) == 0);
+
+    wbxml_free(wbxml);
+    wbxml_free(expected);
+    wbxml_template_destroy(tmpl);
+}
+END_TEST
+
+START_TEST (test_template_fill_buffer)
+{
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLTemplateValue values[3];
+    WBXMLBuffer *output = NULL;
+    WB_UTINY *expected = NULL;
+    WB_ULONG expected_len = 0;
+
+    tmpl = test_template_create_foldersync();
+
+    output = wbxml_buffer_create("", 0, 0);
+    ck_assert(output != NULL);
+
+    /* A long document */
+    test_template_set_value(&values[0], "1234567890123456789012345678901234567890", FALSE);
+    test_template_set_value(&values[1], "Contacts", FALSE);
+    test_template_set_value(&values[2], "Calendar", FALSE);
+    ck_assert(wbxml_template_fill_buffer(tmpl, values, output) == WBXML_OK);
+
+    /* The Buffer is reused for a shorter one */
+    wbxml_buffer_delete(output, 0, wbxml_buffer_len(output));
+    test_template_set_value(&values[0], "2", FALSE);
+    test_template_set_value(&values[1], "Notes", FALSE);
+    test_template_set_value(&values[2], "Inbox", FALSE);
+    ck_assert(wbxml_template_fill_buffer(tmpl, values, output) == WBXML_OK);
+
+    test_template_encode(TEST_TEMPLATE_FOLDERSYNC_XML("2", "Inbox", "Notes"), &expected, &expected_len);
+
+    ck_assert(wbxml_buffer_len(output) == expected_len);
+    ck_assert(memcmp(wbxml_buffer_get_cstr(output), expected, expected_len) == 0);
+
+    wbxml_free(expected);
+    wbxml_buffer_destroy(output);
+    wbxml_template_destroy(tmpl);
+}
+END_TEST
+
+START_TEST (test_template_opaque)
+{
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLTemplateValue values[3];
+    WB_UTINY *wbxml = NULL, *without = NULL;
+    WB_ULONG wbxml_len = 0, without_len = 0;
+    WB_UTINY data[200];
+
+    tmpl = test_template_create_foldersync();
+
+    /* Opaque Data can contain a NULL char, and its length is a Multi-byte Integer */
+    memset(data, 0, sizeof(data));
+    values[0].data = data;
+    values[0].len = sizeof(data);
+    values[0].opaque = TRUE;
+    test_template_set_value(&values[1], "Contacts", FALSE);
+    test_template_set_value(&values[2], "Calendar", FALSE);
+
+    ck_assert(wbxml_template_fill(tmpl, values, &wbxml, &wbxml_len) == WBXML_OK);
+
+    /* An empty Inline String is not encoded */
+    test_template_set_value(&values[0], "", FALSE);
+    ck_assert(wbxml_template_fill(tmpl, values, &without, &without_len) == WBXML_OK);
+
+    /* OPAQUE, length on two bytes, and data */
+    ck_assert(wbxml_len == without_len + 3 + sizeof(data));
+    ck_assert(memchr(wbxml, 0xc3, wbxml_len) != NULL);
+    ck_assert(memcmp(memchr(wbxml, 0xc3, wbxml_len), "\xc3\x81\x48", 3) == 0);
+
+    wbxml_free(wbxml);
+    wbxml_free(without);
+    wbxml_template_destroy(tmpl);
+}
+END_TEST
+
+START_TEST (test_template_bad_values)
+{
+    WBXMLTemplate *tmpl = NULL;
+    WBXMLTemplateValue values[3];
+    WBXMLBuffer *output = NULL;
+
+    tmpl = test_template_create_foldersync();
+
+    output = wbxml_buffer_create("", 0, 0);
+    ck_assert(output != NULL);
+
+    /* An Inline String can't contain a NULL char */
+    values[0].data = (const WB_UTINY *) "a\0b";
+    values[0].len = 3;
+    values[0].opaque = FALSE;
+    test_template_set_value(&values[1], "Contacts", FALSE);
+    test_template_set_value(&values[2], "Calendar", FALSE);
+
+    ck_assert(wbxml_template_fill_buffer(tmpl, values, output) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_buffer_len(output) == 0);
+
+    values[0].data = NULL;
+    ck_assert(wbxml_template_fill_buffer(tmpl, values, output) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_template_fill_buffer(tmpl, NULL, output) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_template_fill_buffer(NULL, values, output) == WBXML_ERROR_BAD_PARAMETER);
+
+    wbxml_buffer_destroy(output);
+    wbxml_template_destroy(tmpl);
+}
+END_TEST
+
+START_TEST (test_template_bad_slots)
+{
+    const WB_TINY *xml = TEST_TEMPLATE_FOLDERSYNC_XML("x", "x", "x");
+    WBXMLTree *tree = NULL;
+    WBXMLTreeNode *slots[1];
+    WBXMLTemplate *tmpl = NULL;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG wbxml_len = 0;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) xml, strlen(xml), &tree) == WBXML_OK);
+
+    /* A Slot that is not in Tree */
+    slots[0] = wbxml_tree_node_create_text((const WB_UTINY *) "x", 1);
+    ck_assert(slots[0] != NULL);
+    ck_assert(wbxml_template_create(tree, slots, 1, NULL, &tmpl) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(tmpl == NULL);
+    wbxml_tree_node_destroy(slots[0]);
+
+    ck_assert(wbxml_template_create(tree, NULL, 1, NULL, &tmpl) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_template_create(NULL, slots, 0, NULL, &tmpl) == WBXML_ERROR_BAD_PARAMETER);
+
+    /* Without Slots, it is the encoded Tree */
+    ck_assert(wbxml_template_create(tree, NULL, 0, NULL, &tmpl) == WBXML_OK);
+    ck_assert(wbxml_template_get_nb_slots(tmpl) == 0);
+    ck_assert(wbxml_template_fill(tmpl, NULL, &wbxml, &wbxml_len) == WBXML_OK);
+    ck_assert(wbxml_len > 0);
+
+    wbxml_free(wbxml);
+    wbxml_template_destroy(tmpl);
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
+START_TEST (test_template_bad_slots_allocator)
+{
+    const WB_TINY *xml = TEST_TEMPLATE_FOLDERSYNC_XML("x", "x", "x");
+    WBXMLAllocator allocator, *previous = NULL;
+    WBXMLTree *tree = NULL;
+    WBXMLTreeNode *slots[1];
+    WBXMLEncoder *encoder = NULL;
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG wbxml_len = 0, slots_pos[1];
+    long live = 0;
+
+    memset(&allocator, 0, sizeof(allocator));
+    allocator.malloc_clb = test_template_malloc;
+    allocator.realloc_clb = test_template_realloc;
+    allocator.free_clb = test_template_free;
+    allocator.ctx = &live;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) xml, strlen(xml), &tree) == WBXML_OK);
+
+    previous = wbxml_mem_use_allocator(&allocator);
+    encoder = wbxml_encoder_create();
+    wbxml_mem_use_allocator(previous);
+    ck_assert(encoder != NULL);
+
+    wbxml_encoder_set_tree(encoder, tree);
+
+    /* The document encoded with the Allocator of encoder is freed with it */
+    slots[0] = wbxml_tree_node_create_text((const WB_UTINY *) "x", 1);
+    ck_assert(slots[0] != NULL);
+    ck_assert(wbxml_encoder_encode_tree_with_slots(encoder, slots, 1, slots_pos,
+                                                   &wbxml, &wbxml_len) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml == NULL);
+    wbxml_tree_node_destroy(slots[0]);
+
+    wbxml_encoder_destroy(encoder);
+    ck_assert(live == 0);
+
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_template)
+
+    ADD_TEST(test_template_fill);
+    ADD_TEST(test_template_fill_buffer);
+    ADD_TEST(test_template_opaque);
+    ADD_TEST(test_template_bad_values);
+    ADD_TEST(test_template_bad_slots);
+    ADD_TEST(test_template_bad_slots_allocator);
+
+END_TESTS
@@ -0,0 +1,228 @@
+#include "api_test.h"
+
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_tree_compact.h"
+#include "../../src/wbxml_encoder.h"
+#include "../../src/wbxml_mem.h"
+
+#define TEST_COMPACT_SI_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE si PUBLIC \"-//WAPFORUM//DTD SI 1.0//EN\" \"http://www.wapforum.org/DTD/si.dtd\">" \
+    "<si><indication href=\"http://www.example.com/\" si-id=\"1\">You have mail</indication>" \
+    "<info><item class=\"a\">one</item><item class=\"b\"><![CDATA[two]]></item></info></si>"
+
+#define TEST_COMPACT_FOLDERSYNC_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE ActiveSync PUBLIC \"-//MICROSOFT//DTD ActiveSync//EN\" \"http://www.microsoft.com/\">" \
+    "<FolderSync xmlns=\"FolderHierarchy:\"><Status>1</Status><SyncKey>1</SyncKey>" \
+    "<Changes><Count>2</Count>" \
+    "<Add><ServerId>1</ServerId><ParentId>0</ParentId><DisplayName>Calendar</DisplayName><Type>8</Type></Add>" \
+    "<Add><ServerId>2</ServerId><ParentId>0</ParentId><DisplayName>Contacts</DisplayName><Type>9</Type></Add>" \
+    "</Changes></FolderSync>"
+
+/* Encodes a Tree, and the same Tree through a Compact Tree: both documents must be the same */
+static void test_compact_same_wbxml(const WB_TINY *xml)
+{
+    WBXMLTree *tree = NULL, *expanded = NULL;
+    WBXMLCompactTree *ctree = NULL;
+    WB_UTINY *wbxml = NULL, *compact_wbxml = NULL, *expanded_wbxml = NULL;
+    WB_ULONG wbxml_len = 0, compact_wbxml_len = 0, expanded_wbxml_len = 0;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) xml, strlen(xml), &tree) == WBXML_OK);
+    ck_assert(wbxml_tree_to_wbxml(tree, &wbxml, &wbxml_len, NULL) == WBXML_OK);
+
+    ck_assert(wbxml_compact_tree_from_tree(tree, &ctree) == WBXML_OK);
+    ck_assert(ctree->nb_nodes > 0);
+    ck_assert(ctree->lang == tree->lang);
+
+    ck_assert(wbxml_compact_tree_to_wbxml(ctree, &compact_wbxml, &compact_wbxml_len, NULL) == WBXML_OK);
+    ck_assert(compact_wbxml_len == wbxml_len);
+    ck_assert(memcmp(compact_wbxml, wbxml, wbxml_len) == 0);
+
+    /* The expanded Tree is the same document */
+    ck_assert(wbxml_compact_tree_to_tree(ctree, &expanded) == WBXML_OK);
+    ck_assert(expanded->arena != NULL);
+    ck_assert(wbxml_tree_to_wbxml(expanded, &expanded_wbxml, &expanded_wbxml_len, NULL) == WBXML_OK);
+    ck_assert(expanded_wbxml_len == wbxml_len);
+    ck_assert(memcmp(expanded_wbxml, wbxml, wbxml_len) == 0);
+
+    wbxml_free(wbxml);
+    wbxml_free(compact_wbxml);
+    wbxml_free(expanded_wbxml);
+    wbxml_tree_destroy(expanded);
+    wbxml_compact_tree_destroy(ctree);
+    wbxml_tree_destroy(tree);
+}
+
+START_TEST (test_compact_build)
+{
+    WBXMLCompactTree *ctree = NULL;
+    WB_ULONG root = 0, status = 0, text = 0, sync_key = 0;
+
+    ctree = wbxml_compact_tree_create(WBXML_LANG_ACTIVESYNC, WBXML_CHARSET_UTF_8);
+    ck_assert(ctree != NULL);
+    ck_assert(ctree->root == WBXML_COMPACT_NONE);
+
+    /* Only Elements can be the Root, and there is only one */
+    ck_assert(wbxml_compact_tree_add_text(ctree, WBXML_COMPACT_NONE, (const WB_UTINY *) "a", 1) == WBXML_COMPACT_NONE);
+
+    root = wbxml_compact_tree_add_xml_elt(ctree, WBXML_COMPACT_NONE, (const WB_UTINY *) "FolderSync");
+    ck_assert(root == 0);
+    ck_assert(ctree->root == root);
+    ck_assert(ctree->nodes[root].tag != NULL);
+    ck_assert(wbxml_compact_tree_add_xml_elt(ctree, WBXML_COMPACT_NONE, (const WB_UTINY *) "FolderSync") == WBXML_COMPACT_NONE);
+
+    /* "Status" is searched in the code page of its parent first */
+    status = wbxml_compact_tree_add_xml_elt(ctree, root, (const WB_UTINY *) "Status");
+    ck_assert(status != WBXML_COMPACT_NONE);
+    ck_assert(ctree->nodes[status].tag->wbxmlCodePage == ctree->nodes[root].tag->wbxmlCodePage);
+
+    text = wbxml_compact_tree_add_text(ctree, status, (const WB_UTINY *) "1", 1);
+    ck_assert(text != WBXML_COMPACT_NONE);
+    ck_assert(ctree->nodes[text].text_len == 1);
+    ck_assert(strcmp((const char *) wbxml_compact_tree_get_str(ctree, ctree->nodes[text].text), "1") == 0);
+
+    /* Text has no children */
+    ck_assert(wbxml_compact_tree_add_cdata(ctree, text) == WBXML_COMPACT_NONE);
+
+    /* Unknown names are Literal Elements */
+    sync_key = wbxml_compact_tree_add_xml_elt(ctree, root, (const WB_UTINY *) "Unknown");
+    ck_assert(sync_key != WBXML_COMPACT_NONE);
+    ck_assert(ctree->nodes[sync_key].tag == NULL);
+    ck_assert(strcmp((const char *) wbxml_compact_tree_get_str(ctree, ctree->nodes[sync_key].name), "Unknown") == 0);
+
+    /* Links */
+    ck_assert(ctree->nodes[root].children == status);
+    ck_assert(ctree->nodes[root].last == sync_key);
+    ck_assert(ctree->nodes[status].next == sync_key);
+    ck_assert(ctree->nodes[sync_key].prev == status);
+    ck_assert(ctree->nodes[status].parent == root);
+    ck_assert(ctree->nodes[text].parent == status);
+    ck_assert(ctree->nb_nodes == 4);
+
+    /* Attributes */
+    ck_assert(wbxml_compact_tree_add_literal_attr(ctree, sync_key, (const WB_UTINY *) "a", (const WB_UTINY *) "1", 1) == WBXML_OK);
+    ck_assert(wbxml_compact_tree_add_xml_attr(ctree, sync_key, (const WB_UTINY *) "b", (const WB_UTINY *) "2") == WBXML_OK);
+    ck_assert(wbxml_compact_tree_add_xml_attr(ctree, text, (const WB_UTINY *) "c", (const WB_UTINY *) "3") == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(ctree->nb_attrs == 2);
+    ck_assert(ctree->nodes[sync_key].attrs == 0);
+    ck_assert(ctree->attrs[0].next == 1);
+    ck_assert(ctree->attrs[1].next == WBXML_COMPACT_NONE);
+
+    wbxml_compact_tree_destroy(ctree);
+}
+END_TEST
+
+START_TEST (test_compact_many_nodes)
+{
+    WBXMLCompactTree *ctree = NULL;
+    WBXMLTree *tree = NULL;
+    WBXMLTreeNode *node = NULL;
+    WB_ULONG root = 0, i = 0;
+    WB_UTINY text[16];
+
+    ctree = wbxml_compact_tree_create(WBXML_LANG_ACTIVESYNC, WBXML_CHARSET_UTF_8);
+    ck_assert(ctree != NULL);
+
+    root = wbxml_compact_tree_add_xml_elt(ctree, WBXML_COMPACT_NONE, (const WB_UTINY *) "FolderSync");
+
+    for (i = 0; i < 5000; i++) {
+        sprintf((char *) text, "%u", i);
+        ck_assert(wbxml_compact_tree_add_text(ctree, root, text, strlen((const char *) text)) == i + 1);
+    }
+
+    /* Siblings are kept in order */
+    ck_assert(wbxml_compact_tree_to_tree(ctree, &tree) == WBXML_OK);
+    ck_assert(tree->root != NULL);
+
+    for (i = 0, node = tree->root->children; node != NULL; i++, node = node->next) {
+        sprintf((char *) text, "%u", i);
+        ck_assert(node->type == WBXML_TREE_TEXT_NODE);
+        ck_assert(node->parent == tree->root);
+        ck_assert(strcmp((const char *) wbxml_buffer_get_cstr(node->content), (const char *) text) == 0);
+        ck_assert((node->prev == NULL) == (i == 0));
+    }
+    ck_assert(i == 5000);
+
+    wbxml_tree_destroy(tree);
+    wbxml_compact_tree_destroy(ctree);
+}
+END_TEST
+
+START_TEST (test_compact_round_trip)
+{
+    test_compact_same_wbxml(TEST_COMPACT_SI_XML);
+    test_compact_same_wbxml(TEST_COMPACT_FOLDERSYNC_XML);
+}
+END_TEST
+
+START_TEST (test_compact_encoder)
+{
+    WBXMLTree *tree = NULL, *expanded = NULL;
+    WBXMLCompactTree *ctree = NULL;
+    WBXMLEncoder *encoder = NULL;
+    WB_UTINY *wbxml = NULL, *compact_wbxml = NULL;
+    WB_ULONG wbxml_len = 0, compact_wbxml_len = 0;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) TEST_COMPACT_FOLDERSYNC_XML,
+                                  strlen(TEST_COMPACT_FOLDERSYNC_XML), &tree) == WBXML_OK);
+    ck_assert(wbxml_compact_tree_from_tree(tree, &ctree) == WBXML_OK);
+
+    encoder = wbxml_encoder_create();
+    ck_assert(encoder != NULL);
+    wbxml_encoder_set_tree(encoder, tree);
+    ck_assert(wbxml_encoder_encode_tree_to_wbxml(encoder, &wbxml, &wbxml_len) == WBXML_OK);
+    wbxml_encoder_destroy(encoder);
+
+    /* The expanded Tree doesn't depend on the Compact Tree */
+    ck_assert(wbxml_compact_tree_to_tree(ctree, &expanded) == WBXML_OK);
+    wbxml_compact_tree_destroy(ctree);
+
+    encoder = wbxml_encoder_create();
+    ck_assert(encoder != NULL);
+    wbxml_encoder_set_tree(encoder, expanded);
+    ck_assert(wbxml_encoder_encode_tree_to_wbxml(encoder, &compact_wbxml, &compact_wbxml_len) == WBXML_OK);
+    wbxml_encoder_destroy(encoder);
+
+    ck_assert(compact_wbxml_len == wbxml_len);
+    ck_assert(memcmp(compact_wbxml, wbxml, wbxml_len) == 0);
+
+    wbxml_free(wbxml);
+    wbxml_free(compact_wbxml);
+    wbxml_tree_destroy(expanded);
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
+START_TEST (test_compact_not_allowed)
+{
+    WBXMLTree *tree = NULL;
+    WBXMLTreeNode *pi = NULL;
+    WBXMLCompactTree *ctree = NULL;
+
+    ck_assert(wbxml_tree_from_xml((WB_UTINY *) TEST_COMPACT_SI_XML, strlen(TEST_COMPACT_SI_XML), &tree) == WBXML_OK);
+
+    /* Processing Instructions can't be converted */
+    pi = wbxml_tree_node_create(WBXML_TREE_PI_NODE);
+    ck_assert(pi != NULL);
+    ck_assert(wbxml_tree_add_node(tree, tree->root, pi));
+
+    ck_assert(wbxml_compact_tree_from_tree(tree, &ctree) == WBXML_ERROR_XML_NODE_NOT_ALLOWED);
+    ck_assert(ctree == NULL);
+
+    ck_assert(wbxml_compact_tree_from_tree(NULL, &ctree) == WBXML_ERROR_BAD_PARAMETER);
+    ck_assert(wbxml_compact_tree_to_tree(NULL, &tree) == WBXML_ERROR_BAD_PARAMETER);
+
+    wbxml_tree_destroy(tree);
+}
+END_TEST
+
+BEGIN_TESTS(wbxml_tree_compact)
+
+    ADD_TEST(test_compact_build);
+    ADD_TEST(test_compact_many_nodes);
+    ADD_TEST(test_compact_round_trip);
+    ADD_TEST(test_compact_encoder);
+    ADD_TEST(test_compact_not_allowed);
+
+END_TESTS
@@ -0,0 +1,208 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file bench_charset.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Benchmark of Charsets Conversions
+ *
+ * Usage: bench_charset [-n iterations] [-l length]
+ *
+ * A text of about 'length' bytes (default: 64, the size of a typical inline string) is
+ * converted 'iterations' times, for each pair of charsets converted without iconv:
+ *   - ISO-8859-1 <-> UTF-8,
+ *   - UTF-16 (Big Endian and Little Endian) <-> UTF-8,
+ *   - UCS-2 <-> UTF-8,
+ * and for ISO-8859-2 <-> UTF-8, which is converted with iconv (when supported).
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_charset.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define BENCH_DEFAULT_ITERATIONS 200000
+#define BENCH_DEFAULT_LENGTH 64
+
+/** Text converted, in UTF-8 (every character is in ISO-8859-1 and ISO-8859-2) */
+#define BENCH_TEXT "Gr\xc3\xbc\xc3\x9f" "e aus K\xc3\xb6ln, caf\xc3\xa9 au lait. "
+
+
+/** A text, in a charset */
+typedef struct BenchText_s {
+    WBXMLCharsetMIBEnum charset;
+    WB_TINY            *data;
+    WB_ULONG            len;
+} BenchText;
+
+
+/**
+ * @brief Convert a text, several times, and print results
+ */
+static void run(const char *title, BenchText *from, WBXMLCharsetMIBEnum to, long iterations)
+{
+    WBXMLBuffer *result = NULL;
+    WB_ULONG     len = 0, out_len = 0;
+    int          errors = 0;
+    long         n = 0;
+    clock_t      start = 0;
+    double       secs = 0;
+
+    if (from->data == NULL) {
+        printf("%-24s %10s\n", title, "-");
+        return;
+    }
+
+    start = clock();
+
+    for (n = 0; n < iterations; n++) {
+        len = from->len;
+
+        if (wbxml_charset_conv(from->data, &len, from->charset, &result, to) != WBXML_OK) {
+            errors++;
+            continue;
+        }
+
+        out_len = wbxml_buffer_len(result);
+        wbxml_buffer_destroy(result);
+    }
+
+    secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs <= 0)
+        secs = 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-24s %10.1f MB/s %10.0f conv/s %8lu bytes %6d errors\n",
+           title,
+           (double) from->len * iterations / secs / 1e6,
+           (double) iterations / secs,
+           (unsigned long) out_len,
+           errors);
+}
+
+
+/**
+ * @brief Get a text in a charset, from its UTF-8 version
+ */
+static void convert_text(BenchText *utf8, WBXMLCharsetMIBEnum charset, BenchText *text)
+{
+    WBXMLBuffer *result = NULL;
+    WB_ULONG     len = utf8->len;
+
+    text->charset = charset;
+    text->data = NULL;
+    text->len = 0;
+
+    if (wbxml_charset_conv(utf8->data, &len, WBXML_CHARSET_UTF_8, &result, charset) != WBXML_OK)
+        return;
+
+    if ((text->data = malloc(wbxml_buffer_len(result))) != NULL) {
+        text->len = wbxml_buffer_len(result);
+        memcpy(text->data, wbxml_buffer_get_cstr(result), text->len);
+    }
+
+    wbxml_buffer_destroy(result);
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchText  utf8, latin1, utf16_be, utf16_le, ucs2, latin2;
+    long       iterations = BENCH_DEFAULT_ITERATIONS;
+    WB_ULONG   length = BENCH_DEFAULT_LENGTH, i = 0;
+    WB_TINY    tmp = 0;
+    int        arg = 0;
+
+    for (arg = 1; arg < argc; arg++) {
+        if ((strcmp(argv[arg], "-n") == 0) && (arg + 1 < argc)) {
+            iterations = atol(argv[++arg]);
+            if (iterations <= 0)
+                iterations = 1;
+        }
+        else if ((strcmp(argv[arg], "-l") == 0) && (arg + 1 < argc)) {
+            length = (WB_ULONG) atol(argv[++arg]);
+            if (length < WBXML_STRLEN(BENCH_TEXT))
+                length = WBXML_STRLEN(BENCH_TEXT);
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations] [-l length]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Text in UTF-8, made of whole copies of BENCH_TEXT */
+    length += WBXML_STRLEN(BENCH_TEXT) - 1;
+    length -= length % WBXML_STRLEN(BENCH_TEXT);
+
+    if ((utf8.data = malloc(length)) == NULL)
+        return 1;
+
+    for (i = 0; i < length; i += WBXML_STRLEN(BENCH_TEXT))
+        memcpy(utf8.data + i, BENCH_TEXT, WBXML_STRLEN(BENCH_TEXT));
+
+    utf8.charset = WBXML_CHARSET_UTF_8;
+    utf8.len = length;
+
+    /* Same text, in other charsets */
+    convert_text(&utf8, WBXML_CHARSET_ISO_8859_1, &latin1);
+    convert_text(&utf8, WBXML_CHARSET_UTF_16, &utf16_be);
+    convert_text(&utf8, WBXML_CHARSET_UTF_16, &utf16_le);
+    convert_text(&utf8, WBXML_CHARSET_ISO_10646_UCS_2, &ucs2);
+    convert_text(&utf8, WBXML_CHARSET_ISO_8859_2, &latin2);
+
+    /* Swap bytes of each character (Byte Order Mark included) */
+    for (i = 0; (utf16_le.data != NULL) && (i + 1 < utf16_le.len); i += 2) {
+        tmp = utf16_le.data[i];
+        utf16_le.data[i] = utf16_le.data[i + 1];
+        utf16_le.data[i + 1] = tmp;
+    }
+
+    printf("%lu UTF-8 bytes, %ld iterations\n", (unsigned long) utf8.len, iterations);
+
+    run("ISO-8859-1 -> UTF-8", &latin1, WBXML_CHARSET_UTF_8, iterations);
+    run("UTF-8 -> ISO-8859-1", &utf8, WBXML_CHARSET_ISO_8859_1, iterations);
+    run("UTF-16BE -> UTF-8", &utf16_be, WBXML_CHARSET_UTF_8, iterations);
+    run("UTF-16LE -> UTF-8", &utf16_le, WBXML_CHARSET_UTF_8, iterations);
+    run("UTF-8 -> UTF-16", &utf8, WBXML_CHARSET_UTF_16, iterations);
+    run("UCS-2 -> UTF-8", &ucs2, WBXML_CHARSET_UTF_8, iterations);
+    run("UTF-8 -> UCS-2", &utf8, WBXML_CHARSET_ISO_10646_UCS_2, iterations);
+    run("ISO-8859-2 -> UTF-8", &latin2, WBXML_CHARSET_UTF_8, iterations);
+    run("UTF-8 -> ISO-8859-2", &utf8, WBXML_CHARSET_ISO_8859_2, iterations);
+
+    wbxml_charset_conv_cleanup();
+
+    free(utf8.data);
+    free(latin1.data);
+    free(utf16_be.data);
+    free(utf16_le.data);
+    free(ucs2.data);
+    free(latin2.data);
+
+    return 0;
+}
@@ -0,0 +1,371 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file bench_reader.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Benchmark of the WBXML Reader against the WBXML Parser (callbacks)
+ *
+ * Usage: bench_reader [-n iterations] [-e element] file...
+ *
+ * Files ending with ".xml" are first converted to WBXML. Each document is then read:
+ *   - by the WBXML Parser, with callbacks counting Elements,
+ *   - by the WBXML Parser, skipping the content of each child of the root Element,
+ *   - by the WBXML Reader, reading all Events,
+ *   - by the WBXML Reader, skipping the content of each child of the root Element,
+ *   - by the WBXML Reader, stopping at the content of the first 'element' (default: "SyncKey").
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_parser.h"
+#include "../../src/wbxml_reader.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define BENCH_DEFAULT_ITERATIONS 100
+#define BENCH_DEFAULT_ELEMENT "SyncKey"
+
+
+/** A document to read */
+typedef struct BenchDocument_s {
+    const char *name;
+    WB_UTINY   *wbxml;
+    WB_ULONG    wbxml_len;
+} BenchDocument;
+
+/** A way to read documents */
+typedef WBXMLError (*BenchFunction)(BenchDocument *doc, void *ctx, WB_ULONG *elements);
+
+
+/* Element counter, for Parser callbacks */
+static void count_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **atts)
+{
+    (void) element; /* avoid warning about unused parameter */
+    (void) atts; /* avoid warning about unused parameter */
+
+    (*(WB_ULONG *) ctx)++;
+}
+
+static WBXMLContentHandler count_handler = {
+    NULL,
+    NULL,
+    count_start_element,
+    NULL,
+    NULL,
+    NULL
+};
+
+
+/* Element counter, for Parser callbacks skipping the content of each child of root Element */
+typedef struct BenchSkip_s {
+    WBXMLParser *parser;
+    WB_ULONG    *elements;
+    WB_ULONG     depth;
+} BenchSkip;
+
+static void skip_start_element(void *ctx, WBXMLTag *element, WBXMLAttribute **atts)
+{
+    BenchSkip *skip = (BenchSkip *) ctx;
+
+    (void) element; /* avoid warning about unused parameter */
+    (void) atts; /* avoid warning about unused parameter */
+
+    (*skip->elements)++;
+
+    if (++skip->depth == 2)
+        wbxml_parser_skip_element(skip->parser);
+}
+
+static void skip_end_element(void *ctx, WBXMLTag *element)
+{
+    (void) element; /* avoid warning about unused parameter */
+
+    ((BenchSkip *) ctx)->depth--;
+}
+
+static WBXMLContentHandler skip_handler = {
+    NULL,
+    NULL,
+    skip_start_element,
+    skip_end_element,
+    NULL,
+    NULL
+};
+
+
+static WBXMLError bench_parser(BenchDocument *doc, void *ctx, WB_ULONG *elements)
+{
+    WBXMLParser *parser = (WBXMLParser *) ctx;
+
+    wbxml_parser_set_content_handler(parser, &count_handler);
+    wbxml_parser_set_user_data(parser, elements);
+
+    return wbxml_parser_parse_static(parser, doc->wbxml, doc->wbxml_len);
+}
+
+
+static WBXMLError bench_parser_skip(BenchDocument *doc, void *ctx, WB_ULONG *elements)
+{
+    WBXMLParser *parser = (WBXMLParser *) ctx;
+    BenchSkip skip;
+
+    skip.parser = parser;
+    skip.elements = elements;
+    skip.depth = 0;
+
+    wbxml_parser_set_content_handler(parser, &skip_handler);
+    wbxml_parser_set_user_data(parser, &skip);
+
+    return wbxml_parser_parse_static(parser, doc->wbxml, doc->wbxml_len);
+}
+
+
+static WBXMLError bench_reader_all(BenchDocument *doc, void *ctx, WB_ULONG *elements)
+{
+    WBXMLReader *reader = (WBXMLReader *) ctx;
+    WBXMLReaderEvent event;
+    WBXMLError ret = WBXML_OK;
+
+    if ((ret = wbxml_reader_set_input(reader, doc->wbxml, doc->wbxml_len)) != WBXML_OK)
+        return ret;
+
+    while ((ret = wbxml_reader_next(reader, &event)) == WBXML_OK) {
+        if (event.type == WBXML_READER_START_ELEMENT)
+            (*elements)++;
+        else if (event.type == WBXML_READER_END_DOCUMENT)
+            break;
+    }
+
+    return ret;
+}
+
+
+static WBXMLError bench_reader_skip(BenchDocument *doc, void *ctx, WB_ULONG *elements)
+{
+    WBXMLReader *reader = (WBXMLReader *) ctx;
+    WBXMLReaderEvent event;
+    WBXMLError ret = WBXML_OK;
+
+    if ((ret = wbxml_reader_set_input(reader, doc->wbxml, doc->wbxml_len)) != WBXML_OK)
+        return ret;
+
+    while ((ret = wbxml_reader_next(reader, &event)) == WBXML_OK) {
+        if (event.type == WBXML_READER_START_ELEMENT) {
+            (*elements)++;
+
+            /* Only look at the children of root Element */
+            if ((event.depth == 2) && ((ret = wbxml_reader_skip(reader)) != WBXML_OK))
+                break;
+        }
+        else if (event.type == WBXML_READER_END_DOCUMENT)
+            break;
+    }
+
+    return ret;
+}
+
+
+static const char *stop_element = BENCH_DEFAULT_ELEMENT;
+
+static WBXMLError bench_reader_stop(BenchDocument *doc, void *ctx, WB_ULONG *elements)
+{
+    WBXMLReader *reader = (WBXMLReader *) ctx;
+    WBXMLReaderEvent event;
+    WBXMLError ret = WBXML_OK;
+    WB_ULONG len = WBXML_STRLEN(stop_element);
+
+    if ((ret = wbxml_reader_set_input(reader, doc->wbxml, doc->wbxml_len)) != WBXML_OK)
+        return ret;
+
+    while ((ret = wbxml_reader_next(reader, &event)) == WBXML_OK) {
+        if (event.type == WBXML_READER_START_ELEMENT) {
+            (*elements)++;
+
+            if ((event.name_len == len) && (memcmp(event.name, stop_element, len) == 0)) {
+                /* Got it: read its content, and stop */
+                return wbxml_reader_next(reader, &event);
+            }
+        }
+        else if (event.type == WBXML_READER_END_DOCUMENT)
+            break;
+    }
+
+    return ret;
+}
+
+
+/**
+ * @brief Read all documents, several times, and print results
+ */
+static void run(const char *title, BenchFunction function, void *ctx,
+                BenchDocument *docs, int nb_docs, long iterations)
+{
+    WB_ULONG elements = 0, bytes = 0;
+    int      errors = 0, i = 0;
+    long     n = 0;
+    clock_t  start = 0;
+    double   secs = 0;
+
+    start = clock();
+
+    for (n = 0; n < iterations; n++) {
+        for (i = 0; i < nb_docs; i++) {
+            if (function(&docs[i], ctx, &elements) != WBXML_OK)
+                errors++;
+
+            bytes += docs[i].wbxml_len;
+        }
+    }
+
+    secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs <= 0)
+        secs = 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-24s %10.1f MB/s %10.0f docs/s %12lu elements %6d errors\n",
+           title,
+           (double) bytes / secs / 1e6,
+           (double) (iterations * nb_docs) / secs,
+           (unsigned long) (elements / iterations),
+           errors / (int) iterations);
+}
+
+
+/**
+ * @brief Load a document, as WBXML
+ */
+static WB_BOOL load_document(const char *name, BenchDocument *doc)
+{
+    WBXMLConvXML2WBXML *conv = NULL;
+    FILE       *file = NULL;
+    WB_UTINY   *data = NULL, *tmp = NULL;
+    WB_ULONG    len = 0, size = 0, nb = 0;
+    WBXMLError  ret = WBXML_OK;
+
+    if ((file = fopen(name, "rb")) == NULL) {
+        fprintf(stderr, "Can't open %s\n", name);
+        return FALSE;
+    }
+
+    do {
+        if (len == size) {
+            size += 4096 + size;
+            if ((tmp = realloc(data, size + 1)) == NULL) {
+                free(data);
+                fclose(file);
+                return FALSE;
+            }
+            data = tmp;
+        }
+
+        nb = (WB_ULONG) fread(data + len, 1, size - len, file);
+        len += nb;
+    } while (nb > 0);
+
+    fclose(file);
+    data[len] = '\0';
+
+    doc->name = name;
+
+    if ((WBXML_STRLEN(name) > 4) && (strcmp(name + WBXML_STRLEN(name) - 4, ".xml") == 0)) {
+        if ((ret = wbxml_conv_xml2wbxml_create(&conv)) == WBXML_OK) {
+            ret = wbxml_conv_xml2wbxml_run(conv, data, len, &doc->wbxml, &doc->wbxml_len);
+            wbxml_conv_xml2wbxml_destroy(conv);
+        }
+
+        free(data);
+
+        if (ret != WBXML_OK) {
+            fprintf(stderr, "Can't convert %s: %s\n", name, wbxml_errors_string(ret));
+            return FALSE;
+        }
+    }
+    else {
+        doc->wbxml = data;
+        doc->wbxml_len = len;
+    }
+
+    return TRUE;
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchDocument *docs = NULL;
+    WBXMLParser   *parser = NULL;
+    WBXMLReader   *reader = NULL;
+    WB_ULONG       total = 0;
+    long           iterations = BENCH_DEFAULT_ITERATIONS;
+    int            nb_docs = 0, i = 0;
+
+    if ((docs = malloc(argc * sizeof(BenchDocument))) == NULL)
+        return 1;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iterations = atol(argv[++i]);
+            if (iterations <= 0)
+                iterations = 1;
+        }
+        else if ((strcmp(argv[i], "-e") == 0) && (i + 1 < argc))
+            stop_element = argv[++i];
+        else if (load_document(argv[i], &docs[nb_docs])) {
+            total += docs[nb_docs].wbxml_len;
+            nb_docs++;
+        }
+    }
+
+    if (nb_docs == 0) {
+        fprintf(stderr, "Usage: %s [-n iterations] [-e element] file...\n", argv[0]);
+        free(docs);
+        return 1;
+    }
+
+    printf("%d documents, %lu WBXML bytes, %ld iterations\n", nb_docs, (unsigned long) total, iterations);
+
+    if ((parser = wbxml_parser_create()) != NULL) {
+        run("parser (callbacks)", bench_parser, parser, docs, nb_docs, iterations);
+        run("parser (skip children)", bench_parser_skip, parser, docs, nb_docs, iterations);
+        wbxml_parser_destroy(parser);
+    }
+
+    if ((reader = wbxml_reader_create()) != NULL) {
+        run("reader (all events)", bench_reader_all, reader, docs, nb_docs, iterations);
+        run("reader (skip children)", bench_reader_skip, reader, docs, nb_docs, iterations);
+        run("reader (stop at element)", bench_reader_stop, reader, docs, nb_docs, iterations);
+        wbxml_reader_destroy(reader);
+    }
+
+    for (i = 0; i < nb_docs; i++)
+        free(docs[i].wbxml);
+
+    free(docs);
+
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file bench_strtbl.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Benchmark of String Table references, on a SyncML document
+ *
+ * Usage: bench_strtbl [-n iterations] [-i items]
+ *
+ * A SyncML document with 'items' Status and Replace commands (default: 500) is converted
+ * to WBXML: the LocURIs, that are the same in all commands, go to the String Table. The
+ * document is then parsed 'iterations' times, by the WBXML Parser and to a WBXML Tree,
+ * in UTF-8 and in ISO-8859-1 (the charset of WBXML document is only changed: all strings
+ * are US-ASCII). In UTF-8, strings are given as is. In ISO-8859-1, they are converted.
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_parser.h"
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_conv.h"
+#include "../../src/wbxml_mem.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define BENCH_DEFAULT_ITERATIONS 200
+#define BENCH_DEFAULT_ITEMS 500
+
+#define BENCH_HEADER \
+    "<?xml version=\"1.0\"?>\n" \
+    "<!DOCTYPE SyncML PUBLIC \"-//SYNCML//DTD SyncML 1.1//EN\" \"http://www.syncml.org/docs/syncml_represent_v11_20020213.dtd\">\n" \
+    "<SyncML>\n" \
+    " <SyncHdr>\n" \
+    "  <VerDTD>1.1</VerDTD>\n" \
+    "  <VerProto>SyncML/1.1</VerProto>\n" \
+    "  <SessionID>1</SessionID>\n" \
+    "  <MsgID>2</MsgID>\n" \
+    "  <Target><LocURI>http://www.syncml.org/sync-server</LocURI></Target>\n" \
+    "  <Source><LocURI>IMEI:493005100592800</LocURI></Source>\n" \
+    " </SyncHdr>\n" \
+    " <SyncBody>\n"
+
+#define BENCH_STATUS \
+    "  <Status>\n" \
+    "   <CmdID>%u</CmdID>\n" \
+    "   <MsgRef>1</MsgRef><CmdRef>%u</CmdRef><Cmd>Replace</Cmd>\n" \
+    "   <TargetRef>./contacts/james_bond</TargetRef>\n" \
+    "   <SourceRef>./dev-contacts</SourceRef>\n" \
+    "   <Data>200</Data>\n" \
+    "  </Status>\n"
+
+#define BENCH_REPLACE \
+    "  <Replace>\n" \
+    "   <CmdID>%u</CmdID>\n" \
+    "   <Meta><Type xmlns=\"syncml:metinf\">text/x-vcard</Type></Meta>\n" \
+    "   <Item>\n" \
+    "    <Target><LocURI>./contacts/james_bond</LocURI></Target>\n" \
+    "    <Source><LocURI>./dev-contacts</LocURI></Source>\n" \
+    "    <Data>%u</Data>\n" \
+    "   </Item>\n" \
+    "  </Replace>\n"
+
+#define BENCH_FOOTER \
+    "  <Final/>\n" \
+    " </SyncBody>\n" \
+    "</SyncML>\n"
+
+
+/* Counting Allocator */
+
+static void *bench_malloc(void *ctx, size_t size)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    return malloc(size);
+}
+
+static void *bench_realloc(void *ctx, void *memblock, size_t size)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    return realloc(memblock, size);
+}
+
+static void bench_free(void *ctx, void *memblock)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    free(memblock);
+}
+
+static WBXMLAllocator bench_allocator = {
+    bench_malloc,
+    bench_realloc,
+    bench_free,
+    NULL,
+    0, 0, 0, 0, 0
+};
+
+
+/* Characters counter, for Parser callbacks */
+static void count_characters(void *ctx, WB_UTINY *ch, WB_ULONG start, WB_ULONG length)
+{
+    (void) ch; /* avoid warning about unused parameter */
+    (void) start; /* avoid warning about unused parameter */
+
+    (*(WB_ULONG *) ctx) += length;
+}
+
+static WBXMLContentHandler count_handler = {
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    count_characters,
+    NULL
+};
+
+
+/**
+ * @brief Build the SyncML document, and convert it to WBXML
+ */
+static WB_UTINY *build_document(WB_ULONG items, WB_ULONG *wbxml_len)
+{
+    WBXMLConvXML2WBXML *conv = NULL;
+    WB_UTINY *xml = NULL, *wbxml = NULL;
+    WB_ULONG  len = 0, i = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if ((xml = malloc(WBXML_STRLEN(BENCH_HEADER) + WBXML_STRLEN(BENCH_FOOTER) +
+                      items * (WBXML_STRLEN(BENCH_STATUS) + WBXML_STRLEN(BENCH_REPLACE) + 40) + 1)) == NULL)
+        return NULL;
+
+    len = sprintf((char *) xml, "%s", BENCH_HEADER);
+
+    for (i = 0; i < items; i++) {
+        len += sprintf((char *) xml + len, BENCH_STATUS, 2 * i + 1, 2 * i + 1);
+        len += sprintf((char *) xml + len, BENCH_REPLACE, 2 * i + 2, i);
+    }
+
+    len += sprintf((char *) xml + len, "%s", BENCH_FOOTER);
+
+    if ((ret = wbxml_conv_xml2wbxml_create(&conv)) == WBXML_OK) {
+        ret = wbxml_conv_xml2wbxml_run(conv, xml, len, &wbxml, wbxml_len);
+        wbxml_conv_xml2wbxml_destroy(conv);
+    }
+
+    free(xml);
+
+    if (ret != WBXML_OK) {
+        fprintf(stderr, "Can't convert SyncML document: %s\n", wbxml_errors_string(ret));
+        return NULL;
+    }
+
+    return wbxml;
+}
+
+
+/**
+ * @brief Change the charset of a WBXML document
+ * @note Header: version publicid charset strtbl (publicid and charset are mb_u_int32)
+ */
+static WB_BOOL set_charset(WB_UTINY *wbxml, WB_ULONG wbxml_len, WB_UTINY charset)
+{
+    WB_ULONG pos = 1;
+
+    /* publicid = mb_u_int32 | ( zero index ) */
+    if (wbxml[pos] == 0x00)
+        pos++;
+    while ((pos < wbxml_len) && (wbxml[pos] & 0x80))
+        pos++;
+    pos++;
+
+    /* UTF-8: 106 */
+    if ((pos >= wbxml_len) || (wbxml[pos] != 0x6A))
+        return FALSE;
+
+    wbxml[pos] = charset;
+
+    return TRUE;
+}
+
+
+/**
+ * @brief Parse a document several times, and print results
+ */
+static void run(const char *title, WB_UTINY *wbxml, WB_ULONG wbxml_len, WB_BOOL tree, long iterations)
+{
+    WBXMLParser *parser = NULL;
+    WBXMLTree   *result = NULL;
+    WB_ULONG     chars = 0, allocs = 0;
+    int          errors = 0;
+    long         n = 0;
+    clock_t      start = 0;
+    double       secs = 0;
+
+    if ((parser = wbxml_parser_create()) == NULL)
+        return;
+
+    wbxml_parser_set_content_handler(parser, &count_handler);
+    wbxml_parser_set_user_data(parser, &chars);
+
+    allocs = bench_allocator.allocs;
+    start = clock();
+
+    for (n = 0; n < iterations; n++) {
+        if (tree) {
+            if (wbxml_tree_from_wbxml_static(wbxml, wbxml_len, WBXML_LANG_UNKNOWN,
+                                             WBXML_CHARSET_UNKNOWN, &result) != WBXML_OK)
+                errors++;
+
+            wbxml_tree_destroy(result);
+            result = NULL;
+        }
+        else if (wbxml_parser_parse_static(parser, wbxml, wbxml_len) != WBXML_OK)
+            errors++;
+    }
+
+    secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs <= 0)
+        secs = 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-24s %10.1f MB/s %10.0f docs/s %10.1f allocs/doc %6d errors\n",
+           title,
+           (double) wbxml_len * iterations / secs / 1e6,
+           (double) iterations / secs,
+           (double) (bench_allocator.allocs - allocs) / iterations,
+           errors);
+
+    wbxml_parser_destroy(parser);
+}
+
+
+int main(int argc, char **argv)
+{
+    WB_UTINY *utf8 = NULL, *latin1 = NULL;
+    WB_ULONG  wbxml_len = 0, items = BENCH_DEFAULT_ITEMS;
+    long      iterations = BENCH_DEFAULT_ITERATIONS;
+    int       i = 0;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iterations = atol(argv[++i]);
+            if (iterations <= 0)
+                iterations = 1;
+        }
+        else if ((strcmp(argv[i], "-i") == 0) && (i + 1 < argc)) {
+            items = (WB_ULONG) atol(argv[++i]);
+            if (items == 0)
+                items = 1;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations] [-i items]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* Every allocation of the library is counted */
+    wbxml_mem_set_allocator(&bench_allocator);
+
+    if ((utf8 = build_document(items, &wbxml_len)) == NULL)
+        return 1;
+
+    if (((latin1 = malloc(wbxml_len)) == NULL) ||
+        !set_charset(memcpy(latin1, utf8, wbxml_len), wbxml_len, WBXML_CHARSET_ISO_8859_1))
+    {
+        fprintf(stderr, "Can't change charset of WBXML document\n");
+        wbxml_free(utf8);
+        free(latin1);
+        return 1;
+    }
+
+    printf("%lu items, %lu WBXML bytes, %ld iterations\n",
+           (unsigned long) items, (unsigned long) wbxml_len, iterations);
+
+    run("parser (UTF-8)", utf8, wbxml_len, FALSE, iterations);
+    run("parser (ISO-8859-1)", latin1, wbxml_len, FALSE, iterations);
+    run("tree (UTF-8)", utf8, wbxml_len, TRUE, iterations);
+    run("tree (ISO-8859-1)", latin1, wbxml_len, TRUE, iterations);
+
+    wbxml_free(utf8);
+    free(latin1);
+
+    return 0;
+}
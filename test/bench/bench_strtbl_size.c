@@ -0,0 +1,444 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file bench_strtbl_size.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Size of WBXML documents of the test corpus, with each String Table builder
+ *
+ * Usage: bench_strtbl_size [-c corpus] [name...]
+ *
+ * Each document of 'corpus' (default: test/tools of the sources) is converted to WBXML
+ * without String Table, with the default String Table (words found more than once), and
+ * with the String Table that saves the most bytes (wbxml_conv_xml2wbxml_enable_optimal_string_table()).
+ * Bytes and ratios to default are printed per directory, with the time taken by each
+ * conversion. The WBXML documents of both String Tables are converted back to XML: they
+ * must give the same XML. If names are given, only the directories whose name starts
+ * with one of them are run.
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_conv.h"
+#include "../../src/wbxml_mem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dirent.h>
+
+
+#if !defined( WBXML_BENCH_CORPUS )
+#define WBXML_BENCH_CORPUS "test/tools"
+#endif /* WBXML_BENCH_CORPUS */
+
+/** String Table builders */
+enum {
+    BENCH_NO_STRTBL = 0,
+    BENCH_DEFAULT_STRTBL,
+    BENCH_OPTIMAL_STRTBL,
+    BENCH_NB_MODES
+};
+
+static const char *bench_modes[BENCH_NB_MODES] = { "none", "default", "optimal" };
+
+/** Bytes and time of a set of documents, for each builder */
+typedef struct BenchTotal_s {
+    int      documents;
+    int      errors;            /**< Documents that can't be converted, or that don't give the same XML */
+    WB_ULONG xml_bytes;
+    WB_ULONG bytes[BENCH_NB_MODES];
+    double   secs[BENCH_NB_MODES];
+} BenchTotal;
+
+
+/* Directories of documents without WBXML Public ID (as in launchTests.sh) */
+static const struct {
+    const char    *name;
+    WBXMLLanguage  lang;
+} bench_languages[] = {
+    { "ota",     WBXML_LANG_OTA_SETTINGS },
+    { "airsync", WBXML_LANG_AIRSYNC },
+    { NULL,      WBXML_LANG_UNKNOWN }
+};
+
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+
+static char *bench_path(const char *dir, const char *name)
+{
+    char *path = NULL;
+
+    if ((path = malloc(strlen(dir) + strlen(name) + 2)) != NULL)
+        sprintf(path, "%s/%s", dir, name);
+
+    return path;
+}
+
+
+static WB_BOOL bench_has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+
+    return (WB_BOOL) ((len > suffix_len) && (strcmp(name + len - suffix_len, suffix) == 0));
+}
+
+
+static WB_UTINY *bench_read_file(const char *path, WB_ULONG *len)
+{
+    FILE     *file = NULL;
+    WB_UTINY *data = NULL, *tmp = NULL;
+    WB_ULONG  size = 0, nb = 0;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    *len = 0;
+
+    do {
+        if (*len == size) {
+            size += 4096 + size;
+            if ((tmp = realloc(data, size + 1)) == NULL) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = tmp;
+        }
+
+        nb = (WB_ULONG) fread(data + *len, 1, size - *len, file);
+        *len += nb;
+    } while (nb > 0);
+
+    fclose(file);
+    data[*len] = '\0';
+
+    return data;
+}
+
+
+static int bench_compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+
+/**
+ * @brief List the entries of a directory, sorted by name
+ * @return The number of entries, or -1 if the directory can't be opened
+ */
+static int bench_list_dir(const char *path, char ***names)
+{
+    DIR           *dir = NULL;
+    struct dirent *entry = NULL;
+    char         **tmp = NULL;
+    int            nb = 0, size = 0;
+
+    if ((dir = opendir(path)) == NULL)
+        return -1;
+
+    *names = NULL;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        if (nb == size) {
+            size += 16 + size;
+            if ((tmp = realloc(*names, size * sizeof(char *))) == NULL)
+                break;
+            *names = tmp;
+        }
+
+        if (((*names)[nb] = strdup(entry->d_name)) != NULL)
+            nb++;
+    }
+
+    closedir(dir);
+
+    if (nb > 0)
+        qsort(*names, nb, sizeof(char *), bench_compare_names);
+
+    return nb;
+}
+
+
+static void bench_free_names(char **names, int nb)
+{
+    int i = 0;
+
+    for (i = 0; i < nb; i++)
+        free(names[i]);
+
+    free(names);
+}
+
+
+static WB_BOOL bench_selected(const char *name, char **filters, int nb_filters)
+{
+    int i = 0;
+
+    if (nb_filters == 0)
+        return TRUE;
+
+    for (i = 0; i < nb_filters; i++) {
+        if (strncmp(name, filters[i], strlen(filters[i])) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+/**
+ * @brief Convert an XML document to WBXML, with a String Table builder
+ * @return The WBXML document, or NULL on error
+ */
+static WB_UTINY *bench_convert(int mode, WB_UTINY *xml, WB_ULONG xml_len, WB_ULONG *wbxml_len, double *secs)
+{
+    WBXMLConvXML2WBXML *conv = NULL;
+    WB_UTINY *wbxml = NULL;
+    double start = 0;
+
+    if (wbxml_conv_xml2wbxml_create(&conv) != WBXML_OK)
+        return NULL;
+
+    if (mode == BENCH_NO_STRTBL)
+        wbxml_conv_xml2wbxml_disable_string_table(conv);
+    else if (mode == BENCH_OPTIMAL_STRTBL)
+        wbxml_conv_xml2wbxml_enable_optimal_string_table(conv);
+
+    start = bench_now();
+
+    if (wbxml_conv_xml2wbxml_run(conv, xml, xml_len, &wbxml, wbxml_len) != WBXML_OK)
+        wbxml = NULL;
+
+    *secs += bench_now() - start;
+
+    wbxml_conv_xml2wbxml_destroy(conv);
+
+    return wbxml;
+}
+
+
+/**
+ * @brief Convert a WBXML document back to XML
+ * @return The XML document, or NULL on error
+ */
+static WB_UTINY *bench_decode(WBXMLLanguage lang, WB_UTINY *wbxml, WB_ULONG wbxml_len, WB_ULONG *xml_len)
+{
+    WBXMLConvWBXML2XML *conv = NULL;
+    WB_UTINY *xml = NULL;
+
+    if (wbxml_conv_wbxml2xml_create(&conv) != WBXML_OK)
+        return NULL;
+
+    wbxml_conv_wbxml2xml_set_language(conv, lang);
+
+    if (wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len, &xml, xml_len) != WBXML_OK)
+        xml = NULL;
+
+    wbxml_conv_wbxml2xml_destroy(conv);
+
+    return xml;
+}
+
+
+/**
+ * @brief Convert a document with each builder, and add its sizes to total
+ */
+static void bench_document(const char *path, WBXMLLanguage lang, BenchTotal *total)
+{
+    WB_UTINY *xml = NULL, *wbxml[BENCH_NB_MODES], *back[2] = { NULL, NULL };
+    WB_ULONG  xml_len = 0, wbxml_len[BENCH_NB_MODES], back_len[2] = { 0, 0 };
+    int       i = 0;
+
+    if ((xml = bench_read_file(path, &xml_len)) == NULL)
+        return;
+
+    for (i = 0; i < BENCH_NB_MODES; i++)
+        wbxml[i] = bench_convert(i, xml, xml_len, &wbxml_len[i], &total->secs[i]);
+
+    /* Documents that can't be converted are not counted */
+    if (wbxml[BENCH_NO_STRTBL] == NULL) {
+        for (i = 0; i < BENCH_NB_MODES; i++)
+            wbxml_free(wbxml[i]);
+        free(xml);
+        return;
+    }
+
+    total->documents++;
+    total->xml_bytes += xml_len;
+
+    if ((wbxml[BENCH_DEFAULT_STRTBL] == NULL) || (wbxml[BENCH_OPTIMAL_STRTBL] == NULL)) {
+        fprintf(stderr, "%s: conversion failed\n", path);
+        total->errors++;
+    }
+    else {
+        for (i = 0; i < BENCH_NB_MODES; i++)
+            total->bytes[i] += wbxml_len[i];
+
+        back[0] = bench_decode(lang, wbxml[BENCH_DEFAULT_STRTBL], wbxml_len[BENCH_DEFAULT_STRTBL], &back_len[0]);
+        back[1] = bench_decode(lang, wbxml[BENCH_OPTIMAL_STRTBL], wbxml_len[BENCH_OPTIMAL_STRTBL], &back_len[1]);
+
+        if ((back[0] == NULL) || (back[1] == NULL) ||
+            (back_len[0] != back_len[1]) || (memcmp(back[0], back[1], back_len[0]) != 0))
+        {
+            fprintf(stderr, "%s: not the same XML\n", path);
+            total->errors++;
+        }
+
+        wbxml_free(back[0]);
+        wbxml_free(back[1]);
+    }
+
+    for (i = 0; i < BENCH_NB_MODES; i++)
+        wbxml_free(wbxml[i]);
+
+    free(xml);
+}
+
+
+static void bench_print(const char *name, BenchTotal *total)
+{
+    double ref = (total->bytes[BENCH_DEFAULT_STRTBL] > 0) ? (double) total->bytes[BENCH_DEFAULT_STRTBL] : 1.0;
+    int i = 0;
+
+    printf("%-16s %4d docs %9lu XML", name, total->documents, (unsigned long) total->xml_bytes);
+
+    for (i = 0; i < BENCH_NB_MODES; i++) {
+        printf(" | %s %8lu %5.3f %7.3fs",
+               bench_modes[i],
+               (unsigned long) total->bytes[i],
+               (double) total->bytes[i] / ref,
+               total->secs[i]);
+    }
+
+    if (total->errors > 0)
+        printf(" | %d errors", total->errors);
+
+    printf("\n");
+    fflush(stdout);
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchTotal   total, dir_total;
+    WBXMLLanguage lang = WBXML_LANG_UNKNOWN;
+    const char  *corpus_dir = WBXML_BENCH_CORPUS;
+    char       **filters = NULL, **names = NULL, **files = NULL, *path = NULL, *file = NULL;
+    int          nb_filters = 0, nb_names = 0, nb_files = 0, i = 0, j = 0, k = 0;
+
+    if ((filters = malloc(argc * sizeof(char *))) == NULL)
+        return 1;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc))
+            corpus_dir = argv[++i];
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-c corpus] [name...]\n", argv[0]);
+            free(filters);
+            return 1;
+        }
+        else
+            filters[nb_filters++] = argv[i];
+    }
+
+    if ((nb_names = bench_list_dir(corpus_dir, &names)) < 0) {
+        fprintf(stderr, "Can't open %s\n", corpus_dir);
+        free(filters);
+        return 1;
+    }
+
+    printf("Bytes of WBXML documents, and ratio to the default String Table\n");
+
+    memset(&total, 0, sizeof(BenchTotal));
+
+    /* One line per directory */
+    for (i = 0; i < nb_names; i++) {
+        if (!bench_selected(names[i], filters, nb_filters))
+            continue;
+
+        if ((path = bench_path(corpus_dir, names[i])) == NULL)
+            continue;
+
+        if ((nb_files = bench_list_dir(path, &files)) <= 0) {
+            free(path);
+            continue;
+        }
+
+        lang = WBXML_LANG_UNKNOWN;
+        for (j = 0; bench_languages[j].name != NULL; j++) {
+            if (strcmp(names[i], bench_languages[j].name) == 0)
+                lang = bench_languages[j].lang;
+        }
+
+        memset(&dir_total, 0, sizeof(BenchTotal));
+
+        for (j = 0; j < nb_files; j++) {
+            if (!bench_has_suffix(files[j], ".xml") && !bench_has_suffix(files[j], ".ddf"))
+                continue;
+
+            if ((file = bench_path(path, files[j])) != NULL) {
+                bench_document(file, lang, &dir_total);
+                free(file);
+            }
+        }
+
+        if (dir_total.documents > 0) {
+            bench_print(names[i], &dir_total);
+
+            total.documents += dir_total.documents;
+            total.errors += dir_total.errors;
+            total.xml_bytes += dir_total.xml_bytes;
+
+            for (k = 0; k < BENCH_NB_MODES; k++) {
+                total.bytes[k] += dir_total.bytes[k];
+                total.secs[k] += dir_total.secs[k];
+            }
+        }
+
+        bench_free_names(files, nb_files);
+        free(path);
+    }
+
+    bench_print("total", &total);
+
+    bench_free_names(names, nb_names);
+    free(filters);
+
+    return (total.errors > 0) ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file bench_xml_escape.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Benchmark of XML escaping, on large text nodes
+ *
+ * Usage: bench_xml_escape [-n iterations] [-l length]
+ *
+ * A WBXML Tree with one text node of 'length' bytes (default: 1MB) is encoded to
+ * XML 'iterations' times, in compact and canonical XML, for three kinds of text:
+ *   - plain text, with nothing to escape,
+ *   - a mail body (HTML), with a few chars to escape,
+ *   - markup, with a char to escape every four chars.
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_tree.h"
+
+#include <stdio.h>
+#include <time.h>
+
+
+#define BENCH_DEFAULT_ITERATIONS 20
+#define BENCH_DEFAULT_LENGTH (1024 * 1024)
+
+#define BENCH_XML \
+    "<?xml version=\"1.0\"?>" \
+    "<!DOCTYPE si PUBLIC \"-//WAPFORUM//DTD SI 1.0//EN\" \"http://www.wapforum.org/DTD/si.dtd\">" \
+    "<si><indication href=\"http://www.example.com/\"/></si>"
+
+/* Patterns repeated to build texts */
+#define BENCH_PLAIN  "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor. "
+#define BENCH_MAIL   "<p>Hi Bob,</p>\r\n<p>The meeting is moved to Tuesday, see you there.</p>\r\n"
+#define BENCH_MARKUP "<a>&'\"b"
+
+
+/**
+ * @brief Encode a Tree to XML, several times, and print results
+ */
+static void run(const char *title, const char *pattern, WB_ULONG length,
+                WBXMLGenXMLType gen_type, long iterations)
+{
+    WBXMLGenXMLParams params;
+    WBXMLTree   *tree = NULL;
+    WB_UTINY    *text = NULL, *xml = NULL;
+    WB_ULONG     xml_len = 0, i = 0;
+    int          errors = 0;
+    long         n = 0;
+    clock_t      start = 0;
+    double       secs = 0;
+
+    if ((text = malloc(length)) == NULL)
+        return;
+
+    for (i = 0; i < length; i++)
+        text[i] = pattern[i % WBXML_STRLEN(pattern)];
+
+    if ((wbxml_tree_from_xml((WB_UTINY *) BENCH_XML, WBXML_STRLEN(BENCH_XML), &tree) != WBXML_OK) ||
+        (wbxml_tree_add_text(tree, tree->root, text, length) == NULL))
+    {
+        fprintf(stderr, "Can't build the WBXML Tree\n");
+        wbxml_tree_destroy(tree);
+        free(text);
+        return;
+    }
+
+    params.gen_type = gen_type;
+    params.lang = WBXML_LANG_UNKNOWN;
+    params.charset = WBXML_CHARSET_UNKNOWN;
+    params.indent = 0;
+    params.keep_ignorable_ws = TRUE;
+
+    start = clock();
+
+    for (n = 0; n < iterations; n++) {
+        if (wbxml_tree_to_xml(tree, &xml, &xml_len, &params) != WBXML_OK) {
+            errors++;
+            continue;
+        }
+
+        wbxml_free(xml);
+    }
+
+    secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (secs <= 0)
+        secs = 1.0 / CLOCKS_PER_SEC;
+
+    printf("%-24s %10.1f MB/s %10.0f docs/s %12lu XML bytes %6d errors\n",
+           title,
+           (double) length * iterations / secs / 1e6,
+           (double) iterations / secs,
+           (unsigned long) xml_len,
+           errors);
+
+    wbxml_tree_destroy(tree);
+    free(text);
+}
+
+
+int main(int argc, char **argv)
+{
+    long     iterations = BENCH_DEFAULT_ITERATIONS;
+    WB_ULONG length = BENCH_DEFAULT_LENGTH;
+    int      i = 0;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+            iterations = atol(argv[++i]);
+            if (iterations <= 0)
+                iterations = 1;
+        }
+        else if ((strcmp(argv[i], "-l") == 0) && (i + 1 < argc)) {
+            length = (WB_ULONG) atol(argv[++i]);
+            if (length == 0)
+                length = 1;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [-n iterations] [-l length]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%lu text bytes, %ld iterations\n", (unsigned long) length, iterations);
+
+    run("plain (compact)", BENCH_PLAIN, length, WBXML_GEN_XML_COMPACT, iterations);
+    run("plain (canonical)", BENCH_PLAIN, length, WBXML_GEN_XML_CANONICAL, iterations);
+    run("mail (compact)", BENCH_MAIL, length, WBXML_GEN_XML_COMPACT, iterations);
+    run("mail (canonical)", BENCH_MAIL, length, WBXML_GEN_XML_CANONICAL, iterations);
+    run("markup (compact)", BENCH_MARKUP, length, WBXML_GEN_XML_COMPACT, iterations);
+    run("markup (canonical)", BENCH_MARKUP, length, WBXML_GEN_XML_CANONICAL, iterations);
+
+    return 0;
+}
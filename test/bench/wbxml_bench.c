@@ -0,0 +1,865 @@
+/*
+ * libwbxml, the WBXML Library.
+ * Copyright (C) 2002-2008 Aymerick Jehanne <aymerick@jehanne.org>
+ * Copyright (C) 2011,2014 Michael Bell <michael.bell@web.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * LGPL v2.1: http://www.gnu.org/copyleft/lesser.txt
+ *
+ * Contact: aymerick@jehanne.org
+ * Home: http://libwbxml.aymerick.com
+ */
+
+/**
+ * @file wbxml_bench.c
+ * @ingroup wbxml_bench
+ *
+ * @date 26/10/17
+ *
+ * @brief Reproducible benchmark of the library, on the test corpus and on synthetic documents
+ *
+ * Usage: wbxml_bench [-c corpus] [-o file.json] [-m max_size] [-t seconds] [name...]
+ *
+ * Each directory of 'corpus' (default: test/tools of the sources) is a set of documents
+ * (files ending with ".xml" or ".ddf"), that are first converted to WBXML. Synthetic
+ * ActiveSync documents, from 10KB to 'max_size' bytes (default: 10MB, up to 100MB), are
+ * then added: each one is a set of its own. If names are given, only the sets whose name
+ * starts with one of them are run.
+ *
+ * Each set is run by these operations, until 'seconds' (default: 0.2) have elapsed:
+ *   - parse:        WBXML Parser, without callbacks     (bytes: WBXML document)
+ *   - tree:         WBXML Tree built from WBXML         (bytes: WBXML document)
+ *   - encode_wbxml: WBXML Tree encoded to WBXML         (bytes: WBXML document)
+ *   - encode_xml:   WBXML Tree encoded to XML           (bytes: XML document produced)
+ *   - round_trip:   XML converted to WBXML, then to XML (bytes: XML document)
+ *
+ * Results give nanoseconds per byte, documents per second, allocations per document
+ * (counted with an Allocator) and peak RSS of the process so far. They are printed, and
+ * written as JSON to 'file.json', so that runs on several commits can be compared.
+ */
+
+#include "../../src/wbxml.h"
+#include "../../src/wbxml_parser.h"
+#include "../../src/wbxml_tree.h"
+#include "../../src/wbxml_conv.h"
+#include "../../src/wbxml_mem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+
+#if !defined( WBXML_BENCH_CORPUS )
+#define WBXML_BENCH_CORPUS "test/tools"
+#endif /* WBXML_BENCH_CORPUS */
+
+#define BENCH_DEFAULT_MIN_TIME 0.2
+#define BENCH_DEFAULT_MAX_SIZE (10 * 1024 * 1024)
+
+
+/** A document, in XML and WBXML, with its WBXML Tree */
+typedef struct BenchDocument_s {
+    char          *name;
+    WB_UTINY      *xml;
+    WB_ULONG       xml_len;
+    WB_UTINY      *wbxml;
+    WB_ULONG       wbxml_len;
+    WBXMLTree     *tree;
+    WBXMLLanguage  lang;        /**< Language forced when parsing WBXML (or WBXML_LANG_UNKNOWN) */
+} BenchDocument;
+
+/** A set of documents */
+typedef struct BenchCorpus_s {
+    const char    *name;
+    BenchDocument *docs;
+    int            nb_docs;
+    int            skipped;     /**< Documents that can't be converted to WBXML, or to a Tree */
+    WBXMLLanguage  lang;        /**< Language forced when parsing WBXML (or WBXML_LANG_UNKNOWN) */
+} BenchCorpus;
+
+/** Objects reused by operations */
+typedef struct BenchContext_s {
+    WBXMLParser        *parser;
+    WBXMLConvXML2WBXML *xml2wbxml;
+    WBXMLConvWBXML2XML *wbxml2xml;
+} BenchContext;
+
+/** An operation on a document: returns the number of bytes it accounts for, or 0 on error */
+typedef WB_ULONG (*BenchFunction)(BenchContext *ctx, BenchDocument *doc);
+
+/** The result of an operation on a set of documents */
+typedef struct BenchResult_s {
+    const char *corpus;
+    const char *operation;
+    int         documents;
+    WB_ULONG    bytes;          /**< Bytes accounted for by one run over the set */
+    long        iterations;
+    double      ns_per_byte;
+    double      docs_per_sec;
+    double      allocs_per_doc;
+    long        peak_rss_kb;
+    int         errors;         /**< Errors in one run over the set */
+} BenchResult;
+
+
+/* Counting Allocator, set for the whole program */
+
+static void *bench_malloc(void *ctx, size_t size)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    return malloc(size);
+}
+
+static void *bench_realloc(void *ctx, void *memblock, size_t size)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    return realloc(memblock, size);
+}
+
+static void bench_free(void *ctx, void *memblock)
+{
+    (void) ctx; /* avoid warning about unused parameter */
+
+    free(memblock);
+}
+
+static WBXMLAllocator bench_allocator = {
+    bench_malloc,
+    bench_realloc,
+    bench_free,
+    NULL,
+    0, 0, 0, 0, 0
+};
+
+
+/* Operations */
+
+static WB_ULONG bench_parse(BenchContext *ctx, BenchDocument *doc)
+{
+    wbxml_parser_set_language(ctx->parser, doc->lang);
+
+    if (wbxml_parser_parse_static(ctx->parser, doc->wbxml, doc->wbxml_len) != WBXML_OK)
+        return 0;
+
+    return doc->wbxml_len;
+}
+
+
+static WB_ULONG bench_tree(BenchContext *ctx, BenchDocument *doc)
+{
+    WBXMLTree *tree = NULL;
+
+    (void) ctx; /* avoid warning about unused parameter */
+
+    if (wbxml_tree_from_wbxml_static(doc->wbxml, doc->wbxml_len,
+                                     doc->lang, WBXML_CHARSET_UNKNOWN, &tree) != WBXML_OK)
+        return 0;
+
+    wbxml_tree_destroy(tree);
+
+    return doc->wbxml_len;
+}
+
+
+static WB_ULONG bench_encode_wbxml(BenchContext *ctx, BenchDocument *doc)
+{
+    WB_UTINY *wbxml = NULL;
+    WB_ULONG  wbxml_len = 0;
+
+    (void) ctx; /* avoid warning about unused parameter */
+
+    if (wbxml_tree_to_wbxml(doc->tree, &wbxml, &wbxml_len, NULL) != WBXML_OK)
+        return 0;
+
+    wbxml_free(wbxml);
+
+    return wbxml_len;
+}
+
+
+static WB_ULONG bench_encode_xml(BenchContext *ctx, BenchDocument *doc)
+{
+    WB_UTINY *xml = NULL;
+    WB_ULONG  xml_len = 0;
+
+    (void) ctx; /* avoid warning about unused parameter */
+
+    if (wbxml_tree_to_xml(doc->tree, &xml, &xml_len, NULL) != WBXML_OK)
+        return 0;
+
+    wbxml_free(xml);
+
+    return xml_len;
+}
+
+
+static WB_ULONG bench_round_trip(BenchContext *ctx, BenchDocument *doc)
+{
+    WB_UTINY *wbxml = NULL, *xml = NULL;
+    WB_ULONG  wbxml_len = 0, xml_len = 0;
+    WBXMLError ret = WBXML_OK;
+
+    if (wbxml_conv_xml2wbxml_run(ctx->xml2wbxml, doc->xml, doc->xml_len, &wbxml, &wbxml_len) != WBXML_OK)
+        return 0;
+
+    wbxml_conv_wbxml2xml_set_language(ctx->wbxml2xml, doc->lang);
+    ret = wbxml_conv_wbxml2xml_run(ctx->wbxml2xml, wbxml, wbxml_len, &xml, &xml_len);
+
+    wbxml_free(wbxml);
+    wbxml_free(xml);
+
+    if (ret != WBXML_OK)
+        return 0;
+
+    return doc->xml_len;
+}
+
+
+static const struct {
+    const char    *name;
+    BenchFunction  function;
+} bench_operations[] = {
+    { "parse",        bench_parse },
+    { "tree",         bench_tree },
+    { "encode_wbxml", bench_encode_wbxml },
+    { "encode_xml",   bench_encode_xml },
+    { "round_trip",   bench_round_trip },
+    { NULL,           NULL }
+};
+
+
+/* Directories of documents without WBXML Public ID (as in launchTests.sh) */
+static const struct {
+    const char    *name;
+    WBXMLLanguage  lang;
+} bench_languages[] = {
+    { "ota",     WBXML_LANG_OTA_SETTINGS },
+    { "airsync", WBXML_LANG_AIRSYNC },
+    { NULL,      WBXML_LANG_UNKNOWN }
+};
+
+
+/* Sizes of synthetic documents */
+static const struct {
+    const char *name;
+    WB_ULONG    size;
+} bench_synthetics[] = {
+    { "synthetic-10KB",  10 * 1024 },
+    { "synthetic-100KB", 100 * 1024 },
+    { "synthetic-1MB",   1024 * 1024 },
+    { "synthetic-10MB",  10 * 1024 * 1024 },
+    { "synthetic-100MB", 100 * 1024 * 1024 },
+    { NULL,              0 }
+};
+
+
+/* Measures */
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+
+static long bench_peak_rss_kb(void)
+{
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    /* Kilobytes on Linux (bytes on Mac OS X) */
+#if defined( __APPLE__ )
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif /* __APPLE__ */
+}
+
+
+/**
+ * @brief Run an operation on a set of documents, until 'min_time' seconds have elapsed
+ */
+static void bench_run(BenchContext *ctx, BenchCorpus *corpus, const char *operation,
+                      BenchFunction function, double min_time, BenchResult *result)
+{
+    WB_ULONG allocs = 0, bytes = 0, len = 0;
+    double   start = 0, secs = 0, total = 0;
+    long     iterations = 0;
+    int      errors = 0, i = 0;
+
+    allocs = bench_allocator.allocs;
+    start = bench_now();
+
+    do {
+        for (i = 0; i < corpus->nb_docs; i++) {
+            if ((len = function(ctx, &corpus->docs[i])) == 0)
+                errors++;
+
+            bytes += len;
+        }
+
+        iterations++;
+        secs = bench_now() - start;
+    } while (secs < min_time);
+
+    total = (double) iterations * corpus->nb_docs;
+
+    result->corpus = corpus->name;
+    result->operation = operation;
+    result->documents = corpus->nb_docs;
+    result->bytes = bytes / iterations;
+    result->iterations = iterations;
+    result->ns_per_byte = (bytes > 0) ? secs * 1e9 / bytes : 0;
+    result->docs_per_sec = total / secs;
+    result->allocs_per_doc = (double) (bench_allocator.allocs - allocs) / total;
+    result->peak_rss_kb = bench_peak_rss_kb();
+    result->errors = errors / (int) iterations;
+
+    printf("%-20s %-14s %10.2f ns/B %12.1f docs/s %10.1f allocs/doc %8ld KB %4d errors\n",
+           result->corpus,
+           result->operation,
+           result->ns_per_byte,
+           result->docs_per_sec,
+           result->allocs_per_doc,
+           result->peak_rss_kb,
+           result->errors);
+    fflush(stdout);
+}
+
+
+/* Documents */
+
+/**
+ * @brief Add an XML document to a set: convert it to WBXML, and build its Tree
+ * @note The set takes 'name' and 'xml'
+ */
+static void bench_add_document(BenchContext *ctx, BenchCorpus *corpus, char *name, WB_UTINY *xml, WB_ULONG xml_len)
+{
+    BenchDocument *doc = &corpus->docs[corpus->nb_docs];
+
+    doc->name = name;
+    doc->xml = xml;
+    doc->xml_len = xml_len;
+    doc->wbxml = NULL;
+    doc->wbxml_len = 0;
+    doc->tree = NULL;
+    doc->lang = corpus->lang;
+
+    if ((wbxml_conv_xml2wbxml_run(ctx->xml2wbxml, xml, xml_len, &doc->wbxml, &doc->wbxml_len) != WBXML_OK) ||
+        (wbxml_tree_from_wbxml_static(doc->wbxml, doc->wbxml_len,
+                                      doc->lang, WBXML_CHARSET_UNKNOWN, &doc->tree) != WBXML_OK))
+    {
+        wbxml_free(doc->wbxml);
+        free(name);
+        free(xml);
+        corpus->skipped++;
+        return;
+    }
+
+    corpus->nb_docs++;
+}
+
+
+static void bench_free_corpus(BenchCorpus *corpus)
+{
+    int i = 0;
+
+    for (i = 0; i < corpus->nb_docs; i++) {
+        free(corpus->docs[i].name);
+        free(corpus->docs[i].xml);
+        wbxml_free(corpus->docs[i].wbxml);
+        wbxml_tree_destroy(corpus->docs[i].tree);
+    }
+
+    free(corpus->docs);
+    corpus->docs = NULL;
+    corpus->nb_docs = 0;
+}
+
+
+static char *bench_path(const char *dir, const char *name)
+{
+    char *path = NULL;
+
+    if ((path = malloc(strlen(dir) + strlen(name) + 2)) != NULL)
+        sprintf(path, "%s/%s", dir, name);
+
+    return path;
+}
+
+
+static WB_BOOL bench_has_suffix(const char *name, const char *suffix)
+{
+    size_t len = strlen(name), suffix_len = strlen(suffix);
+
+    return (WB_BOOL) ((len > suffix_len) && (strcmp(name + len - suffix_len, suffix) == 0));
+}
+
+
+static WB_UTINY *bench_read_file(const char *path, WB_ULONG *len)
+{
+    FILE     *file = NULL;
+    WB_UTINY *data = NULL, *tmp = NULL;
+    WB_ULONG  size = 0, nb = 0;
+
+    if ((file = fopen(path, "rb")) == NULL)
+        return NULL;
+
+    *len = 0;
+
+    do {
+        if (*len == size) {
+            size += 4096 + size;
+            if ((tmp = realloc(data, size + 1)) == NULL) {
+                free(data);
+                fclose(file);
+                return NULL;
+            }
+            data = tmp;
+        }
+
+        nb = (WB_ULONG) fread(data + *len, 1, size - *len, file);
+        *len += nb;
+    } while (nb > 0);
+
+    fclose(file);
+    data[*len] = '\0';
+
+    return data;
+}
+
+
+static int bench_compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+
+/**
+ * @brief List the entries of a directory, sorted by name
+ * @return The number of entries, or -1 if the directory can't be opened
+ */
+static int bench_list_dir(const char *path, char ***names)
+{
+    DIR           *dir = NULL;
+    struct dirent *entry = NULL;
+    char         **tmp = NULL;
+    int            nb = 0, size = 0;
+
+    if ((dir = opendir(path)) == NULL)
+        return -1;
+
+    *names = NULL;
+
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        if (nb == size) {
+            size += 16 + size;
+            if ((tmp = realloc(*names, size * sizeof(char *))) == NULL)
+                break;
+            *names = tmp;
+        }
+
+        if (((*names)[nb] = strdup(entry->d_name)) != NULL)
+            nb++;
+    }
+
+    closedir(dir);
+
+    if (nb > 0)
+        qsort(*names, nb, sizeof(char *), bench_compare_names);
+
+    return nb;
+}
+
+
+static void bench_free_names(char **names, int nb)
+{
+    int i = 0;
+
+    for (i = 0; i < nb; i++)
+        free(names[i]);
+
+    free(names);
+}
+
+
+/**
+ * @brief Load the documents of a directory
+ */
+static WB_BOOL bench_load_corpus(BenchContext *ctx, const char *path, BenchCorpus *corpus)
+{
+    WB_UTINY *xml = NULL;
+    WB_ULONG  xml_len = 0;
+    char    **names = NULL, *file = NULL;
+    int       nb = 0, i = 0;
+
+    for (i = 0; bench_languages[i].name != NULL; i++) {
+        if (strcmp(corpus->name, bench_languages[i].name) == 0)
+            corpus->lang = bench_languages[i].lang;
+    }
+
+    if ((nb = bench_list_dir(path, &names)) < 0)
+        return FALSE;
+
+    if ((corpus->docs = malloc((nb + 1) * sizeof(BenchDocument))) == NULL) {
+        bench_free_names(names, nb);
+        return FALSE;
+    }
+
+    for (i = 0; i < nb; i++) {
+        if (!bench_has_suffix(names[i], ".xml") && !bench_has_suffix(names[i], ".ddf"))
+            continue;
+
+        if ((file = bench_path(path, names[i])) == NULL)
+            continue;
+
+        if ((xml = bench_read_file(file, &xml_len)) != NULL)
+            bench_add_document(ctx, corpus, file, xml, xml_len);
+        else
+            free(file);
+    }
+
+    bench_free_names(names, nb);
+
+    return (WB_BOOL) (corpus->nb_docs > 0);
+}
+
+
+/* Synthetic documents */
+
+static WB_BOOL bench_append(char **data, WB_ULONG *len, WB_ULONG *size, const char *str)
+{
+    WB_ULONG str_len = (WB_ULONG) strlen(str);
+    char    *tmp = NULL;
+
+    if (*len + str_len + 1 > *size) {
+        *size = *size * 2 + str_len + 1;
+        if ((tmp = realloc(*data, *size)) == NULL)
+            return FALSE;
+        *data = tmp;
+    }
+
+    memcpy(*data + *len, str, str_len + 1);
+    *len += str_len;
+
+    return TRUE;
+}
+
+
+static const char *bench_words[] = {
+    "meeting", "report", "budget", "Tuesday", "review", "draft", "project", "lunch",
+    "release", "customer", "invoice", "schedule", "update", "notes", "team", "agenda"
+};
+
+#define BENCH_NB_WORDS (sizeof(bench_words) / sizeof(bench_words[0]))
+
+/**
+ * @brief Build an ActiveSync Sync response of at least 'size' bytes, with mails
+ * @note Documents only depend on 'size': a simple LCG picks the words of texts
+ */
+static WB_UTINY *bench_synthetic_xml(WB_ULONG size, WB_ULONG *len)
+{
+    char         *data = NULL, item[2048], *p = NULL;
+    WB_ULONG      alloc = 0, n = 0, i = 0, words = 0;
+    unsigned long seed = 12345;
+    WB_BOOL       ok = TRUE;
+
+    *len = 0;
+
+    ok = bench_append(&data, len, &alloc,
+                      "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                      "<!DOCTYPE ActiveSync PUBLIC \"-//MICROSOFT//DTD ActiveSync//EN\" \"http://www.microsoft.com/\">\n"
+                      "<Sync xmlns=\"AirSync:\">\n"
+                      " <Collections>\n"
+                      "  <Collection>\n"
+                      "   <SyncKey>1</SyncKey>\n"
+                      "   <CollectionId>3</CollectionId>\n"
+                      "   <Status>1</Status>\n"
+                      "   <Commands>\n");
+
+    for (n = 1; ok && (*len < size); n++) {
+        sprintf(item,
+                "    <Add>\n"
+                "     <ServerId>3:%u</ServerId>\n"
+                "     <ApplicationData>\n"
+                "      <To xmlns=\"Email:\">\"User %u\" &lt;user%u@example.com&gt;</To>\n"
+                "      <From xmlns=\"Email:\">\"Sender %u\" &lt;sender%u@example.org&gt;</From>\n"
+                "      <DateReceived xmlns=\"Email:\">2017-10-%02uT%02u:%02u:00.000Z</DateReceived>\n"
+                "      <Read xmlns=\"Email:\">%u</Read>\n"
+                "      <Body xmlns=\"AirSyncBase:\">\n"
+                "       <Type>1</Type>\n"
+                "       <Data>",
+                n, n % 97, n % 97, n % 31, n % 31,
+                1 + n % 28, n % 24, n % 60, n % 2);
+        ok = bench_append(&data, len, &alloc, item);
+
+        /* Body: some words, with a few chars to escape */
+        words = 20 + n % 40;
+        p = item;
+        for (i = 0; i < words; i++) {
+            seed = seed * 1103515245UL + 12345UL;
+            p += sprintf(p, "%s%s", bench_words[(seed >> 16) % BENCH_NB_WORDS],
+                         (i % 16 == 15) ? " &amp; " : " ");
+        }
+
+        ok = ok && bench_append(&data, len, &alloc, item);
+        ok = ok && bench_append(&data, len, &alloc,
+                                "</Data>\n"
+                                "      </Body>\n"
+                                "     </ApplicationData>\n"
+                                "    </Add>\n");
+    }
+
+    ok = ok && bench_append(&data, len, &alloc,
+                            "   </Commands>\n"
+                            "  </Collection>\n"
+                            " </Collections>\n"
+                            "</Sync>\n");
+
+    if (!ok) {
+        free(data);
+        return NULL;
+    }
+
+    return (WB_UTINY *) data;
+}
+
+
+static WB_BOOL bench_load_synthetic(BenchContext *ctx, WB_ULONG size, BenchCorpus *corpus)
+{
+    WB_UTINY *xml = NULL;
+    WB_ULONG  xml_len = 0;
+    char     *name = NULL;
+
+    if ((corpus->docs = malloc(sizeof(BenchDocument))) == NULL)
+        return FALSE;
+
+    if (((name = strdup(corpus->name)) == NULL) ||
+        ((xml = bench_synthetic_xml(size, &xml_len)) == NULL))
+    {
+        free(name);
+        return FALSE;
+    }
+
+    bench_add_document(ctx, corpus, name, xml, xml_len);
+
+    return (WB_BOOL) (corpus->nb_docs > 0);
+}
+
+
+/* Results */
+
+static WB_BOOL bench_selected(const char *name, char **filters, int nb_filters)
+{
+    int i = 0;
+
+    if (nb_filters == 0)
+        return TRUE;
+
+    for (i = 0; i < nb_filters; i++) {
+        if (strncmp(name, filters[i], strlen(filters[i])) == 0)
+            return TRUE;
+    }
+
+    return FALSE;
+}
+
+
+static WB_BOOL bench_write_json(const char *path, BenchResult *results, int nb_results, double min_time)
+{
+    FILE *file = NULL;
+    int   i = 0;
+
+    if ((file = fopen(path, "w")) == NULL)
+        return FALSE;
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"library\": \"libwbxml\",\n");
+    fprintf(file, "  \"version\": \"%s\",\n", WBXML_LIB_VERSION);
+    fprintf(file, "  \"min_time\": %g,\n", min_time);
+    fprintf(file, "  \"results\": [\n");
+
+    for (i = 0; i < nb_results; i++) {
+        fprintf(file,
+                "    { \"corpus\": \"%s\", \"operation\": \"%s\", \"documents\": %d, \"bytes\": %lu, "
+                "\"iterations\": %ld, \"ns_per_byte\": %.3f, \"docs_per_sec\": %.1f, "
+                "\"allocs_per_doc\": %.1f, \"peak_rss_kb\": %ld, \"errors\": %d }%s\n",
+                results[i].corpus,
+                results[i].operation,
+                results[i].documents,
+                (unsigned long) results[i].bytes,
+                results[i].iterations,
+                results[i].ns_per_byte,
+                results[i].docs_per_sec,
+                results[i].allocs_per_doc,
+                results[i].peak_rss_kb,
+                results[i].errors,
+                (i + 1 < nb_results) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+
+    return (WB_BOOL) (fclose(file) == 0);
+}
+
+
+/**
+ * @brief Run all operations on a set of documents, then free it
+ */
+static void bench_corpus(BenchContext *ctx, BenchCorpus *corpus, double min_time,
+                         BenchResult **results, int *nb_results)
+{
+    BenchResult *tmp = NULL;
+    int          i = 0;
+
+    printf("%s: %d documents", corpus->name, corpus->nb_docs);
+    if (corpus->skipped > 0)
+        printf(" (%d skipped)", corpus->skipped);
+    printf("\n");
+
+    for (i = 0; bench_operations[i].name != NULL; i++) {
+        if ((tmp = realloc(*results, (*nb_results + 1) * sizeof(BenchResult))) == NULL)
+            break;
+        *results = tmp;
+
+        bench_run(ctx, corpus, bench_operations[i].name, bench_operations[i].function,
+                  min_time, &(*results)[(*nb_results)++]);
+    }
+
+    bench_free_corpus(corpus);
+}
+
+
+int main(int argc, char **argv)
+{
+    BenchContext ctx;
+    BenchCorpus  corpus;
+    BenchResult *results = NULL;
+    const char  *corpus_dir = WBXML_BENCH_CORPUS, *output = NULL;
+    char       **filters = NULL, **names = NULL, *path = NULL;
+    WB_ULONG     max_size = BENCH_DEFAULT_MAX_SIZE;
+    double       min_time = BENCH_DEFAULT_MIN_TIME;
+    int          nb_filters = 0, nb_names = 0, nb_results = 0, i = 0, ret = 0;
+
+    /* Every allocation of the library is counted */
+    wbxml_mem_set_allocator(&bench_allocator);
+
+    if ((filters = malloc(argc * sizeof(char *))) == NULL)
+        return 1;
+
+    for (i = 1; i < argc; i++) {
+        if ((strcmp(argv[i], "-c") == 0) && (i + 1 < argc))
+            corpus_dir = argv[++i];
+        else if ((strcmp(argv[i], "-o") == 0) && (i + 1 < argc))
+            output = argv[++i];
+        else if ((strcmp(argv[i], "-m") == 0) && (i + 1 < argc))
+            max_size = (WB_ULONG) atol(argv[++i]);
+        else if ((strcmp(argv[i], "-t") == 0) && (i + 1 < argc))
+            min_time = atof(argv[++i]);
+        else if (argv[i][0] == '-') {
+            fprintf(stderr, "Usage: %s [-c corpus] [-o file.json] [-m max_size] [-t seconds] [name...]\n", argv[0]);
+            free(filters);
+            return 1;
+        }
+        else
+            filters[nb_filters++] = argv[i];
+    }
+
+    memset(&ctx, 0, sizeof(BenchContext));
+
+    if (((ctx.parser = wbxml_parser_create()) == NULL) ||
+        (wbxml_conv_xml2wbxml_create(&ctx.xml2wbxml) != WBXML_OK) ||
+        (wbxml_conv_wbxml2xml_create(&ctx.wbxml2xml) != WBXML_OK))
+    {
+        fprintf(stderr, "Can't create parser and converters\n");
+        ret = 1;
+        goto cleanup;
+    }
+
+    printf("libwbxml %s, at least %g seconds per operation\n", WBXML_LIB_VERSION, min_time);
+
+    /* Test corpus: one set per directory */
+    if ((nb_names = bench_list_dir(corpus_dir, &names)) < 0)
+        fprintf(stderr, "Can't open %s\n", corpus_dir);
+
+    for (i = 0; i < nb_names; i++) {
+        if (!bench_selected(names[i], filters, nb_filters))
+            continue;
+
+        memset(&corpus, 0, sizeof(BenchCorpus));
+        corpus.name = names[i];
+
+        if ((path = bench_path(corpus_dir, names[i])) == NULL)
+            continue;
+
+        if (bench_load_corpus(&ctx, path, &corpus))
+            bench_corpus(&ctx, &corpus, min_time, &results, &nb_results);
+        else
+            bench_free_corpus(&corpus);
+
+        free(path);
+    }
+
+    /* Synthetic documents */
+    for (i = 0; (bench_synthetics[i].name != NULL) && (bench_synthetics[i].size <= max_size); i++) {
+        if (!bench_selected(bench_synthetics[i].name, filters, nb_filters))
+            continue;
+
+        memset(&corpus, 0, sizeof(BenchCorpus));
+        corpus.name = bench_synthetics[i].name;
+
+        if (bench_load_synthetic(&ctx, bench_synthetics[i].size, &corpus))
+            bench_corpus(&ctx, &corpus, min_time, &results, &nb_results);
+        else {
+            fprintf(stderr, "Can't build %s\n", corpus.name);
+            bench_free_corpus(&corpus);
+        }
+    }
+
+    if ((output != NULL) && !bench_write_json(output, results, nb_results, min_time)) {
+        fprintf(stderr, "Can't write %s\n", output);
+        ret = 1;
+    }
+
+cleanup:
+    /* Results refer to names of sets */
+    free(results);
+    bench_free_names(names, nb_names);
+
+    if (ctx.parser != NULL)
+        wbxml_parser_destroy(ctx.parser);
+    if (ctx.xml2wbxml != NULL)
+        wbxml_conv_xml2wbxml_destroy(ctx.xml2wbxml);
+    if (ctx.wbxml2xml != NULL)
+        wbxml_conv_wbxml2xml_destroy(ctx.wbxml2xml);
+
+    free(filters);
+
+    return ret;
+}
@@ -440,7 +440,7 @@ WB_LONG main(WB_LONG argc, WB_TINY **argv)
     if (input_file != stdin)
         fclose(input_file);
 
-    /* Convert WBXML document */
+    /* Convert WBXML document (parsed in place: 'wbxml' is kept until the end) */
     ret = wbxml_conv_wbxml2xml_run(conv, wbxml, wbxml_len, &xml, &xml_len);
     if (ret != WBXML_OK) {
         fprintf(stderr, "wbxml2xml failed: %s\n", wbxml_errors_string(ret));
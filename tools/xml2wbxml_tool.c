@@ -94,6 +94,7 @@ static void help(void) {
     fprintf(stderr, "    -o output.wbxml : output file\n");
     fprintf(stderr, "    -k : keep ignorable whitespaces (Default: ignore)\n");
     fprintf(stderr, "    -n : do NOT generate String Table (Default: generate)\n");
+    fprintf(stderr, "    -s : choose String Table content by bytes saved (smaller output, slower)\n");
     fprintf(stderr, "    -v X (WBXML Version of output document)\n");
     fprintf(stderr, "       1.0 : WBXML 1.0\n");
     fprintf(stderr, "       1.1 : WBXML 1.1\n");
@@ -124,7 +125,7 @@ WB_LONG main(WB_LONG argc, WB_TINY **argv)
     }
 
 
-    while ((opt = wbxml_getopt(argc, argv, "nkah?o:v:")) != EOF)
+    while ((opt = wbxml_getopt(argc, argv, "nskah?o:v:")) != EOF)
     {
         switch (opt) {
         case 'v':
@@ -133,6 +134,9 @@ WB_LONG main(WB_LONG argc, WB_TINY **argv)
         case 'n':
             wbxml_conv_xml2wbxml_disable_string_table(conv);
             break;
+        case 's':
+            wbxml_conv_xml2wbxml_enable_optimal_string_table(conv);
+            break;
         case 'k':
             wbxml_conv_xml2wbxml_enable_preserve_whitespaces(conv);
             break;
@@ -92,6 +92,10 @@ LINK32=link.exe
 # PROP Default_Filter "cpp;c;cxx;rc;def;r;odl;idl;hpj;bat"
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_arena.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_base64.c
 # End Source File
 # Begin Source File
@@ -128,6 +132,10 @@ SOURCE=..\..\src\wbxml_log.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_matcher.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_mem.c
 # End Source File
 # Begin Source File
@@ -136,6 +144,10 @@ SOURCE=..\..\src\wbxml_parser.c
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_reader.c
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_tables.c
 # End Source File
 # Begin Source File
@@ -164,6 +176,10 @@ SOURCE=..\..\src\wbxml.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_arena.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_base64.h
 # End Source File
 # Begin Source File
@@ -204,6 +220,10 @@ SOURCE=..\..\src\wbxml_log.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_matcher.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_mem.h
 # End Source File
 # Begin Source File
@@ -212,6 +232,10 @@ SOURCE=..\..\src\wbxml_parser.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\..\src\wbxml_reader.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\..\src\wbxml_tables.h
 # End Source File
 # Begin Source File